@@ -32,39 +32,22 @@ int main(int argc, char** argv)
 	ccv_dense_matrix_t* image_desc = 0;
 	ccv_sift(image, &image_keypoints, &image_desc, 0, params);
 	elapsed_time = get_current_time() - elapsed_time;
-	int i, j, k;
+	int i;
 	int match = 0;
-	for (i = 0; i < obj_keypoints->rnum; i++)
+	if (image_keypoints->rnum > 0 && obj_keypoints->rnum > 0)
 	{
-		float* odesc = obj_desc->data.f32 + i * 128;
-		int minj = -1;
-		double mind = 1e6, mind2 = 1e6;
-		for (j = 0; j < image_keypoints->rnum; j++)
+		ccv_sift_index_t* index = ccv_sift_index_new(image_desc, 4);
+		ccv_array_t* matches = ccv_sift_index_match(index, obj_desc, ccv_sift_match_default_params);
+		for (i = 0; i < matches->rnum; i++)
 		{
-			float* idesc = image_desc->data.f32 + j * 128;
-			double d = 0;
-			for (k = 0; k < 128; k++)
-			{
-				d += (odesc[k] - idesc[k]) * (odesc[k] - idesc[k]);
-				if (d > mind2)
-					break;
-			}
-			if (d < mind)
-			{
-				mind2 = mind;
-				mind = d;
-				minj = j;
-			} else if (d < mind2) {
-				mind2 = d;
-			}
-		}
-		if (mind < mind2 * 0.36)
-		{
-			ccv_keypoint_t* op = (ccv_keypoint_t*)ccv_array_get(obj_keypoints, i);
-			ccv_keypoint_t* kp = (ccv_keypoint_t*)ccv_array_get(image_keypoints, minj);
+			ccv_sift_match_t* m = (ccv_sift_match_t*)ccv_array_get(matches, i);
+			ccv_keypoint_t* op = (ccv_keypoint_t*)ccv_array_get(obj_keypoints, m->query);
+			ccv_keypoint_t* kp = (ccv_keypoint_t*)ccv_array_get(image_keypoints, m->index);
 			printf("%f %f => %f %f\n", op->x, op->y, kp->x, kp->y);
-			match++;
 		}
+		match = matches->rnum;
+		ccv_array_free(matches);
+		ccv_sift_index_free(index);
 	}
 	printf("%dx%d on %dx%d\n", object->cols, object->rows, image->cols, image->rows);
 	printf("%d keypoints out of %d are matched\n", match, obj_keypoints->rnum);
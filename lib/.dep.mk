@@ -0,0 +1,67 @@
+ccv_cache.o: ccv_cache.c ccv.h nnc/ccv_nnc_tfb.h ccv_internal.h
+ccv_memory.o: ccv_memory.c ccv.h nnc/ccv_nnc_tfb.h ccv_internal.h \
+ 3rdparty/siphash/siphash24.h
+siphash24.o: 3rdparty/siphash/siphash24.c
+kiss_fft.o: 3rdparty/kissfft/kiss_fft.c 3rdparty/kissfft/_kiss_fft_guts.h \
+ 3rdparty/kissfft/kiss_fft.h
+kiss_fftnd.o: 3rdparty/kissfft/kiss_fftnd.c 3rdparty/kissfft/kiss_fftnd.h \
+ 3rdparty/kissfft/kiss_fft.h 3rdparty/kissfft/_kiss_fft_guts.h
+kiss_fftr.o: 3rdparty/kissfft/kiss_fftr.c 3rdparty/kissfft/kiss_fftr.h \
+ 3rdparty/kissfft/kiss_fft.h 3rdparty/kissfft/_kiss_fft_guts.h
+kiss_fftndr.o: 3rdparty/kissfft/kiss_fftndr.c \
+ 3rdparty/kissfft/kiss_fftndr.h 3rdparty/kissfft/kiss_fft.h \
+ 3rdparty/kissfft/kiss_fftr.h 3rdparty/kissfft/kiss_fftnd.h \
+ 3rdparty/kissfft/_kiss_fft_guts.h
+kissf_fft.o: 3rdparty/kissfft/kissf_fft.c \
+ 3rdparty/kissfft/_kissf_fft_guts.h 3rdparty/kissfft/kissf_fft.h
+kissf_fftnd.o: 3rdparty/kissfft/kissf_fftnd.c \
+ 3rdparty/kissfft/kissf_fftnd.h 3rdparty/kissfft/kissf_fft.h \
+ 3rdparty/kissfft/_kissf_fft_guts.h
+kissf_fftr.o: 3rdparty/kissfft/kissf_fftr.c 3rdparty/kissfft/kissf_fftr.h \
+ 3rdparty/kissfft/kissf_fft.h 3rdparty/kissfft/_kissf_fft_guts.h
+kissf_fftndr.o: 3rdparty/kissfft/kissf_fftndr.c \
+ 3rdparty/kissfft/kissf_fftndr.h 3rdparty/kissfft/kissf_fft.h \
+ 3rdparty/kissfft/kissf_fftr.h 3rdparty/kissfft/kissf_fftnd.h \
+ 3rdparty/kissfft/_kissf_fft_guts.h
+dSFMT.o: 3rdparty/dsfmt/dSFMT.c 3rdparty/dsfmt/dSFMT-params.h \
+ 3rdparty/dsfmt/dSFMT.h 3rdparty/dsfmt/dSFMT-params19937.h \
+ 3rdparty/dsfmt/dSFMT-common.h
+SFMT.o: 3rdparty/sfmt/SFMT.c 3rdparty/sfmt/SFMT.h \
+ 3rdparty/sfmt/SFMT-params.h 3rdparty/sfmt/SFMT-params19937.h \
+ 3rdparty/sfmt/SFMT-common.h 3rdparty/sfmt/SFMT-sse2.h
+sqlite3.o: 3rdparty/sqlite3/sqlite3.c
+ccv_io.o: ccv_io.c ccv.h nnc/ccv_nnc_tfb.h ccv_internal.h \
+ io/_ccv_io_libpng.inc io/_ccv_io_libjpeg.inc io/_ccv_io_bmp.inc \
+ io/_ccv_io_binary.inc io/_ccv_io_raw.inc
+ccv_numeric.o: ccv_numeric.c ccv.h nnc/ccv_nnc_tfb.h ccv_internal.h \
+ 3rdparty/kissfft/kiss_fftndr.h 3rdparty/kissfft/kiss_fft.h \
+ 3rdparty/kissfft/kiss_fftr.h 3rdparty/kissfft/kiss_fftnd.h \
+ 3rdparty/kissfft/kissf_fftndr.h 3rdparty/kissfft/kissf_fft.h \
+ 3rdparty/kissfft/kissf_fftr.h 3rdparty/kissfft/kissf_fftnd.h
+ccv_algebra.o: ccv_algebra.c ccv.h nnc/ccv_nnc_tfb.h ccv_internal.h
+ccv_util.o: ccv_util.c ccv.h nnc/ccv_nnc_tfb.h ccv_internal.h
+ccv_basic.o: ccv_basic.c ccv.h nnc/ccv_nnc_tfb.h ccv_internal.h
+ccv_image_processing.o: ccv_image_processing.c ccv.h nnc/ccv_nnc_tfb.h \
+ ccv_internal.h
+ccv_resample.o: ccv_resample.c ccv.h nnc/ccv_nnc_tfb.h ccv_internal.h
+ccv_transform.o: ccv_transform.c ccv.h nnc/ccv_nnc_tfb.h ccv_internal.h
+ccv_classic.o: ccv_classic.c ccv.h nnc/ccv_nnc_tfb.h ccv_internal.h
+ccv_pyramid.o: ccv_pyramid.c ccv.h nnc/ccv_nnc_tfb.h ccv_internal.h
+ccv_daisy.o: ccv_daisy.c ccv.h nnc/ccv_nnc_tfb.h ccv_internal.h
+ccv_sift.o: ccv_sift.c ccv.h nnc/ccv_nnc_tfb.h ccv_internal.h \
+ 3rdparty/dsfmt/dSFMT.h
+ccv_bbf.o: ccv_bbf.c ccv.h nnc/ccv_nnc_tfb.h ccv_internal.h
+ccv_mser.o: ccv_mser.c ccv.h nnc/ccv_nnc_tfb.h ccv_internal.h
+ccv_swt.o: ccv_swt.c ccv.h nnc/ccv_nnc_tfb.h ccv_internal.h
+ccv_dpm.o: ccv_dpm.c ccv.h nnc/ccv_nnc_tfb.h ccv_internal.h
+ccv_tld.o: ccv_tld.c ccv.h nnc/ccv_nnc_tfb.h ccv_internal.h \
+ 3rdparty/sfmt/SFMT.h 3rdparty/sfmt/SFMT-params.h \
+ 3rdparty/sfmt/SFMT-params19937.h 3rdparty/dsfmt/dSFMT.h
+ccv_ferns.o: ccv_ferns.c ccv.h nnc/ccv_nnc_tfb.h ccv_internal.h \
+ 3rdparty/dsfmt/dSFMT.h
+ccv_icf.o: ccv_icf.c ccv.h nnc/ccv_nnc_tfb.h ccv_internal.h
+ccv_scd.o: ccv_scd.c ccv.h nnc/ccv_nnc_tfb.h ccv_internal.h \
+ 3rdparty/sqlite3/sqlite3.h
+ccv_convnet.o: ccv_convnet.c ccv.h nnc/ccv_nnc_tfb.h ccv_internal.h \
+ 3rdparty/sqlite3/sqlite3.h inc/ccv_convnet_internal.h
+ccv_output.o: ccv_output.c ccv.h nnc/ccv_nnc_tfb.h
@@ -155,6 +155,20 @@ typedef union {
 	} terminal;
 } ccv_cache_index_t;
 
+typedef struct {
+	uint64_t hit; /**< The number of lookups found an object of this type. */
+	uint64_t put; /**< The number of objects of this type put into the cache. */
+	uint64_t eviction; /**< The number of objects of this type evicted to make room. */
+	uint64_t evicted_size; /**< The bytes of objects of this type evicted to make room. */
+	uint32_t rnum; /**< The number of objects of this type currently in the cache. */
+	size_t size; /**< The bytes of objects of this type currently in the cache. */
+} ccv_cache_type_stat_t;
+
+typedef struct {
+	uint64_t miss; /**< The number of lookups found nothing, the type of what is looked for is not known to the cache. */
+	ccv_cache_type_stat_t type[16]; /**< The statistics for each cache type. */
+} ccv_cache_stat_t;
+
 typedef struct {
 	ccv_cache_index_t origin;
 	uint32_t rnum;
@@ -162,6 +176,7 @@ typedef struct {
 	size_t up;
 	size_t size;
 	ccv_cache_index_free_f ffree[16];
+	ccv_cache_stat_t stat;
 } ccv_cache_t;
 
 /* I made it as generic as possible */
@@ -192,6 +207,17 @@ void* ccv_cache_get(ccv_cache_t* cache, uint64_t sign, uint8_t* type);
  * @return 0 - success, 1 - replace, -1 - failure.
  */
 int ccv_cache_put(ccv_cache_t* cache, uint64_t sign, void* x, uint32_t size, uint8_t type);
+/**
+ * Put an object to cache with its signature, size, type and the cost to compute it again. Objects are evicted by age, an object with cost is treated as if it were put later than it was: an object whose cost equals its size is kept for about one more turnover of the cache than an object at no cost. Thus, cost is in the same unit as size (it can be the bytes touched to compute the object, for example), and ccv_cache_put is the same as this one with 0 cost.
+ * @param cache The cache.
+ * @param sign The signature.
+ * @param x The pointer to the object.
+ * @param size The size of the object.
+ * @param type The type of the object.
+ * @param cost The cost to compute the object again, recorded when the object is produced.
+ * @return 0 - success, 1 - replace, -1 - failure.
+ */
+int ccv_cache_put_with_cost(ccv_cache_t* cache, uint64_t sign, void* x, uint32_t size, uint8_t type, uint64_t cost);
 /**
  * Get an object from cache for its signature and then remove that object from the cache. 0 if cannot find the object.
  * @param cache The cache.
@@ -207,6 +233,29 @@ void* ccv_cache_out(ccv_cache_t* cache, uint64_t sign, uint8_t* type);
  * @return -1 if cannot find the object, otherwise return 0.
  */
 int ccv_cache_delete(ccv_cache_t* cache, uint64_t sign);
+/**
+ * Get the age of the least recently used object in the cache. Age increases with each put, thus, caches that have their age set from one counter before each put can be compared with each other.
+ * @param cache The cache.
+ * @return 0 if the cache is empty, otherwise the age.
+ */
+uint32_t ccv_cache_lru_age(ccv_cache_t* cache);
+/**
+ * Make the cache and every object in it younger by shift. Objects with an age less than shift become the least recently used ones, in no particular order. The age only has 28 bits for each object, thus, a cache rebases itself on put before it overflows. Caches that share one counter have to be rebased together by the owner of the counter.
+ * @param cache The cache.
+ * @param shift How much younger it gets.
+ */
+void ccv_cache_rebase_age(ccv_cache_t* cache, uint32_t shift);
+/**
+ * Get the hit / miss / eviction statistics and the bytes held for each type of the cache. It is the same as reading cache->stat.
+ * @param cache The cache.
+ * @param stat The statistics.
+ */
+void ccv_cache_get_stat(ccv_cache_t* cache, ccv_cache_stat_t* stat);
+/**
+ * Free the least recently used object in the cache.
+ * @param cache The cache.
+ */
+void ccv_cache_evict(ccv_cache_t* cache);
 /**
  * Clean up the cache, free all objects inside and other memory space occupied.
  * @param cache The cache.
@@ -452,6 +501,16 @@ void ccv_enable_default_cache(void);
  * @param size The upper limit of the cache, in bytes.
  */
 void ccv_enable_cache(size_t size);
+/**
+ * Enable a process-wide cache for ccv, shared by all threads, thus, a matrix derived on one thread can be reused on another. The cache is sharded by signature with a lock for each shard, and the least recently used objects are evicted once all shards together go beyond the given memory size. Once enabled, it takes precedence over the per-thread cache from ccv_enable_cache. ccv_drain_cache and ccv_disable_cache apply to it as well.
+ * @param size The upper limit of the cache, in bytes.
+ */
+void ccv_enable_global_cache(size_t size);
+/**
+ * Get the statistics of the application-wide cache (the process-wide one if it is enabled, otherwise, the one for this thread). Matrices are of type 0 and arrays are of type 1. The statistics are reset when the cache is enabled again, use them to find a cache size that fits the workload.
+ * @param stat The statistics.
+ */
+void ccv_get_cache_stat(ccv_cache_stat_t* stat);
 
 #define ccv_get_dense_matrix_cell_by(type, x, row, col, ch) \
 	(((type) & CCV_32S) ? (void*)((x)->data.i32 + ((row) * (x)->cols + (col)) * CCV_GET_CHANNEL(type) + (ch)) : \
@@ -573,6 +632,16 @@ int ccv_read_impl(const void* in, ccv_dense_matrix_t** x, int type, int rows, in
 // this is a way to implement function-signature based dispatch, you can call either
 // ccv_read(in, x, type) or ccv_read(in, x, type, rows, cols, scanline)
 // notice that you can implement this with va_* functions, but that is not type-safe
+/**
+ * Read image from a file or a region of memory, and scale it down to fit within max_rows x max_cols while keeping its aspect ratio. For JPEG, the image is decoded at 1/2, 1/4 or 1/8 of its size directly (the largest reduction that is still no smaller than the requested size), and only the remainder is resampled with CCV_INTER_AREA. Other formats are decoded at full size and then resampled. An image that already fits is returned as is.
+ * @param in The file name or the data memory.
+ * @param x The output image.
+ * @param type CCV_IO_ANY_FILE or CCV_IO_ANY_STREAM, in conjunction with CCV_IO_GRAY or CCV_IO_RGB_COLOR.
+ * @param size The size of that data memory region, 0 for a file.
+ * @param max_rows The maximum rows of the output image, 0 for no limit.
+ * @param max_cols The maximum columns of the output image, 0 for no limit.
+ */
+int ccv_read_fit(const void* in, ccv_dense_matrix_t** x, int type, int size, int max_rows, int max_cols);
 /**
  * Write image to a file. This function has soft dependencies on [LibJPEG](http://libjpeg.sourceforge.net/) and [LibPNG](http://www.libpng.org/pub/png/libpng.html). No these libraries, no JPEG nor PNG write support.
  * @param mat The input image.
@@ -939,6 +1008,25 @@ typedef int(*ccv_array_group_f)(const void*, const void*, void*);
  * @param data Any extra user data.
  */
 int ccv_array_group(ccv_array_t* array, ccv_array_t** index, ccv_array_group_f gfunc, void* data);
+typedef ccv_rect_t(*ccv_array_bound_f)(const void*, void*);
+typedef void(*ccv_array_intersect_f)(int, int, void*);
+/**
+ * Find all pairs of elements in the array whose bounds intersect. Bounds are indexed with a uniform grid, thus, it doesn't compare every element against every other element.
+ * @param array The array.
+ * @param bfunc ccv_rect_t ccv_array_bound_f(const void* a, void* data). Return the bound of a.
+ * @param ifunc void ccv_array_intersect_f(int i, int j, void* data). Called once for each pair of elements (i < j) whose bounds intersect.
+ * @param data Any extra user data.
+ */
+void ccv_array_intersect(ccv_array_t* array, ccv_array_bound_f bfunc, ccv_array_intersect_f ifunc, void* data);
+/**
+ * Group elements in the array from its similarity, same as **ccv_array_group**, but only compare elements whose bounds intersect. It is much faster than **ccv_array_group** for a large array.
+ * @param array The array.
+ * @param index The output index, same group element will have the same index.
+ * @param gfunc int ccv_array_group_f(const void* a, const void* b, void* data). Return 1 if a and b are in the same group, it can only be 1 if the bounds of a and b intersect.
+ * @param bfunc ccv_rect_t ccv_array_bound_f(const void* a, void* data). Return the bound of a.
+ * @param data Any extra user data.
+ */
+int ccv_array_group_spatially(ccv_array_t* array, ccv_array_t** index, ccv_array_group_f gfunc, ccv_array_bound_f bfunc, void* data);
 void ccv_make_array_immutable(ccv_array_t* array);
 void ccv_make_array_mutable(ccv_array_t* array);
 /**
@@ -1085,7 +1173,7 @@ void ccv_minimize(ccv_dense_matrix_t* x, int length, double red, ccv_minimize_f
  * @param a Dense matrix a.
  * @param b Dense matrix b.
  * @param d The output matrix.
- * @param type The type of output matrix, if 0, ccv will try to match the input matrix for appropriate type.
+ * @param type The type of output matrix, if 0, ccv will try to match the input matrix for appropriate type. With CCV_C1, the responses of all channels will be summed up into one channel.
  * @param padding_pattern ccv doesn't support padding pattern for now.
  */
 void ccv_filter(ccv_dense_matrix_t* a, ccv_dense_matrix_t* b, ccv_dense_matrix_t** d, int type, int padding_pattern);
@@ -1408,6 +1496,67 @@ extern const ccv_sift_param_t ccv_sift_default_params;
  * @param params A **ccv_sift_param_t** structure that defines various aspect of SIFT function.
  */
 void ccv_sift(ccv_dense_matrix_t* a, ccv_array_t** keypoints, ccv_dense_matrix_t** desc, int type, ccv_sift_param_t params);
+
+typedef struct {
+	int dim; /**< The split dimension, -1 for a leaf. */
+	float value; /**< The split value. */
+	int left; /**< The left child, or the descriptor for a leaf. */
+	int right; /**< The right child. */
+} ccv_sift_index_node_t;
+
+typedef struct {
+	int rows; /**< The number of descriptors. */
+	int cols; /**< The dimension of a descriptor. */
+	int trees; /**< The number of randomized k-d trees. */
+	float* data; /**< The descriptors, rows x cols. */
+	ccv_sift_index_node_t* nodes; /**< 2 * rows - 1 nodes for each tree, the first one is the root. */
+} ccv_sift_index_t;
+
+typedef struct {
+	int checks; /**< The maximum number of descriptors to compare against for each query, 0 for an exhaustive search. */
+	float ratio; /**< Keep the match only if its squared distance is smaller than ratio times the squared distance of the second nearest. */
+} ccv_sift_match_param_t;
+
+typedef struct {
+	int query; /**< The index of the query descriptor. */
+	int index; /**< The index of the nearest descriptor in the index. */
+	float distance; /**< The squared distance between the two. */
+} ccv_sift_match_t;
+
+extern const ccv_sift_match_param_t ccv_sift_match_default_params;
+
+/**
+ * Build a randomized k-d forest over descriptors for approximate nearest neighbour search. Each tree splits on one of the dimensions with the highest variance, picked at random, so that the trees search different parts of the space.
+ * @param desc The descriptors, one for each row (the output of ccv_sift).
+ * @param trees The number of trees, 4 is a good start.
+ * @return The index, its descriptors are copied.
+ */
+ccv_sift_index_t* ccv_sift_index_new(ccv_dense_matrix_t* desc, int trees);
+/**
+ * Find the nearest descriptor in the index for each row of desc with the ratio test. Queries are run in parallel.
+ * @param index The index.
+ * @param desc The query descriptors, one for each row.
+ * @param params A **ccv_sift_match_param_t** structure that defines how exhaustive the search is and the ratio test.
+ * @return An array of ccv_sift_match_t for queries that pass the ratio test, in the order of the queries.
+ */
+ccv_array_t* ccv_sift_index_match(ccv_sift_index_t* index, ccv_dense_matrix_t* desc, ccv_sift_match_param_t params);
+/**
+ * Write the index to a file. Fields are written in fixed-width little-endian, thus, the file can be read on other machines.
+ * @param index The index.
+ * @param filename The file name.
+ */
+void ccv_sift_index_write(ccv_sift_index_t* index, const char* filename);
+/**
+ * Read the index from a file. The nodes are checked to be valid trees over the descriptors.
+ * @param filename The file name.
+ * @return The index, 0 if it cannot be read or it is malformed.
+ */
+ccv_sift_index_t* ccv_sift_index_read(const char* filename);
+/**
+ * Free the index.
+ * @param index The index.
+ */
+void ccv_sift_index_free(ccv_sift_index_t* index);
 /** @} */
 
 /* mser related method */
@@ -1522,6 +1671,95 @@ typedef struct {
 	};
 } ccv_file_info_t;
 
+/**
+ * @defgroup ccv_pyramid shared image pyramid
+ * Every detector builds its own image pyramid and computes its own feature channels per level. If you run several of
+ * them on one image, a lot of these are the same. A **ccv_pyramid_t** materializes levels and feature channels lazily,
+ * keyed by the signature derived from its parent (the same way ccv derives signatures for its outputs). Thus, whoever
+ * asks first computes it, and the rest just pick it up. A matrix returned from the pyramid is owned by the pyramid,
+ * release it with **ccv_pyramid_release** after its last use. The pyramid is safe to access from multiple workers of a
+ * parallel_for.
+ * @{
+ */
+
+enum {
+	CCV_PYRAMID_CACHE_FEATURE = 0x01, /**< Keep the feature channels around after the detector is done with them. Otherwise, they are freed once released. */
+	CCV_PYRAMID_CACHE_LEVEL = 0x02, /**< Keep the image levels around after the detector is done with them. Otherwise, they are freed once released. */
+};
+
+typedef struct {
+	int flags;
+	uint64_t sig; /**< The signature all levels and feature channels are derived from. */
+	ccv_dense_matrix_t* image; /**< The input image, the pyramid doesn't own it. */
+	ccv_array_t* entries;
+	void* lock;
+} ccv_pyramid_t;
+
+/**
+ * Create a new pyramid on top of an image. Nothing is computed until being asked for.
+ * @param a The input image, it has to outlive the pyramid.
+ * @param flags CCV_PYRAMID_CACHE_LEVEL | CCV_PYRAMID_CACHE_FEATURE if you will run more than one detector on this pyramid.
+ * @return A newly created pyramid.
+ */
+CCV_WARN_UNUSED(ccv_pyramid_t*) ccv_pyramid_new(ccv_dense_matrix_t* a, int flags);
+/**
+ * Get the matrix resampled from a level of the pyramid (see **ccv_resample**).
+ * @param pyramid The pyramid.
+ * @param a The input image of the pyramid, or a matrix returned from the pyramid.
+ * @param rows The new row.
+ * @param cols The new column.
+ * @param type CCV_INTER_AREA or CCV_INTER_CUBIC.
+ * @return The resampled matrix, owned by the pyramid.
+ */
+ccv_dense_matrix_t* ccv_pyramid_resample(ccv_pyramid_t* pyramid, ccv_dense_matrix_t* a, int rows, int cols, int type);
+/**
+ * Get the half-sized matrix of a level of the pyramid (see **ccv_sample_down**).
+ * @param pyramid The pyramid.
+ * @param a The input image of the pyramid, or a matrix returned from the pyramid.
+ * @param src_x Shift the start point by src_x.
+ * @param src_y Shift the start point by src_y.
+ * @return The downsampled matrix, owned by the pyramid.
+ */
+ccv_dense_matrix_t* ccv_pyramid_sample_down(ccv_pyramid_t* pyramid, ccv_dense_matrix_t* a, int src_x, int src_y);
+/**
+ * Get the summed area table of the integral channel features of a level (see **ccv_icf**). The level is bordered with margin first.
+ * @param pyramid The pyramid.
+ * @param a The input image of the pyramid, or a matrix returned from the pyramid.
+ * @param margin The margin to border the level with.
+ * @return The summed area table with zero padding, owned by the pyramid.
+ */
+ccv_dense_matrix_t* ccv_pyramid_icf(ccv_pyramid_t* pyramid, ccv_dense_matrix_t* a, ccv_margin_t margin);
+/**
+ * Get the summed area table of the SURF features of a level (see **ccv_scd**). The level is bordered with margin first.
+ * @param pyramid The pyramid.
+ * @param a The input image of the pyramid, or a matrix returned from the pyramid.
+ * @param margin The margin to border the level with.
+ * @return The summed area table with zero padding, owned by the pyramid.
+ */
+ccv_dense_matrix_t* ccv_pyramid_scd(ccv_pyramid_t* pyramid, ccv_dense_matrix_t* a, ccv_margin_t margin);
+/**
+ * Get the HOG feature of a level (see **ccv_hog**).
+ * @param pyramid The pyramid.
+ * @param a The input image of the pyramid, or a matrix returned from the pyramid.
+ * @param sbin The number of bins for orientation (default to 9, thus, for **b**, it will have 9 * 2 + 9 + 4 = 31 channels).
+ * @param size The window size for HOG (default to 8)
+ * @return The HOG feature, owned by the pyramid.
+ */
+ccv_dense_matrix_t* ccv_pyramid_hog(ccv_pyramid_t* pyramid, ccv_dense_matrix_t* a, int sbin, int size);
+/**
+ * Tell the pyramid a level or a feature channel is no longer used by the caller. Once every caller released it, it will be
+ * freed, unless CCV_PYRAMID_CACHE_LEVEL (for levels) or CCV_PYRAMID_CACHE_FEATURE (for feature channels) is set.
+ * @param pyramid The pyramid.
+ * @param mat The level or the feature channel returned from the pyramid.
+ */
+void ccv_pyramid_release(ccv_pyramid_t* pyramid, ccv_dense_matrix_t* mat);
+/**
+ * Free the pyramid and every matrix it owns.
+ * @param pyramid The pyramid.
+ */
+void ccv_pyramid_free(ccv_pyramid_t* pyramid);
+/** @} */
+
 /* I'd like to include Deformable Part Models as a general object detection method in here
  * The difference between BBF and DPM:
  * ~ BBF is for rigid object detection: banners, box, faces etc.
@@ -1630,6 +1868,15 @@ void ccv_dpm_mixture_model_new(char** posfiles, ccv_rect_t* bboxes, int posnum,
  * @return A **ccv_array_t** of **ccv_root_comp_t** that contains the root bounding box as well as its parts.
  */
 CCV_WARN_UNUSED(ccv_array_t*) ccv_dpm_detect_objects(ccv_dense_matrix_t* a, ccv_dpm_mixture_model_t** model, int count, ccv_dpm_param_t params);
+/**
+ * Same as **ccv_dpm_detect_objects**, but takes the image levels and HOG features from a shared pyramid.
+ * @param pyramid The pyramid of the input image.
+ * @param model An array of mixture models.
+ * @param count How many mixture models you've passed in.
+ * @param params A **ccv_dpm_param_t** structure that defines various aspects of the detector.
+ * @return A **ccv_array_t** of **ccv_root_comp_t** that contains the root bounding box as well as its parts.
+ */
+CCV_WARN_UNUSED(ccv_array_t*) ccv_dpm_detect_objects_in_pyramid(ccv_pyramid_t* pyramid, ccv_dpm_mixture_model_t** model, int count, ccv_dpm_param_t params);
 /**
  * Read DPM mixture model from a model file.
  * @param directory The model file for DPM mixture model.
@@ -1686,7 +1933,7 @@ enum {
 typedef struct {
 	int interval; /**< Interval images between the full size image and the half size one. e.g. 2 will generate 2 images in between full size image and half size one: image with full size, image with 5/6 size, image with 2/3 size, image with 1/2 size. */
 	int min_neighbors; /**< 0: no grouping afterwards. 1: group objects that intersects each other. > 1: group objects that intersects each other, and only passes these that have at least **min_neighbors** intersected objects. */
-	int flags; /**< CCV_BBF_NO_NESTED, if one class of object is inside another class of object, this flag will reject the first object. */
+	int flags; /**< CCV_BBF_NO_NESTED, if one class of object is inside another class of object, this flag will reject the first object. CCV_BBF_PARALLEL, build the image pyramid and scan it with multiple threads, the result is the same as the single-threaded one. */
 	int accurate; /**< BBF will generates 4 spatial scale variations for better accuracy. Set this parameter to 0 will reduce to 1 scale variation, and thus 3 times faster but lower the general accuracy of the detector. */
 	ccv_size_t size; /**< The smallest object size that will be interesting to us. */
 } ccv_bbf_param_t;
@@ -1703,6 +1950,7 @@ typedef struct {
 
 enum {
 	CCV_BBF_NO_NESTED = 0x10000000,
+	CCV_BBF_PARALLEL = 0x20000000,
 };
 
 extern const ccv_bbf_param_t ccv_bbf_default_params;
@@ -1728,6 +1976,15 @@ void ccv_bbf_classifier_cascade_new(ccv_dense_matrix_t** posimg, int posnum, cha
  * @return A **ccv_array_t** of **ccv_comp_t** for detection results.
  */
 CCV_WARN_UNUSED(ccv_array_t*) ccv_bbf_detect_objects(ccv_dense_matrix_t* a, ccv_bbf_classifier_cascade_t** cascade, int count, ccv_bbf_param_t params);
+/**
+ * Same as **ccv_bbf_detect_objects**, but takes the image levels from a shared pyramid.
+ * @param pyramid The pyramid of the input image.
+ * @param cascade An array of classifier cascades.
+ * @param count How many classifier cascades you've passed in.
+ * @param params A **ccv_bbf_param_t** structure that defines various aspects of the detector.
+ * @return A **ccv_array_t** of **ccv_comp_t** for detection results.
+ */
+CCV_WARN_UNUSED(ccv_array_t*) ccv_bbf_detect_objects_in_pyramid(ccv_pyramid_t* pyramid, ccv_bbf_classifier_cascade_t** cascade, int count, ccv_bbf_param_t params);
 /**
  * Read BBF classifier cascade from working directory.
  * @param directory The working directory that trains a BBF classifier cascade.
@@ -1850,6 +2107,7 @@ typedef struct {
 	 * every frame, we will rotate them, for example, slide window 1
 	 * only gets examined at frame % rotation == 1 */
 	int rotation; /**< When >= 1, using "rotation" technique, which, only evaluate a subset of sliding windows for each frame, but after rotation + 1 frames, every sliding window will be evaluated in one of these frames. */
+	float search_region; /**< When > 0, and the last frame is verified, only evaluate sliding windows within the last box padded by this ratio of its width / height on each side. The whole frame is evaluated again once the tracking is lost or unverified. 0 to always evaluate the whole frame. */
 	/** @} */
 } ccv_tld_param_t;
 
@@ -1872,6 +2130,11 @@ typedef struct {
 	int count;
 	void* sfmt;
 	void* dsfmt;
+	ccv_array_t* windows; // all sliding windows, in the same order as fern_buffer
+	ccv_rect_t scan; // the region evaluated by long-term detection on the last frame
+	ccv_dense_matrix_t* gb; // blurred frame, reused between frames
+	ccv_dense_matrix_t* sat; // integral image of the frame, reused between frames
+	ccv_dense_matrix_t* sqsat; // squared integral image of the frame, reused between frames
 	uint32_t fern_buffer[1]; // fetched ferns from image, this is a buffer
 } ccv_tld_t;
 
@@ -2041,6 +2304,15 @@ void ccv_icf_multiscale_classifier_cascade_free(ccv_icf_multiscale_classifier_ca
  * @return A **ccv_array_t** of **ccv_comp_t** with detection results.
  */
 CCV_WARN_UNUSED(ccv_array_t*) ccv_icf_detect_objects(ccv_dense_matrix_t* a, void* cascade, int count, ccv_icf_param_t params);
+/**
+ * Same as **ccv_icf_detect_objects**, but takes the image levels and integral channel features from a shared pyramid.
+ * @param pyramid The pyramid of the input image.
+ * @param cascade An array of classifier cascades.
+ * @param count How many classifier cascades you've passed in.
+ * @param params A **ccv_icf_param_t** structure that defines various aspects of the detector.
+ * @return A **ccv_array_t** of **ccv_comp_t** with detection results.
+ */
+CCV_WARN_UNUSED(ccv_array_t*) ccv_icf_detect_objects_in_pyramid(ccv_pyramid_t* pyramid, void* cascade, int count, ccv_icf_param_t params);
 /** @} */
 
 /* SCD: SURF-Cascade Detector
@@ -2183,6 +2455,15 @@ void ccv_scd(ccv_dense_matrix_t* a, ccv_dense_matrix_t** b, int type);
  * @return A **ccv_array_t** of **ccv_comp_t** with detection results.
  */
 CCV_WARN_UNUSED(ccv_array_t*) ccv_scd_detect_objects(ccv_dense_matrix_t* a, ccv_scd_classifier_cascade_t** cascades, int count, ccv_scd_param_t params);
+/**
+ * Same as **ccv_scd_detect_objects**, but takes the image levels and SURF features from a shared pyramid.
+ * @param pyramid The pyramid of the input image.
+ * @param cascades An array of classifier cascades.
+ * @param count How many classifier cascades you've passed in.
+ * @param params A **ccv_scd_param_t** structure that defines various aspects of the detector.
+ * @return A **ccv_array_t** of **ccv_comp_t** with detection results.
+ */
+CCV_WARN_UNUSED(ccv_array_t*) ccv_scd_detect_objects_in_pyramid(ccv_pyramid_t* pyramid, ccv_scd_classifier_cascade_t** cascades, int count, ccv_scd_param_t params);
 /** @} */
 
 /* categorization types and methods for training */
@@ -2282,6 +2563,7 @@ typedef struct {
 	ccv_convnet_input_t input; // the input requirement
 	ccv_convnet_type_t net; // network configuration
 	void* reserved;
+	void* quantized; // 8-bit weights with their per channel scales, see ccv_convnet_quantize
 } ccv_convnet_layer_t;
 
 typedef struct {
@@ -2400,6 +2682,13 @@ void ccv_convnet_write(ccv_convnet_t* convnet, const char* filename, ccv_convnet
  * @param convnet A convolutional network.
  */
 void ccv_convnet_compact(ccv_convnet_t* convnet);
+/**
+ * Quantize weights of convolutional layers and full connect layers to 8-bit integers with per channel scales, these layers are computed with 8-bit integers and 32-bit accumulators thereafter. The full precision weights are freed, thus, a quantized network can be used to encode / classify but not to train.
+ * @param convnet A convolutional network.
+ * @param a A C-array of sample images to calibrate the range of activations. If it is 0, the range is derived from each input at runtime.
+ * @param batch The number of sample images.
+ */
+void ccv_convnet_quantize(ccv_convnet_t* convnet, ccv_dense_matrix_t** a, int batch);
 /**
  * Free up the memory of a given convolutional network.
  * @param convnet A convolutional network.
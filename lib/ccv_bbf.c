@@ -8,6 +8,9 @@
 #ifdef USE_OPENMP
 #include <omp.h>
 #endif
+#ifdef USE_DISPATCH
+#include <dispatch/dispatch.h>
+#endif
 
 const ccv_bbf_param_t ccv_bbf_default_params = {
 	.interval = 5,
@@ -1188,8 +1191,110 @@ static int _ccv_is_equal_same_class(const void* _r1, const void* _r2, void* data
 		   (int)(r2->rect.width * 1.5 + 0.5) >= r1->rect.width;
 }
 
-ccv_array_t* ccv_bbf_detect_objects(ccv_dense_matrix_t* a, ccv_bbf_classifier_cascade_t** _cascade, int count, ccv_bbf_param_t params)
+// the rectangles grouped with r have their origins in this bound
+static ccv_rect_t _ccv_equal_bound(const void* _r, void* data)
+{
+	const ccv_comp_t* r = (const ccv_comp_t*)_r;
+	int distance = (int)(r->rect.width * 0.25 + 0.5);
+	return ccv_rect(r->rect.x - distance, r->rect.y - distance, distance * 2 + 1, distance * 2 + 1);
+}
+
+// the rectangles nested in r are in this bound
+static ccv_rect_t _ccv_nested_bound(const void* _r, void* data)
+{
+	const ccv_comp_t* r = (const ccv_comp_t*)_r;
+	int distance = (int)(r->rect.width * 0.25 + 0.5);
+	return ccv_rect(r->rect.x - distance, r->rect.y - distance, r->rect.width + distance * 2, r->rect.height + distance * 2);
+}
+
+static int _ccv_is_nested(const ccv_comp_t* r1, const ccv_comp_t* r2)
+{
+	int distance = (int)(r2->rect.width * 0.25 + 0.5);
+
+	return r1->classification.id == r2->classification.id &&
+		   r1->rect.x >= r2->rect.x - distance &&
+		   r1->rect.y >= r2->rect.y - distance &&
+		   r1->rect.x + r1->rect.width <= r2->rect.x + r2->rect.width + distance &&
+		   r1->rect.y + r1->rect.height <= r2->rect.y + r2->rect.height + distance &&
+		   (r2->neighbors > ccv_max(3, r1->neighbors) || r1->neighbors < 3);
+}
+
+typedef struct {
+	ccv_array_t* seq;
+	int* nested;
+} ccv_bbf_nested_t;
+
+static void _ccv_nested(int i, int j, void* data)
 {
+	ccv_bbf_nested_t* nested = (ccv_bbf_nested_t*)data;
+	const ccv_comp_t* r1 = (const ccv_comp_t*)ccv_array_get(nested->seq, i);
+	const ccv_comp_t* r2 = (const ccv_comp_t*)ccv_array_get(nested->seq, j);
+	if (_ccv_is_nested(r1, r2))
+		nested->nested[i] = 1;
+	if (_ccv_is_nested(r2, r1))
+		nested->nested[j] = 1;
+}
+
+#define CCV_BBF_PARALLEL_ROWS (8)
+
+// Scan rows [y_start, y_end) of scale i with spatial variation q, push the detected objects into seq (created on demand).
+static void _ccv_bbf_scan(ccv_bbf_classifier_cascade_t* cascade, int id, ccv_dense_matrix_t** pyr, int next, int i, int q, int y_start, int y_end, float scale_x, float scale_y, ccv_array_t** seq)
+{
+	int dx[] = {0, 1, 0, 1};
+	int dy[] = {0, 0, 1, 1};
+	int i_rows = pyr[i * 4 + next * 8]->rows - (cascade->size.height >> 2);
+	int steps[] = { pyr[i * 4]->step, pyr[i * 4 + next * 4]->step, pyr[i * 4 + next * 8]->step };
+	int i_cols = pyr[i * 4 + next * 8]->cols - (cascade->size.width >> 2);
+	int paddings[] = { pyr[i * 4]->step * 4 - i_cols * 4,
+					   pyr[i * 4 + next * 4]->step * 2 - i_cols * 2,
+					   pyr[i * 4 + next * 8]->step - i_cols };
+	int j, k, x, y;
+	y_end = ccv_min(y_end, i_rows);
+	unsigned char* u8[] = { pyr[i * 4]->data.u8 + dx[q] * 2 + dy[q] * pyr[i * 4]->step * 2 + y_start * steps[0] * 4, pyr[i * 4 + next * 4]->data.u8 + dx[q] + dy[q] * pyr[i * 4 + next * 4]->step + y_start * steps[1] * 2, pyr[i * 4 + next * 8 + q]->data.u8 + y_start * steps[2] };
+	for (y = y_start; y < y_end; y++)
+	{
+		for (x = 0; x < i_cols; x++)
+		{
+			float sum = 0;
+			int flag = 1;
+			ccv_bbf_stage_classifier_t* classifier = cascade->stage_classifier;
+			for (j = 0; j < cascade->count; ++j, ++classifier)
+			{
+				sum = 0;
+				float* alpha = classifier->alpha;
+				ccv_bbf_feature_t* feature = classifier->feature;
+				for (k = 0; k < classifier->count; ++k, alpha += 2, ++feature)
+					sum += alpha[_ccv_run_bbf_feature(feature, steps, u8)];
+				if (sum < classifier->threshold)
+				{
+					flag = 0;
+					break;
+				}
+			}
+			if (flag)
+			{
+				ccv_comp_t comp;
+				comp.rect = ccv_rect((int)((x * 4 + dx[q] * 2) * scale_x + 0.5), (int)((y * 4 + dy[q] * 2) * scale_y + 0.5), (int)(cascade->size.width * scale_x + 0.5), (int)(cascade->size.height * scale_y + 0.5));
+				comp.neighbors = 1;
+				comp.classification.id = id;
+				comp.classification.confidence = sum;
+				if (!*seq)
+					*seq = ccv_array_new(sizeof(ccv_comp_t), 16, 0);
+				ccv_array_push(*seq, &comp);
+			}
+			u8[0] += 4;
+			u8[1] += 2;
+			u8[2] += 1;
+		}
+		u8[0] += paddings[0];
+		u8[1] += paddings[1];
+		u8[2] += paddings[2];
+	}
+}
+
+ccv_array_t* ccv_bbf_detect_objects_in_pyramid(ccv_pyramid_t* pyramid, ccv_bbf_classifier_cascade_t** _cascade, int count, ccv_bbf_param_t params)
+{
+	ccv_dense_matrix_t* a = pyramid->image;
 	int hr = a->rows / params.size.height;
 	int wr = a->cols / params.size.width;
 	double scale = pow(2., 1. / (params.interval + 1.));
@@ -1198,21 +1303,43 @@ ccv_array_t* ccv_bbf_detect_objects(ccv_dense_matrix_t* a, ccv_bbf_classifier_ca
 	ccv_dense_matrix_t** pyr = (ccv_dense_matrix_t**)alloca((scale_upto + next * 2) * 4 * sizeof(ccv_dense_matrix_t*));
 	memset(pyr, 0, (scale_upto + next * 2) * 4 * sizeof(ccv_dense_matrix_t*));
 	if (params.size.height != _cascade[0]->size.height || params.size.width != _cascade[0]->size.width)
-		ccv_resample(a, &pyr[0], 0, a->rows * _cascade[0]->size.height / params.size.height, a->cols * _cascade[0]->size.width / params.size.width, CCV_INTER_AREA);
+		pyr[0] = ccv_pyramid_resample(pyramid, a, a->rows * _cascade[0]->size.height / params.size.height, a->cols * _cascade[0]->size.width / params.size.width, CCV_INTER_AREA);
 	else
 		pyr[0] = a;
-	int i, j, k, t, x, y, q;
-	for (i = 1; i < ccv_min(params.interval + 1, scale_upto + next * 2); i++)
-		ccv_resample(pyr[0], &pyr[i * 4], 0, (int)(pyr[0]->rows / pow(scale, i)), (int)(pyr[0]->cols / pow(scale, i)), CCV_INTER_AREA);
-	for (i = next; i < scale_upto + next * 2; i++)
-		ccv_sample_down(pyr[i * 4 - next * 4], &pyr[i * 4], 0, 0, 0);
-	if (params.accurate)
-		for (i = next * 2; i < scale_upto + next * 2; i++)
+	int i, j, t;
+	if (params.flags & CCV_BBF_PARALLEL)
+	{
+		// Levels within one octave only depend on the levels of the octave before it, build them concurrently.
+		parallel_for(l, ccv_min(params.interval + 1, scale_upto + next * 2) - 1) {
+			pyr[(l + 1) * 4] = ccv_pyramid_resample(pyramid, pyr[0], (int)(pyr[0]->rows / pow(scale, l + 1)), (int)(pyr[0]->cols / pow(scale, l + 1)), CCV_INTER_AREA);
+		} parallel_endfor
+		for (i = next; i < scale_upto + next * 2; i += next)
 		{
-			ccv_sample_down(pyr[i * 4 - next * 4], &pyr[i * 4 + 1], 0, 1, 0);
-			ccv_sample_down(pyr[i * 4 - next * 4], &pyr[i * 4 + 2], 0, 0, 1);
-			ccv_sample_down(pyr[i * 4 - next * 4], &pyr[i * 4 + 3], 0, 1, 1);
+			const int octave = i;
+			parallel_for(l, ccv_min(next, scale_upto + next * 2 - octave)) {
+				const int level = octave + l;
+				pyr[level * 4] = ccv_pyramid_sample_down(pyramid, pyr[level * 4 - next * 4], 0, 0);
+				if (params.accurate && level >= next * 2)
+				{
+					pyr[level * 4 + 1] = ccv_pyramid_sample_down(pyramid, pyr[level * 4 - next * 4], 1, 0);
+					pyr[level * 4 + 2] = ccv_pyramid_sample_down(pyramid, pyr[level * 4 - next * 4], 0, 1);
+					pyr[level * 4 + 3] = ccv_pyramid_sample_down(pyramid, pyr[level * 4 - next * 4], 1, 1);
+				}
+			} parallel_endfor
 		}
+	} else {
+		for (i = 1; i < ccv_min(params.interval + 1, scale_upto + next * 2); i++)
+			pyr[i * 4] = ccv_pyramid_resample(pyramid, pyr[0], (int)(pyr[0]->rows / pow(scale, i)), (int)(pyr[0]->cols / pow(scale, i)), CCV_INTER_AREA);
+		for (i = next; i < scale_upto + next * 2; i++)
+			pyr[i * 4] = ccv_pyramid_sample_down(pyramid, pyr[i * 4 - next * 4], 0, 0);
+		if (params.accurate)
+			for (i = next * 2; i < scale_upto + next * 2; i++)
+			{
+				pyr[i * 4 + 1] = ccv_pyramid_sample_down(pyramid, pyr[i * 4 - next * 4], 1, 0);
+				pyr[i * 4 + 2] = ccv_pyramid_sample_down(pyramid, pyr[i * 4 - next * 4], 0, 1);
+				pyr[i * 4 + 3] = ccv_pyramid_sample_down(pyramid, pyr[i * 4 - next * 4], 1, 1);
+			}
+	}
 	ccv_array_t* idx_seq;
 	ccv_array_t* seq = ccv_array_new(sizeof(ccv_comp_t), 64, 0);
 	ccv_array_t* seq2 = ccv_array_new(sizeof(ccv_comp_t), 64, 0);
@@ -1224,59 +1351,53 @@ ccv_array_t* ccv_bbf_detect_objects(ccv_dense_matrix_t* a, ccv_bbf_classifier_ca
 		float scale_x = (float) params.size.width / (float) cascade->size.width;
 		float scale_y = (float) params.size.height / (float) cascade->size.height;
 		ccv_array_clear(seq);
-		for (i = 0; i < scale_upto; i++)
+		const int qn = params.accurate ? 4 : 1;
+		if (params.flags & CCV_BBF_PARALLEL)
 		{
-			int dx[] = {0, 1, 0, 1};
-			int dy[] = {0, 0, 1, 1};
-			int i_rows = pyr[i * 4 + next * 8]->rows - (cascade->size.height >> 2);
-			int steps[] = { pyr[i * 4]->step, pyr[i * 4 + next * 4]->step, pyr[i * 4 + next * 8]->step };
-			int i_cols = pyr[i * 4 + next * 8]->cols - (cascade->size.width >> 2);
-			int paddings[] = { pyr[i * 4]->step * 4 - i_cols * 4,
-							   pyr[i * 4 + next * 4]->step * 2 - i_cols * 2,
-							   pyr[i * 4 + next * 8]->step - i_cols };
-			for (q = 0; q < (params.accurate ? 4 : 1); q++)
+			// Partition (scale, q, row band) into work items, each of them collects candidates into its own array.
+			float* scales = (float*)ccmalloc(sizeof(float) * 2 * scale_upto);
+			int* offsets = (int*)ccmalloc(sizeof(int) * (scale_upto + 1));
+			offsets[0] = 0;
+			for (i = 0; i < scale_upto; i++)
 			{
-				unsigned char* u8[] = { pyr[i * 4]->data.u8 + dx[q] * 2 + dy[q] * pyr[i * 4]->step * 2, pyr[i * 4 + next * 4]->data.u8 + dx[q] + dy[q] * pyr[i * 4 + next * 4]->step, pyr[i * 4 + next * 8 + q]->data.u8 };
-				for (y = 0; y < i_rows; y++)
+				scales[i * 2] = scale_x;
+				scales[i * 2 + 1] = scale_y;
+				scale_x *= scale;
+				scale_y *= scale;
+				const int i_rows = pyr[i * 4 + next * 8]->rows - (cascade->size.height >> 2);
+				offsets[i + 1] = offsets[i] + qn * ccv_max(0, (i_rows + CCV_BBF_PARALLEL_ROWS - 1) / CCV_BBF_PARALLEL_ROWS);
+			}
+			const int item_count = offsets[scale_upto];
+			ccv_array_t** seqs = (ccv_array_t**)cccalloc(item_count, sizeof(ccv_array_t*));
+			parallel_for(n, item_count) {
+				int s = 0;
+				while (offsets[s + 1] <= n)
+					++s;
+				const int bands = (offsets[s + 1] - offsets[s]) / qn;
+				const int q = (n - offsets[s]) / bands;
+				const int y = ((n - offsets[s]) % bands) * CCV_BBF_PARALLEL_ROWS;
+				_ccv_bbf_scan(cascade, t, pyr, next, s, q, y, y + CCV_BBF_PARALLEL_ROWS, scales[s * 2], scales[s * 2 + 1], seqs + n);
+			} parallel_endfor
+			// Merge in the same order as the serial scan, thus, the result doesn't depend on scheduling.
+			for (i = 0; i < item_count; i++)
+				if (seqs[i])
 				{
-					for (x = 0; x < i_cols; x++)
-					{
-						float sum;
-						int flag = 1;
-						ccv_bbf_stage_classifier_t* classifier = cascade->stage_classifier;
-						for (j = 0; j < cascade->count; ++j, ++classifier)
-						{
-							sum = 0;
-							float* alpha = classifier->alpha;
-							ccv_bbf_feature_t* feature = classifier->feature;
-							for (k = 0; k < classifier->count; ++k, alpha += 2, ++feature)
-								sum += alpha[_ccv_run_bbf_feature(feature, steps, u8)];
-							if (sum < classifier->threshold)
-							{
-								flag = 0;
-								break;
-							}
-						}
-						if (flag)
-						{
-							ccv_comp_t comp;
-							comp.rect = ccv_rect((int)((x * 4 + dx[q] * 2) * scale_x + 0.5), (int)((y * 4 + dy[q] * 2) * scale_y + 0.5), (int)(cascade->size.width * scale_x + 0.5), (int)(cascade->size.height * scale_y + 0.5));
-							comp.neighbors = 1;
-							comp.classification.id = t;
-							comp.classification.confidence = sum;
-							ccv_array_push(seq, &comp);
-						}
-						u8[0] += 4;
-						u8[1] += 2;
-						u8[2] += 1;
-					}
-					u8[0] += paddings[0];
-					u8[1] += paddings[1];
-					u8[2] += paddings[2];
+					for (j = 0; j < seqs[i]->rnum; j++)
+						ccv_array_push(seq, ccv_array_get(seqs[i], j));
+					ccv_array_free(seqs[i]);
 				}
+			ccfree(seqs);
+			ccfree(offsets);
+			ccfree(scales);
+		} else {
+			for (i = 0; i < scale_upto; i++)
+			{
+				int q;
+				for (q = 0; q < qn; q++)
+					_ccv_bbf_scan(cascade, t, pyr, next, i, q, 0, INT_MAX, scale_x, scale_y, &seq);
+				scale_x *= scale;
+				scale_y *= scale;
 			}
-			scale_x *= scale;
-			scale_y *= scale;
 		}
 
 		/* the following code from OpenCV's haar feature implementation */
@@ -1291,7 +1412,7 @@ ccv_array_t* ccv_bbf_detect_objects(ccv_dense_matrix_t* a, ccv_bbf_classifier_ca
 			idx_seq = 0;
 			ccv_array_clear(seq2);
 			// group retrieved rectangles in order to filter out noise
-			int ncomp = ccv_array_group(seq, &idx_seq, _ccv_is_equal_same_class, 0);
+			int ncomp = ccv_array_group_spatially(seq, &idx_seq, _ccv_is_equal_same_class, _ccv_equal_bound, 0);
 			ccv_comp_t* comps = (ccv_comp_t*)ccmalloc((ncomp + 1) * sizeof(ccv_comp_t));
 			memset(comps, 0, (ncomp + 1) * sizeof(ccv_comp_t));
 
@@ -1333,37 +1454,25 @@ ccv_array_t* ccv_bbf_detect_objects(ccv_dense_matrix_t* a, ccv_bbf_classifier_ca
 			}
 
 			// filter out small face rectangles inside large face rectangles
+			ccv_bbf_nested_t nested = {
+				.seq = seq2,
+				.nested = (int*)cccalloc(seq2->rnum + 1, sizeof(int)),
+			};
+			ccv_array_intersect(seq2, _ccv_nested_bound, _ccv_nested, &nested);
 			for(i = 0; i < seq2->rnum; i++)
-			{
-				ccv_comp_t r1 = *(ccv_comp_t*)ccv_array_get(seq2, i);
-				int flag = 1;
-
-				for(j = 0; j < seq2->rnum; j++)
-				{
-					ccv_comp_t r2 = *(ccv_comp_t*)ccv_array_get(seq2, j);
-					int distance = (int)(r2.rect.width * 0.25 + 0.5);
-
-					if(i != j &&
-					   r1.classification.id == r2.classification.id &&
-					   r1.rect.x >= r2.rect.x - distance &&
-					   r1.rect.y >= r2.rect.y - distance &&
-					   r1.rect.x + r1.rect.width <= r2.rect.x + r2.rect.width + distance &&
-					   r1.rect.y + r1.rect.height <= r2.rect.y + r2.rect.height + distance &&
-					   (r2.neighbors > ccv_max(3, r1.neighbors) || r1.neighbors < 3))
-					{
-						flag = 0;
-						break;
-					}
-				}
-
-				if(flag)
-					ccv_array_push(result_seq, &r1);
-			}
+				if(!nested.nested[i])
+					ccv_array_push(result_seq, ccv_array_get(seq2, i));
+			ccfree(nested.nested);
 			ccv_array_free(idx_seq);
 			ccfree(comps);
 		}
 	}
 
+	// Every cascade scans all the levels, release them after the last one.
+	for (i = 0; i < (scale_upto + next * 2) * 4; i++)
+		if (pyr[i])
+			ccv_pyramid_release(pyramid, pyr[i]);
+
 	ccv_array_free(seq);
 	ccv_array_free(seq2);
 
@@ -1374,7 +1483,7 @@ ccv_array_t* ccv_bbf_detect_objects(ccv_dense_matrix_t* a, ccv_bbf_classifier_ca
 		result_seq2 = ccv_array_new(sizeof(ccv_comp_t), 64, 0);
 		idx_seq = 0;
 		// group retrieved rectangles in order to filter out noise
-		int ncomp = ccv_array_group(result_seq, &idx_seq, _ccv_is_equal, 0);
+		int ncomp = ccv_array_group_spatially(result_seq, &idx_seq, _ccv_is_equal, _ccv_equal_bound, 0);
 		ccv_comp_t* comps = (ccv_comp_t*)ccmalloc((ncomp + 1) * sizeof(ccv_comp_t));
 		memset(comps, 0, (ncomp + 1) * sizeof(ccv_comp_t));
 
@@ -1404,21 +1513,17 @@ ccv_array_t* ccv_bbf_detect_objects(ccv_dense_matrix_t* a, ccv_bbf_classifier_ca
 		result_seq2 = result_seq;
 	}
 
-	for (i = 1; i < scale_upto + next * 2; i++)
-		ccv_matrix_free(pyr[i * 4]);
-	if (params.accurate)
-		for (i = next * 2; i < scale_upto + next * 2; i++)
-		{
-			ccv_matrix_free(pyr[i * 4 + 1]);
-			ccv_matrix_free(pyr[i * 4 + 2]);
-			ccv_matrix_free(pyr[i * 4 + 3]);
-		}
-	if (params.size.height != _cascade[0]->size.height || params.size.width != _cascade[0]->size.width)
-		ccv_matrix_free(pyr[0]);
-
 	return result_seq2;
 }
 
+ccv_array_t* ccv_bbf_detect_objects(ccv_dense_matrix_t* a, ccv_bbf_classifier_cascade_t** _cascade, int count, ccv_bbf_param_t params)
+{
+	ccv_pyramid_t* pyramid = ccv_pyramid_new(a, 0);
+	ccv_array_t* result_seq = ccv_bbf_detect_objects_in_pyramid(pyramid, _cascade, count, params);
+	ccv_pyramid_free(pyramid);
+	return result_seq;
+}
+
 ccv_bbf_classifier_cascade_t* ccv_bbf_read_classifier_cascade(const char* directory)
 {
 	char buf[1024];
@@ -5,6 +5,8 @@
 #define CCV_GET_TERMINAL_AGE(x) (((x) >> 32) & 0x0FFFFFFF)
 #define CCV_GET_TERMINAL_SIZE(x) ((x) & 0xFFFFFFFF)
 #define CCV_SET_TERMINAL_TYPE(x, y, z) (((uint64_t)(x) << 60) | ((uint64_t)(y) << 32) | (z))
+/* the age only has 28 bits in a terminal, once the age of a cache gets here, it is rebased */
+#define CCV_CACHE_AGE_REBASE (0x0F000000)
 
 void ccv_cache_init(ccv_cache_t* cache, size_t up, int cache_types, ccv_cache_index_free_f ffree, ...)
 {
@@ -21,6 +23,7 @@ void ccv_cache_init(ccv_cache_t* cache, size_t up, int cache_types, ccv_cache_in
 		cache->ffree[i] = va_arg(arguments, ccv_cache_index_free_f);
 	va_end(arguments);
 	memset(&cache->origin, 0, sizeof(ccv_cache_index_t));
+	memset(&cache->stat, 0, sizeof(ccv_cache_stat_t));
 }
 
 static int bits_in_16bits[0x1u << 16];
@@ -145,15 +148,17 @@ static ccv_cache_index_t* _ccv_cache_seek(ccv_cache_index_t* branch, uint64_t si
 void* ccv_cache_get(ccv_cache_t* cache, uint64_t sign, uint8_t* type)
 {
 	if (cache->rnum == 0)
+	{
+		++cache->stat.miss;
 		return 0;
+	}
 	ccv_cache_index_t* branch = _ccv_cache_seek(&cache->origin, sign, 0);
-	if (!branch)
-		return 0;
-	int leaf = branch->terminal.off & 0x1;
-	if (!leaf)
-		return 0;
-	if (branch->terminal.sign != sign)
+	if (!branch || !(branch->terminal.off & 0x1) || branch->terminal.sign != sign)
+	{
+		++cache->stat.miss;
 		return 0;
+	}
+	++cache->stat.type[CCV_GET_CACHE_TYPE(branch->terminal.type)].hit;
 	if (type)
 		*type = CCV_GET_CACHE_TYPE(branch->terminal.type);
 	return (void*)(branch->terminal.off - (branch->terminal.off & 0x3));
@@ -173,6 +178,10 @@ static void _ccv_cache_lru(ccv_cache_t* cache)
 			assert(type >= 0 && type < 16);
 			cache->ffree[type](result);
 		}
+		++cache->stat.type[type].eviction;
+		cache->stat.type[type].evicted_size += cache->size;
+		cache->stat.type[type].rnum = 0;
+		cache->stat.type[type].size = 0;
 		cache->rnum = 0;
 		cache->size = 0;
 		return;
@@ -185,6 +194,9 @@ static void _ccv_cache_lru(ccv_cache_t* cache)
 		int leaf = branch->terminal.off & 0x1;
 		if (leaf)
 		{
+			ccv_cache_type_stat_t* stat = cache->stat.type + CCV_GET_CACHE_TYPE(branch->terminal.type);
+			++stat->eviction;
+			stat->evicted_size += CCV_GET_TERMINAL_SIZE(branch->terminal.type);
 			ccv_cache_delete(cache, branch->terminal.sign);
 			break;
 		} else {
@@ -212,24 +224,87 @@ static void _ccv_cache_depleted(ccv_cache_t* cache, size_t size)
 		_ccv_cache_lru(cache);
 }
 
+/* the age an object put now should have, an object with cost is treated as if it were put later, for every
+ * multiple of its size in cost, it gets a turnover of the cache (the number of objects it holds when full) more puts */
+static uint32_t _ccv_cache_credited_age(ccv_cache_t* cache, uint32_t size, uint64_t cost)
+{
+	if (cost == 0 || size == 0)
+		return cache->age;
+	uint64_t turnover = cache->size > 0 ? cache->up * cache->rnum / cache->size : cache->up / size;
+	turnover = ccv_clamp(turnover, 1, 0x0FFFFFFF);
+	if (cost / size >= 0x0FFFFFFF)
+		return 0x0FFFFFFF;
+	uint64_t age = cache->age + cost / size * turnover + cost % size * turnover / size;
+	return ccv_min(age, 0x0FFFFFFF);
+}
+
+static uint32_t _ccv_cache_rebased_age(uint32_t age, uint32_t shift)
+{
+	// the ones older than shift are all the least recently used now, 0 is reserved for an empty cache
+	return age > shift + 1 ? age - shift : 1;
+}
+
+static void _ccv_cache_rebase(ccv_cache_index_t* branch, uint32_t shift)
+{
+	int leaf = branch->terminal.off & 0x1;
+	if (leaf)
+	{
+		uint32_t age = _ccv_cache_rebased_age(CCV_GET_TERMINAL_AGE(branch->terminal.type), shift);
+		branch->terminal.type = CCV_SET_TERMINAL_TYPE(CCV_GET_CACHE_TYPE(branch->terminal.type), age, CCV_GET_TERMINAL_SIZE(branch->terminal.type));
+	} else {
+		ccv_cache_index_t* set = (ccv_cache_index_t*)(branch->branch.set - (branch->branch.set & 0x3));
+		uint32_t i, total = compute_bits(branch->branch.bitmap);
+		for (i = 0; i < total; i++)
+			_ccv_cache_rebase(set + i, shift);
+		// it is monotonic, thus, the youngest age of the children is still the rebased one
+		branch->branch.age = _ccv_cache_rebased_age(branch->branch.age, shift);
+	}
+}
+
+void ccv_cache_rebase_age(ccv_cache_t* cache, uint32_t shift)
+{
+	if (shift == 0)
+		return;
+	if (cache->rnum > 0)
+		_ccv_cache_rebase(&cache->origin, shift);
+	cache->age = _ccv_cache_rebased_age(cache->age, shift);
+}
+
 int ccv_cache_put(ccv_cache_t* cache, uint64_t sign, void* x, uint32_t size, uint8_t type)
+{
+	return ccv_cache_put_with_cost(cache, sign, x, size, type, 0);
+}
+
+int ccv_cache_put_with_cost(ccv_cache_t* cache, uint64_t sign, void* x, uint32_t size, uint8_t type, uint64_t cost)
 {
 	assert(((uint64_t)x & 0x3) == 0);
 	if (size > cache->up)
 		return -1;
 	if (size + cache->size > cache->up)
 		_ccv_cache_depleted(cache, cache->up - size);
+	if (cache->age >= CCV_CACHE_AGE_REBASE)
+	{
+		// keep the order of the younger half, or of all of them if they are young enough
+		uint32_t lru_age = ccv_cache_lru_age(cache);
+		ccv_cache_rebase_age(cache, ccv_max(lru_age > 0 ? lru_age - 1 : 0, cache->age / 2));
+	}
+	ccv_cache_type_stat_t* stat = cache->stat.type + type;
 	if (cache->rnum == 0)
 	{
-		cache->age = 1;
+		// don't restart the age, it may be shared with other caches
+		++cache->age;
 		cache->origin.terminal.off = (uint64_t)x | 0x1;
 		cache->origin.terminal.sign = sign;
-		cache->origin.terminal.type = CCV_SET_TERMINAL_TYPE(type, cache->age, size);
+		cache->origin.terminal.type = CCV_SET_TERMINAL_TYPE(type, _ccv_cache_credited_age(cache, size, cost), size);
 		cache->size = size;
 		cache->rnum = 1;
+		++stat->put;
+		++stat->rnum;
+		stat->size += size;
 		return 0;
 	}
 	++cache->age;
+	uint32_t x_age = _ccv_cache_credited_age(cache, size, cost);
 	int i, depth = -1;
 	ccv_cache_index_t* branch = _ccv_cache_seek(&cache->origin, sign, &depth);
 	if (!branch)
@@ -244,8 +319,14 @@ int ccv_cache_put(ccv_cache_t* cache, uint64_t sign, void* x, uint32_t size, uin
 			cache->ffree[CCV_GET_CACHE_TYPE(branch->terminal.type)]((void*)(branch->terminal.off - (branch->terminal.off & 0x3)));
 			branch->terminal.off = (uint64_t)x | 0x1;
 			uint32_t old_size = CCV_GET_TERMINAL_SIZE(branch->terminal.type);
+			ccv_cache_type_stat_t* old_stat = cache->stat.type + CCV_GET_CACHE_TYPE(branch->terminal.type);
+			--old_stat->rnum;
+			old_stat->size -= old_size;
+			++stat->put;
+			++stat->rnum;
+			stat->size += size;
 			cache->size = cache->size + size - old_size;
-			branch->terminal.type = CCV_SET_TERMINAL_TYPE(type, cache->age, size);
+			branch->terminal.type = CCV_SET_TERMINAL_TYPE(type, x_age, size);
 			_ccv_cache_aging(&cache->origin, sign);
 			return 1;
 		} else {
@@ -280,7 +361,7 @@ int ccv_cache_put(ccv_cache_t* cache, uint64_t sign, void* x, uint32_t size, uin
 			int u = dice < udice;
 			set[u].terminal.sign = sign;
 			set[u].terminal.off = (uint64_t)x | 0x1;
-			set[u].terminal.type = CCV_SET_TERMINAL_TYPE(type, cache->age, size);
+			set[u].terminal.type = CCV_SET_TERMINAL_TYPE(type, x_age, size);
 			set[1 - u] = t;
 		}
 	} else {
@@ -296,14 +377,19 @@ int ccv_cache_put(ccv_cache_t* cache, uint64_t sign, void* x, uint32_t size, uin
 			set[i] = set[i - 1];
 		set[start].terminal.off = (uint64_t)x | 0x1;
 		set[start].terminal.sign = sign;
-		set[start].terminal.type = CCV_SET_TERMINAL_TYPE(type, cache->age, size);
+		set[start].terminal.type = CCV_SET_TERMINAL_TYPE(type, x_age, size);
 		branch->branch.set = (uint64_t)set;
 		branch->branch.bitmap |= k;
 		if (total == 63)
 			branch->branch.set |= 0x2;
 	}
+	// objects put with cost may be younger than this one, the age of the path has to be updated
+	_ccv_cache_aging(&cache->origin, sign);
 	cache->rnum++;
 	cache->size += size;
+	++stat->put;
+	++stat->rnum;
+	stat->size += size;
 	return 0;
 }
 
@@ -341,7 +427,7 @@ static void _ccv_cache_cleanup_and_free(ccv_cache_index_t* branch, ccv_cache_ind
 	}
 }
 
-void* ccv_cache_out(ccv_cache_t* cache, uint64_t sign, uint8_t* type)
+static void* _ccv_cache_out(ccv_cache_t* cache, uint64_t sign, uint8_t* type)
 {
 	if (!bits_in_16bits_init)
 		precomputed_16bits();
@@ -394,6 +480,9 @@ void* ccv_cache_out(ccv_cache_t* cache, uint64_t sign, uint8_t* type)
 	if (type)
 		*type = CCV_GET_CACHE_TYPE(branch->terminal.type);
 	uint32_t size = CCV_GET_TERMINAL_SIZE(branch->terminal.type);
+	ccv_cache_type_stat_t* stat = cache->stat.type + CCV_GET_CACHE_TYPE(branch->terminal.type);
+	--stat->rnum;
+	stat->size -= size;
 	if (branch != &cache->origin)
 	{
 		uint64_t k = 1, j = 63;
@@ -426,10 +515,23 @@ void* ccv_cache_out(ccv_cache_t* cache, uint64_t sign, uint8_t* type)
 	return result;
 }
 
+void* ccv_cache_out(ccv_cache_t* cache, uint64_t sign, uint8_t* type)
+{
+	uint8_t x_type = 0;
+	void* result = _ccv_cache_out(cache, sign, &x_type);
+	if (result)
+		++cache->stat.type[x_type].hit;
+	else
+		++cache->stat.miss;
+	if (type)
+		*type = x_type;
+	return result;
+}
+
 int ccv_cache_delete(ccv_cache_t* cache, uint64_t sign)
 {
 	uint8_t type = 0;
-	void* result = ccv_cache_out(cache, sign, &type);
+	void* result = _ccv_cache_out(cache, sign, &type);
 	if (result != 0)
 	{
 		assert(type >= 0 && type < 16);
@@ -439,6 +541,26 @@ int ccv_cache_delete(ccv_cache_t* cache, uint64_t sign)
 	return -1;
 }
 
+uint32_t ccv_cache_lru_age(ccv_cache_t* cache)
+{
+	if (cache->rnum == 0)
+		return 0;
+	if (cache->origin.terminal.off & 0x1)
+		return CCV_GET_TERMINAL_AGE(cache->origin.terminal.type);
+	return cache->origin.branch.age;
+}
+
+void ccv_cache_get_stat(ccv_cache_t* cache, ccv_cache_stat_t* stat)
+{
+	*stat = cache->stat;
+}
+
+void ccv_cache_evict(ccv_cache_t* cache)
+{
+	if (cache->rnum > 0)
+		_ccv_cache_lru(cache);
+}
+
 void ccv_cache_cleanup(ccv_cache_t* cache)
 {
 	if (cache->rnum > 0)
@@ -448,6 +570,9 @@ void ccv_cache_cleanup(ccv_cache_t* cache)
 		cache->age = 0;
 		cache->rnum = 0;
 		memset(&cache->origin, 0, sizeof(ccv_cache_index_t));
+		int i;
+		for (i = 0; i < 16; i++)
+			cache->stat.type[i].rnum = 0, cache->stat.type[i].size = 0;
 	}
 }
 
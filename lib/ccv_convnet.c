@@ -53,6 +53,7 @@ ccv_convnet_t* ccv_convnet_new(int use_cwc_accel, ccv_size_t input, ccv_convnet_
 		layers[i].input = params[i].input;
 		layers[i].net = params[i].output;
 		layers[i].reserved = 0;
+		layers[i].quantized = 0;
 		switch (params[i].type)
 		{
 			case CCV_CONVNET_CONVOLUTIONAL:
@@ -388,6 +389,147 @@ static inline void _ccv_convnet_convolutional_forward_propagate_fallback(ccv_con
 }
 #endif
 
+typedef struct {
+	float input_scale; // the scale of input activations, if it is 0, derive one from each input
+	float* scale; // the scale of weights per output channel
+	float* bias;
+	int8_t* w;
+} ccv_convnet_layer_quantized_t;
+
+#define QUANTIZED(x) ((ccv_convnet_layer_quantized_t*)((x)->quantized))
+
+static inline int _ccv_convnet_dot_s8(const int8_t* a, const int8_t* b, int n)
+{
+	int i = 0, sum = 0;
+#if defined(HAVE_SSE2)
+	__m128i s4 = _mm_setzero_si128();
+	for (; i < n - 15; i += 16)
+	{
+		__m128i a16 = _mm_loadu_si128((const __m128i*)(a + i));
+		__m128i b16 = _mm_loadu_si128((const __m128i*)(b + i));
+		// sign extend to 16-bit, and multiply-add adjacent pairs into 32-bit accumulators
+		__m128i a8l = _mm_srai_epi16(_mm_unpacklo_epi8(a16, a16), 8);
+		__m128i a8h = _mm_srai_epi16(_mm_unpackhi_epi8(a16, a16), 8);
+		__m128i b8l = _mm_srai_epi16(_mm_unpacklo_epi8(b16, b16), 8);
+		__m128i b8h = _mm_srai_epi16(_mm_unpackhi_epi8(b16, b16), 8);
+		s4 = _mm_add_epi32(s4, _mm_add_epi32(_mm_madd_epi16(a8l, b8l), _mm_madd_epi16(a8h, b8h)));
+	}
+	for (; i < n - 7; i += 8)
+	{
+		__m128i a8 = _mm_loadl_epi64((const __m128i*)(a + i));
+		__m128i b8 = _mm_loadl_epi64((const __m128i*)(b + i));
+		s4 = _mm_add_epi32(s4, _mm_madd_epi16(_mm_srai_epi16(_mm_unpacklo_epi8(a8, a8), 8), _mm_srai_epi16(_mm_unpacklo_epi8(b8, b8), 8)));
+	}
+	int s[4] __attribute__ ((__aligned__(16)));
+	_mm_store_si128((__m128i*)s, s4);
+	sum = s[0] + s[1] + s[2] + s[3];
+#elif defined(HAVE_NEON)
+	int32x4_t s4 = vmovq_n_s32(0);
+	for (; i < n - 15; i += 16)
+	{
+		int8x16_t a16 = vld1q_s8(a + i);
+		int8x16_t b16 = vld1q_s8(b + i);
+		s4 = vpadalq_s16(s4, vmull_s8(vget_low_s8(a16), vget_low_s8(b16)));
+		s4 = vpadalq_s16(s4, vmull_s8(vget_high_s8(a16), vget_high_s8(b16)));
+	}
+	sum = vgetq_lane_s32(s4, 0) + vgetq_lane_s32(s4, 1) + vgetq_lane_s32(s4, 2) + vgetq_lane_s32(s4, 3);
+#endif
+	for (; i < n; i++)
+		sum += a[i] * b[i];
+	return sum;
+}
+
+static float _ccv_convnet_quantize_input(ccv_convnet_layer_quantized_t* quantized, const float* a, int8_t* b, int n)
+{
+	int i;
+	float input_scale = quantized->input_scale;
+	if (input_scale == 0)
+	{
+		float max_abs = 0;
+		for (i = 0; i < n; i++)
+			max_abs = ccv_max(max_abs, fabsf(a[i]));
+		input_scale = max_abs > 0 ? max_abs / 127 : 1;
+	}
+	float inv_scale = 1.0 / input_scale;
+	for (i = 0; i < n; i++)
+	{
+		int v = (int)lrintf(a[i] * inv_scale);
+		b[i] = ccv_clamp(v, -127, 127);
+	}
+	return input_scale;
+}
+
+static void _ccv_convnet_convolutional_forward_propagate_quantized(ccv_convnet_layer_t* layer, ccv_dense_matrix_t* a, ccv_dense_matrix_t* db, int rows, int cols, int ch, int count, int strides, int border, int kernel_rows, int kernel_cols, int ch_per_partition, int count_per_partition)
+{
+	ccv_convnet_layer_quantized_t* quantized = QUANTIZED(layer);
+	assert(a->step == a->cols * CCV_GET_DATA_TYPE_SIZE(a->type) * ch);
+	int8_t* qa = (int8_t*)ccmalloc(a->rows * a->cols * ch);
+	float input_scale = _ccv_convnet_quantize_input(quantized, a->data.f32, qa, a->rows * a->cols * ch);
+	parallel_for(k, count) {
+		int i, j, x, y;
+		int p = k / count_per_partition;
+		int8_t* ap = qa + p * ch_per_partition;
+		float* bp = db->data.f32 + k;
+		int8_t* layer_w = quantized->w + k * kernel_rows * kernel_cols * ch_per_partition;
+		float scale = input_scale * quantized->scale[k];
+		float bias = quantized->bias[k];
+		for (i = 0; i < db->rows; i++)
+		{
+			int comy = ccv_max(i * strides - border, 0) - (i * strides - border);
+			int maxy = kernel_rows - comy - (i * strides + kernel_rows - ccv_min(a->rows + border, i * strides + kernel_rows));
+			comy *= ch_per_partition * kernel_cols;
+			for (j = 0; j < db->cols; j++)
+			{
+				int v = 0;
+				int comx = ccv_max(j * strides - border, 0) - (j * strides - border);
+				int maxx = kernel_cols - comx - (j * strides + kernel_cols - ccv_min(a->cols + border, j * strides + kernel_cols));
+				int8_t* w = layer_w + comx * ch_per_partition + comy;
+				int8_t* apz = ap + ccv_max(j * strides - border, 0) * ch;
+				// when we have border, we simply do zero padding
+				for (y = 0; y < maxy; y++)
+				{
+					// without partition, a row of the kernel is one contiguous dot product
+					if (ch_per_partition == ch)
+						v += _ccv_convnet_dot_s8(w, apz, maxx * ch);
+					else
+						for (x = 0; x < maxx; x++)
+							v += _ccv_convnet_dot_s8(w + x * ch_per_partition, apz + x * ch, ch_per_partition);
+					w += kernel_cols * ch_per_partition;
+					apz += a->cols * ch;
+				}
+				bp[j * count] = ccv_max(0, v * scale + bias); // ReLU
+			}
+			bp += db->cols * count;
+			ap += a->cols * ch * (ccv_max((i + 1) * strides - border, 0) - ccv_max(i * strides - border, 0));
+		}
+	} parallel_endfor
+	ccfree(qa);
+}
+
+// computes batch rows of n inputs against the 8-bit weights, the output is batch rows of count
+static void _ccv_convnet_full_connect_forward_propagate_quantized(ccv_convnet_layer_t* layer, const float* a, float* b, int batch, int n)
+{
+	ccv_convnet_layer_quantized_t* quantized = QUANTIZED(layer);
+	int count = layer->net.full_connect.count;
+	assert(n * count == layer->wnum);
+	int8_t* qa = (int8_t*)ccmalloc(batch * n);
+	// each row has its own input scale, thus, the output of a row doesn't depend on the other rows in the batch
+	float* input_scale = (float*)alloca(sizeof(float) * batch);
+	int k;
+	for (k = 0; k < batch; k++)
+		input_scale[k] = _ccv_convnet_quantize_input(quantized, a + k * n, qa + k * n, n);
+	parallel_for(i, count) {
+		int j;
+		int8_t* w = quantized->w + i * n;
+		for (j = 0; j < batch; j++)
+		{
+			float v = _ccv_convnet_dot_s8(w, qa + j * n, n) * input_scale[j] * quantized->scale[i] + quantized->bias[i];
+			b[j * count + i] = layer->net.full_connect.relu ? ccv_max(0, v) : v;
+		}
+	} parallel_endfor
+	ccfree(qa);
+}
+
 static void _ccv_convnet_convolutional_forward_propagate(ccv_convnet_layer_t* layer, ccv_dense_matrix_t* a, ccv_dense_matrix_t** b)
 {
 	int rows, cols, partition;
@@ -405,6 +547,11 @@ static void _ccv_convnet_convolutional_forward_propagate(ccv_convnet_layer_t* la
 	int ch_per_partition = ch / partition;
 	int count_per_partition = count / partition;
 	assert(count_per_partition % 4 == 0);
+	if (QUANTIZED(layer))
+	{
+		_ccv_convnet_convolutional_forward_propagate_quantized(layer, a, db, rows, cols, ch, count, strides, border, kernel_rows, kernel_cols, ch_per_partition, count_per_partition);
+		return;
+	}
 #if defined(HAVE_SSE2) || defined(HAVE_NEON)
 	_ccv_convnet_layer_simd_alloc_reserved(layer);
 #endif
@@ -423,6 +570,12 @@ static void _ccv_convnet_full_connect_forward_propagate(ccv_convnet_layer_t* lay
 	ccv_dense_matrix_t* db = *b = ccv_dense_matrix_renew(*b, layer->net.full_connect.count, 1, CCV_32F | CCV_C1, CCV_32F | CCV_C1, 0);
 	int ch = CCV_GET_CHANNEL(a->type);
 	int rows = a->rows, cols = a->cols;
+	if (QUANTIZED(layer))
+	{
+		assert(a->step == a->cols * CCV_GET_DATA_TYPE_SIZE(a->type) * ch);
+		_ccv_convnet_full_connect_forward_propagate_quantized(layer, a->data.f32, db->data.f32, 1, rows * cols * ch);
+		return;
+	}
 	// reshape a for gemm
 	assert(a->step == a->cols * CCV_GET_DATA_TYPE_SIZE(a->type) * ch);
 	a->rows = rows * cols * ch, a->cols = 1, a->type = (a->type - ch) | CCV_C1;
@@ -601,6 +754,12 @@ static void _ccv_convnet_full_connect_forward_propagate_parallel(ccv_convnet_lay
 {
 	assert(CCV_GET_DATA_TYPE(a->type) == CCV_32F);
 	ccv_dense_matrix_t* db = *b = ccv_dense_matrix_renew(*b, a->rows, layer->net.full_connect.count, CCV_32F | CCV_C1, CCV_32F | CCV_C1, 0);
+	if (QUANTIZED(layer))
+	{
+		assert(a->step == a->cols * CCV_GET_DATA_TYPE_SIZE(a->type));
+		_ccv_convnet_full_connect_forward_propagate_quantized(layer, a->data.f32, db->data.f32, a->rows, a->cols);
+		return;
+	}
 	// reshape a for gemm
 	int i, j;
 	float* bptr = db->data.f32;
@@ -735,6 +894,9 @@ void ccv_convnet_classify(ccv_convnet_t* convnet, ccv_dense_matrix_t** a, int sy
 	assert(scan >= 0 && scan < convnet->count);
 	assert(full_connect >= 0 && full_connect < convnet->count);
 	memset(b, 0, sizeof(ccv_dense_matrix_t*) * (convnet->count + 1));
+	// Inputs to the full connect layers from the whole batch are stacked, thus, these layers are computed with one GEMM.
+	const int crops = 5 * (!!symmetric + 1);
+	ccv_dense_matrix_t* c = ccv_dense_matrix_new(crops * batch, convnet->layers[full_connect].input.node.count, CCV_32F | CCV_C1, 0, 0);
 	for (i = 0; i < batch; i++)
 	{
 		assert(CCV_GET_CHANNEL(a[i]->type) == convnet->channels);
@@ -755,7 +917,6 @@ void ccv_convnet_classify(ccv_convnet_t* convnet, ccv_dense_matrix_t** a, int sy
 		ccv_matrix_free(slice);
 		// doing the first few layers until the first scan layer
 		int out_rows, out_cols, out_partition;
-		ccv_dense_matrix_t* c = ccv_dense_matrix_new(5 * (!!symmetric + 1), convnet->layers[full_connect].input.node.count, CCV_32F | CCV_C1, 0, 0);
 		for (t = 0; t <= !!symmetric; t++)
 		{
 			rows = b[0]->rows, cols = b[0]->cols;
@@ -782,7 +943,7 @@ void ccv_convnet_classify(ccv_convnet_t* convnet, ccv_dense_matrix_t** a, int sy
 				ccv_convnet_layer_t* layer = convnet->layers + scan + 1;
 				ccv_slice(b[scan + 1], (ccv_matrix_t**)&input, CCV_32F, offsets[k][1], offsets[k][0], layer->input.matrix.rows, layer->input.matrix.cols);
 				// copy the last layer for full connect compute
-				b[full_connect] = ccv_dense_matrix_new(convnet->layers[full_connect].input.matrix.rows, convnet->layers[full_connect].input.matrix.cols, CCV_NO_DATA_ALLOC | CCV_32F | convnet->layers[full_connect].input.matrix.channels, c->data.f32 + (t * 5 + k) * convnet->layers[full_connect].input.node.count, 0);
+				b[full_connect] = ccv_dense_matrix_new(convnet->layers[full_connect].input.matrix.rows, convnet->layers[full_connect].input.matrix.cols, CCV_NO_DATA_ALLOC | CCV_32F | convnet->layers[full_connect].input.matrix.channels, c->data.f32 + (i * crops + t * 5 + k) * convnet->layers[full_connect].input.node.count, 0);
 				for (j = scan + 1; j < full_connect; j++)
 				{
 					layer = convnet->layers + j;
@@ -802,18 +963,23 @@ void ccv_convnet_classify(ccv_convnet_t* convnet, ccv_dense_matrix_t** a, int sy
 				ccv_flip(b[0], &b[0], 0, CCV_FLIP_X);
 		}
 		ccv_matrix_free(b[0]);
-		// now have everything in c, do the last full connect propagate
-		b[full_connect] = c;
-		for (j = full_connect; j < convnet->count; j++)
-		{
-			ccv_convnet_layer_t* layer = convnet->layers + j;
-			assert(layer->type == CCV_CONVNET_FULL_CONNECT);
-			_ccv_convnet_full_connect_forward_propagate_parallel(layer, b[j], b + j + 1);
-			ccv_matrix_free(b[j]);
-		}
+		memset(b, 0, sizeof(ccv_dense_matrix_t*) * (convnet->count + 1));
+	}
+	// now have everything in c, do the last full connect propagate
+	b[full_connect] = c;
+	for (j = full_connect; j < convnet->count; j++)
+	{
+		ccv_convnet_layer_t* layer = convnet->layers + j;
+		assert(layer->type == CCV_CONVNET_FULL_CONNECT);
+		_ccv_convnet_full_connect_forward_propagate_parallel(layer, b[j], b + j + 1);
+		ccv_matrix_free(b[j]);
+	}
+	ccv_dense_matrix_t* output = b[convnet->count];
+	for (i = 0; i < batch; i++)
+	{
+		ccv_dense_matrix_t crop_output = ccv_dense_matrix(crops, output->cols, CCV_32F | CCV_C1, output->data.f32 + i * crops * output->cols, 0);
 		ccv_dense_matrix_t* softmax = 0;
-		_ccv_convnet_compute_softmax_parallel(b[convnet->count], &softmax, 0);
-		ccv_matrix_free(b[convnet->count]);
+		_ccv_convnet_compute_softmax_parallel(&crop_output, &softmax, 0);
 		ranks[i] = ccv_array_new(sizeof(ccv_classification_t), tops, 0);
 		float* r = softmax->data.f32;
 		assert(tops <= softmax->cols);
@@ -828,13 +994,13 @@ void ccv_convnet_classify(ccv_convnet_t* convnet, ccv_dense_matrix_t** a, int sy
 			r[max_idx] = -1;
 			ccv_classification_t classification = {
 				.id = max_idx,
-				.confidence = max_val / ((!!symmetric + 1) * 5),
+				.confidence = max_val / crops,
 			};
 			ccv_array_push(ranks[i], &classification);
 		}
 		ccv_matrix_free(softmax);
-		memset(b, 0, sizeof(ccv_dense_matrix_t*) * (convnet->count + 1));
 	}
+	ccv_matrix_free(output);
 #ifdef HAVE_CUDA
 	}
 #endif
@@ -1242,6 +1408,7 @@ static ccv_convnet_t* _ccv_convnet_update_new(ccv_convnet_t* convnet)
 		update_params->layers[i].net = convnet->layers[i].net;
 		update_params->layers[i].wnum = convnet->layers[i].wnum;
 		update_params->layers[i].reserved = 0;
+		update_params->layers[i].quantized = 0;
 		switch (update_params->layers[i].type)
 		{
 			case CCV_CONVNET_CONVOLUTIONAL:
@@ -1406,6 +1573,94 @@ void ccv_convnet_compact(ccv_convnet_t* convnet)
 	}
 }
 
+void ccv_convnet_quantize(ccv_convnet_t* convnet, ccv_dense_matrix_t** a, int batch)
+{
+	assert(!convnet->use_cwc_accel);
+	int i, j, k;
+	float* input_max = (float*)cccalloc(convnet->count, sizeof(float));
+	ccv_dense_matrix_t** b = (ccv_dense_matrix_t**)alloca(sizeof(ccv_dense_matrix_t*) * (convnet->count + 1));
+	// calibrate on the center of sample images, find the range of inputs to each layer
+	for (i = 0; i < batch; i++)
+	{
+		assert(CCV_GET_CHANNEL(a[i]->type) == convnet->channels);
+		assert(a[i]->rows >= convnet->rows && a[i]->cols >= convnet->cols);
+		memset(b, 0, sizeof(ccv_dense_matrix_t*) * (convnet->count + 1));
+		ccv_dense_matrix_t* slice = 0;
+		ccv_slice(a[i], (ccv_matrix_t**)&slice, CCV_32F, (a[i]->rows - convnet->rows) / 2, (a[i]->cols - convnet->cols) / 2, convnet->rows, convnet->cols);
+		ccv_dense_matrix_t* mean_activity = 0;
+		ccv_resample(convnet->mean_activity, &mean_activity, 0, convnet->rows, convnet->cols, CCV_INTER_CUBIC);
+		ccv_subtract(slice, mean_activity, (ccv_matrix_t**)b, CCV_32F);
+		ccv_matrix_free(mean_activity);
+		ccv_matrix_free(slice);
+		for (j = 0; j < convnet->count; j++)
+		{
+			ccv_convnet_layer_t* layer = convnet->layers + j;
+			if (layer->type == CCV_CONVNET_CONVOLUTIONAL || layer->type == CCV_CONVNET_FULL_CONNECT)
+			{
+				int n = b[j]->rows * b[j]->cols * CCV_GET_CHANNEL(b[j]->type);
+				for (k = 0; k < n; k++)
+					input_max[j] = ccv_max(input_max[j], fabsf(b[j]->data.f32[k]));
+			}
+			_ccv_convnet_layer_forward_propagate(layer, b[j], b + j + 1, 0);
+			ccv_matrix_free(b[j]);
+		}
+		ccv_matrix_free(b[convnet->count]);
+	}
+	for (i = 0; i < convnet->count; i++)
+	{
+		ccv_convnet_layer_t* layer = convnet->layers + i;
+		if ((layer->type != CCV_CONVNET_CONVOLUTIONAL && layer->type != CCV_CONVNET_FULL_CONNECT) || QUANTIZED(layer))
+			continue;
+		int count = layer->type == CCV_CONVNET_CONVOLUTIONAL ? layer->net.convolutional.count : layer->net.full_connect.count;
+		ccv_convnet_layer_quantized_t* quantized = (ccv_convnet_layer_quantized_t*)ccmalloc(sizeof(ccv_convnet_layer_quantized_t) + sizeof(float) * count * 2 + layer->wnum);
+		quantized->input_scale = input_max[i] / 127;
+		quantized->scale = (float*)(quantized + 1);
+		quantized->bias = quantized->scale + count;
+		quantized->w = (int8_t*)(quantized->bias + count);
+		// symmetric quantization per output channel, for both layer types weights of an output channel are contiguous
+		int n = layer->wnum / count;
+		for (j = 0; j < count; j++)
+		{
+			float* w = layer->w + j * n;
+			float max_abs = 0;
+			for (k = 0; k < n; k++)
+				max_abs = ccv_max(max_abs, fabsf(w[k]));
+			quantized->scale[j] = max_abs > 0 ? max_abs / 127 : 1;
+			float inv_scale = 1.0 / quantized->scale[j];
+			for (k = 0; k < n; k++)
+			{
+				int v = (int)lrintf(w[k] * inv_scale);
+				quantized->w[j * n + k] = ccv_clamp(v, -127, 127);
+			}
+		}
+		memcpy(quantized->bias, layer->bias, sizeof(float) * count);
+		// bias was allocated along with the full precision weights
+		ccfree(layer->w);
+		layer->w = 0;
+		layer->bias = quantized->bias;
+		layer->quantized = quantized;
+		if (SIMD(layer))
+		{
+			ccfree(layer->reserved);
+			layer->reserved = 0;
+		}
+	}
+	ccfree(input_max);
+}
+
+static float* _ccv_convnet_layer_dequantize(ccv_convnet_layer_t* layer)
+{
+	ccv_convnet_layer_quantized_t* quantized = QUANTIZED(layer);
+	int count = layer->type == CCV_CONVNET_CONVOLUTIONAL ? layer->net.convolutional.count : layer->net.full_connect.count;
+	int n = layer->wnum / count;
+	float* w = (float*)ccmalloc(sizeof(float) * layer->wnum);
+	int i, j;
+	for (i = 0; i < count; i++)
+		for (j = 0; j < n; j++)
+			w[i * n + j] = quantized->w[i * n + j] * quantized->scale[i];
+	return w;
+}
+
 void ccv_convnet_write(ccv_convnet_t* convnet, const char* filename, ccv_convnet_write_param_t params)
 {
 	sqlite3* db = 0;
@@ -1486,16 +1741,20 @@ void ccv_convnet_write(ccv_convnet_t* convnet, const char* filename, ccv_convnet
 			if (layer->type == CCV_CONVNET_CONVOLUTIONAL || layer->type == CCV_CONVNET_FULL_CONNECT)
 			{
 				sqlite3_bind_int(layer_data_insert_stmt, 1, i);
+				// the file format only has full precision or half precision weights, write out what the 8-bit weights represent
+				float* layer_w = QUANTIZED(layer) ? _ccv_convnet_layer_dequantize(layer) : layer->w;
 				if (params.half_precision)
 				{
 					uint16_t* w = (uint16_t*)ccmalloc(sizeof(uint16_t) * layer->wnum);
-					ccv_float_to_half_precision(layer->w, w, layer->wnum);
+					ccv_float_to_half_precision(layer_w, w, layer->wnum);
+					if (QUANTIZED(layer))
+						ccfree(layer_w);
 					uint16_t* bias = (uint16_t*)ccmalloc(sizeof(uint16_t) * (layer->type == CCV_CONVNET_CONVOLUTIONAL ? layer->net.convolutional.count : layer->net.full_connect.count));
 					ccv_float_to_half_precision(layer->bias, bias, layer->type == CCV_CONVNET_CONVOLUTIONAL ? layer->net.convolutional.count : layer->net.full_connect.count);
 					sqlite3_bind_blob(layer_data_insert_stmt, 2, w, sizeof(uint16_t) * layer->wnum, ccfree);
 					sqlite3_bind_blob(layer_data_insert_stmt, 3, bias, sizeof(uint16_t) * (layer->type == CCV_CONVNET_CONVOLUTIONAL ? layer->net.convolutional.count : layer->net.full_connect.count), ccfree);
 				} else {
-					sqlite3_bind_blob(layer_data_insert_stmt, 2, layer->w, sizeof(float) * layer->wnum, SQLITE_STATIC);
+					sqlite3_bind_blob(layer_data_insert_stmt, 2, layer_w, sizeof(float) * layer->wnum, QUANTIZED(layer) ? ccfree : SQLITE_STATIC);
 					sqlite3_bind_blob(layer_data_insert_stmt, 3, layer->bias, sizeof(float) * (layer->type == CCV_CONVNET_CONVOLUTIONAL ? layer->net.convolutional.count : layer->net.full_connect.count), SQLITE_STATIC);
 				}
 				sqlite3_bind_int(layer_data_insert_stmt, 4, params.half_precision);
@@ -1697,8 +1956,12 @@ void ccv_convnet_free(ccv_convnet_t* convnet)
 	ccv_convnet_compact(convnet);
 	int i;
 	for (i = 0; i < convnet->count; i++)
+	{
 		if (convnet->layers[i].w)
 			ccfree(convnet->layers[i].w);
+		if (QUANTIZED(convnet->layers + i))
+			ccfree(convnet->layers[i].quantized);
+	}
 	if (convnet->mean_activity)
 		ccv_matrix_free(convnet->mean_activity);
 	ccfree(convnet);
@@ -42,44 +42,34 @@ static int _ccv_dpm_scale_upto(ccv_dense_matrix_t* a, ccv_dpm_mixture_model_t**
 	return (int)(log((double)ccv_min(hr, wr)) / log(scale)) - next;
 }
 
-static void _ccv_dpm_feature_pyramid(ccv_dense_matrix_t* a, ccv_dense_matrix_t** pyr, int scale_upto, int interval)
+// Same as _ccv_dpm_feature_pyramid, but the image levels and HOG features come from a shared pyramid.
+static void _ccv_dpm_feature_pyramid_from(ccv_pyramid_t* pyramid, ccv_dense_matrix_t** pyr, int scale_upto, int interval)
 {
 	int next = interval + 1;
 	double scale = pow(2.0, 1.0 / (interval + 1.0));
-	memset(pyr, 0, (scale_upto + next * 2) * sizeof(ccv_dense_matrix_t*));
-	pyr[next] = a;
+	ccv_dense_matrix_t** level = (ccv_dense_matrix_t**)alloca((scale_upto + next * 2) * sizeof(ccv_dense_matrix_t*));
+	level[next] = pyramid->image;
 	int i;
 	for (i = 1; i <= interval; i++)
-		ccv_resample(pyr[next], &pyr[next + i], 0, (int)(pyr[next]->rows / pow(scale, i)), (int)(pyr[next]->cols / pow(scale, i)), CCV_INTER_AREA);
-	for (i = next; i < scale_upto + next; i++)
-		ccv_sample_down(pyr[i], &pyr[i + next], 0, 0, 0);
-	ccv_dense_matrix_t* hog;
-	/* a more efficient way to generate up-scaled hog (using smaller size) */
-	for (i = 0; i < next; i++)
+		level[next + i] = ccv_pyramid_resample(pyramid, level[next], (int)(level[next]->rows / pow(scale, i)), (int)(level[next]->cols / pow(scale, i)), CCV_INTER_AREA);
+	// Walk down the levels, each one is released as soon as its half size level and HOG features are computed.
+	for (i = next; i < scale_upto + next * 2; i++)
 	{
-		hog = 0;
-		ccv_hog(pyr[i + next], &hog, 0, 9, CCV_DPM_WINDOW_SIZE / 2 /* this is */);
-		pyr[i] = hog;
-	}
-	hog = 0;
-	ccv_hog(pyr[next], &hog, 0, 9, CCV_DPM_WINDOW_SIZE);
-	pyr[next] = hog;
-	for (i = next + 1; i < scale_upto + next * 2; i++)
-	{
-		hog = 0;
-		ccv_hog(pyr[i], &hog, 0, 9, CCV_DPM_WINDOW_SIZE);
-		ccv_matrix_free(pyr[i]);
-		pyr[i] = hog;
+		if (i < scale_upto + next)
+			level[i + next] = ccv_pyramid_sample_down(pyramid, level[i], 0, 0);
+		/* a more efficient way to generate up-scaled hog (using smaller size) */
+		if (i < next * 2)
+			pyr[i - next] = ccv_pyramid_hog(pyramid, level[i], 9, CCV_DPM_WINDOW_SIZE / 2);
+		pyr[i] = ccv_pyramid_hog(pyramid, level[i], 9, CCV_DPM_WINDOW_SIZE);
+		ccv_pyramid_release(pyramid, level[i]);
 	}
 }
 
 static void _ccv_dpm_compute_score(ccv_dpm_root_classifier_t* root_classifier, ccv_dense_matrix_t* hog, ccv_dense_matrix_t* hog2x, ccv_dense_matrix_t** _response, ccv_dense_matrix_t** part_feature, ccv_dense_matrix_t** dx, ccv_dense_matrix_t** dy)
 {
-	ccv_dense_matrix_t* response = 0;
-	ccv_filter(hog, root_classifier->root.w, &response, 0, CCV_NO_PADDING);
 	ccv_dense_matrix_t* root_feature = 0;
-	ccv_flatten(response, (ccv_matrix_t**)&root_feature, 0, 0);
-	ccv_matrix_free(response);
+	// the responses of all HOG channels are summed up in the frequency domain
+	ccv_filter(hog, root_classifier->root.w, &root_feature, CCV_32F | CCV_C1, CCV_NO_PADDING);
 	*_response = root_feature;
 	if (hog2x == 0)
 		return;
@@ -90,11 +80,8 @@ static void _ccv_dpm_compute_score(ccv_dpm_root_classifier_t* root_classifier, c
 	for (i = 0; i < root_classifier->count; i++)
 	{
 		ccv_dpm_part_classifier_t* part = root_classifier->part + i;
-		ccv_dense_matrix_t* response = 0;
-		ccv_filter(hog2x, part->w, &response, 0, CCV_NO_PADDING);
 		ccv_dense_matrix_t* feature = 0;
-		ccv_flatten(response, (ccv_matrix_t**)&feature, 0, 0);
-		ccv_matrix_free(response);
+		ccv_filter(hog2x, part->w, &feature, CCV_32F | CCV_C1, CCV_NO_PADDING);
 		part_feature[i] = dx[i] = dy[i] = 0;
 		ccv_distance_transform(feature, &part_feature[i], 0, &dx[i], 0, &dy[i], 0, part->dx, part->dy, part->dxx, part->dyy, CCV_NEGATIVE | CCV_GSEDT);
 		ccv_matrix_free(feature);
@@ -120,6 +107,37 @@ static void _ccv_dpm_compute_score(ccv_dpm_root_classifier_t* root_classifier, c
 #ifdef HAVE_LIBLINEAR
 #ifdef HAVE_GSL
 
+static void _ccv_dpm_feature_pyramid(ccv_dense_matrix_t* a, ccv_dense_matrix_t** pyr, int scale_upto, int interval)
+{
+	int next = interval + 1;
+	double scale = pow(2.0, 1.0 / (interval + 1.0));
+	memset(pyr, 0, (scale_upto + next * 2) * sizeof(ccv_dense_matrix_t*));
+	pyr[next] = a;
+	int i;
+	for (i = 1; i <= interval; i++)
+		ccv_resample(pyr[next], &pyr[next + i], 0, (int)(pyr[next]->rows / pow(scale, i)), (int)(pyr[next]->cols / pow(scale, i)), CCV_INTER_AREA);
+	for (i = next; i < scale_upto + next; i++)
+		ccv_sample_down(pyr[i], &pyr[i + next], 0, 0, 0);
+	ccv_dense_matrix_t* hog;
+	/* a more efficient way to generate up-scaled hog (using smaller size) */
+	for (i = 0; i < next; i++)
+	{
+		hog = 0;
+		ccv_hog(pyr[i + next], &hog, 0, 9, CCV_DPM_WINDOW_SIZE / 2 /* this is */);
+		pyr[i] = hog;
+	}
+	hog = 0;
+	ccv_hog(pyr[next], &hog, 0, 9, CCV_DPM_WINDOW_SIZE);
+	pyr[next] = hog;
+	for (i = next + 1; i < scale_upto + next * 2; i++)
+	{
+		hog = 0;
+		ccv_hog(pyr[i], &hog, 0, 9, CCV_DPM_WINDOW_SIZE);
+		ccv_matrix_free(pyr[i]);
+		pyr[i] = hog;
+	}
+}
+
 static uint64_t _ccv_dpm_time_measure()
 {
 	struct timeval tv;
@@ -2042,8 +2060,63 @@ static int _ccv_is_equal_same_class(const void* _r1, const void* _r2, void* data
 		(int)(r2->rect.height * 1.5 + 0.5) >= r1->rect.height;
 }
 
-ccv_array_t* ccv_dpm_detect_objects(ccv_dense_matrix_t* a, ccv_dpm_mixture_model_t** _model, int count, ccv_dpm_param_t params)
+// the rectangles grouped with r have their origins in this bound
+static ccv_rect_t _ccv_equal_bound(const void* _r, void* data)
+{
+	const ccv_root_comp_t* r = (const ccv_root_comp_t*)_r;
+	int distance = (int)(ccv_min(r->rect.width, r->rect.height) * 0.25 + 0.5);
+	return ccv_rect(r->rect.x - distance, r->rect.y - distance, distance * 2 + 1, distance * 2 + 1);
+}
+
+// the rectangles nested in r are in this bound
+static ccv_rect_t _ccv_nested_bound(const void* _r, void* data)
+{
+	const ccv_root_comp_t* r = (const ccv_root_comp_t*)_r;
+	int distance = (int)(ccv_min(r->rect.width, r->rect.height) * 0.25 + 0.5);
+	return ccv_rect(r->rect.x - distance, r->rect.y - distance, r->rect.width + distance * 2, r->rect.height + distance * 2);
+}
+
+static int _ccv_is_nested(const ccv_root_comp_t* r1, const ccv_root_comp_t* r2)
+{
+	int distance = (int)(ccv_min(r2->rect.width, r2->rect.height) * 0.25 + 0.5);
+
+	return r1->classification.id == r2->classification.id &&
+		r1->rect.x >= r2->rect.x - distance &&
+		r1->rect.y >= r2->rect.y - distance &&
+		r1->rect.x + r1->rect.width <= r2->rect.x + r2->rect.width + distance &&
+		r1->rect.y + r1->rect.height <= r2->rect.y + r2->rect.height + distance;
+}
+
+typedef struct {
+	ccv_array_t* seq;
+	int* muted;
+} ccv_dpm_nested_t;
+
+static void _ccv_nested(int i, int j, void* data)
+{
+	ccv_dpm_nested_t* nested = (ccv_dpm_nested_t*)data;
+	const ccv_root_comp_t* r1 = (const ccv_root_comp_t*)ccv_array_get(nested->seq, i);
+	const ccv_root_comp_t* r2 = (const ccv_root_comp_t*)ccv_array_get(nested->seq, j);
+	// if r1 (the smaller one) is better, mute r2, otherwise, mute r1
+	if (_ccv_is_nested(r1, r2))
+	{
+		if (r2->classification.confidence <= r1->classification.confidence && r2->neighbors < r1->neighbors)
+			nested->muted[j] = 1;
+		else
+			nested->muted[i] = 1;
+	}
+	if (_ccv_is_nested(r2, r1))
+	{
+		if (r1->classification.confidence <= r2->classification.confidence && r1->neighbors < r2->neighbors)
+			nested->muted[i] = 1;
+		else
+			nested->muted[j] = 1;
+	}
+}
+
+ccv_array_t* ccv_dpm_detect_objects_in_pyramid(ccv_pyramid_t* pyramid, ccv_dpm_mixture_model_t** _model, int count, ccv_dpm_param_t params)
 {
+	ccv_dense_matrix_t* a = pyramid->image;
 	int c, i, j, k, x, y;
 	double scale = pow(2.0, 1.0 / (params.interval + 1.0));
 	int next = params.interval + 1;
@@ -2051,7 +2124,7 @@ ccv_array_t* ccv_dpm_detect_objects(ccv_dense_matrix_t* a, ccv_dpm_mixture_model
 	if (scale_upto < 0) // image is too small to be interesting
 		return 0;
 	ccv_dense_matrix_t** pyr = (ccv_dense_matrix_t**)alloca((scale_upto + next * 2) * sizeof(ccv_dense_matrix_t*));
-	_ccv_dpm_feature_pyramid(a, pyr, scale_upto, params.interval);
+	_ccv_dpm_feature_pyramid_from(pyramid, pyr, scale_upto, params.interval);
 	ccv_array_t* idx_seq;
 	ccv_array_t* seq = ccv_array_new(sizeof(ccv_root_comp_t), 64, 0);
 	ccv_array_t* seq2 = ccv_array_new(sizeof(ccv_root_comp_t), 64, 0);
@@ -2140,7 +2213,7 @@ ccv_array_t* ccv_dpm_detect_objects(ccv_dense_matrix_t* a, ccv_dpm_mixture_model
 			idx_seq = 0;
 			ccv_array_clear(seq2);
 			// group retrieved rectangles in order to filter out noise
-			int ncomp = ccv_array_group(seq, &idx_seq, _ccv_is_equal_same_class, 0);
+			int ncomp = ccv_array_group_spatially(seq, &idx_seq, _ccv_is_equal_same_class, _ccv_equal_bound, 0);
 			ccv_root_comp_t* comps = (ccv_root_comp_t*)ccmalloc((ncomp + 1) * sizeof(ccv_root_comp_t));
 			memset(comps, 0, (ncomp + 1) * sizeof(ccv_root_comp_t));
 
@@ -2170,66 +2243,23 @@ ccv_array_t* ccv_dpm_detect_objects(ccv_dense_matrix_t* a, ccv_dpm_mixture_model
 					ccv_array_push(seq2, comps + i);
 			}
 
-			// filter out large object rectangles contains small object rectangles
+			// filter out large object rectangles contains small object rectangles, and small object rectangles inside large object rectangles
+			ccv_dpm_nested_t nested = {
+				.seq = seq2,
+				.muted = (int*)cccalloc(seq2->rnum + 1, sizeof(int)),
+			};
+			ccv_array_intersect(seq2, _ccv_nested_bound, _ccv_nested, &nested);
 			for (i = 0; i < seq2->rnum; i++)
-			{
-				ccv_root_comp_t* r2 = (ccv_root_comp_t*)ccv_array_get(seq2, i);
-				int distance = (int)(ccv_min(r2->rect.width, r2->rect.height) * 0.25 + 0.5);
-				for (j = 0; j < seq2->rnum; j++)
-				{
-					ccv_root_comp_t r1 = *(ccv_root_comp_t*)ccv_array_get(seq2, j);
-					if (i != j &&
-						abs(r1.classification.id) == r2->classification.id &&
-						r1.rect.x >= r2->rect.x - distance &&
-						r1.rect.y >= r2->rect.y - distance &&
-						r1.rect.x + r1.rect.width <= r2->rect.x + r2->rect.width + distance &&
-						r1.rect.y + r1.rect.height <= r2->rect.y + r2->rect.height + distance &&
-						// if r1 (the smaller one) is better, mute r2
-						(r2->classification.confidence <= r1.classification.confidence && r2->neighbors < r1.neighbors))
-					{
-						r2->classification.id = -r2->classification.id;
-						break;
-					}
-				}
-			}
-
-			// filter out small object rectangles inside large object rectangles
-			for (i = 0; i < seq2->rnum; i++)
-			{
-				ccv_root_comp_t r1 = *(ccv_root_comp_t*)ccv_array_get(seq2, i);
-				if (r1.classification.id > 0)
-				{
-					int flag = 1;
-
-					for (j = 0; j < seq2->rnum; j++)
-					{
-						ccv_root_comp_t r2 = *(ccv_root_comp_t*)ccv_array_get(seq2, j);
-						int distance = (int)(ccv_min(r2.rect.width, r2.rect.height) * 0.25 + 0.5);
-
-						if (i != j &&
-							r1.classification.id == abs(r2.classification.id) &&
-							r1.rect.x >= r2.rect.x - distance &&
-							r1.rect.y >= r2.rect.y - distance &&
-							r1.rect.x + r1.rect.width <= r2.rect.x + r2.rect.width + distance &&
-							r1.rect.y + r1.rect.height <= r2.rect.y + r2.rect.height + distance &&
-							(r2.classification.confidence > r1.classification.confidence || r2.neighbors >= r1.neighbors))
-						{
-							flag = 0;
-							break;
-						}
-					}
-
-					if (flag)
-						ccv_array_push(result_seq, &r1);
-				}
-			}
+				if (!nested.muted[i])
+					ccv_array_push(result_seq, ccv_array_get(seq2, i));
+			ccfree(nested.muted);
 			ccv_array_free(idx_seq);
 			ccfree(comps);
 		}
 	}
 
 	for (i = 0; i < scale_upto + next * 2; i++)
-		ccv_matrix_free(pyr[i]);
+		ccv_pyramid_release(pyramid, pyr[i]);
 
 	ccv_array_free(seq);
 	ccv_array_free(seq2);
@@ -2241,7 +2271,7 @@ ccv_array_t* ccv_dpm_detect_objects(ccv_dense_matrix_t* a, ccv_dpm_mixture_model
 		result_seq2 = ccv_array_new(sizeof(ccv_root_comp_t), 64, 0);
 		idx_seq = 0;
 		// group retrieved rectangles in order to filter out noise
-		int ncomp = ccv_array_group(result_seq, &idx_seq, _ccv_is_equal, 0);
+		int ncomp = ccv_array_group_spatially(result_seq, &idx_seq, _ccv_is_equal, _ccv_equal_bound, 0);
 		ccv_root_comp_t* comps = (ccv_root_comp_t*)ccmalloc((ncomp + 1) * sizeof(ccv_root_comp_t));
 		memset(comps, 0, (ncomp + 1) * sizeof(ccv_root_comp_t));
 
@@ -2276,6 +2306,14 @@ ccv_array_t* ccv_dpm_detect_objects(ccv_dense_matrix_t* a, ccv_dpm_mixture_model
 	return result_seq2;
 }
 
+ccv_array_t* ccv_dpm_detect_objects(ccv_dense_matrix_t* a, ccv_dpm_mixture_model_t** _model, int count, ccv_dpm_param_t params)
+{
+	ccv_pyramid_t* pyramid = ccv_pyramid_new(a, 0);
+	ccv_array_t* result_seq = ccv_dpm_detect_objects_in_pyramid(pyramid, _model, count, params);
+	ccv_pyramid_free(pyramid);
+	return result_seq;
+}
+
 ccv_dpm_mixture_model_t* ccv_dpm_read_mixture_model(const char* directory)
 {
 	FILE* r = fopen(directory, "r");
@@ -1965,8 +1965,63 @@ static int _ccv_is_equal_same_class(const void* _r1, const void* _r2, void* data
 		(int)(r2->rect.height * 1.5 + 0.5) >= r1->rect.height;
 }
 
-static void _ccv_icf_detect_objects_with_classifier_cascade(ccv_dense_matrix_t* a, ccv_icf_classifier_cascade_t** cascades, int count, ccv_icf_param_t params, ccv_array_t* seq[])
+// the rectangles grouped with r have their origins in this bound
+static ccv_rect_t _ccv_equal_bound(const void* _r, void* data)
 {
+	const ccv_comp_t* r = (const ccv_comp_t*)_r;
+	int distance = (int)(ccv_min(r->rect.width, r->rect.height) * 0.25 + 0.5);
+	return ccv_rect(r->rect.x - distance, r->rect.y - distance, distance * 2 + 1, distance * 2 + 1);
+}
+
+// the rectangles nested in r are in this bound
+static ccv_rect_t _ccv_nested_bound(const void* _r, void* data)
+{
+	const ccv_comp_t* r = (const ccv_comp_t*)_r;
+	int distance = (int)(ccv_min(r->rect.width, r->rect.height) * 0.25 + 0.5);
+	return ccv_rect(r->rect.x - distance, r->rect.y - distance, r->rect.width + distance * 2, r->rect.height + distance * 2);
+}
+
+static int _ccv_is_nested(const ccv_comp_t* r1, const ccv_comp_t* r2)
+{
+	int distance = (int)(ccv_min(r2->rect.width, r2->rect.height) * 0.25 + 0.5);
+
+	return r1->classification.id == r2->classification.id &&
+		r1->rect.x >= r2->rect.x - distance &&
+		r1->rect.y >= r2->rect.y - distance &&
+		r1->rect.x + r1->rect.width <= r2->rect.x + r2->rect.width + distance &&
+		r1->rect.y + r1->rect.height <= r2->rect.y + r2->rect.height + distance;
+}
+
+typedef struct {
+	ccv_array_t* seq;
+	int* muted;
+} ccv_icf_nested_t;
+
+static void _ccv_nested(int i, int j, void* data)
+{
+	ccv_icf_nested_t* nested = (ccv_icf_nested_t*)data;
+	const ccv_comp_t* r1 = (const ccv_comp_t*)ccv_array_get(nested->seq, i);
+	const ccv_comp_t* r2 = (const ccv_comp_t*)ccv_array_get(nested->seq, j);
+	// if r1 (the smaller one) is better, mute r2, otherwise, mute r1
+	if (_ccv_is_nested(r1, r2))
+	{
+		if (r2->classification.confidence <= r1->classification.confidence && r2->neighbors < r1->neighbors)
+			nested->muted[j] = 1;
+		else
+			nested->muted[i] = 1;
+	}
+	if (_ccv_is_nested(r2, r1))
+	{
+		if (r1->classification.confidence <= r2->classification.confidence && r1->neighbors < r2->neighbors)
+			nested->muted[i] = 1;
+		else
+			nested->muted[j] = 1;
+	}
+}
+
+static void _ccv_icf_detect_objects_with_classifier_cascade(ccv_pyramid_t* pyramid, ccv_icf_classifier_cascade_t** cascades, int count, ccv_icf_param_t params, ccv_array_t* seq[])
+{
+	ccv_dense_matrix_t* a = pyramid->image;
 	int i, j, k, q, x, y;
 	int scale_upto = 1;
 	for (i = 0; i < count; i++)
@@ -1974,10 +2029,7 @@ static void _ccv_icf_detect_objects_with_classifier_cascade(ccv_dense_matrix_t*
 	ccv_dense_matrix_t** pyr = (ccv_dense_matrix_t**)alloca(sizeof(ccv_dense_matrix_t*) * scale_upto);
 	pyr[0] = a;
 	for (i = 1; i < scale_upto; i++)
-	{
-		pyr[i] = 0;
-		ccv_sample_down(pyr[i - 1], &pyr[i], 0, 0, 0);
-	}
+		pyr[i] = ccv_pyramid_sample_down(pyramid, pyr[i - 1], 0, 0);
 	for (i = 0; i < scale_upto; i++)
 	{
 		// run it
@@ -1992,21 +2044,13 @@ static void _ccv_icf_detect_objects_with_classifier_cascade(ccv_dense_matrix_t*
 				int cols = (int)(pyr[i]->cols / scale + 0.5);
 				if (rows < cascade->size.height || cols < cascade->size.width)
 					break;
-				ccv_dense_matrix_t* image = k == 0 ? pyr[i] : 0;
+				ccv_dense_matrix_t* image = k == 0 ? pyr[i] : ccv_pyramid_resample(pyramid, pyr[i], rows, cols, CCV_INTER_AREA);
+				ccv_dense_matrix_t* sat = ccv_pyramid_icf(pyramid, image, cascade->margin);
 				if (k > 0)
-					ccv_resample(pyr[i], &image, 0, rows, cols, CCV_INTER_AREA);
-				ccv_dense_matrix_t* bordered = 0;
-				ccv_border(image, (ccv_matrix_t**)&bordered, 0, cascade->margin);
-				if (k > 0)
-					ccv_matrix_free(image);
-				rows = bordered->rows;
-				cols = bordered->cols;
-				ccv_dense_matrix_t* icf = 0;
-				ccv_icf(bordered, &icf, 0);
-				ccv_matrix_free(bordered);
-				ccv_dense_matrix_t* sat = 0;
-				ccv_sat(icf, &sat, 0, CCV_PADDING_ZERO);
-				ccv_matrix_free(icf);
+					ccv_pyramid_release(pyramid, image);
+				// The summed area table is padded with one row and one column of zeros.
+				rows = sat->rows - 1;
+				cols = sat->cols - 1;
 				int ch = CCV_GET_CHANNEL(sat->type);
 				float* ptr = sat->data.f32;
 				for (y = 0; y < rows; y += params.step_through)
@@ -2042,18 +2086,17 @@ static void _ccv_icf_detect_objects_with_classifier_cascade(ccv_dense_matrix_t*
 					}
 					ptr += sat->cols * ch * params.step_through;
 				}
-				ccv_matrix_free(sat);
+				ccv_pyramid_release(pyramid, sat);
 				scale *= scale_ratio;
 			}
 		}
+		ccv_pyramid_release(pyramid, pyr[i]);
 	}
-
-	for (i = 1; i < scale_upto; i++)
-		ccv_matrix_free(pyr[i]);
 }
 
-static void _ccv_icf_detect_objects_with_multiscale_classifier_cascade(ccv_dense_matrix_t* a, ccv_icf_multiscale_classifier_cascade_t** multiscale_cascade, int count, ccv_icf_param_t params, ccv_array_t* seq[])
+static void _ccv_icf_detect_objects_with_multiscale_classifier_cascade(ccv_pyramid_t* pyramid, ccv_icf_multiscale_classifier_cascade_t** multiscale_cascade, int count, ccv_icf_param_t params, ccv_array_t* seq[])
 {
+	ccv_dense_matrix_t* a = pyramid->image;
 	int i, j, k, q, x, y, ix, iy, py;
 	assert(multiscale_cascade[0]->count % multiscale_cascade[0]->octave == 0);
 	ccv_margin_t margin = multiscale_cascade[0]->cascade[multiscale_cascade[0]->count - 1].margin;
@@ -2075,20 +2118,10 @@ static void _ccv_icf_detect_objects_with_multiscale_classifier_cascade(ccv_dense
 	ccv_dense_matrix_t** pyr = (ccv_dense_matrix_t**)alloca(sizeof(ccv_dense_matrix_t*) * scale_upto);
 	pyr[0] = a;
 	for (i = 1; i < scale_upto; i++)
-	{
-		pyr[i] = 0;
-		ccv_sample_down(pyr[i - 1], &pyr[i], 0, 0, 0);
-	}
+		pyr[i] = ccv_pyramid_sample_down(pyramid, pyr[i - 1], 0, 0);
 	for (i = 0; i < scale_upto; i++)
 	{
-		ccv_dense_matrix_t* bordered = 0;
-		ccv_border(pyr[i], (ccv_matrix_t**)&bordered, 0, margin);
-		ccv_dense_matrix_t* icf = 0;
-		ccv_icf(bordered, &icf, 0);
-		ccv_matrix_free(bordered);
-		ccv_dense_matrix_t* sat = 0;
-		ccv_sat(icf, &sat, 0, CCV_PADDING_ZERO);
-		ccv_matrix_free(icf);
+		ccv_dense_matrix_t* sat = ccv_pyramid_icf(pyramid, pyr[i], margin);
 		int ch = CCV_GET_CHANNEL(sat->type);
 		assert(CCV_GET_DATA_TYPE(sat->type) == CCV_32F);
 		// run it
@@ -2151,17 +2184,15 @@ static void _ccv_icf_detect_objects_with_multiscale_classifier_cascade(ccv_dense
 				scale *= scale_ratio;
 			}
 		}
-		ccv_matrix_free(sat);
+		ccv_pyramid_release(pyramid, sat);
+		ccv_pyramid_release(pyramid, pyr[i]);
 	}
-
-	for (i = 1; i < scale_upto; i++)
-		ccv_matrix_free(pyr[i]);
 }
 
-ccv_array_t* ccv_icf_detect_objects(ccv_dense_matrix_t* a, void* cascade, int count, ccv_icf_param_t params)
+ccv_array_t* ccv_icf_detect_objects_in_pyramid(ccv_pyramid_t* pyramid, void* cascade, int count, ccv_icf_param_t params)
 {
 	assert(count > 0);
-	int i, j, k;
+	int i, k;
 	int type = *(((int**)cascade)[0]);
 	for (i = 1; i < count; i++)
 	{
@@ -2174,10 +2205,10 @@ ccv_array_t* ccv_icf_detect_objects(ccv_dense_matrix_t* a, void* cascade, int co
 	switch (type)
 	{
 		case CCV_ICF_CLASSIFIER_TYPE_A:
-			_ccv_icf_detect_objects_with_classifier_cascade(a, (ccv_icf_classifier_cascade_t**)cascade, count, params, seq);
+			_ccv_icf_detect_objects_with_classifier_cascade(pyramid, (ccv_icf_classifier_cascade_t**)cascade, count, params, seq);
 			break;
 		case CCV_ICF_CLASSIFIER_TYPE_B:
-			_ccv_icf_detect_objects_with_multiscale_classifier_cascade(a, (ccv_icf_multiscale_classifier_cascade_t**)cascade, count, params, seq);
+			_ccv_icf_detect_objects_with_multiscale_classifier_cascade(pyramid, (ccv_icf_multiscale_classifier_cascade_t**)cascade, count, params, seq);
 			break;
 	}
 	ccv_array_t* result_seq = ccv_array_new(sizeof(ccv_comp_t), 64, 0);
@@ -2196,7 +2227,7 @@ ccv_array_t* ccv_icf_detect_objects(ccv_dense_matrix_t* a, void* cascade, int co
 			ccv_array_t* idx_seq = 0;
 			ccv_array_clear(seq2);
 			// group retrieved rectangles in order to filter out noise
-			int ncomp = ccv_array_group(seq[k], &idx_seq, _ccv_is_equal_same_class, 0);
+			int ncomp = ccv_array_group_spatially(seq[k], &idx_seq, _ccv_is_equal_same_class, _ccv_equal_bound, 0);
 			ccv_comp_t* comps = (ccv_comp_t*)cccalloc(ncomp + 1, sizeof(ccv_comp_t));
 
 			// count number of neighbors
@@ -2223,60 +2254,16 @@ ccv_array_t* ccv_icf_detect_objects(ccv_dense_matrix_t* a, void* cascade, int co
 					ccv_array_push(seq2, comps + i);
 			}
 
-			// filter out large object rectangles contains small object rectangles
-			for (i = 0; i < seq2->rnum; i++)
-			{
-				ccv_comp_t* r2 = (ccv_comp_t*)ccv_array_get(seq2, i);
-				int distance = (int)(ccv_min(r2->rect.width, r2->rect.height) * 0.25 + 0.5);
-				for (j = 0; j < seq2->rnum; j++)
-				{
-					ccv_comp_t r1 = *(ccv_comp_t*)ccv_array_get(seq2, j);
-					if (i != j &&
-						abs(r1.classification.id) == r2->classification.id &&
-						r1.rect.x >= r2->rect.x - distance &&
-						r1.rect.y >= r2->rect.y - distance &&
-						r1.rect.x + r1.rect.width <= r2->rect.x + r2->rect.width + distance &&
-						r1.rect.y + r1.rect.height <= r2->rect.y + r2->rect.height + distance &&
-						// if r1 (the smaller one) is better, mute r2
-						(r2->classification.confidence <= r1.classification.confidence && r2->neighbors < r1.neighbors))
-					{
-						r2->classification.id = -r2->classification.id;
-						break;
-					}
-				}
-			}
-
-			// filter out small object rectangles inside large object rectangles
+			// filter out large object rectangles contains small object rectangles, and small object rectangles inside large object rectangles
+			ccv_icf_nested_t nested = {
+				.seq = seq2,
+				.muted = (int*)cccalloc(seq2->rnum + 1, sizeof(int)),
+			};
+			ccv_array_intersect(seq2, _ccv_nested_bound, _ccv_nested, &nested);
 			for (i = 0; i < seq2->rnum; i++)
-			{
-				ccv_comp_t r1 = *(ccv_comp_t*)ccv_array_get(seq2, i);
-				if (r1.classification.id > 0)
-				{
-					int flag = 1;
-
-					for (j = 0; j < seq2->rnum; j++)
-					{
-						ccv_comp_t r2 = *(ccv_comp_t*)ccv_array_get(seq2, j);
-						int distance = (int)(ccv_min(r2.rect.width, r2.rect.height) * 0.25 + 0.5);
-
-						if (i != j &&
-							abs(r1.classification.id) == abs(r2.classification.id) &&
-							r1.rect.x >= r2.rect.x - distance &&
-							r1.rect.y >= r2.rect.y - distance &&
-							r1.rect.x + r1.rect.width <= r2.rect.x + r2.rect.width + distance &&
-							r1.rect.y + r1.rect.height <= r2.rect.y + r2.rect.height + distance &&
-							// if r2 is better, we mute r1
-							(r2.classification.confidence > r1.classification.confidence || r2.neighbors >= r1.neighbors))
-						{
-							flag = 0;
-							break;
-						}
-					}
-
-					if (flag)
-						ccv_array_push(result_seq, &r1);
-				}
-			}
+				if (!nested.muted[i])
+					ccv_array_push(result_seq, ccv_array_get(seq2, i));
+			ccfree(nested.muted);
 			ccv_array_free(idx_seq);
 			ccfree(comps);
 		}
@@ -2286,3 +2273,11 @@ ccv_array_t* ccv_icf_detect_objects(ccv_dense_matrix_t* a, void* cascade, int co
 
 	return result_seq;
 }
+
+ccv_array_t* ccv_icf_detect_objects(ccv_dense_matrix_t* a, void* cascade, int count, ccv_icf_param_t params)
+{
+	ccv_pyramid_t* pyramid = ccv_pyramid_new(a, 0);
+	ccv_array_t* result_seq = ccv_icf_detect_objects_in_pyramid(pyramid, cascade, count, params);
+	ccv_pyramid_free(pyramid);
+	return result_seq;
+}
@@ -650,4 +650,10 @@ T func_name(T* buf, int low, int high) \
 	}                                                \
 }
 
+/* the FFT plans and kernel spectra kept by ccv_filter on this thread, drained / closed along with the ccv cache */
+void ccv_filter_drain_cache(void);
+void ccv_filter_close_cache(void);
+/* move the age counter of the process-wide cache, thus, its rebase can be reached without 2^27 puts */
+void ccv_global_cache_set_age(uint32_t age);
+
 #endif
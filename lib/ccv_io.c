@@ -1,5 +1,17 @@
 #include "ccv.h"
 #include "ccv_internal.h"
+
+static void _ccv_read_fit_size(int rows, int cols, int max_rows, int max_cols, int* fit_rows, int* fit_cols)
+{
+	double scale = 1;
+	if (max_rows > 0 && rows > max_rows)
+		scale = (double)max_rows / rows;
+	if (max_cols > 0 && cols * scale > max_cols)
+		scale = (double)max_cols / cols;
+	*fit_rows = ccv_max(1, ccv_min(rows, (int)(rows * scale + 0.5)));
+	*fit_cols = ccv_max(1, ccv_min(cols, (int)(cols * scale + 0.5)));
+}
+
 #ifdef HAVE_LIBPNG
 #ifdef __APPLE__
 #include "TargetConditionals.h"
@@ -30,7 +42,7 @@
 #include "io/_ccv_io_binary.inc"
 #include "io/_ccv_io_raw.inc"
 
-static int _ccv_read_and_close_fd(FILE* fd, ccv_dense_matrix_t** x, int type)
+static int _ccv_read_and_close_fd(FILE* fd, ccv_dense_matrix_t** x, int type, int max_rows, int max_cols)
 {
 	int ctype = (type & 0xF00) ? CCV_8U | ((type & 0xF00) >> 8) : 0;
 	if ((type & 0XFF) == CCV_IO_ANY_FILE)
@@ -51,7 +63,7 @@ static int _ccv_read_and_close_fd(FILE* fd, ccv_dense_matrix_t** x, int type)
 	{
 #ifdef HAVE_LIBJPEG
 		case CCV_IO_JPEG_FILE:
-			_ccv_read_jpeg_fd(fd, x, ctype);
+			_ccv_read_jpeg_fd(fd, x, ctype, max_rows, max_cols);
 			break;
 #endif
 #ifdef HAVE_LIBPNG
@@ -65,6 +77,19 @@ static int _ccv_read_and_close_fd(FILE* fd, ccv_dense_matrix_t** x, int type)
 		case CCV_IO_BINARY_FILE:
 			_ccv_read_binary_fd(fd, x, ctype);
 	}
+	if (*x != 0 && (max_rows > 0 || max_cols > 0))
+	{
+		// whatever the decoder cannot scale down natively is area resampled
+		int rows, cols;
+		_ccv_read_fit_size((*x)->rows, (*x)->cols, max_rows, max_cols, &rows, &cols);
+		if (rows < (*x)->rows || cols < (*x)->cols)
+		{
+			ccv_dense_matrix_t* im = *x;
+			*x = 0;
+			ccv_resample(im, x, 0, rows, cols, CCV_INTER_AREA);
+			ccv_matrix_free(im);
+		}
+	}
 	if (*x != 0)
 		ccv_make_matrix_immutable(*x);
 	if (type & CCV_IO_ANY_FILE)
@@ -172,26 +197,26 @@ static fpos_t seekfn(void* context, fpos_t off, int whence)
 }
 #endif
 
-int ccv_read_impl(const void* in, ccv_dense_matrix_t** x, int type, int rows, int cols, int scanline)
+static int _ccv_read_encoded(const void* in, ccv_dense_matrix_t** x, int type, int size, int max_rows, int max_cols)
 {
 	FILE* fd = 0;
 	if (type & CCV_IO_ANY_FILE)
 	{
-		assert(rows == 0 && cols == 0 && scanline == 0);
+		assert(size == 0);
 		fd = fopen((const char*)in, "rb");
 		if (!fd)
 			return CCV_IO_ERROR;
-		return _ccv_read_and_close_fd(fd, x, type);
+		return _ccv_read_and_close_fd(fd, x, type, max_rows, max_cols);
 	} else if (type & CCV_IO_ANY_STREAM) {
-		assert(rows > 8 && cols == 0 && scanline == 0);
+		assert(size > 8);
 		assert((type & 0xFF) != CCV_IO_DEFLATE_STREAM); // deflate stream (compressed stream) is not supported yet
 #if _XOPEN_SOURCE >= 700 || _POSIX_C_SOURCE >= 200809L || defined(__APPLE__) || defined(BSD)
 		// this is only supported by glibc
 #if _XOPEN_SOURCE >= 700 || _POSIX_C_SOURCE >= 200809L
-		fd = fmemopen((void*)in, (size_t)rows, "rb");
+		fd = fmemopen((void*)in, (size_t)size, "rb");
 #else
 		ccv_io_mem_t mem = {
-			.size = rows,
+			.size = size,
 			.pos = 0,
 			.buffer = (char*)in,
 		};
@@ -201,14 +226,33 @@ int ccv_read_impl(const void* in, ccv_dense_matrix_t** x, int type, int rows, in
 			return CCV_IO_ERROR;
 		// mimicking itself as a "file"
 		type = (type & ~0x10) | 0x20;
-		return _ccv_read_and_close_fd(fd, x, type);
+		return _ccv_read_and_close_fd(fd, x, type, max_rows, max_cols);
 #endif
+	}
+	return CCV_IO_UNKNOWN;
+}
+
+int ccv_read_impl(const void* in, ccv_dense_matrix_t** x, int type, int rows, int cols, int scanline)
+{
+	if (type & CCV_IO_ANY_FILE)
+	{
+		assert(rows == 0 && cols == 0 && scanline == 0);
+		return _ccv_read_encoded(in, x, type, 0, 0, 0);
+	} else if (type & CCV_IO_ANY_STREAM) {
+		assert(rows > 8 && cols == 0 && scanline == 0);
+		return _ccv_read_encoded(in, x, type, rows, 0, 0);
 	} else if (type & CCV_IO_ANY_RAW) {
 		return _ccv_read_raw(x, (void*)in /* it can be modifiable if it is NO_COPY mode */, type, rows, cols, scanline);
 	}
 	return CCV_IO_UNKNOWN;
 }
 
+int ccv_read_fit(const void* in, ccv_dense_matrix_t** x, int type, int size, int max_rows, int max_cols)
+{
+	assert(type & (CCV_IO_ANY_FILE | CCV_IO_ANY_STREAM));
+	return _ccv_read_encoded(in, x, type, size, max_rows, max_cols);
+}
+
 int ccv_write(ccv_dense_matrix_t* mat, char* out, int* len, int type, void* conf)
 {
 	FILE* fd = 0;
@@ -1,6 +1,7 @@
 #include "ccv.h"
 #include "ccv_internal.h"
 #include "3rdparty/siphash/siphash24.h"
+#include <pthread.h>
 
 static __thread ccv_cache_t ccv_cache;
 
@@ -13,13 +14,128 @@ static __thread ccv_cache_t ccv_cache;
 /* option to enable/disable cache */
 static __thread int ccv_cache_opt = 0;
 
+/**
+ * The process-wide cache is sharded by the top bits of the signature. All shards
+ * take their age from one counter, thus, the least recently used object across
+ * shards can be found by comparing the age of each shard.
+ **/
+#define CCV_GLOBAL_CACHE_SHARDS (16)
+/* an object only has 28 bits for its age, the shards are rebased together well before the counter gets there,
+ * and before the shards would rebase themselves */
+#define CCV_GLOBAL_CACHE_AGE_REBASE (0x08000000)
+
+typedef struct {
+	pthread_mutex_t mutex;
+	ccv_cache_t cache;
+} ccv_cache_shard_t;
+
+static ccv_cache_shard_t ccv_global_cache[CCV_GLOBAL_CACHE_SHARDS];
+static int ccv_global_cache_opt = 0;
+static size_t ccv_global_cache_up = 0;
+static size_t ccv_global_cache_size = 0; // updated with atomic operations
+static uint32_t ccv_global_cache_age = 0; // updated with atomic operations
+
+static inline ccv_cache_shard_t* _ccv_global_cache_shard(uint64_t sig)
+{
+	return ccv_global_cache + (sig >> 60) % CCV_GLOBAL_CACHE_SHARDS;
+}
+
+static void _ccv_global_cache_resize(size_t old_size, size_t new_size)
+{
+	if (new_size > old_size)
+		__sync_fetch_and_add(&ccv_global_cache_size, new_size - old_size);
+	else if (new_size < old_size)
+		__sync_fetch_and_sub(&ccv_global_cache_size, old_size - new_size);
+}
+
+static void* _ccv_global_cache_out(uint64_t sig, uint8_t* type)
+{
+	ccv_cache_shard_t* shard = _ccv_global_cache_shard(sig);
+	pthread_mutex_lock(&shard->mutex);
+	size_t old_size = shard->cache.size;
+	void* x = ccv_cache_out(&shard->cache, sig, type);
+	_ccv_global_cache_resize(old_size, shard->cache.size);
+	pthread_mutex_unlock(&shard->mutex);
+	return x;
+}
+
+static void _ccv_global_cache_evict(void)
+{
+	int i;
+	while (ccv_global_cache_size > ccv_global_cache_up)
+	{
+		// find the shard with the least recently used object, only one lock is held at a time
+		ccv_cache_shard_t* lru = 0;
+		uint32_t lru_age = 0;
+		for (i = 0; i < CCV_GLOBAL_CACHE_SHARDS; i++)
+		{
+			pthread_mutex_lock(&ccv_global_cache[i].mutex);
+			uint32_t age = ccv_cache_lru_age(&ccv_global_cache[i].cache);
+			pthread_mutex_unlock(&ccv_global_cache[i].mutex);
+			if (age > 0 && (!lru || age < lru_age))
+				lru = ccv_global_cache + i, lru_age = age;
+		}
+		if (!lru)
+			break;
+		pthread_mutex_lock(&lru->mutex);
+		size_t old_size = lru->cache.size;
+		// it may have changed in between, in that case, just look again
+		if (ccv_cache_lru_age(&lru->cache) == lru_age)
+			ccv_cache_evict(&lru->cache);
+		_ccv_global_cache_resize(old_size, lru->cache.size);
+		pthread_mutex_unlock(&lru->mutex);
+	}
+}
+
+static void _ccv_global_cache_rebase(void)
+{
+	int i;
+	// the only place that holds more than one shard lock, and it always takes them in order
+	for (i = 0; i < CCV_GLOBAL_CACHE_SHARDS; i++)
+		pthread_mutex_lock(&ccv_global_cache[i].mutex);
+	// the counter only moves with a shard lock held, and another thread may have rebased it already
+	uint32_t age = ccv_global_cache_age;
+	if (age >= CCV_GLOBAL_CACHE_AGE_REBASE)
+	{
+		uint32_t lru_age = 0;
+		for (i = 0; i < CCV_GLOBAL_CACHE_SHARDS; i++)
+		{
+			uint32_t shard_age = ccv_cache_lru_age(&ccv_global_cache[i].cache);
+			if (shard_age > 0 && (lru_age == 0 || shard_age < lru_age))
+				lru_age = shard_age;
+		}
+		// keep the order of the younger half, or of all of them if they are young enough
+		uint32_t shift = ccv_max(lru_age > 0 ? lru_age - 1 : 0, age / 2);
+		for (i = 0; i < CCV_GLOBAL_CACHE_SHARDS; i++)
+			ccv_cache_rebase_age(&ccv_global_cache[i].cache, shift);
+		__sync_fetch_and_sub(&ccv_global_cache_age, shift);
+	}
+	for (i = CCV_GLOBAL_CACHE_SHARDS - 1; i >= 0; i--)
+		pthread_mutex_unlock(&ccv_global_cache[i].mutex);
+}
+
+static int _ccv_global_cache_put(uint64_t sig, void* x, uint32_t size, uint8_t type)
+{
+	if (ccv_global_cache_age >= CCV_GLOBAL_CACHE_AGE_REBASE)
+		_ccv_global_cache_rebase();
+	ccv_cache_shard_t* shard = _ccv_global_cache_shard(sig);
+	pthread_mutex_lock(&shard->mutex);
+	size_t old_size = shard->cache.size;
+	shard->cache.age = __sync_fetch_and_add(&ccv_global_cache_age, 1);
+	int result = ccv_cache_put(&shard->cache, sig, x, size, type);
+	_ccv_global_cache_resize(old_size, shard->cache.size);
+	pthread_mutex_unlock(&shard->mutex);
+	_ccv_global_cache_evict();
+	return result;
+}
+
 ccv_dense_matrix_t* ccv_dense_matrix_new(int rows, int cols, int type, void* data, uint64_t sig)
 {
 	ccv_dense_matrix_t* mat;
-	if (ccv_cache_opt && sig != 0 && !data && !(type & CCV_NO_DATA_ALLOC))
+	if ((ccv_global_cache_opt || ccv_cache_opt) && sig != 0 && !data && !(type & CCV_NO_DATA_ALLOC))
 	{
 		uint8_t type;
-		mat = (ccv_dense_matrix_t*)ccv_cache_out(&ccv_cache, sig, &type);
+		mat = (ccv_dense_matrix_t*)(ccv_global_cache_opt ? _ccv_global_cache_out(sig, &type) : ccv_cache_out(&ccv_cache, sig, &type));
 		if (mat)
 		{
 			assert(type == 0);
@@ -169,7 +285,7 @@ void ccv_matrix_free(ccv_matrix_t* mat)
 	{
 		ccv_dense_matrix_t* dmt = (ccv_dense_matrix_t*)mat;
 		dmt->refcount = 0;
-		if (!ccv_cache_opt || // e don't enable cache
+		if ((!ccv_global_cache_opt && !ccv_cache_opt) || // e don't enable cache
 			!(dmt->type & CCV_REUSABLE) || // or this is not a reusable piece
 			dmt->sig == 0 || // or this doesn't have valid signature
 			(dmt->type & CCV_NO_DATA_ALLOC)) // or this matrix is allocated as header-only, therefore we cannot cache it
@@ -181,7 +297,12 @@ void ccv_matrix_free(ccv_matrix_t* mat)
 				   CCV_GET_DATA_TYPE(dmt->type) == CCV_64S ||
 				   CCV_GET_DATA_TYPE(dmt->type) == CCV_64F);
 			size_t size = ccv_compute_dense_matrix_size(dmt->rows, dmt->cols, dmt->type);
-			ccv_cache_put(&ccv_cache, dmt->sig, dmt, size, 0 /* type 0 */);
+			if (ccv_global_cache_opt)
+			{
+				if (_ccv_global_cache_put(dmt->sig, dmt, size, 0 /* type 0 */) < 0)
+					ccfree(dmt);
+			} else if (ccv_cache_put(&ccv_cache, dmt->sig, dmt, size, 0 /* type 0 */) < 0)
+				ccfree(dmt); // it is larger than the cache can hold
 		}
 	} else if (type & CCV_MATRIX_SPARSE) {
 		ccv_sparse_matrix_t* smt = (ccv_sparse_matrix_t*)mat;
@@ -204,10 +325,10 @@ void ccv_matrix_free(ccv_matrix_t* mat)
 ccv_array_t* ccv_array_new(int rsize, int rnum, uint64_t sig)
 {
 	ccv_array_t* array;
-	if (ccv_cache_opt && sig != 0)
+	if ((ccv_global_cache_opt || ccv_cache_opt) && sig != 0)
 	{
 		uint8_t type;
-		array = (ccv_array_t*)ccv_cache_out(&ccv_cache, sig, &type);
+		array = (ccv_array_t*)(ccv_global_cache_opt ? _ccv_global_cache_out(sig, &type) : ccv_cache_out(&ccv_cache, sig, &type));
 		if (array)
 		{
 			assert(type == 1);
@@ -249,14 +370,19 @@ void ccv_array_free_immediately(ccv_array_t* array)
 
 void ccv_array_free(ccv_array_t* array)
 {
-	if (!ccv_cache_opt || !(array->type & CCV_REUSABLE) || array->sig == 0)
+	if ((!ccv_global_cache_opt && !ccv_cache_opt) || !(array->type & CCV_REUSABLE) || array->sig == 0)
 	{
 		array->refcount = 0;
 		ccfree(array->data);
 		ccfree(array);
 	} else {
 		size_t size = sizeof(ccv_array_t) + array->size * array->rsize;
-		ccv_cache_put(&ccv_cache, array->sig, array, size, 1 /* type 1 */);
+		if (ccv_global_cache_opt)
+		{
+			if (_ccv_global_cache_put(array->sig, array, size, 1 /* type 1 */) < 0)
+				ccv_array_free_immediately(array);
+		} else if (ccv_cache_put(&ccv_cache, array->sig, array, size, 1 /* type 1 */) < 0)
+			ccv_array_free_immediately(array); // it is larger than the cache can hold
 	}
 }
 
@@ -264,12 +390,46 @@ void ccv_drain_cache(void)
 {
 	if (ccv_cache.rnum > 0)
 		ccv_cache_cleanup(&ccv_cache);
+	ccv_filter_drain_cache();
+	if (ccv_global_cache_opt)
+	{
+		int i;
+		for (i = 0; i < CCV_GLOBAL_CACHE_SHARDS; i++)
+		{
+			pthread_mutex_lock(&ccv_global_cache[i].mutex);
+			size_t old_size = ccv_global_cache[i].cache.size;
+			ccv_cache_cleanup(&ccv_global_cache[i].cache);
+			_ccv_global_cache_resize(old_size, 0);
+			pthread_mutex_unlock(&ccv_global_cache[i].mutex);
+		}
+	}
+}
+
+static void _ccv_disable_global_cache(void)
+{
+	if (!ccv_global_cache_opt)
+		return;
+	ccv_global_cache_opt = 0;
+	int i;
+	for (i = 0; i < CCV_GLOBAL_CACHE_SHARDS; i++)
+	{
+		ccv_cache_close(&ccv_global_cache[i].cache);
+		pthread_mutex_destroy(&ccv_global_cache[i].mutex);
+	}
+	ccv_global_cache_size = 0;
 }
 
 void ccv_disable_cache(void)
 {
 	ccv_cache_opt = 0;
 	ccv_cache_close(&ccv_cache);
+	ccv_filter_close_cache();
+	_ccv_disable_global_cache();
+}
+
+void ccv_global_cache_set_age(uint32_t age)
+{
+	ccv_global_cache_age = age;
 }
 
 void ccv_enable_cache(size_t size)
@@ -278,6 +438,49 @@ void ccv_enable_cache(size_t size)
 	ccv_cache_init(&ccv_cache, size, 2, ccv_matrix_free_immediately, ccv_array_free_immediately);
 }
 
+void ccv_enable_global_cache(size_t size)
+{
+	_ccv_disable_global_cache();
+	int i;
+	for (i = 0; i < CCV_GLOBAL_CACHE_SHARDS; i++)
+	{
+		pthread_mutex_init(&ccv_global_cache[i].mutex, 0);
+		// every shard can grow up to the whole budget, the budget is kept across shards on put
+		ccv_cache_init(&ccv_global_cache[i].cache, size, 2, ccv_matrix_free_immediately, ccv_array_free_immediately);
+	}
+	ccv_global_cache_up = size;
+	ccv_global_cache_size = 0;
+	ccv_global_cache_opt = 1;
+}
+
+void ccv_get_cache_stat(ccv_cache_stat_t* stat)
+{
+	if (!ccv_global_cache_opt)
+	{
+		ccv_cache_get_stat(&ccv_cache, stat);
+		return;
+	}
+	memset(stat, 0, sizeof(ccv_cache_stat_t));
+	int i, j;
+	for (i = 0; i < CCV_GLOBAL_CACHE_SHARDS; i++)
+	{
+		ccv_cache_stat_t shard_stat;
+		pthread_mutex_lock(&ccv_global_cache[i].mutex);
+		ccv_cache_get_stat(&ccv_global_cache[i].cache, &shard_stat);
+		pthread_mutex_unlock(&ccv_global_cache[i].mutex);
+		stat->miss += shard_stat.miss;
+		for (j = 0; j < 16; j++)
+		{
+			stat->type[j].hit += shard_stat.type[j].hit;
+			stat->type[j].put += shard_stat.type[j].put;
+			stat->type[j].eviction += shard_stat.type[j].eviction;
+			stat->type[j].evicted_size += shard_stat.type[j].evicted_size;
+			stat->type[j].rnum += shard_stat.type[j].rnum;
+			stat->type[j].size += shard_stat.type[j].size;
+		}
+	}
+}
+
 void ccv_enable_default_cache(void)
 {
 	ccv_enable_cache(CCV_DEFAULT_CACHE_SIZE);
@@ -1,8 +1,8 @@
 #include "ccv.h"
 #include "ccv_internal.h"
 #include <complex.h>
-#ifdef HAVE_FFTW3
 #include <pthread.h>
+#ifdef HAVE_FFTW3
 #include <fftw3.h>
 #else
 #include "3rdparty/kissfft/kiss_fftndr.h"
@@ -381,6 +381,83 @@ void ccv_minimize(ccv_dense_matrix_t* x, int length, double red, ccv_minimize_f
 	ccv_matrix_free(df3);
 }
 
+/* FFT plans (cache type 0) and kernel spectra (cache type 1) are kept in a per-thread cache, much like
+ * how ccv_memory recycles matrices. DPM filters every pyramid level of every image with the same root /
+ * part weights, there is no need to plan or to transform these weights again and again. The cache is
+ * drained with ccv_drain_cache, closed with ccv_disable_cache, and closed when the thread exits. */
+#define CCV_FILTER_FFT_CACHE_SIZE (16 * 1024 * 1024)
+
+static __thread ccv_cache_t* ccv_filter_fft_cache = 0;
+static pthread_key_t ccv_filter_fft_cache_key;
+static pthread_once_t ccv_filter_fft_cache_key_once = PTHREAD_ONCE_INIT;
+
+static void _ccv_filter_fft_plan_free(void* plan);
+static void _ccv_filter_fft_spectrum_free(void* spectrum);
+
+static void _ccv_filter_fft_cache_free(void* cache)
+{
+	ccv_cache_close((ccv_cache_t*)cache);
+	ccfree(cache);
+}
+
+static void _ccv_filter_fft_cache_key_new(void)
+{
+	pthread_key_create(&ccv_filter_fft_cache_key, _ccv_filter_fft_cache_free);
+}
+
+void ccv_filter_drain_cache(void)
+{
+	if (ccv_filter_fft_cache && ccv_filter_fft_cache->rnum > 0)
+		ccv_cache_cleanup(ccv_filter_fft_cache);
+}
+
+void ccv_filter_close_cache(void)
+{
+	if (!ccv_filter_fft_cache)
+		return;
+	pthread_setspecific(ccv_filter_fft_cache_key, 0);
+	_ccv_filter_fft_cache_free(ccv_filter_fft_cache);
+	ccv_filter_fft_cache = 0;
+}
+
+static uint64_t _ccv_filter_fft_sign(int cache_type, int rows, int cols, int ch, int fft_type, uint64_t sig)
+{
+	int key[] = {
+		cache_type, rows, cols, ch, fft_type
+	};
+	return ccv_cache_generate_signature((const char*)key, sizeof(key), sig, CCV_EOF_SIGN);
+}
+
+// the object is taken out of the cache while in use, thus, it cannot be evicted under our feet
+static void* _ccv_filter_fft_cache_out(uint64_t sign, uint8_t cache_type)
+{
+	if (!ccv_filter_fft_cache)
+	{
+		pthread_once(&ccv_filter_fft_cache_key_once, _ccv_filter_fft_cache_key_new);
+		ccv_filter_fft_cache = (ccv_cache_t*)ccmalloc(sizeof(ccv_cache_t));
+		ccv_cache_init(ccv_filter_fft_cache, CCV_FILTER_FFT_CACHE_SIZE, 2, _ccv_filter_fft_plan_free, _ccv_filter_fft_spectrum_free);
+		// the thread may exit without draining, the destructor closes the cache then
+		pthread_setspecific(ccv_filter_fft_cache_key, ccv_filter_fft_cache);
+	}
+	uint8_t type;
+	void* x = ccv_cache_out(ccv_filter_fft_cache, sign, &type);
+	assert(!x || type == cache_type);
+	return x;
+}
+
+static void _ccv_filter_fft_cache_put(uint64_t sign, void* x, uint32_t size, uint8_t cache_type, uint64_t cost)
+{
+	if (ccv_cache_put_with_cost(ccv_filter_fft_cache, sign, x, size, cache_type, cost) < 0)
+		ccv_filter_fft_cache->ffree[cache_type](x);
+}
+
+// a kernel spectrum costs a forward FFT to compute again, which passes over it about log2(rows * cols) times,
+// whereas a plan is cheap enough to make again that it can go by age alone
+static uint64_t _ccv_filter_fft_spectrum_cost(int rows, int cols, uint32_t size)
+{
+	return (uint64_t)size * (uint64_t)ceil(log2((double)rows * cols));
+}
+
 #ifdef HAVE_FFTW3
 /* optimal FFT size table is adopted from OpenCV */
 static const int _ccv_optimal_fft_size[] = {
@@ -582,52 +659,85 @@ static int _ccv_get_optimal_fft_size(int size)
 
 static pthread_mutex_t fftw_plan_mutex = PTHREAD_MUTEX_INITIALIZER;
 
-static void _ccv_filter_fftw(ccv_dense_matrix_t* a, ccv_dense_matrix_t* b, ccv_dense_matrix_t* d, int padding_pattern)
+typedef struct {
+	int fft_type;
+	int ch;
+	void* p; // fftw_plan or fftwf_plan, r2c for all channels
+	void* pinv; // c2r for all channels
+	void* pinv_sum; // c2r for one channel, channels are summed up before it
+} ccv_filter_fft_plan_t;
+
+static void _ccv_filter_fft_plan_free(void* x)
 {
-	int ch = CCV_GET_CHANNEL(a->type);
-	int fft_type = (CCV_GET_DATA_TYPE(d->type) == CCV_8U || CCV_GET_DATA_TYPE(d->type) == CCV_32F) ? CCV_32F : CCV_64F;
-	int rows = ccv_min(a->rows + b->rows - 1, _ccv_get_optimal_fft_size(b->rows * 3));
-	int cols = ccv_min(a->cols + b->cols - 1, _ccv_get_optimal_fft_size(b->cols * 3));
-	int cols_2c = 2 * (cols / 2 + 1);
-	void* fftw_a;
-	void* fftw_b;
-	void* fftw_d;
-	fftw_plan p, pinv;
-	fftwf_plan pf, pinvf;
+	ccv_filter_fft_plan_t* plan = (ccv_filter_fft_plan_t*)x;
+	pthread_mutex_lock(&fftw_plan_mutex);
+	if (plan->fft_type == CCV_32F)
+	{
+		fftwf_destroy_plan((fftwf_plan)plan->p);
+		fftwf_destroy_plan((fftwf_plan)plan->pinv);
+		if (plan->ch > 1)
+			fftwf_destroy_plan((fftwf_plan)plan->pinv_sum);
+	} else {
+		fftw_destroy_plan((fftw_plan)plan->p);
+		fftw_destroy_plan((fftw_plan)plan->pinv);
+		if (plan->ch > 1)
+			fftw_destroy_plan((fftw_plan)plan->pinv_sum);
+	}
+	pthread_mutex_unlock(&fftw_plan_mutex);
+	ccfree(plan);
+}
+
+static void _ccv_filter_fft_spectrum_free(void* spectrum)
+{
+	fftw_free(spectrum);
+}
+
+static ccv_filter_fft_plan_t* _ccv_filter_fftw_plan_out(uint64_t sign, int rows, int cols, int ch, int fft_type)
+{
+	ccv_filter_fft_plan_t* plan = (ccv_filter_fft_plan_t*)_ccv_filter_fft_cache_out(sign, 0);
+	if (plan)
+		return plan;
+	plan = (ccv_filter_fft_plan_t*)ccmalloc(sizeof(ccv_filter_fft_plan_t));
+	plan->fft_type = fft_type;
+	plan->ch = ch;
+	int ndim[] = {rows, cols};
+	pthread_mutex_lock(&fftw_plan_mutex);
 	if (fft_type == CCV_32F)
 	{
-		fftw_a = fftwf_malloc(rows * cols_2c * ch * sizeof(float));
-		fftw_b = fftwf_malloc(rows * cols_2c * ch * sizeof(float));
-		fftw_d = fftwf_malloc(rows * cols_2c * ch * sizeof(float));
-		pthread_mutex_lock(&fftw_plan_mutex);
 		if (ch == 1)
 		{
-			pf = fftwf_plan_dft_r2c_2d(rows, cols, 0, 0, FFTW_ESTIMATE);
-			pinvf = fftwf_plan_dft_c2r_2d(rows, cols, 0, 0, FFTW_ESTIMATE);
+			plan->p = fftwf_plan_dft_r2c_2d(rows, cols, 0, 0, FFTW_ESTIMATE);
+			plan->pinv_sum = plan->pinv = fftwf_plan_dft_c2r_2d(rows, cols, 0, 0, FFTW_ESTIMATE);
 		} else {
-			int ndim[] = {rows, cols};
-			pf = fftwf_plan_many_dft_r2c(2, ndim, ch, 0, 0, ch, 1, 0, 0, ch, 1, FFTW_ESTIMATE);
-			pinvf = fftwf_plan_many_dft_c2r(2, ndim, ch, 0, 0, ch, 1, 0, 0, ch, 1, FFTW_ESTIMATE);
+			plan->p = fftwf_plan_many_dft_r2c(2, ndim, ch, 0, 0, ch, 1, 0, 0, ch, 1, FFTW_ESTIMATE);
+			plan->pinv = fftwf_plan_many_dft_c2r(2, ndim, ch, 0, 0, ch, 1, 0, 0, ch, 1, FFTW_ESTIMATE);
+			plan->pinv_sum = fftwf_plan_dft_c2r_2d(rows, cols, 0, 0, FFTW_ESTIMATE);
 		}
-		pthread_mutex_unlock(&fftw_plan_mutex);
 	} else {
-		fftw_a = fftw_malloc(rows * cols_2c * ch * sizeof(double));
-		fftw_b = fftw_malloc(rows * cols_2c * ch * sizeof(double));
-		fftw_d = fftw_malloc(rows * cols_2c * ch * sizeof(double));
-		pthread_mutex_lock(&fftw_plan_mutex);
 		if (ch == 1)
 		{
-			p = fftw_plan_dft_r2c_2d(rows, cols, 0, 0, FFTW_ESTIMATE);
-			pinv = fftw_plan_dft_c2r_2d(rows, cols, 0, 0, FFTW_ESTIMATE);
+			plan->p = fftw_plan_dft_r2c_2d(rows, cols, 0, 0, FFTW_ESTIMATE);
+			plan->pinv_sum = plan->pinv = fftw_plan_dft_c2r_2d(rows, cols, 0, 0, FFTW_ESTIMATE);
 		} else {
-			int ndim[] = {rows, cols};
-			p = fftw_plan_many_dft_r2c(2, ndim, ch, 0, 0, ch, 1, 0, 0, ch, 1, FFTW_ESTIMATE);
-			pinv = fftw_plan_many_dft_c2r(2, ndim, ch, 0, 0, ch, 1, 0, 0, ch, 1, FFTW_ESTIMATE);
+			plan->p = fftw_plan_many_dft_r2c(2, ndim, ch, 0, 0, ch, 1, 0, 0, ch, 1, FFTW_ESTIMATE);
+			plan->pinv = fftw_plan_many_dft_c2r(2, ndim, ch, 0, 0, ch, 1, 0, 0, ch, 1, FFTW_ESTIMATE);
+			plan->pinv_sum = fftw_plan_dft_c2r_2d(rows, cols, 0, 0, FFTW_ESTIMATE);
 		}
-		pthread_mutex_unlock(&fftw_plan_mutex);
 	}
-	memset(fftw_b, 0, rows * cols_2c * ch * CCV_GET_DATA_TYPE_SIZE(fft_type));
+	pthread_mutex_unlock(&fftw_plan_mutex);
+	return plan;
+}
 
+static void* _ccv_filter_fftw_spectrum_out(uint64_t sign, ccv_filter_fft_plan_t* plan, ccv_dense_matrix_t* b, int rows, int cols)
+{
+	void* fftw_b = sign ? _ccv_filter_fft_cache_out(sign, 1) : 0;
+	if (fftw_b)
+		return fftw_b;
+	int ch = plan->ch;
+	int fft_type = plan->fft_type;
+	int cols_2c = 2 * (cols / 2 + 1);
+	fftw_b = fftw_malloc(rows * cols_2c * ch * CCV_GET_DATA_TYPE_SIZE(fft_type));
+	memset(fftw_b, 0, rows * cols_2c * ch * CCV_GET_DATA_TYPE_SIZE(fft_type));
 	int i, j, k;
 	unsigned char* m_ptr = b->data.u8;
 	// to flip matrix b is crucial, this problem only shows when I changed to a more sophisticated test case
@@ -644,9 +754,29 @@ static void _ccv_filter_fftw(ccv_dense_matrix_t* a, ccv_dense_matrix_t* b, ccv_d
 	ccv_matrix_typeof(fft_type, ccv_matrix_getter, b->type, for_block);
 #undef for_block
 	if (fft_type == CCV_32F)
-		fftwf_execute_dft_r2c(pf, (float*)fftw_b, (fftwf_complex*)fftw_b);
+		fftwf_execute_dft_r2c((fftwf_plan)plan->p, (float*)fftw_b, (fftwf_complex*)fftw_b);
 	else
-		fftw_execute_dft_r2c(p, (double*)fftw_b, (fftw_complex*)fftw_b);
+		fftw_execute_dft_r2c((fftw_plan)plan->p, (double*)fftw_b, (fftw_complex*)fftw_b);
+	return fftw_b;
+}
+
+static void _ccv_filter_fftw(ccv_dense_matrix_t* a, ccv_dense_matrix_t* b, ccv_dense_matrix_t* d, int padding_pattern)
+{
+	int ch = CCV_GET_CHANNEL(a->type);
+	// either the same as ch, or 1 when channels are summed up in the frequency domain
+	int dch = CCV_GET_CHANNEL(d->type);
+	int fft_type = (CCV_GET_DATA_TYPE(d->type) == CCV_8U || CCV_GET_DATA_TYPE(d->type) == CCV_32F) ? CCV_32F : CCV_64F;
+	int rows = ccv_min(a->rows + b->rows - 1, _ccv_get_optimal_fft_size(b->rows * 3));
+	int cols = ccv_min(a->cols + b->cols - 1, _ccv_get_optimal_fft_size(b->cols * 3));
+	int cols_2c = 2 * (cols / 2 + 1);
+	uint64_t plan_sign = _ccv_filter_fft_sign(0, rows, cols, ch, fft_type, CCV_EOF_SIGN);
+	uint64_t spectrum_sign = b->sig ? _ccv_filter_fft_sign(1, rows, cols, ch, fft_type, b->sig) : 0;
+	ccv_filter_fft_plan_t* plan = _ccv_filter_fftw_plan_out(plan_sign, rows, cols, ch, fft_type);
+	void* fftw_a = fftw_malloc(rows * cols_2c * ch * CCV_GET_DATA_TYPE_SIZE(fft_type));
+	void* fftw_b = _ccv_filter_fftw_spectrum_out(spectrum_sign, plan, b, rows, cols);
+	void* fftw_d = fftw_malloc(rows * cols_2c * dch * CCV_GET_DATA_TYPE_SIZE(fft_type));
+	int i, j, k;
+	unsigned char* m_ptr;
 	/* why a->cols + cols - 2 * (b->cols & ~1) ?
 	 * what we really want is ceiling((a->cols - (b->cols & ~1)) / (cols - (b->cols & ~1)))
 	 * in this case, we strip out paddings on the left/right, and compute how many tiles
@@ -679,10 +809,22 @@ static void _ccv_filter_fftw(ccv_dense_matrix_t* a, ccv_dense_matrix_t* b, ccv_d
 			_cpx_type* fftw_bc = (_cpx_type*)fftw_b; \
 			_cpx_type* fftw_dc = (_cpx_type*)fftw_d; \
 			fft_execute_dft_r2c((_for_type*)fftw_a, (_cpx_type*)fftw_ac); \
-			for (x = 0; x < rows * ch * (cols / 2 + 1); x++) \
-				fftw_dc[x] = (fftw_ac[x] * fftw_bc[x]) * scale; \
-			fft_execute_dft_c2r((_cpx_type*)fftw_dc, (_for_type*)fftw_d); \
-			fftw_ptr = (_for_type*)fftw_d + ((1 + (i > 0)) * brows2 * cols_2c + (1 + (j > 0)) * bcols2) * ch; \
+			if (dch == ch) \
+			{ \
+				for (x = 0; x < rows * ch * (cols / 2 + 1); x++) \
+					fftw_dc[x] = (fftw_ac[x] * fftw_bc[x]) * scale; \
+				fft_execute_dft_c2r((_cpx_type*)fftw_dc, (_for_type*)fftw_d); \
+			} else { \
+				for (x = 0; x < rows * (cols / 2 + 1); x++) \
+				{ \
+					_cpx_type sum = 0; \
+					for (k = 0; k < ch; k++) \
+						sum += fftw_ac[x * ch + k] * fftw_bc[x * ch + k]; \
+					fftw_dc[x] = sum * scale; \
+				} \
+				fft_execute_dft_c2r_sum((_cpx_type*)fftw_dc, (_for_type*)fftw_d); \
+			} \
+			fftw_ptr = (_for_type*)fftw_d + ((1 + (i > 0)) * brows2 * cols_2c + (1 + (j > 0)) * bcols2) * dch; \
 			end_y = ccv_min(d->rows - (iy + (i > 0) * brows2), \
 							(rows - (b->rows & ~1)) + (i == 0) * brows2); \
 			end_x = ccv_min(d->cols - (ix + (j > 0) * bcols2), \
@@ -690,37 +832,37 @@ static void _ccv_filter_fftw(ccv_dense_matrix_t* a, ccv_dense_matrix_t* b, ccv_d
 			m_ptr = (unsigned char*)ccv_get_dense_matrix_cell(d, iy + (i > 0) * brows2, ix + (j > 0) * bcols2, 0); \
 			for (y = 0; y < end_y; y++) \
 			{ \
-				for (x = 0; x < end_x * ch; x++) \
+				for (x = 0; x < end_x * dch; x++) \
 					_for_set(m_ptr, x, fftw_ptr[x], 0); \
 				m_ptr += d->step; \
-				fftw_ptr += cols_2c * ch; \
+				fftw_ptr += cols_2c * dch; \
 			} \
 			int end_tile_y, end_tile_x; \
 			/* handle edge cases: */ \
 			if (i + 1 == tile_y && end_y + iy + (i > 0) * brows2 < d->rows) \
 			{ \
 				end_tile_y = ccv_min(brows2, d->rows - (iy + (i > 0) * brows2 + end_y)); \
-				fftw_ptr = (_for_type*)fftw_d + (1 + (j > 0)) * bcols2 * ch; \
+				fftw_ptr = (_for_type*)fftw_d + (1 + (j > 0)) * bcols2 * dch; \
 				m_ptr = (unsigned char*)ccv_get_dense_matrix_cell(d, iy + (i > 0) * brows2 + end_y, ix + (j > 0) * bcols2, 0); \
 				for (y = 0; y < end_tile_y; y++) \
 				{ \
-					for (x = 0; x < end_x * ch; x++) \
+					for (x = 0; x < end_x * dch; x++) \
 						_for_set(m_ptr, x, fftw_ptr[x], 0); \
 					m_ptr += d->step; \
-					fftw_ptr += cols_2c * ch; \
+					fftw_ptr += cols_2c * dch; \
 				} \
 			} \
 			if (j + 1 == tile_x && end_x + ix + (j > 0) * bcols2 < d->cols) \
 			{ \
 				end_tile_x = ccv_min(bcols2, d->cols - (ix + (j > 0) * bcols2 + end_x)); \
-				fftw_ptr = (_for_type*)fftw_d + (1 + (i > 0)) * brows2 * cols_2c * ch; \
+				fftw_ptr = (_for_type*)fftw_d + (1 + (i > 0)) * brows2 * cols_2c * dch; \
 				m_ptr = (unsigned char*)ccv_get_dense_matrix_cell(d, iy + (i > 0) * brows2, ix + (j > 0) * bcols2 + end_x, 0); \
 				for (y = 0; y < end_y; y++) \
 				{ \
-					for (x = 0; x < end_tile_x * ch; x++) \
+					for (x = 0; x < end_tile_x * dch; x++) \
 						_for_set(m_ptr, x, fftw_ptr[x], 0); \
 					m_ptr += d->step; \
-					fftw_ptr += cols_2c * ch; \
+					fftw_ptr += cols_2c * dch; \
 				} \
 			} \
 			if (i + 1 == tile_y && end_y + iy + (i > 0) * brows2 < d->rows && \
@@ -730,84 +872,97 @@ static void _ccv_filter_fftw(ccv_dense_matrix_t* a, ccv_dense_matrix_t* b, ccv_d
 				m_ptr = (unsigned char*)ccv_get_dense_matrix_cell(d, iy + (i > 0) * brows2 + end_y, ix + (j > 0) * bcols2 + end_x, 0); \
 				for (y = 0; y < end_tile_y; y++) \
 				{ \
-					for (x = 0; x < end_tile_x * ch; x++) \
+					for (x = 0; x < end_tile_x * dch; x++) \
 						_for_set(m_ptr, x, fftw_ptr[x], 0); \
 					m_ptr += d->step; \
-					fftw_ptr += cols_2c * ch; \
+					fftw_ptr += cols_2c * dch; \
 				} \
 			} \
 		}
 	if (fft_type == CCV_32F)
 	{
-#define fft_execute_dft_r2c(r, c) fftwf_execute_dft_r2c(pf, r, c)
-#define fft_execute_dft_c2r(c, r) fftwf_execute_dft_c2r(pinvf, c, r)
+#define fft_execute_dft_r2c(r, c) fftwf_execute_dft_r2c((fftwf_plan)plan->p, r, c)
+#define fft_execute_dft_c2r(c, r) fftwf_execute_dft_c2r((fftwf_plan)plan->pinv, c, r)
+#define fft_execute_dft_c2r_sum(c, r) fftwf_execute_dft_c2r((fftwf_plan)plan->pinv_sum, c, r)
 		ccv_matrix_setter(d->type, ccv_matrix_getter, a->type, for_block, float, fftwf_complex);
 #undef fft_execute_dft_r2c
 #undef fft_execute_dft_c2r
-		pthread_mutex_lock(&fftw_plan_mutex);
-		fftwf_destroy_plan(pf);
-		fftwf_destroy_plan(pinvf);
-		pthread_mutex_unlock(&fftw_plan_mutex);
-		fftwf_free(fftw_a);
-		fftwf_free(fftw_b);
-		fftwf_free(fftw_d);
+#undef fft_execute_dft_c2r_sum
 	} else {
-#define fft_execute_dft_r2c(r, c) fftw_execute_dft_r2c(p, r, c)
-#define fft_execute_dft_c2r(c, r) fftw_execute_dft_c2r(pinv, c, r)
+#define fft_execute_dft_r2c(r, c) fftw_execute_dft_r2c((fftw_plan)plan->p, r, c)
+#define fft_execute_dft_c2r(c, r) fftw_execute_dft_c2r((fftw_plan)plan->pinv, c, r)
+#define fft_execute_dft_c2r_sum(c, r) fftw_execute_dft_c2r((fftw_plan)plan->pinv_sum, c, r)
 		ccv_matrix_setter(d->type, ccv_matrix_getter, a->type, for_block, double, fftw_complex);
 #undef fft_execute_dft_r2c
 #undef fft_execute_dft_c2r
-		pthread_mutex_lock(&fftw_plan_mutex);
-		fftw_destroy_plan(p);
-		fftw_destroy_plan(pinv);
-		pthread_mutex_unlock(&fftw_plan_mutex);
-		fftw_free(fftw_a);
-		fftw_free(fftw_b);
-		fftw_free(fftw_d);
+#undef fft_execute_dft_c2r_sum
 	}
 #undef for_block
+	fftw_free(fftw_a);
+	fftw_free(fftw_d);
+	if (spectrum_sign)
+	{
+		uint32_t size = rows * cols_2c * ch * CCV_GET_DATA_TYPE_SIZE(fft_type);
+		_ccv_filter_fft_cache_put(spectrum_sign, fftw_b, size, 1, _ccv_filter_fft_spectrum_cost(rows, cols, size));
+	} else
+		fftw_free(fftw_b);
+	_ccv_filter_fft_cache_put(plan_sign, plan, sizeof(ccv_filter_fft_plan_t) + (rows + cols) * 2 * CCV_GET_DATA_TYPE_SIZE(fft_type), 0, 0);
 }
 #else
-static void _ccv_filter_kissfft(ccv_dense_matrix_t* a, ccv_dense_matrix_t* b, ccv_dense_matrix_t* d, int padding_pattern)
+typedef struct {
+	int fft_type;
+	void* p; // kiss_fftndr_cfg or kissf_fftndr_cfg, they don't depend on channels
+	void* pinv;
+} ccv_filter_fft_plan_t;
+
+static void _ccv_filter_fft_plan_free(void* x)
 {
-	int ch = CCV_GET_CHANNEL(a->type);
-	int fft_type = (CCV_GET_DATA_TYPE(d->type) == CCV_8U || CCV_GET_DATA_TYPE(d->type) == CCV_32F) ? CCV_32F : CCV_64F;
-	int rows = ((ccv_min(a->rows + b->rows - 1, kiss_fftr_next_fast_size_real(b->rows * 3)) + 1) >> 1) << 1;
-	int cols = ((ccv_min(a->cols + b->cols - 1, kiss_fftr_next_fast_size_real(b->cols * 3)) + 1) >> 1) << 1;
+	ccv_filter_fft_plan_t* plan = (ccv_filter_fft_plan_t*)x;
+	if (plan->fft_type == CCV_32F)
+	{
+		kissf_fft_free(plan->p);
+		kissf_fft_free(plan->pinv);
+	} else {
+		kiss_fft_free(plan->p);
+		kiss_fft_free(plan->pinv);
+	}
+	ccfree(plan);
+}
+
+static void _ccv_filter_fft_spectrum_free(void* spectrum)
+{
+	ccfree(spectrum);
+}
+
+static ccv_filter_fft_plan_t* _ccv_filter_kissfft_plan_out(uint64_t sign, int rows, int cols, int fft_type)
+{
+	ccv_filter_fft_plan_t* plan = (ccv_filter_fft_plan_t*)_ccv_filter_fft_cache_out(sign, 0);
+	if (plan)
+		return plan;
+	plan = (ccv_filter_fft_plan_t*)ccmalloc(sizeof(ccv_filter_fft_plan_t));
+	plan->fft_type = fft_type;
 	int ndim[] = {rows, cols};
-	void* kiss_a;
-	void* kiss_b;
-	void* kiss_d;
-	void* kiss_ac;
-	void* kiss_bc;
-	void* kiss_dc;
-	kiss_fftndr_cfg p;
-	kiss_fftndr_cfg pinv;
-	kissf_fftndr_cfg pf;
-	kissf_fftndr_cfg pinvf;
 	if (fft_type == CCV_32F)
 	{
-		pf = kissf_fftndr_alloc(ndim, 2, 0, 0, 0);
-		pinvf = kissf_fftndr_alloc(ndim, 2, 1, 0, 0);
-		kiss_a = ccmalloc(rows * cols * ch * sizeof(kissf_fft_scalar));
-		kiss_b = ccmalloc(rows * cols * ch * sizeof(kissf_fft_scalar));
-		kiss_d = ccmalloc(rows * cols * ch * sizeof(kissf_fft_scalar));
-		kiss_ac = ccmalloc(rows * (cols / 2 + 1) * ch * sizeof(kissf_fft_cpx));
-		kiss_bc = ccmalloc(rows * (cols / 2 + 1) * ch * sizeof(kissf_fft_cpx));
-		kiss_dc = ccmalloc(rows * (cols / 2 + 1) * ch * sizeof(kissf_fft_cpx));
-		memset(kiss_b, 0, rows * cols * ch * sizeof(kissf_fft_scalar));
+		plan->p = kissf_fftndr_alloc(ndim, 2, 0, 0, 0);
+		plan->pinv = kissf_fftndr_alloc(ndim, 2, 1, 0, 0);
 	} else {
-		p = kiss_fftndr_alloc(ndim, 2, 0, 0, 0);
-		pinv = kiss_fftndr_alloc(ndim, 2, 1, 0, 0);
-		kiss_a = ccmalloc(rows * cols * ch * sizeof(kiss_fft_scalar));
-		kiss_b = ccmalloc(rows * cols * ch * sizeof(kiss_fft_scalar));
-		kiss_d = ccmalloc(rows * cols * ch * sizeof(kiss_fft_scalar));
-		kiss_ac = ccmalloc(rows * (cols / 2 + 1) * ch * sizeof(kiss_fft_cpx));
-		kiss_bc = ccmalloc(rows * (cols / 2 + 1) * ch * sizeof(kiss_fft_cpx));
-		kiss_dc = ccmalloc(rows * (cols / 2 + 1) * ch * sizeof(kiss_fft_cpx));
-		memset(kiss_b, 0, rows * cols * ch * sizeof(kiss_fft_scalar));
+		plan->p = kiss_fftndr_alloc(ndim, 2, 0, 0, 0);
+		plan->pinv = kiss_fftndr_alloc(ndim, 2, 1, 0, 0);
 	}
+	return plan;
+}
+
+static void* _ccv_filter_kissfft_spectrum_out(uint64_t sign, ccv_filter_fft_plan_t* plan, ccv_dense_matrix_t* b, int rows, int cols, int ch)
+{
+	void* kiss_bc = sign ? _ccv_filter_fft_cache_out(sign, 1) : 0;
+	if (kiss_bc)
+		return kiss_bc;
+	int fft_type = plan->fft_type;
 	int nch = rows * cols, nchc = rows * (cols / 2 + 1);
+	void* kiss_b = ccmalloc(nch * ch * CCV_GET_DATA_TYPE_SIZE(fft_type));
+	kiss_bc = ccmalloc(nchc * ch * 2 * CCV_GET_DATA_TYPE_SIZE(fft_type));
+	memset(kiss_b, 0, nch * ch * CCV_GET_DATA_TYPE_SIZE(fft_type));
 	int i, j, k;
 	unsigned char* m_ptr = b->data.u8;
 	// to flip matrix b is crucial, this problem only shows when I changed to a more sophisticated test case
@@ -825,10 +980,34 @@ static void _ccv_filter_kissfft(ccv_dense_matrix_t* a, ccv_dense_matrix_t* b, cc
 #undef for_block
 	if (fft_type == CCV_32F)
 		for (k = 0; k < ch; k++)
-			kissf_fftndr(pf, (kissf_fft_scalar*)kiss_b + nch * k, (kissf_fft_cpx*)kiss_bc + nchc * k);
+			kissf_fftndr((kissf_fftndr_cfg)plan->p, (kissf_fft_scalar*)kiss_b + nch * k, (kissf_fft_cpx*)kiss_bc + nchc * k);
 	else
 		for (k = 0; k < ch; k++)
-			kiss_fftndr(p, (kiss_fft_scalar*)kiss_b + nch * k, (kiss_fft_cpx*)kiss_bc + nchc * k);
+			kiss_fftndr((kiss_fftndr_cfg)plan->p, (kiss_fft_scalar*)kiss_b + nch * k, (kiss_fft_cpx*)kiss_bc + nchc * k);
+	ccfree(kiss_b);
+	return kiss_bc;
+}
+
+static void _ccv_filter_kissfft(ccv_dense_matrix_t* a, ccv_dense_matrix_t* b, ccv_dense_matrix_t* d, int padding_pattern)
+{
+	int ch = CCV_GET_CHANNEL(a->type);
+	// either the same as ch, or 1 when channels are summed up in the frequency domain
+	int dch = CCV_GET_CHANNEL(d->type);
+	int fft_type = (CCV_GET_DATA_TYPE(d->type) == CCV_8U || CCV_GET_DATA_TYPE(d->type) == CCV_32F) ? CCV_32F : CCV_64F;
+	int rows = ((ccv_min(a->rows + b->rows - 1, kiss_fftr_next_fast_size_real(b->rows * 3)) + 1) >> 1) << 1;
+	int cols = ((ccv_min(a->cols + b->cols - 1, kiss_fftr_next_fast_size_real(b->cols * 3)) + 1) >> 1) << 1;
+	uint64_t plan_sign = _ccv_filter_fft_sign(0, rows, cols, 1, fft_type, CCV_EOF_SIGN);
+	uint64_t spectrum_sign = b->sig ? _ccv_filter_fft_sign(1, rows, cols, ch, fft_type, b->sig) : 0;
+	ccv_filter_fft_plan_t* plan = _ccv_filter_kissfft_plan_out(plan_sign, rows, cols, fft_type);
+	int nch = rows * cols, nchc = rows * (cols / 2 + 1);
+	size_t scalar_size = CCV_GET_DATA_TYPE_SIZE(fft_type);
+	void* kiss_a = ccmalloc(nch * ch * scalar_size);
+	void* kiss_d = ccmalloc(nch * dch * scalar_size);
+	void* kiss_ac = ccmalloc(nchc * ch * 2 * scalar_size);
+	void* kiss_bc = _ccv_filter_kissfft_spectrum_out(spectrum_sign, plan, b, rows, cols, ch);
+	void* kiss_dc = ccmalloc(nchc * dch * 2 * scalar_size);
+	int i, j, k;
+	unsigned char* m_ptr;
 	/* why a->cols + cols - 2 * (b->cols & ~1) ?
 	 * what we really want is ceiling((a->cols - (b->cols & ~1)) / (cols - (b->cols & ~1)))
 	 * in this case, we strip out paddings on the left/right, and compute how many tiles
@@ -863,12 +1042,34 @@ static void _ccv_filter_kissfft(ccv_dense_matrix_t* a, ccv_dense_matrix_t* b, cc
 			_cpx_type* fft_ac = (_cpx_type*)kiss_ac; \
 			_cpx_type* fft_bc = (_cpx_type*)kiss_bc; \
 			_cpx_type* fft_dc = (_cpx_type*)kiss_dc; \
-			for (x = 0; x < rows * ch * (cols / 2 + 1); x++) \
+			if (dch == ch) \
 			{ \
-				fft_dc[x].r = (fft_ac[x].r * fft_bc[x].r - fft_ac[x].i * fft_bc[x].i) * scale; \
-				fft_dc[x].i = (fft_ac[x].i * fft_bc[x].r + fft_ac[x].r * fft_bc[x].i) * scale; \
+				for (x = 0; x < rows * ch * (cols / 2 + 1); x++) \
+				{ \
+					fft_dc[x].r = (fft_ac[x].r * fft_bc[x].r - fft_ac[x].i * fft_bc[x].i) * scale; \
+					fft_dc[x].i = (fft_ac[x].i * fft_bc[x].r + fft_ac[x].r * fft_bc[x].i) * scale; \
+				} \
+			} else { \
+				/* sum up all channels before the inverse transform, thus, only one inverse is needed */ \
+				for (x = 0; x < nchc; x++) \
+					fft_dc[x].r = fft_dc[x].i = 0; \
+				for (k = 0; k < ch; k++) \
+				{ \
+					_cpx_type* fft_ack = fft_ac + nchc * k; \
+					_cpx_type* fft_bck = fft_bc + nchc * k; \
+					for (x = 0; x < nchc; x++) \
+					{ \
+						fft_dc[x].r += fft_ack[x].r * fft_bck[x].r - fft_ack[x].i * fft_bck[x].i; \
+						fft_dc[x].i += fft_ack[x].i * fft_bck[x].r + fft_ack[x].r * fft_bck[x].i; \
+					} \
+				} \
+				for (x = 0; x < nchc; x++) \
+				{ \
+					fft_dc[x].r *= scale; \
+					fft_dc[x].i *= scale; \
+				} \
 			} \
-			for (k = 0; k < ch; k++) \
+			for (k = 0; k < dch; k++) \
 				fft_ndri((_cpx_type*)kiss_dc + nchc * k, (_for_type*)kiss_d + nch * k); \
 			kiss_ptr = (_for_type*)kiss_d + (1 + (i > 0)) * brows2 * cols + (1 + (j > 0)) * bcols2; \
 			end_y = ccv_min(d->rows - (iy + (i > 0) * brows2), \
@@ -879,8 +1080,8 @@ static void _ccv_filter_kissfft(ccv_dense_matrix_t* a, ccv_dense_matrix_t* b, cc
 			for (y = 0; y < end_y; y++) \
 			{ \
 				for (x = 0; x < end_x; x++) \
-					for (k = 0; k < ch; k++) \
-						_for_set(m_ptr, x * ch + k, kiss_ptr[k * nch + x], 0); \
+					for (k = 0; k < dch; k++) \
+						_for_set(m_ptr, x * dch + k, kiss_ptr[k * nch + x], 0); \
 				m_ptr += d->step; \
 				kiss_ptr += cols; \
 			} \
@@ -894,8 +1095,8 @@ static void _ccv_filter_kissfft(ccv_dense_matrix_t* a, ccv_dense_matrix_t* b, cc
 				for (y = 0; y < end_tile_y; y++) \
 				{ \
 					for (x = 0; x < end_x; x++) \
-						for (k = 0; k < ch; k++) \
-							_for_set(m_ptr, x * ch + k, kiss_ptr[k * nch + x], 0); \
+						for (k = 0; k < dch; k++) \
+							_for_set(m_ptr, x * dch + k, kiss_ptr[k * nch + x], 0); \
 					m_ptr += d->step; \
 					kiss_ptr += cols; \
 				} \
@@ -908,8 +1109,8 @@ static void _ccv_filter_kissfft(ccv_dense_matrix_t* a, ccv_dense_matrix_t* b, cc
 				for (y = 0; y < end_y; y++) \
 				{ \
 					for (x = 0; x < end_tile_x; x++) \
-						for (k = 0; k < ch; k++) \
-							_for_set(m_ptr, x * ch + k, kiss_ptr[k * nch + x], 0); \
+						for (k = 0; k < dch; k++) \
+							_for_set(m_ptr, x * dch + k, kiss_ptr[k * nch + x], 0); \
 					m_ptr += d->step; \
 					kiss_ptr += cols; \
 				} \
@@ -922,8 +1123,8 @@ static void _ccv_filter_kissfft(ccv_dense_matrix_t* a, ccv_dense_matrix_t* b, cc
 				for (y = 0; y < end_tile_y; y++) \
 				{ \
 					for (x = 0; x < end_tile_x; x++) \
-						for (k = 0; k < ch; k++) \
-							_for_set(m_ptr, x * ch + k, kiss_ptr[k * nch + x], 0); \
+						for (k = 0; k < dch; k++) \
+							_for_set(m_ptr, x * dch + k, kiss_ptr[k * nch + x], 0); \
 					m_ptr += d->step; \
 					kiss_ptr += cols; \
 				} \
@@ -931,29 +1132,30 @@ static void _ccv_filter_kissfft(ccv_dense_matrix_t* a, ccv_dense_matrix_t* b, cc
 		}
 	if (fft_type == CCV_32F)
 	{
-#define fft_ndr(r, c) kissf_fftndr(pf, r, c)
-#define fft_ndri(c, r) kissf_fftndri(pinvf, c, r)
+#define fft_ndr(r, c) kissf_fftndr((kissf_fftndr_cfg)plan->p, r, c)
+#define fft_ndri(c, r) kissf_fftndri((kissf_fftndr_cfg)plan->pinv, c, r)
 		ccv_matrix_setter(d->type, ccv_matrix_getter, a->type, for_block, kissf_fft_scalar, kissf_fft_cpx);
 #undef fft_ndr
 #undef fft_ndri
-		kissf_fft_free(pf);
-		kissf_fft_free(pinvf);
 	} else {
-#define fft_ndr(r, c) kiss_fftndr(p, r, c)
-#define fft_ndri(c, r) kiss_fftndri(pinv, c, r)
+#define fft_ndr(r, c) kiss_fftndr((kiss_fftndr_cfg)plan->p, r, c)
+#define fft_ndri(c, r) kiss_fftndri((kiss_fftndr_cfg)plan->pinv, c, r)
 		ccv_matrix_setter(d->type, ccv_matrix_getter, a->type, for_block, kiss_fft_scalar, kiss_fft_cpx);
 #undef fft_ndr
 #undef fft_ndri
-		kiss_fft_free(p);
-		kiss_fft_free(pinv);
 	}
 #undef for_block
 	ccfree(kiss_dc);
-	ccfree(kiss_bc);
 	ccfree(kiss_ac);
 	ccfree(kiss_d);
-	ccfree(kiss_b);
 	ccfree(kiss_a);
+	if (spectrum_sign)
+	{
+		uint32_t size = nchc * ch * 2 * scalar_size;
+		_ccv_filter_fft_cache_put(spectrum_sign, kiss_bc, size, 1, _ccv_filter_fft_spectrum_cost(rows, cols, size));
+	} else
+		ccfree(kiss_bc);
+	_ccv_filter_fft_cache_put(plan_sign, plan, sizeof(ccv_filter_fft_plan_t) + (rows + cols) * 2 * scalar_size, 0, 0);
 }
 #endif
 
@@ -1035,9 +1237,11 @@ static void _ccv_filter_direct_8u(ccv_dense_matrix_t* a, ccv_dense_matrix_t* b,
 
 void ccv_filter(ccv_dense_matrix_t* a, ccv_dense_matrix_t* b, ccv_dense_matrix_t** d, int type, int padding_pattern)
 {
-	ccv_declare_derived_signature(sig, a->sig != 0 && b->sig != 0, ccv_sign_with_literal("ccv_filter"), a->sig, b->sig, CCV_EOF_SIGN);
-	type = (type == 0) ? CCV_GET_DATA_TYPE(a->type) | CCV_GET_CHANNEL(a->type) : CCV_GET_DATA_TYPE(type) | CCV_GET_CHANNEL(a->type);
-	ccv_dense_matrix_t* dd = *d = ccv_dense_matrix_renew(*d, a->rows, a->cols, CCV_ALL_DATA_TYPE | CCV_GET_CHANNEL(a->type), type, sig);
+	/* asking for CCV_C1 output on a multi-channel matrix sums up the responses of all channels */
+	int ch = (CCV_GET_CHANNEL(type) == CCV_C1) ? CCV_C1 : CCV_GET_CHANNEL(a->type);
+	ccv_declare_derived_signature(sig, a->sig != 0 && b->sig != 0, ccv_sign_with_format(20, "ccv_filter(%d)", ch), a->sig, b->sig, CCV_EOF_SIGN);
+	type = (CCV_GET_DATA_TYPE(type) == 0) ? CCV_GET_DATA_TYPE(a->type) | ch : CCV_GET_DATA_TYPE(type) | ch;
+	ccv_dense_matrix_t* dd = *d = ccv_dense_matrix_renew(*d, a->rows, a->cols, CCV_ALL_DATA_TYPE | ch, type, sig);
 	ccv_object_return_if_cached(, dd);
 
 	/* 15 is the constant to indicate the high cost of FFT (even with O(nlog(m)) for
@@ -1048,7 +1252,7 @@ void ccv_filter(ccv_dense_matrix_t* a, ccv_dense_matrix_t* b, ccv_dense_matrix_t
 	 * to do FFT for the whole image. The image can be divided to n/m part, and
 	 * the FFT itself is O(mlog(m)), so, the convolution process has time complexity
 	 * of O(nlog(m)) */
-	if ((b->rows * b->cols < (log((double)(b->rows * b->cols)) + 1) * 15) && (a->type & CCV_8U))
+	if ((b->rows * b->cols < (log((double)(b->rows * b->cols)) + 1) * 15) && (a->type & CCV_8U) && ch == CCV_GET_CHANNEL(a->type))
 	{
 		_ccv_filter_direct_8u(a, b, dd, padding_pattern);
 	} else {
@@ -0,0 +1,244 @@
+#include "ccv.h"
+#include "ccv_internal.h"
+#ifdef USE_OPENMP
+#include <omp.h>
+#endif
+#ifdef USE_DISPATCH
+#include <dispatch/dispatch.h>
+#endif
+
+typedef struct {
+	uint64_t sig;
+	int feature;
+	int refcount; // How many callers got this matrix from the pyramid and haven't released it yet.
+	ccv_dense_matrix_t* mat;
+} ccv_pyramid_entry_t;
+
+// Every pyramid has its own lock, thus, detectors running on different pyramids don't contend with each other.
+static void _ccv_pyramid_lock(ccv_pyramid_t* pyramid)
+{
+#ifdef USE_DISPATCH
+	dispatch_semaphore_wait((dispatch_semaphore_t)pyramid->lock, DISPATCH_TIME_FOREVER);
+#elif defined(USE_OPENMP)
+	omp_set_lock((omp_lock_t*)pyramid->lock);
+#endif
+}
+
+static void _ccv_pyramid_unlock(ccv_pyramid_t* pyramid)
+{
+#ifdef USE_DISPATCH
+	dispatch_semaphore_signal((dispatch_semaphore_t)pyramid->lock);
+#elif defined(USE_OPENMP)
+	omp_unset_lock((omp_lock_t*)pyramid->lock);
+#endif
+}
+
+ccv_pyramid_t* ccv_pyramid_new(ccv_dense_matrix_t* a, int flags)
+{
+	ccv_pyramid_t* pyramid = (ccv_pyramid_t*)ccmalloc(sizeof(ccv_pyramid_t));
+	pyramid->flags = flags;
+	pyramid->image = a;
+	// Even the input image doesn't have a signature, everything in the pyramid can still be keyed from a made up one.
+	ccv_declare_derived_signature(sig, a->sig == 0, ccv_sign_with_literal("ccv_pyramid"), CCV_EOF_SIGN);
+	pyramid->sig = a->sig ? a->sig : sig;
+	pyramid->entries = ccv_array_new(sizeof(ccv_pyramid_entry_t), 64, 0);
+#ifdef USE_DISPATCH
+	pyramid->lock = (void*)dispatch_semaphore_create(1);
+#elif defined(USE_OPENMP)
+	pyramid->lock = ccmalloc(sizeof(omp_lock_t));
+	omp_init_lock((omp_lock_t*)pyramid->lock);
+#else
+	pyramid->lock = 0;
+#endif
+	return pyramid;
+}
+
+// The lock only guards the entries, the computation happens outside of it.
+static uint64_t _ccv_pyramid_key(ccv_pyramid_t* pyramid, ccv_dense_matrix_t* a)
+{
+	if (a == pyramid->image)
+		return pyramid->sig;
+	uint64_t sig = a->sig;
+	_ccv_pyramid_lock(pyramid);
+	int i;
+	for (i = 0; i < pyramid->entries->rnum; i++)
+	{
+		ccv_pyramid_entry_t* entry = (ccv_pyramid_entry_t*)ccv_array_get(pyramid->entries, i);
+		if (entry->mat == a)
+		{
+			sig = entry->sig;
+			break;
+		}
+	}
+	_ccv_pyramid_unlock(pyramid);
+	return sig;
+}
+
+static ccv_dense_matrix_t* _ccv_pyramid_find(ccv_pyramid_t* pyramid, uint64_t sig)
+{
+	if (sig == 0)
+		return 0;
+	ccv_dense_matrix_t* mat = 0;
+	_ccv_pyramid_lock(pyramid);
+	int i;
+	for (i = 0; i < pyramid->entries->rnum; i++)
+	{
+		ccv_pyramid_entry_t* entry = (ccv_pyramid_entry_t*)ccv_array_get(pyramid->entries, i);
+		if (entry->sig == sig)
+		{
+			++entry->refcount;
+			mat = entry->mat;
+			break;
+		}
+	}
+	_ccv_pyramid_unlock(pyramid);
+	return mat;
+}
+
+static ccv_dense_matrix_t* _ccv_pyramid_add(ccv_pyramid_t* pyramid, uint64_t sig, ccv_dense_matrix_t* mat, int feature)
+{
+	ccv_dense_matrix_t* exist = 0;
+	_ccv_pyramid_lock(pyramid);
+	int i;
+	if (sig != 0)
+		for (i = 0; i < pyramid->entries->rnum; i++)
+		{
+			ccv_pyramid_entry_t* entry = (ccv_pyramid_entry_t*)ccv_array_get(pyramid->entries, i);
+			if (entry->sig == sig)
+			{
+				++entry->refcount;
+				exist = entry->mat;
+				break;
+			}
+		}
+	if (!exist)
+	{
+		ccv_pyramid_entry_t entry = {
+			.sig = sig,
+			.feature = feature,
+			.refcount = 1,
+			.mat = mat,
+		};
+		ccv_array_push(pyramid->entries, &entry);
+	}
+	_ccv_pyramid_unlock(pyramid);
+	// Somebody else computed the same thing in the meantime, keep theirs.
+	if (exist)
+	{
+		ccv_matrix_free(mat);
+		return exist;
+	}
+	return mat;
+}
+
+ccv_dense_matrix_t* ccv_pyramid_resample(ccv_pyramid_t* pyramid, ccv_dense_matrix_t* a, int rows, int cols, int type)
+{
+	uint64_t key = _ccv_pyramid_key(pyramid, a);
+	ccv_declare_derived_signature(sig, key != 0, ccv_sign_with_format(64, "ccv_resample(%d,%d,%d)", rows, cols, type), key, CCV_EOF_SIGN);
+	ccv_dense_matrix_t* b = _ccv_pyramid_find(pyramid, sig);
+	if (b)
+		return b;
+	ccv_resample(a, &b, 0, rows, cols, type);
+	return _ccv_pyramid_add(pyramid, sig, b, 0);
+}
+
+ccv_dense_matrix_t* ccv_pyramid_sample_down(ccv_pyramid_t* pyramid, ccv_dense_matrix_t* a, int src_x, int src_y)
+{
+	uint64_t key = _ccv_pyramid_key(pyramid, a);
+	ccv_declare_derived_signature(sig, key != 0, ccv_sign_with_format(64, "ccv_sample_down(%d,%d)", src_x, src_y), key, CCV_EOF_SIGN);
+	ccv_dense_matrix_t* b = _ccv_pyramid_find(pyramid, sig);
+	if (b)
+		return b;
+	ccv_sample_down(a, &b, 0, src_x, src_y);
+	return _ccv_pyramid_add(pyramid, sig, b, 0);
+}
+
+ccv_dense_matrix_t* ccv_pyramid_icf(ccv_pyramid_t* pyramid, ccv_dense_matrix_t* a, ccv_margin_t margin)
+{
+	uint64_t key = _ccv_pyramid_key(pyramid, a);
+	ccv_declare_derived_signature(sig, key != 0, ccv_sign_with_format(64, "ccv_icf(%d,%d,%d,%d)", margin.left, margin.top, margin.right, margin.bottom), key, CCV_EOF_SIGN);
+	ccv_dense_matrix_t* sat = _ccv_pyramid_find(pyramid, sig);
+	if (sat)
+		return sat;
+	ccv_dense_matrix_t* bordered = 0;
+	ccv_border(a, (ccv_matrix_t**)&bordered, 0, margin);
+	ccv_dense_matrix_t* icf = 0;
+	ccv_icf(bordered, &icf, 0);
+	ccv_matrix_free(bordered);
+	ccv_sat(icf, &sat, 0, CCV_PADDING_ZERO);
+	ccv_matrix_free(icf);
+	return _ccv_pyramid_add(pyramid, sig, sat, 1);
+}
+
+ccv_dense_matrix_t* ccv_pyramid_scd(ccv_pyramid_t* pyramid, ccv_dense_matrix_t* a, ccv_margin_t margin)
+{
+	uint64_t key = _ccv_pyramid_key(pyramid, a);
+	ccv_declare_derived_signature(sig, key != 0, ccv_sign_with_format(64, "ccv_scd(%d,%d,%d,%d)", margin.left, margin.top, margin.right, margin.bottom), key, CCV_EOF_SIGN);
+	ccv_dense_matrix_t* sat = _ccv_pyramid_find(pyramid, sig);
+	if (sat)
+		return sat;
+	ccv_dense_matrix_t* scd = 0;
+	if (margin.left == 0 && margin.top == 0 && margin.right == 0 && margin.bottom == 0)
+		ccv_scd(a, &scd, 0);
+	else {
+		ccv_dense_matrix_t* bordered = 0;
+		ccv_border(a, (ccv_matrix_t**)&bordered, 0, margin);
+		ccv_scd(bordered, &scd, 0);
+		ccv_matrix_free(bordered);
+	}
+	ccv_sat(scd, &sat, 0, CCV_PADDING_ZERO);
+	ccv_matrix_free(scd);
+	return _ccv_pyramid_add(pyramid, sig, sat, 1);
+}
+
+ccv_dense_matrix_t* ccv_pyramid_hog(ccv_pyramid_t* pyramid, ccv_dense_matrix_t* a, int sbin, int size)
+{
+	uint64_t key = _ccv_pyramid_key(pyramid, a);
+	ccv_declare_derived_signature(sig, key != 0, ccv_sign_with_format(64, "ccv_hog(%d,%d)", sbin, size), key, CCV_EOF_SIGN);
+	ccv_dense_matrix_t* hog = _ccv_pyramid_find(pyramid, sig);
+	if (hog)
+		return hog;
+	ccv_hog(a, &hog, 0, sbin, size);
+	return _ccv_pyramid_add(pyramid, sig, hog, 1);
+}
+
+void ccv_pyramid_release(ccv_pyramid_t* pyramid, ccv_dense_matrix_t* mat)
+{
+	int found = 0;
+	_ccv_pyramid_lock(pyramid);
+	int i;
+	for (i = 0; i < pyramid->entries->rnum; i++)
+	{
+		ccv_pyramid_entry_t* entry = (ccv_pyramid_entry_t*)ccv_array_get(pyramid->entries, i);
+		if (entry->mat == mat)
+		{
+			assert(entry->refcount > 0);
+			// Free it after the last use, unless the pyramid is asked to keep it for the next detector.
+			if (--entry->refcount == 0 && !(pyramid->flags & (entry->feature ? CCV_PYRAMID_CACHE_FEATURE : CCV_PYRAMID_CACHE_LEVEL)))
+			{
+				*entry = *(ccv_pyramid_entry_t*)ccv_array_get(pyramid->entries, pyramid->entries->rnum - 1);
+				--pyramid->entries->rnum;
+				found = 1;
+			}
+			break;
+		}
+	}
+	_ccv_pyramid_unlock(pyramid);
+	if (found)
+		ccv_matrix_free(mat);
+}
+
+void ccv_pyramid_free(ccv_pyramid_t* pyramid)
+{
+	int i;
+	for (i = 0; i < pyramid->entries->rnum; i++)
+		ccv_matrix_free(((ccv_pyramid_entry_t*)ccv_array_get(pyramid->entries, i))->mat);
+	ccv_array_free(pyramid->entries);
+#ifdef USE_DISPATCH
+	dispatch_release((dispatch_semaphore_t)pyramid->lock);
+#elif defined(USE_OPENMP)
+	omp_destroy_lock((omp_lock_t*)pyramid->lock);
+	ccfree(pyramid->lock);
+#endif
+	ccfree(pyramid);
+}
@@ -1650,28 +1650,28 @@ static int _ccv_is_equal_same_class(const void* _r1, const void* _r2, void* data
 	return i >= 0.3 * m; // IoM > 0.3 like HeadHunter does
 }
 
-ccv_array_t* ccv_scd_detect_objects(ccv_dense_matrix_t* a, ccv_scd_classifier_cascade_t** cascades, int count, ccv_scd_param_t params)
+// only the rectangles intersect with r can be grouped with r
+static ccv_rect_t _ccv_equal_bound(const void* _r, void* data)
 {
+	return ((const ccv_comp_t*)_r)->rect;
+}
+
+ccv_array_t* ccv_scd_detect_objects_in_pyramid(ccv_pyramid_t* pyramid, ccv_scd_classifier_cascade_t** cascades, int count, ccv_scd_param_t params)
+{
+	ccv_dense_matrix_t* a = pyramid->image;
 	int i, j, k, x, y, p, q;
 	int scale_upto = 1;
 	float up_ratio = 1.0;
 	for (i = 0; i < count; i++)
 		up_ratio = ccv_max(up_ratio, ccv_max((float)cascades[i]->size.width / params.size.width, (float)cascades[i]->size.height / params.size.height));
 	if (up_ratio - 1.0 > 1e-4)
-	{
-		ccv_dense_matrix_t* resized = 0;
-		ccv_resample(a, &resized, 0, (int)(a->rows * up_ratio + 0.5), (int)(a->cols * up_ratio + 0.5), CCV_INTER_CUBIC);
-		a = resized;
-	}
+		a = ccv_pyramid_resample(pyramid, a, (int)(a->rows * up_ratio + 0.5), (int)(a->cols * up_ratio + 0.5), CCV_INTER_CUBIC);
 	for (i = 0; i < count; i++)
 		scale_upto = ccv_max(scale_upto, (int)(log(ccv_min((double)a->rows / (cascades[i]->size.height - cascades[i]->margin.top - cascades[i]->margin.bottom), (double)a->cols / (cascades[i]->size.width - cascades[i]->margin.left - cascades[i]->margin.right))) / log(2.) - DBL_MIN) + 1);
 	ccv_dense_matrix_t** pyr = (ccv_dense_matrix_t**)alloca(sizeof(ccv_dense_matrix_t*) * scale_upto);
 	pyr[0] = a;
 	for (i = 1; i < scale_upto; i++)
-	{
-		pyr[i] = 0;
-		ccv_sample_down(pyr[i - 1], &pyr[i], 0, 0, 0);
-	}
+		pyr[i] = ccv_pyramid_sample_down(pyramid, pyr[i - 1], 0, 0);
 #if defined(HAVE_SSE2)
 	__m128 surf[8];
 #else
@@ -1694,27 +1694,11 @@ ccv_array_t* ccv_scd_detect_objects(ccv_dense_matrix_t* a, ccv_scd_classifier_ca
 				int cols = (int)(pyr[i]->cols / scale + 0.5);
 				if (rows < cascade->size.height || cols < cascade->size.width)
 					break;
-				ccv_dense_matrix_t* image = k == 0 ? pyr[i] : 0;
+				ccv_dense_matrix_t* image = k == 0 ? pyr[i] : ccv_pyramid_resample(pyramid, pyr[i], rows, cols, CCV_INTER_AREA);
+				ccv_dense_matrix_t* sat = ccv_pyramid_scd(pyramid, image, cascade->margin);
 				if (k > 0)
-					ccv_resample(pyr[i], &image, 0, rows, cols, CCV_INTER_AREA);
-				ccv_dense_matrix_t* scd = 0;
-				if (cascade->margin.left == 0 && cascade->margin.top == 0 && cascade->margin.right == 0 && cascade->margin.bottom == 0)
-				{
-					ccv_scd(image, &scd, 0);
-					if (k > 0)
-						ccv_matrix_free(image);
-				} else {
-					ccv_dense_matrix_t* bordered = 0;
-					ccv_border(image, (ccv_matrix_t**)&bordered, 0, cascade->margin);
-					if (k > 0)
-						ccv_matrix_free(image);
-					ccv_scd(bordered, &scd, 0);
-					ccv_matrix_free(bordered);
-				}
-				ccv_dense_matrix_t* sat = 0;
-				ccv_sat(scd, &sat, 0, CCV_PADDING_ZERO);
+					ccv_pyramid_release(pyramid, image);
 				assert(CCV_GET_CHANNEL(sat->type) == CCV_SCD_CHANNEL);
-				ccv_matrix_free(scd);
 				float* ptr = sat->data.f32;
 				for (y = 0; y < rows; y += params.step_through)
 				{
@@ -1779,17 +1763,13 @@ ccv_array_t* ccv_scd_detect_objects(ccv_dense_matrix_t* a, ccv_scd_classifier_ca
 					}
 					ptr += sat->cols * CCV_SCD_CHANNEL * params.step_through;
 				}
-				ccv_matrix_free(sat);
+				ccv_pyramid_release(pyramid, sat);
 				scale *= scale_ratio;
 			}
 		}
+		ccv_pyramid_release(pyramid, pyr[i]);
 	}
 
-	for (i = 1; i < scale_upto; i++)
-		ccv_matrix_free(pyr[i]);
-	if (up_ratio - 1.0 > 1e-4)
-		ccv_matrix_free(a);
-
 	ccv_array_t* result_seq = ccv_array_new(sizeof(ccv_comp_t), 64, 0);
 	for (k = 0; k < count; k++)
 	{
@@ -1804,7 +1784,7 @@ ccv_array_t* ccv_scd_detect_objects(ccv_dense_matrix_t* a, ccv_scd_classifier_ca
 		} else {
 			ccv_array_t* idx_seq = 0;
 			// group retrieved rectangles in order to filter out noise
-			int ncomp = ccv_array_group(seq[k], &idx_seq, _ccv_is_equal_same_class, 0);
+			int ncomp = ccv_array_group_spatially(seq[k], &idx_seq, _ccv_is_equal_same_class, _ccv_equal_bound, 0);
 			ccv_comp_t* comps = (ccv_comp_t*)cccalloc(ncomp + 1, sizeof(ccv_comp_t));
 
 			// count number of neighbors
@@ -1838,3 +1818,11 @@ ccv_array_t* ccv_scd_detect_objects(ccv_dense_matrix_t* a, ccv_scd_classifier_ca
 
 	return result_seq;
 }
+
+ccv_array_t* ccv_scd_detect_objects(ccv_dense_matrix_t* a, ccv_scd_classifier_cascade_t** cascades, int count, ccv_scd_param_t params)
+{
+	ccv_pyramid_t* pyramid = ccv_pyramid_new(a, 0);
+	ccv_array_t* result_seq = ccv_scd_detect_objects_in_pyramid(pyramid, cascades, count, params);
+	ccv_pyramid_free(pyramid);
+	return result_seq;
+}
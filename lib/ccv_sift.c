@@ -31,6 +31,14 @@
 
 #include "ccv.h"
 #include "ccv_internal.h"
+#if defined(HAVE_SSE2)
+#include <xmmintrin.h>
+#elif defined(HAVE_NEON)
+#include <arm_neon.h>
+#endif
+#include <float.h>
+#include <limits.h>
+#include "3rdparty/dsfmt/dSFMT.h"
 
 const ccv_sift_param_t ccv_sift_default_params = {
 	.noctaves = 3,
@@ -487,3 +495,496 @@ void ccv_sift(ccv_dense_matrix_t* a, ccv_array_t** _keypoints, ccv_dense_matrix_
 		ccv_matrix_free(md[i]);
 	}
 }
+
+/* randomized k-d forest, as described in:
+ * Optimised KD-trees for fast image descriptor matching, Chanop Silpa-Anan and Richard Hartley
+ * Fast Approximate Nearest Neighbors with Automatic Algorithm Configuration, Marius Muja and David G. Lowe */
+
+const ccv_sift_match_param_t ccv_sift_match_default_params = {
+	.checks = 128,
+	.ratio = 0.36,
+};
+
+#define CCV_SIFT_INDEX_SAMPLE_SIZE (100)
+#define CCV_SIFT_INDEX_RANDOM_DIM (5)
+
+static inline float _ccv_sift_index_distance(const float* a, const float* b, int cols)
+{
+	int i = 0;
+	float d = 0;
+#if defined(HAVE_SSE2)
+	__m128 sum4 = _mm_setzero_ps();
+	for (; i < cols - 3; i += 4)
+	{
+		__m128 x4 = _mm_sub_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i));
+		sum4 = _mm_add_ps(sum4, _mm_mul_ps(x4, x4));
+	}
+	float sum[4];
+	_mm_storeu_ps(sum, sum4);
+	d = sum[0] + sum[1] + sum[2] + sum[3];
+#elif defined(HAVE_NEON)
+	float32x4_t sum4 = vdupq_n_f32(0);
+	for (; i < cols - 3; i += 4)
+	{
+		float32x4_t x4 = vsubq_f32(vld1q_f32(a + i), vld1q_f32(b + i));
+		sum4 = vmlaq_f32(sum4, x4, x4);
+	}
+	float sum[4];
+	vst1q_f32(sum, sum4);
+	d = sum[0] + sum[1] + sum[2] + sum[3];
+#endif
+	for (; i < cols; i++)
+		d += (a[i] - b[i]) * (a[i] - b[i]);
+	return d;
+}
+
+static void _ccv_sift_index_copy_desc(ccv_dense_matrix_t* desc, float* data)
+{
+	int i, j;
+	unsigned char* m_ptr = desc->data.u8;
+#define for_block(_, _for_get) \
+	for (i = 0; i < desc->rows; i++) \
+	{ \
+		for (j = 0; j < desc->cols; j++) \
+			data[j] = _for_get(m_ptr, j, 0); \
+		data += desc->cols; \
+		m_ptr += desc->step; \
+	}
+	ccv_matrix_getter(desc->type, for_block);
+#undef for_block
+}
+
+typedef struct {
+	int node;
+	int start;
+	int count;
+} ccv_sift_index_split_t;
+
+static void _ccv_sift_index_build_tree(ccv_sift_index_t* index, ccv_sift_index_node_t* nodes, int* perm, dsfmt_t* dsfmt)
+{
+	int i, j, k;
+	const int cols = index->cols;
+	const float* data = index->data;
+	double* mean = (double*)ccmalloc(sizeof(double) * cols * 2);
+	double* var = mean + cols;
+	ccv_array_t* stack = ccv_array_new(sizeof(ccv_sift_index_split_t), 64, 0);
+	ccv_sift_index_split_t split = {
+		.node = 0,
+		.start = 0,
+		.count = index->rows,
+	};
+	ccv_array_push(stack, &split);
+	int next = 1;
+	while (stack->rnum > 0)
+	{
+		split = *(ccv_sift_index_split_t*)ccv_array_get(stack, stack->rnum - 1);
+		--stack->rnum;
+		ccv_sift_index_node_t* node = nodes + split.node;
+		int* idx = perm + split.start;
+		if (split.count == 1)
+		{
+			node->dim = -1;
+			node->value = 0;
+			node->left = idx[0];
+			node->right = -1;
+			continue;
+		}
+		// mean and variance on a sample, the permutation is already random
+		int sample = ccv_min(split.count, CCV_SIFT_INDEX_SAMPLE_SIZE);
+		memset(mean, 0, sizeof(double) * cols * 2);
+		for (i = 0; i < sample; i++)
+		{
+			const float* x = data + (size_t)idx[i] * cols;
+			for (j = 0; j < cols; j++)
+				mean[j] += x[j];
+		}
+		for (j = 0; j < cols; j++)
+			mean[j] /= sample;
+		for (i = 0; i < sample; i++)
+		{
+			const float* x = data + (size_t)idx[i] * cols;
+			for (j = 0; j < cols; j++)
+				var[j] += (x[j] - mean[j]) * (x[j] - mean[j]);
+		}
+		// pick one of the dimensions with the highest variance at random
+		int top[CCV_SIFT_INDEX_RANDOM_DIM];
+		int top_count = 0;
+		for (j = 0; j < cols; j++)
+			if (top_count < CCV_SIFT_INDEX_RANDOM_DIM || var[j] > var[top[top_count - 1]])
+			{
+				if (top_count < CCV_SIFT_INDEX_RANDOM_DIM)
+					++top_count;
+				for (k = top_count - 1; k > 0 && var[j] > var[top[k - 1]]; k--)
+					top[k] = top[k - 1];
+				top[k] = j;
+			}
+		int dim = top[dsfmt_genrand_uint32(dsfmt) % top_count];
+		float value = mean[dim];
+		// partition to < value, == value and > value, and split somewhere in the middle
+		int lim1 = 0, lim2;
+		for (i = 0; i < split.count; i++)
+			if (data[(size_t)idx[i] * cols + dim] < value)
+			{
+				CCV_SWAP(idx[i], idx[lim1], k);
+				++lim1;
+			}
+		lim2 = lim1;
+		for (i = lim1; i < split.count; i++)
+			if (data[(size_t)idx[i] * cols + dim] <= value)
+			{
+				CCV_SWAP(idx[i], idx[lim2], k);
+				++lim2;
+			}
+		int middle;
+		if (lim1 > split.count / 2)
+			middle = lim1;
+		else if (lim2 < split.count / 2)
+			middle = lim2;
+		else
+			middle = split.count / 2;
+		// degenerated cases (all the same), splitting in half still keeps the tree 2 * rows - 1 nodes
+		if (middle == 0 || middle == split.count)
+			middle = split.count / 2;
+		node->dim = dim;
+		node->value = value;
+		node->left = next;
+		node->right = next + 1;
+		ccv_sift_index_split_t left = {
+			.node = next,
+			.start = split.start,
+			.count = middle,
+		};
+		ccv_sift_index_split_t right = {
+			.node = next + 1,
+			.start = split.start + middle,
+			.count = split.count - middle,
+		};
+		next += 2;
+		ccv_array_push(stack, &right);
+		ccv_array_push(stack, &left);
+	}
+	assert(next == index->rows * 2 - 1);
+	ccv_array_free(stack);
+	ccfree(mean);
+}
+
+static ccv_sift_index_t* _ccv_sift_index_new(int rows, int cols, int trees)
+{
+	ccv_sift_index_t* index = (ccv_sift_index_t*)ccmalloc(sizeof(ccv_sift_index_t) + sizeof(ccv_sift_index_node_t) * (size_t)(rows * 2 - 1) * trees + sizeof(float) * (size_t)rows * cols);
+	index->rows = rows;
+	index->cols = cols;
+	index->trees = trees;
+	index->nodes = (ccv_sift_index_node_t*)(index + 1);
+	index->data = (float*)(index->nodes + (size_t)(rows * 2 - 1) * trees);
+	return index;
+}
+
+ccv_sift_index_t* ccv_sift_index_new(ccv_dense_matrix_t* desc, int trees)
+{
+	assert(desc->rows > 0 && trees > 0);
+	assert(CCV_GET_CHANNEL(desc->type) == CCV_C1);
+	ccv_sift_index_t* index = _ccv_sift_index_new(desc->rows, desc->cols, trees);
+	_ccv_sift_index_copy_desc(desc, index->data);
+	int* perm = (int*)ccmalloc(sizeof(int) * desc->rows);
+	dsfmt_t dsfmt;
+	dsfmt_init_gen_rand(&dsfmt, (uint32_t)desc->rows);
+	int i, j, k, t;
+	for (i = 0; i < desc->rows; i++)
+		perm[i] = i;
+	for (t = 0; t < trees; t++)
+	{
+		for (i = desc->rows - 1; i > 0; i--)
+		{
+			j = dsfmt_genrand_uint32(&dsfmt) % (i + 1);
+			CCV_SWAP(perm[i], perm[j], k);
+		}
+		_ccv_sift_index_build_tree(index, index->nodes + (size_t)(desc->rows * 2 - 1) * t, perm, &dsfmt);
+	}
+	ccfree(perm);
+	return index;
+}
+
+typedef struct {
+	float distance;
+	int node;
+} ccv_sift_index_branch_t;
+
+typedef struct {
+	ccv_sift_index_branch_t* heap;
+	int size;
+	int rnum;
+	float distance[2];
+	int index[2];
+	int checks;
+} ccv_sift_index_search_t;
+
+static void _ccv_sift_index_push_branch(ccv_sift_index_search_t* search, int node, float distance)
+{
+	if (search->rnum == search->size)
+	{
+		search->size = search->size * 2;
+		search->heap = (ccv_sift_index_branch_t*)ccrealloc(search->heap, sizeof(ccv_sift_index_branch_t) * search->size);
+	}
+	int i = search->rnum++;
+	// sift up
+	while (i > 0 && search->heap[(i - 1) >> 1].distance > distance)
+	{
+		search->heap[i] = search->heap[(i - 1) >> 1];
+		i = (i - 1) >> 1;
+	}
+	search->heap[i].distance = distance;
+	search->heap[i].node = node;
+}
+
+static ccv_sift_index_branch_t _ccv_sift_index_pop_branch(ccv_sift_index_search_t* search)
+{
+	ccv_sift_index_branch_t top = search->heap[0];
+	ccv_sift_index_branch_t last = search->heap[--search->rnum];
+	int i = 0;
+	// sift down
+	for (;;)
+	{
+		int c = i * 2 + 1;
+		if (c >= search->rnum)
+			break;
+		if (c + 1 < search->rnum && search->heap[c + 1].distance < search->heap[c].distance)
+			++c;
+		if (search->heap[c].distance >= last.distance)
+			break;
+		search->heap[i] = search->heap[c];
+		i = c;
+	}
+	search->heap[i] = last;
+	return top;
+}
+
+static inline void _ccv_sift_index_check(ccv_sift_index_search_t* search, int index, float distance)
+{
+	if (distance < search->distance[0])
+	{
+		search->distance[1] = search->distance[0];
+		search->index[1] = search->index[0];
+		search->distance[0] = distance;
+		search->index[0] = index;
+	} else if (distance < search->distance[1]) {
+		search->distance[1] = distance;
+		search->index[1] = index;
+	}
+}
+
+static void _ccv_sift_index_descend(ccv_sift_index_t* index, ccv_sift_index_node_t* nodes, int node, float distance, const float* query, ccv_sift_index_search_t* search)
+{
+	while (nodes[node].dim >= 0)
+	{
+		float diff = query[nodes[node].dim] - nodes[node].value;
+		int near = diff < 0 ? nodes[node].left : nodes[node].right;
+		int far = diff < 0 ? nodes[node].right : nodes[node].left;
+		// the lower bound of the other side is approximated by accumulating along the path
+		float far_distance = distance + diff * diff;
+		if (far_distance < search->distance[1])
+			_ccv_sift_index_push_branch(search, (int)(nodes + far - index->nodes), far_distance);
+		node = near;
+	}
+	int i = nodes[node].left;
+	// the same descriptor can be reached from different trees
+	if (i == search->index[0] || i == search->index[1])
+		return;
+	++search->checks;
+	_ccv_sift_index_check(search, i, _ccv_sift_index_distance(query, index->data + (size_t)i * index->cols, index->cols));
+}
+
+static void _ccv_sift_index_search(ccv_sift_index_t* index, const float* query, ccv_sift_index_search_t* search, int checks)
+{
+	search->distance[0] = search->distance[1] = FLT_MAX;
+	search->index[0] = search->index[1] = -1;
+	search->checks = 0;
+	int i;
+	if (checks <= 0 || checks >= index->rows)
+	{
+		for (i = 0; i < index->rows; i++)
+			_ccv_sift_index_check(search, i, _ccv_sift_index_distance(query, index->data + (size_t)i * index->cols, index->cols));
+		return;
+	}
+	search->rnum = 0;
+	const size_t tree_size = (size_t)index->rows * 2 - 1;
+	for (i = 0; i < index->trees; i++)
+		_ccv_sift_index_descend(index, index->nodes + tree_size * i, 0, 0, query, search);
+	while (search->rnum > 0 && search->checks < checks)
+	{
+		ccv_sift_index_branch_t branch = _ccv_sift_index_pop_branch(search);
+		// the closest branch is already too far away
+		if (branch.distance >= search->distance[1])
+			break;
+		// branch.node is counted from the first tree, locate its own tree
+		ccv_sift_index_node_t* nodes = index->nodes + tree_size * (branch.node / tree_size);
+		_ccv_sift_index_descend(index, nodes, (int)(branch.node % tree_size), branch.distance, query, search);
+	}
+}
+
+ccv_array_t* ccv_sift_index_match(ccv_sift_index_t* index, ccv_dense_matrix_t* desc, ccv_sift_match_param_t params)
+{
+	assert(desc->cols == index->cols && CCV_GET_CHANNEL(desc->type) == CCV_C1);
+	float* query = (float*)ccmalloc(sizeof(float) * desc->rows * desc->cols);
+	_ccv_sift_index_copy_desc(desc, query);
+	ccv_sift_match_t* matches = (ccv_sift_match_t*)ccmalloc(sizeof(ccv_sift_match_t) * desc->rows);
+	parallel_for(i, desc->rows) {
+		ccv_sift_index_search_t search = {
+			.size = 64,
+		};
+		search.heap = (ccv_sift_index_branch_t*)ccmalloc(sizeof(ccv_sift_index_branch_t) * search.size);
+		_ccv_sift_index_search(index, query + (size_t)i * index->cols, &search, params.checks);
+		matches[i].query = i;
+		matches[i].index = (search.index[0] >= 0 && search.distance[0] < params.ratio * search.distance[1]) ? search.index[0] : -1;
+		matches[i].distance = search.distance[0];
+		ccfree(search.heap);
+	} parallel_endfor
+	ccv_array_t* seq = ccv_array_new(sizeof(ccv_sift_match_t), 64, 0);
+	int i;
+	for (i = 0; i < desc->rows; i++)
+		if (matches[i].index >= 0)
+			ccv_array_push(seq, matches + i);
+	ccfree(matches);
+	ccfree(query);
+	return seq;
+}
+
+/* The file is in fixed-width little-endian fields, thus, it can be read on a machine with different endianness or
+ * struct padding: rows, cols and trees as 32-bit integers, then dim, value, left and right of each node as 32-bit
+ * fields, and the descriptors as 32-bit floats. */
+static inline void _ccv_sift_index_put_u32(unsigned char* buf, uint32_t v)
+{
+	buf[0] = v & 0xff;
+	buf[1] = (v >> 8) & 0xff;
+	buf[2] = (v >> 16) & 0xff;
+	buf[3] = (v >> 24) & 0xff;
+}
+
+static inline uint32_t _ccv_sift_index_get_u32(const unsigned char* buf)
+{
+	return (uint32_t)buf[0] | ((uint32_t)buf[1] << 8) | ((uint32_t)buf[2] << 16) | ((uint32_t)buf[3] << 24);
+}
+
+static inline uint32_t _ccv_sift_index_f32_to_u32(float f)
+{
+	uint32_t v;
+	memcpy(&v, &f, sizeof(v));
+	return v;
+}
+
+static inline float _ccv_sift_index_u32_to_f32(uint32_t v)
+{
+	float f;
+	memcpy(&f, &v, sizeof(f));
+	return f;
+}
+
+void ccv_sift_index_write(ccv_sift_index_t* index, const char* filename)
+{
+	FILE* w = fopen(filename, "wb");
+	if (w == 0)
+		return;
+	const size_t tree_size = (size_t)index->rows * 2 - 1;
+	// one tree or one descriptor is converted at a time
+	unsigned char* buf = (unsigned char*)ccmalloc(ccv_max(tree_size * 16, (size_t)index->cols * 4));
+	_ccv_sift_index_put_u32(buf, (uint32_t)index->rows);
+	_ccv_sift_index_put_u32(buf + 4, (uint32_t)index->cols);
+	_ccv_sift_index_put_u32(buf + 8, (uint32_t)index->trees);
+	fwrite(buf, 1, 12, w);
+	size_t i;
+	int t;
+	for (t = 0; t < index->trees; t++)
+	{
+		const ccv_sift_index_node_t* nodes = index->nodes + tree_size * t;
+		for (i = 0; i < tree_size; i++)
+		{
+			_ccv_sift_index_put_u32(buf + i * 16, (uint32_t)nodes[i].dim);
+			_ccv_sift_index_put_u32(buf + i * 16 + 4, _ccv_sift_index_f32_to_u32(nodes[i].value));
+			_ccv_sift_index_put_u32(buf + i * 16 + 8, (uint32_t)nodes[i].left);
+			_ccv_sift_index_put_u32(buf + i * 16 + 12, (uint32_t)nodes[i].right);
+		}
+		fwrite(buf, 1, tree_size * 16, w);
+	}
+	for (t = 0; t < index->rows; t++)
+	{
+		const float* data = index->data + (size_t)t * index->cols;
+		for (i = 0; i < index->cols; i++)
+			_ccv_sift_index_put_u32(buf + i * 4, _ccv_sift_index_f32_to_u32(data[i]));
+		fwrite(buf, 1, (size_t)index->cols * 4, w);
+	}
+	ccfree(buf);
+	fclose(w);
+}
+
+ccv_sift_index_t* ccv_sift_index_read(const char* filename)
+{
+	FILE* r = fopen(filename, "rb");
+	if (r == 0)
+		return 0;
+	unsigned char header[12];
+	if (fread(header, 1, 12, r) != 12)
+	{
+		fclose(r);
+		return 0;
+	}
+	int rows = (int)_ccv_sift_index_get_u32(header);
+	int cols = (int)_ccv_sift_index_get_u32(header + 4);
+	int trees = (int)_ccv_sift_index_get_u32(header + 8);
+	if (rows <= 0 || rows > INT_MAX / 2 || cols <= 0 || trees <= 0)
+	{
+		fclose(r);
+		return 0;
+	}
+	ccv_sift_index_t* index = _ccv_sift_index_new(rows, cols, trees);
+	const size_t tree_size = (size_t)rows * 2 - 1;
+	unsigned char* buf = (unsigned char*)ccmalloc(ccv_max(tree_size * 16, (size_t)cols * 4));
+	size_t i;
+	int t;
+	for (t = 0; index && t < trees; t++)
+	{
+		if (fread(buf, 1, tree_size * 16, r) != tree_size * 16)
+		{
+			ccfree(index);
+			index = 0;
+			break;
+		}
+		ccv_sift_index_node_t* nodes = index->nodes + tree_size * t;
+		for (i = 0; i < tree_size; i++)
+		{
+			nodes[i].dim = (int32_t)_ccv_sift_index_get_u32(buf + i * 16);
+			nodes[i].value = _ccv_sift_index_u32_to_f32(_ccv_sift_index_get_u32(buf + i * 16 + 4));
+			nodes[i].left = (int32_t)_ccv_sift_index_get_u32(buf + i * 16 + 8);
+			nodes[i].right = (int32_t)_ccv_sift_index_get_u32(buf + i * 16 + 12);
+			// the search trusts these without checking, thus, a split has to be on a dimension of the descriptor and
+			// point to children after itself (no cycle) in the same tree, and a leaf has to point to a descriptor
+			if (nodes[i].dim >= 0 ?
+				(nodes[i].dim >= cols || nodes[i].left <= (int)i || nodes[i].left >= tree_size || nodes[i].right <= (int)i || nodes[i].right >= tree_size) :
+				(nodes[i].dim != -1 || nodes[i].left < 0 || nodes[i].left >= rows))
+				break;
+		}
+		if (i < tree_size)
+		{
+			ccfree(index);
+			index = 0;
+		}
+	}
+	for (t = 0; index && t < rows; t++)
+	{
+		if (fread(buf, 1, (size_t)cols * 4, r) != (size_t)cols * 4)
+		{
+			ccfree(index);
+			index = 0;
+			break;
+		}
+		float* data = index->data + (size_t)t * cols;
+		for (i = 0; i < cols; i++)
+			data[i] = _ccv_sift_index_u32_to_f32(_ccv_sift_index_get_u32(buf + i * 4));
+	}
+	ccfree(buf);
+	fclose(r);
+	return index;
+}
+
+void ccv_sift_index_free(ccv_sift_index_t* index)
+{
+	ccfree(index);
+}
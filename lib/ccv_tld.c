@@ -35,10 +35,12 @@ const ccv_tld_param_t ccv_tld_default_params = {
 	.track_deform_scale = 0.02,
 	.new_deform_shift = 0.02,
 	.track_deform_shift = 0.02,
+	.search_region = 0,
 };
 
 #define TLD_GRID_SPARSITY (10)
 #define TLD_PATCH_SIZE (10)
+#define TLD_SCAN_BAND (1024)
 
 static CCV_IMPLEMENT_MEDIAN(_ccv_tld_median, float)
 
@@ -469,6 +471,49 @@ static double _ccv_tld_box_variance(ccv_dense_matrix_t* sat, ccv_dense_matrix_t*
 	return variance;
 }
 
+// computes the integral image and the squared integral image in one pass, it is
+// equivalent to ccv_sat on a and on a * a, but reuses sat / sqsat if they are supplied
+static void _ccv_tld_integral(ccv_dense_matrix_t* a, ccv_dense_matrix_t** sat, ccv_dense_matrix_t** sqsat)
+{
+	assert(CCV_GET_DATA_TYPE(a->type) == CCV_8U && CCV_GET_CHANNEL(a->type) == CCV_C1);
+	assert(a->rows * a->cols < 0x808080); // otherwise the integral image cannot fit in 32-bit
+	ccv_dense_matrix_t* db = *sat = ccv_dense_matrix_renew(*sat, a->rows, a->cols, CCV_32S | CCV_C1, CCV_32S | CCV_C1, 0);
+	ccv_dense_matrix_t* dc = *sqsat = ccv_dense_matrix_renew(*sqsat, a->rows, a->cols, CCV_64S | CCV_C1, CCV_64S | CCV_C1, 0);
+	int i, j;
+	unsigned char* a_ptr = a->data.u8;
+	int* b_ptr = db->data.i32;
+	int64_t* c_ptr = dc->data.i64;
+	int sum = 0;
+	int64_t sqsum = 0;
+	for (j = 0; j < a->cols; j++)
+	{
+		sum += a_ptr[j];
+		sqsum += a_ptr[j] * a_ptr[j];
+		b_ptr[j] = sum;
+		c_ptr[j] = sqsum;
+	}
+	for (i = 1; i < a->rows; i++)
+	{
+		a_ptr += a->step;
+		b_ptr += db->cols;
+		c_ptr += dc->cols;
+		sum = 0;
+		sqsum = 0;
+		for (j = 0; j < a->cols; j++)
+		{
+			sum += a_ptr[j];
+			sqsum += a_ptr[j] * a_ptr[j];
+			b_ptr[j] = b_ptr[j - db->cols] + sum;
+			c_ptr[j] = c_ptr[j - dc->cols] + sqsum;
+		}
+	}
+}
+
+static inline int _ccv_tld_rect_within(ccv_rect_t r, ccv_rect_t region)
+{
+	return r.x >= region.x && r.y >= region.y && r.x + r.width <= region.x + region.width && r.y + r.height <= region.y + region.height;
+}
+
 static float _ccv_tld_sv_classify(ccv_tld_t* tld, ccv_dense_matrix_t* a, int pnum, int nnum, int* anyp, int* anyn)
 {
 	assert(a->rows == tld->patch.height && a->cols == tld->patch.width);
@@ -553,6 +598,7 @@ static void _ccv_tld_check_params(ccv_tld_param_t params)
 	assert(params.new_deform_shift > 0);
 	assert(params.track_deform_shift > 0);
 	assert(params.rotation >= 0);
+	assert(params.search_region >= 0);
 }
 
 static float _ccv_tld_ferns_compute_threshold(ccv_ferns_t* ferns, float ferns_thres, ccv_dense_matrix_t* ga, ccv_dense_matrix_t* sat, ccv_dense_matrix_t* sqsat, double var_thres, ccv_array_t* bad, int starter)
@@ -612,6 +658,15 @@ ccv_tld_t* ccv_tld_new(ccv_dense_matrix_t* a, ccv_rect_t box, ccv_tld_param_t pa
 	tld->sfmt = ccmalloc(sizeof(sfmt_t));
 	tld->dsfmt = ccmalloc(sizeof(dsfmt_t));
 	tld->box.rect = box;
+	tld->windows = ccv_array_new(sizeof(ccv_comp_t), best_box.neighbors, 0);
+	int i = 0;
+	for_each_box(comp, patch.width, patch.height, params.interval, params.shift, a->cols, a->rows)
+		comp.neighbors = i++;
+		ccv_array_push(tld->windows, &comp);
+	end_for_each_box;
+	assert(i == best_box.neighbors);
+	tld->scan = ccv_rect(0, 0, a->cols, a->rows);
+	tld->gb = tld->sat = tld->sqsat = 0;
 	{
 	double scale = pow(2.0, 1.0 / (params.interval + 1.0));
 	int scale_upto = (int)(log((double)ccv_min((double)a->cols / patch.width, (double)a->rows / patch.height)) / log(scale));
@@ -629,7 +684,7 @@ ccv_tld_t* ccv_tld_new(ccv_dense_matrix_t* a, ccv_rect_t box, ccv_tld_param_t pa
 	sfmt_init_gen_rand(sfmt, (uint32_t)a);
 	sfmt_genrand_shuffle(sfmt, ccv_array_get(bad, 0), bad->rnum, bad->rsize);
 	int badex = (bad->rnum + 1) / 2;
-	int i, j, k = good->rnum;
+	int j, k = good->rnum;
 	// inflate good so that it can be used many times for the deformation
 	for (i = 0; i < params.new_deform; i++)
 		for (j = 0; j < k; j++)
@@ -644,19 +699,15 @@ ccv_tld_t* ccv_tld_new(ccv_dense_matrix_t* a, ccv_rect_t box, ccv_tld_param_t pa
 		idx[i] = i;
 	sfmt_genrand_shuffle(sfmt, idx, badex + good->rnum, sizeof(int));
 	// train the fern classifier
-	ccv_dense_matrix_t* ga = 0;
-	ccv_blur(a, &ga, 0, 1.5);
+	ccv_blur(a, &tld->gb, 0, 1.5);
+	ccv_dense_matrix_t* ga = tld->gb;
 	ccv_dense_matrix_t* b = 0;
 	_ccv_tld_fetch_patch(tld, ga, &b, 0, best_box.rect);
 	tld->var_thres = ccv_variance(b) * 0.5;
 	ccv_array_push(tld->sv[1], &b);
-	ccv_dense_matrix_t* sat = 0;
-	ccv_sat(a, &sat, 0, CCV_NO_PADDING);
-	ccv_dense_matrix_t* sq = 0;
-	ccv_multiply(a, a, (ccv_matrix_t**)&sq, 0);
-	ccv_dense_matrix_t* sqsat = 0;
-	ccv_sat(sq, &sqsat, 0, CCV_NO_PADDING);
-	ccv_matrix_free(sq);
+	_ccv_tld_integral(a, &tld->sat, &tld->sqsat);
+	ccv_dense_matrix_t* sat = tld->sat;
+	ccv_dense_matrix_t* sqsat = tld->sqsat;
 	dsfmt_t* dsfmt = (dsfmt_t*)tld->dsfmt;
 	dsfmt_init_gen_rand(dsfmt, (uint32_t)tld);
 	{ // save stack fr alloca
@@ -705,9 +756,6 @@ ccv_tld_t* ccv_tld_new(ccv_dense_matrix_t* a, ccv_rect_t box, ccv_tld_param_t pa
 	}
 	tld->nnc_thres = _ccv_tld_nnc_compute_threshold(tld, tld->params.nnc_thres, ga, sat, sqsat, tld->var_thres * 0.5, bad, badex);
 	tld->nnc_thres = ccv_min(tld->nnc_thres, params.nnc_beyond);
-	ccv_matrix_free(sqsat);
-	ccv_matrix_free(sat);
-	ccv_matrix_free(ga);
 	ccv_array_free(bad);
 	// init tld params
 	tld->found = 1; // assume last time has found (we just started)
@@ -771,7 +819,9 @@ static int _ccv_tld_quick_learn(ccv_tld_t* tld, ccv_dense_matrix_t* ga, ccv_dens
 					if (i == 0)
 					{
 						assert(box->neighbors >= 0 && box->neighbors < best_box.neighbors);
+						// only windows evaluated by long-term detection have their ferns in fern_buffer
 						if (box->neighbors % r1 == r0 &&
+							_ccv_tld_rect_within(box->rect, tld->scan) &&
 							_ccv_tld_box_variance(sat, sqsat, box->rect) > tld->var_thres)
 						{
 							// put them in order for faster access the next round
@@ -828,34 +878,57 @@ static int _ccv_tld_quick_learn(ccv_tld_t* tld, ccv_dense_matrix_t* ga, ccv_dens
 
 static ccv_array_t* _ccv_tld_long_term_detect(ccv_tld_t* tld, ccv_dense_matrix_t* ga, ccv_dense_matrix_t* sat, ccv_dense_matrix_t* sqsat, ccv_tld_info_t* info)
 {
-	int i = 0, r0 = tld->count % (tld->params.rotation + 1), r1 = tld->params.rotation + 1;
+	int i, r0 = tld->count % (tld->params.rotation + 1), r1 = tld->params.rotation + 1;
 	tld->top->rnum = 0;
-	uint32_t* fern = tld->fern_buffer;
-	for_each_box(box, tld->patch.width, tld->patch.height, tld->params.interval, tld->params.shift, ga->cols, ga->rows)
-		if (i % r1 == r0 &&
-			_ccv_tld_box_variance(sat, sqsat, box.rect) > tld->var_thres)
+	tld->scan = ccv_rect(0, 0, ga->cols, ga->rows);
+	if (tld->params.search_region > 0 && tld->found && tld->verified)
+	{
+		// only look around the last verified box
+		ccv_rect_t box = tld->box.rect;
+		int x = ccv_max(0, (int)(box.x - box.width * tld->params.search_region + 0.5));
+		int y = ccv_max(0, (int)(box.y - box.height * tld->params.search_region + 0.5));
+		int width = ccv_min(ga->cols, (int)(box.x + box.width * (1 + tld->params.search_region) + 0.5)) - x;
+		int height = ccv_min(ga->rows, (int)(box.y + box.height * (1 + tld->params.search_region) + 0.5)) - y;
+		tld->scan = ccv_rect(x, y, width, height);
+	}
+	ccv_array_t* windows = tld->windows;
+	// each band of windows writes to its own region of fern_buffer, thus, they can be evaluated in parallel
+	parallel_for(j, (windows->rnum + TLD_SCAN_BAND - 1) / TLD_SCAN_BAND) {
+		int k;
+		for (k = j * TLD_SCAN_BAND; k < ccv_min((j + 1) * TLD_SCAN_BAND, windows->rnum); k++)
+		{
+			ccv_comp_t* box = (ccv_comp_t*)ccv_array_get(windows, k);
+			box->classification.confidence = -FLT_MAX;
+			if (k % r1 == r0 &&
+				_ccv_tld_rect_within(box->rect, tld->scan) &&
+				_ccv_tld_box_variance(sat, sqsat, box->rect) > tld->var_thres)
+			{
+				uint32_t* fern = tld->fern_buffer + k * tld->ferns->structs;
+				_ccv_tld_ferns_feature_for(tld->ferns, ga, *box, fern, 0, 0, 0, 0);
+				box->classification.confidence = ccv_ferns_predict(tld->ferns, fern);
+			}
+		}
+	} parallel_endfor
+	// collect the top matches in the same order as a sequential scan
+	for (i = 0; i < windows->rnum; i++)
+	{
+		ccv_comp_t* box = (ccv_comp_t*)ccv_array_get(windows, i);
+		if (box->classification.confidence > tld->ferns_thres)
 		{
-			_ccv_tld_ferns_feature_for(tld->ferns, ga, box, fern, 0, 0, 0, 0);
-			box.classification.confidence = ccv_ferns_predict(tld->ferns, fern);
-			if (box.classification.confidence > tld->ferns_thres)
+			if (tld->top->rnum < tld->params.top_n)
 			{
-				if (tld->top->rnum < tld->params.top_n)
+				ccv_array_push(tld->top, box);
+				_ccv_tld_box_percolate_up(tld->top, tld->top->rnum - 1);
+			} else {
+				ccv_comp_t* top_box = (ccv_comp_t*)ccv_array_get(tld->top, 0);
+				if (top_box->classification.confidence < box->classification.confidence)
 				{
-					ccv_array_push(tld->top, &box);
-					_ccv_tld_box_percolate_up(tld->top, tld->top->rnum - 1);
-				} else {
-					ccv_comp_t* top_box = (ccv_comp_t*)ccv_array_get(tld->top, 0);
-					if (top_box->classification.confidence < box.classification.confidence)
-					{
-						*(ccv_comp_t*)ccv_array_get(tld->top, 0) = box;
-						_ccv_tld_box_percolate_down(tld->top, 0);
-					}
+					*(ccv_comp_t*)ccv_array_get(tld->top, 0) = *box;
+					_ccv_tld_box_percolate_down(tld->top, 0);
 				}
 			}
 		}
-		fern += tld->ferns->structs;
-		++i;
-	end_for_each_box;
+	}
 	ccv_array_t* seq = ccv_array_new(sizeof(ccv_comp_t), tld->top->rnum, 0);
 	for (i = 0; i < tld->top->rnum; i++)
 	{
@@ -882,6 +955,12 @@ static int _ccv_is_equal(const void* _r1, const void* _r2, void* data)
 	return _ccv_tld_rect_intersect(r1->rect, r2->rect) > 0.5;
 }
 
+// only the rectangles intersect with r can be grouped with r
+static ccv_rect_t _ccv_equal_bound(const void* _r, void* data)
+{
+	return ((const ccv_comp_t*)_r)->rect;
+}
+
 // since there is no refcount syntax for ccv yet, we won't implicitly retain any matrix in ccv_tld_t
 // instead, you should pass the previous frame and the current frame into the track function
 ccv_comp_t ccv_tld_track_object(ccv_tld_t* tld, ccv_dense_matrix_t* a, ccv_dense_matrix_t* b, ccv_tld_info_t* info)
@@ -890,8 +969,8 @@ ccv_comp_t ccv_tld_track_object(ccv_tld_t* tld, ccv_dense_matrix_t* a, ccv_dense
 	int tracked = 0;
 	int verified = 0;
 	assert(tld->frame_signature == a->sig);
-	ccv_dense_matrix_t* gb = 0;
-	ccv_blur(b, &gb, 0, 1.5);
+	ccv_blur(b, &tld->gb, 0, 1.5);
+	ccv_dense_matrix_t* gb = tld->gb;
 	if (info)
 		info->perform_track = tld->found;
 	if (tld->found)
@@ -918,13 +997,9 @@ ccv_comp_t ccv_tld_track_object(ccv_tld_t* tld, ccv_dense_matrix_t* a, ccv_dense
 	}
 	if (info)
 		info->track_success = tracked;
-	ccv_dense_matrix_t* sat = 0;
-	ccv_sat(b, &sat, 0, CCV_NO_PADDING);
-	ccv_dense_matrix_t* sq = 0;
-	ccv_multiply(b, b, (ccv_matrix_t**)&sq, 0);
-	ccv_dense_matrix_t* sqsat = 0;
-	ccv_sat(sq, &sqsat, 0, CCV_NO_PADDING);
-	ccv_matrix_free(sq);
+	_ccv_tld_integral(b, &tld->sat, &tld->sqsat);
+	ccv_dense_matrix_t* sat = tld->sat;
+	ccv_dense_matrix_t* sqsat = tld->sqsat;
 	ccv_array_t* dd = _ccv_tld_long_term_detect(tld, gb, sat, sqsat, info);
 	if (info)
 	{
@@ -937,7 +1012,7 @@ ccv_comp_t ccv_tld_track_object(ccv_tld_t* tld, ccv_dense_matrix_t* a, ccv_dense
 	{
 		ccv_array_t* idx_dd = 0;
 		// group retrieved rectangles in order to filter out noise
-		int ncomp = ccv_array_group(dd, &idx_dd, _ccv_is_equal, 0);
+		int ncomp = ccv_array_group_spatially(dd, &idx_dd, _ccv_is_equal, _ccv_equal_bound, 0);
 		ccv_comp_t* comps = (ccv_comp_t*)ccmalloc(ncomp * sizeof(ccv_comp_t));
 		memset(comps, 0, ncomp * sizeof(ccv_comp_t));
 		for (i = 0; i < dd->rnum; i++)
@@ -1036,9 +1111,6 @@ ccv_comp_t ccv_tld_track_object(ccv_tld_t* tld, ccv_dense_matrix_t* a, ccv_dense
 		info->perform_learn = verified;
 	if (verified)
 		verified = (_ccv_tld_quick_learn(tld, gb, sat, sqsat, result) == 0);
-	ccv_matrix_free(sqsat);
-	ccv_matrix_free(sat);
-	ccv_matrix_free(gb);
 	tld->verified = verified;
 	tld->box = result;
 	tld->frame_signature = b->sig;
@@ -1058,6 +1130,10 @@ void ccv_tld_free(ccv_tld_t* tld)
 		ccv_matrix_free(*(ccv_dense_matrix_t**)ccv_array_get(tld->sv[1], i));
 	ccv_array_free(tld->sv[1]);
 	ccv_array_free(tld->top);
+	ccv_array_free(tld->windows);
+	ccv_matrix_free(tld->gb);
+	ccv_matrix_free(tld->sat);
+	ccv_matrix_free(tld->sqsat);
 	ccv_ferns_free(tld->ferns);
 	ccfree(tld);
 }
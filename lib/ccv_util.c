@@ -1691,6 +1691,47 @@ typedef struct ccv_ptree_node_t
 	int rank;
 } ccv_ptree_node_t;
 
+static ccv_ptree_node_t* _ccv_ptree_root(ccv_ptree_node_t* node)
+{
+	ccv_ptree_node_t* root = node;
+	while (root->parent)
+		root = root->parent;
+	/* compress path from node to the root: */
+	while (node->parent)
+	{
+		ccv_ptree_node_t* temp = node;
+		node = node->parent;
+		temp->parent = root;
+	}
+	return root;
+}
+
+static int _ccv_ptree_index(ccv_ptree_node_t* node, int rnum, ccv_array_t** index)
+{
+	if (*index == 0)
+		*index = ccv_array_new(sizeof(int), rnum, 0);
+	else
+		ccv_array_clear(*index);
+	ccv_array_t* idx = *index;
+
+	int i, j, class_idx = 0;
+	for(i = 0; i < rnum; i++)
+	{
+		j = -1;
+		ccv_ptree_node_t* node1 = node + i;
+		if(node1->element)
+		{
+			while(node1->parent)
+				node1 = node1->parent;
+			if(node1->rank >= 0)
+				node1->rank = ~class_idx++;
+			j = ~node1->rank;
+		}
+		ccv_array_push(idx, &j);
+	}
+	return class_idx;
+}
+
 /* the code for grouping array is adopted from OpenCV's cvSeqPartition func, it is essentially a find-union algorithm */
 int ccv_array_group(ccv_array_t* array, ccv_array_t** index, ccv_array_group_f gfunc, void* data)
 {
@@ -1750,27 +1791,122 @@ int ccv_array_group(ccv_array_t* array, ccv_array_t** index, ccv_array_group_f g
 			}
 		}
 	}
-	if (*index == 0)
-		*index = ccv_array_new(sizeof(int), array->rnum, 0);
-	else
-		ccv_array_clear(*index);
-	ccv_array_t* idx = *index;
+	int class_idx = _ccv_ptree_index(node, array->rnum, index);
+	ccfree(node);
+	return class_idx;
+}
+
+typedef struct {
+	int64_t cell;
+	int idx;
+} ccv_array_cell_t;
 
-	int class_idx = 0;
-	for(i = 0; i < array->rnum; i++)
+#define less_than(c1, c2, aux) ((c1).cell < (c2).cell || ((c1).cell == (c2).cell && (c1).idx < (c2).idx))
+static CCV_IMPLEMENT_QSORT(_ccv_array_cell_qsort, ccv_array_cell_t, less_than)
+#undef less_than
+
+/* the bounds are put into a uniform grid with the cell size of an average bound, thus, only bounds share a cell are compared */
+void ccv_array_intersect(ccv_array_t* array, ccv_array_bound_f bfunc, ccv_array_intersect_f ifunc, void* data)
+{
+	if (array->rnum < 2)
+		return;
+	int i, j, x, y;
+	ccv_rect_t* bounds = (ccv_rect_t*)ccmalloc(sizeof(ccv_rect_t) * array->rnum);
+	int min_x = INT_MAX, min_y = INT_MAX, max_x = INT_MIN;
+	double size = 0;
+	for (i = 0; i < array->rnum; i++)
 	{
-		j = -1;
-		ccv_ptree_node_t* node1 = node + i;
-		if(node1->element)
-		{
-			while(node1->parent)
-				node1 = node1->parent;
-			if(node1->rank >= 0)
-				node1->rank = ~class_idx++;
-			j = ~node1->rank;
+		ccv_rect_t bound = bfunc(ccv_array_get(array, i), data);
+		bound.width = ccv_max(bound.width, 1);
+		bound.height = ccv_max(bound.height, 1);
+		bounds[i] = bound;
+		min_x = ccv_min(min_x, bound.x);
+		min_y = ccv_min(min_y, bound.y);
+		max_x = ccv_max(max_x, bound.x + bound.width);
+		size += ccv_max(bound.width, bound.height);
+	}
+	int cell = ccv_max(1, (int)(size / array->rnum + 0.5));
+	int64_t cols = (max_x - min_x) / cell + 1;
+	ccv_array_t* cells = ccv_array_new(sizeof(ccv_array_cell_t), array->rnum * 4, 0);
+	for (i = 0; i < array->rnum; i++)
+		for (y = (bounds[i].y - min_y) / cell; y <= (bounds[i].y + bounds[i].height - 1 - min_y) / cell; y++)
+			for (x = (bounds[i].x - min_x) / cell; x <= (bounds[i].x + bounds[i].width - 1 - min_x) / cell; x++)
+			{
+				ccv_array_cell_t c = {
+					.cell = y * cols + x,
+					.idx = i,
+				};
+				ccv_array_push(cells, &c);
+			}
+	ccv_array_cell_t* c = (ccv_array_cell_t*)ccv_array_get(cells, 0);
+	_ccv_array_cell_qsort(c, cells->rnum, 0);
+	for (i = 0; i < cells->rnum; i = j)
+	{
+		for (j = i + 1; j < cells->rnum && c[j].cell == c[i].cell; j++);
+		for (x = i; x < j; x++)
+			for (y = x + 1; y < j; y++)
+			{
+				ccv_rect_t* b1 = bounds + c[x].idx;
+				ccv_rect_t* b2 = bounds + c[y].idx;
+				int ix = ccv_max(b1->x, b2->x);
+				int iy = ccv_max(b1->y, b2->y);
+				if (ix >= ccv_min(b1->x + b1->width, b2->x + b2->width) ||
+					iy >= ccv_min(b1->y + b1->height, b2->y + b2->height))
+					continue;
+				// a pair of bounds can share several cells, only report it in the cell that has the top left corner of their intersection
+				if ((iy - min_y) / cell * cols + (ix - min_x) / cell == c[i].cell)
+					ifunc(c[x].idx, c[y].idx, data);
+			}
+	}
+	ccv_array_free(cells);
+	ccfree(bounds);
+}
+
+typedef struct {
+	ccv_array_t* array;
+	ccv_ptree_node_t* node;
+	ccv_array_group_f gfunc;
+	void* data;
+} ccv_array_group_spatially_t;
+
+static void _ccv_array_group_spatially(int i, int j, void* context)
+{
+	ccv_array_group_spatially_t* group = (ccv_array_group_spatially_t*)context;
+	ccv_ptree_node_t* root = _ccv_ptree_root(group->node + i);
+	ccv_ptree_node_t* root2 = _ccv_ptree_root(group->node + j);
+	// already in the same group, skip the comparisons
+	if (root == root2)
+		return;
+	if (group->gfunc(group->node[i].element, group->node[j].element, group->data) ||
+		group->gfunc(group->node[j].element, group->node[i].element, group->data))
+	{
+		if (root->rank > root2->rank)
+			root2->parent = root;
+		else {
+			root->parent = root2;
+			root2->rank += root->rank == root2->rank;
 		}
-		ccv_array_push(idx, &j);
 	}
+}
+
+int ccv_array_group_spatially(ccv_array_t* array, ccv_array_t** index, ccv_array_group_f gfunc, ccv_array_bound_f bfunc, void* data)
+{
+	int i;
+	ccv_ptree_node_t* node = (ccv_ptree_node_t*)ccmalloc(array->rnum * sizeof(ccv_ptree_node_t));
+	for (i = 0; i < array->rnum; i++)
+	{
+		node[i].parent = 0;
+		node[i].element = ccv_array_get(array, i);
+		node[i].rank = 0;
+	}
+	ccv_array_group_spatially_t group = {
+		.array = array,
+		.node = node,
+		.gfunc = gfunc,
+		.data = data,
+	};
+	ccv_array_intersect(array, bfunc, _ccv_array_group_spatially, &group);
+	int class_idx = _ccv_ptree_index(node, array->rnum, index);
 	ccfree(node);
 	return class_idx;
 }
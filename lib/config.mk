@@ -0,0 +1,12 @@
+CC := gcc
+AR := ar
+NVCC := 
+CUDA_SRCS := 
+CUDA_COMPAT_LIB := 
+CUDA_CMD_LIB := 
+DEFINE_MACROS := -D HAVE_CBLAS -D HAVE_LIBPNG -D HAVE_LIBJPEG -D HAVE_PTHREAD -D HAVE_UCONTEXT -D HAVE_SSE2
+prefix := /usr/local
+exec_prefix := ${prefix}
+CFLAGS :=  -msse2 $(DEFINE_MACROS) -I${prefix}/include
+NVFLAGS := --use_fast_math -arch=sm_30 $(DEFINE_MACROS)
+LDFLAGS :=  -L${exec_prefix}/lib -lm -lopenblas -lrt -lpng -ljpeg -lpthread -lsqlite3
@@ -52,6 +52,8 @@ typedef struct {
 	ccv_nnc_graph_exec_symbol_t* update_execs;
 	ccv_nnc_tensor_t** retain_tensors; // Additional need to retained tensors.
 	ccv_nnc_tensor_t** trainable_tensors;
+	void* checkpoint_map; // The memory-mapped checkpoint tensors are bound to.
+	size_t checkpoint_map_size;
 	ccv_nnc_tensor_symbol_map_t* saved_aux;
 	ccv_nnc_cmd_t minimizer;
 	ccv_nnc_cmd_t loss;
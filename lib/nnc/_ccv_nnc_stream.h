@@ -17,6 +17,12 @@
 
 struct ccv_nnc_stream_signal_s {
 	int type;
+	// A CPU signal is a counter. Emit bumps the emit count at submission time, and the fire count
+	// is updated when the emit is reached on the stream. A wait is satisfied once the fire count
+	// catches up with the emit count observed when the wait is submitted.
+	uint64_t emit_count;
+	uint64_t fire_count;
+	ccv_array_t* waiters; // CPU stream contexts blocked by this signal.
 };
 
 typedef struct ccv_nnc_stream_task_s ccv_nnc_stream_task_t;
@@ -55,12 +61,44 @@ struct ccv_nnc_stream_task_s {
 	ccv_nnc_stream_task_f func;
 };
 
+// The CPU workspace of a stream context. It only grows, to the largest size requested, and is kept across commands
+// until it is trimmed (or drained), thus, we don't allocate (and fault in) the scratch memory for every command.
+typedef struct {
+	size_t size;
+	void* ptr;
+	size_t grow_size; // The largest size requested since the last trim, the workspace grows to it.
+	size_t high_water_mark; // The largest size ever requested.
+	uint64_t request_count;
+	uint64_t alloc_count;
+} ccv_nnc_stream_workspace_t;
+
+// Get at least size of memory from the workspace, reallocate if it is not large enough.
+CCV_WARN_UNUSED(void*) ccv_nnc_stream_workspace_get(ccv_nnc_stream_workspace_t* const workspace, const size_t size);
+// Free the workspace if it is larger than max_size.
+void ccv_nnc_stream_workspace_trim(ccv_nnc_stream_workspace_t* const workspace, const size_t max_size);
+// Free the workspace of a thread local stream context when the calling thread exits.
+void ccv_nnc_stream_workspace_per_thread(ccv_nnc_stream_workspace_t* const workspace);
+
 struct ccv_nnc_stream_context_s {
 	int type;
 	ccv_nnc_stream_task_t* main; // main task.
 	ccv_nnc_stream_scheduler_t* scheduler;
 };
 
+// Whether the stream context is a CPU stream context that will execute commands on the worker pool asynchronously
+// (that is not the case if we are already executing on this stream context).
+CCV_WARN_UNUSED(int) ccv_nnc_stream_context_is_cpu_async(const ccv_nnc_stream_context_t* const stream_context);
+// Submit a command to the worker pool, it will be executed in order on the given CPU stream context.
+void ccv_nnc_stream_cpu_exec(ccv_nnc_stream_context_t* const stream_context, const ccv_nnc_cmd_exec_f func, const ccv_nnc_cmd_t cmd, const ccv_nnc_hint_t hint, const int flags, ccv_nnc_tensor_t* const* const inputs, const int input_size, ccv_nnc_tensor_t* const* const outputs, const int output_size);
+// Wait until the jobs submitted to a CPU stream context are executed, the failure recorded is kept for ccv_nnc_stream_context_wait.
+void ccv_nnc_stream_cpu_wait(ccv_nnc_stream_context_t* const stream_context);
+// Stop the worker threads and free the worker pool, it is started again on the next submission.
+void ccv_nnc_stream_cpu_pool_free(void);
+typedef void (*ccv_nnc_stream_cpu_callback_f)(void* const userdata);
+// Submit a callback to the worker pool, it will be executed in order on the given CPU stream context.
+void ccv_nnc_stream_cpu_add_callback(ccv_nnc_stream_context_t* const stream_context, const ccv_nnc_stream_cpu_callback_f func, void* const userdata);
+// How much workspace a thread keeps after a command executed without a stream context.
+CCV_WARN_UNUSED(size_t) ccv_nnc_stream_workspace_limit(void);
 // Return the scheduler from a stream (if not created, create one).
 CCV_WARN_UNUSED(ccv_nnc_stream_scheduler_t*) ccv_nnc_stream_context_get_scheduler(ccv_nnc_stream_context_t* const stream_context);
 // This method activates the scheduler (if necessary), and runs the given task.
@@ -12,6 +12,7 @@
 
 #include "ccv_nnc.h"
 #include "ccv_nnc_internal.h"
+#include <pthread.h>
 
 typedef struct {
 	// Start for while loop handling
@@ -28,6 +29,7 @@ typedef struct {
 	int inc[CCV_NNC_MAX_DIM_ALLOC];
 	ccv_array_t* s_ref; // Reference to the tensor number in its sub graphs, Starts at 1.
 	char* name;
+	ccv_nnc_tensor_t* constant; // The content of this tensor if it is a constant, always on CPU, owned by the symbolic graph.
 	ccv_nnc_tensor_param_t info;
 } ccv_nnc_tensor_symbol_info_t;
 
@@ -144,6 +146,9 @@ struct ccv_nnc_tensor_arena_s {
 	// ccv_tensor_multiview_t, thus, it is aligned to a 16-byte boundary).
 	ccv_array_t* tensor_metadata;
 	ccv_array_t* m_tensor_idx; // The index into multi-view tensors in tensor_metadata.
+	ccv_array_t* constants; // The copies of constant tensors this arena owns (only on the top-level arena).
+	ccv_array_t** derived; // The data derived from each of these constants, see ccv_nnc_constant_derived.
+	pthread_mutex_t derived_mutex; // Protect the derived data, only initialized if there are constants.
 };
 
 struct ccv_nnc_graph_exec_arena_s {
@@ -199,6 +204,7 @@ void ccv_nnc_symbolic_graph_add_source(ccv_nnc_symbolic_graph_t* const graph, co
 void ccv_nnc_symbolic_graph_add_destination(ccv_nnc_symbolic_graph_t* const graph, const ccv_nnc_graph_exec_symbol_t destination);
 int ccv_nnc_over_tensor_symbol_aliases(const ccv_nnc_tensor_symbol_info_t* const tensor_a, const ccv_nnc_tensor_symbol_info_t* const tensor_b);
 int ccv_nnc_tensor_symbol_map_raw(ccv_nnc_symbolic_graph_t* const graph, const ccv_nnc_tensor_symbol_t symbol);
+void ccv_nnc_tensor_constant_sign(ccv_nnc_tensor_t* const constant);
 
 #endif
 
@@ -2,22 +2,36 @@
 #include "ccv_nnc_easy.h"
 #include "ccv_nnc_internal.h"
 #include "ccv_internal.h"
+#include "_ccv_nnc_stream.h"
 #include "3rdparty/khash/khash.h"
+#include "3rdparty/sfmt/SFMT.h"
+#include <unistd.h>
 
 KHASH_MAP_INIT_INT64(ctx, ccv_array_t*)
 
+// Batches rows of another dataframe, each of its columns is a batch of a column from that dataframe.
+typedef struct {
+	int batch_count;
+	int format;
+	uint32_t seed;
+	int* row_idxs; // The rows of that dataframe in the order to be batched, if they are shuffled.
+	ccv_cnnp_dataframe_t* dataframe;
+	int column_idxs[1];
+} ccv_cnnp_dataframe_batching_t;
+
 struct ccv_cnnp_dataframe_s {
 	int row_size;
 	int column_size;
 	khash_t(ctx)* data_ctx; // The stream context based cache for data entity of columns. This helps us to avoid allocations when iterate through data.
+	pthread_mutex_t mutex; // Rows can be prefetched on the worker pool, this protects the data_ctx.
 	ccv_array_t* derived_column_data;
+	ccv_cnnp_dataframe_batching_t* batching;
 	ccv_cnnp_column_data_t column_data[1];
 };
 
 typedef struct {
 	int column_idx_size;
 	int* column_idxs;
-	void** data;
 	void* context;
 	ccv_cnnp_column_data_deinit_f deinit;
 	ccv_cnnp_column_data_map_f map;
@@ -30,6 +44,7 @@ ccv_cnnp_dataframe_t* ccv_cnnp_dataframe_new(const ccv_cnnp_column_data_t* const
 	dataframe->row_size = row_size;
 	dataframe->column_size = column_size;
 	dataframe->data_ctx = kh_init(ctx);
+	pthread_mutex_init(&dataframe->mutex, 0);
 	memcpy(dataframe->column_data, column_data, sizeof(ccv_cnnp_column_data_t) * column_size);
 	return dataframe;
 }
@@ -45,13 +60,11 @@ int ccv_cnnp_dataframe_map(ccv_cnnp_dataframe_t* const dataframe, ccv_cnnp_colum
 		{ assert(column_idxs[i] < column_size); }
 	ccv_cnnp_derived_column_data_t column_data = {
 		.column_idx_size = column_idx_size,
-		.data = (void*)ccmalloc(sizeof(void*) * column_idx_size + sizeof(int) * column_idx_size),
+		.column_idxs = (int*)ccmalloc(sizeof(int) * column_idx_size),
 		.context = context,
 		.map = map,
 		.deinit = deinit,
 	};
-	memset(column_data.data, 0, sizeof(void*) * column_idx_size);
-	column_data.column_idxs = (int*)(column_data.data + column_idx_size);
 	memcpy(column_data.column_idxs, column_idxs, sizeof(int) * column_idx_size);
 	ccv_array_push(dataframe->derived_column_data, &column_data);
 	return dataframe->column_size + dataframe->derived_column_data->rnum - 1;
@@ -62,12 +75,41 @@ typedef struct {
 	void* data;
 } ccv_cnnp_dataframe_data_item_t;
 
+// A row computed ahead of time.
+typedef struct {
+	int done;
+	int row_idx;
+	uint64_t ctx; // The stream context the data will be reused on.
+	ccv_nnc_stream_context_t* stream_context; // The stream context this row is computed on.
+	ccv_cnnp_dataframe_iter_t* iter;
+	ccv_cnnp_dataframe_data_item_t data[1];
+} ccv_cnnp_dataframe_fetched_row_t;
+
+#define CCV_CNNP_DATAFRAME_MAX_PREFETCH_STREAM_SIZE (16)
+
 struct ccv_cnnp_dataframe_iter_s {
 	int idx;
-	int prefetch_count;
+	int row_size; // How many rows this iterator goes through.
+	int* row_idxs; // The rows in the order to go through, if it is shuffled.
+	int block_size;
+	int shard_idx;
+	int shard_count;
+	uint32_t seed;
+	int prefetch_head; // The first prefetched row in the ring.
+	int prefetch_tail; // How many rows are prefetched.
+	int fetched_size; // The size of the ring.
+	int stream_size;
+	int stream_idx;
 	int column_idx_size;
 	ccv_cnnp_dataframe_t* dataframe;
 	int* column_idxs;
+	ccv_cnnp_dataframe_fetched_row_t** fetched_rows;
+	ccv_nnc_stream_context_t* streams[CCV_CNNP_DATAFRAME_MAX_PREFETCH_STREAM_SIZE]; // The streams to compute rows concurrently on the worker pool.
+	ccv_nnc_stream_signal_t* signal;
+	ccv_nnc_stream_context_t* cached_stream_context; // The stream context the cached data are consumed on.
+	int releasing; // How many rows are waiting on their stream contexts to be returned to the cache.
+	pthread_mutex_t mutex;
+	pthread_cond_t notify;
 	ccv_cnnp_dataframe_data_item_t cached_data[1]; // The data cached when deriving data.
 };
 
@@ -80,9 +122,12 @@ ccv_cnnp_dataframe_iter_t* ccv_cnnp_dataframe_iter_new(ccv_cnnp_dataframe_t* con
 		{ assert(column_idxs[i] < column_size); }
 	ccv_cnnp_dataframe_iter_t* const iter = (ccv_cnnp_dataframe_iter_t*)cccalloc(1, sizeof(ccv_cnnp_dataframe_iter_t) + sizeof(ccv_cnnp_dataframe_data_item_t) * column_size + sizeof(void*) * (column_idx_size - 1) + sizeof(int) * column_idx_size);
 	iter->dataframe = dataframe;
+	iter->row_size = dataframe->row_size;
 	iter->column_idx_size = column_idx_size;
 	iter->column_idxs = (int*)(iter->cached_data + column_size);
 	memcpy(iter->column_idxs, column_idxs, sizeof(int) * column_idx_size);
+	pthread_mutex_init(&iter->mutex, 0);
+	pthread_cond_init(&iter->notify, 0);
 	return iter;
 }
 
@@ -90,6 +135,7 @@ static void _ccv_cnnp_dataframe_enqueue_data(ccv_cnnp_dataframe_t* const datafra
 {
 	khash_t(ctx)* const data_ctx = dataframe->data_ctx;
 	int ret = 0;
+	pthread_mutex_lock(&dataframe->mutex);
 	khiter_t k = kh_put(ctx, data_ctx, ctx, &ret);
 	assert(ret >= 0);
 	const int column_size = dataframe->column_size + (dataframe->derived_column_data ? dataframe->derived_column_data->rnum : 0);
@@ -107,88 +153,359 @@ static void _ccv_cnnp_dataframe_enqueue_data(ccv_cnnp_dataframe_t* const datafra
 		*(ccv_array_t**)ccv_array_get(columns, column_idx) = column;
 	}
 	ccv_array_push(column, &data);
+	pthread_mutex_unlock(&dataframe->mutex);
 }
 
-static void* _ccv_cnnp_dataframe_dequeue_data(ccv_cnnp_dataframe_t* const dataframe, const int column_idx, ccv_nnc_stream_context_t* const stream_context)
+static void* _ccv_cnnp_dataframe_dequeue_data(ccv_cnnp_dataframe_t* const dataframe, const int column_idx, const uint64_t ctx)
 {
-	const uint64_t ctx = (uint64_t)(uintptr_t)stream_context;
 	khash_t(ctx)* const data_ctx = dataframe->data_ctx;
+	void* data = 0;
+	pthread_mutex_lock(&dataframe->mutex);
 	khiter_t k = kh_get(ctx, data_ctx, ctx);
-	if (k == kh_end(data_ctx))
-		return 0;
-	ccv_array_t* const columns = kh_val(data_ctx, k);
-	if (column_idx >= columns->rnum)
-		return 0;
-	ccv_array_t* const column = *(ccv_array_t**)ccv_array_get(columns, column_idx);
-	if (!column || column->rnum == 0)
-		return 0;
-	void* const data = *(void**)ccv_array_get(column, column->rnum - 1);
-	--column->rnum;
+	if (k != kh_end(data_ctx))
+	{
+		ccv_array_t* const columns = kh_val(data_ctx, k);
+		ccv_array_t* const column = column_idx < columns->rnum ? *(ccv_array_t**)ccv_array_get(columns, column_idx) : 0;
+		if (column && column->rnum > 0)
+		{
+			data = *(void**)ccv_array_get(column, column->rnum - 1);
+			--column->rnum;
+		}
+	}
+	pthread_mutex_unlock(&dataframe->mutex);
 	return data;
 }
 
-static void* _ccv_cnnp_dataframe_column_data(ccv_cnnp_dataframe_t* const dataframe, ccv_cnnp_dataframe_data_item_t* const cached_data, const int row_idx, const int column_idx, ccv_nnc_stream_context_t* const stream_context)
+// Data are reused from, and will be returned to the cache of ctx, while computed on the given stream context.
+static void* _ccv_cnnp_dataframe_column_data(ccv_cnnp_dataframe_t* const dataframe, ccv_cnnp_dataframe_data_item_t* const cached_data, const int row_idx, const int column_idx, const uint64_t ctx, ccv_nnc_stream_context_t* const stream_context)
 {
 	if (cached_data[column_idx].data)
 		return cached_data[column_idx].data;
-	void* data = _ccv_cnnp_dataframe_dequeue_data(dataframe, column_idx, stream_context);
+	void* data = _ccv_cnnp_dataframe_dequeue_data(dataframe, column_idx, ctx);
 	if (column_idx >= dataframe->column_size)
 	{
 		const ccv_cnnp_derived_column_data_t* const derived_column_data = (ccv_cnnp_derived_column_data_t*)ccv_array_get(dataframe->derived_column_data, column_idx - dataframe->column_size);
 		const int column_idx_size = derived_column_data->column_idx_size;
+		// Rows can be derived concurrently, thus, the input data cannot be kept on the column.
+		void** const column_data = (void**)alloca(sizeof(void*) * column_idx_size);
 		int i;
 		for (i = 0; i < column_idx_size; i++)
-			derived_column_data->data[i] = _ccv_cnnp_dataframe_column_data(dataframe, cached_data, row_idx, derived_column_data->column_idxs[i], stream_context);
-		derived_column_data->map(derived_column_data->data[i], derived_column_data->column_idx_size, &data, derived_column_data->context, stream_context);
+			column_data[i] = _ccv_cnnp_dataframe_column_data(dataframe, cached_data, row_idx, derived_column_data->column_idxs[i], ctx, stream_context);
+		derived_column_data->map(column_data, column_idx_size, &data, derived_column_data->context, stream_context);
 	} else {
 		const ccv_cnnp_column_data_t* const column_data = dataframe->column_data + column_idx;
 		column_data->data_enum(column_idx, row_idx, 1, &data, column_data->context, stream_context);
 	}
-	cached_data[column_idx].ctx = (uint64_t)(uintptr_t)stream_context;
+	cached_data[column_idx].ctx = ctx;
 	cached_data[column_idx].data = data;
 	return data;
 }
 
-int ccv_cnnp_dataframe_iter_next(ccv_cnnp_dataframe_iter_t* const iter, void** const data_ref, const int column_idx_size, ccv_nnc_stream_context_t* const stream_context)
+static void _ccv_cnnp_dataframe_release_data(ccv_cnnp_dataframe_t* const dataframe, ccv_cnnp_dataframe_data_item_t* const cached_data)
 {
-	ccv_cnnp_dataframe_t* const dataframe = iter->dataframe;
-	assert(column_idx_size <= iter->column_idx_size);
 	const int column_size = dataframe->column_size + (dataframe->derived_column_data ? dataframe->derived_column_data->rnum : 0);
 	int i;
 	// Push existing data back to reusable state (note, these may not be reused immediately because they may be on a different stream context).
 	for (i = 0; i < column_size; i++)
-		if (iter->cached_data[i].data)
+		if (cached_data[i].data)
 		{
-			_ccv_cnnp_dataframe_enqueue_data(dataframe, iter->cached_data[i].data, i, iter->cached_data[i].ctx);
-			iter->cached_data[i].data = 0;
-			iter->cached_data[i].ctx = 0;
+			_ccv_cnnp_dataframe_enqueue_data(dataframe, cached_data[i].data, i, cached_data[i].ctx);
+			cached_data[i].data = 0;
+			cached_data[i].ctx = 0;
 		}
-	const int idx = iter->idx;
-	if (idx == dataframe->row_size)
+}
+
+// Data returned when the stream context they are consumed on is done with them.
+typedef struct {
+	ccv_cnnp_dataframe_iter_t* iter;
+	ccv_cnnp_dataframe_data_item_t data[1];
+} ccv_cnnp_dataframe_released_row_t;
+
+static void _ccv_cnnp_dataframe_release_row(void* const userdata)
+{
+	ccv_cnnp_dataframe_released_row_t* const released_row = (ccv_cnnp_dataframe_released_row_t*)userdata;
+	ccv_cnnp_dataframe_iter_t* const iter = released_row->iter;
+	_ccv_cnnp_dataframe_release_data(iter->dataframe, released_row->data);
+	pthread_mutex_lock(&iter->mutex);
+	--iter->releasing;
+	pthread_cond_broadcast(&iter->notify);
+	pthread_mutex_unlock(&iter->mutex);
+	ccfree(released_row);
+}
+
+static void _ccv_cnnp_dataframe_iter_release_data(ccv_cnnp_dataframe_iter_t* const iter)
+{
+	ccv_cnnp_dataframe_t* const dataframe = iter->dataframe;
+	ccv_nnc_stream_context_t* const stream_context = iter->cached_stream_context;
+	iter->cached_stream_context = 0;
+	if (!ccv_nnc_stream_context_is_cpu_async(stream_context))
+	{
+		_ccv_cnnp_dataframe_release_data(dataframe, iter->cached_data);
+		return;
+	}
+	// The stream context may still read these, and rows computed on the helper streams would take them from the cache
+	// right away. Thus, only return them to the cache after what is queued on the stream context so far finishes.
+	const int column_size = dataframe->column_size + (dataframe->derived_column_data ? dataframe->derived_column_data->rnum : 0);
+	ccv_cnnp_dataframe_released_row_t* const released_row = (ccv_cnnp_dataframe_released_row_t*)ccmalloc(sizeof(ccv_cnnp_dataframe_released_row_t) + sizeof(ccv_cnnp_dataframe_data_item_t) * (column_size - 1));
+	released_row->iter = iter;
+	memcpy(released_row->data, iter->cached_data, sizeof(ccv_cnnp_dataframe_data_item_t) * column_size);
+	memset(iter->cached_data, 0, sizeof(ccv_cnnp_dataframe_data_item_t) * column_size);
+	pthread_mutex_lock(&iter->mutex);
+	++iter->releasing;
+	pthread_mutex_unlock(&iter->mutex);
+	ccv_nnc_stream_cpu_add_callback(stream_context, _ccv_cnnp_dataframe_release_row, released_row);
+}
+
+static void _ccv_cnnp_dataframe_fetch_row(void* const userdata)
+{
+	ccv_cnnp_dataframe_fetched_row_t* const fetched_row = (ccv_cnnp_dataframe_fetched_row_t*)userdata;
+	ccv_cnnp_dataframe_iter_t* const iter = fetched_row->iter;
+	int i;
+	for (i = 0; i < iter->column_idx_size; i++)
+		_ccv_cnnp_dataframe_column_data(iter->dataframe, fetched_row->data, fetched_row->row_idx, iter->column_idxs[i], fetched_row->ctx, fetched_row->stream_context);
+	pthread_mutex_lock(&iter->mutex);
+	fetched_row->done = 1;
+	pthread_cond_broadcast(&iter->notify);
+	pthread_mutex_unlock(&iter->mutex);
+}
+
+int ccv_cnnp_dataframe_iter_next(ccv_cnnp_dataframe_iter_t* const iter, void** const data_ref, const int column_idx_size, ccv_nnc_stream_context_t* const stream_context)
+{
+	ccv_cnnp_dataframe_t* const dataframe = iter->dataframe;
+	assert(column_idx_size <= iter->column_idx_size);
+	const int column_size = dataframe->column_size + (dataframe->derived_column_data ? dataframe->derived_column_data->rnum : 0);
+	int i;
+	_ccv_cnnp_dataframe_iter_release_data(iter);
+	if (iter->idx == iter->row_size)
 		return -1;
+	const int idx = iter->row_idxs ? iter->row_idxs[iter->idx] : iter->idx;
+	const uint64_t ctx = (uint64_t)(uintptr_t)stream_context;
+	if (iter->prefetch_tail > 0)
+	{
+		ccv_cnnp_dataframe_fetched_row_t* const fetched_row = iter->fetched_rows[iter->prefetch_head];
+		assert(fetched_row->row_idx == idx);
+		pthread_mutex_lock(&iter->mutex);
+		while (!fetched_row->done)
+			pthread_cond_wait(&iter->notify, &iter->mutex);
+		pthread_mutex_unlock(&iter->mutex);
+		// Hand over the data as is, they will be returned to the cache of the stream context they are consumed on.
+		for (i = 0; i < column_size; i++)
+			if (fetched_row->data[i].data)
+			{
+				iter->cached_data[i].ctx = ctx;
+				iter->cached_data[i].data = fetched_row->data[i].data;
+				fetched_row->data[i].data = 0;
+			}
+		iter->prefetch_head = (iter->prefetch_head + 1) % iter->fetched_size;
+		--iter->prefetch_tail;
+	}
 	for (i = 0; i < column_idx_size; i++)
 	{
 		const int column_idx = iter->column_idxs[i];
-		data_ref[i] = _ccv_cnnp_dataframe_column_data(dataframe, iter->cached_data, idx, column_idx, stream_context);
+		data_ref[i] = _ccv_cnnp_dataframe_column_data(dataframe, iter->cached_data, idx, column_idx, ctx, stream_context);
 	}
+	iter->cached_stream_context = stream_context;
 	++iter->idx;
 	return 0;
 }
 
-int ccv_cnnp_dataframe_iter_prefetch(ccv_cnnp_dataframe_iter_t* const iter, ccv_nnc_stream_context_t* const stream_context)
+static ccv_cnnp_dataframe_fetched_row_t* _ccv_cnnp_dataframe_iter_fetched_row(ccv_cnnp_dataframe_iter_t* const iter)
+{
+	ccv_cnnp_dataframe_t* const dataframe = iter->dataframe;
+	const int column_size = dataframe->column_size + (dataframe->derived_column_data ? dataframe->derived_column_data->rnum : 0);
+	if (iter->prefetch_tail == iter->fetched_size)
+	{
+		// Grow the ring, and lay the rows out from 0 again.
+		const int fetched_size = ccv_max(4, iter->fetched_size * 2);
+		ccv_cnnp_dataframe_fetched_row_t** const fetched_rows = (ccv_cnnp_dataframe_fetched_row_t**)cccalloc(fetched_size, sizeof(ccv_cnnp_dataframe_fetched_row_t*));
+		int i;
+		for (i = 0; i < iter->fetched_size; i++)
+			fetched_rows[i] = iter->fetched_rows[(iter->prefetch_head + i) % iter->fetched_size];
+		if (iter->fetched_rows)
+			ccfree(iter->fetched_rows);
+		iter->fetched_rows = fetched_rows;
+		iter->fetched_size = fetched_size;
+		iter->prefetch_head = 0;
+	}
+	const int slot = (iter->prefetch_head + iter->prefetch_tail) % iter->fetched_size;
+	ccv_cnnp_dataframe_fetched_row_t* fetched_row = iter->fetched_rows[slot];
+	if (!fetched_row)
+		fetched_row = iter->fetched_rows[slot] = (ccv_cnnp_dataframe_fetched_row_t*)cccalloc(1, sizeof(ccv_cnnp_dataframe_fetched_row_t) + sizeof(ccv_cnnp_dataframe_data_item_t) * (column_size - 1));
+	fetched_row->iter = iter;
+	fetched_row->done = 0;
+	return fetched_row;
+}
+
+int ccv_cnnp_dataframe_iter_prefetch(ccv_cnnp_dataframe_iter_t* const iter, const int prefetch_count, ccv_nnc_stream_context_t* const stream_context)
 {
-	return -1;
+	const int row_size = ccv_min(prefetch_count, iter->row_size - (iter->idx + iter->prefetch_tail));
+	if (row_size <= 0)
+		return -1;
+	const uint64_t ctx = (uint64_t)(uintptr_t)stream_context;
+	const int async = ccv_nnc_stream_context_is_cpu_async(stream_context);
+	if (async)
+	{
+		if (!iter->stream_size)
+		{
+			const long core_count = sysconf(_SC_NPROCESSORS_ONLN);
+			iter->stream_size = ccv_max(1, ccv_min((int)core_count, CCV_CNNP_DATAFRAME_MAX_PREFETCH_STREAM_SIZE));
+			iter->signal = ccv_nnc_stream_signal_new(CCV_STREAM_CONTEXT_CPU);
+		}
+		// Rows wait for the data already released on this stream context to be returned to the cache, thus, they can be reused.
+		ccv_nnc_stream_context_emit_signal(stream_context, iter->signal);
+	}
+	int i;
+	for (i = 0; i < row_size; i++)
+	{
+		ccv_cnnp_dataframe_fetched_row_t* const fetched_row = _ccv_cnnp_dataframe_iter_fetched_row(iter);
+		const int idx = iter->idx + iter->prefetch_tail;
+		fetched_row->row_idx = iter->row_idxs ? iter->row_idxs[idx] : idx;
+		fetched_row->ctx = ctx;
+		++iter->prefetch_tail;
+		if (async)
+		{
+			// Spread rows onto different streams, thus, they are computed concurrently on the worker pool.
+			ccv_nnc_stream_context_t* stream = iter->streams[iter->stream_idx];
+			if (!stream)
+				stream = iter->streams[iter->stream_idx] = ccv_nnc_stream_context_new(CCV_STREAM_CONTEXT_CPU);
+			iter->stream_idx = (iter->stream_idx + 1) % iter->stream_size;
+			fetched_row->stream_context = stream;
+			ccv_nnc_stream_context_wait_signal(stream, iter->signal);
+			ccv_nnc_stream_cpu_add_callback(stream, _ccv_cnnp_dataframe_fetch_row, fetched_row);
+		} else {
+			fetched_row->stream_context = stream_context;
+			_ccv_cnnp_dataframe_fetch_row(fetched_row);
+		}
+	}
+	return 0;
+}
+
+static void _ccv_cnnp_dataframe_iter_shuffle_rows(ccv_cnnp_dataframe_iter_t* const iter, const int epoch)
+{
+	const int row_size = iter->dataframe->row_size;
+	const int block_size = iter->block_size;
+	const int block_count = (row_size + block_size - 1) / block_size;
+	// Every shard derives the same permutation from the seed and the epoch, thus, they don't need to communicate.
+	sfmt_t sfmt;
+	uint32_t key[2] = { iter->seed, (uint32_t)epoch };
+	sfmt_init_by_array(&sfmt, key, 2);
+	int* const blocks = (int*)ccmalloc(sizeof(int) * block_count);
+	int i, j, k;
+	for (i = 0; i < block_count; i++)
+		blocks[i] = i;
+	for (i = block_count - 1; i > 0; i--)
+	{
+		j = sfmt_genrand_uint32(&sfmt) % (i + 1);
+		CCV_SWAP(blocks[i], blocks[j], k);
+	}
+	// Blocks are dealt to the shards, so a row is read by exactly one shard per epoch.
+	int shard_row_size = 0;
+	for (i = iter->shard_idx; i < block_count; i += iter->shard_count)
+		shard_row_size += ccv_min(block_size, row_size - blocks[i] * block_size);
+	iter->row_idxs = iter->row_idxs ? (int*)ccrealloc(iter->row_idxs, sizeof(int) * ccv_max(1, shard_row_size)) : (int*)ccmalloc(sizeof(int) * ccv_max(1, shard_row_size));
+	iter->row_size = shard_row_size;
+	int* row_idxs = iter->row_idxs;
+	for (i = iter->shard_idx; i < block_count; i += iter->shard_count)
+	{
+		// Rows are shuffled only within a block, and a block is read through before moving onto the next.
+		const int row_start = blocks[i] * block_size;
+		const int count = ccv_min(block_size, row_size - row_start);
+		for (j = 0; j < count; j++)
+			row_idxs[j] = row_start + j;
+		for (j = count - 1; j > 0; j--)
+		{
+			const int r = sfmt_genrand_uint32(&sfmt) % (j + 1);
+			CCV_SWAP(row_idxs[j], row_idxs[r], k);
+		}
+		row_idxs += count;
+	}
+	ccfree(blocks);
+}
+
+static void _ccv_cnnp_dataframe_iter_drain(ccv_cnnp_dataframe_iter_t* const iter)
+{
+	ccv_cnnp_dataframe_t* const dataframe = iter->dataframe;
+	_ccv_cnnp_dataframe_iter_release_data(iter);
+	// Rows prefetched for the old order are discarded once they are done.
+	pthread_mutex_lock(&iter->mutex);
+	for (; iter->prefetch_tail > 0; --iter->prefetch_tail)
+	{
+		ccv_cnnp_dataframe_fetched_row_t* const fetched_row = iter->fetched_rows[iter->prefetch_head];
+		while (!fetched_row->done)
+			pthread_cond_wait(&iter->notify, &iter->mutex);
+		_ccv_cnnp_dataframe_release_data(dataframe, fetched_row->data);
+		iter->prefetch_head = (iter->prefetch_head + 1) % iter->fetched_size;
+	}
+	pthread_mutex_unlock(&iter->mutex);
+}
+
+void ccv_cnnp_dataframe_iter_shuffle(ccv_cnnp_dataframe_iter_t* const iter, const uint32_t seed, const int block_size, const int shard_idx, const int shard_count)
+{
+	assert(block_size > 0);
+	assert(shard_count > 0);
+	assert(shard_idx >= 0 && shard_idx < shard_count);
+	iter->seed = seed;
+	iter->block_size = block_size;
+	iter->shard_idx = shard_idx;
+	iter->shard_count = shard_count;
+	ccv_cnnp_dataframe_iter_set_epoch(iter, 0);
+}
+
+static void _ccv_cnnp_dataframe_batching_shuffle_rows(ccv_cnnp_dataframe_batching_t* const batching, const int epoch)
+{
+	const int row_size = batching->dataframe->row_size;
+	sfmt_t sfmt;
+	uint32_t key[2] = { batching->seed, (uint32_t)epoch };
+	sfmt_init_by_array(&sfmt, key, 2);
+	int* const row_idxs = batching->row_idxs;
+	int i, j, k;
+	for (i = 0; i < row_size; i++)
+		row_idxs[i] = i;
+	for (i = row_size - 1; i > 0; i--)
+	{
+		j = sfmt_genrand_uint32(&sfmt) % (i + 1);
+		CCV_SWAP(row_idxs[i], row_idxs[j], k);
+	}
+}
+
+void ccv_cnnp_dataframe_iter_set_epoch(ccv_cnnp_dataframe_iter_t* const iter, const int epoch)
+{
+	_ccv_cnnp_dataframe_iter_drain(iter);
+	// Batches are made of different rows every epoch.
+	ccv_cnnp_dataframe_batching_t* const batching = iter->dataframe->batching;
+	if (batching && batching->row_idxs)
+		_ccv_cnnp_dataframe_batching_shuffle_rows(batching, epoch);
+	if (iter->block_size > 0)
+		_ccv_cnnp_dataframe_iter_shuffle_rows(iter, epoch);
+	iter->idx = 0;
 }
 
 void ccv_cnnp_dataframe_iter_free(ccv_cnnp_dataframe_iter_t* const iter)
 {
 	ccv_cnnp_dataframe_t* const dataframe = iter->dataframe;
-	const int column_size = dataframe->column_size + (dataframe->derived_column_data ? dataframe->derived_column_data->rnum : 0);
 	int i;
-	// Push existing data back to reusable state (note, these may not be reused immediately because they may be on a different stream context).
-	for (i = 0; i < column_size; i++)
-		if (iter->cached_data[i].data)
-			_ccv_cnnp_dataframe_enqueue_data(dataframe, iter->cached_data[i].data, i, iter->cached_data[i].ctx);
+	_ccv_cnnp_dataframe_iter_release_data(iter);
+	pthread_mutex_lock(&iter->mutex);
+	while (iter->releasing > 0)
+		pthread_cond_wait(&iter->notify, &iter->mutex);
+	pthread_mutex_unlock(&iter->mutex);
+	for (i = 0; i < iter->stream_size; i++)
+		if (iter->streams[i])
+			ccv_nnc_stream_context_free(iter->streams[i]); // This waits for the rows computed on it.
+	if (iter->signal)
+		ccv_nnc_stream_signal_free(iter->signal);
+	for (i = 0; i < iter->fetched_size; i++)
+		if (iter->fetched_rows[i])
+		{
+			_ccv_cnnp_dataframe_release_data(dataframe, iter->fetched_rows[i]->data);
+			ccfree(iter->fetched_rows[i]);
+		}
+	if (iter->fetched_rows)
+		ccfree(iter->fetched_rows);
+	if (iter->row_idxs)
+		ccfree(iter->row_idxs);
+	pthread_mutex_destroy(&iter->mutex);
+	pthread_cond_destroy(&iter->notify);
 	ccfree(iter);
 }
 
@@ -207,6 +524,8 @@ void ccv_cnnp_dataframe_free(ccv_cnnp_dataframe_t* const dataframe)
 		for (i = 0; i < columns->rnum; i++)
 		{
 			ccv_array_t* const column = *(ccv_array_t**)ccv_array_get(columns, i);
+			if (!column)
+				continue;
 			// Get the property deinit function.
 			ccv_cnnp_column_data_deinit_f deinit = (i < dataframe->column_size) ? dataframe->column_data[i].deinit : ((ccv_cnnp_derived_column_data_t*)ccv_array_get(dataframe->derived_column_data, i - dataframe->column_size))->deinit;
 			if (deinit)
@@ -218,6 +537,129 @@ void ccv_cnnp_dataframe_free(ccv_cnnp_dataframe_t* const dataframe)
 	}
 	kh_destroy(ctx, data_ctx);
 	if (dataframe->derived_column_data)
+	{
+		int i;
+		for (i = 0; i < dataframe->derived_column_data->rnum; i++)
+			ccfree(((ccv_cnnp_derived_column_data_t*)ccv_array_get(dataframe->derived_column_data, i))->column_idxs);
 		ccv_array_free(dataframe->derived_column_data);
+	}
+	if (dataframe->batching)
+	{
+		if (dataframe->batching->row_idxs)
+			ccfree(dataframe->batching->row_idxs);
+		ccfree(dataframe->batching);
+	}
+	pthread_mutex_destroy(&dataframe->mutex);
 	ccfree(dataframe);
 }
+
+static void _ccv_cnnp_tensor_deinit(void* const data)
+{
+	ccv_nnc_tensor_free((ccv_nnc_tensor_t*)data);
+}
+
+static void _ccv_cnnp_dataframe_batching_enum(const int column_idx, const int row_idx, const int row_size, void** const data, void* const context, ccv_nnc_stream_context_t* const stream_context)
+{
+	const ccv_cnnp_dataframe_batching_t* const batching = (ccv_cnnp_dataframe_batching_t*)context;
+	ccv_cnnp_dataframe_t* const dataframe = batching->dataframe;
+	const int column_size = dataframe->column_size + (dataframe->derived_column_data ? dataframe->derived_column_data->rnum : 0);
+	const int source_column_idx = batching->column_idxs[column_idx];
+	const int row_start = row_idx * batching->batch_count;
+	const int batch_count = ccv_min(batching->batch_count, dataframe->row_size - row_start);
+	// Rows are pulled from the other dataframe directly, with their data reused on the stream context of this batch.
+	const uint64_t ctx = (uint64_t)(uintptr_t)stream_context;
+	ccv_cnnp_dataframe_data_item_t* const cached_data = (ccv_cnnp_dataframe_data_item_t*)alloca(sizeof(ccv_cnnp_dataframe_data_item_t) * column_size);
+	memset(cached_data, 0, sizeof(ccv_cnnp_dataframe_data_item_t) * column_size);
+	ccv_nnc_tensor_t* batch = (ccv_nnc_tensor_t*)*data;
+	int i, j;
+	for (i = 0; i < batch_count; i++)
+	{
+		const int source_row_idx = batching->row_idxs ? batching->row_idxs[row_start + i] : row_start + i;
+		const ccv_nnc_tensor_t* const tensor = (ccv_nnc_tensor_t*)_ccv_cnnp_dataframe_column_data(dataframe, cached_data, source_row_idx, source_column_idx, ctx, stream_context);
+		assert(!CCV_IS_TENSOR_VIEW(tensor));
+		assert(CCV_TENSOR_GET_MEMORY(tensor->info.type) == CCV_TENSOR_CPU_MEMORY);
+		const int nd = ccv_nnc_tensor_nd(tensor->info.dim);
+		assert(nd < CCV_NNC_MAX_DIM_ALLOC);
+		ccv_nnc_tensor_param_t params = tensor->info;
+		// A tensor bridged from ccv_dense_matrix_t keeps its step after the dimensions.
+		for (j = nd; j < CCV_NNC_MAX_DIM_ALLOC; j++)
+			params.dim[j] = 0;
+		// Only a HWC / CHW tensor can be transformed, for the others, the format is just a label.
+		const int transform = (nd == 3 && batching->format && batching->format != params.format &&
+			(params.format == CCV_TENSOR_FORMAT_NHWC || params.format == CCV_TENSOR_FORMAT_NCHW));
+		if (batching->format)
+			params.format = batching->format;
+		if (transform)
+		{
+			if (params.format == CCV_TENSOR_FORMAT_NCHW)
+				params.dim[0] = tensor->info.dim[2], params.dim[1] = tensor->info.dim[0], params.dim[2] = tensor->info.dim[1];
+			else
+				params.dim[0] = tensor->info.dim[1], params.dim[1] = tensor->info.dim[2], params.dim[2] = tensor->info.dim[0];
+		}
+		if (i == 0)
+		{
+			ccv_nnc_tensor_param_t batch_params = params;
+			batch_params.dim[0] = batch_count;
+			for (j = 0; j < nd; j++)
+				batch_params.dim[j + 1] = params.dim[j];
+			// Reuse the batch tensor from the cache if it has the same shape.
+			if (batch && memcmp(&batch->info, &batch_params, sizeof(ccv_nnc_tensor_param_t)) != 0)
+			{
+				ccv_nnc_tensor_free(batch);
+				batch = 0;
+			}
+			if (!batch)
+				batch = ccv_nnc_tensor_new(0, batch_params, 0);
+		} else {
+			for (j = 0; j < nd; j++)
+				{ assert(batch->info.dim[j + 1] == params.dim[j]); }
+		}
+		const size_t size = CCV_GET_DATA_TYPE_SIZE(params.datatype) * ccv_nnc_tensor_count(params);
+		if (transform)
+		{
+			ccv_nnc_tensor_t slice = ccv_nnc_tensor(batch->data.u8 + size * i, params, 0);
+			ccv_nnc_cmd_exec(CMD_FORMAT_TRANSFORM_FORWARD(), ccv_nnc_no_hint, 0, TENSOR_LIST((ccv_nnc_tensor_t*)tensor), TENSOR_LIST(&slice), 0);
+		} else
+			memcpy(batch->data.u8 + size * i, tensor->data.u8, size);
+		_ccv_cnnp_dataframe_release_data(dataframe, cached_data);
+	}
+	*data = batch;
+}
+
+ccv_cnnp_dataframe_t* ccv_cnnp_dataframe_batching_new(ccv_cnnp_dataframe_t* const dataframe, const int* const column_idxs, const int column_idx_size, const int batch_count, const int format)
+{
+	assert(column_idx_size > 0);
+	assert(batch_count > 0);
+	assert(format == 0 || format == CCV_TENSOR_FORMAT_NCHW || format == CCV_TENSOR_FORMAT_NHWC);
+	const int column_size = dataframe->column_size + (dataframe->derived_column_data ? dataframe->derived_column_data->rnum : 0);
+	int i;
+	for (i = 0; i < column_idx_size; i++)
+		{ assert(column_idxs[i] < column_size); }
+	ccv_cnnp_dataframe_batching_t* const batching = (ccv_cnnp_dataframe_batching_t*)ccmalloc(sizeof(ccv_cnnp_dataframe_batching_t) + sizeof(int) * (column_idx_size - 1));
+	batching->batch_count = batch_count;
+	batching->format = format;
+	batching->seed = 0;
+	batching->row_idxs = 0;
+	batching->dataframe = dataframe;
+	memcpy(batching->column_idxs, column_idxs, sizeof(int) * column_idx_size);
+	ccv_cnnp_column_data_t* const column_data = (ccv_cnnp_column_data_t*)alloca(sizeof(ccv_cnnp_column_data_t) * column_idx_size);
+	for (i = 0; i < column_idx_size; i++)
+	{
+		column_data[i].data_enum = _ccv_cnnp_dataframe_batching_enum;
+		column_data[i].deinit = _ccv_cnnp_tensor_deinit;
+		column_data[i].context = batching;
+	}
+	ccv_cnnp_dataframe_t* const batched = ccv_cnnp_dataframe_new(column_data, column_idx_size, (dataframe->row_size + batch_count - 1) / batch_count);
+	batched->batching = batching;
+	return batched;
+}
+
+ccv_cnnp_dataframe_t* ccv_cnnp_dataframe_shuffled_batching_new(ccv_cnnp_dataframe_t* const dataframe, const int* const column_idxs, const int column_idx_size, const int batch_count, const int format, const uint32_t seed)
+{
+	ccv_cnnp_dataframe_t* const batched = ccv_cnnp_dataframe_batching_new(dataframe, column_idxs, column_idx_size, batch_count, format);
+	ccv_cnnp_dataframe_batching_t* const batching = batched->batching;
+	batching->seed = seed;
+	batching->row_idxs = (int*)ccmalloc(sizeof(int) * ccv_max(1, dataframe->row_size));
+	_ccv_cnnp_dataframe_batching_shuffle_rows(batching, 0);
+	return batched;
+}
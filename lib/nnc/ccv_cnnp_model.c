@@ -3,6 +3,7 @@
 #include "ccv_nnc_internal.h"
 #include "ccv_internal.h"
 #include "_ccv_cnnp_model.h"
+#include <sys/mman.h>
 
 #pragma mark - Level-5 API
 
@@ -955,6 +956,8 @@ static void _ccv_cnnp_compiled_data_free(ccv_cnnp_compiled_data_t* const compile
 		ccfree(compiled_data->saved_aux);
 	if (compiled_data->trainable_tensors)
 		ccfree(compiled_data->trainable_tensors);
+	if (compiled_data->checkpoint_map)
+		munmap(compiled_data->checkpoint_map, compiled_data->checkpoint_map_size);
 	if (compiled_data->dest_to_evals)
 		ccfree(compiled_data->dest_to_evals);
 	ccfree(compiled_data);
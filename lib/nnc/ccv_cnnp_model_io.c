@@ -7,6 +7,10 @@
 #ifdef HAVE_CUDA
 #include "gpu/ccv_nnc_compat.h"
 #endif
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 #ifdef NDEBUG
 #define SQLITE_ENFORCE(stmt) (void)(stmt)
@@ -14,10 +18,238 @@
 #define SQLITE_ENFORCE assert
 #endif
 
+// The memory-mapped checkpoint is a header, followed by the index of tensors, and then the data of tensors, each aligned.
+#define CCV_CNNP_CHECKPOINT_MMAP_MAGIC "ccvnncmm"
+#define CCV_CNNP_CHECKPOINT_MMAP_VERSION (1)
+#define CCV_CNNP_CHECKPOINT_MMAP_ALIGN (64)
+
+typedef struct {
+	char magic[8];
+	uint32_t version;
+	uint32_t tensor_size;
+} ccv_cnnp_checkpoint_mmap_header_t;
+
+typedef struct {
+	uint64_t offset; // 0 if there is no tensor.
+	uint64_t size;
+	int type;
+	int format;
+	int datatype;
+	int dim[CCV_NNC_MAX_DIM_ALLOC];
+} ccv_cnnp_checkpoint_mmap_index_t;
+
+static void _ccv_cnnp_checkpoint_mmap_write(ccv_nnc_tensor_t* const* const tensors, const int tensor_size, const char* const fn)
+{
+	// Write to a different file and move it over, the old file may be mapped by other processes still.
+	const size_t fn_len = strlen(fn);
+	char* const tmp_fn = (char*)ccmalloc(fn_len + 5);
+	memcpy(tmp_fn, fn, fn_len);
+	memcpy(tmp_fn + fn_len, ".tmp", 5);
+	FILE* const w = fopen(tmp_fn, "wb");
+	if (!w)
+	{
+		ccfree(tmp_fn);
+		return;
+	}
+	ccv_cnnp_checkpoint_mmap_header_t header;
+	memcpy(header.magic, CCV_CNNP_CHECKPOINT_MMAP_MAGIC, 8);
+	header.version = CCV_CNNP_CHECKPOINT_MMAP_VERSION;
+	header.tensor_size = tensor_size;
+	ccv_cnnp_checkpoint_mmap_index_t* const index = (ccv_cnnp_checkpoint_mmap_index_t*)cccalloc(tensor_size, sizeof(ccv_cnnp_checkpoint_mmap_index_t));
+	uint64_t offset = (sizeof(header) + sizeof(ccv_cnnp_checkpoint_mmap_index_t) * tensor_size + CCV_CNNP_CHECKPOINT_MMAP_ALIGN - 1) & -CCV_CNNP_CHECKPOINT_MMAP_ALIGN;
+	int i;
+	for (i = 0; i < tensor_size; i++)
+	{
+		const ccv_nnc_tensor_t* const tensor = tensors[i];
+		if (!tensor)
+			continue;
+		assert(!CCV_IS_TENSOR_VIEW(tensor));
+		index[i].offset = offset;
+		index[i].size = ccv_nnc_tensor_data_size(tensor->info);
+		index[i].type = tensor->info.type;
+		index[i].format = tensor->info.format;
+		index[i].datatype = tensor->info.datatype;
+		memcpy(index[i].dim, tensor->info.dim, sizeof(index[i].dim));
+		offset = (offset + index[i].size + CCV_CNNP_CHECKPOINT_MMAP_ALIGN - 1) & -CCV_CNNP_CHECKPOINT_MMAP_ALIGN;
+	}
+	int ok = (1 == fwrite(&header, sizeof(header), 1, w));
+	ok = ok && (tensor_size == fwrite(index, sizeof(ccv_cnnp_checkpoint_mmap_index_t), tensor_size, w));
+	uint64_t pos = sizeof(header) + sizeof(ccv_cnnp_checkpoint_mmap_index_t) * tensor_size;
+	static const uint8_t zeros[CCV_CNNP_CHECKPOINT_MMAP_ALIGN] = {0};
+#ifdef HAVE_CUDA
+	size_t workspace_size = 0;
+	void* workspace = 0;
+#endif
+	for (i = 0; ok && i < tensor_size; i++)
+	{
+		const ccv_nnc_tensor_t* const tensor = tensors[i];
+		if (!tensor)
+			continue;
+		if (pos < index[i].offset)
+			ok = (1 == fwrite(zeros, index[i].offset - pos, 1, w));
+		const size_t data_size = index[i].size;
+#ifdef HAVE_CUDA
+		if (CCV_TENSOR_GET_MEMORY(tensor->info.type) == CCV_TENSOR_GPU_MEMORY)
+		{
+			if (!workspace)
+			{
+				workspace = ccmalloc(data_size);
+				workspace_size = data_size;
+			} else if (data_size > workspace_size) {
+				workspace = ccrealloc(workspace, data_size);
+				workspace_size = data_size;
+			}
+			cumemcpy(workspace, CCV_TENSOR_CPU_MEMORY, tensor->data.u8, tensor->info.type, data_size);
+			ok = ok && (1 == fwrite(workspace, data_size, 1, w));
+		} else
+			ok = ok && (1 == fwrite(tensor->data.u8, data_size, 1, w));
+#else
+		ok = ok && (1 == fwrite(tensor->data.u8, data_size, 1, w));
+#endif
+		pos = index[i].offset + data_size;
+	}
+#ifdef HAVE_CUDA
+	if (workspace)
+		ccfree(workspace);
+#endif
+	ccfree(index);
+	ok = (0 == fclose(w)) && ok;
+	if (ok)
+		rename(tmp_fn, fn);
+	else
+		remove(tmp_fn);
+	ccfree(tmp_fn);
+}
+
+static void _ccv_cnnp_checkpoint_mmap_copy(ccv_nnc_tensor_t* const tensor, const uint8_t* const data, const size_t size)
+{
+	const size_t data_size = ccv_min(ccv_nnc_tensor_data_size(tensor->info), size);
+#ifdef HAVE_CUDA
+	if (CCV_TENSOR_GET_MEMORY(tensor->info.type) == CCV_TENSOR_GPU_MEMORY)
+		cumemcpy(tensor->data.u8, tensor->info.type, data, CCV_TENSOR_CPU_MEMORY, data_size);
+	else
+		memcpy(tensor->data.u8, data, data_size);
+#else
+	memcpy(tensor->data.u8, data, data_size);
+#endif
+}
+
+// Bind the tensor onto the mapped pages if it is possible, otherwise, allocate it and copy the data over.
+static ccv_nnc_tensor_t* _ccv_cnnp_checkpoint_mmap_tensor_new(const ccv_nnc_tensor_param_t params, const ccv_cnnp_checkpoint_mmap_index_t* const index, uint8_t* const map, int* const bound)
+{
+	if (index && CCV_TENSOR_GET_MEMORY(params.type) == CCV_TENSOR_CPU_MEMORY && index->size == ccv_nnc_tensor_data_size(params))
+	{
+		*bound = 1;
+		return ccv_nnc_tensor_new(map + index->offset, params, 0);
+	}
+	ccv_nnc_tensor_t* const tensor = ccv_nnc_tensor_new(0, params, 0);
+	if (index)
+		_ccv_cnnp_checkpoint_mmap_copy(tensor, map + index->offset, index->size);
+	return tensor;
+}
+
+static void _ccv_cnnp_model_checkpoint_mmap(ccv_cnnp_model_t* const model, const char* const fn, const int flags)
+{
+	ccv_cnnp_compiled_data_t* const compiled_data = model->compiled_data;
+	const int tensors_init = !!compiled_data->trainable_tensors;
+	const int trainable_size = compiled_data->trainables->rnum;
+	const int parallel_count = ccv_max(compiled_data->parallel_count, 1);
+	const int retain_size = compiled_data->retains->rnum * parallel_count;
+	if (tensors_init && flags != CCV_CNNP_MODEL_CHECKPOINT_READ_ONLY)
+	{
+		_ccv_cnnp_checkpoint_mmap_write(compiled_data->trainable_tensors, trainable_size + retain_size, fn);
+		return;
+	}
+	const int fd = open(fn, O_RDONLY);
+	if (fd < 0)
+		return;
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size < sizeof(ccv_cnnp_checkpoint_mmap_header_t))
+	{
+		close(fd);
+		return;
+	}
+	const size_t map_size = st.st_size;
+	// Mapped privately, thus, the pages are shared until the tensors are updated (copy-on-write).
+	uint8_t* const map = (uint8_t*)mmap(0, map_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (map == MAP_FAILED)
+		return;
+	const ccv_cnnp_checkpoint_mmap_header_t* const header = (ccv_cnnp_checkpoint_mmap_header_t*)map;
+	const ccv_cnnp_checkpoint_mmap_index_t* const index = (ccv_cnnp_checkpoint_mmap_index_t*)(header + 1);
+	if (memcmp(header->magic, CCV_CNNP_CHECKPOINT_MMAP_MAGIC, 8) != 0 || header->version != CCV_CNNP_CHECKPOINT_MMAP_VERSION ||
+		sizeof(ccv_cnnp_checkpoint_mmap_header_t) + sizeof(ccv_cnnp_checkpoint_mmap_index_t) * header->tensor_size > map_size)
+	{
+		munmap(map, map_size);
+		return;
+	}
+	const int tensor_size = header->tensor_size;
+	int i, j;
+	for (i = 0; i < tensor_size; i++)
+		if (index[i].offset + index[i].size > map_size)
+		{
+			munmap(map, map_size);
+			return;
+		}
+	int bound = 0;
+	if (!tensors_init)
+	{
+		// A trainable tensor missing from the file would be left uninitialized, don't read the file and leave them to
+		// the initializers of the model instead.
+		for (i = 0; i < trainable_size; i++)
+		{
+			const ccv_nnc_tensor_symbol_t trainable = *(ccv_nnc_tensor_symbol_t*)ccv_array_get(compiled_data->trainables, i);
+			if (i >= tensor_size || !index[i].offset || index[i].size != ccv_nnc_tensor_data_size(ccv_nnc_tensor_symbol_params(trainable.graph, trainable)))
+			{
+				munmap(map, map_size);
+				return;
+			}
+		}
+		// Same as ccv_cnnp_model_tensors_init, except the tensors are bound to the mapped file.
+		compiled_data->trainable_tensors = (ccv_nnc_tensor_t**)ccmalloc(sizeof(ccv_nnc_tensor_t*) * (trainable_size + retain_size));
+		compiled_data->retain_tensors = compiled_data->trainable_tensors + trainable_size;
+		for (i = 0; i < trainable_size; i++)
+		{
+			const ccv_nnc_tensor_symbol_t trainable = *(ccv_nnc_tensor_symbol_t*)ccv_array_get(compiled_data->trainables, i);
+			compiled_data->trainable_tensors[i] = _ccv_cnnp_checkpoint_mmap_tensor_new(ccv_nnc_tensor_symbol_params(trainable.graph, trainable), index + i, map, &bound);
+		}
+		for (i = 0; i < compiled_data->retains->rnum; i++)
+		{
+			const ccv_nnc_tensor_symbol_t retained = *(ccv_nnc_tensor_symbol_t*)ccv_array_get(compiled_data->retains, i);
+			ccv_nnc_tensor_param_t info = ccv_nnc_tensor_symbol_params(retained.graph, retained);
+			for (j = 0; j < parallel_count; j++)
+			{
+				const int k = trainable_size + i * parallel_count + j;
+				if (j > 0)
+					CCV_TENSOR_SET_DEVICE_ID(info.type, j);
+				compiled_data->retain_tensors[i * parallel_count + j] = _ccv_cnnp_checkpoint_mmap_tensor_new(info, k < tensor_size && index[k].offset ? index + k : 0, map, &bound);
+			}
+		}
+	} else {
+		for (i = 0; i < trainable_size + retain_size && i < tensor_size; i++)
+			if (compiled_data->trainable_tensors[i] && index[i].offset)
+				_ccv_cnnp_checkpoint_mmap_copy(compiled_data->trainable_tensors[i], map + index[i].offset, index[i].size);
+	}
+	if (!bound)
+	{
+		munmap(map, map_size);
+		return;
+	}
+	// Only tensors created here can be bound, thus, there is no earlier mapping.
+	assert(!compiled_data->checkpoint_map);
+	compiled_data->checkpoint_map = map;
+	compiled_data->checkpoint_map_size = map_size;
+}
+
 void ccv_cnnp_model_checkpoint(ccv_cnnp_model_t* const model, const char* const fn, const int flags)
 {
 	ccv_cnnp_compiled_data_t* const compiled_data = model->compiled_data;
 	assert(compiled_data); // The model has to be compiled.
+	if (flags & CCV_CNNP_MODEL_CHECKPOINT_MMAP)
+	{
+		_ccv_cnnp_model_checkpoint_mmap(model, fn, flags & ~CCV_CNNP_MODEL_CHECKPOINT_MMAP);
+		return;
+	}
 	sqlite3* conn = 0;
 	if (SQLITE_OK != sqlite3_open(fn, &conn))
 		return;
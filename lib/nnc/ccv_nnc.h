@@ -25,6 +25,11 @@
  * Initialize the library.
  */
 void ccv_nnc_init(void);
+/**
+ * Stop the worker threads that execute commands on CPU stream contexts, and free them. These are started again on
+ * the next command submitted to a CPU stream context. All CPU stream contexts need to be waited before this.
+ */
+void ccv_nnc_deinit(void);
 
 /** @} */
 
@@ -57,6 +62,22 @@ enum {
 	CCV_NNC_EXEC_OOM       = -3, /**< Out of memory error. */
 };
 
+/**
+ * Element-wise ops that can be fused at the end of a command (its epilogue), see CCV_NNC_SIMPLIFY_EPILOGUE_FUSION.
+ * These are applied in order on the output of the command, the extra tensors they need are appended to the inputs
+ * of the command in the same order.
+ */
+enum {
+	CCV_NNC_EPILOGUE_RELU = 1, /**< b = max(b, 0). */
+	CCV_NNC_EPILOGUE_SCALAR_MUL, /**< b = b * a. */
+	CCV_NNC_EPILOGUE_EXP, /**< b = exp(b). */
+	CCV_NNC_EPILOGUE_EWSUM, /**< b = b + x, x is the next input, it has the same shape as b. */
+	CCV_NNC_EPILOGUE_EWPROD, /**< b = b * x, x is the next input, it has the same shape as b. */
+	CCV_NNC_EPILOGUE_BATCH_NORM, /**< b = (b - mean) * scale / (sqrt(var) + a) + bias (as batch norm in test mode), the next 4 inputs are scale, bias, mean and var along the last dimension of b. */
+};
+
+#define CCV_NNC_MAX_EPILOGUE_SIZE (4)
+
 /**
  * Parameters for command.
  */
@@ -103,6 +124,13 @@ typedef struct {
 		} dropout;
 		void* userdata;
 	};
+	struct {
+		int size; /**< [epilogue.size] The number of element-wise ops fused at the end of this command. */
+		struct {
+			int type; /**< [epilogue.ops[].type] One of CCV_NNC_EPILOGUE_*. */
+			float a; /**< [epilogue.ops[].a] The scalar for CCV_NNC_EPILOGUE_SCALAR_MUL, or the epsilon for CCV_NNC_EPILOGUE_BATCH_NORM. */
+		} ops[CCV_NNC_MAX_EPILOGUE_SIZE];
+	} epilogue;
 } ccv_nnc_cmd_param_t;
 
 /*
@@ -316,6 +344,21 @@ CCV_WARN_UNUSED(uint32_t) ccv_nnc_cmd_find_backend(const ccv_nnc_cmd_t cmd, cons
  * @return The modified cmd that contains the updated configuration.
  */
 CCV_WARN_UNUSED(ccv_nnc_cmd_t) ccv_nnc_cmd_autotune(const ccv_nnc_cmd_t cmd, const size_t max_workspace_size, const ccv_nnc_hint_t hint, const int flags, ccv_nnc_tensor_t* const* const inputs, const int input_size, ccv_nnc_tensor_t* const* const outputs, const int output_size, ccv_nnc_stream_context_t* const stream_context);
+/**
+ * Open an on-disk database to remember the results of autotune (ccv_nnc_cmd_autotune and ccv_nnc_graph_autotune).
+ * The results are keyed by the command, its parameters, the hint, the flags, the max workspace size, the
+ * shapes / formats / datatypes of the tensors and the CPU model. They are loaded into memory when the database
+ * is opened, and autotune with a remembered key returns the backend / algorithm without running anything. New
+ * results are written to the database as they are tuned. To pre-warm the database offline, open it and run
+ * autotune (or compile the models) with the same shapes on identical hardware, then ship the database file.
+ * @param fn The file name of the database.
+ * @return 0 if the database is opened, -1 otherwise.
+ */
+CCV_WARN_UNUSED(int) ccv_nnc_cmd_autotune_db_open(const char* const fn);
+/**
+ * Close the autotune database, and forget the results loaded from it.
+ */
+void ccv_nnc_cmd_autotune_db_close(void);
 /**
  * Check whether a given tensor input / output pattern can be computed by the given command.
  * bitmasks encode whether a given input tensor / output tensor available at a position.
@@ -388,7 +431,7 @@ CCV_WARN_UNUSED(int) ccv_nnc_cmd_enforce_inplace(const ccv_nnc_cmd_t cmd, const
 // Control flow constructs
 // Follow heavily based along CUDA's stream / event idea.
 enum {
-	CCV_STREAM_CONTEXT_CPU = 0x1, /**< A CPU based stream context (unsupported). */
+	CCV_STREAM_CONTEXT_CPU = 0x1, /**< A CPU based stream context, commands are executed on a worker pool. */
 	CCV_STREAM_CONTEXT_GPU = 0x2, /**< A GPU based stream context. */
 };
 #define CCV_STREAM_GET_CONTEXT(type) ((type) & 0x3)
@@ -415,12 +458,47 @@ CCV_WARN_UNUSED(void*) ccv_nnc_stream_context_get_workspace(ccv_nnc_stream_conte
  * @param stream The stream context to drain workspace memory.
  */
 void ccv_nnc_stream_context_drain(ccv_nnc_stream_context_t* const stream);
+/**
+ * Deallocate the workspace memory on the stream context if it is larger than the given size.
+ * Unlike drain, the workspace within the size is kept for the next command.
+ * @param stream_context The stream context to trim workspace memory, 0 for the calling thread's.
+ * @param max_workspace_size The largest workspace memory to keep, 0 to deallocate any.
+ */
+void ccv_nnc_stream_context_trim(ccv_nnc_stream_context_t* const stream_context, const size_t max_workspace_size);
+/**
+ * Statistics of the CPU workspace memory on a stream context.
+ */
+typedef struct {
+	size_t size; /**< The size of the workspace memory currently held. */
+	size_t high_water_mark; /**< The largest workspace memory ever requested. */
+	uint64_t request_count; /**< How many times the workspace memory is requested. */
+	uint64_t alloc_count; /**< How many of these requests allocated memory. */
+} ccv_nnc_stream_context_workspace_stat_t;
+/**
+ * Get the statistics of the CPU workspace memory on a stream context.
+ * @param stream_context The stream context, 0 for the calling thread's (used by commands executed without a stream context).
+ * @return The statistics of the CPU workspace memory.
+ */
+CCV_WARN_UNUSED(ccv_nnc_stream_context_workspace_stat_t) ccv_nnc_stream_context_workspace_stat(const ccv_nnc_stream_context_t* const stream_context);
+/**
+ * The default of how much workspace memory each thread keeps between commands executed without a stream context.
+ */
+#define CCV_NNC_DEFAULT_WORKSPACE_LIMIT ((size_t)256 * 1024 * 1024)
+/**
+ * Set how much workspace memory each thread keeps between commands executed without a stream context. The
+ * workspace memory grows to the largest size requested, and is kept for the next command, if it is larger
+ * than the limit after a command, it is deallocated. The default is CCV_NNC_DEFAULT_WORKSPACE_LIMIT.
+ * @param workspace_limit The largest workspace memory to keep, 0 to deallocate after every command.
+ */
+void ccv_nnc_set_workspace_limit(const size_t workspace_limit);
 /**
  * Wait until all tasks submitted (command, graph run etc.) on the stream context
  * completed.
  * @param stream The stream context to wait.
+ * @return CCV_NNC_EXEC_SUCCESS if all the commands executed asynchronously on a CPU stream context since the
+ *         last wait succeeded, otherwise, the status of the first one failed.
  */
-void ccv_nnc_stream_context_wait(const ccv_nnc_stream_context_t* const stream);
+int ccv_nnc_stream_context_wait(const ccv_nnc_stream_context_t* const stream);
 /**
  * Deallocate the stream context.
  * @param stream_context The stream context to be destroyed.
@@ -810,6 +888,26 @@ CCV_WARN_UNUSED(ccv_nnc_tensor_symbol_t) ccv_nnc_tensor_symbol_new(ccv_nnc_symbo
  * @return A tensor symbol alias reference.
  */
 CCV_WARN_UNUSED(ccv_nnc_tensor_symbol_t) ccv_nnc_tensor_symbol_alias_new(ccv_nnc_symbolic_graph_t* const graph, const ccv_nnc_tensor_symbol_t tensor_symbol, const int ofs[CCV_NNC_MAX_DIM_ALLOC], const int inc[CCV_NNC_MAX_DIM_ALLOC], const ccv_nnc_tensor_param_t info, const char* const name);
+/**
+ * Create a constant tensor symbol. The content is copied into the symbolic graph and will be bound to this symbol
+ * when the graph is compiled (unless it is bound explicitly). Constants can be folded by the simplify pass, and
+ * kernels can cache transformations of them (such as pre-transformed weights) because they are signed by their content.
+ * The compiled constant is immutable. If it is retrieved with ccv_nnc_tensor_from_symbol, its signature is cleared,
+ * thus, it can be changed, but the cached transformations are not used any more.
+ * @param graph The symbolic graph.
+ * @param info The tensor parameters.
+ * @param data The content of the tensor, laid out as a CPU tensor of the given parameters.
+ * @param name The name of the tensor symbol, it is optional.
+ * @return A tensor symbol reference.
+ */
+CCV_WARN_UNUSED(ccv_nnc_tensor_symbol_t) ccv_nnc_tensor_symbol_constant_new(ccv_nnc_symbolic_graph_t* const graph, const ccv_nnc_tensor_param_t info, const void* const data, const char* const name);
+/**
+ * Get the content of a constant tensor symbol.
+ * @param graph The symbolic graph.
+ * @param tensor The tensor symbol reference.
+ * @return The CPU tensor holds the content, 0 if the tensor symbol is not a constant.
+ */
+CCV_WARN_UNUSED(const ccv_nnc_tensor_t*) ccv_nnc_tensor_symbol_constant(const ccv_nnc_symbolic_graph_t* const graph, const ccv_nnc_tensor_symbol_t tensor);
 /**
  * Manually delete a tensor symbol off the symbolic graph.
  * @param graph The symbolic graph.
@@ -938,7 +1036,7 @@ void ccv_nnc_symbolic_graph_free(ccv_nnc_symbolic_graph_t* const graph);
  * Find corresponding tensor by a symbol from the tensor arena.
  * @param tensor_arena The tensor arena object generated through compilation,
  * @param symbol The tensor symbol reference. Because tensor symbol reference is on stack. It can still be used even the original symbolic graph is free'd.
- * @return A concrete tensor from the tensor arena.
+ * @return A concrete tensor from the tensor arena. Its signature is cleared, because it can be changed.
  */
 CCV_WARN_UNUSED(ccv_nnc_tensor_t*) ccv_nnc_tensor_from_symbol(const ccv_nnc_tensor_arena_t* const tensor_arena, const ccv_nnc_tensor_symbol_t symbol);
 /**
@@ -1149,6 +1247,13 @@ void ccv_nnc_graph_exec_symbol_to(const ccv_nnc_symbolic_graph_t* const graph, c
  * @return The total allocated size in bytes.
  */
 CCV_WARN_UNUSED(uint64_t) ccv_nnc_tensor_arena_size(const ccv_nnc_tensor_arena_t* const tensor_arena);
+/**
+ * Find the size of the data the tensor arena keeps for its constants, such as the weights transformed for the
+ * kernels that use them. It is not included in ccv_nnc_tensor_arena_size.
+ * @param tensor_arena The tensor arena object generated through compilation.
+ * @return The total size in bytes.
+ */
+CCV_WARN_UNUSED(uint64_t) ccv_nnc_tensor_arena_derived_size(const ccv_nnc_tensor_arena_t* const tensor_arena);
 /**
  * Function prototype for tensor symbol creation callback.
  */
@@ -1733,7 +1838,20 @@ enum {
 	 * that are sequential.
 	 */
 	CCV_NNC_SIMPLIFY_OPS_FUSION,
-	// CCV_NNC_SIMPLIFY_CONSTANT_FOLDING, // This currently is not supported, because we don't have efficient way to express constant in symbolic graph.
+	/**
+	 * Fuse the element-wise ops (ReLU, batch norm in test mode, element-wise sum / product, scalar multiply, exp) that
+	 * follow a convolution, GEMM or element-wise command into the epilogue of that command, thus, the chain runs as
+	 * one pass over the data. Batch norm is folded into a per-channel scale and shift. Only CPU tensors are fused, and
+	 * only if the intermediate tensors are not aliased, not in the outputs and not used by anything else. The fused
+	 * commands don't have backward, thus, run this on inference graphs, or after the backward pass is generated.
+	 */
+	CCV_NNC_SIMPLIFY_EPILOGUE_FUSION,
+	/**
+	 * If all the inputs of a command are constants (created with ccv_nnc_tensor_symbol_constant_new), run it once on
+	 * CPU and turn its outputs into constants. The command is removed from the graph afterwards, so are the constants
+	 * no longer used by anything. Commands with side effects (random, custom, sub-graphs) are not folded.
+	 */
+	CCV_NNC_SIMPLIFY_CONSTANT_FOLDING,
 };
 /**
  * Simplify a graph with given list of passes, in that particular order.
@@ -1752,6 +1870,35 @@ void ccv_nnc_symbolic_graph_simplify(ccv_nnc_symbolic_graph_t* const graph, cons
 
 /** @} */
 
+/**
+ * @defgroup level_3_5_rematerialize Memory Budgeted Graph (Rematerialization)
+ * @{
+ */
+
+/**
+ * Trade computation for memory on a graph with backward pass. The activations the backward pass reads from the
+ * forward pass are retained until the backward pass reaches them. This drops some of them and recomputes them right
+ * before the backward pass reads them, until the retained activations fit in the given memory budget. Activations
+ * that can be recomputed with element-wise commands (ReLU, softmax, ew*, add, mul etc.) are dropped first, then the
+ * ones need to replay a segment of the forward pass (convolution, GEMM, pooling) from the nearest retained activation.
+ * A segment replays at most sqrt(n) commands, where n is the number of commands in the forward pass, this bounds the
+ * computation overhead. The tensors a segment recomputes on the way are counted against the budget too, and the
+ * commands shared by the segments of several dropped activations are replayed once. Batch norm, dropout and commands
+ * with more than one output are never replayed.
+ * The recomputation exec symbols are added to the graph, thus, you need to call this before compile the graph, and
+ * after ccv_nnc_symbolic_graph_backward or ccv_nnc_symbolic_graph_minimize.
+ * @param graph The symbolic graph with backward pass.
+ * @param max_memory_size The memory budget (in bytes) for the activations retained for the backward pass.
+ * @param sources The source execution node symbols array.
+ * @param source_size The size of source node symbols array.
+ * @param destinations The destinations execution node symbols array.
+ * @param destination_size The size of destination node symbols array.
+ * @return The size (in bytes) of the activations retained for the backward pass after this, plus the largest size of the tensors recomputed on the way to a dropped one. It can be larger than max_memory_size if there is nothing more to drop.
+ */
+uint64_t ccv_nnc_symbolic_graph_rematerialize(ccv_nnc_symbolic_graph_t* const graph, const uint64_t max_memory_size, const ccv_nnc_graph_exec_symbol_t* const sources, const int source_size, const ccv_nnc_graph_exec_symbol_t* const destinations, const int destination_size);
+
+/** @} */
+
 /**
  * @defgroup level_3_5_parallel Automatic Graph Parallelization
  * @{
@@ -2017,6 +2164,34 @@ typedef void (*ccv_cnnp_column_data_map_f)(void** const column_data, const int c
  * @return The new column index.
  */
 CCV_WARN_UNUSED(int) ccv_cnnp_dataframe_map(ccv_cnnp_dataframe_t* const dataframe, ccv_cnnp_column_data_map_f map, ccv_cnnp_column_data_deinit_f deinit, const int* const column_idxs, const int column_idx_size, void* const context);
+/**
+ * Derive a new dataframe which rows are minibatches of consecutive rows from the given dataframe. Each of its
+ * columns is a tensor batched from one of the given columns: the rows are copied into one contiguous tensor
+ * with the batch size as its first dimension. The batched tensors are reused through the stream context the
+ * same way as other data. The last batch can be smaller if the rows are not divisible by the batch count.
+ * @param dataframe The dataframe that contains the rows. It has to be freed after the new dataframe.
+ * @param column_idxs The columns to be batched. These have to be CPU tensors (ccv_nnc_tensor_t) of the same shape in every row.
+ * @param column_idx_size The size of columns array.
+ * @param batch_count How many rows make one batch.
+ * @param format The format of the batched tensors, CCV_TENSOR_FORMAT_NCHW or CCV_TENSOR_FORMAT_NHWC. A 3-d tensor
+ *        in the other format is transformed while being copied. 0 to keep the format as is.
+ * @return The new dataframe, column i of it is the batch of column_idxs[i].
+ */
+CCV_WARN_UNUSED(ccv_cnnp_dataframe_t*) ccv_cnnp_dataframe_batching_new(ccv_cnnp_dataframe_t* const dataframe, const int* const column_idxs, const int column_idx_size, const int batch_count, const int format);
+/**
+ * Same as **ccv_cnnp_dataframe_batching_new**, but the rows are shuffled before being batched, thus, a batch
+ * is made of rows from anywhere in the dataframe. The order is derived from the seed and the epoch only. It
+ * starts with epoch 0, and is shuffled again whenever **ccv_cnnp_dataframe_iter_set_epoch** is called on an
+ * iterator of the new dataframe, so there should be only one iterator of it at a time.
+ * @param dataframe The dataframe that contains the rows. It has to be freed after the new dataframe.
+ * @param column_idxs The columns to be batched. These have to be CPU tensors (ccv_nnc_tensor_t) of the same shape in every row.
+ * @param column_idx_size The size of columns array.
+ * @param batch_count How many rows make one batch.
+ * @param format The format of the batched tensors, CCV_TENSOR_FORMAT_NCHW or CCV_TENSOR_FORMAT_NHWC. 0 to keep the format as is.
+ * @param seed The seed to shuffle the rows.
+ * @return The new dataframe, column i of it is the batch of column_idxs[i].
+ */
+CCV_WARN_UNUSED(ccv_cnnp_dataframe_t*) ccv_cnnp_dataframe_shuffled_batching_new(ccv_cnnp_dataframe_t* const dataframe, const int* const column_idxs, const int column_idx_size, const int batch_count, const int format, const uint32_t seed);
 /**
  * The opaque pointer to the iterator.
  */
@@ -2030,7 +2205,7 @@ typedef struct ccv_cnnp_dataframe_iter_s ccv_cnnp_dataframe_iter_t;
  */
 CCV_WARN_UNUSED(ccv_cnnp_dataframe_iter_t*) ccv_cnnp_dataframe_iter_new(ccv_cnnp_dataframe_t* const dataframe, const int* const column_idxs, const int column_idx_size);
 /**
- * Get the next item from the iterator.
+ * Get the next item from the iterator. If the item is prefetched, this waits for it to be ready, and hands it over.
  * @param iter The iterator to go through.
  * @param data_ref The output for the data.
  * @param column_idx_size The size of the data_ref array.
@@ -2039,13 +2214,37 @@ CCV_WARN_UNUSED(ccv_cnnp_dataframe_iter_t*) ccv_cnnp_dataframe_iter_new(ccv_cnnp
  */
 int ccv_cnnp_dataframe_iter_next(ccv_cnnp_dataframe_iter_t* const iter, void** const data_ref, const int column_idx_size, ccv_nnc_stream_context_t* const stream_context);
 /**
- * Prefetch next item on the iterator with the given stream context. You can call this method multiple times
- * to prefetch multiple items ahead of time.
+ * Prefetch next items on the iterator with the given stream context. You can call this method multiple times
+ * to prefetch more items ahead of time. If the stream context is a CPU stream context, the items are computed
+ * on the worker pool in the background, different items concurrently. Thus, the data enumeration and map
+ * functions need to be safe to call from multiple threads. Otherwise, they are computed before return.
+ * The data are reused from the stream context the same way as **ccv_cnnp_dataframe_iter_next**.
  * @param iter The iterator to go through.
+ * @param prefetch_count How many more items to prefetch.
  * @param stream_context The stream context to extract data asynchronously.
  * @return 0 if the prefetch is successful, -1 if it is ended.
  */
-int ccv_cnnp_dataframe_iter_prefetch(ccv_cnnp_dataframe_iter_t* const iter, ccv_nnc_stream_context_t* const stream_context);
+int ccv_cnnp_dataframe_iter_prefetch(ccv_cnnp_dataframe_iter_t* const iter, const int prefetch_count, ccv_nnc_stream_context_t* const stream_context);
+/**
+ * Go through rows in a shuffled order instead. Rows are grouped into blocks of consecutive rows, the blocks are
+ * shuffled, and then rows within each block. Thus, rows are still read close to each other. The blocks are
+ * dealt to shards in turn, with the same seed, each shard goes through different rows and all of them
+ * together cover the dataframe. The order is derived from the seed and the epoch only. This resets the
+ * iterator to the beginning of epoch 0.
+ * @param iter The iterator to go through.
+ * @param seed The seed to shuffle the rows.
+ * @param block_size How many consecutive rows are shuffled as a block.
+ * @param shard_idx Which shard this iterator goes through, from 0 to shard_count - 1.
+ * @param shard_count How many shards the rows are split into, 1 for no sharding.
+ */
+void ccv_cnnp_dataframe_iter_shuffle(ccv_cnnp_dataframe_iter_t* const iter, const uint32_t seed, const int block_size, const int shard_idx, const int shard_count);
+/**
+ * Reset the iterator to the beginning of the given epoch. If the iterator is shuffled, rows are in the order
+ * of that epoch. Items prefetched but not consumed yet are discarded.
+ * @param iter The iterator to go through.
+ * @param epoch The epoch to go through.
+ */
+void ccv_cnnp_dataframe_iter_set_epoch(ccv_cnnp_dataframe_iter_t* const iter, const int epoch);
 /**
  * Free the dataframe iterator object.
  * @param iter The dataframe iterator to be freed.
@@ -2188,6 +2387,13 @@ enum {
 	 * Only write parameters to disk.
 	 */
 	CCV_CNNP_MODEL_CHECKPOINT_WRITE_ONLY,
+	/**
+	 * Use a flat, memory-mapped file rather than SQLite, combined with one of the above. If the model is not
+	 * initialized, CPU tensors are bound to the mapped pages directly instead of copied. The pages are shared
+	 * with other processes that load the same file until written to (copy-on-write). If the file misses any
+	 * trainable tensor of an uninitialized model, nothing is loaded and the model initializes itself as usual.
+	 */
+	CCV_CNNP_MODEL_CHECKPOINT_MMAP = 0x10,
 };
 /**
  * This method checkpoint the given model. If the model is initialized, it will persist all parameters
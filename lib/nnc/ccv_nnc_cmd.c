@@ -1,11 +1,18 @@
 #include "ccv_nnc.h"
 #include "ccv_nnc_internal.h"
 #include "ccv_nnc_easy.h"
+#include "_ccv_nnc_stream.h"
+#include "cmd/_ccv_nnc_cpu_ref.h"
+#include "3rdparty/khash/khash.h"
+#include "3rdparty/siphash/siphash24.h"
+#include "3rdparty/sqlite3/sqlite3.h"
 #ifdef HAVE_CUDA
 #include "gpu/ccv_nnc_compat.h"
 #endif
 #include <time.h>
 #include <sys/time.h>
+#include <sys/utsname.h>
+#include <unistd.h>
 
 #ifdef __MACH__
 #include <mach/mach.h>
@@ -32,6 +39,11 @@ void ccv_nnc_init(void)
 	_ccv_nnc_cmd_init();
 }
 
+void ccv_nnc_deinit(void)
+{
+	ccv_nnc_stream_cpu_pool_free();
+}
+
 const char* ccv_nnc_cmd_name(const uint32_t cmd)
 {
 	switch (cmd)
@@ -224,7 +236,7 @@ void ccv_nnc_hint_tensor_auto_backward_from_inputs(const ccv_nnc_cmd_param_t cmd
 		outputs[i] = inputs[i + 1];
 }
 
-void ccv_nnc_hint_tensor_auto(const ccv_nnc_cmd_t cmd, const ccv_nnc_tensor_param_t* const inputs, const int input_size, const ccv_nnc_hint_t hint, ccv_nnc_tensor_param_t* const outputs, const int output_size)
+void ccv_nnc_hint_tensor_auto(const ccv_nnc_cmd_t cmd, const ccv_nnc_tensor_param_t* const inputs, int input_size, const ccv_nnc_hint_t hint, ccv_nnc_tensor_param_t* const outputs, const int output_size)
 {
 	// zero out the parameters
 	const ccv_nnc_tensor_param_t z = {};
@@ -236,6 +248,9 @@ void ccv_nnc_hint_tensor_auto(const ccv_nnc_cmd_t cmd, const ccv_nnc_tensor_para
 		return;
 	const int cmd_idx = _ccv_nnc_cmd_ph(cmd.cmd);
 	const ccv_nnc_cmd_registry_t registry = init_map[cmd_idx].registry;
+	// The inputs for the fused element-wise ops don't change the output shape.
+	if (cmd.info.epilogue.size)
+		input_size -= ccv_nnc_cmd_epilogue_input_size(cmd.info);
 	if (registry.tensor_auto)
 		registry.tensor_auto(cmd.info, inputs, input_size, hint, outputs, output_size);
 	else if (ccv_nnc_cmd_is_forward(cmd)) // For forward, the default auto is forward_from_inputs
@@ -248,6 +263,9 @@ int ccv_nnc_cmd_allow_inplace(const ccv_nnc_cmd_t cmd, const int input_idx, cons
 {
 	if (cmd.cmd == CCV_NNC_NOOP || cmd.cmd == CCV_NNC_CUSTOM_FORWARD || cmd.cmd == CCV_NNC_CUSTOM_BACKWARD || cmd.cmd == CCV_NNC_GRAPH_FORWARD || cmd.cmd == CCV_NNC_GRAPH_BACKWARD)
 		return 0;
+	// The fused element-wise ops read their inputs after the output is written.
+	if (cmd.info.epilogue.size)
+		return 0;
 	const int cmd_idx = _ccv_nnc_cmd_ph(cmd.cmd);
 	const ccv_nnc_cmd_registry_t registry = init_map[cmd_idx].registry;
 	if (registry.allow_inplace)
@@ -302,6 +320,224 @@ uint32_t ccv_nnc_cmd_find_backend(const ccv_nnc_cmd_t cmd, const int tensor_memo
 
 #define AUTO_TUNE_TRIAL_SIZE (3)
 
+typedef struct {
+	uint32_t backend;
+	int algorithm;
+} ccv_nnc_autotune_entry_t;
+
+KHASH_MAP_INIT_INT64(autotune, ccv_nnc_autotune_entry_t)
+
+// The autotune results are loaded from the database into memory when it is opened, and written through to the
+// database when a new command is tuned.
+static struct {
+	pthread_mutex_t mutex;
+	sqlite3* conn;
+	sqlite3_stmt* insert_stmt;
+	khash_t(autotune)* entries;
+	char cpu[128];
+} ccv_nnc_autotune_db = {
+	.mutex = PTHREAD_MUTEX_INITIALIZER,
+};
+
+static uint8_t key_siphash[16] = "autotunekvlibnnc";
+
+static void _ccv_nnc_autotune_cpu_model(char* const cpu, const size_t size)
+{
+	cpu[0] = 0;
+	FILE* const r = fopen("/proc/cpuinfo", "r");
+	if (r)
+	{
+		char line[256];
+		while (fgets(line, sizeof(line), r))
+			if (strncmp(line, "model name", 10) == 0)
+			{
+				const char* model = strchr(line, ':');
+				model = model ? model + 1 : line;
+				while (*model == ' ' || *model == '\t')
+					++model;
+				const size_t len = strcspn(model, "\n");
+				snprintf(cpu, size, "%.*s", (int)len, model);
+				break;
+			}
+		fclose(r);
+	}
+	if (!cpu[0])
+	{
+		struct utsname name;
+		if (uname(&name) == 0)
+			snprintf(cpu, size, "%s", name.machine);
+	}
+	// The number of cores matters as much as the model to which algorithm is the fastest.
+	const size_t len = strlen(cpu);
+	snprintf(cpu + len, size - len, "/%d", (int)sysconf(_SC_NPROCESSORS_ONLN));
+}
+
+static uint64_t _ccv_nnc_autotune_key(const ccv_nnc_cmd_t cmd, const size_t max_workspace_size, const ccv_nnc_hint_t hint, const int flags, ccv_nnc_tensor_t* const* const inputs, const int input_size, ccv_nnc_tensor_t* const* const outputs, const int output_size)
+{
+	// Everything that can change which backend / algorithm is the fastest (or can run at all) goes into the key.
+	typedef struct {
+		int exists;
+		int view;
+		ccv_nnc_tensor_param_t info;
+		int inc[CCV_NNC_MAX_DIM_ALLOC];
+	} ccv_nnc_autotune_key_tensor_t;
+	typedef struct {
+		uint32_t cmd;
+		int flags;
+		uint64_t max_workspace_size;
+		int input_size;
+		int output_size;
+		ccv_nnc_cmd_param_t info;
+		ccv_nnc_hint_t hint;
+		char cpu[128];
+		ccv_nnc_autotune_key_tensor_t tensors[1];
+	} ccv_nnc_autotune_key_t;
+	const size_t key_size = sizeof(ccv_nnc_autotune_key_t) + sizeof(ccv_nnc_autotune_key_tensor_t) * (input_size + output_size - 1);
+	ccv_nnc_autotune_key_t* const key = (ccv_nnc_autotune_key_t*)cccalloc(1, key_size);
+	key->cmd = cmd.cmd;
+	key->flags = flags;
+	key->max_workspace_size = max_workspace_size;
+	key->input_size = input_size;
+	key->output_size = output_size;
+	key->info = cmd.info;
+	key->hint = hint;
+	memcpy(key->cpu, ccv_nnc_autotune_db.cpu, sizeof(key->cpu));
+	int i;
+	for (i = 0; i < input_size + output_size; i++)
+	{
+		const ccv_nnc_tensor_t* const tensor = i < input_size ? inputs[i] : outputs[i - input_size];
+		if (!tensor)
+			continue;
+		key->tensors[i].exists = 1;
+		key->tensors[i].info = tensor->info;
+		if (CCV_IS_TENSOR_VIEW(tensor))
+		{
+			key->tensors[i].view = 1;
+			memcpy(key->tensors[i].inc, ((ccv_nnc_tensor_view_t*)tensor)->inc, sizeof(key->tensors[i].inc));
+		}
+	}
+	uint64_t hash;
+	siphash((uint8_t*)&hash, (const uint8_t*)key, key_size, key_siphash);
+	ccfree(key);
+	return hash;
+}
+
+int ccv_nnc_cmd_autotune_db_open(const char* const fn)
+{
+	pthread_mutex_lock(&ccv_nnc_autotune_db.mutex);
+	if (ccv_nnc_autotune_db.conn)
+	{
+		pthread_mutex_unlock(&ccv_nnc_autotune_db.mutex);
+		ccv_nnc_cmd_autotune_db_close();
+		pthread_mutex_lock(&ccv_nnc_autotune_db.mutex);
+	}
+	sqlite3* conn = 0;
+	if (SQLITE_OK != sqlite3_open(fn, &conn))
+	{
+		sqlite3_close(conn);
+		pthread_mutex_unlock(&ccv_nnc_autotune_db.mutex);
+		return -1;
+	}
+	const char autotune_create_table_qs[] = "CREATE TABLE IF NOT EXISTS autotune "
+		"(key INTEGER, cpu TEXT, backend INTEGER, algorithm INTEGER, PRIMARY KEY (key))";
+	const char autotune_select_qs[] =
+		"SELECT key, backend, algorithm FROM autotune WHERE cpu=$cpu";
+	const char autotune_insert_qs[] =
+		"REPLACE INTO autotune (key, cpu, backend, algorithm) VALUES ($key, $cpu, $backend, $algorithm)";
+	sqlite3_stmt* autotune_select_stmt = 0;
+	sqlite3_stmt* autotune_insert_stmt = 0;
+	if (SQLITE_OK != sqlite3_exec(conn, autotune_create_table_qs, 0, 0, 0) ||
+		SQLITE_OK != sqlite3_prepare_v2(conn, autotune_select_qs, sizeof(autotune_select_qs), &autotune_select_stmt, 0) ||
+		SQLITE_OK != sqlite3_prepare_v2(conn, autotune_insert_qs, sizeof(autotune_insert_qs), &autotune_insert_stmt, 0))
+	{
+		sqlite3_finalize(autotune_select_stmt);
+		sqlite3_finalize(autotune_insert_stmt);
+		sqlite3_close(conn);
+		pthread_mutex_unlock(&ccv_nnc_autotune_db.mutex);
+		return -1;
+	}
+	_ccv_nnc_autotune_cpu_model(ccv_nnc_autotune_db.cpu, sizeof(ccv_nnc_autotune_db.cpu));
+	khash_t(autotune)* const entries = kh_init(autotune);
+	sqlite3_bind_text(autotune_select_stmt, 1, ccv_nnc_autotune_db.cpu, -1, SQLITE_STATIC);
+	while (SQLITE_ROW == sqlite3_step(autotune_select_stmt))
+	{
+		int ret;
+		const khiter_t k = kh_put(autotune, entries, (uint64_t)sqlite3_column_int64(autotune_select_stmt, 0), &ret);
+		kh_val(entries, k).backend = (uint32_t)sqlite3_column_int64(autotune_select_stmt, 1);
+		kh_val(entries, k).algorithm = sqlite3_column_int(autotune_select_stmt, 2);
+	}
+	sqlite3_finalize(autotune_select_stmt);
+	ccv_nnc_autotune_db.conn = conn;
+	ccv_nnc_autotune_db.insert_stmt = autotune_insert_stmt;
+	ccv_nnc_autotune_db.entries = entries;
+	pthread_mutex_unlock(&ccv_nnc_autotune_db.mutex);
+	return 0;
+}
+
+void ccv_nnc_cmd_autotune_db_close(void)
+{
+	pthread_mutex_lock(&ccv_nnc_autotune_db.mutex);
+	if (ccv_nnc_autotune_db.conn)
+	{
+		sqlite3_finalize(ccv_nnc_autotune_db.insert_stmt);
+		sqlite3_close(ccv_nnc_autotune_db.conn);
+		kh_destroy(autotune, ccv_nnc_autotune_db.entries);
+		ccv_nnc_autotune_db.conn = 0;
+		ccv_nnc_autotune_db.insert_stmt = 0;
+		ccv_nnc_autotune_db.entries = 0;
+	}
+	pthread_mutex_unlock(&ccv_nnc_autotune_db.mutex);
+}
+
+static int _ccv_nnc_autotune_db_get(const int cmd_idx, const uint64_t key, ccv_nnc_cmd_t* const tuned_cmd)
+{
+	pthread_mutex_lock(&ccv_nnc_autotune_db.mutex);
+	if (!ccv_nnc_autotune_db.entries)
+	{
+		pthread_mutex_unlock(&ccv_nnc_autotune_db.mutex);
+		return 0;
+	}
+	const khiter_t k = kh_get(autotune, ccv_nnc_autotune_db.entries, key);
+	const int found = (k != kh_end(ccv_nnc_autotune_db.entries));
+	const ccv_nnc_autotune_entry_t entry = found ? kh_val(ccv_nnc_autotune_db.entries, k) : (ccv_nnc_autotune_entry_t){};
+	pthread_mutex_unlock(&ccv_nnc_autotune_db.mutex);
+	if (!found)
+		return 0;
+	// The database may come from a different build, only take what this build can run.
+	const int backend_idx = _ccv_nnc_cmd_backend_ph(entry.backend);
+	if (backend_idx < 0 || backend_idx >= CCV_NNC_BACKEND_COUNT || backend_init_map[backend_idx].backend != entry.backend)
+		return 0;
+	const ccv_nnc_cmd_backend_registry_t api_registry = init_map[cmd_idx].backends[backend_idx];
+	if (!api_registry.exec || entry.algorithm < -1 || (!api_registry.autotune && entry.algorithm >= api_registry.algorithms))
+		return 0;
+	tuned_cmd->backend = entry.backend;
+	tuned_cmd->algorithm = entry.algorithm;
+	return 1;
+}
+
+static void _ccv_nnc_autotune_db_put(const uint64_t key, const ccv_nnc_cmd_t tuned_cmd)
+{
+	pthread_mutex_lock(&ccv_nnc_autotune_db.mutex);
+	if (!ccv_nnc_autotune_db.entries)
+	{
+		pthread_mutex_unlock(&ccv_nnc_autotune_db.mutex);
+		return;
+	}
+	int ret;
+	const khiter_t k = kh_put(autotune, ccv_nnc_autotune_db.entries, key, &ret);
+	kh_val(ccv_nnc_autotune_db.entries, k).backend = tuned_cmd.backend;
+	kh_val(ccv_nnc_autotune_db.entries, k).algorithm = tuned_cmd.algorithm;
+	sqlite3_stmt* const autotune_insert_stmt = ccv_nnc_autotune_db.insert_stmt;
+	sqlite3_bind_int64(autotune_insert_stmt, 1, (sqlite3_int64)key);
+	sqlite3_bind_text(autotune_insert_stmt, 2, ccv_nnc_autotune_db.cpu, -1, SQLITE_STATIC);
+	sqlite3_bind_int64(autotune_insert_stmt, 3, tuned_cmd.backend);
+	sqlite3_bind_int(autotune_insert_stmt, 4, tuned_cmd.algorithm);
+	sqlite3_step(autotune_insert_stmt);
+	sqlite3_reset(autotune_insert_stmt);
+	sqlite3_clear_bindings(autotune_insert_stmt);
+	pthread_mutex_unlock(&ccv_nnc_autotune_db.mutex);
+}
+
 ccv_nnc_cmd_t ccv_nnc_cmd_autotune(const ccv_nnc_cmd_t cmd, const size_t max_workspace_size, const ccv_nnc_hint_t hint, const int flags, ccv_nnc_tensor_t* const* const inputs, const int input_size, ccv_nnc_tensor_t* const* const outputs, const int output_size, ccv_nnc_stream_context_t* const stream_context)
 {
 	// This is a custom cmd kernel, no need to autotune.
@@ -326,6 +562,19 @@ ccv_nnc_cmd_t ccv_nnc_cmd_autotune(const ccv_nnc_cmd_t cmd, const size_t max_wor
 	int64_t best_measured = -1;
 	const int cmd_idx = _ccv_nnc_cmd_ph(cmd.cmd);
 	assert(cmd_idx >= 0 && cmd_idx < sizeof(init_map) / sizeof(init_map[0]));
+	// If it is tuned before (in this process, or another one that shares the database), no need to run anything.
+	const int use_db = !!ccv_nnc_autotune_db.entries;
+	const uint64_t key = use_db ? _ccv_nnc_autotune_key(cmd, max_workspace_size, hint, flags, inputs, input_size, outputs, output_size) : 0;
+	if (use_db && _ccv_nnc_autotune_db_get(cmd_idx, key, &tuned_cmd))
+		return tuned_cmd;
+	// Run the candidates synchronously. On a CPU stream context, a kernel that refuses to run returns after the
+	// command is submitted, it would be mistaken as the fastest one.
+	ccv_nnc_stream_context_t* tune_stream_context = stream_context;
+	if (ccv_nnc_stream_context_is_cpu_async(stream_context))
+	{
+		ccv_nnc_stream_cpu_wait(stream_context);
+		tune_stream_context = 0;
+	}
 	// We need to have trial loop through all the data.
 	for (k = 0; k < AUTO_TUNE_TRIAL_SIZE; k++)
 	{
@@ -346,13 +595,14 @@ ccv_nnc_cmd_t ccv_nnc_cmd_autotune(const ccv_nnc_cmd_t cmd, const size_t max_wor
 					// Assuming k == 0 is sufficient, and we can skip.
 					if (k > 0)
 						continue;
-					candid_cmd.algorithm = api_registry.autotune(candid_cmd, max_workspace_size, hint, flags, inputs, input_size, outputs, output_size, stream_context);
+					candid_cmd.algorithm = api_registry.autotune(candid_cmd, max_workspace_size, hint, flags, inputs, input_size, outputs, output_size, tune_stream_context);
 					// Drain the context, autotune can use excessive amount of memory. Need to drain it now.
-					ccv_nnc_stream_context_drain(stream_context);
+					ccv_nnc_stream_context_drain(tune_stream_context);
 					uint64_t elapsed = ccv_nnc_cmd_mono_time();
 					// Ready to run.
-					int status = ccv_nnc_cmd_exec(candid_cmd, hint, flags, inputs, input_size, outputs, output_size, stream_context);
-					ccv_nnc_stream_context_wait(stream_context);
+					int status = ccv_nnc_cmd_exec(candid_cmd, hint, flags, inputs, input_size, outputs, output_size, tune_stream_context);
+					if (status == CCV_NNC_EXEC_SUCCESS)
+						status = ccv_nnc_stream_context_wait(tune_stream_context);
 					elapsed = ccv_nnc_cmd_mono_time() - elapsed;
 					if (status == CCV_NNC_EXEC_SUCCESS &&
 						(best_measured == -1 || elapsed < best_measured))
@@ -367,7 +617,9 @@ ccv_nnc_cmd_t ccv_nnc_cmd_autotune(const ccv_nnc_cmd_t cmd, const size_t max_wor
 						candid_cmd.algorithm = j;
 						uint64_t elapsed = ccv_nnc_cmd_mono_time();
 						// Ready to run.
-						int status = ccv_nnc_cmd_exec(candid_cmd, hint, flags, inputs, input_size, outputs, output_size, stream_context);
+						int status = ccv_nnc_cmd_exec(candid_cmd, hint, flags, inputs, input_size, outputs, output_size, tune_stream_context);
+						if (status == CCV_NNC_EXEC_SUCCESS)
+							status = ccv_nnc_stream_context_wait(tune_stream_context);
 						elapsed = ccv_nnc_cmd_mono_time() - elapsed;
 						if (status == CCV_NNC_EXEC_SUCCESS &&
 							(best_measured == -1 || elapsed < best_measured))
@@ -380,6 +632,8 @@ ccv_nnc_cmd_t ccv_nnc_cmd_autotune(const ccv_nnc_cmd_t cmd, const size_t max_wor
 			}
 		}
 	}
+	if (use_db && best_measured >= 0)
+		_ccv_nnc_autotune_db_put(key, tuned_cmd);
 	return tuned_cmd;
 }
 
@@ -393,6 +647,20 @@ int ccv_nnc_cmd_bitmask(const ccv_nnc_cmd_t cmd, const int input_size, const int
 		return 0;
 	const int cmd_idx = _ccv_nnc_cmd_ph(cmd.cmd);
 	const ccv_nnc_cmd_registry_t cmd_registry = init_map[cmd_idx].registry;
+	if (cmd.info.epilogue.size)
+	{
+		// All the inputs for the fused element-wise ops are required, check the rest as if these are not there.
+		const int epilogue_input_size = ccv_nnc_cmd_epilogue_input_size(cmd.info);
+		int i;
+		if (input_size <= epilogue_input_size)
+			return 0;
+		for (i = input_size - epilogue_input_size; i < input_size; i++)
+			if (!(input_bitmasks[i >> 6] & ((uint64_t)1 << (i & 63))))
+				return 0;
+		if (cmd_registry.bitmask)
+			return cmd_registry.bitmask(input_size - epilogue_input_size, output_size, input_bitmasks, input_bitmask_size, output_bitmasks, output_bitmask_size);
+		return 0;
+	}
 	if (cmd_registry.bitmask)
 		return cmd_registry.bitmask(input_size, output_size, input_bitmasks, input_bitmask_size, output_bitmasks, output_bitmask_size);
 	// If there is not checking, none can pass.
@@ -418,6 +686,59 @@ int ccv_nnc_device_id_for_io(ccv_nnc_tensor_t* const* const inputs, const int in
 	return device_id >= 0 ? device_id : default_device_id; // The default one.
 }
 
+// A command submitted to a CPU stream context returns before the kernel runs, thus, check what we can before that.
+static int _ccv_nnc_cmd_can_exec(const ccv_nnc_cmd_t cmd, const ccv_nnc_cmd_backend_registry_t api_registry, ccv_nnc_tensor_t* const* const inputs, const int input_size, ccv_nnc_tensor_t* const* const outputs, const int output_size)
+{
+	if (cmd.algorithm < -1 || (!api_registry.autotune && cmd.algorithm >= api_registry.algorithms))
+		return CCV_NNC_EXEC_INVALID;
+	int i;
+	int tensor_memory = 0, tensor_formats = 0, tensor_datatypes = 0;
+	uint64_t input_bitmasks[(input_size + 63) / 64 + 1];
+	uint64_t output_bitmasks[(output_size + 63) / 64 + 1];
+	memset(input_bitmasks, 0, sizeof(input_bitmasks));
+	memset(output_bitmasks, 0, sizeof(output_bitmasks));
+	for (i = 0; i < input_size; i++)
+		if (inputs[i])
+		{
+			tensor_memory |= CCV_TENSOR_GET_MEMORY(inputs[i]->info.type), tensor_formats |= inputs[i]->info.format, tensor_datatypes |= inputs[i]->info.datatype;
+			input_bitmasks[i >> 6] |= (uint64_t)1 << (i & 63);
+		}
+	for (i = 0; i < output_size; i++)
+		if (outputs[i])
+		{
+			tensor_memory |= CCV_TENSOR_GET_MEMORY(outputs[i]->info.type), tensor_formats |= outputs[i]->info.format, tensor_datatypes |= outputs[i]->info.datatype;
+			output_bitmasks[i >> 6] |= (uint64_t)1 << (i & 63);
+		}
+	if ((api_registry.tensor_memory & tensor_memory) != tensor_memory ||
+		(api_registry.tensor_formats & tensor_formats) != tensor_formats ||
+		(api_registry.tensor_datatypes & tensor_datatypes) != tensor_datatypes)
+		return CCV_NNC_EXEC_INVALID;
+	if (!ccv_nnc_cmd_bitmask(cmd, input_size, output_size, input_bitmasks, (input_size + 63) / 64, output_bitmasks, (output_size + 63) / 64))
+		return CCV_NNC_EXEC_INVALID;
+	return CCV_NNC_EXEC_SUCCESS;
+}
+
+// For the backends that don't apply the fused element-wise ops themselves, run the command without the inputs for
+// these, and then apply them as a separate pass.
+static int _ccv_nnc_cmd_exec_with_epilogue(const ccv_nnc_cmd_t cmd, const ccv_nnc_hint_t hint, const int flags, ccv_nnc_tensor_t* const* const inputs, const int input_size, ccv_nnc_tensor_t* const* const outputs, const int output_size, ccv_nnc_stream_context_t* const stream_context)
+{
+	const ccv_nnc_cmd_backend_registry_t api_registry = init_map[_ccv_nnc_cmd_ph(cmd.cmd)].backends[_ccv_nnc_cmd_backend_ph(cmd.backend)];
+	const int epilogue_input_size = ccv_nnc_cmd_epilogue_input_size(cmd.info);
+	assert(output_size == 1);
+	assert(CCV_TENSOR_GET_MEMORY(outputs[0]->info.type) == CCV_TENSOR_CPU_MEMORY);
+	if (CCV_IS_TENSOR_VIEW(outputs[0]))
+		return CCV_NNC_EXEC_INVALID;
+	ccv_nnc_cpu_epilogue_t epilogue;
+	int status = _ccv_nnc_cpu_epilogue_new(cmd.info, inputs + input_size - epilogue_input_size, epilogue_input_size, (ccv_nnc_tensor_view_t*)outputs[0], &epilogue);
+	if (status != CCV_NNC_EXEC_SUCCESS)
+		return status;
+	status = api_registry.exec(cmd, hint, flags, inputs, input_size - epilogue_input_size, outputs, output_size, stream_context);
+	if (status == CCV_NNC_EXEC_SUCCESS)
+		status = _ccv_nnc_cpu_epilogue_apply_all(&epilogue, (ccv_nnc_tensor_view_t*)outputs[0]);
+	_ccv_nnc_cpu_epilogue_free(&epilogue);
+	return status;
+}
+
 int ccv_nnc_cmd_exec(const ccv_nnc_cmd_t cmd, const ccv_nnc_hint_t hint, const int flags, ccv_nnc_tensor_t* const* const inputs, const int input_size, ccv_nnc_tensor_t* const* const outputs, const int output_size, ccv_nnc_stream_context_t* const stream_context)
 {
 	// If it is no-op, return as if succeed already.
@@ -430,9 +751,15 @@ int ccv_nnc_cmd_exec(const ccv_nnc_cmd_t cmd, const ccv_nnc_hint_t hint, const i
 	// If it is a custom command, just apply it directly.
 	if (cmd.cmd == CCV_NNC_CUSTOM_FORWARD || cmd.cmd == CCV_NNC_CUSTOM_BACKWARD)
 	{
+		// Submit to the worker pool if it is a CPU stream context.
+		if (ccv_nnc_stream_context_is_cpu_async(stream_context))
+		{
+			ccv_nnc_stream_cpu_exec(stream_context, cmd.exec, cmd, hint, flags, inputs, input_size, outputs, output_size);
+			return CCV_NNC_EXEC_SUCCESS;
+		}
 		int ret = cmd.exec(cmd, hint, flags, inputs, input_size, outputs, output_size, stream_context);
 		if (!stream_context)
-			ccv_nnc_stream_context_drain(stream_context);
+			ccv_nnc_stream_context_trim(stream_context, ccv_nnc_stream_workspace_limit());
 		return ret;
 	}
 	assert(cmd.cmd != CCV_NNC_GRAPH_FORWARD && cmd.cmd != CCV_NNC_GRAPH_BACKWARD);
@@ -458,10 +785,37 @@ int ccv_nnc_cmd_exec(const ccv_nnc_cmd_t cmd, const ccv_nnc_hint_t hint, const i
 	const ccv_nnc_cmd_backend_registry_t api_registry = init_map[cmd_idx].backends[backend_idx];
 	if (!api_registry.exec)
 		return CCV_NNC_EXEC_NO_KERNEL;
+	// The failures after this are recorded on the stream context, and returned from ccv_nnc_stream_context_wait.
+	if (ccv_nnc_stream_context_is_cpu_async(stream_context))
+	{
+		const int status = _ccv_nnc_cmd_can_exec(cmd, api_registry, inputs, input_size, outputs, output_size);
+		if (status != CCV_NNC_EXEC_SUCCESS)
+			return status;
+	}
+	if (cmd.info.epilogue.size && !api_registry.epilogue)
+	{
+		ccv_nnc_cmd_t epilogue_cmd = cmd;
+		epilogue_cmd.backend = backend;
+		if (ccv_nnc_stream_context_is_cpu_async(stream_context))
+		{
+			ccv_nnc_stream_cpu_exec(stream_context, _ccv_nnc_cmd_exec_with_epilogue, epilogue_cmd, hint, flags, inputs, input_size, outputs, output_size);
+			return CCV_NNC_EXEC_SUCCESS;
+		}
+		int ret = _ccv_nnc_cmd_exec_with_epilogue(epilogue_cmd, hint, flags, inputs, input_size, outputs, output_size, stream_context);
+		if (!stream_context)
+			ccv_nnc_stream_context_trim(stream_context, ccv_nnc_stream_workspace_limit());
+		return ret;
+	}
 	// Everything is out, call the underlying implementation.
+	if (ccv_nnc_stream_context_is_cpu_async(stream_context))
+	{
+		ccv_nnc_stream_cpu_exec(stream_context, api_registry.exec, cmd, hint, flags, inputs, input_size, outputs, output_size);
+		return CCV_NNC_EXEC_SUCCESS;
+	}
 	int ret = api_registry.exec(cmd, hint, flags, inputs, input_size, outputs, output_size, stream_context);
+	// Keep the workspace for the next command executed without a stream context, as long as it is within the limit.
 	if (!stream_context)
-		ccv_nnc_stream_context_drain(stream_context);
+		ccv_nnc_stream_context_trim(stream_context, ccv_nnc_stream_workspace_limit());
 	return ret;
 }
 
@@ -36,10 +36,44 @@ typedef struct {
 	int tensor_datatypes; /**< [datatypes] The supported data types for this API implementation. */
 	int tensor_memory; /**< [memory] The supported tensor memory type for this API implementation. */
 	int algorithms; /**< [algorithms] Number of algorithms variation. */
+	int epilogue; /**< [epilogue] Whether this API implementation applies the fused element-wise ops (cmd.info.epilogue) itself. */
 	ccv_nnc_cmd_exec_f exec;
 	ccv_nnc_cmd_autotune_f autotune;
 } ccv_nnc_cmd_backend_registry_t;
 
+/**
+ * The number of inputs the epilogue takes, these are the last inputs of the command.
+ */
+static inline int ccv_nnc_cmd_epilogue_input_size(const ccv_nnc_cmd_param_t cmd)
+{
+	int i;
+	int input_size = 0;
+	for (i = 0; i < cmd.epilogue.size; i++)
+		if (cmd.epilogue.ops[i].type == CCV_NNC_EPILOGUE_EWSUM || cmd.epilogue.ops[i].type == CCV_NNC_EPILOGUE_EWPROD)
+			++input_size;
+		else if (cmd.epilogue.ops[i].type == CCV_NNC_EPILOGUE_BATCH_NORM)
+			input_size += 4;
+	return input_size;
+}
+
+/**
+ * Compute data derived from a constant into a 16-byte aligned buffer.
+ */
+typedef void (*ccv_nnc_constant_derive_f)(void* const data, const void* const context);
+/**
+ * Get the data derived from a constant, for example, the weights transformed for a kernel. It is kept by the
+ * tensor arena that owns the constant, computed with derive on first use and freed along with the arena. derive runs
+ * without any lock held, if several threads derive the same data at once, only the first one to finish is kept.
+ * @param constant_sig The signature of the constant tensor.
+ * @param constant_data The data of the constant tensor, only the arena's own copy of the constant matches.
+ * @param sig The signature of the derived data, it should be derived from constant_sig.
+ * @param size The size of the derived data in bytes.
+ * @param derive The function to compute the derived data.
+ * @param context The context passed to derive.
+ * @return 0 if no tensor arena owns this constant, the caller has to derive the data itself then.
+ */
+void* ccv_nnc_constant_derived(const uint64_t constant_sig, const void* const constant_data, const uint64_t sig, const size_t size, ccv_nnc_constant_derive_f derive, const void* const context);
+
 static inline int ccv_nnc_tensor_hw(const ccv_nnc_tensor_param_t a, const int nd)
 {
 	if ((a.format == CCV_TENSOR_FORMAT_CHWN) ||
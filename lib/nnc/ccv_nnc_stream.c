@@ -5,24 +5,454 @@
 #include "gpu/ccv_nnc_compat.h"
 #endif
 #include "_ccv_nnc_stream.h"
+#include <unistd.h>
+
+enum {
+	CCV_NNC_STREAM_CPU_JOB_EXEC,
+	CCV_NNC_STREAM_CPU_JOB_EMIT,
+	CCV_NNC_STREAM_CPU_JOB_WAIT,
+	CCV_NNC_STREAM_CPU_JOB_CALLBACK,
+};
+
+typedef struct ccv_nnc_stream_cpu_job_s ccv_nnc_stream_cpu_job_t;
+
+struct ccv_nnc_stream_cpu_job_s {
+	int type;
+	ccv_nnc_stream_cpu_job_t* next;
+	union {
+		struct {
+			ccv_nnc_cmd_exec_f func;
+			ccv_nnc_cmd_t cmd;
+			ccv_nnc_hint_t hint;
+			int flags;
+			int input_size;
+			int output_size;
+			ccv_nnc_tensor_t** tensors;
+		} exec;
+		struct {
+			ccv_nnc_stream_signal_t* signal;
+			uint64_t count;
+		} signal;
+		struct {
+			ccv_nnc_stream_cpu_callback_f func;
+			void* userdata;
+		} callback;
+	};
+};
 
 typedef struct {
 	ccv_nnc_stream_context_t super;
-	// Left for implementation yet, the CPU support for stream context.
-	size_t workspace_size;
-	void* workspace;
+	// The workspace has to be the first, it matches the layout of the compat stream context.
+	ccv_nnc_stream_workspace_t workspace;
+	// Jobs submitted to a CPU stream context are executed in order by the worker pool. Different CPU stream
+	// contexts can be picked up by different workers, therefore, they run concurrently.
+	int scheduled; // Whether this stream is on a worker deque, executing, or blocked by a signal.
+	int status; // The first failure of the commands executed since the last ccv_nnc_stream_context_wait.
+	ccv_nnc_stream_cpu_job_t* head;
+	ccv_nnc_stream_cpu_job_t* tail;
+	pthread_mutex_t mutex;
+	pthread_cond_t notify;
 } ccv_nnc_stream_cpu_t;
 
+#define CCV_NNC_STREAM_CPU_MAX_WORKER_SIZE (256)
+
+// Each worker owns a deque of runnable streams. The owner pushes / pops from the bottom, other workers
+// steal from the top.
+typedef struct {
+	pthread_t thread;
+	pthread_mutex_t mutex;
+	int top;
+	int bottom;
+	int size;
+	ccv_nnc_stream_cpu_t** streams;
+} ccv_nnc_stream_cpu_worker_t;
+
+typedef struct {
+	int worker_size;
+	int shutdown; // The workers exit once there is no runnable stream.
+	int next; // The next worker to submit to if the submission is not from within the pool.
+	int ready; // How many runnable streams are on the deques.
+	int signal_wait_count; // How many jobs are waiting for a signal inline (thus, blocking a worker).
+	pthread_mutex_t mutex;
+	pthread_cond_t notify;
+	pthread_mutex_t signal_mutex; // Protect the fire count and the waiters of signals.
+	ccv_nnc_stream_cpu_worker_t* workers;
+} ccv_nnc_stream_cpu_pool_t;
+
+static ccv_nnc_stream_cpu_pool_t ccv_nnc_stream_cpu_pool;
+static pthread_mutex_t ccv_nnc_stream_cpu_pool_mutex = PTHREAD_MUTEX_INITIALIZER; // Protect the pool from being started and freed at the same time.
+static __thread ccv_nnc_stream_cpu_worker_t* ccv_nnc_stream_cpu_current_worker = 0;
+static __thread ccv_nnc_stream_cpu_t* ccv_nnc_stream_cpu_current_stream = 0;
+
+static void _ccv_nnc_stream_cpu_worker_push(ccv_nnc_stream_cpu_worker_t* const worker, ccv_nnc_stream_cpu_t* const stream_cpu)
+{
+	pthread_mutex_lock(&worker->mutex);
+	if (worker->bottom - worker->top >= worker->size)
+	{
+		// Grow the deque, and lay the streams out from 0 again.
+		const int new_size = worker->size * 2;
+		ccv_nnc_stream_cpu_t** const streams = (ccv_nnc_stream_cpu_t**)ccmalloc(sizeof(ccv_nnc_stream_cpu_t*) * new_size);
+		int i;
+		for (i = worker->top; i < worker->bottom; i++)
+			streams[i - worker->top] = worker->streams[i & (worker->size - 1)];
+		ccfree(worker->streams);
+		worker->streams = streams;
+		worker->bottom -= worker->top;
+		worker->top = 0;
+		worker->size = new_size;
+	}
+	worker->streams[worker->bottom & (worker->size - 1)] = stream_cpu;
+	++worker->bottom;
+	pthread_mutex_unlock(&worker->mutex);
+}
+
+static ccv_nnc_stream_cpu_t* _ccv_nnc_stream_cpu_worker_pop(ccv_nnc_stream_cpu_worker_t* const worker)
+{
+	ccv_nnc_stream_cpu_t* stream_cpu = 0;
+	pthread_mutex_lock(&worker->mutex);
+	if (worker->bottom > worker->top)
+	{
+		--worker->bottom;
+		stream_cpu = worker->streams[worker->bottom & (worker->size - 1)];
+	}
+	pthread_mutex_unlock(&worker->mutex);
+	return stream_cpu;
+}
+
+static ccv_nnc_stream_cpu_t* _ccv_nnc_stream_cpu_worker_steal(ccv_nnc_stream_cpu_worker_t* const worker)
+{
+	ccv_nnc_stream_cpu_t* stream_cpu = 0;
+	pthread_mutex_lock(&worker->mutex);
+	if (worker->bottom > worker->top)
+	{
+		stream_cpu = worker->streams[worker->top & (worker->size - 1)];
+		++worker->top;
+	}
+	pthread_mutex_unlock(&worker->mutex);
+	return stream_cpu;
+}
+
+// Put a stream onto a deque, preferably the one of the current worker, thus, the follow-up work stays on the same core.
+static void _ccv_nnc_stream_cpu_make_ready(ccv_nnc_stream_cpu_t* const stream_cpu)
+{
+	ccv_nnc_stream_cpu_pool_t* const pool = &ccv_nnc_stream_cpu_pool;
+	ccv_nnc_stream_cpu_worker_t* worker = ccv_nnc_stream_cpu_current_worker;
+	if (!worker)
+		worker = pool->workers + (unsigned int)__sync_fetch_and_add(&pool->next, 1) % pool->worker_size;
+	_ccv_nnc_stream_cpu_worker_push(worker, stream_cpu);
+	pthread_mutex_lock(&pool->mutex);
+	++pool->ready;
+	pthread_cond_signal(&pool->notify);
+	pthread_mutex_unlock(&pool->mutex);
+}
+
+static void _ccv_nnc_stream_cpu_fire_signal(ccv_nnc_stream_signal_t* const signal, const uint64_t count)
+{
+	ccv_nnc_stream_cpu_pool_t* const pool = &ccv_nnc_stream_cpu_pool;
+	pthread_mutex_lock(&pool->signal_mutex);
+	if (count > signal->fire_count)
+		signal->fire_count = count;
+	ccv_array_t* const waiters = signal->waiters;
+	signal->waiters = 0;
+	pthread_mutex_unlock(&pool->signal_mutex);
+	// Wake up the workers that wait for a signal inline.
+	pthread_mutex_lock(&pool->mutex);
+	if (pool->signal_wait_count)
+		pthread_cond_broadcast(&pool->notify);
+	pthread_mutex_unlock(&pool->mutex);
+	if (!waiters)
+		return;
+	int i;
+	// These are still marked as scheduled, therefore, simply put them back onto the deque.
+	for (i = 0; i < waiters->rnum; i++)
+		_ccv_nnc_stream_cpu_make_ready(*(ccv_nnc_stream_cpu_t**)ccv_array_get(waiters, i));
+	ccv_array_free(waiters);
+}
+
+static void _ccv_nnc_stream_cpu_run(ccv_nnc_stream_cpu_t* const stream_cpu)
+{
+	ccv_nnc_stream_cpu_pool_t* const pool = &ccv_nnc_stream_cpu_pool;
+	// A worker can run another stream while a job waits for a signal inline, restore the current stream afterwards.
+	ccv_nnc_stream_cpu_t* const current_stream = ccv_nnc_stream_cpu_current_stream;
+	ccv_nnc_stream_cpu_current_stream = stream_cpu;
+	for (;;)
+	{
+		pthread_mutex_lock(&stream_cpu->mutex);
+		ccv_nnc_stream_cpu_job_t* const job = stream_cpu->head;
+		if (!job)
+		{
+			stream_cpu->scheduled = 0;
+			pthread_cond_broadcast(&stream_cpu->notify);
+			pthread_mutex_unlock(&stream_cpu->mutex);
+			break;
+		}
+		if (job->type == CCV_NNC_STREAM_CPU_JOB_WAIT)
+		{
+			ccv_nnc_stream_signal_t* const signal = job->signal.signal;
+			pthread_mutex_lock(&pool->signal_mutex);
+			if (signal->fire_count < job->signal.count)
+			{
+				// Park this stream on the signal, it will be put back onto a deque once the signal fires.
+				if (!signal->waiters)
+					signal->waiters = ccv_array_new(sizeof(ccv_nnc_stream_cpu_t*), 1, 0);
+				ccv_array_push(signal->waiters, &stream_cpu);
+				pthread_mutex_unlock(&pool->signal_mutex);
+				pthread_mutex_unlock(&stream_cpu->mutex);
+				break;
+			}
+			pthread_mutex_unlock(&pool->signal_mutex);
+		}
+		stream_cpu->head = job->next;
+		if (!stream_cpu->head)
+			stream_cpu->tail = 0;
+		pthread_mutex_unlock(&stream_cpu->mutex);
+		switch (job->type)
+		{
+			case CCV_NNC_STREAM_CPU_JOB_EXEC: {
+				const int status = job->exec.func(job->exec.cmd, job->exec.hint, job->exec.flags, job->exec.tensors, job->exec.input_size, job->exec.tensors + job->exec.input_size, job->exec.output_size, (ccv_nnc_stream_context_t*)stream_cpu);
+				// Nobody waits for the return value, keep it for ccv_nnc_stream_context_wait.
+				if (status != CCV_NNC_EXEC_SUCCESS)
+				{
+					pthread_mutex_lock(&stream_cpu->mutex);
+					if (stream_cpu->status == CCV_NNC_EXEC_SUCCESS)
+						stream_cpu->status = status;
+					pthread_mutex_unlock(&stream_cpu->mutex);
+				}
+				break;
+			}
+			case CCV_NNC_STREAM_CPU_JOB_EMIT:
+				_ccv_nnc_stream_cpu_fire_signal(job->signal.signal, job->signal.count);
+				break;
+			case CCV_NNC_STREAM_CPU_JOB_CALLBACK:
+				job->callback.func(job->callback.userdata);
+				break;
+		}
+		ccfree(job);
+	}
+	ccv_nnc_stream_cpu_current_stream = current_stream;
+}
+
+static ccv_nnc_stream_cpu_t* _ccv_nnc_stream_cpu_worker_next(ccv_nnc_stream_cpu_worker_t* const worker)
+{
+	ccv_nnc_stream_cpu_pool_t* const pool = &ccv_nnc_stream_cpu_pool;
+	const int worker_idx = (int)(worker - pool->workers);
+	// There is a runnable stream claimed for us, check our own deque first, then steal from others.
+	ccv_nnc_stream_cpu_t* stream_cpu = _ccv_nnc_stream_cpu_worker_pop(worker);
+	int i;
+	for (i = 1; !stream_cpu; i++)
+		stream_cpu = _ccv_nnc_stream_cpu_worker_steal(pool->workers + (worker_idx + i) % pool->worker_size);
+	return stream_cpu;
+}
+
+// A job waits for a signal on the stream it is executing on. The stream cannot be parked (the job is halfway through),
+// therefore, block until the signal fires. The worker keeps running other runnable streams meanwhile, otherwise
+// the stream that emits the signal may never get a worker.
+static void _ccv_nnc_stream_cpu_wait_signal_inline(ccv_nnc_stream_signal_t* const signal, const uint64_t count)
+{
+	ccv_nnc_stream_cpu_pool_t* const pool = &ccv_nnc_stream_cpu_pool;
+	ccv_nnc_stream_cpu_worker_t* const worker = ccv_nnc_stream_cpu_current_worker;
+	assert(worker);
+	pthread_mutex_lock(&pool->mutex);
+	++pool->signal_wait_count;
+	for (;;)
+	{
+		pthread_mutex_lock(&pool->signal_mutex);
+		const int fired = signal->fire_count >= count;
+		pthread_mutex_unlock(&pool->signal_mutex);
+		if (fired)
+			break;
+		if (pool->ready > 0)
+		{
+			--pool->ready;
+			pthread_mutex_unlock(&pool->mutex);
+			_ccv_nnc_stream_cpu_run(_ccv_nnc_stream_cpu_worker_next(worker));
+			pthread_mutex_lock(&pool->mutex);
+			continue;
+		}
+		pthread_cond_wait(&pool->notify, &pool->mutex);
+	}
+	--pool->signal_wait_count;
+	pthread_mutex_unlock(&pool->mutex);
+}
+
+static void* _ccv_nnc_stream_cpu_worker_main(void* userdata)
+{
+	ccv_nnc_stream_cpu_pool_t* const pool = &ccv_nnc_stream_cpu_pool;
+	ccv_nnc_stream_cpu_worker_t* const worker = (ccv_nnc_stream_cpu_worker_t*)userdata;
+	ccv_nnc_stream_cpu_current_worker = worker;
+	for (;;)
+	{
+		pthread_mutex_lock(&pool->mutex);
+		while (pool->ready == 0 && !pool->shutdown)
+			pthread_cond_wait(&pool->notify, &pool->mutex);
+		if (pool->ready == 0)
+		{
+			pthread_mutex_unlock(&pool->mutex);
+			break;
+		}
+		--pool->ready;
+		pthread_mutex_unlock(&pool->mutex);
+		_ccv_nnc_stream_cpu_run(_ccv_nnc_stream_cpu_worker_next(worker));
+	}
+	return 0;
+}
+
+static void _ccv_nnc_stream_cpu_pool_init(void)
+{
+	ccv_nnc_stream_cpu_pool_t* const pool = &ccv_nnc_stream_cpu_pool;
+	// One worker per online core.
+	const long core_count = sysconf(_SC_NPROCESSORS_ONLN);
+	pool->worker_size = ccv_max(1, ccv_min((int)core_count, CCV_NNC_STREAM_CPU_MAX_WORKER_SIZE));
+	pool->shutdown = 0;
+	pool->next = 0;
+	pool->ready = 0;
+	pool->signal_wait_count = 0;
+	pthread_mutex_init(&pool->mutex, 0);
+	pthread_cond_init(&pool->notify, 0);
+	pthread_mutex_init(&pool->signal_mutex, 0);
+	ccv_nnc_stream_cpu_worker_t* const workers = (ccv_nnc_stream_cpu_worker_t*)cccalloc(pool->worker_size, sizeof(ccv_nnc_stream_cpu_worker_t));
+	int i;
+	for (i = 0; i < pool->worker_size; i++)
+	{
+		ccv_nnc_stream_cpu_worker_t* const worker = workers + i;
+		pthread_mutex_init(&worker->mutex, 0);
+		worker->size = 16;
+		worker->streams = (ccv_nnc_stream_cpu_t**)ccmalloc(sizeof(ccv_nnc_stream_cpu_t*) * worker->size);
+	}
+	// Publish the workers before these start, the submissions check it without the lock.
+	__atomic_store_n(&pool->workers, workers, __ATOMIC_RELEASE);
+	for (i = 0; i < pool->worker_size; i++)
+		pthread_create(&workers[i].thread, 0, _ccv_nnc_stream_cpu_worker_main, workers + i);
+}
+
+void ccv_nnc_stream_cpu_pool_free(void)
+{
+	ccv_nnc_stream_cpu_pool_t* const pool = &ccv_nnc_stream_cpu_pool;
+	pthread_mutex_lock(&ccv_nnc_stream_cpu_pool_mutex);
+	if (!pool->workers)
+	{
+		pthread_mutex_unlock(&ccv_nnc_stream_cpu_pool_mutex);
+		return;
+	}
+	pthread_mutex_lock(&pool->mutex);
+	pool->shutdown = 1;
+	pthread_cond_broadcast(&pool->notify);
+	pthread_mutex_unlock(&pool->mutex);
+	int i;
+	for (i = 0; i < pool->worker_size; i++)
+		pthread_join(pool->workers[i].thread, 0);
+	for (i = 0; i < pool->worker_size; i++)
+	{
+		pthread_mutex_destroy(&pool->workers[i].mutex);
+		ccfree(pool->workers[i].streams);
+	}
+	ccfree(pool->workers);
+	pool->workers = 0;
+	pthread_mutex_destroy(&pool->mutex);
+	pthread_cond_destroy(&pool->notify);
+	pthread_mutex_destroy(&pool->signal_mutex);
+	pthread_mutex_unlock(&ccv_nnc_stream_cpu_pool_mutex);
+}
+
+static void _ccv_nnc_stream_cpu_submit(ccv_nnc_stream_cpu_t* const stream_cpu, ccv_nnc_stream_cpu_job_t* const job)
+{
+	// Start the worker pool on the first submission (or the first after it is freed).
+	if (!__atomic_load_n(&ccv_nnc_stream_cpu_pool.workers, __ATOMIC_ACQUIRE))
+	{
+		pthread_mutex_lock(&ccv_nnc_stream_cpu_pool_mutex);
+		if (!ccv_nnc_stream_cpu_pool.workers)
+			_ccv_nnc_stream_cpu_pool_init();
+		pthread_mutex_unlock(&ccv_nnc_stream_cpu_pool_mutex);
+	}
+	job->next = 0;
+	pthread_mutex_lock(&stream_cpu->mutex);
+	if (stream_cpu->tail)
+		stream_cpu->tail->next = job;
+	else
+		stream_cpu->head = job;
+	stream_cpu->tail = job;
+	const int make_ready = !stream_cpu->scheduled;
+	stream_cpu->scheduled = 1;
+	pthread_mutex_unlock(&stream_cpu->mutex);
+	if (make_ready)
+		_ccv_nnc_stream_cpu_make_ready(stream_cpu);
+}
+
+static void _ccv_nnc_stream_cpu_wait(ccv_nnc_stream_cpu_t* const stream_cpu)
+{
+	// If we are the one executing it, there is nothing to wait.
+	if (stream_cpu == ccv_nnc_stream_cpu_current_stream)
+		return;
+	pthread_mutex_lock(&stream_cpu->mutex);
+	while (stream_cpu->scheduled)
+		pthread_cond_wait(&stream_cpu->notify, &stream_cpu->mutex);
+	pthread_mutex_unlock(&stream_cpu->mutex);
+}
+
+static int _ccv_nnc_stream_context_is_cpu_current(const ccv_nnc_stream_context_t* const stream_context)
+{
+	return stream_context && stream_context == (ccv_nnc_stream_context_t*)ccv_nnc_stream_cpu_current_stream;
+}
+
+int ccv_nnc_stream_context_is_cpu_async(const ccv_nnc_stream_context_t* const stream_context)
+{
+	return stream_context && CCV_STREAM_GET_CONTEXT(stream_context->type) == CCV_STREAM_CONTEXT_CPU && stream_context != (ccv_nnc_stream_context_t*)ccv_nnc_stream_cpu_current_stream;
+}
+
+void ccv_nnc_stream_cpu_exec(ccv_nnc_stream_context_t* const stream_context, const ccv_nnc_cmd_exec_f func, const ccv_nnc_cmd_t cmd, const ccv_nnc_hint_t hint, const int flags, ccv_nnc_tensor_t* const* const inputs, const int input_size, ccv_nnc_tensor_t* const* const outputs, const int output_size)
+{
+	assert(ccv_nnc_stream_context_is_cpu_async(stream_context));
+	const int tensor_size = input_size + output_size;
+	ccv_nnc_stream_cpu_job_t* const job = (ccv_nnc_stream_cpu_job_t*)ccmalloc(sizeof(ccv_nnc_stream_cpu_job_t) + (sizeof(ccv_nnc_tensor_t*) + sizeof(ccv_nnc_tensor_view_t)) * tensor_size);
+	job->type = CCV_NNC_STREAM_CPU_JOB_EXEC;
+	job->exec.func = func;
+	job->exec.cmd = cmd;
+	job->exec.hint = hint;
+	job->exec.flags = flags;
+	job->exec.input_size = input_size;
+	job->exec.output_size = output_size;
+	job->exec.tensors = (ccv_nnc_tensor_t**)(job + 1);
+	// The tensor headers can be updated (multi-view unwrap for example) before this job gets executed, snapshot
+	// them the same way a GPU stream captures the pointers at launch time. The same tensor maps to the same snapshot.
+	ccv_nnc_tensor_view_t* const snapshots = (ccv_nnc_tensor_view_t*)(job->exec.tensors + tensor_size);
+	int i, j;
+	for (i = 0; i < tensor_size; i++)
+	{
+		ccv_nnc_tensor_t* const tensor = i < input_size ? inputs[i] : outputs[i - input_size];
+		job->exec.tensors[i] = 0;
+		if (!tensor)
+			continue;
+		for (j = 0; !job->exec.tensors[i] && j < i; j++)
+			if ((j < input_size ? inputs[j] : outputs[j - input_size]) == tensor)
+				job->exec.tensors[i] = job->exec.tensors[j];
+		if (job->exec.tensors[i])
+			continue;
+		memcpy(snapshots + i, tensor, CCV_IS_TENSOR_VIEW(tensor) ? sizeof(ccv_nnc_tensor_view_t) : sizeof(ccv_nnc_tensor_t));
+		job->exec.tensors[i] = (ccv_nnc_tensor_t*)(snapshots + i);
+	}
+	_ccv_nnc_stream_cpu_submit((ccv_nnc_stream_cpu_t*)stream_context, job);
+}
+
+void ccv_nnc_stream_cpu_add_callback(ccv_nnc_stream_context_t* const stream_context, const ccv_nnc_stream_cpu_callback_f func, void* const userdata)
+{
+	assert(ccv_nnc_stream_context_is_cpu_async(stream_context));
+	ccv_nnc_stream_cpu_job_t* const job = (ccv_nnc_stream_cpu_job_t*)ccmalloc(sizeof(ccv_nnc_stream_cpu_job_t));
+	job->type = CCV_NNC_STREAM_CPU_JOB_CALLBACK;
+	job->callback.func = func;
+	job->callback.userdata = userdata;
+	_ccv_nnc_stream_cpu_submit((ccv_nnc_stream_cpu_t*)stream_context, job);
+}
+
 ccv_nnc_stream_context_t* ccv_nnc_stream_context_new(const int type)
 {
 	ccv_nnc_stream_cpu_t* const stream_cpu = (ccv_nnc_stream_cpu_t*)cccalloc(1, sizeof(ccv_nnc_stream_cpu_t));
 	stream_cpu->super.type = type;
-	stream_cpu->workspace_size = 0;
-	stream_cpu->workspace = 0;
 #ifdef HAVE_CUDA
 	if (CCV_STREAM_GET_CONTEXT(type) == CCV_STREAM_CONTEXT_GPU)
 		return ccv_nnc_init_stream_context((ccv_nnc_stream_context_t*)stream_cpu);
 #endif
+	pthread_mutex_init(&stream_cpu->mutex, 0);
+	pthread_cond_init(&stream_cpu->notify, 0);
 	return (ccv_nnc_stream_context_t*)stream_cpu;
 }
 
@@ -34,47 +464,140 @@ static __thread ccv_nnc_stream_cpu_t ccv_nnc_per_thread_stream_cpu = {
 };
 #endif
 
-void* ccv_nnc_stream_context_get_workspace(ccv_nnc_stream_context_t* const stream_context, const size_t workspace_size, const int mem)
+void* ccv_nnc_stream_workspace_get(ccv_nnc_stream_workspace_t* const workspace, const size_t size)
+{
+	++workspace->request_count;
+	workspace->grow_size = ccv_max(workspace->grow_size, size);
+	workspace->high_water_mark = ccv_max(workspace->high_water_mark, size);
+	if (workspace->size >= size)
+		return workspace->ptr;
+	++workspace->alloc_count;
+	if (workspace->ptr)
+		ccfree(workspace->ptr);
+	workspace->ptr = 0;
+	// Grow to the largest size since the last trim, thus, alternating between a smaller and a larger request won't reallocate.
+	if (ccmemalign(&workspace->ptr, 16, workspace->grow_size) != 0)
+	{
+		workspace->ptr = 0;
+		workspace->size = 0;
+		return 0;
+	}
+	workspace->size = workspace->grow_size;
+	return workspace->ptr;
+}
+
+void ccv_nnc_stream_workspace_trim(ccv_nnc_stream_workspace_t* const workspace, const size_t max_size)
+{
+	workspace->grow_size = 0;
+	if (workspace->size <= max_size)
+		return;
+	ccfree(workspace->ptr);
+	workspace->ptr = 0;
+	workspace->size = 0;
+}
+
+static pthread_once_t ccv_nnc_per_thread_workspace_once = PTHREAD_ONCE_INIT;
+static pthread_key_t ccv_nnc_per_thread_workspace_key;
+
+static void _ccv_nnc_per_thread_workspace_free(void* const workspace)
+{
+	ccv_nnc_stream_workspace_trim((ccv_nnc_stream_workspace_t*)workspace, 0);
+}
+
+static void _ccv_nnc_per_thread_workspace_key_new(void)
+{
+	pthread_key_create(&ccv_nnc_per_thread_workspace_key, _ccv_nnc_per_thread_workspace_free);
+}
+
+void ccv_nnc_stream_workspace_per_thread(ccv_nnc_stream_workspace_t* const workspace)
+{
+	pthread_once(&ccv_nnc_per_thread_workspace_once, _ccv_nnc_per_thread_workspace_key_new);
+	if (!pthread_getspecific(ccv_nnc_per_thread_workspace_key))
+		pthread_setspecific(ccv_nnc_per_thread_workspace_key, workspace);
+}
+
+static ccv_nnc_stream_workspace_t* _ccv_nnc_stream_context_cpu_workspace(const ccv_nnc_stream_context_t* const stream_context)
 {
 #ifdef HAVE_CUDA
-	return ccv_nnc_stream_compat_get_workspace(stream_context, workspace_size, mem);
+	return ccv_nnc_stream_compat_cpu_workspace(stream_context);
 #else
 	ccv_nnc_stream_cpu_t* stream_cpu = (ccv_nnc_stream_cpu_t*)stream_context;
 	if (!stream_cpu)
+	{
 		stream_cpu = &ccv_nnc_per_thread_stream_cpu;
+		ccv_nnc_stream_workspace_per_thread(&stream_cpu->workspace);
+	}
+	return &stream_cpu->workspace;
+#endif
+}
+
+void* ccv_nnc_stream_context_get_workspace(ccv_nnc_stream_context_t* const stream_context, const size_t workspace_size, const int mem)
+{
+#ifdef HAVE_CUDA
+	return ccv_nnc_stream_compat_get_workspace(stream_context, workspace_size, mem);
+#else
 	assert(mem == CCV_TENSOR_CPU_MEMORY);
-	if (stream_cpu->workspace_size >= workspace_size)
-		return stream_cpu->workspace;
-	stream_cpu->workspace_size = workspace_size;
-	if (stream_cpu->workspace)
-		ccfree(stream_cpu->workspace);
-	stream_cpu->workspace = 0;
-	ccmemalign(&stream_cpu->workspace, 16, workspace_size);
-	return stream_cpu->workspace;
+	return ccv_nnc_stream_workspace_get(_ccv_nnc_stream_context_cpu_workspace(stream_context), workspace_size);
 #endif
 }
 
 void ccv_nnc_stream_context_drain(ccv_nnc_stream_context_t* const stream_context)
 {
+	// Cannot free the workspace while the worker pool may still use it.
+	if (ccv_nnc_stream_context_is_cpu_async(stream_context))
+		_ccv_nnc_stream_cpu_wait((ccv_nnc_stream_cpu_t*)stream_context);
 #ifdef HAVE_CUDA
 	ccv_nnc_stream_compat_drain(stream_context);
 #else
-	ccv_nnc_stream_cpu_t* stream_cpu = (ccv_nnc_stream_cpu_t*)stream_context;
-	if (!stream_cpu)
-		stream_cpu = &ccv_nnc_per_thread_stream_cpu;
-	if (stream_cpu->workspace)
-	{
-		ccfree(stream_cpu->workspace);
-		stream_cpu->workspace = 0;
-		stream_cpu->workspace_size = 0;
-	}
+	ccv_nnc_stream_workspace_trim(_ccv_nnc_stream_context_cpu_workspace(stream_context), 0);
+#endif
+}
+
+void ccv_nnc_stream_context_trim(ccv_nnc_stream_context_t* const stream_context, const size_t max_workspace_size)
+{
+	if (ccv_nnc_stream_context_is_cpu_async(stream_context))
+		_ccv_nnc_stream_cpu_wait((ccv_nnc_stream_cpu_t*)stream_context);
+#ifdef HAVE_CUDA
+	ccv_nnc_stream_compat_trim(stream_context, max_workspace_size);
+#else
+	ccv_nnc_stream_workspace_trim(_ccv_nnc_stream_context_cpu_workspace(stream_context), max_workspace_size);
 #endif
 }
 
-void ccv_nnc_stream_context_wait(const ccv_nnc_stream_context_t* const stream_context)
+ccv_nnc_stream_context_workspace_stat_t ccv_nnc_stream_context_workspace_stat(const ccv_nnc_stream_context_t* const stream_context)
+{
+	const ccv_nnc_stream_workspace_t* const workspace = _ccv_nnc_stream_context_cpu_workspace(stream_context);
+	const ccv_nnc_stream_context_workspace_stat_t stat = {
+		.size = workspace->size,
+		.high_water_mark = workspace->high_water_mark,
+		.request_count = workspace->request_count,
+		.alloc_count = workspace->alloc_count,
+	};
+	return stat;
+}
+
+static size_t ccv_nnc_workspace_limit = CCV_NNC_DEFAULT_WORKSPACE_LIMIT;
+
+void ccv_nnc_set_workspace_limit(const size_t workspace_limit)
+{
+	ccv_nnc_workspace_limit = workspace_limit;
+}
+
+size_t ccv_nnc_stream_workspace_limit(void)
+{
+	return ccv_nnc_workspace_limit;
+}
+
+void ccv_nnc_stream_cpu_wait(ccv_nnc_stream_context_t* const stream_context)
+{
+	if (ccv_nnc_stream_context_is_cpu_async(stream_context))
+		_ccv_nnc_stream_cpu_wait((ccv_nnc_stream_cpu_t*)stream_context);
+}
+
+int ccv_nnc_stream_context_wait(const ccv_nnc_stream_context_t* const stream_context)
 {
 	if (!stream_context)
-		return;
+		return CCV_NNC_EXEC_SUCCESS;
 	ccv_nnc_stream_scheduler_t* const scheduler = stream_context->scheduler;
 	if (scheduler) // First wait the scheduler to finish.
 	{
@@ -83,28 +606,45 @@ void ccv_nnc_stream_context_wait(const ccv_nnc_stream_context_t* const stream_co
 			pthread_cond_wait(&scheduler->notify, &scheduler->mutex);
 		pthread_mutex_unlock(&scheduler->mutex);
 	}
+	int status = CCV_NNC_EXEC_SUCCESS;
+	if (CCV_STREAM_GET_CONTEXT(stream_context->type) == CCV_STREAM_CONTEXT_CPU)
+	{
+		ccv_nnc_stream_cpu_t* const stream_cpu = (ccv_nnc_stream_cpu_t*)stream_context;
+		_ccv_nnc_stream_cpu_wait(stream_cpu);
+		// Report the failure once, the commands submitted after this start over.
+		pthread_mutex_lock(&stream_cpu->mutex);
+		status = stream_cpu->status;
+		stream_cpu->status = CCV_NNC_EXEC_SUCCESS;
+		pthread_mutex_unlock(&stream_cpu->mutex);
+	}
 #ifdef HAVE_CUDA
 	if (CCV_STREAM_GET_CONTEXT(stream_context->type) == CCV_STREAM_CONTEXT_GPU)
 		ccv_nnc_synchronize_stream_context(stream_context);
 #endif
+	return status;
 }
 
 void ccv_nnc_stream_context_free(ccv_nnc_stream_context_t* const stream_context)
 {
+	if (CCV_STREAM_GET_CONTEXT(stream_context->type) == CCV_STREAM_CONTEXT_CPU)
+	{
+		ccv_nnc_stream_cpu_t* const stream_cpu = (ccv_nnc_stream_cpu_t*)stream_context;
+		_ccv_nnc_stream_cpu_wait(stream_cpu);
+		if (stream_cpu->workspace.ptr)
+			ccfree(stream_cpu->workspace.ptr);
+		pthread_mutex_destroy(&stream_cpu->mutex);
+		pthread_cond_destroy(&stream_cpu->notify);
+	}
 #ifdef HAVE_CUDA
 	if (CCV_STREAM_GET_CONTEXT(stream_context->type) == CCV_STREAM_CONTEXT_GPU)
 		ccv_nnc_deinit_stream_context(stream_context);
-#else
-	ccv_nnc_stream_cpu_t* stream_cpu = (ccv_nnc_stream_cpu_t*)stream_context;
-	if (stream_cpu->workspace)
-		ccfree(stream_cpu->workspace);
 #endif
 	ccfree(stream_context);
 }
 
 ccv_nnc_stream_signal_t* ccv_nnc_stream_signal_new(const int type)
 {
-	ccv_nnc_stream_signal_t* const signal = (ccv_nnc_stream_signal_t*)ccmalloc(sizeof(ccv_nnc_stream_signal_t));
+	ccv_nnc_stream_signal_t* const signal = (ccv_nnc_stream_signal_t*)cccalloc(1, sizeof(ccv_nnc_stream_signal_t));
 	signal->type = type;
 #ifdef HAVE_CUDA
 	if (CCV_STREAM_GET_CONTEXT(type) == CCV_STREAM_CONTEXT_GPU)
@@ -115,6 +655,18 @@ ccv_nnc_stream_signal_t* ccv_nnc_stream_signal_new(const int type)
 
 void ccv_nnc_stream_context_emit_signal(const ccv_nnc_stream_context_t* const stream, const ccv_nnc_stream_signal_t* const signal)
 {
+	if (ccv_nnc_stream_context_is_cpu_async(stream) && CCV_STREAM_GET_CONTEXT(signal->type) == CCV_STREAM_CONTEXT_CPU)
+	{
+		ccv_nnc_stream_cpu_job_t* const job = (ccv_nnc_stream_cpu_job_t*)ccmalloc(sizeof(ccv_nnc_stream_cpu_job_t));
+		job->type = CCV_NNC_STREAM_CPU_JOB_EMIT;
+		job->signal.signal = (ccv_nnc_stream_signal_t*)signal;
+		// The signal is a counter, the emitted count is taken at submission time, and the fire count is
+		// updated once the job is reached on the stream.
+		job->signal.count = __sync_add_and_fetch(&((ccv_nnc_stream_signal_t*)signal)->emit_count, 1);
+		_ccv_nnc_stream_cpu_submit((ccv_nnc_stream_cpu_t*)stream, job);
+	} else if (_ccv_nnc_stream_context_is_cpu_current(stream) && CCV_STREAM_GET_CONTEXT(signal->type) == CCV_STREAM_CONTEXT_CPU)
+		// Emitted from a job on this stream, everything before it on the stream is done, fire it now.
+		_ccv_nnc_stream_cpu_fire_signal((ccv_nnc_stream_signal_t*)signal, __sync_add_and_fetch(&((ccv_nnc_stream_signal_t*)signal)->emit_count, 1));
 #ifdef HAVE_CUDA
 	if (CCV_STREAM_GET_CONTEXT(signal->type) == CCV_STREAM_CONTEXT_GPU)
 		ccv_nnc_stream_compat_emit_signal(stream, signal);
@@ -123,6 +675,23 @@ void ccv_nnc_stream_context_emit_signal(const ccv_nnc_stream_context_t* const st
 
 void ccv_nnc_stream_context_wait_signal(const ccv_nnc_stream_context_t* const stream, const ccv_nnc_stream_signal_t* const signal)
 {
+	if (ccv_nnc_stream_context_is_cpu_async(stream) && CCV_STREAM_GET_CONTEXT(signal->type) == CCV_STREAM_CONTEXT_CPU)
+	{
+		const uint64_t count = signal->emit_count;
+		// Nothing emitted yet, nothing to wait.
+		if (!count)
+			return;
+		ccv_nnc_stream_cpu_job_t* const job = (ccv_nnc_stream_cpu_job_t*)ccmalloc(sizeof(ccv_nnc_stream_cpu_job_t));
+		job->type = CCV_NNC_STREAM_CPU_JOB_WAIT;
+		job->signal.signal = (ccv_nnc_stream_signal_t*)signal;
+		job->signal.count = count;
+		_ccv_nnc_stream_cpu_submit((ccv_nnc_stream_cpu_t*)stream, job);
+	} else if (_ccv_nnc_stream_context_is_cpu_current(stream) && CCV_STREAM_GET_CONTEXT(signal->type) == CCV_STREAM_CONTEXT_CPU) {
+		// Waited from a job on this stream, the rest of the job has to wait, thus, wait inline.
+		const uint64_t count = signal->emit_count;
+		if (count)
+			_ccv_nnc_stream_cpu_wait_signal_inline((ccv_nnc_stream_signal_t*)signal, count);
+	}
 #ifdef HAVE_CUDA
 	if (CCV_STREAM_GET_CONTEXT(signal->type) == CCV_STREAM_CONTEXT_GPU)
 		ccv_nnc_stream_compat_wait_signal(stream, signal);
@@ -135,6 +704,8 @@ void ccv_nnc_stream_signal_free(ccv_nnc_stream_signal_t* const signal)
 	if (CCV_STREAM_GET_CONTEXT(signal->type) == CCV_STREAM_CONTEXT_GPU)
 		ccv_nnc_deinit_stream_signal(signal);
 #endif
+	if (signal->waiters)
+		ccv_array_free(signal->waiters);
 	ccfree(signal);
 }
 
@@ -347,10 +918,43 @@ void ccv_nnc_stream_task_resume(ccv_nnc_stream_task_t* const task)
 		_ccv_nnc_stream_task_done(task);
 }
 
+static void _ccv_nnc_stream_cpu_task_resume(void* const userdata)
+{
+	ccv_nnc_stream_task_t* const task = (ccv_nnc_stream_task_t*)userdata;
+	ccv_nnc_stream_scheduler_t* const scheduler = task->super;
+	pthread_mutex_lock(&scheduler->mutex);
+	ccv_nnc_stream_scheduler_add_task(scheduler, task);
+	--scheduler->stream_wait_task_count;
+	pthread_cond_signal(&scheduler->wait);
+	pthread_mutex_unlock(&scheduler->mutex);
+}
+
+static void _ccv_nnc_stream_cpu_task_synchronize(ccv_nnc_stream_task_t* const self, ccv_nnc_stream_cpu_t* const stream_cpu)
+{
+	pthread_mutex_lock(&stream_cpu->mutex);
+	const int scheduled = stream_cpu->scheduled;
+	pthread_mutex_unlock(&stream_cpu->mutex);
+	// If the stream is completed, no need to wait.
+	if (!scheduled)
+		return;
+	ccv_nnc_stream_scheduler_t* const scheduler = self->super;
+	pthread_mutex_lock(&scheduler->mutex);
+	++scheduler->stream_wait_task_count;
+	ccv_nnc_stream_cpu_job_t* const job = (ccv_nnc_stream_cpu_job_t*)ccmalloc(sizeof(ccv_nnc_stream_cpu_job_t));
+	job->type = CCV_NNC_STREAM_CPU_JOB_CALLBACK;
+	job->callback.func = _ccv_nnc_stream_cpu_task_resume;
+	job->callback.userdata = self;
+	_ccv_nnc_stream_cpu_submit(stream_cpu, job);
+	pthread_mutex_unlock(&scheduler->mutex);
+	swapcontext(&scheduler->callee, &scheduler->caller);
+}
+
 void ccv_nnc_stream_task_synchronize(ccv_nnc_stream_task_t* const self, ccv_nnc_stream_context_t* const stream)
 {
 	if (!stream)
 		return;
+	if (ccv_nnc_stream_context_is_cpu_async(stream))
+		_ccv_nnc_stream_cpu_task_synchronize(self, (ccv_nnc_stream_cpu_t*)stream);
 #ifdef HAVE_CUDA
 	if (CCV_STREAM_GET_CONTEXT(stream->type) == CCV_STREAM_CONTEXT_GPU)
 		ccv_nnc_stream_compat_task_synchronize(self, stream);
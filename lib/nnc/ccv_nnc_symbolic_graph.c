@@ -49,6 +49,15 @@ ccv_nnc_symbolic_graph_t* ccv_nnc_symbolic_graph_dup(const ccv_nnc_symbolic_grap
 			symbol_info->s_ref->rnum = s_ref->rnum;
 			memcpy(ccv_array_get(symbol_info->s_ref, 0), ccv_array_get(s_ref, 0), sizeof(int) * s_ref->rnum);
 		}
+		if (symbol_info->constant)
+		{
+			ccv_nnc_tensor_t* const constant = symbol_info->constant;
+			ccv_nnc_tensor_param_t cpu_info = symbol_info->info;
+			cpu_info.type = CCV_TENSOR_CPU_MEMORY;
+			symbol_info->constant = ccv_nnc_tensor_new(0, cpu_info, 0);
+			memcpy(symbol_info->constant->data.u8, constant->data.u8, ccv_nnc_tensor_data_size(cpu_info));
+			symbol_info->constant->sig = constant->sig;
+		}
 	}
 	new_graph->exec_symbol_info = ccv_array_new(sizeof(ccv_nnc_graph_exec_symbol_info_t), graph->exec_symbol_info->rnum, 0);
 	new_graph->exec_symbol_info->rnum = graph->exec_symbol_info->rnum;
@@ -186,6 +195,36 @@ ccv_nnc_tensor_symbol_t ccv_nnc_tensor_symbol_new(ccv_nnc_symbolic_graph_t* cons
 	return symbol;
 }
 
+void ccv_nnc_tensor_constant_sign(ccv_nnc_tensor_t* const constant)
+{
+	// Sign the constant with its content, thus, any transformation derived from it can be cached.
+	constant->sig = ccv_cache_generate_signature((const char*)constant->data.u8, ccv_nnc_tensor_data_size(constant->info), (uint64_t)constant->info.datatype, CCV_EOF_SIGN);
+}
+
+ccv_nnc_tensor_symbol_t ccv_nnc_tensor_symbol_constant_new(ccv_nnc_symbolic_graph_t* const graph, const ccv_nnc_tensor_param_t info, const void* const data, const char* const name)
+{
+	assert(!ccv_nnc_is_tensor_auto(info));
+	assert(data);
+	ccv_nnc_tensor_param_t cpu_info = info;
+	cpu_info.type = CCV_TENSOR_CPU_MEMORY;
+	ccv_nnc_tensor_t* const constant = ccv_nnc_tensor_new(0, cpu_info, 0);
+	const size_t data_size = ccv_nnc_tensor_data_size(cpu_info);
+	memcpy(constant->data.u8, data, data_size);
+	ccv_nnc_tensor_constant_sign(constant);
+	const ccv_nnc_tensor_symbol_t symbol = ccv_nnc_tensor_symbol_new(graph, info, name);
+	ccv_nnc_tensor_symbol_info_t* const symbol_info = (ccv_nnc_tensor_symbol_info_t*)ccv_array_get(graph->tensor_symbol_info, symbol.d);
+	symbol_info->constant = constant;
+	return symbol;
+}
+
+const ccv_nnc_tensor_t* ccv_nnc_tensor_symbol_constant(const ccv_nnc_symbolic_graph_t* const graph, const ccv_nnc_tensor_symbol_t tensor)
+{
+	assert(graph == tensor.graph);
+	assert(tensor.d >= 0 && tensor.d < graph->tensor_symbol_info->rnum);
+	const ccv_nnc_tensor_symbol_info_t* const symbol_info = (ccv_nnc_tensor_symbol_info_t*)ccv_array_get(graph->tensor_symbol_info, tensor.d);
+	return symbol_info->constant;
+}
+
 void* ccv_nnc_tensor_symbol_new_hook(ccv_nnc_symbolic_graph_t* const graph, ccv_nnc_tensor_symbol_new_hook_f hook, void* context)
 {
 	void* const prev = graph->hooks.tensor_symbol_new.context;
@@ -760,6 +799,11 @@ void ccv_nnc_tensor_symbol_free(ccv_nnc_symbolic_graph_t* const graph, ccv_nnc_t
 		ccfree(symbol_info->name);
 		symbol_info->name = 0;
 	}
+	if (symbol_info->constant)
+	{
+		ccv_nnc_tensor_free(symbol_info->constant);
+		symbol_info->constant = 0;
+	}
 	symbol_info->flags |= CCV_NNC_TENSOR_SYMBOL_DEAD;
 	int i;
 	for (i = graph->tensor_symbol_info->rnum - 1; i >= 0; i--)
@@ -1727,6 +1771,8 @@ void ccv_nnc_symbolic_graph_free(ccv_nnc_symbolic_graph_t* const graph)
 			ccfree(symbol_info->name);
 		if (symbol_info->s_ref)
 			ccv_array_free(symbol_info->s_ref);
+		if (symbol_info->constant)
+			ccv_nnc_tensor_free(symbol_info->constant);
 	}
 	if (graph->sub_graphs)
 	{
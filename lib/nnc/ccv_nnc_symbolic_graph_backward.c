@@ -1089,6 +1089,7 @@ static void _ccv_nnc_symbolic_graph_backward_prep_gen(ccv_nnc_symbolic_graph_bac
 		{
 			const ccv_nnc_graph_exec_symbol_info_t* forw_exec = exec_symbol_info + idx;
 			ccv_nnc_autograd_graph_exec_symbol_t* back_exec = autograd_execs + idx;
+			assert(!forw_exec->cmd.info.epilogue.size); /* Commands with fused element-wise ops don't have backward. */
 			back_exec->cmd = forw_exec->cmd;
 			if (back_exec->cmd.cmd != CCV_NNC_NOOP)
 				back_exec->cmd.cmd += 1; /* Backward command is the one after forward command. */
@@ -7,6 +7,8 @@
 #endif
 #include "_ccv_nnc_graph.h"
 #include "_ccv_nnc_symbolic_graph.h"
+#include "3rdparty/khash/khash.h"
+#include <pthread.h>
 
 #pragma mark - Level-3 API
 
@@ -1084,6 +1086,8 @@ static ccv_nnc_tensor_arena_t* _ccv_nnc_tensor_arena_new(ccv_nnc_symbolic_graph_
 	tensor_arena->sub_arena_size = graph_prep->sub_prep_size;
 	tensor_arena->tensor_metadata = ccv_array_new(16 /* align to 16 bytes */, 0, 0);
 	tensor_arena->m_tensor_idx = ccv_array_new(sizeof(int), 0, 0);
+	tensor_arena->constants = 0;
+	tensor_arena->derived = 0;
 	for (i = 0; i < alloc_prep->buffer_size; i++)
 		tensor_arena->buffers[i].type = alloc_prep->buffers[i].type,
 			tensor_arena->buffers[i].pin_mem = alloc_prep->buffers[i].pin_mem,
@@ -1271,6 +1275,9 @@ static ccv_nnc_tensor_arena_t* _ccv_nnc_tensor_arena_new(ccv_nnc_symbolic_graph_
 				int pos = _ccv_nnc_tensor_metadata_pos_new(tensor_arena->tensor_metadata, sizeof(ccv_nnc_tensor_t));
 				ccv_nnc_tensor_t* const tv = _ccv_nnc_tensor_metadata_get(tensor_arena->tensor_metadata, pos);
 				*tv = ccv_nnc_tensor(tensor_binds[i].tensor->data.ptr, tensor_binds[i].tensor->info, 0);
+				// Keep the signature, thus, transformations of it can be cached. It is cleared once the tensor is handed out
+				// by ccv_nnc_tensor_from_symbol, because it can be changed then.
+				tv->sig = tensor_binds[i].tensor->sig;
 				tensor_arena->vt_tensors[d] = (ccv_nnc_tensor_t*)(intptr_t)pos;
 			}
 		}
@@ -1716,8 +1723,11 @@ ccv_nnc_tensor_t* ccv_nnc_tensor_from_symbol(const ccv_nnc_tensor_arena_t* const
 			ccv_nnc_tensor_multiview_t* mv = (ccv_nnc_tensor_multiview_t*)tensor;
 			while (CCV_IS_TENSOR_MULTIVIEW(mv))
 				mv = (ccv_nnc_tensor_multiview_t*)(mv->it ? mv->it : CCV_NNC_MULTIVIEW_DATA(mv)[0]);
-			return (ccv_nnc_tensor_t*)mv;
+			tensor = (ccv_nnc_tensor_t*)mv;
 		}
+		// The caller can write to the tensor, thus, if it is a constant, the transformations derived from it are stale.
+		if (tensor)
+			tensor->sig = 0;
 		return tensor;
 	}
 	int i;
@@ -3797,6 +3807,199 @@ static void _ccv_nnc_symbolic_graph_prep_dup_breakpoints_free(ccv_nnc_symbolic_g
 	} ccv_nnc_graph_visit_endfor
 }
 
+typedef struct {
+	uint64_t sig;
+	size_t size;
+	void* data;
+} ccv_nnc_constant_derived_t;
+
+typedef struct {
+	uint64_t sig; // The signature of the constant.
+	int idx; // The index of the constant in its tensor arena.
+	ccv_nnc_tensor_arena_t* tensor_arena;
+} ccv_nnc_constant_owner_t;
+
+KHASH_MAP_INIT_INT64(constant_owner, ccv_nnc_constant_owner_t)
+
+// The tensor arenas that own constants, keyed by the data pointer of the constant, thus, kernels can find the data
+// derived from a constant. It only changes when a tensor arena is created or freed.
+static pthread_rwlock_t constant_owner_rwlock = PTHREAD_RWLOCK_INITIALIZER;
+static khash_t(constant_owner)* constant_owners = 0;
+
+static void _ccv_nnc_constant_arena_add(ccv_nnc_tensor_arena_t* const tensor_arena)
+{
+	int i, ret;
+	tensor_arena->derived = (ccv_array_t**)cccalloc(tensor_arena->constants->rnum, sizeof(ccv_array_t*));
+	pthread_mutex_init(&tensor_arena->derived_mutex, 0);
+	pthread_rwlock_wrlock(&constant_owner_rwlock);
+	if (!constant_owners)
+		constant_owners = kh_init(constant_owner);
+	for (i = 0; i < tensor_arena->constants->rnum; i++)
+	{
+		const ccv_nnc_tensor_t* const constant = *(ccv_nnc_tensor_t**)ccv_array_get(tensor_arena->constants, i);
+		khiter_t k = kh_put(constant_owner, constant_owners, (uint64_t)(uintptr_t)constant->data.ptr, &ret);
+		assert(ret != 0);
+		const ccv_nnc_constant_owner_t owner = {
+			.sig = constant->sig,
+			.idx = i,
+			.tensor_arena = tensor_arena,
+		};
+		kh_val(constant_owners, k) = owner;
+	}
+	pthread_rwlock_unlock(&constant_owner_rwlock);
+}
+
+static void _ccv_nnc_constant_arena_remove(ccv_nnc_tensor_arena_t* const tensor_arena)
+{
+	int i, j;
+	pthread_rwlock_wrlock(&constant_owner_rwlock);
+	for (i = 0; i < tensor_arena->constants->rnum; i++)
+	{
+		const ccv_nnc_tensor_t* const constant = *(ccv_nnc_tensor_t**)ccv_array_get(tensor_arena->constants, i);
+		khiter_t k = kh_get(constant_owner, constant_owners, (uint64_t)(uintptr_t)constant->data.ptr);
+		assert(k != kh_end(constant_owners));
+		kh_del(constant_owner, constant_owners, k);
+	}
+	if (kh_size(constant_owners) == 0)
+	{
+		kh_destroy(constant_owner, constant_owners);
+		constant_owners = 0;
+	}
+	pthread_rwlock_unlock(&constant_owner_rwlock);
+	for (i = 0; i < tensor_arena->constants->rnum; i++)
+		if (tensor_arena->derived[i])
+		{
+			for (j = 0; j < tensor_arena->derived[i]->rnum; j++)
+				ccfree(((ccv_nnc_constant_derived_t*)ccv_array_get(tensor_arena->derived[i], j))->data);
+			ccv_array_free(tensor_arena->derived[i]);
+		}
+	ccfree(tensor_arena->derived);
+	pthread_mutex_destroy(&tensor_arena->derived_mutex);
+}
+
+static void* _ccv_nnc_constant_derived_get(const ccv_array_t* const derived, const uint64_t sig, const size_t size)
+{
+	int i;
+	for (i = 0; derived && i < derived->rnum; i++)
+	{
+		const ccv_nnc_constant_derived_t* const entry = (ccv_nnc_constant_derived_t*)ccv_array_get(derived, i);
+		if (entry->sig == sig)
+		{
+			assert(entry->size == size);
+			return entry->data;
+		}
+	}
+	return 0;
+}
+
+void* ccv_nnc_constant_derived(const uint64_t constant_sig, const void* const constant_data, const uint64_t sig, const size_t size, ccv_nnc_constant_derive_f derive, const void* const context)
+{
+	if (!constant_sig)
+		return 0;
+	ccv_nnc_constant_owner_t owner = {
+		.tensor_arena = 0,
+	};
+	pthread_rwlock_rdlock(&constant_owner_rwlock);
+	if (constant_owners)
+	{
+		khiter_t k = kh_get(constant_owner, constant_owners, (uint64_t)(uintptr_t)constant_data);
+		if (k != kh_end(constant_owners) && kh_val(constant_owners, k).sig == constant_sig)
+			owner = kh_val(constant_owners, k);
+	}
+	pthread_rwlock_unlock(&constant_owner_rwlock);
+	ccv_nnc_tensor_arena_t* const tensor_arena = owner.tensor_arena;
+	if (!tensor_arena)
+		return 0;
+	pthread_mutex_lock(&tensor_arena->derived_mutex);
+	void* data = _ccv_nnc_constant_derived_get(tensor_arena->derived[owner.idx], sig, size);
+	pthread_mutex_unlock(&tensor_arena->derived_mutex);
+	if (data)
+		return data;
+	// Derive it without holding any lock. If another thread derived the same data meanwhile, use that one instead.
+	ccmemalign(&data, 16, size);
+	if (!data)
+		return 0;
+	derive(data, context);
+	pthread_mutex_lock(&tensor_arena->derived_mutex);
+	void* const published = _ccv_nnc_constant_derived_get(tensor_arena->derived[owner.idx], sig, size);
+	if (!published)
+	{
+		if (!tensor_arena->derived[owner.idx])
+			tensor_arena->derived[owner.idx] = ccv_array_new(sizeof(ccv_nnc_constant_derived_t), 1, 0);
+		const ccv_nnc_constant_derived_t derived = {
+			.sig = sig,
+			.size = size,
+			.data = data,
+		};
+		ccv_array_push(tensor_arena->derived[owner.idx], &derived);
+	}
+	pthread_mutex_unlock(&tensor_arena->derived_mutex);
+	if (published)
+	{
+		ccfree(data);
+		return published;
+	}
+	return data;
+}
+
+static void _ccv_nnc_tensor_constant_binds_new(const ccv_nnc_symbolic_graph_t* const symbolic_graph, const ccv_nnc_tensor_bind_t* const tensor_binds, const int tensor_bind_size, ccv_array_t* const constant_binds)
+{
+	int i, j;
+	for (i = 0; i < symbolic_graph->tensor_symbol_info->rnum; i++)
+	{
+		const ccv_nnc_tensor_symbol_info_t* const symbol_info = (ccv_nnc_tensor_symbol_info_t*)ccv_array_get(symbolic_graph->tensor_symbol_info, i);
+		if (!symbol_info->constant || CCV_NNC_TENSOR_SYMBOL_IS_DEAD(symbol_info->flags))
+			continue;
+		const ccv_nnc_tensor_symbol_t symbol = {
+			.d = i,
+			.graph = symbolic_graph,
+		};
+		// If it is binded explicitly, respect that.
+		int binded = 0;
+		for (j = 0; !binded && j < tensor_bind_size; j++)
+			binded = (tensor_binds[j].symbol.d == i && tensor_binds[j].symbol.graph == symbolic_graph);
+		if (binded)
+			continue;
+		ccv_nnc_tensor_t* const tensor = ccv_nnc_tensor_new(0, symbol_info->info, 0);
+		if (CCV_TENSOR_GET_MEMORY(symbol_info->info.type) == CCV_TENSOR_CPU_MEMORY)
+			memcpy(tensor->data.u8, symbol_info->constant->data.u8, ccv_nnc_tensor_data_size(symbol_info->info));
+		else
+			ccv_nnc_cmd_exec(CMD_DATA_TRANSFER_FORWARD(), ccv_nnc_no_hint, 0, &symbol_info->constant, 1, &tensor, 1, 0);
+		tensor->sig = symbol_info->constant->sig;
+		const ccv_nnc_tensor_bind_t constant_bind = {
+			.symbol = symbol,
+			.tensor = tensor,
+		};
+		ccv_array_push(constant_binds, &constant_bind);
+	}
+	if (symbolic_graph->sub_graphs)
+		for (i = 0; i < symbolic_graph->sub_graphs->rnum; i++)
+			_ccv_nnc_tensor_constant_binds_new(*(ccv_nnc_symbolic_graph_t**)ccv_array_get(symbolic_graph->sub_graphs, i), tensor_binds, tensor_bind_size, constant_binds);
+}
+
+// The data derived from a constant is kept by its signature, thus, no command can write to a constant (or its alias).
+static void _ccv_nnc_symbolic_graph_assert_constants_read_only(const ccv_nnc_symbolic_graph_t* const symbolic_graph)
+{
+	int i, j;
+	for (i = 0; i < symbolic_graph->exec_symbol_info->rnum; i++)
+	{
+		const ccv_nnc_graph_exec_symbol_info_t* const symbol_info = (ccv_nnc_graph_exec_symbol_info_t*)ccv_array_get(symbolic_graph->exec_symbol_info, i);
+		if (CCV_NNC_GRAPH_EXEC_IS_DEAD(symbol_info->flags))
+			continue;
+		for (j = 0; j < symbol_info->output_size; j++)
+			if (symbol_info->outputs[j] >= 0)
+			{
+				const ccv_nnc_tensor_symbol_info_t* tensor_symbol_info = (ccv_nnc_tensor_symbol_info_t*)ccv_array_get(symbolic_graph->tensor_symbol_info, symbol_info->outputs[j]);
+				if (tensor_symbol_info->alias_ref)
+					tensor_symbol_info = (ccv_nnc_tensor_symbol_info_t*)ccv_array_get(symbolic_graph->tensor_symbol_info, tensor_symbol_info->alias_ref - 1);
+				assert(!tensor_symbol_info->constant);
+			}
+	}
+	if (symbolic_graph->sub_graphs)
+		for (i = 0; i < symbolic_graph->sub_graphs->rnum; i++)
+			_ccv_nnc_symbolic_graph_assert_constants_read_only(*(ccv_nnc_symbolic_graph_t**)ccv_array_get(symbolic_graph->sub_graphs, i));
+}
+
 void ccv_nnc_symbolic_graph_compile(const ccv_nnc_symbolic_graph_t* const symbolic_graph, const ccv_nnc_tensor_bind_t* const tensor_binds, const int tensor_bind_size, const ccv_nnc_tensor_symbol_t* const outputs, const int output_size, const ccv_nnc_graph_exec_symbol_t* const sources, const int source_size, const ccv_nnc_graph_exec_symbol_t* const destinations, const int destination_size, ccv_nnc_graph_t** const graph_ref, ccv_nnc_tensor_arena_t** const tensor_arena_ref, ccv_nnc_graph_exec_arena_t** const graph_exec_arena_ref)
 {
 	assert(graph_ref);
@@ -3809,9 +4012,35 @@ void ccv_nnc_symbolic_graph_compile(const ccv_nnc_symbolic_graph_t* const symbol
 		assert(tensor_binds[i].tensor);
 		assert(!CCV_IS_TENSOR_MULTIVIEW(tensor_binds[i].tensor));
 	}
-	ccv_nnc_symbolic_graph_prep_t* graph_prep = _ccv_nnc_symbolic_graph_prep_new(symbolic_graph, tensor_binds, tensor_bind_size, outputs, output_size, sources, source_size, destinations, destination_size, 0, 0, 0, 0);
+	_ccv_nnc_symbolic_graph_assert_constants_read_only(symbolic_graph);
+	// Constants not binded explicitly are binded to copies owned by the tensor arena.
+	ccv_array_t* const constant_binds = ccv_array_new(sizeof(ccv_nnc_tensor_bind_t), 0, 0);
+	_ccv_nnc_tensor_constant_binds_new(symbolic_graph, tensor_binds, tensor_bind_size, constant_binds);
+	const ccv_nnc_tensor_bind_t* all_binds = tensor_binds;
+	int all_bind_size = tensor_bind_size;
+	ccv_nnc_tensor_bind_t* merged_binds = 0;
+	if (constant_binds->rnum > 0)
+	{
+		all_bind_size = tensor_bind_size + constant_binds->rnum;
+		merged_binds = (ccv_nnc_tensor_bind_t*)ccmalloc(sizeof(ccv_nnc_tensor_bind_t) * all_bind_size);
+		if (tensor_bind_size > 0)
+			memcpy(merged_binds, tensor_binds, sizeof(ccv_nnc_tensor_bind_t) * tensor_bind_size);
+		memcpy(merged_binds + tensor_bind_size, ccv_array_get(constant_binds, 0), sizeof(ccv_nnc_tensor_bind_t) * constant_binds->rnum);
+		all_binds = merged_binds;
+	}
+	ccv_nnc_symbolic_graph_prep_t* graph_prep = _ccv_nnc_symbolic_graph_prep_new(symbolic_graph, all_binds, all_bind_size, outputs, output_size, sources, source_size, destinations, destination_size, 0, 0, 0, 0);
 	_ccv_nnc_symbolic_graph_prep_while_count_tensor(graph_prep);
-	ccv_nnc_tensor_arena_t* tensor_arena = _ccv_nnc_tensor_arena_new(graph_prep, 0, tensor_binds, tensor_bind_size);
+	ccv_nnc_tensor_arena_t* tensor_arena = _ccv_nnc_tensor_arena_new(graph_prep, 0, all_binds, all_bind_size);
+	if (merged_binds)
+		ccfree(merged_binds);
+	if (constant_binds->rnum > 0)
+	{
+		tensor_arena->constants = ccv_array_new(sizeof(ccv_nnc_tensor_t*), constant_binds->rnum, 0);
+		for (i = 0; i < constant_binds->rnum; i++)
+			ccv_array_push(tensor_arena->constants, &((ccv_nnc_tensor_bind_t*)ccv_array_get(constant_binds, i))->tensor);
+		_ccv_nnc_constant_arena_add(tensor_arena);
+	}
+	ccv_array_free(constant_binds);
 	_ccv_nnc_tensor_arena_fixup_peer_ref_and_tape_var(tensor_arena, graph_prep, tensor_arena);
 	*tensor_arena_ref = tensor_arena;
 	// The above handled tensor allocation, now we need to materialize the graph from symbolic to real.
@@ -3860,6 +4089,21 @@ uint64_t ccv_nnc_tensor_arena_size(const ccv_nnc_tensor_arena_t* const tensor_ar
 	return total_size;
 }
 
+uint64_t ccv_nnc_tensor_arena_derived_size(const ccv_nnc_tensor_arena_t* const tensor_arena)
+{
+	uint64_t total_size = 0;
+	int i, j;
+	if (!tensor_arena->constants)
+		return 0;
+	pthread_mutex_lock((pthread_mutex_t*)&tensor_arena->derived_mutex);
+	for (i = 0; i < tensor_arena->constants->rnum; i++)
+		if (tensor_arena->derived[i])
+			for (j = 0; j < tensor_arena->derived[i]->rnum; j++)
+				total_size += ((ccv_nnc_constant_derived_t*)ccv_array_get(tensor_arena->derived[i], j))->size;
+	pthread_mutex_unlock((pthread_mutex_t*)&tensor_arena->derived_mutex);
+	return total_size;
+}
+
 void ccv_nnc_tensor_arena_free(ccv_nnc_tensor_arena_t* const tensor_arena)
 {
 	int i;
@@ -3883,6 +4127,13 @@ void ccv_nnc_tensor_arena_free(ccv_nnc_tensor_arena_t* const tensor_arena)
 		ccfree(tensor_arena->buffers[i].ptr);
 #endif
 	}
+	if (tensor_arena->constants)
+	{
+		_ccv_nnc_constant_arena_remove(tensor_arena);
+		for (i = 0; i < tensor_arena->constants->rnum; i++)
+			ccv_nnc_tensor_free(*(ccv_nnc_tensor_t**)ccv_array_get(tensor_arena->constants, i));
+		ccv_array_free(tensor_arena->constants);
+	}
 	_ccv_nnc_tensor_arena_free(tensor_arena);
 }
 
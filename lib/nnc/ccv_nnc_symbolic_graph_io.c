@@ -57,6 +57,10 @@ static void _ccv_nnc_symbolic_graph_write(const ccv_nnc_symbolic_graph_t* const
 		sqlite3_bind_int(tensor_symbol_insert_stmt, 16, symbol_info->info.format);
 		sqlite3_bind_int(tensor_symbol_insert_stmt, 17, symbol_info->info.datatype);
 		sqlite3_bind_blob(tensor_symbol_insert_stmt, 18, symbol_info->info.dim, sizeof(symbol_info->info.dim), 0);
+		if (symbol_info->constant)
+			sqlite3_bind_blob(tensor_symbol_insert_stmt, 19, symbol_info->constant->data.u8, ccv_nnc_tensor_data_size(symbol_info->constant->info), 0);
+		else
+			sqlite3_bind_null(tensor_symbol_insert_stmt, 19);
 		SQLITE_ENFORCE(SQLITE_DONE == sqlite3_step(tensor_symbol_insert_stmt));
 		sqlite3_reset(tensor_symbol_insert_stmt);
 		sqlite3_clear_bindings(tensor_symbol_insert_stmt);
@@ -177,6 +181,23 @@ static void _ccv_nnc_symbolic_graph_push_repo(const ccv_nnc_symbolic_graph_t* co
 		}
 }
 
+// The constant column is added later, the files written before don't have it.
+static int _ccv_nnc_tensor_symbol_has_constant(sqlite3* const conn)
+{
+	const char tensor_symbol_table_info_qs[] = "PRAGMA table_info(tensor_symbol)";
+	sqlite3_stmt* tensor_symbol_table_info_stmt = 0;
+	if (SQLITE_OK != sqlite3_prepare_v2(conn, tensor_symbol_table_info_qs, sizeof(tensor_symbol_table_info_qs), &tensor_symbol_table_info_stmt, 0))
+		return 0;
+	int has_constant = 0;
+	while (!has_constant && SQLITE_ROW == sqlite3_step(tensor_symbol_table_info_stmt))
+	{
+		const char* const name = (const char*)sqlite3_column_text(tensor_symbol_table_info_stmt, 1);
+		has_constant = name && strcmp(name, "constant") == 0;
+	}
+	sqlite3_finalize(tensor_symbol_table_info_stmt);
+	return has_constant;
+}
+
 void ccv_nnc_symbolic_graph_write(const ccv_nnc_symbolic_graph_t* const graph, const ccv_nnc_tensor_bind_t* const tensor_binds, const int tensor_bind_size, const char* const fn)
 {
 	sqlite3* conn = 0;
@@ -187,14 +208,16 @@ void ccv_nnc_symbolic_graph_write(const ccv_nnc_symbolic_graph_t* const graph, c
 		"(id INTEGER, graph INTEGER, assign_ref INTEGER, r_assign_ref INTEGER, "
 		"bypass_ref INTEGER, r_bypass_ref INTEGER, p_ref INTEGER, alias_ref INTEGER, peer_ref INTEGER, "
 		"flags INTEGER, ofs BLOB, inc BLOB, s_ref BLOB, name TEXT, type INTEGER, format INTEGER, "
-		"datatype INTEGER, dim BLOB, PRIMARY KEY (id, graph))";
+		"datatype INTEGER, dim BLOB, constant BLOB, PRIMARY KEY (id, graph))";
 	SQLITE_ENFORCE(SQLITE_OK == sqlite3_exec(conn, tensor_symbol_create_table_qs, 0, 0, 0));
+	if (!_ccv_nnc_tensor_symbol_has_constant(conn))
+		SQLITE_ENFORCE(SQLITE_OK == sqlite3_exec(conn, "ALTER TABLE tensor_symbol ADD COLUMN constant BLOB", 0, 0, 0));
 	const char tensor_symbol_insert_qs[] = 
 		"REPLACE INTO tensor_symbol "
 		"(id, graph, assign_ref, r_assign_ref, bypass_ref, r_bypass_ref, p_ref, alias_ref, peer_ref, flags, "
-		"ofs, inc, s_ref, name, type, format, datatype, dim) VALUES "
+		"ofs, inc, s_ref, name, type, format, datatype, dim, constant) VALUES "
 		"($id, $graph, $assign_ref, $r_assign_ref, $bypass_ref, $r_bypass_ref, $p_ref, $alias_ref, $peer_ref, "
-		"$flags, $ofs, $inc, $s_ref, $name, $type, $format, $datatype, $dim)";
+		"$flags, $ofs, $inc, $s_ref, $name, $type, $format, $datatype, $dim, $constant)";
 	sqlite3_stmt* tensor_symbol_insert_stmt = 0;
 	SQLITE_ENFORCE(SQLITE_OK == sqlite3_prepare_v2(conn, tensor_symbol_insert_qs, sizeof(tensor_symbol_insert_qs), &tensor_symbol_insert_stmt, 0));
 
@@ -481,6 +504,17 @@ static void _ccv_nnc_symbolic_graph_read(const int graph_idx, sqlite3_stmt* cons
 		const int* const dim = sqlite3_column_blob(tensor_symbol_select_stmt, 16);
 		if (dim)
 			memcpy(symbol_info->info.dim, dim, ccv_min(sqlite3_column_bytes(tensor_symbol_select_stmt, 16), sizeof(symbol_info->info.dim)));
+		const void* const constant = sqlite3_column_blob(tensor_symbol_select_stmt, 17);
+		if (constant)
+		{
+			ccv_nnc_tensor_param_t cpu_info = symbol_info->info;
+			cpu_info.type = CCV_TENSOR_CPU_MEMORY;
+			assert(sqlite3_column_bytes(tensor_symbol_select_stmt, 17) == ccv_nnc_tensor_data_size(cpu_info));
+			symbol_info->constant = ccv_nnc_tensor_new(0, cpu_info, 0);
+			memcpy(symbol_info->constant->data.u8, constant, ccv_nnc_tensor_data_size(cpu_info));
+			ccv_nnc_tensor_constant_sign(symbol_info->constant);
+		} else
+			symbol_info->constant = 0;
 		if (CCV_NNC_TENSOR_SYMBOL_IS_DEAD(symbol_info->flags) && graph->reuse.tensor < 0)
 			graph->reuse.tensor = i;
 	}
@@ -608,8 +642,15 @@ void ccv_nnc_symbolic_graph_read(const char* const fn, ccv_nnc_symbolic_graph_t*
 	sqlite3_stmt* tensor_symbol_select_stmt = 0;
 	const char tensor_symbol_select_qs[] =
 		"SELECT id, assign_ref, r_assign_ref, bypass_ref, r_bypass_ref, p_ref, alias_ref, peer_ref, flags, ofs, inc, "
-		"s_ref, name, type, format, datatype, dim FROM tensor_symbol WHERE graph=$graph ORDER BY id";
-	SQLITE_ENFORCE(SQLITE_OK == sqlite3_prepare_v2(conn, tensor_symbol_select_qs, sizeof(tensor_symbol_select_qs), &tensor_symbol_select_stmt, 0));
+		"s_ref, name, type, format, datatype, dim, constant FROM tensor_symbol WHERE graph=$graph ORDER BY id";
+	// Without the constant column, select NULL in its place, thus, no tensor symbol is read as constant.
+	const char tensor_symbol_without_constant_select_qs[] =
+		"SELECT id, assign_ref, r_assign_ref, bypass_ref, r_bypass_ref, p_ref, alias_ref, peer_ref, flags, ofs, inc, "
+		"s_ref, name, type, format, datatype, dim, NULL FROM tensor_symbol WHERE graph=$graph ORDER BY id";
+	if (_ccv_nnc_tensor_symbol_has_constant(conn))
+		SQLITE_ENFORCE(SQLITE_OK == sqlite3_prepare_v2(conn, tensor_symbol_select_qs, sizeof(tensor_symbol_select_qs), &tensor_symbol_select_stmt, 0));
+	else
+		SQLITE_ENFORCE(SQLITE_OK == sqlite3_prepare_v2(conn, tensor_symbol_without_constant_select_qs, sizeof(tensor_symbol_without_constant_select_qs), &tensor_symbol_select_stmt, 0));
 	const char exec_symbol_select_qs[] =
 		"SELECT id, input_size, output_size, graph_ref_size, flags, peer_ref, inputs, outputs, outgoings, "
 		"name, cmd_cmd, cmd_backend, cmd_algorithm, cmd_info, hint, graph_ref, case_of_expr, case_of_flags, "
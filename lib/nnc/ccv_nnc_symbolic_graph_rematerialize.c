@@ -0,0 +1,518 @@
+#include "ccv_nnc.h"
+#include "ccv_nnc_easy.h"
+#include "ccv_nnc_internal.h"
+#include "ccv_internal.h"
+#include "_ccv_nnc_symbolic_graph.h"
+
+#pragma mark - Level-3.5 API
+
+enum {
+	CCV_NNC_REMAT_RETAINED = 0x1, // This tensor is produced in the forward pass and read in the backward pass.
+	CCV_NNC_REMAT_RECOMPUTABLE = 0x2, // This tensor can be recomputed by replaying its producer.
+	CCV_NNC_REMAT_CANDIDATE = 0x4, // This tensor can be dropped and recomputed right before the backward pass reads it.
+	CCV_NNC_REMAT_DROPPED = 0x8, // This tensor is dropped.
+	CCV_NNC_REMAT_ALIASED = 0x10, // There are aliases to this tensor.
+};
+
+typedef struct {
+	int tensor_symbol_info_size;
+	int exec_symbol_info_size;
+	int forward_tensor_symbol_size; // Tensors before this are created before ccv_nnc_symbolic_graph_backward.
+	int max_recompute_size; // The maximum number of commands to replay for one dropped tensor.
+	ccv_nnc_symbolic_graph_t* graph;
+	ccv_nnc_graph_visit_t* visit;
+	ccv_nnc_tensor_symbol_info_t* tensor_symbol_info;
+	ccv_nnc_graph_exec_symbol_info_t* exec_symbol_info;
+	int* exec_rank; // The position of the exec in the topological order, -1 if it is not visited.
+	int* output_execs; // Mapping from tensor to the exec that generates this tensor, -1 if there is none, -2 if there are multiple.
+	int* tensor_flags;
+	int* recompute_size; // For dropped tensors, how many commands we replay to recompute it.
+	uint32_t* backward_execs; // Mark a exec is part of the backward pass, each bit represent a exec.
+	uint32_t* exec_visited; // Scratch space to collect commands to replay, each bit represent a exec.
+	ccv_array_t* recompute_execs; // Scratch space to collect commands to replay.
+} ccv_nnc_symbolic_graph_rematerialize_t;
+
+static int _ccv_nnc_rematerialize_cmd_is_cheap(const ccv_nnc_cmd_t cmd)
+{
+	switch (cmd.cmd)
+	{
+		case CCV_NNC_RELU_FORWARD:
+		case CCV_NNC_SOFTMAX_FORWARD:
+		case CCV_NNC_ADD_FORWARD:
+		case CCV_NNC_MUL_FORWARD:
+		case CCV_NNC_SCALAR_MUL_FORWARD:
+		case CCV_NNC_EWSUM_FORWARD:
+		case CCV_NNC_EWPROD_FORWARD:
+		case CCV_NNC_EWDIV_FORWARD:
+		case CCV_NNC_EWEXP_FORWARD:
+		case CCV_NNC_EWLOG_FORWARD:
+		case CCV_NNC_EWSQRT_FORWARD:
+		case CCV_NNC_DATA_TRANSFER_FORWARD:
+		case CCV_NNC_FORMAT_TRANSFORM_FORWARD:
+			return 1;
+	}
+	return 0;
+}
+
+static int _ccv_nnc_rematerialize_cmd_is_recomputable(const ccv_nnc_cmd_t cmd)
+{
+	// Batch norm is not here because in training mode, it updates the running mean / variance in place, replaying it
+	// will update these twice. Dropout and random commands are not here because replaying them generates different
+	// results.
+	switch (cmd.cmd)
+	{
+		case CCV_NNC_CONVOLUTION_FORWARD:
+		case CCV_NNC_GEMM_FORWARD:
+		case CCV_NNC_MAX_POOL_FORWARD:
+		case CCV_NNC_AVERAGE_POOL_FORWARD:
+			return 1;
+	}
+	return _ccv_nnc_rematerialize_cmd_is_cheap(cmd);
+}
+
+static ccv_nnc_symbolic_graph_rematerialize_t* _ccv_nnc_symbolic_graph_rematerialize_new(ccv_nnc_symbolic_graph_t* const graph, const ccv_nnc_graph_exec_symbol_t* const sources, const int source_size, const ccv_nnc_graph_exec_symbol_t* const destinations, const int destination_size)
+{
+	ccv_nnc_symbolic_graph_rematerialize_t* const remat = (ccv_nnc_symbolic_graph_rematerialize_t*)ccmalloc(sizeof(ccv_nnc_symbolic_graph_rematerialize_t));
+	remat->graph = graph;
+	remat->visit = ccv_nnc_graph_visit_new(graph, (ccv_nnc_graph_exec_symbol_info_t*)ccv_array_get(graph->exec_symbol_info, 0), graph->exec_symbol_info->rnum, sources, source_size, destinations, destination_size, 0);
+	remat->tensor_symbol_info = (ccv_nnc_tensor_symbol_info_t*)ccmalloc(sizeof(ccv_nnc_tensor_symbol_info_t) * graph->tensor_symbol_info->rnum);
+	remat->exec_symbol_info = (ccv_nnc_graph_exec_symbol_info_t*)ccmalloc(sizeof(ccv_nnc_graph_exec_symbol_info_t) * graph->exec_symbol_info->rnum);
+	ccv_nnc_symbolic_graph_symbol_infer(graph, remat->visit, sources, source_size, destinations, destination_size, 0, 0, remat->tensor_symbol_info, remat->exec_symbol_info);
+	remat->tensor_symbol_info_size = graph->tensor_symbol_info->rnum;
+	remat->exec_symbol_info_size = graph->exec_symbol_info->rnum;
+	remat->forward_tensor_symbol_size = ccv_min(graph->backward.tensor_symbol_size, remat->tensor_symbol_info_size);
+	remat->exec_rank = (int*)ccmalloc(sizeof(int) * (remat->exec_symbol_info_size + remat->tensor_symbol_info_size * 3));
+	remat->output_execs = remat->exec_rank + remat->exec_symbol_info_size;
+	remat->tensor_flags = remat->output_execs + remat->tensor_symbol_info_size;
+	remat->recompute_size = remat->tensor_flags + remat->tensor_symbol_info_size;
+	remat->backward_execs = (uint32_t*)cccalloc(((remat->exec_symbol_info_size + 31) >> 5) * 2, sizeof(uint32_t));
+	remat->exec_visited = remat->backward_execs + ((remat->exec_symbol_info_size + 31) >> 5);
+	remat->recompute_execs = ccv_array_new(sizeof(int), 0, 0);
+	int i, j;
+	for (i = 0; i < remat->exec_symbol_info_size; i++)
+		remat->exec_rank[i] = -1;
+	for (i = 0; i < remat->tensor_symbol_info_size; i++)
+	{
+		remat->output_execs[i] = -1;
+		remat->tensor_flags[i] = 0;
+		remat->recompute_size[i] = 0;
+	}
+	int rank = 0, forward_exec_size = 0;
+	ccv_nnc_graph_visit_for(remat->visit, remat->exec_symbol_info, node, idx) {
+		remat->exec_rank[idx] = rank++;
+		int is_backward = ccv_nnc_cmd_is_backward(node->cmd);
+		for (i = 0; i < node->output_size; i++)
+		{
+			const int d = node->outputs[i];
+			if (d < 0)
+				continue;
+			remat->output_execs[d] = remat->output_execs[d] == -1 ? idx : -2;
+			// Any command writes to the gradients, the updated parameters etc. is part of the backward pass.
+			if (d >= remat->forward_tensor_symbol_size)
+				is_backward = 1;
+		}
+		if (is_backward)
+			remat->backward_execs[idx >> 5] |= (1u << (idx & 0x1f));
+		else
+			++forward_exec_size;
+	} ccv_nnc_graph_visit_endfor
+	// Replaying a segment of sqrt(n) commands for each dropped tensor bounds the overhead the same way as checkpointing
+	// every sqrt(n) commands does.
+	remat->max_recompute_size = ccv_max(2, (int)(sqrtf(forward_exec_size) + 0.5));
+	for (i = 0; i < remat->tensor_symbol_info_size; i++)
+		if (remat->tensor_symbol_info[i].alias_ref)
+			remat->tensor_flags[remat->tensor_symbol_info[i].alias_ref - 1] |= CCV_NNC_REMAT_ALIASED;
+	ccv_nnc_graph_visit_for(remat->visit, remat->exec_symbol_info, node, idx) {
+		if (remat->backward_execs[idx >> 5] & (1u << (idx & 0x1f)))
+		{
+			// Whatever the backward pass reads from the forward pass is retained until then.
+			for (i = 0; i < node->input_size; i++)
+			{
+				int d = node->inputs[i];
+				if (d < 0)
+					continue;
+				if (remat->tensor_symbol_info[d].alias_ref)
+					d = remat->tensor_symbol_info[d].alias_ref - 1;
+				if (d < remat->forward_tensor_symbol_size && remat->output_execs[d] >= 0 &&
+					!(remat->backward_execs[remat->output_execs[d] >> 5] & (1u << (remat->output_execs[d] & 0x1f))))
+					remat->tensor_flags[d] |= CCV_NNC_REMAT_RETAINED;
+			}
+			continue;
+		}
+		if (node->graph_ref_size || !_ccv_nnc_rematerialize_cmd_is_recomputable(node->cmd))
+			continue;
+		int output_size = 0;
+		for (i = 0; i < node->output_size; i++)
+			if (node->outputs[i] >= 0)
+				++output_size;
+		if (output_size != 1)
+			continue;
+		for (i = 0; i < node->output_size; i++)
+		{
+			const int d = node->outputs[i];
+			if (d < 0)
+				continue;
+			int flag = !remat->tensor_symbol_info[d].alias_ref && !remat->tensor_symbol_info[d].flags && remat->output_execs[d] == idx;
+			for (j = 0; flag && j < node->input_size; j++)
+				if (node->inputs[j] == d)
+					flag = 0;
+			if (flag)
+				remat->tensor_flags[d] |= CCV_NNC_REMAT_RECOMPUTABLE;
+		}
+	} ccv_nnc_graph_visit_endfor
+	for (i = 0; i < remat->forward_tensor_symbol_size; i++)
+		if ((remat->tensor_flags[i] & (CCV_NNC_REMAT_RETAINED | CCV_NNC_REMAT_RECOMPUTABLE)) == (CCV_NNC_REMAT_RETAINED | CCV_NNC_REMAT_RECOMPUTABLE) &&
+			!(remat->tensor_flags[i] & CCV_NNC_REMAT_ALIASED))
+			remat->tensor_flags[i] |= CCV_NNC_REMAT_CANDIDATE;
+	// The readers in the backward pass will read the recomputed tensor instead, thus, they cannot be sub-graphs.
+	ccv_nnc_graph_visit_for(remat->visit, remat->exec_symbol_info, node, idx) {
+		if (!(remat->backward_execs[idx >> 5] & (1u << (idx & 0x1f))) || !node->graph_ref_size)
+			continue;
+		for (i = 0; i < node->input_size; i++)
+			if (node->inputs[i] >= 0)
+				remat->tensor_flags[node->inputs[i]] &= ~CCV_NNC_REMAT_CANDIDATE;
+	} ccv_nnc_graph_visit_endfor
+	return remat;
+}
+
+static void _ccv_nnc_symbolic_graph_rematerialize_free(ccv_nnc_symbolic_graph_rematerialize_t* const remat)
+{
+	ccv_nnc_graph_visit_free(remat->visit);
+	ccfree(remat->tensor_symbol_info);
+	ccfree(remat->exec_symbol_info);
+	ccfree(remat->exec_rank);
+	ccfree(remat->backward_execs);
+	ccv_array_free(remat->recompute_execs);
+	ccfree(remat);
+}
+
+// Collect the commands to replay for tensor d into recompute_execs. It goes back until it reaches a tensor that
+// is retained anyway (or a tensor not produced by this graph, such as inputs and parameters). Returns 0 if
+// d cannot be recomputed within max_recompute_size commands.
+static int _ccv_nnc_rematerialize_collect(ccv_nnc_symbolic_graph_rematerialize_t* const remat, const int d, int* const is_cheap)
+{
+	const int exec_idx = remat->output_execs[d];
+	assert(exec_idx >= 0);
+	if (remat->exec_visited[exec_idx >> 5] & (1u << (exec_idx & 0x1f)))
+		return 1;
+	if (remat->recompute_execs->rnum >= remat->max_recompute_size)
+		return 0;
+	remat->exec_visited[exec_idx >> 5] |= (1u << (exec_idx & 0x1f));
+	ccv_array_push(remat->recompute_execs, &exec_idx);
+	const ccv_nnc_graph_exec_symbol_info_t* const node = remat->exec_symbol_info + exec_idx;
+	if (!_ccv_nnc_rematerialize_cmd_is_cheap(node->cmd))
+		*is_cheap = 0;
+	int i;
+	for (i = 0; i < node->input_size; i++)
+	{
+		const int x = node->inputs[i];
+		if (x < 0)
+			continue;
+		const int base = remat->tensor_symbol_info[x].alias_ref ? remat->tensor_symbol_info[x].alias_ref - 1 : x;
+		if (remat->output_execs[base] == -1)
+			continue; // Not produced by this graph, it is there all the time.
+		if (remat->output_execs[base] == -2)
+			return 0;
+		if ((remat->tensor_flags[base] & (CCV_NNC_REMAT_RETAINED | CCV_NNC_REMAT_DROPPED)) == CCV_NNC_REMAT_RETAINED)
+			continue;
+		// Only recompute the tensor directly, not through an alias.
+		if (base != x || !(remat->tensor_flags[base] & CCV_NNC_REMAT_RECOMPUTABLE))
+			return 0;
+		if (!_ccv_nnc_rematerialize_collect(remat, base, is_cheap))
+			return 0;
+	}
+	return 1;
+}
+
+// Returns the number of commands to replay for tensor d, or -1 if it cannot be recomputed.
+static int _ccv_nnc_rematerialize_recompute_size(ccv_nnc_symbolic_graph_rematerialize_t* const remat, const int d, int* const is_cheap)
+{
+	int i;
+	ccv_array_clear(remat->recompute_execs);
+	*is_cheap = 1;
+	const int flag = _ccv_nnc_rematerialize_collect(remat, d, is_cheap);
+	for (i = 0; i < remat->recompute_execs->rnum; i++)
+	{
+		const int idx = *(int*)ccv_array_get(remat->recompute_execs, i);
+		remat->exec_visited[idx >> 5] &= ~(1u << (idx & 0x1f));
+	}
+	return flag ? remat->recompute_execs->rnum : -1;
+}
+
+// The memory of the tensors the collected commands recompute before they reach tensor d, these are alive at the same
+// time as the retained ones when d is recomputed. The recomputed d itself is not counted, it is counted as retained.
+static size_t _ccv_nnc_rematerialize_recompute_footprint(const ccv_nnc_symbolic_graph_rematerialize_t* const remat, const int d)
+{
+	int i, j;
+	size_t footprint = 0;
+	for (i = 0; i < remat->recompute_execs->rnum; i++)
+	{
+		const ccv_nnc_graph_exec_symbol_info_t* const node = remat->exec_symbol_info + *(int*)ccv_array_get(remat->recompute_execs, i);
+		for (j = 0; j < node->output_size; j++)
+			if (node->outputs[j] >= 0 && node->outputs[j] != d)
+				footprint += ccv_nnc_tensor_data_size(remat->tensor_symbol_info[node->outputs[j]].info);
+	}
+	return footprint;
+}
+
+// The earliest reader of tensor d in the backward pass.
+static int _ccv_nnc_rematerialize_first_reader(const ccv_nnc_symbolic_graph_rematerialize_t* const remat, const int d)
+{
+	int i, first = -1;
+	ccv_nnc_graph_visit_for(remat->visit, remat->exec_symbol_info, node, idx) {
+		if (!(remat->backward_execs[idx >> 5] & (1u << (idx & 0x1f))))
+			continue;
+		for (i = 0; i < node->input_size; i++)
+			if (node->inputs[i] == d)
+			{
+				first = idx;
+				break;
+			}
+		if (first >= 0)
+			break;
+	} ccv_nnc_graph_visit_endfor
+	return first;
+}
+
+// The commands in the backward pass that run right before the exec, the recomputation starts after them.
+static void _ccv_nnc_rematerialize_backward_incomings(const ccv_nnc_symbolic_graph_rematerialize_t* const remat, const int exec_idx, ccv_array_t* const incomings)
+{
+	int i;
+	ccv_array_clear(incomings);
+	ccv_nnc_graph_visit_for(remat->visit, remat->exec_symbol_info, node, idx) {
+		if (!(remat->backward_execs[idx >> 5] & (1u << (idx & 0x1f))) || !node->outgoings)
+			continue;
+		for (i = 0; i < node->outgoings->rnum; i++)
+			if (*(int*)ccv_array_get(node->outgoings, i) == exec_idx)
+			{
+				ccv_array_push(incomings, &idx);
+				break;
+			}
+	} ccv_nnc_graph_visit_endfor
+}
+
+// Replay the commands in their topological order, there are only a few of them, insertion sort is fine.
+static void _ccv_nnc_rematerialize_sort_by_rank(int* const execs, const int exec_size, const int* const exec_rank)
+{
+	int i, j;
+	for (i = 1; i < exec_size; i++)
+	{
+		const int idx = execs[i];
+		for (j = i; j > 0 && exec_rank[execs[j - 1]] > exec_rank[idx]; j--)
+			execs[j] = execs[j - 1];
+		execs[j] = idx;
+	}
+}
+
+// Returns the largest memory of the tensors recomputed alongside a dropped one, see _ccv_nnc_rematerialize_recompute_footprint.
+static uint64_t _ccv_nnc_rematerialize_select(ccv_nnc_symbolic_graph_rematerialize_t* const remat, uint64_t* const retained_size, const uint64_t max_memory_size)
+{
+	int i, j;
+	ccv_array_t* const incomings = ccv_array_new(sizeof(int), 0, 0);
+	// Tensors without any command in the backward pass right before its first reader would be recomputed at the
+	// beginning of the backward pass, that saves nothing.
+	for (i = 0; i < remat->forward_tensor_symbol_size; i++)
+		if (remat->tensor_flags[i] & CCV_NNC_REMAT_CANDIDATE)
+		{
+			const int first_reader = _ccv_nnc_rematerialize_first_reader(remat, i);
+			if (first_reader >= 0)
+				_ccv_nnc_rematerialize_backward_incomings(remat, first_reader, incomings);
+			if (first_reader < 0 || !incomings->rnum)
+				remat->tensor_flags[i] &= ~CCV_NNC_REMAT_CANDIDATE;
+		}
+	ccv_array_free(incomings);
+	uint64_t recompute_footprint = 0;
+	while (*retained_size + recompute_footprint > max_memory_size)
+	{
+		// Drop the cheapest one first: tensors recomputed with element-wise commands, then the ones replay fewer commands,
+		// then the larger ones.
+		int best = -1, best_tier = 0, best_cost = 0;
+		size_t best_size = 0;
+		uint64_t best_footprint = 0;
+		for (i = 0; i < remat->forward_tensor_symbol_size; i++)
+		{
+			if ((remat->tensor_flags[i] & (CCV_NNC_REMAT_CANDIDATE | CCV_NNC_REMAT_DROPPED)) != CCV_NNC_REMAT_CANDIDATE)
+				continue;
+			remat->tensor_flags[i] |= CCV_NNC_REMAT_DROPPED;
+			int is_cheap;
+			int cost = _ccv_nnc_rematerialize_recompute_size(remat, i, &is_cheap);
+			uint64_t footprint = cost >= 0 ? _ccv_nnc_rematerialize_recompute_footprint(remat, i) : 0;
+			// Tensors dropped earlier may need to replay more commands now.
+			for (j = 0; cost >= 0 && j < remat->forward_tensor_symbol_size; j++)
+				if (j != i && (remat->tensor_flags[j] & CCV_NNC_REMAT_DROPPED))
+				{
+					int other_is_cheap;
+					const int other_cost = _ccv_nnc_rematerialize_recompute_size(remat, j, &other_is_cheap);
+					if (other_cost < 0)
+						cost = -1;
+					else {
+						if (other_cost > remat->recompute_size[j])
+						{
+							cost += other_cost - remat->recompute_size[j];
+							is_cheap = is_cheap && other_is_cheap;
+						}
+						// The largest one, not the sum, a command shared by several segments is replayed once and
+						// its output is only counted once (see _ccv_nnc_rematerialize_apply).
+						footprint = ccv_max(footprint, _ccv_nnc_rematerialize_recompute_footprint(remat, j));
+					}
+				}
+			remat->tensor_flags[i] &= ~CCV_NNC_REMAT_DROPPED;
+			if (cost < 0)
+				continue;
+			const size_t size = ccv_nnc_tensor_data_size(remat->tensor_symbol_info[i].info);
+			// Dropping it shouldn't take more memory than it saves. If it breaks even, the next ones recomputed alongside can
+			// share the footprint, thus, still drop it.
+			if (footprint > recompute_footprint + size)
+				continue;
+			const int tier = is_cheap ? 0 : 1;
+			if (best < 0 || tier < best_tier || (tier == best_tier && (cost < best_cost || (cost == best_cost && size > best_size))))
+				best = i, best_tier = tier, best_cost = cost, best_size = size, best_footprint = footprint;
+		}
+		if (best < 0)
+			break;
+		remat->tensor_flags[best] |= CCV_NNC_REMAT_DROPPED;
+		for (i = 0; i < remat->forward_tensor_symbol_size; i++)
+			if (remat->tensor_flags[i] & CCV_NNC_REMAT_DROPPED)
+			{
+				int is_cheap;
+				remat->recompute_size[i] = _ccv_nnc_rematerialize_recompute_size(remat, i, &is_cheap);
+				assert(remat->recompute_size[i] > 0);
+			}
+		*retained_size -= best_size;
+		recompute_footprint = best_footprint;
+	}
+	return recompute_footprint;
+}
+
+static void _ccv_nnc_rematerialize_apply(ccv_nnc_symbolic_graph_rematerialize_t* const remat)
+{
+	ccv_nnc_symbolic_graph_t* const graph = remat->graph;
+	int i, j, k, d;
+	int max_io_size = 1;
+	for (i = 0; i < remat->exec_symbol_info_size; i++)
+		max_io_size = ccv_max(max_io_size, remat->exec_symbol_info[i].input_size + remat->exec_symbol_info[i].output_size);
+	ccv_nnc_tensor_symbol_t* const io = (ccv_nnc_tensor_symbol_t*)ccmalloc(sizeof(ccv_nnc_tensor_symbol_t) * max_io_size);
+	// Mapping from the original tensor to its recomputed one, and the command that recomputes it.
+	int* const tensor_remap = (int*)ccmalloc(sizeof(int) * remat->tensor_symbol_info_size * 2);
+	int* const remap_execs = tensor_remap + remat->tensor_symbol_info_size;
+	for (i = 0; i < remat->tensor_symbol_info_size; i++)
+		tensor_remap[i] = remap_execs[i] = -1;
+	ccv_array_t* const incomings = ccv_array_new(sizeof(int), 0, 0);
+	// Recompute the dropped tensors in the order the backward pass reads them, thus, if the segments to replay for
+	// them share commands, the one replayed for the earlier reader is reused by the later ones.
+	int* const dropped = (int*)ccmalloc(sizeof(int) * remat->forward_tensor_symbol_size * 2);
+	int* const first_readers = dropped + remat->forward_tensor_symbol_size;
+	int dropped_size = 0;
+	for (d = 0; d < remat->forward_tensor_symbol_size; d++)
+		if (remat->tensor_flags[d] & CCV_NNC_REMAT_DROPPED)
+		{
+			dropped[dropped_size] = d;
+			first_readers[d] = _ccv_nnc_rematerialize_first_reader(remat, d);
+			assert(first_readers[d] >= 0);
+			for (i = dropped_size; i > 0 && remat->exec_rank[first_readers[dropped[i - 1]]] > remat->exec_rank[first_readers[d]]; i--)
+				dropped[i] = dropped[i - 1];
+			dropped[i] = d;
+			++dropped_size;
+		}
+	for (k = 0; k < dropped_size; k++)
+	{
+		d = dropped[k];
+		int is_cheap;
+		const int recompute_size = _ccv_nnc_rematerialize_recompute_size(remat, d, &is_cheap);
+		assert(recompute_size > 0);
+		_ccv_nnc_rematerialize_sort_by_rank((int*)ccv_array_get(remat->recompute_execs, 0), recompute_size, remat->exec_rank);
+		_ccv_nnc_rematerialize_backward_incomings(remat, first_readers[d], incomings);
+		assert(incomings->rnum > 0);
+		// The commands replayed before this are reused, the new ones are from here.
+		const int exec_symbol_size = graph->exec_symbol_info->rnum;
+		for (i = 0; i < recompute_size; i++)
+		{
+			const int exec_idx = *(int*)ccv_array_get(remat->recompute_execs, i);
+			const ccv_nnc_graph_exec_symbol_info_t* const node = remat->exec_symbol_info + exec_idx;
+			for (j = 0; j < node->output_size; j++)
+				if (node->outputs[j] >= 0 && remap_execs[node->outputs[j]] >= 0)
+					break;
+			if (j < node->output_size)
+				continue;
+			int is_head = 1;
+			for (j = 0; j < node->input_size; j++)
+			{
+				const int x = node->inputs[j];
+				if (x >= 0 && remap_execs[x] >= exec_symbol_size)
+					is_head = 0;
+				io[j] = (ccv_nnc_tensor_symbol_t){
+					.d = x >= 0 && tensor_remap[x] >= 0 ? tensor_remap[x] : x,
+					.graph = x >= 0 ? graph : 0,
+				};
+			}
+			for (j = 0; j < node->output_size; j++)
+			{
+				const int y = node->outputs[j];
+				if (y >= 0)
+				{
+					io[node->input_size + j] = ccv_nnc_tensor_symbol_new(graph, remat->tensor_symbol_info[y].info, remat->tensor_symbol_info[y].name);
+					tensor_remap[y] = io[node->input_size + j].d;
+				} else
+					io[node->input_size + j] = NO_TENSOR_SYMBOL;
+			}
+			const ccv_nnc_graph_exec_symbol_t recompute = ccv_nnc_graph_exec_symbol_new(graph, node->cmd, io, node->input_size, io + node->input_size, node->output_size, node->name);
+			ccv_nnc_graph_exec_symbol_set_hint(graph, recompute, node->hint);
+			for (j = 0; j < node->output_size; j++)
+				if (node->outputs[j] >= 0)
+					remap_execs[node->outputs[j]] = recompute.d;
+			for (j = 0; j < node->input_size; j++)
+			{
+				const int x = node->inputs[j];
+				if (x >= 0 && remap_execs[x] >= 0)
+					ccv_nnc_graph_exec_symbol_concat(graph, (ccv_nnc_graph_exec_symbol_t){
+						.d = remap_execs[x],
+						.graph = graph,
+					}, recompute);
+			}
+			// Start the recomputation only when the backward pass is about to read it.
+			if (is_head)
+				for (j = 0; j < incomings->rnum; j++)
+					ccv_nnc_graph_exec_symbol_concat(graph, (ccv_nnc_graph_exec_symbol_t){
+						.d = *(int*)ccv_array_get(incomings, j),
+						.graph = graph,
+					}, recompute);
+		}
+		// Now, the backward pass reads the recomputed tensor instead.
+		ccv_nnc_graph_visit_for(remat->visit, remat->exec_symbol_info, node, idx) {
+			if (!(remat->backward_execs[idx >> 5] & (1u << (idx & 0x1f))))
+				continue;
+			ccv_nnc_graph_exec_symbol_info_t* const exec_info = (ccv_nnc_graph_exec_symbol_info_t*)ccv_array_get(graph->exec_symbol_info, idx);
+			int flag = 0;
+			for (j = 0; j < exec_info->input_size; j++)
+				if (exec_info->inputs[j] == d)
+					exec_info->inputs[j] = tensor_remap[d], flag = 1;
+			if (flag)
+				ccv_nnc_graph_exec_symbol_concat(graph, (ccv_nnc_graph_exec_symbol_t){
+					.d = remap_execs[d],
+					.graph = graph,
+				}, (ccv_nnc_graph_exec_symbol_t){
+					.d = idx,
+					.graph = graph,
+				});
+		} ccv_nnc_graph_visit_endfor
+	}
+	ccfree(dropped);
+	ccv_array_free(incomings);
+	ccfree(tensor_remap);
+	ccfree(io);
+}
+
+uint64_t ccv_nnc_symbolic_graph_rematerialize(ccv_nnc_symbolic_graph_t* const graph, const uint64_t max_memory_size, const ccv_nnc_graph_exec_symbol_t* const sources, const int source_size, const ccv_nnc_graph_exec_symbol_t* const destinations, const int destination_size)
+{
+	assert(graph->backward.tensor_symbol_idx); // Need to call ccv_nnc_symbolic_graph_backward first.
+	ccv_nnc_symbolic_graph_rematerialize_t* const remat = _ccv_nnc_symbolic_graph_rematerialize_new(graph, sources, source_size, destinations, destination_size);
+	int i;
+	uint64_t retained_size = 0;
+	for (i = 0; i < remat->forward_tensor_symbol_size; i++)
+		if (remat->tensor_flags[i] & CCV_NNC_REMAT_RETAINED)
+			retained_size += ccv_nnc_tensor_data_size(remat->tensor_symbol_info[i].info);
+	const uint64_t recompute_footprint = _ccv_nnc_rematerialize_select(remat, &retained_size, max_memory_size);
+	_ccv_nnc_rematerialize_apply(remat);
+	_ccv_nnc_symbolic_graph_rematerialize_free(remat);
+	return retained_size + recompute_footprint;
+}
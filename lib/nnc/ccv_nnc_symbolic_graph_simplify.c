@@ -669,6 +669,358 @@ static void _ccv_nnc_symbolic_graph_ops_fusion(ccv_nnc_symbolic_graph_simplify_t
 	} ccv_nnc_graph_visit_endfor
 }
 
+static int _ccv_nnc_epilogue_tensor_is_cpu_32f(const ccv_nnc_tensor_symbol_info_t* const tensor_symbol_info)
+{
+	return CCV_TENSOR_GET_MEMORY(tensor_symbol_info->info.type) == CCV_TENSOR_CPU_MEMORY && tensor_symbol_info->info.datatype == CCV_32F;
+}
+
+// Whether the tensor is plain: not an alias, no alias refers to it, not a tape variable, and not involved in while
+// loops / sub-graphs.
+static int _ccv_nnc_simplify_tensor_is_plain(const ccv_nnc_tensor_symbol_info_t* const tensor_symbol_info, const uint32_t* const aliased, const int d)
+{
+	const ccv_nnc_tensor_symbol_info_t* const symbol_info = tensor_symbol_info + d;
+	return !symbol_info->alias_ref && !(aliased[d >> 5] & (1u << (d & 0x1f))) &&
+		!symbol_info->assign_ref && !symbol_info->r_assign_ref && !symbol_info->bypass_ref && !symbol_info->r_bypass_ref &&
+		!symbol_info->p_ref && !(symbol_info->s_ref && symbol_info->s_ref->rnum) &&
+		!(symbol_info->flags & CCV_NNC_TENSOR_SYMBOL_TAPE_VAR);
+}
+
+static void _ccv_nnc_symbolic_graph_epilogue_fusion(ccv_nnc_symbolic_graph_simplify_t* const simplify, const ccv_nnc_tensor_symbol_t* const outputs, const int output_size)
+{
+	uint32_t* const exec_dead = simplify->exec_dead;
+	uint32_t* const tensor_dead = simplify->tensor_dead;
+	ccv_nnc_graph_exec_symbol_info_t* const exec_symbol_info = simplify->exec_symbol_info;
+	const ccv_nnc_tensor_symbol_info_t* const tensor_symbol_info = simplify->tensor_symbol_info;
+	const int tensor_symbol_info_size = simplify->tensor_symbol_info_size;
+	int i, j;
+	_ccv_nnc_symbolic_graph_simplify_update_output_execs(simplify);
+	uint32_t* const aliased = (uint32_t*)cccalloc(((tensor_symbol_info_size + 31) >> 5) * 2, sizeof(uint32_t));
+	uint32_t* const is_output = aliased + ((tensor_symbol_info_size + 31) >> 5);
+	// Count the readers of each tensor, and the position of each exec in the topological order.
+	int* const reads = (int*)cccalloc(tensor_symbol_info_size + simplify->exec_symbol_info_size, sizeof(int));
+	int* const exec_order = reads + tensor_symbol_info_size;
+	for (i = 0; i < tensor_symbol_info_size; i++)
+		if (tensor_symbol_info[i].alias_ref)
+		{
+			const int d = tensor_symbol_info[i].alias_ref - 1;
+			aliased[d >> 5] |= (1u << (d & 0x1f));
+		}
+	for (i = 0; i < output_size; i++)
+		if (outputs[i].d >= 0)
+		{
+			const int d = tensor_symbol_info[outputs[i].d].alias_ref ? tensor_symbol_info[outputs[i].d].alias_ref - 1 : outputs[i].d;
+			is_output[d >> 5] |= (1u << (d & 0x1f));
+		}
+	for (i = 0; i < simplify->exec_symbol_info_size; i++)
+		exec_order[i] = -1;
+	for (i = 0; i < simplify->visit->size; i++)
+		exec_order[simplify->visit->node[i].index] = i;
+	// Readers outside of the visited sub-graph count as well.
+	for (i = 0; i < simplify->graph->exec_symbol_info->rnum; i++)
+	{
+		const ccv_nnc_graph_exec_symbol_info_t* const symbol_info = (ccv_nnc_graph_exec_symbol_info_t*)ccv_array_get(simplify->graph->exec_symbol_info, i);
+		if (CCV_NNC_GRAPH_EXEC_IS_DEAD(symbol_info->flags))
+			continue;
+		for (j = 0; j < symbol_info->input_size; j++)
+			if (symbol_info->inputs[j] >= 0)
+			{
+				const int d = symbol_info->inputs[j];
+				++reads[tensor_symbol_info[d].alias_ref ? tensor_symbol_info[d].alias_ref - 1 : d];
+			}
+	}
+	int extra_inputs[CCV_NNC_MAX_EPILOGUE_SIZE * 4];
+	ccv_nnc_graph_visit_for(simplify->visit, exec_symbol_info, node, idx) {
+		if (exec_dead[idx >> 5] & (1u << (idx & 0x1f)))
+			continue;
+		if (node->cmd.cmd != CCV_NNC_CONVOLUTION_FORWARD && node->cmd.cmd != CCV_NNC_GEMM_FORWARD &&
+			node->cmd.cmd != CCV_NNC_EWSUM_FORWARD && node->cmd.cmd != CCV_NNC_EWPROD_FORWARD &&
+			node->cmd.cmd != CCV_NNC_EWEXP_FORWARD && node->cmd.cmd != CCV_NNC_SCALAR_MUL_FORWARD)
+			continue;
+		if (node->output_size != 1 || node->outputs[0] < 0 || node->graph_ref_size || node->peer_ref)
+			continue;
+		int fusable = 1;
+		for (i = 0; fusable && i < node->input_size; i++)
+			if (node->inputs[i] >= 0)
+				fusable = _ccv_nnc_epilogue_tensor_is_cpu_32f(tensor_symbol_info + node->inputs[i]);
+		if (!fusable)
+			continue;
+		ccv_nnc_cmd_param_t info = node->cmd.info;
+		int extra_input_size = 0;
+		int tail = idx;
+		int t = node->outputs[0];
+		while (info.epilogue.size < CCV_NNC_MAX_EPILOGUE_SIZE)
+		{
+			// The intermediate tensor has to be read only once, by the next op, and nobody else can observe it.
+			if (!_ccv_nnc_simplify_tensor_is_plain(tensor_symbol_info, aliased, t) || !_ccv_nnc_epilogue_tensor_is_cpu_32f(tensor_symbol_info + t) || reads[t] != 1 ||
+				(is_output[t >> 5] & (1u << (t & 0x1f))))
+				break;
+			const ccv_nnc_graph_exec_symbol_info_t* const tail_node = exec_symbol_info + tail;
+			if (!tail_node->outgoings)
+				break;
+			int next = -1;
+			for (i = 0; next < 0 && i < tail_node->outgoings->rnum; i++)
+			{
+				const int d = *(int*)ccv_array_get(tail_node->outgoings, i);
+				if (exec_dead[d >> 5] & (1u << (d & 0x1f)))
+					continue;
+				for (j = 0; j < exec_symbol_info[d].input_size; j++)
+					if (exec_symbol_info[d].inputs[j] == t)
+						next = d;
+			}
+			if (next < 0 || exec_order[next] < 0)
+				break;
+			const ccv_nnc_graph_exec_symbol_info_t* const next_node = exec_symbol_info + next;
+			if (next_node->output_size < 1 || next_node->outputs[0] < 0 || next_node->graph_ref_size || next_node->peer_ref)
+				break;
+			const int u = next_node->outputs[0];
+			if (!_ccv_nnc_simplify_tensor_is_plain(tensor_symbol_info, aliased, u) || !_ccv_nnc_epilogue_tensor_is_cpu_32f(tensor_symbol_info + u) ||
+				memcmp(tensor_symbol_info[u].info.dim, tensor_symbol_info[t].info.dim, sizeof(tensor_symbol_info[t].info.dim)) != 0)
+				break;
+			const int nd = ccv_nnc_tensor_nd(tensor_symbol_info[t].info.dim);
+			const int count = tensor_symbol_info[t].info.dim[nd - 1];
+			int type = 0, extra_size = 0;
+			float a = 0;
+			switch (next_node->cmd.cmd)
+			{
+				case CCV_NNC_RELU_FORWARD:
+					if (next_node->input_size == 1 && next_node->output_size == 1)
+						type = CCV_NNC_EPILOGUE_RELU;
+					break;
+				case CCV_NNC_SCALAR_MUL_FORWARD:
+					if (next_node->input_size == 1 && next_node->output_size == 1)
+						type = CCV_NNC_EPILOGUE_SCALAR_MUL, a = next_node->cmd.info.blas.a[0];
+					break;
+				case CCV_NNC_EWEXP_FORWARD:
+					if (next_node->input_size == 1 && next_node->output_size == 1)
+						type = CCV_NNC_EPILOGUE_EXP;
+					break;
+				case CCV_NNC_EWSUM_FORWARD:
+				case CCV_NNC_EWPROD_FORWARD:
+					if (next_node->input_size == 2 && next_node->output_size == 1 && next_node->inputs[0] >= 0 && next_node->inputs[1] >= 0 &&
+						next_node->inputs[0] != next_node->inputs[1])
+					{
+						const int e = next_node->inputs[0] == t ? next_node->inputs[1] : next_node->inputs[0];
+						if (!tensor_symbol_info[e].alias_ref && _ccv_nnc_epilogue_tensor_is_cpu_32f(tensor_symbol_info + e) &&
+							ccv_nnc_tensor_count(tensor_symbol_info[e].info) == ccv_nnc_tensor_count(tensor_symbol_info[t].info))
+						{
+							type = next_node->cmd.cmd == CCV_NNC_EWSUM_FORWARD ? CCV_NNC_EPILOGUE_EWSUM : CCV_NNC_EPILOGUE_EWPROD;
+							extra_inputs[extra_input_size] = e;
+							extra_size = 1;
+						}
+					}
+					break;
+				case CCV_NNC_BATCH_NORM_FORWARD:
+					// Only in test mode the mean / variance are fixed, thus, it is an affine transformation on the last axis.
+					if (next_node->cmd.info.bnorm.is_test && next_node->input_size == 5 && next_node->inputs[0] == t &&
+						next_node->cmd.info.bnorm.count == nd - 1)
+					{
+						int matched = 1;
+						for (i = 0; matched && i < nd - 1; i++)
+							matched = next_node->cmd.info.bnorm.axis[i] == i;
+						for (i = 1; matched && i < next_node->output_size; i++)
+							matched = next_node->outputs[i] < 0;
+						for (i = 1; matched && i < 5; i++)
+							matched = next_node->inputs[i] >= 0 && !tensor_symbol_info[next_node->inputs[i]].alias_ref &&
+								_ccv_nnc_epilogue_tensor_is_cpu_32f(tensor_symbol_info + next_node->inputs[i]) &&
+								ccv_nnc_tensor_count(tensor_symbol_info[next_node->inputs[i]].info) == count;
+						if (matched)
+						{
+							type = CCV_NNC_EPILOGUE_BATCH_NORM, a = next_node->cmd.info.bnorm.epsilon;
+							for (i = 0; i < 4; i++)
+								extra_inputs[extra_input_size + i] = next_node->inputs[i + 1];
+							extra_size = 4;
+						}
+					}
+					break;
+			}
+			if (!type)
+				break;
+			// The extra inputs now need to be ready before the head, make sure they are not computed after it.
+			for (i = 0; type && i < extra_size; i++)
+			{
+				const int d = simplify->output_execs[extra_inputs[extra_input_size + i]];
+				if (d >= 0 && (exec_order[d] < 0 || exec_order[d] >= exec_order[idx]))
+					type = 0;
+			}
+			if (!type)
+				break;
+			info.epilogue.ops[info.epilogue.size].type = type;
+			info.epilogue.ops[info.epilogue.size].a = a;
+			++info.epilogue.size;
+			extra_input_size += extra_size;
+			exec_dead[next >> 5] |= (1u << (next & 0x1f));
+			tensor_dead[t >> 5] |= (1u << (t & 0x1f));
+			tail = next;
+			t = u;
+		}
+		if (tail == idx)
+			continue;
+		// Modify the head so it carries the fused ops and writes to the output of the last one.
+		ccv_nnc_graph_exec_symbol_info_t* const actual_node = (ccv_nnc_graph_exec_symbol_info_t*)ccv_array_get(simplify->graph->exec_symbol_info, idx);
+		const int input_size = node->input_size + extra_input_size;
+		int* const inputs = (int*)ccmalloc(sizeof(int) * (input_size + 1));
+		memcpy(inputs, node->inputs, sizeof(int) * node->input_size);
+		memcpy(inputs + node->input_size, extra_inputs, sizeof(int) * extra_input_size);
+		inputs[input_size] = t;
+		if (node->inputs)
+			ccfree(node->inputs);
+		actual_node->inputs = node->inputs = inputs;
+		actual_node->outputs = node->outputs = inputs + input_size;
+		actual_node->input_size = node->input_size = input_size;
+		actual_node->cmd.info = node->cmd.info = info;
+		simplify->output_execs[t] = idx;
+		for (i = 0; i < extra_input_size; i++)
+		{
+			const int d = simplify->output_execs[extra_inputs[i]];
+			if (d >= 0)
+			{
+				ccv_nnc_graph_exec_symbol_concat(simplify->graph, (ccv_nnc_graph_exec_symbol_t){
+					.d = d,
+					.graph = simplify->graph,
+				}, (ccv_nnc_graph_exec_symbol_t){
+					.d = idx,
+					.graph = simplify->graph,
+				});
+				// The outgoings may be newly created, keep the copy in sync.
+				exec_symbol_info[d].outgoings = ((ccv_nnc_graph_exec_symbol_info_t*)ccv_array_get(simplify->graph->exec_symbol_info, d))->outgoings;
+			}
+		}
+	} ccv_nnc_graph_visit_endfor
+	ccfree(reads);
+	ccfree(aliased);
+}
+
+static void _ccv_nnc_symbolic_graph_constant_folding(ccv_nnc_symbolic_graph_simplify_t* const simplify, const ccv_nnc_tensor_symbol_t* const outputs, const int output_size)
+{
+	uint32_t* const exec_dead = simplify->exec_dead;
+	uint32_t* const tensor_dead = simplify->tensor_dead;
+	ccv_nnc_tensor_symbol_info_t* const tensor_symbol_info = simplify->tensor_symbol_info;
+	const int tensor_symbol_info_size = simplify->tensor_symbol_info_size;
+	int i, j;
+	uint32_t* const aliased = (uint32_t*)cccalloc(((tensor_symbol_info_size + 31) >> 5) * 3, sizeof(uint32_t));
+	uint32_t* const folded_inputs = aliased + ((tensor_symbol_info_size + 31) >> 5);
+	uint32_t* const rewritten = folded_inputs + ((tensor_symbol_info_size + 31) >> 5);
+	for (i = 0; i < tensor_symbol_info_size; i++)
+		if (tensor_symbol_info[i].alias_ref)
+		{
+			const int d = tensor_symbol_info[i].alias_ref - 1;
+			aliased[d >> 5] |= (1u << (d & 0x1f));
+		}
+	_ccv_nnc_symbolic_graph_simplify_update_output_execs(simplify);
+	// A tensor written by more than one command (such as in-place ones) changes after the folded command, it is not a constant.
+	ccv_nnc_graph_visit_for(simplify->visit, simplify->exec_symbol_info, node, idx) {
+		if (exec_dead[idx >> 5] & (1u << (idx & 0x1f)))
+			continue;
+		for (i = 0; i < node->output_size; i++)
+			if (node->outputs[i] >= 0 && simplify->output_execs[node->outputs[i]] != idx)
+				rewritten[node->outputs[i] >> 5] |= (1u << (node->outputs[i] & 0x1f));
+	} ccv_nnc_graph_visit_endfor
+	ccv_nnc_graph_visit_for(simplify->visit, simplify->exec_symbol_info, node, idx) {
+		if (exec_dead[idx >> 5] & (1u << (idx & 0x1f)))
+			continue;
+		// Commands with side effects, or these can not be run standalone, are not folded.
+		if (node->cmd.cmd == CCV_NNC_NOOP ||
+			node->cmd.cmd == CCV_NNC_CUSTOM_FORWARD || node->cmd.cmd == CCV_NNC_CUSTOM_BACKWARD ||
+			node->cmd.cmd == CCV_NNC_GRAPH_FORWARD || node->cmd.cmd == CCV_NNC_GRAPH_BACKWARD ||
+			node->cmd.cmd == CCV_NNC_RANDOM_UNIFORM_FORWARD || node->cmd.cmd == CCV_NNC_RANDOM_UNIFORM_BACKWARD ||
+			node->cmd.cmd == CCV_NNC_DROPOUT_FORWARD || node->cmd.cmd == CCV_NNC_DROPOUT_BACKWARD)
+			continue;
+		if (node->graph_ref_size || node->peer_ref)
+			continue;
+		int foldable = 1, input_count = 0, output_count = 0;
+		int tensor_memory = 0, tensor_formats = 0, tensor_datatypes = 0;
+		for (i = 0; foldable && i < node->input_size; i++)
+			if (node->inputs[i] >= 0)
+			{
+				const ccv_nnc_tensor_symbol_info_t* const symbol_info = tensor_symbol_info + node->inputs[i];
+				foldable = !symbol_info->alias_ref && !!symbol_info->constant;
+				if (foldable)
+				{
+					++input_count;
+					tensor_memory |= CCV_TENSOR_CPU_MEMORY, tensor_formats |= symbol_info->info.format, tensor_datatypes |= symbol_info->info.datatype;
+				}
+			}
+		for (i = 0; foldable && i < node->output_size; i++)
+			if (node->outputs[i] >= 0)
+			{
+				const int d = node->outputs[i];
+				foldable = _ccv_nnc_simplify_tensor_is_plain(tensor_symbol_info, aliased, d) && !tensor_symbol_info[d].constant &&
+					!ccv_nnc_is_tensor_auto(tensor_symbol_info[d].info) &&
+					simplify->output_execs[d] == idx && !(rewritten[d >> 5] & (1u << (d & 0x1f)));
+				if (foldable)
+				{
+					++output_count;
+					tensor_memory |= CCV_TENSOR_CPU_MEMORY, tensor_formats |= tensor_symbol_info[d].info.format, tensor_datatypes |= tensor_symbol_info[d].info.datatype;
+				}
+			}
+		if (!foldable || !input_count || !output_count)
+			continue;
+		// Fold on CPU, it is done once, thus, any backend will do as long as it supports CPU tensors.
+		ccv_nnc_cmd_t cmd = node->cmd;
+		cmd.backend = ccv_nnc_cmd_find_backend(cmd, tensor_memory, tensor_formats, tensor_datatypes);
+		cmd.algorithm = -1;
+		if (cmd.backend == CCV_NNC_NO_BACKEND)
+			continue;
+		ccv_nnc_tensor_t** const inputs = (ccv_nnc_tensor_t**)ccmalloc(sizeof(ccv_nnc_tensor_t*) * (node->input_size + node->output_size));
+		ccv_nnc_tensor_t** const output_tensors = inputs + node->input_size;
+		for (i = 0; i < node->input_size; i++)
+			inputs[i] = node->inputs[i] >= 0 ? tensor_symbol_info[node->inputs[i]].constant : 0;
+		for (i = 0; i < node->output_size; i++)
+			if (node->outputs[i] >= 0)
+			{
+				ccv_nnc_tensor_param_t cpu_info = tensor_symbol_info[node->outputs[i]].info;
+				cpu_info.type = CCV_TENSOR_CPU_MEMORY;
+				output_tensors[i] = ccv_nnc_tensor_new(0, cpu_info, 0);
+			} else
+				output_tensors[i] = 0;
+		if (ccv_nnc_cmd_exec(cmd, node->hint, 0, inputs, node->input_size, output_tensors, node->output_size, 0) != CCV_NNC_EXEC_SUCCESS)
+		{
+			for (i = 0; i < node->output_size; i++)
+				if (output_tensors[i])
+					ccv_nnc_tensor_free(output_tensors[i]);
+			ccfree(inputs);
+			continue;
+		}
+		for (i = 0; i < node->output_size; i++)
+			if (node->outputs[i] >= 0)
+			{
+				const int d = node->outputs[i];
+				ccv_nnc_tensor_t* const constant = output_tensors[i];
+				ccv_nnc_tensor_constant_sign(constant);
+				// The symbolic graph owns the constant, the simplify copy only references it.
+				ccv_nnc_tensor_symbol_info_t* const symbol_info = (ccv_nnc_tensor_symbol_info_t*)ccv_array_get(simplify->graph->tensor_symbol_info, d);
+				symbol_info->constant = constant;
+				symbol_info->info = tensor_symbol_info[d].info;
+				tensor_symbol_info[d].constant = constant;
+			}
+		ccfree(inputs);
+		for (i = 0; i < node->input_size; i++)
+			if (node->inputs[i] >= 0)
+				folded_inputs[node->inputs[i] >> 5] |= (1u << (node->inputs[i] & 0x1f));
+		exec_dead[idx >> 5] |= (1u << (idx & 0x1f));
+	} ccv_nnc_graph_visit_endfor
+	// Constants only read by the folded commands are not needed any more.
+	for (i = 0; i < simplify->graph->exec_symbol_info->rnum; i++)
+	{
+		const ccv_nnc_graph_exec_symbol_info_t* const symbol_info = (ccv_nnc_graph_exec_symbol_info_t*)ccv_array_get(simplify->graph->exec_symbol_info, i);
+		if (CCV_NNC_GRAPH_EXEC_IS_DEAD(symbol_info->flags) || (exec_dead[i >> 5] & (1u << (i & 0x1f))))
+			continue;
+		for (j = 0; j < symbol_info->input_size; j++)
+			if (symbol_info->inputs[j] >= 0)
+			{
+				const int d = symbol_info->inputs[j];
+				folded_inputs[d >> 5] &= ~(1u << (d & 0x1f));
+			}
+	}
+	for (i = 0; i < output_size; i++)
+		if (outputs[i].d >= 0)
+			folded_inputs[outputs[i].d >> 5] &= ~(1u << (outputs[i].d & 0x1f));
+	for (i = 0; i < tensor_symbol_info_size; i++)
+		if ((folded_inputs[i >> 5] & (1u << (i & 0x1f))) && !(aliased[i >> 5] & (1u << (i & 0x1f))))
+			tensor_dead[i >> 5] |= (1u << (i & 0x1f));
+	ccfree(aliased);
+}
+
 static void _ccv_nnc_symbolic_graph_pruning_undead_exec(ccv_nnc_symbolic_graph_simplify_t* const simplify, const int exec_idx, uint32_t* const tensor_visited, ccv_array_t* const next)
 {
 	assert(exec_idx >= 0);
@@ -925,6 +1277,12 @@ void ccv_nnc_symbolic_graph_simplify(ccv_nnc_symbolic_graph_t* const graph, cons
 			case CCV_NNC_SIMPLIFY_OPS_FUSION:
 				_ccv_nnc_symbolic_graph_ops_fusion(simplify, outputs, output_size);
 				break;
+			case CCV_NNC_SIMPLIFY_EPILOGUE_FUSION:
+				_ccv_nnc_symbolic_graph_epilogue_fusion(simplify, outputs, output_size);
+				break;
+			case CCV_NNC_SIMPLIFY_CONSTANT_FOLDING:
+				_ccv_nnc_symbolic_graph_constant_folding(simplify, outputs, output_size);
+				break;
 		}
 	_ccv_nnc_symbolic_graph_simplify_apply(simplify);
 	_ccv_nnc_symbolic_graph_simplify_free(simplify);
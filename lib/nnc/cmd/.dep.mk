@@ -0,0 +1,267 @@
+ccv_nnc_ew_cpu_ref.o: ew/ccv_nnc_ew_cpu_ref.c ../../ccv.h \
+ ../../nnc/ccv_nnc_tfb.h ../../ccv_internal.h ../../nnc/ccv_nnc.h \
+ ../../nnc/cmd/ccv_nnc_cmd.h ../../nnc/cmd/ccv_nnc_backend.h \
+ ../../nnc/ccv_nnc_easy.h ../../nnc/cmd/ccv_nnc_cmd_easy.h \
+ ../../nnc/ccv_nnc_internal.h ew/../_ccv_nnc_cpu_ref.h
+ccv_nnc_max_pool_cpu_ref.o: pool/ccv_nnc_max_pool_cpu_ref.c ../../ccv.h \
+ ../../nnc/ccv_nnc_tfb.h ../../ccv_internal.h ../../nnc/ccv_nnc.h \
+ ../../nnc/cmd/ccv_nnc_cmd.h ../../nnc/cmd/ccv_nnc_backend.h \
+ ../../nnc/ccv_nnc_easy.h ../../nnc/cmd/ccv_nnc_cmd_easy.h \
+ ../../nnc/ccv_nnc_internal.h
+ccv_nnc_avg_pool_cpu_ref.o: pool/ccv_nnc_avg_pool_cpu_ref.c ../../ccv.h \
+ ../../nnc/ccv_nnc_tfb.h ../../ccv_internal.h ../../nnc/ccv_nnc.h \
+ ../../nnc/cmd/ccv_nnc_cmd.h ../../nnc/cmd/ccv_nnc_backend.h \
+ ../../nnc/ccv_nnc_easy.h ../../nnc/cmd/ccv_nnc_cmd_easy.h \
+ ../../nnc/ccv_nnc_internal.h
+ccv_nnc_conv_cpu_ref.o: convolution/ccv_nnc_conv_cpu_ref.c ../../ccv.h \
+ ../../nnc/ccv_nnc_tfb.h ../../ccv_internal.h ../../nnc/ccv_nnc.h \
+ ../../nnc/cmd/ccv_nnc_cmd.h ../../nnc/cmd/ccv_nnc_backend.h \
+ ../../nnc/ccv_nnc_easy.h ../../nnc/cmd/ccv_nnc_cmd_easy.h \
+ ../../nnc/ccv_nnc_internal.h
+ccv_nnc_conv_cpu_opt.o: convolution/ccv_nnc_conv_cpu_opt.c ../../ccv.h \
+ ../../nnc/ccv_nnc_tfb.h ../../ccv_internal.h ../../nnc/ccv_nnc.h \
+ ../../nnc/cmd/ccv_nnc_cmd.h ../../nnc/cmd/ccv_nnc_backend.h \
+ ../../nnc/ccv_nnc_easy.h ../../nnc/cmd/ccv_nnc_cmd_easy.h \
+ ../../nnc/ccv_nnc_internal.h convolution/_ccv_nnc_conv_cpu_opt.h \
+ convolution/../_ccv_nnc_cpu_ref.h
+ccv_nnc_conv_cpu_avx.o: convolution/ccv_nnc_conv_cpu_avx.c ../../ccv.h \
+ ../../nnc/ccv_nnc_tfb.h ../../ccv_internal.h ../../nnc/ccv_nnc.h \
+ ../../nnc/cmd/ccv_nnc_cmd.h ../../nnc/cmd/ccv_nnc_backend.h \
+ ../../nnc/ccv_nnc_easy.h ../../nnc/cmd/ccv_nnc_cmd_easy.h \
+ ../../nnc/ccv_nnc_internal.h convolution/../_ccv_nnc_cpu_avx.h \
+ convolution/_ccv_nnc_conv_cpu_avx.h
+ccv_nnc_sgd_cpu_ref.o: sgd/ccv_nnc_sgd_cpu_ref.c ../../ccv.h \
+ ../../nnc/ccv_nnc_tfb.h ../../ccv_internal.h ../../nnc/ccv_nnc.h \
+ ../../nnc/cmd/ccv_nnc_cmd.h ../../nnc/cmd/ccv_nnc_backend.h \
+ ../../nnc/ccv_nnc_easy.h ../../nnc/cmd/ccv_nnc_cmd_easy.h \
+ ../../nnc/ccv_nnc_internal.h sgd/../_ccv_nnc_cpu_ref.h
+ccv_nnc_softmax_cpu_ref.o: softmax/ccv_nnc_softmax_cpu_ref.c ../../ccv.h \
+ ../../nnc/ccv_nnc_tfb.h ../../ccv_internal.h ../../nnc/ccv_nnc.h \
+ ../../nnc/cmd/ccv_nnc_cmd.h ../../nnc/cmd/ccv_nnc_backend.h \
+ ../../nnc/ccv_nnc_easy.h ../../nnc/cmd/ccv_nnc_cmd_easy.h \
+ ../../nnc/ccv_nnc_internal.h
+ccv_nnc_rand_uniform_cpu_ref.o: rand/ccv_nnc_rand_uniform_cpu_ref.c \
+ ../../ccv.h ../../nnc/ccv_nnc_tfb.h ../../ccv_internal.h \
+ ../../nnc/ccv_nnc.h ../../nnc/cmd/ccv_nnc_cmd.h \
+ ../../nnc/cmd/ccv_nnc_backend.h ../../nnc/ccv_nnc_easy.h \
+ ../../nnc/cmd/ccv_nnc_cmd_easy.h ../../nnc/ccv_nnc_internal.h \
+ ../../3rdparty/dsfmt/dSFMT.h
+ccv_nnc_categorical_crossentropy_cpu_ref.o: \
+ loss/ccv_nnc_categorical_crossentropy_cpu_ref.c ../../ccv.h \
+ ../../nnc/ccv_nnc_tfb.h ../../ccv_internal.h ../../nnc/ccv_nnc.h \
+ ../../nnc/cmd/ccv_nnc_cmd.h ../../nnc/cmd/ccv_nnc_backend.h \
+ ../../nnc/ccv_nnc_easy.h ../../nnc/cmd/ccv_nnc_cmd_easy.h \
+ ../../nnc/ccv_nnc_internal.h
+ccv_nnc_relu_cpu_ref.o: relu/ccv_nnc_relu_cpu_ref.c ../../ccv.h \
+ ../../nnc/ccv_nnc_tfb.h ../../ccv_internal.h ../../nnc/ccv_nnc.h \
+ ../../nnc/cmd/ccv_nnc_cmd.h ../../nnc/cmd/ccv_nnc_backend.h \
+ ../../nnc/ccv_nnc_easy.h ../../nnc/cmd/ccv_nnc_cmd_easy.h \
+ ../../nnc/ccv_nnc_internal.h
+ccv_nnc_dropout_cpu_ref.o: dropout/ccv_nnc_dropout_cpu_ref.c ../../ccv.h \
+ ../../nnc/ccv_nnc_tfb.h ../../ccv_internal.h ../../nnc/ccv_nnc.h \
+ ../../nnc/cmd/ccv_nnc_cmd.h ../../nnc/cmd/ccv_nnc_backend.h \
+ ../../nnc/ccv_nnc_easy.h ../../nnc/cmd/ccv_nnc_cmd_easy.h \
+ ../../nnc/ccv_nnc_internal.h ../../3rdparty/dsfmt/dSFMT.h \
+ dropout/../_ccv_nnc_cpu_ref.h
+ccv_nnc_softmax_crossentropy_cpu_ref.o: \
+ softmax_loss/ccv_nnc_softmax_crossentropy_cpu_ref.c ../../ccv.h \
+ ../../nnc/ccv_nnc_tfb.h ../../ccv_internal.h ../../nnc/ccv_nnc.h \
+ ../../nnc/cmd/ccv_nnc_cmd.h ../../nnc/cmd/ccv_nnc_backend.h \
+ ../../nnc/ccv_nnc_easy.h ../../nnc/cmd/ccv_nnc_cmd_easy.h \
+ ../../nnc/ccv_nnc_internal.h
+ccv_nnc_reduce_sum_cpu_ref.o: reduce/ccv_nnc_reduce_sum_cpu_ref.c \
+ ../../ccv.h ../../nnc/ccv_nnc_tfb.h ../../ccv_internal.h \
+ ../../nnc/ccv_nnc.h ../../nnc/cmd/ccv_nnc_cmd.h \
+ ../../nnc/cmd/ccv_nnc_backend.h ../../nnc/ccv_nnc_easy.h \
+ ../../nnc/cmd/ccv_nnc_cmd_easy.h ../../nnc/ccv_nnc_internal.h \
+ reduce/../_ccv_nnc_cpu_ref.h
+ccv_nnc_reduce_max_cpu_ref.o: reduce/ccv_nnc_reduce_max_cpu_ref.c \
+ ../../ccv.h ../../nnc/ccv_nnc_tfb.h ../../ccv_internal.h \
+ ../../nnc/ccv_nnc.h ../../nnc/cmd/ccv_nnc_cmd.h \
+ ../../nnc/cmd/ccv_nnc_backend.h ../../nnc/ccv_nnc_easy.h \
+ ../../nnc/cmd/ccv_nnc_cmd_easy.h ../../nnc/ccv_nnc_internal.h \
+ reduce/../_ccv_nnc_cpu_ref.h
+ccv_nnc_batch_norm_cpu_ref.o: norm/ccv_nnc_batch_norm_cpu_ref.c \
+ ../../ccv.h ../../nnc/ccv_nnc_tfb.h ../../ccv_internal.h \
+ ../../nnc/ccv_nnc.h ../../nnc/cmd/ccv_nnc_cmd.h \
+ ../../nnc/cmd/ccv_nnc_backend.h ../../nnc/ccv_nnc_easy.h \
+ ../../nnc/cmd/ccv_nnc_cmd_easy.h ../../nnc/ccv_nnc_internal.h \
+ norm/../_ccv_nnc_cpu_ref.h
+ccv_nnc_gemm_cpu_ref.o: blas/ccv_nnc_gemm_cpu_ref.c ../../ccv.h \
+ ../../nnc/ccv_nnc_tfb.h ../../ccv_internal.h ../../nnc/ccv_nnc.h \
+ ../../nnc/cmd/ccv_nnc_cmd.h ../../nnc/cmd/ccv_nnc_backend.h \
+ ../../nnc/ccv_nnc_easy.h ../../nnc/cmd/ccv_nnc_cmd_easy.h \
+ ../../nnc/ccv_nnc_internal.h
+ccv_nnc_gemm_cpu_opt.o: blas/ccv_nnc_gemm_cpu_opt.c ../../ccv.h \
+ ../../nnc/ccv_nnc_tfb.h ../../ccv_internal.h ../../nnc/ccv_nnc.h \
+ ../../nnc/cmd/ccv_nnc_cmd.h ../../nnc/cmd/ccv_nnc_backend.h \
+ ../../nnc/ccv_nnc_easy.h ../../nnc/cmd/ccv_nnc_cmd_easy.h \
+ ../../nnc/ccv_nnc_internal.h blas/_ccv_nnc_gemm_cpu_opt.h \
+ blas/../_ccv_nnc_cpu_ref.h
+ccv_nnc_gemm_cpu_avx.o: blas/ccv_nnc_gemm_cpu_avx.c ../../ccv.h \
+ ../../nnc/ccv_nnc_tfb.h ../../ccv_internal.h ../../nnc/ccv_nnc.h \
+ ../../nnc/cmd/ccv_nnc_cmd.h ../../nnc/cmd/ccv_nnc_backend.h \
+ ../../nnc/ccv_nnc_easy.h ../../nnc/cmd/ccv_nnc_cmd_easy.h \
+ ../../nnc/ccv_nnc_internal.h blas/../_ccv_nnc_cpu_avx.h \
+ blas/_ccv_nnc_gemm_cpu_avx.h
+ccv_nnc_add_cpu_ref.o: blas/ccv_nnc_add_cpu_ref.c ../../ccv.h \
+ ../../nnc/ccv_nnc_tfb.h ../../ccv_internal.h ../../nnc/ccv_nnc.h \
+ ../../nnc/cmd/ccv_nnc_cmd.h ../../nnc/cmd/ccv_nnc_backend.h \
+ ../../nnc/ccv_nnc_easy.h ../../nnc/cmd/ccv_nnc_cmd_easy.h \
+ ../../nnc/ccv_nnc_internal.h blas/../_ccv_nnc_cpu_ref.h
+ccv_nnc_mul_cpu_ref.o: blas/ccv_nnc_mul_cpu_ref.c ../../ccv.h \
+ ../../nnc/ccv_nnc_tfb.h ../../ccv_internal.h ../../nnc/ccv_nnc.h \
+ ../../nnc/cmd/ccv_nnc_cmd.h ../../nnc/cmd/ccv_nnc_backend.h \
+ ../../nnc/ccv_nnc_easy.h ../../nnc/cmd/ccv_nnc_cmd_easy.h \
+ ../../nnc/ccv_nnc_internal.h blas/../_ccv_nnc_cpu_ref.h
+ccv_nnc_util_cpu_ref.o: util/ccv_nnc_util_cpu_ref.c ../../ccv.h \
+ ../../nnc/ccv_nnc_tfb.h ../../ccv_internal.h ../../nnc/ccv_nnc.h \
+ ../../nnc/cmd/ccv_nnc_cmd.h ../../nnc/cmd/ccv_nnc_backend.h \
+ ../../nnc/ccv_nnc_easy.h ../../nnc/cmd/ccv_nnc_cmd_easy.h \
+ ../../nnc/ccv_nnc_internal.h util/../_ccv_nnc_cpu_ref.h
+ccv_nnc_ew.o: ew/ccv_nnc_ew.c ../../ccv.h ../../nnc/ccv_nnc_tfb.h \
+ ../../nnc/ccv_nnc.h ../../nnc/cmd/ccv_nnc_cmd.h \
+ ../../nnc/cmd/ccv_nnc_backend.h ../../nnc/ccv_nnc_internal.h \
+ ../../ccv_internal.h
+ccv_nnc_pool.o: pool/ccv_nnc_pool.c ../../ccv.h ../../nnc/ccv_nnc_tfb.h \
+ ../../nnc/ccv_nnc.h ../../nnc/cmd/ccv_nnc_cmd.h \
+ ../../nnc/cmd/ccv_nnc_backend.h ../../nnc/ccv_nnc_easy.h \
+ ../../nnc/cmd/ccv_nnc_cmd_easy.h ../../nnc/ccv_nnc_internal.h \
+ ../../ccv_internal.h
+ccv_nnc_convolution.o: convolution/ccv_nnc_convolution.c ../../ccv.h \
+ ../../nnc/ccv_nnc_tfb.h ../../nnc/ccv_nnc.h ../../nnc/cmd/ccv_nnc_cmd.h \
+ ../../nnc/cmd/ccv_nnc_backend.h ../../nnc/ccv_nnc_easy.h \
+ ../../nnc/cmd/ccv_nnc_cmd_easy.h ../../nnc/ccv_nnc_internal.h \
+ ../../ccv_internal.h
+_ccv_nnc_conv_cpu_4x4_3x3_winograd.o: \
+ convolution/cpu_opt/_ccv_nnc_conv_cpu_4x4_3x3_winograd.c ../../ccv.h \
+ ../../nnc/ccv_nnc_tfb.h ../../ccv_internal.h ../../nnc/ccv_nnc.h \
+ ../../nnc/cmd/ccv_nnc_cmd.h ../../nnc/cmd/ccv_nnc_backend.h \
+ ../../nnc/ccv_nnc_easy.h ../../nnc/cmd/ccv_nnc_cmd_easy.h \
+ ../../nnc/ccv_nnc_internal.h \
+ convolution/cpu_opt/../_ccv_nnc_conv_cpu_opt.h \
+ convolution/cpu_opt/../../_ccv_nnc_cpu_ref.h
+_ccv_nnc_conv_cpu_6x6_3x3_winograd.o: \
+ convolution/cpu_opt/_ccv_nnc_conv_cpu_6x6_3x3_winograd.c ../../ccv.h \
+ ../../nnc/ccv_nnc_tfb.h ../../ccv_internal.h ../../nnc/ccv_nnc.h \
+ ../../nnc/cmd/ccv_nnc_cmd.h ../../nnc/cmd/ccv_nnc_backend.h \
+ ../../nnc/ccv_nnc_easy.h ../../nnc/cmd/ccv_nnc_cmd_easy.h \
+ ../../nnc/ccv_nnc_internal.h \
+ convolution/cpu_opt/../_ccv_nnc_conv_cpu_opt.h \
+ convolution/cpu_opt/../../_ccv_nnc_cpu_ref.h
+_ccv_nnc_conv_cpu_1x1.o: convolution/cpu_opt/_ccv_nnc_conv_cpu_1x1.c \
+ ../../ccv.h ../../nnc/ccv_nnc_tfb.h ../../ccv_internal.h \
+ ../../nnc/ccv_nnc.h ../../nnc/cmd/ccv_nnc_cmd.h \
+ ../../nnc/cmd/ccv_nnc_backend.h ../../nnc/ccv_nnc_easy.h \
+ ../../nnc/cmd/ccv_nnc_cmd_easy.h ../../nnc/ccv_nnc_internal.h \
+ convolution/cpu_opt/../_ccv_nnc_conv_cpu_opt.h \
+ convolution/cpu_opt/../../_ccv_nnc_cpu_ref.h
+_ccv_nnc_conv_cpu_3x3_s2.o: \
+ convolution/cpu_opt/_ccv_nnc_conv_cpu_3x3_s2.c ../../ccv.h \
+ ../../nnc/ccv_nnc_tfb.h ../../ccv_internal.h ../../nnc/ccv_nnc.h \
+ ../../nnc/cmd/ccv_nnc_cmd.h ../../nnc/cmd/ccv_nnc_backend.h \
+ ../../nnc/ccv_nnc_easy.h ../../nnc/cmd/ccv_nnc_cmd_easy.h \
+ ../../nnc/ccv_nnc_internal.h \
+ convolution/cpu_opt/../_ccv_nnc_conv_cpu_opt.h \
+ convolution/cpu_opt/../../_ccv_nnc_cpu_ref.h
+_ccv_nnc_conv_cpu_fft.o: convolution/cpu_opt/_ccv_nnc_conv_cpu_fft.c \
+ ../../ccv.h ../../nnc/ccv_nnc_tfb.h ../../ccv_internal.h \
+ ../../nnc/ccv_nnc.h ../../nnc/cmd/ccv_nnc_cmd.h \
+ ../../nnc/cmd/ccv_nnc_backend.h ../../nnc/ccv_nnc_easy.h \
+ ../../nnc/cmd/ccv_nnc_cmd_easy.h ../../nnc/ccv_nnc_internal.h \
+ convolution/cpu_opt/../_ccv_nnc_conv_cpu_opt.h \
+ convolution/cpu_opt/../../_ccv_nnc_cpu_ref.h
+_ccv_nnc_conv_cpu_gemm.o: convolution/cpu_opt/_ccv_nnc_conv_cpu_gemm.c \
+ ../../ccv.h ../../nnc/ccv_nnc_tfb.h ../../ccv_internal.h \
+ ../../nnc/ccv_nnc.h ../../nnc/cmd/ccv_nnc_cmd.h \
+ ../../nnc/cmd/ccv_nnc_backend.h ../../nnc/ccv_nnc_easy.h \
+ ../../nnc/cmd/ccv_nnc_cmd_easy.h ../../nnc/ccv_nnc_internal.h \
+ convolution/cpu_opt/../_ccv_nnc_conv_cpu_opt.h \
+ convolution/cpu_opt/../../_ccv_nnc_cpu_ref.h \
+ convolution/cpu_opt/../../blas/_ccv_nnc_gemm_cpu_opt.h \
+ convolution/cpu_opt/../../blas/../_ccv_nnc_cpu_ref.h
+_ccv_nnc_conv_cpu_opt.o: convolution/cpu_opt/_ccv_nnc_conv_cpu_opt.c \
+ ../../ccv.h ../../nnc/ccv_nnc_tfb.h ../../ccv_internal.h \
+ ../../nnc/ccv_nnc.h ../../nnc/cmd/ccv_nnc_cmd.h \
+ ../../nnc/cmd/ccv_nnc_backend.h ../../nnc/ccv_nnc_easy.h \
+ ../../nnc/cmd/ccv_nnc_cmd_easy.h ../../nnc/ccv_nnc_internal.h \
+ convolution/cpu_opt/../_ccv_nnc_conv_cpu_opt.h \
+ convolution/cpu_opt/../../_ccv_nnc_cpu_ref.h
+_ccv_nnc_conv_cpu_avx.o: convolution/cpu_avx/_ccv_nnc_conv_cpu_avx.c \
+ ../../ccv.h ../../nnc/ccv_nnc_tfb.h ../../ccv_internal.h \
+ ../../nnc/ccv_nnc.h ../../nnc/cmd/ccv_nnc_cmd.h \
+ ../../nnc/cmd/ccv_nnc_backend.h ../../nnc/ccv_nnc_easy.h \
+ ../../nnc/cmd/ccv_nnc_cmd_easy.h ../../nnc/ccv_nnc_internal.h \
+ convolution/cpu_avx/../../_ccv_nnc_cpu_avx.h \
+ convolution/cpu_avx/../_ccv_nnc_conv_cpu_avx.h
+ccv_nnc_sgd.o: sgd/ccv_nnc_sgd.c ../../ccv.h ../../nnc/ccv_nnc_tfb.h \
+ ../../nnc/ccv_nnc.h ../../nnc/cmd/ccv_nnc_cmd.h \
+ ../../nnc/cmd/ccv_nnc_backend.h ../../nnc/ccv_nnc_internal.h \
+ ../../ccv_internal.h
+ccv_nnc_softmax.o: softmax/ccv_nnc_softmax.c ../../ccv.h \
+ ../../nnc/ccv_nnc_tfb.h ../../nnc/ccv_nnc.h ../../nnc/cmd/ccv_nnc_cmd.h \
+ ../../nnc/cmd/ccv_nnc_backend.h ../../nnc/ccv_nnc_internal.h \
+ ../../ccv_internal.h
+ccv_nnc_rand.o: rand/ccv_nnc_rand.c ../../ccv.h ../../nnc/ccv_nnc_tfb.h \
+ ../../nnc/ccv_nnc.h ../../nnc/cmd/ccv_nnc_cmd.h \
+ ../../nnc/cmd/ccv_nnc_backend.h ../../nnc/ccv_nnc_internal.h \
+ ../../ccv_internal.h
+ccv_nnc_categorical_crossentropy.o: \
+ loss/ccv_nnc_categorical_crossentropy.c ../../ccv.h \
+ ../../nnc/ccv_nnc_tfb.h ../../nnc/ccv_nnc.h ../../nnc/cmd/ccv_nnc_cmd.h \
+ ../../nnc/cmd/ccv_nnc_backend.h ../../nnc/ccv_nnc_internal.h \
+ ../../ccv_internal.h
+ccv_nnc_relu.o: relu/ccv_nnc_relu.c ../../ccv.h ../../nnc/ccv_nnc_tfb.h \
+ ../../nnc/ccv_nnc.h ../../nnc/cmd/ccv_nnc_cmd.h \
+ ../../nnc/cmd/ccv_nnc_backend.h ../../nnc/ccv_nnc_internal.h \
+ ../../ccv_internal.h
+ccv_nnc_dropout.o: dropout/ccv_nnc_dropout.c ../../ccv.h \
+ ../../nnc/ccv_nnc_tfb.h ../../nnc/ccv_nnc.h ../../nnc/cmd/ccv_nnc_cmd.h \
+ ../../nnc/cmd/ccv_nnc_backend.h ../../nnc/ccv_nnc_internal.h \
+ ../../ccv_internal.h
+ccv_nnc_softmax_crossentropy.o: \
+ softmax_loss/ccv_nnc_softmax_crossentropy.c ../../ccv.h \
+ ../../nnc/ccv_nnc_tfb.h ../../nnc/ccv_nnc.h ../../nnc/cmd/ccv_nnc_cmd.h \
+ ../../nnc/cmd/ccv_nnc_backend.h ../../nnc/ccv_nnc_internal.h \
+ ../../ccv_internal.h
+ccv_nnc_reduce.o: reduce/ccv_nnc_reduce.c ../../ccv.h \
+ ../../nnc/ccv_nnc_tfb.h ../../nnc/ccv_nnc.h ../../nnc/cmd/ccv_nnc_cmd.h \
+ ../../nnc/cmd/ccv_nnc_backend.h ../../nnc/ccv_nnc_internal.h \
+ ../../ccv_internal.h
+ccv_nnc_batch_norm.o: norm/ccv_nnc_batch_norm.c ../../ccv.h \
+ ../../nnc/ccv_nnc_tfb.h ../../nnc/ccv_nnc.h ../../nnc/cmd/ccv_nnc_cmd.h \
+ ../../nnc/cmd/ccv_nnc_backend.h ../../nnc/ccv_nnc_internal.h \
+ ../../ccv_internal.h
+ccv_nnc_blas.o: blas/ccv_nnc_blas.c ../../ccv.h ../../nnc/ccv_nnc_tfb.h \
+ ../../nnc/ccv_nnc.h ../../nnc/cmd/ccv_nnc_cmd.h \
+ ../../nnc/cmd/ccv_nnc_backend.h ../../nnc/ccv_nnc_internal.h \
+ ../../ccv_internal.h
+_ccv_nnc_gemm_cpu_opt.o: blas/cpu_opt/_ccv_nnc_gemm_cpu_opt.c ../../ccv.h \
+ ../../nnc/ccv_nnc_tfb.h ../../ccv_internal.h ../../nnc/ccv_nnc.h \
+ ../../nnc/cmd/ccv_nnc_cmd.h ../../nnc/cmd/ccv_nnc_backend.h \
+ ../../nnc/ccv_nnc_easy.h ../../nnc/cmd/ccv_nnc_cmd_easy.h \
+ ../../nnc/ccv_nnc_internal.h blas/cpu_opt/../_ccv_nnc_gemm_cpu_opt.h \
+ blas/cpu_opt/../../_ccv_nnc_cpu_ref.h
+_ccv_nnc_gemm_cpu_packed.o: blas/cpu_opt/_ccv_nnc_gemm_cpu_packed.c \
+ ../../ccv.h ../../nnc/ccv_nnc_tfb.h ../../ccv_internal.h \
+ ../../nnc/ccv_nnc.h ../../nnc/cmd/ccv_nnc_cmd.h \
+ ../../nnc/cmd/ccv_nnc_backend.h ../../nnc/ccv_nnc_easy.h \
+ ../../nnc/cmd/ccv_nnc_cmd_easy.h ../../nnc/ccv_nnc_internal.h \
+ blas/cpu_opt/../_ccv_nnc_gemm_cpu_opt.h \
+ blas/cpu_opt/../../_ccv_nnc_cpu_ref.h
+_ccv_nnc_gemm_cpu_sys.o: blas/cpu_sys/_ccv_nnc_gemm_cpu_sys.c ../../ccv.h \
+ ../../nnc/ccv_nnc_tfb.h ../../ccv_internal.h ../../nnc/ccv_nnc.h \
+ ../../nnc/cmd/ccv_nnc_cmd.h ../../nnc/cmd/ccv_nnc_backend.h \
+ ../../nnc/ccv_nnc_easy.h ../../nnc/cmd/ccv_nnc_cmd_easy.h \
+ ../../nnc/ccv_nnc_internal.h blas/cpu_sys/../_ccv_nnc_gemm_cpu_opt.h \
+ blas/cpu_sys/../../_ccv_nnc_cpu_ref.h
+_ccv_nnc_gemm_cpu_avx.o: blas/cpu_avx/_ccv_nnc_gemm_cpu_avx.c ../../ccv.h \
+ ../../nnc/ccv_nnc_tfb.h ../../ccv_internal.h ../../nnc/ccv_nnc.h \
+ ../../nnc/cmd/ccv_nnc_cmd.h ../../nnc/cmd/ccv_nnc_backend.h \
+ ../../nnc/ccv_nnc_easy.h ../../nnc/cmd/ccv_nnc_cmd_easy.h \
+ ../../nnc/ccv_nnc_internal.h blas/cpu_avx/../../_ccv_nnc_cpu_avx.h \
+ blas/cpu_avx/../_ccv_nnc_gemm_cpu_avx.h
+ccv_nnc_util.o: util/ccv_nnc_util.c ../../ccv.h ../../nnc/ccv_nnc_tfb.h \
+ ../../nnc/ccv_nnc.h ../../nnc/cmd/ccv_nnc_cmd.h \
+ ../../nnc/cmd/ccv_nnc_backend.h ../../nnc/ccv_nnc_internal.h \
+ ../../ccv_internal.h
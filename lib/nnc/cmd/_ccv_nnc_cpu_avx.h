@@ -0,0 +1,43 @@
+#ifndef GUARD_ccv_nnc_cpu_avx_h
+#define GUARD_ccv_nnc_cpu_avx_h
+
+#include <ccv.h>
+#include <nnc/ccv_nnc.h>
+#include <nnc/ccv_nnc_internal.h>
+
+// The AVX kernels are compiled with per-function target attributes, so the rest of the library can still be built
+// for the baseline SSE2 machine. Which path to take is decided at runtime with CPUID.
+#if defined(HAVE_SSE2) && (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define CCV_NNC_CPU_AVX_ENABLED
+#define CCV_NNC_CPU_AVX2_TARGET __attribute__((target("avx2,fma")))
+#define CCV_NNC_CPU_AVX512_TARGET __attribute__((target("avx2,fma,avx512f")))
+#endif
+
+enum {
+	CCV_NNC_CPU_AVX2 = 0x1, // AVX2 with fused multiply-add.
+	CCV_NNC_CPU_AVX512 = 0x2, // AVX-512 foundation.
+};
+
+static inline int _ccv_nnc_cpu_avx_isa(void)
+{
+#ifdef CCV_NNC_CPU_AVX_ENABLED
+	static int isa = -1;
+	if (isa < 0)
+	{
+		int flags = 0;
+		__builtin_cpu_init();
+		if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+		{
+			flags |= CCV_NNC_CPU_AVX2;
+			if (__builtin_cpu_supports("avx512f"))
+				flags |= CCV_NNC_CPU_AVX512;
+		}
+		isa = flags;
+	}
+	return isa;
+#else
+	return 0;
+#endif
+}
+
+#endif
@@ -13,4 +13,26 @@ void _ccv_nnc_add_forw_cpu_ref(const float p, const float q, ccv_nnc_tensor_view
 void _ccv_nnc_mul_forw_cpu_ref(const float p, ccv_nnc_tensor_view_t* const a, ccv_nnc_tensor_view_t* const b, ccv_nnc_tensor_view_t* const c);
 void _ccv_nnc_reduce_sum_forw_cpu_ref(ccv_nnc_tensor_view_t* const a, ccv_nnc_tensor_view_t* const b);
 
+// The epilogue (element-wise ops fused at the end of a command) ready to be applied on blocks of the output.
+typedef struct {
+	int size;
+	int count; // The size of the last dimension of the output, extra inputs are contiguous with rows of this size.
+	struct {
+		int type;
+		float a;
+		const float* x; // The extra input for EWSUM / EWPROD, or the folded scale for BATCH_NORM.
+		const float* y; // The folded shift for BATCH_NORM.
+	} ops[CCV_NNC_MAX_EPILOGUE_SIZE];
+	float* folded;
+} ccv_nnc_cpu_epilogue_t;
+
+int _ccv_nnc_cpu_epilogue_new(const ccv_nnc_cmd_param_t cmd, ccv_nnc_tensor_t* const* const inputs, const int input_size, const ccv_nnc_tensor_view_t* const b, ccv_nnc_cpu_epilogue_t* const epilogue);
+// Apply the epilogue on the block of rows [row, row + rows) and columns [col, col + cols), b points to (row, col).
+void _ccv_nnc_cpu_epilogue_apply(const ccv_nnc_cpu_epilogue_t* const epilogue, float* const b, const int ldb, const int row, const int rows, const int col, const int cols);
+void _ccv_nnc_cpu_epilogue_free(ccv_nnc_cpu_epilogue_t* const epilogue);
+// Apply the epilogue on the whole output as a separate pass. The output cannot be a tensor view.
+int _ccv_nnc_cpu_epilogue_apply_all(const ccv_nnc_cpu_epilogue_t* const epilogue, ccv_nnc_tensor_view_t* const b);
+// Run an element-wise command (without the epilogue) block by block, and apply the epilogue on each block while it is still in cache.
+int _ccv_nnc_ew_forw_epilogue_cpu_ref(const ccv_nnc_cmd_t cmd, const ccv_nnc_hint_t hint, const int flags, ccv_nnc_tensor_t* const* const inputs, const int input_size, ccv_nnc_tensor_t* const* const outputs, const int output_size, ccv_nnc_stream_context_t* const stream_context, const ccv_nnc_cmd_exec_f exec);
+
 #endif
@@ -13,9 +13,27 @@
 #include <ccv.h>
 #include <nnc/ccv_nnc.h>
 
+#include "../_ccv_nnc_cpu_ref.h"
+
 int _ccv_nnc_gemm_forw_cpu_sys(const ccv_nnc_tensor_view_t* const a, const ccv_nnc_tensor_view_t* const w, const ccv_nnc_tensor_view_t* const bias, ccv_nnc_tensor_view_t* const b);
 int _ccv_nnc_gemm_back_cpu_sys(const ccv_nnc_tensor_view_t* const g, const ccv_nnc_tensor_view_t* const a, const ccv_nnc_tensor_view_t* const w, ccv_nnc_tensor_view_t* const dw, ccv_nnc_tensor_view_t* const bias, ccv_nnc_tensor_view_t* const h, const int flags);
 int _ccv_nnc_gemm_forw_cpu_opt(const ccv_nnc_tensor_view_t* const a, const ccv_nnc_tensor_view_t* const w, const ccv_nnc_tensor_view_t* const bias, ccv_nnc_tensor_view_t* const b);
 int _ccv_nnc_gemm_back_cpu_opt(const ccv_nnc_tensor_view_t* const g, const ccv_nnc_tensor_view_t* const a, const ccv_nnc_tensor_view_t* const w, ccv_nnc_tensor_view_t* const dw, ccv_nnc_tensor_view_t* const bias, ccv_nnc_tensor_view_t* const h, const int flags);
+int _ccv_nnc_gemm_forw_packed_cpu_opt(const ccv_nnc_tensor_view_t* const a, const ccv_nnc_tensor_view_t* const w, const ccv_nnc_tensor_view_t* const bias, ccv_nnc_tensor_view_t* const b, const ccv_nnc_cpu_epilogue_t* const epilogue);
+int _ccv_nnc_gemm_back_packed_cpu_opt(const ccv_nnc_tensor_view_t* const g, const ccv_nnc_tensor_view_t* const a, const ccv_nnc_tensor_view_t* const w, ccv_nnc_tensor_view_t* const dw, ccv_nnc_tensor_view_t* const bias, ccv_nnc_tensor_view_t* const h, const int flags);
+/**
+ * The packed GEMM used by the GEMM and the convolution commands: c = a . b, or c += a . b if accumulate is set.
+ * Element (i, j) of a is a[i * a_rs + j * a_cs], element (i, j) of b is b[i * b_rs + j * b_cs], thus, transposes
+ * are just different strides. If b_sig is the signature of a constant, the packed b is kept by its tensor arena. If
+ * epilogue is not 0, it is applied on each block of c once done (row i of c is row epilogue_row + i of the epilogue).
+ */
+int _ccv_nnc_gemm_cpu_packed(const int m, const int n, const int k, const float* const a, const int a_rs, const int a_cs, const float* const b, const int b_rs, const int b_cs, const uint64_t b_sig, float* const c, const int ldc, const int accumulate, const ccv_nnc_cpu_epilogue_t* const epilogue, const int epilogue_row);
+/**
+ * Pack b (k x n) once to run _ccv_nnc_gemm_packed_cpu_opt several times with it. If b_sig is the signature of a
+ * constant, the packed b is kept by its tensor arena (owned is 0). Otherwise, it is packed into new memory the
+ * caller frees with ccfree (owned is 1). Returns 0 if out of memory.
+ */
+float* _ccv_nnc_gemm_pack_b_cpu_opt(const int k, const int n, const float* const b, const int b_rs, const int b_cs, const uint64_t b_sig, int* const owned);
+int _ccv_nnc_gemm_packed_cpu_opt(const int m, const int n, const int k, const float* const a, const int a_rs, const int a_cs, const float* const pb, float* const c, const int ldc, const int accumulate, const ccv_nnc_cpu_epilogue_t* const epilogue, const int epilogue_row);
 
 #endif
@@ -0,0 +1,83 @@
+#include <ccv.h>
+#include <ccv_internal.h>
+#include <nnc/ccv_nnc.h>
+#include <nnc/ccv_nnc_easy.h>
+#include <nnc/ccv_nnc_internal.h>
+
+#include "../_ccv_nnc_cpu_avx.h"
+#include "_ccv_nnc_gemm_cpu_avx.h"
+
+FIND_FILE(cpu_avx/_ccv_nnc_gemm_cpu_avx.c)
+
+enum {
+	CCV_NNC_CMD_AVX_GEMM_ALGO_DIRECT, // Direct multiplication
+	CCV_NNC_CMD_AVX_GEMM_ALGO_COUNT
+};
+
+static int _ccv_nnc_gemm_forw(const ccv_nnc_cmd_t cmd, const ccv_nnc_hint_t hint, const int flags, ccv_nnc_tensor_t* const* const inputs, const int input_size, ccv_nnc_tensor_t* const* const outputs, const int output_size, ccv_nnc_stream_context_t* const stream_context)
+{
+	assert(input_size >= 2);
+	const ccv_nnc_tensor_view_t* w = (const ccv_nnc_tensor_view_t*)inputs[1];
+	const ccv_nnc_tensor_view_t* bias = input_size > 2 ? (const ccv_nnc_tensor_view_t*)inputs[2] : 0;
+	// Copy the most of parameters, but reshape the dimension of a to a vector.
+	const ccv_nnc_tensor_view_t* a = (const ccv_nnc_tensor_view_t*)inputs[0];
+	assert(a->info.dim[2] == 0); // It is a 2-d array.
+	assert(output_size == 1);
+	ccv_nnc_tensor_view_t* b = (ccv_nnc_tensor_view_t*)outputs[0];
+	assert(b->info.dim[2] == 0); // It is a 2-d array.
+	assert(w->info.dim[2] == 0); // It is a 2-d array
+	assert(!bias || bias->info.dim[1] == 0); // It is a 1-d array
+	const int a_nd = ccv_nnc_tensor_nd(a->info.dim);
+	assert(a_nd == 1 || a_nd == 2);
+	const int b_nd = ccv_nnc_tensor_nd(b->info.dim);
+	assert(b_nd == 1 || b_nd == 2);
+	return _ccv_nnc_gemm_forw_cpu_avx(a, w, bias, b);
+}
+
+static int _ccv_nnc_gemm_back(const ccv_nnc_cmd_t cmd, const ccv_nnc_hint_t hint, const int flags, ccv_nnc_tensor_t* const* const inputs, const int input_size, ccv_nnc_tensor_t* const* const outputs, const int output_size, ccv_nnc_stream_context_t* const stream_context)
+{
+	// inputs: gradient, forw prop input, [w]
+	// outputs: [output gradient], weight updates, bias updates
+	assert((input_size == 2 && output_size >= 2) || (input_size == 3 && output_size >= 2));
+	const ccv_nnc_tensor_view_t* g = (const ccv_nnc_tensor_view_t*)inputs[0];
+	assert(g->info.dim[2] == 0); // It is a 2-d array.
+	const ccv_nnc_tensor_view_t* a = (const ccv_nnc_tensor_view_t*)inputs[1];
+	assert(a->info.dim[2] == 0); // It is a 2-d array.
+	ccv_nnc_tensor_view_t* dw = (ccv_nnc_tensor_view_t*)outputs[1];
+	assert(dw->info.dim[2] == 0); // It is a 2-d array.
+	ccv_nnc_tensor_view_t* bias = output_size > 2 ? (ccv_nnc_tensor_view_t*)outputs[2] : 0;
+	assert(!bias || bias->info.dim[1] == 0); // It is a 1-d array.
+	const ccv_nnc_tensor_view_t* w = (input_size > 2) ? (const ccv_nnc_tensor_view_t*)inputs[2] : 0;
+	ccv_nnc_tensor_view_t* h = (ccv_nnc_tensor_view_t*)outputs[0];
+	assert(!h || h->info.dim[2] == 0); // It is a 2-d array.
+	if (w)
+	{
+		assert(w->info.dim[2] == 0); // It is a 2-d array.
+		assert(w->info.dim[0] == dw->info.dim[0]);
+		assert(w->info.dim[1] == dw->info.dim[1]);
+	}
+	return _ccv_nnc_gemm_back_cpu_avx(g, a, w, dw, bias, h, flags);
+}
+
+REGISTER_COMMAND_BACKEND(CCV_NNC_GEMM_FORWARD, CCV_NNC_BACKEND_CPU_AVX)(ccv_nnc_cmd_backend_registry_t* const registry)
+{
+	// Don't register the exec function if this CPU doesn't support AVX2 / FMA, thus, this backend won't be picked.
+	if (!(_ccv_nnc_cpu_avx_isa() & CCV_NNC_CPU_AVX2))
+		return;
+	registry->tensor_formats = CCV_TENSOR_FORMAT_NHWC;
+	registry->tensor_datatypes = CCV_32F;
+	registry->tensor_memory = CCV_TENSOR_CPU_MEMORY;
+	registry->algorithms = CCV_NNC_CMD_AVX_GEMM_ALGO_COUNT;
+	registry->exec = _ccv_nnc_gemm_forw;
+}
+
+REGISTER_COMMAND_BACKEND(CCV_NNC_GEMM_BACKWARD, CCV_NNC_BACKEND_CPU_AVX)(ccv_nnc_cmd_backend_registry_t* const registry)
+{
+	if (!(_ccv_nnc_cpu_avx_isa() & CCV_NNC_CPU_AVX2))
+		return;
+	registry->tensor_formats = CCV_TENSOR_FORMAT_NHWC;
+	registry->tensor_datatypes = CCV_32F;
+	registry->tensor_memory = CCV_TENSOR_CPU_MEMORY;
+	registry->algorithms = CCV_NNC_CMD_AVX_GEMM_ALGO_COUNT;
+	registry->exec = _ccv_nnc_gemm_back;
+}
@@ -6,19 +6,59 @@
 
 #include "_ccv_nnc_gemm_cpu_opt.h"
 
-FIND_FILE(cpu_opt/_ccv_nnc_gemm_cpu_opt.c, cpu_sys/_ccv_nnc_gemm_cpu_sys.c)
+FIND_FILE(cpu_opt/_ccv_nnc_gemm_cpu_opt.c, cpu_opt/_ccv_nnc_gemm_cpu_packed.c, cpu_sys/_ccv_nnc_gemm_cpu_sys.c)
 
 enum {
 	CCV_NNC_CMD_OPT_GEMM_ALGO_DIRECT, // Direct multiplication
 	CCV_NNC_CMD_OPT_GEMM_ALGO_SYSTEM, // Use system GEMM
+	CCV_NNC_CMD_OPT_GEMM_ALGO_PACKED, // Packed and cache blocked GEMM
 	CCV_NNC_CMD_OPT_GEMM_ALGO_COUNT
 };
 
+// The kernels other than the packed one don't take the epilogue, apply it as a separate pass.
+static int _ccv_nnc_gemm_forw_epilogue(const int status, const ccv_nnc_cpu_epilogue_t* const epilogue, ccv_nnc_tensor_view_t* const b)
+{
+	if (status == CCV_NNC_EXEC_SUCCESS && epilogue)
+		return _ccv_nnc_cpu_epilogue_apply_all(epilogue, b);
+	return status;
+}
+
+static int _ccv_nnc_gemm_forw_opt(const int algorithm, const ccv_nnc_tensor_view_t* const a, const ccv_nnc_tensor_view_t* const w, const ccv_nnc_tensor_view_t* const bias, ccv_nnc_tensor_view_t* const b, const int batch_size, const ccv_nnc_cpu_epilogue_t* const epilogue)
+{
+	switch (algorithm)
+	{
+		case CCV_NNC_CMD_OPT_GEMM_ALGO_DIRECT:
+			return _ccv_nnc_gemm_forw_epilogue(_ccv_nnc_gemm_forw_cpu_opt(a, w, bias, b), epilogue, b);
+		case CCV_NNC_CMD_OPT_GEMM_ALGO_SYSTEM:
+			if (!CCV_IS_TENSOR_VIEW(a) && !CCV_IS_TENSOR_VIEW(w) && (!bias || !CCV_IS_TENSOR_VIEW(bias)) && !CCV_IS_TENSOR_VIEW(b))
+				return _ccv_nnc_gemm_forw_epilogue(_ccv_nnc_gemm_forw_cpu_sys(a, w, bias, b), epilogue, b);
+			return CCV_NNC_EXEC_INVALID;
+		case CCV_NNC_CMD_OPT_GEMM_ALGO_PACKED:
+			return _ccv_nnc_gemm_forw_packed_cpu_opt(a, w, bias, b, epilogue);
+		case -1:
+			// Pass-through
+			break;
+	}
+#if (defined HAVE_CBLAS || defined HAVE_ACCELERATE_FRAMEWORK)
+	if (!CCV_IS_TENSOR_VIEW(a) && !CCV_IS_TENSOR_VIEW(w) && (!bias || !CCV_IS_TENSOR_VIEW(bias)) && !CCV_IS_TENSOR_VIEW(b))
+		return _ccv_nnc_gemm_forw_epilogue(_ccv_nnc_gemm_forw_cpu_sys(a, w, bias, b), epilogue, b);
+#endif
+	// With only one row, the packed GEMM has nothing to share the packed panels with, direct multiplication is better.
+	if (batch_size > 1)
+		return _ccv_nnc_gemm_forw_packed_cpu_opt(a, w, bias, b, epilogue);
+	const int status = _ccv_nnc_gemm_forw_cpu_opt(a, w, bias, b);
+	if (status == CCV_NNC_EXEC_INVALID)
+		return _ccv_nnc_gemm_forw_packed_cpu_opt(a, w, bias, b, epilogue);
+	return _ccv_nnc_gemm_forw_epilogue(status, epilogue, b);
+}
+
 static int _ccv_nnc_gemm_forw(const ccv_nnc_cmd_t cmd, const ccv_nnc_hint_t hint, const int flags, ccv_nnc_tensor_t* const* const inputs, const int input_size, ccv_nnc_tensor_t* const* const outputs, const int output_size, ccv_nnc_stream_context_t* const stream_context)
 {
-	assert(input_size >= 2);
+	// The fused element-wise ops take the last inputs.
+	const int epilogue_input_size = ccv_nnc_cmd_epilogue_input_size(cmd.info);
+	assert(input_size - epilogue_input_size >= 2);
 	const ccv_nnc_tensor_view_t* w = (const ccv_nnc_tensor_view_t*)inputs[1];
-	const ccv_nnc_tensor_view_t* bias = input_size > 2 ? (const ccv_nnc_tensor_view_t*)inputs[2] : 0;
+	const ccv_nnc_tensor_view_t* bias = input_size - epilogue_input_size > 2 ? (const ccv_nnc_tensor_view_t*)inputs[2] : 0;
 	// Copy the most of parameters, but reshape the dimension of a to a vector.
 	const ccv_nnc_tensor_view_t* a = (const ccv_nnc_tensor_view_t*)inputs[0];
 	assert(a->info.dim[2] == 0); // It is a 2-d array.
@@ -38,23 +78,18 @@ static int _ccv_nnc_gemm_forw(const ccv_nnc_cmd_t cmd, const ccv_nnc_hint_t hint
 	assert(!bias || bdim[0] == bias->info.dim[0]);
 	assert(bdim[0] == w->info.dim[0]);
 	assert(adim[0] == w->info.dim[1]);
-	switch (cmd.algorithm)
-	{
-		case CCV_NNC_CMD_OPT_GEMM_ALGO_DIRECT:
-			return _ccv_nnc_gemm_forw_cpu_opt(a, w, bias, b);
-		case CCV_NNC_CMD_OPT_GEMM_ALGO_SYSTEM:
-			if (!CCV_IS_TENSOR_VIEW(a) && !CCV_IS_TENSOR_VIEW(w) && (!bias || !CCV_IS_TENSOR_VIEW(bias)) && !CCV_IS_TENSOR_VIEW(b))
-				return _ccv_nnc_gemm_forw_cpu_sys(a, w, bias, b);
-			return CCV_NNC_EXEC_INVALID;
-		case -1:
-			// Pass-through
-			break;
-	}
-#if (defined HAVE_CBLAS || defined HAVE_ACCELERATE_FRAMEWORK)
-	if (!CCV_IS_TENSOR_VIEW(a) && !CCV_IS_TENSOR_VIEW(w) && (!bias || !CCV_IS_TENSOR_VIEW(bias)) && !CCV_IS_TENSOR_VIEW(b))
-		return _ccv_nnc_gemm_forw_cpu_sys(a, w, bias, b);
-#endif
-	return _ccv_nnc_gemm_forw_cpu_opt(a, w, bias, b);
+	if (!cmd.info.epilogue.size)
+		return _ccv_nnc_gemm_forw_opt(cmd.algorithm, a, w, bias, b, batch_size, 0);
+	// Not all kernels can apply the epilogue as they go, thus, the output has to be contiguous for the separate pass.
+	if (CCV_IS_TENSOR_VIEW(b))
+		return CCV_NNC_EXEC_INVALID;
+	ccv_nnc_cpu_epilogue_t epilogue;
+	int status = _ccv_nnc_cpu_epilogue_new(cmd.info, inputs + input_size - epilogue_input_size, epilogue_input_size, b, &epilogue);
+	if (status != CCV_NNC_EXEC_SUCCESS)
+		return status;
+	status = _ccv_nnc_gemm_forw_opt(cmd.algorithm, a, w, bias, b, batch_size, &epilogue);
+	_ccv_nnc_cpu_epilogue_free(&epilogue);
+	return status;
 }
 
 static int _ccv_nnc_gemm_back(const ccv_nnc_cmd_t cmd, const ccv_nnc_hint_t hint, const int flags, ccv_nnc_tensor_t* const* const inputs, const int input_size, ccv_nnc_tensor_t* const* const outputs, const int output_size, ccv_nnc_stream_context_t* const stream_context)
@@ -106,6 +141,8 @@ static int _ccv_nnc_gemm_back(const ccv_nnc_cmd_t cmd, const ccv_nnc_hint_t hint
 				(!w || !CCV_IS_TENSOR_VIEW(w)) && (!h || !CCV_IS_TENSOR_VIEW(h)))
 				return _ccv_nnc_gemm_back_cpu_sys(g, a, w, dw, bias, h, flags);
 			return CCV_NNC_EXEC_INVALID;
+		case CCV_NNC_CMD_OPT_GEMM_ALGO_PACKED:
+			return _ccv_nnc_gemm_back_packed_cpu_opt(g, a, w, dw, bias, h, flags);
 		case -1:
 			// Pass-through
 			break;
@@ -115,7 +152,12 @@ static int _ccv_nnc_gemm_back(const ccv_nnc_cmd_t cmd, const ccv_nnc_hint_t hint
 		(!w || !CCV_IS_TENSOR_VIEW(w)) && (!h || !CCV_IS_TENSOR_VIEW(h)))
 		return _ccv_nnc_gemm_back_cpu_sys(g, a, w, dw, bias, h, flags);
 #endif
-	return _ccv_nnc_gemm_back_cpu_opt(g, a, w, dw, bias, h, flags);
+	if (batch_size > 1)
+		return _ccv_nnc_gemm_back_packed_cpu_opt(g, a, w, dw, bias, h, flags);
+	const int status = _ccv_nnc_gemm_back_cpu_opt(g, a, w, dw, bias, h, flags);
+	if (status == CCV_NNC_EXEC_INVALID)
+		return _ccv_nnc_gemm_back_packed_cpu_opt(g, a, w, dw, bias, h, flags);
+	return status;
 }
 
 REGISTER_COMMAND_BACKEND(CCV_NNC_GEMM_FORWARD, CCV_NNC_BACKEND_CPU_OPT)(ccv_nnc_cmd_backend_registry_t* const registry)
@@ -124,6 +166,7 @@ REGISTER_COMMAND_BACKEND(CCV_NNC_GEMM_FORWARD, CCV_NNC_BACKEND_CPU_OPT)(ccv_nnc_
 	registry->tensor_datatypes = CCV_32F;
 	registry->tensor_memory = CCV_TENSOR_CPU_MEMORY;
 	registry->algorithms = CCV_NNC_CMD_OPT_GEMM_ALGO_COUNT;
+	registry->epilogue = 1;
 	registry->exec = _ccv_nnc_gemm_forw;
 }
 
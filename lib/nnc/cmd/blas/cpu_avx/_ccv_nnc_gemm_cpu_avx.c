@@ -0,0 +1,205 @@
+#include <ccv.h>
+#include <ccv_internal.h>
+#include <nnc/ccv_nnc.h>
+#include <nnc/ccv_nnc_easy.h>
+#include <nnc/ccv_nnc_internal.h>
+#ifdef USE_OPENMP
+#include <omp.h>
+#endif
+#ifdef USE_DISPATCH
+#include <dispatch/dispatch.h>
+#endif
+#include "../../_ccv_nnc_cpu_avx.h"
+#ifdef CCV_NNC_CPU_AVX_ENABLED
+#include <immintrin.h>
+#endif
+#include "../_ccv_nnc_gemm_cpu_avx.h"
+
+#ifdef CCV_NNC_CPU_AVX_ENABLED
+// Compute up to 4 rows of w against a at a time, thus, the loaded a can be shared.
+typedef void (*ccv_nnc_gemv_f)(const float* const ap, const float* const wp, const int wstep, const int count, const int len, const float* const bias, float* const bp);
+// y += alpha * x
+typedef void (*ccv_nnc_axpy_f)(const float alpha, const float* const x, float* const y, const int len);
+
+CCV_NNC_CPU_AVX2_TARGET
+static void _ccv_nnc_gemv_avx2(const float* const ap, const float* const wp, const int wstep, const int count, const int len, const float* const bias, float* const bp)
+{
+	__m256 v8[4] = {
+		_mm256_setzero_ps(), _mm256_setzero_ps(), _mm256_setzero_ps(), _mm256_setzero_ps()
+	};
+	int k, r;
+	for (k = 0; k < len - 7; k += 8)
+	{
+		const __m256 a8 = _mm256_loadu_ps(ap + k);
+		for (r = 0; r < count; r++)
+			v8[r] = _mm256_fmadd_ps(_mm256_loadu_ps(wp + r * wstep + k), a8, v8[r]);
+	}
+	for (r = 0; r < count; r++)
+	{
+		__m128 v4 = _mm_add_ps(_mm256_castps256_ps128(v8[r]), _mm256_extractf128_ps(v8[r], 1));
+		v4 = _mm_add_ps(v4, _mm_movehl_ps(v4, v4));
+		v4 = _mm_add_ss(v4, _mm_shuffle_ps(v4, v4, 1));
+		float sum = _mm_cvtss_f32(v4);
+		int x;
+		for (x = k; x < len; x++)
+			sum += wp[r * wstep + x] * ap[x];
+		bp[r] = bias ? bias[r] + sum : sum;
+	}
+}
+
+CCV_NNC_CPU_AVX2_TARGET
+static void _ccv_nnc_axpy_avx2(const float alpha, const float* const x, float* const y, const int len)
+{
+	const __m256 alpha8 = _mm256_set1_ps(alpha);
+	int k;
+	for (k = 0; k < len - 7; k += 8)
+		_mm256_storeu_ps(y + k, _mm256_fmadd_ps(alpha8, _mm256_loadu_ps(x + k), _mm256_loadu_ps(y + k)));
+	for (; k < len; k++)
+		y[k] += alpha * x[k];
+}
+
+CCV_NNC_CPU_AVX512_TARGET
+static void _ccv_nnc_gemv_avx512(const float* const ap, const float* const wp, const int wstep, const int count, const int len, const float* const bias, float* const bp)
+{
+	__m512 v16[4] = {
+		_mm512_setzero_ps(), _mm512_setzero_ps(), _mm512_setzero_ps(), _mm512_setzero_ps()
+	};
+	int k, r;
+	for (k = 0; k < len - 15; k += 16)
+	{
+		const __m512 a16 = _mm512_loadu_ps(ap + k);
+		for (r = 0; r < count; r++)
+			v16[r] = _mm512_fmadd_ps(_mm512_loadu_ps(wp + r * wstep + k), a16, v16[r]);
+	}
+	if (k < len) // Use masked loads for the tail.
+	{
+		const __mmask16 mask = (__mmask16)((1u << (len - k)) - 1);
+		const __m512 a16 = _mm512_maskz_loadu_ps(mask, ap + k);
+		for (r = 0; r < count; r++)
+			v16[r] = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(mask, wp + r * wstep + k), a16, v16[r]);
+	}
+	for (r = 0; r < count; r++)
+	{
+		const float sum = _mm512_reduce_add_ps(v16[r]);
+		bp[r] = bias ? bias[r] + sum : sum;
+	}
+}
+
+CCV_NNC_CPU_AVX512_TARGET
+static void _ccv_nnc_axpy_avx512(const float alpha, const float* const x, float* const y, const int len)
+{
+	const __m512 alpha16 = _mm512_set1_ps(alpha);
+	int k;
+	for (k = 0; k < len - 15; k += 16)
+		_mm512_storeu_ps(y + k, _mm512_fmadd_ps(alpha16, _mm512_loadu_ps(x + k), _mm512_loadu_ps(y + k)));
+	if (k < len)
+	{
+		const __mmask16 mask = (__mmask16)((1u << (len - k)) - 1);
+		_mm512_mask_storeu_ps(y + k, mask, _mm512_fmadd_ps(alpha16, _mm512_maskz_loadu_ps(mask, x + k), _mm512_maskz_loadu_ps(mask, y + k)));
+	}
+}
+
+// How many columns of h each task computes in backward pass, this keeps the partial h in L1.
+#define CCV_NNC_GEMM_AVX_H_BLOCK (256)
+#endif
+
+int _ccv_nnc_gemm_forw_cpu_avx(const ccv_nnc_tensor_view_t* const a, const ccv_nnc_tensor_view_t* const w, const ccv_nnc_tensor_view_t* const bias, ccv_nnc_tensor_view_t* const b)
+{
+#ifdef CCV_NNC_CPU_AVX_ENABLED
+	const int isa = _ccv_nnc_cpu_avx_isa();
+	if (!(isa & CCV_NNC_CPU_AVX2))
+		return CCV_NNC_EXEC_INVALID;
+	const ccv_nnc_gemv_f gemv = (isa & CCV_NNC_CPU_AVX512) ? _ccv_nnc_gemv_avx512 : _ccv_nnc_gemv_avx2;
+	const int a_nd = ccv_nnc_tensor_nd(a->info.dim);
+	const int* adim = (a_nd == 1) ? a->info.dim : a->info.dim + 1;
+	const int b_nd = ccv_nnc_tensor_nd(b->info.dim);
+	const int* bdim = (b_nd == 1) ? b->info.dim : b->info.dim + 1;
+	assert(!bias || bdim[0] == bias->info.dim[0]);
+	assert(bdim[0] == w->info.dim[0]);
+	assert(adim[0] == w->info.dim[1]);
+	const int batch_size = a_nd == 1 ? 1 : ccv_max(1, a->info.dim[0]);
+	assert(batch_size == (b_nd == 1) ? 1 : ccv_max(1, b->info.dim[0]));
+	const int a_batch_inc = CCV_IS_TENSOR_VIEW(a) ? (a_nd == 1 ? a->inc[0] : a->inc[1]) : adim[0];
+	const int b_batch_inc = CCV_IS_TENSOR_VIEW(b) ? (b_nd == 1 ? b->inc[0] : b->inc[1]) : bdim[0];
+	const int* winc = CCV_IS_TENSOR_VIEW(w) ? w->inc : w->info.dim;
+	const float* const biasp = bias ? bias->data.f32 : 0;
+	int i;
+	for (i = 0; i < batch_size; i++)
+	{
+		const float* const ap = a->data.f32 + i * a_batch_inc;
+		float* const bp = b->data.f32 + i * b_batch_inc;
+		parallel_for(y, (bdim[0] + 3) / 4) {
+			const int j = y * 4;
+			gemv(ap, w->data.f32 + j * winc[1], winc[1], ccv_min(4, bdim[0] - j), adim[0], biasp ? biasp + j : 0, bp + j);
+		} parallel_endfor
+	}
+	return CCV_NNC_EXEC_SUCCESS;
+#else
+	return CCV_NNC_EXEC_INVALID;
+#endif
+}
+
+int _ccv_nnc_gemm_back_cpu_avx(const ccv_nnc_tensor_view_t* const g, const ccv_nnc_tensor_view_t* const a, const ccv_nnc_tensor_view_t* const w, ccv_nnc_tensor_view_t* const dw, ccv_nnc_tensor_view_t* const bias, ccv_nnc_tensor_view_t* const h, const int flags)
+{
+#ifdef CCV_NNC_CPU_AVX_ENABLED
+	const int isa = _ccv_nnc_cpu_avx_isa();
+	if (!(isa & CCV_NNC_CPU_AVX2))
+		return CCV_NNC_EXEC_INVALID;
+	const ccv_nnc_axpy_f axpy = (isa & CCV_NNC_CPU_AVX512) ? _ccv_nnc_axpy_avx512 : _ccv_nnc_axpy_avx2;
+	const int* dwinc = CCV_IS_TENSOR_VIEW(dw) ? dw->inc : dw->info.dim;
+	if (!(flags & CCV_NNC_ACCUMULATE_OUTPUT)) // reset the gradients to 0
+	{
+		memset(dw->data.u8, 0, sizeof(float) * dwinc[1] * dw->info.dim[0]);
+		if (bias)
+			memset(bias->data.u8, 0, sizeof(float) * bias->info.dim[0]);
+	}
+	const int a_nd = ccv_nnc_tensor_nd(a->info.dim);
+	const int* adim = (a_nd == 1) ? a->info.dim : a->info.dim + 1;
+	const int g_nd = ccv_nnc_tensor_nd(g->info.dim);
+	const int* gdim = (g_nd == 1) ? g->info.dim : g->info.dim + 1;
+	const int batch_size = a_nd == 1 ? 1 : ccv_max(1, a->info.dim[0]);
+	int i;
+	const int g_batch_inc = CCV_IS_TENSOR_VIEW(g) ? ((g_nd == 1) ? g->inc[0] : g->inc[1]) : gdim[0];
+	if (bias)
+	{
+		assert(bias->info.dim[0] == gdim[0]);
+		for (i = 0; i < batch_size; i++)
+			axpy(1, g->data.f32 + i * g_batch_inc, bias->data.f32, gdim[0]);
+	}
+	assert(gdim[0] == dw->info.dim[0]);
+	assert(adim[0] == dw->info.dim[1]);
+	const int a_batch_inc = CCV_IS_TENSOR_VIEW(a) ? ((a_nd == 1) ? a->inc[0] : a->inc[1]) : adim[0];
+	for (i = 0; i < batch_size; i++)
+	{
+		const float* const gp = g->data.f32 + i * g_batch_inc;
+		const float* const ap = a->data.f32 + i * a_batch_inc;
+		parallel_for(j, gdim[0]) {
+			axpy(gp[j], ap, dw->data.f32 + j * dwinc[1], adim[0]);
+		} parallel_endfor
+	}
+	if (h && w)
+	{
+		const int h_nd = ccv_nnc_tensor_nd(h->info.dim);
+		const int* hdim = (h_nd == 1) ? h->info.dim : h->info.dim + 1;
+		assert(hdim[0] == adim[0]);
+		const int h_batch_inc = CCV_IS_TENSOR_VIEW(h) ? ((h_nd == 1) ? h->inc[0] : h->inc[1]) : hdim[0];
+		const int* winc = CCV_IS_TENSOR_VIEW(w) ? w->inc : w->info.dim;
+		for (i = 0; i < batch_size; i++)
+		{
+			const float* const gp = g->data.f32 + i * g_batch_inc;
+			float* const hp = h->data.f32 + i * h_batch_inc;
+			parallel_for(y, (hdim[0] + CCV_NNC_GEMM_AVX_H_BLOCK - 1) / CCV_NNC_GEMM_AVX_H_BLOCK) {
+				const int x = y * CCV_NNC_GEMM_AVX_H_BLOCK;
+				const int len = ccv_min(CCV_NNC_GEMM_AVX_H_BLOCK, hdim[0] - x);
+				int k;
+				memset(hp + x, 0, sizeof(float) * len);
+				for (k = 0; k < gdim[0]; k++)
+					axpy(gp[k], w->data.f32 + k * winc[1] + x, hp + x, len);
+			} parallel_endfor
+		}
+	}
+	return CCV_NNC_EXEC_SUCCESS;
+#else
+	return CCV_NNC_EXEC_INVALID;
+#endif
+}
@@ -0,0 +1,330 @@
+#include <ccv.h>
+#include <ccv_internal.h>
+#include <nnc/ccv_nnc.h>
+#include <nnc/ccv_nnc_easy.h>
+#include <nnc/ccv_nnc_internal.h>
+#if defined(HAVE_SSE2)
+#include <xmmintrin.h>
+#endif
+#ifdef USE_OPENMP
+#include <omp.h>
+#endif
+#ifdef USE_DISPATCH
+#include <dispatch/dispatch.h>
+#endif
+#include "../_ccv_nnc_gemm_cpu_opt.h"
+
+/*
+ * The packed GEMM follows the usual BLIS structure: b is packed into panels of NR columns (kc x NR each, for KC
+ * rows at a time), a is packed into panels of MR rows (MR x kc each), and a MR x NR micro-kernel walks one a panel
+ * and one b panel, keeping the MR x NR block of c in registers. The kc x NR b panel stays in L1 while the micro-kernel
+ * goes down the MC rows of a, and the MC x kc block of a stays in L2 while we go across NB columns of b.
+ */
+#define MR (4)
+#define NR (8)
+#define KC (256)
+#define MC (128)
+#define NB (64)
+
+// The packed b is laid out block by block (of KC rows), within each block, panel by panel (of NR columns),
+// thus, the offset of the block starts at p0 is p0 * round_n, and the offset of the panel starts at j0 is j0 * kc.
+static void _ccv_nnc_gemm_pack_b(const int k, const int n, const float* const b, const int b_rs, const int b_cs, float* const pb)
+{
+	const int round_n = (n + NR - 1) / NR * NR;
+	const int panel_count = round_n / NR;
+	int p0;
+	for (p0 = 0; p0 < k; p0 += KC)
+	{
+		const int kc = ccv_min(KC, k - p0);
+		parallel_for(jp, panel_count) {
+			int p, j;
+			const int j0 = jp * NR;
+			const int nr = ccv_min(NR, n - j0);
+			float* pbz = pb + p0 * round_n + j0 * kc;
+			for (p = 0; p < kc; p++)
+			{
+				const float* const bz = b + (p0 + p) * b_rs + j0 * b_cs;
+				for (j = 0; j < nr; j++)
+					pbz[j] = bz[j * b_cs];
+				for (; j < NR; j++)
+					pbz[j] = 0;
+				pbz += NR;
+			}
+		} parallel_endfor
+	}
+}
+
+static void _ccv_nnc_gemm_pack_a(const int m, const int kc, const float* const a, const int a_rs, const int a_cs, float* const pa)
+{
+	const int panel_count = (m + MR - 1) / MR;
+	parallel_for(ip, panel_count) {
+		int p, i;
+		const int i0 = ip * MR;
+		const int mr = ccv_min(MR, m - i0);
+		float* paz = pa + i0 * kc;
+		for (p = 0; p < kc; p++)
+		{
+			const float* const az = a + i0 * a_rs + p * a_cs;
+			for (i = 0; i < mr; i++)
+				paz[i] = az[i * a_rs];
+			for (; i < MR; i++)
+				paz[i] = 0;
+			paz += MR;
+		}
+	} parallel_endfor
+}
+
+#ifdef HAVE_SSE2
+static void _ccv_nnc_gemm_kernel_sse2(const int kc, const float* pa, const float* pb, float* const c, const int ldc, const int accumulate, const int mr, const int nr)
+{
+	__m128 c00 = _mm_setzero_ps(), c01 = _mm_setzero_ps();
+	__m128 c10 = _mm_setzero_ps(), c11 = _mm_setzero_ps();
+	__m128 c20 = _mm_setzero_ps(), c21 = _mm_setzero_ps();
+	__m128 c30 = _mm_setzero_ps(), c31 = _mm_setzero_ps();
+	int p;
+	for (p = 0; p < kc; p++)
+	{
+		const __m128 b0 = _mm_load_ps(pb);
+		const __m128 b1 = _mm_load_ps(pb + 4);
+		const __m128 a0 = _mm_load1_ps(pa);
+		const __m128 a1 = _mm_load1_ps(pa + 1);
+		const __m128 a2 = _mm_load1_ps(pa + 2);
+		const __m128 a3 = _mm_load1_ps(pa + 3);
+		c00 = _mm_add_ps(_mm_mul_ps(a0, b0), c00);
+		c01 = _mm_add_ps(_mm_mul_ps(a0, b1), c01);
+		c10 = _mm_add_ps(_mm_mul_ps(a1, b0), c10);
+		c11 = _mm_add_ps(_mm_mul_ps(a1, b1), c11);
+		c20 = _mm_add_ps(_mm_mul_ps(a2, b0), c20);
+		c21 = _mm_add_ps(_mm_mul_ps(a2, b1), c21);
+		c30 = _mm_add_ps(_mm_mul_ps(a3, b0), c30);
+		c31 = _mm_add_ps(_mm_mul_ps(a3, b1), c31);
+		pa += MR;
+		pb += NR;
+	}
+	if (mr == MR && nr == NR)
+	{
+		float* const c0 = c;
+		float* const c1 = c + ldc;
+		float* const c2 = c + ldc * 2;
+		float* const c3 = c + ldc * 3;
+		if (accumulate)
+		{
+			c00 = _mm_add_ps(_mm_loadu_ps(c0), c00);
+			c01 = _mm_add_ps(_mm_loadu_ps(c0 + 4), c01);
+			c10 = _mm_add_ps(_mm_loadu_ps(c1), c10);
+			c11 = _mm_add_ps(_mm_loadu_ps(c1 + 4), c11);
+			c20 = _mm_add_ps(_mm_loadu_ps(c2), c20);
+			c21 = _mm_add_ps(_mm_loadu_ps(c2 + 4), c21);
+			c30 = _mm_add_ps(_mm_loadu_ps(c3), c30);
+			c31 = _mm_add_ps(_mm_loadu_ps(c3 + 4), c31);
+		}
+		_mm_storeu_ps(c0, c00);
+		_mm_storeu_ps(c0 + 4, c01);
+		_mm_storeu_ps(c1, c10);
+		_mm_storeu_ps(c1 + 4, c11);
+		_mm_storeu_ps(c2, c20);
+		_mm_storeu_ps(c2 + 4, c21);
+		_mm_storeu_ps(c3, c30);
+		_mm_storeu_ps(c3 + 4, c31);
+		return;
+	}
+	// On the edges, spill the block to memory and only write back what is in c.
+	float t[MR * NR] __attribute__ ((__aligned__(16)));
+	_mm_store_ps(t, c00);
+	_mm_store_ps(t + 4, c01);
+	_mm_store_ps(t + 8, c10);
+	_mm_store_ps(t + 12, c11);
+	_mm_store_ps(t + 16, c20);
+	_mm_store_ps(t + 20, c21);
+	_mm_store_ps(t + 24, c30);
+	_mm_store_ps(t + 28, c31);
+	int i, j;
+	for (i = 0; i < mr; i++)
+		if (accumulate)
+			for (j = 0; j < nr; j++)
+				c[i * ldc + j] += t[i * NR + j];
+		else
+			for (j = 0; j < nr; j++)
+				c[i * ldc + j] = t[i * NR + j];
+}
+#else
+static void _ccv_nnc_gemm_kernel_ref(const int kc, const float* pa, const float* pb, float* const c, const int ldc, const int accumulate, const int mr, const int nr)
+{
+	float t[MR * NR] = {};
+	int i, j, p;
+	for (p = 0; p < kc; p++)
+	{
+		for (i = 0; i < MR; i++)
+			for (j = 0; j < NR; j++)
+				t[i * NR + j] += pa[i] * pb[j];
+		pa += MR;
+		pb += NR;
+	}
+	for (i = 0; i < mr; i++)
+		if (accumulate)
+			for (j = 0; j < nr; j++)
+				c[i * ldc + j] += t[i * NR + j];
+		else
+			for (j = 0; j < nr; j++)
+				c[i * ldc + j] = t[i * NR + j];
+}
+#endif
+
+typedef struct {
+	int k;
+	int n;
+	const float* b;
+	int b_rs;
+	int b_cs;
+} ccv_nnc_gemm_pack_b_t;
+
+static void _ccv_nnc_gemm_pack_b_derive(void* const data, const void* const context)
+{
+	const ccv_nnc_gemm_pack_b_t* const pack = (const ccv_nnc_gemm_pack_b_t*)context;
+	_ccv_nnc_gemm_pack_b(pack->k, pack->n, pack->b, pack->b_rs, pack->b_cs, (float*)data);
+}
+
+float* _ccv_nnc_gemm_pack_b_cpu_opt(const int k, const int n, const float* const b, const int b_rs, const int b_cs, const uint64_t b_sig, int* const owned)
+{
+	const int round_n = (n + NR - 1) / NR * NR;
+	const ccv_nnc_gemm_pack_b_t pack = {
+		.k = k,
+		.n = n,
+		.b = b,
+		.b_rs = b_rs,
+		.b_cs = b_cs,
+	};
+	if (b_sig)
+	{
+		ccv_declare_derived_signature(sig, 1, ccv_sign_with_format(64, "_ccv_nnc_gemm_pack_b_cpu_opt(%d,%d,%d,%d)", k, n, b_rs, b_cs), b_sig, CCV_EOF_SIGN);
+		float* const pb = (float*)ccv_nnc_constant_derived(b_sig, b, sig, sizeof(float) * round_n * k, _ccv_nnc_gemm_pack_b_derive, &pack);
+		if (pb)
+		{
+			*owned = 0;
+			return pb;
+		}
+	}
+	float* pb = 0;
+	ccmemalign((void **)&pb, 16, sizeof(float) * round_n * k);
+	if (!pb)
+		return 0;
+	_ccv_nnc_gemm_pack_b_derive(pb, &pack);
+	*owned = 1;
+	return pb;
+}
+
+int _ccv_nnc_gemm_packed_cpu_opt(const int m, const int n, const int k, const float* const a, const int a_rs, const int a_cs, const float* const pb, float* const c, const int ldc, const int accumulate, const ccv_nnc_cpu_epilogue_t* const epilogue, const int epilogue_row)
+{
+	const int round_m = (m + MR - 1) / MR * MR;
+	const int round_n = (n + NR - 1) / NR * NR;
+	float* pa = 0;
+	ccmemalign((void **)&pa, 16, sizeof(float) * round_m * ccv_min(k, KC));
+	if (!pa)
+		return CCV_NNC_EXEC_OOM;
+	const int mb = (m + MC - 1) / MC;
+	const int nb = (n + NB - 1) / NB;
+	int p0;
+	for (p0 = 0; p0 < k; p0 += KC)
+	{
+		const int kc = ccv_min(KC, k - p0);
+		const int acc = accumulate || p0 > 0;
+		_ccv_nnc_gemm_pack_a(m, kc, a + p0 * a_cs, a_rs, a_cs, pa);
+		const float* const pbp = pb + p0 * round_n;
+		parallel_for(t, mb * nb) {
+			int ir, jr;
+			const int ic = (t / nb) * MC;
+			const int jc = (t % nb) * NB;
+			const int ie = ccv_min(ic + MC, m);
+			const int je = ccv_min(jc + NB, n);
+			for (jr = jc; jr < je; jr += NR)
+				for (ir = ic; ir < ie; ir += MR)
+#ifdef HAVE_SSE2
+					_ccv_nnc_gemm_kernel_sse2(kc, pa + ir * kc, pbp + jr * kc, c + ir * ldc + jr, ldc, acc, ccv_min(MR, m - ir), ccv_min(NR, n - jr));
+#else
+					_ccv_nnc_gemm_kernel_ref(kc, pa + ir * kc, pbp + jr * kc, c + ir * ldc + jr, ldc, acc, ccv_min(MR, m - ir), ccv_min(NR, n - jr));
+#endif
+			// After the last panel, the block is done, apply the epilogue while it is still in cache.
+			if (epilogue && p0 + kc == k)
+				_ccv_nnc_cpu_epilogue_apply(epilogue, c + ic * ldc + jc, ldc, epilogue_row + ic, ie - ic, jc, je - jc);
+		} parallel_endfor
+	}
+	ccfree(pa);
+	return CCV_NNC_EXEC_SUCCESS;
+}
+
+int _ccv_nnc_gemm_cpu_packed(const int m, const int n, const int k, const float* const a, const int a_rs, const int a_cs, const float* const b, const int b_rs, const int b_cs, const uint64_t b_sig, float* const c, const int ldc, const int accumulate, const ccv_nnc_cpu_epilogue_t* const epilogue, const int epilogue_row)
+{
+	int owned;
+	float* const pb = _ccv_nnc_gemm_pack_b_cpu_opt(k, n, b, b_rs, b_cs, b_sig, &owned);
+	if (!pb)
+		return CCV_NNC_EXEC_OOM;
+	const int status = _ccv_nnc_gemm_packed_cpu_opt(m, n, k, a, a_rs, a_cs, pb, c, ldc, accumulate, epilogue, epilogue_row);
+	if (owned)
+		ccfree(pb);
+	return status;
+}
+
+int _ccv_nnc_gemm_forw_packed_cpu_opt(const ccv_nnc_tensor_view_t* const a, const ccv_nnc_tensor_view_t* const w, const ccv_nnc_tensor_view_t* const bias, ccv_nnc_tensor_view_t* const b, const ccv_nnc_cpu_epilogue_t* const epilogue)
+{
+	const int a_nd = ccv_nnc_tensor_nd(a->info.dim);
+	const int* adim = (a_nd == 1) ? a->info.dim : a->info.dim + 1;
+	const int b_nd = ccv_nnc_tensor_nd(b->info.dim);
+	const int* bdim = (b_nd == 1) ? b->info.dim : b->info.dim + 1;
+	assert(!bias || bdim[0] == bias->info.dim[0]);
+	assert(bdim[0] == w->info.dim[0]);
+	assert(adim[0] == w->info.dim[1]);
+	const int batch_size = a_nd == 1 ? 1 : ccv_max(1, a->info.dim[0]);
+	assert(batch_size == (b_nd == 1) ? 1 : ccv_max(1, b->info.dim[0]));
+	const int a_batch_inc = CCV_IS_TENSOR_VIEW(a) ? (a_nd == 1 ? a->inc[0] : a->inc[1]) : adim[0];
+	const int b_batch_inc = CCV_IS_TENSOR_VIEW(b) ? (b_nd == 1 ? b->inc[0] : b->inc[1]) : bdim[0];
+	const int* winc = CCV_IS_TENSOR_VIEW(w) ? w->inc : w->info.dim;
+	int i;
+	if (bias)
+		for (i = 0; i < batch_size; i++)
+			memcpy(b->data.f32 + i * b_batch_inc, bias->data.f32, sizeof(float) * bdim[0]);
+	// b = a . T(w), thus, T(w) is the b matrix for GEMM, with row stride 1 and column stride winc[1].
+	return _ccv_nnc_gemm_cpu_packed(batch_size, bdim[0], adim[0], a->data.f32, a_batch_inc, 1, w->data.f32, 1, winc[1], w->sig, b->data.f32, b_batch_inc, !!bias, epilogue, 0);
+}
+
+int _ccv_nnc_gemm_back_packed_cpu_opt(const ccv_nnc_tensor_view_t* const g, const ccv_nnc_tensor_view_t* const a, const ccv_nnc_tensor_view_t* const w, ccv_nnc_tensor_view_t* const dw, ccv_nnc_tensor_view_t* const bias, ccv_nnc_tensor_view_t* const h, const int flags)
+{
+	const int a_nd = ccv_nnc_tensor_nd(a->info.dim);
+	const int* adim = (a_nd == 1) ? a->info.dim : a->info.dim + 1;
+	const int g_nd = ccv_nnc_tensor_nd(g->info.dim);
+	const int* gdim = (g_nd == 1) ? g->info.dim : g->info.dim + 1;
+	const int batch_size = a_nd == 1 ? 1 : ccv_max(1, a->info.dim[0]);
+	const int g_batch_inc = CCV_IS_TENSOR_VIEW(g) ? ((g_nd == 1) ? g->inc[0] : g->inc[1]) : gdim[0];
+	const int a_batch_inc = CCV_IS_TENSOR_VIEW(a) ? ((a_nd == 1) ? a->inc[0] : a->inc[1]) : adim[0];
+	const int* dwinc = CCV_IS_TENSOR_VIEW(dw) ? dw->inc : dw->info.dim;
+	int i, j;
+	if (bias)
+	{
+		if (!(flags & CCV_NNC_ACCUMULATE_OUTPUT)) // reset the gradients to 0
+			memset(bias->data.u8, 0, sizeof(float) * bias->info.dim[0]);
+		assert(bias->info.dim[0] == gdim[0]);
+		float* const bp = bias->data.f32;
+		for (i = 0; i < batch_size; i++)
+		{
+			const float* const gp = g->data.f32 + i * g_batch_inc;
+			for (j = 0; j < gdim[0]; j++)
+				bp[j] += gp[j];
+		}
+	}
+	assert(gdim[0] == dw->info.dim[0]);
+	assert(adim[0] == dw->info.dim[1]);
+	// dw = T(g) . a
+	int status = _ccv_nnc_gemm_cpu_packed(gdim[0], adim[0], batch_size, g->data.f32, 1, g_batch_inc, a->data.f32, a_batch_inc, 1, 0, dw->data.f32, dwinc[1], flags & CCV_NNC_ACCUMULATE_OUTPUT, 0, 0);
+	if (status != CCV_NNC_EXEC_SUCCESS)
+		return status;
+	if (h && w)
+	{
+		const int h_nd = ccv_nnc_tensor_nd(h->info.dim);
+		const int* hdim = (h_nd == 1) ? h->info.dim : h->info.dim + 1;
+		assert(hdim[0] == adim[0]);
+		const int h_batch_inc = CCV_IS_TENSOR_VIEW(h) ? ((h_nd == 1) ? h->inc[0] : h->inc[1]) : hdim[0];
+		const int* winc = CCV_IS_TENSOR_VIEW(w) ? w->inc : w->info.dim;
+		// h = g . w
+		status = _ccv_nnc_gemm_cpu_packed(batch_size, hdim[0], gdim[0], g->data.f32, g_batch_inc, 1, w->data.f32, winc[1], 1, w->sig, h->data.f32, h_batch_inc, 0, 0, 0);
+	}
+	return status;
+}
@@ -9,6 +9,7 @@ enum {
 	CCV_NNC_BACKEND_CPU_OPT = 0x46deb194,
 	CCV_NNC_BACKEND_GPU_REF = 0x5f19790a,
 	CCV_NNC_BACKEND_GPU_CUBLAS = 0x9b8cfed,
-	CCV_NNC_BACKEND_COUNT = 5,
+	CCV_NNC_BACKEND_CPU_AVX = 0xbc447e6c,
+	CCV_NNC_BACKEND_COUNT = 6,
 };
 /** @} */
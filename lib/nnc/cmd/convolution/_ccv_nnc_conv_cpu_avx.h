@@ -0,0 +1,18 @@
+/**********************************************************
+ * C-based/Cached/Core Computer Vision Library
+ * Liu Liu, 2010-02-01
+ **********************************************************/
+
+/**********************************************************
+ * CCV - Neural Network Collection
+ **********************************************************/
+
+#ifndef GUARD_ccv_nnc_conv_cpu_avx_h
+#define GUARD_ccv_nnc_conv_cpu_avx_h
+
+#include <ccv.h>
+#include <nnc/ccv_nnc.h>
+
+int _ccv_nnc_conv_forw_cpu_avx(const ccv_nnc_tensor_view_t* const a, const ccv_nnc_tensor_t* const w, const ccv_nnc_tensor_t* const bias, const ccv_nnc_hint_t hint, ccv_nnc_tensor_view_t* const b);
+
+#endif
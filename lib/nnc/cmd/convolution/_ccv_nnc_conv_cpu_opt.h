@@ -11,11 +11,35 @@
 #define GUARD_ccv_nnc_conv_cpu_opt_h
 
 #include <ccv.h>
+#include <ccv_internal.h>
 #include <nnc/ccv_nnc.h>
+#include <nnc/ccv_nnc_internal.h>
+
+#include "../_ccv_nnc_cpu_ref.h"
+
+/**
+ * The weights of w transformed by a kernel. If w is a constant owned by a tensor arena, the transformed weights are
+ * kept by the arena, keyed by the signature of w, and computed only once.
+ * @param w The weight tensor.
+ * @param name The name of the transform, different layouts need different names.
+ * @param size The number of floats of the transformed weights.
+ * @param transform The function to transform the weights, it receives w as its context.
+ * @return 0 if w is not such a constant, the caller has to transform the weights into its own memory then.
+ */
+static inline const float* _ccv_nnc_conv_cpu_opt_weights(const ccv_nnc_tensor_t* const w, const char* const name, const int size, ccv_nnc_constant_derive_f transform)
+{
+	if (!w->sig)
+		return 0;
+	ccv_declare_derived_signature(sig, 1, ccv_sign_with_format(64, "%s(%d,%d,%d,%d)", name, w->info.dim[0], w->info.dim[1], w->info.dim[2], w->info.dim[3]), w->sig, CCV_EOF_SIGN);
+	return (const float*)ccv_nnc_constant_derived(w->sig, w->data.u8, sig, sizeof(float) * size, transform, w);
+}
 
 int _ccv_nnc_conv_forw_4x4_3x3_winograd_cpu_opt(const ccv_nnc_tensor_view_t* const a, const ccv_nnc_tensor_t* const w, const ccv_nnc_tensor_t* const bias, const ccv_nnc_hint_t hint, ccv_nnc_tensor_view_t* const b, ccv_nnc_stream_context_t* const stream_context);
+int _ccv_nnc_conv_forw_6x6_3x3_winograd_cpu_opt(const ccv_nnc_tensor_view_t* const a, const ccv_nnc_tensor_t* const w, const ccv_nnc_tensor_t* const bias, const ccv_nnc_hint_t hint, ccv_nnc_tensor_view_t* const b, ccv_nnc_stream_context_t* const stream_context);
 int _ccv_nnc_conv_forw_fft_cpu_opt(const ccv_nnc_tensor_view_t* const a, const ccv_nnc_tensor_t* const w, const ccv_nnc_tensor_t* const bias, const ccv_nnc_hint_t hint, ccv_nnc_tensor_view_t* const b);
-int _ccv_nnc_conv_forw_gemm_cpu_opt(const ccv_nnc_tensor_view_t* const a, const ccv_nnc_tensor_t* const w, const ccv_nnc_tensor_t* const bias, const ccv_nnc_hint_t hint, ccv_nnc_tensor_view_t* const b);
+int _ccv_nnc_conv_forw_gemm_cpu_opt(const ccv_nnc_tensor_view_t* const a, const ccv_nnc_tensor_t* const w, const ccv_nnc_tensor_t* const bias, const ccv_nnc_hint_t hint, ccv_nnc_tensor_view_t* const b, const ccv_nnc_cpu_epilogue_t* const epilogue);
+int _ccv_nnc_conv_forw_1x1_cpu_opt(const ccv_nnc_tensor_view_t* const a, const ccv_nnc_tensor_t* const w, const ccv_nnc_tensor_t* const bias, const ccv_nnc_hint_t hint, ccv_nnc_tensor_view_t* const b);
+int _ccv_nnc_conv_forw_3x3_s2_cpu_opt(const ccv_nnc_tensor_view_t* const a, const ccv_nnc_tensor_t* const w, const ccv_nnc_tensor_t* const bias, const ccv_nnc_hint_t hint, ccv_nnc_tensor_view_t* const b);
 int _ccv_nnc_conv_forw_cpu_opt(const ccv_nnc_tensor_view_t* const a, const ccv_nnc_tensor_t* const w, const ccv_nnc_tensor_t* const bias, const ccv_nnc_hint_t hint, ccv_nnc_tensor_view_t* const b);
 
 #endif
@@ -0,0 +1,60 @@
+#include <ccv.h>
+#include <ccv_internal.h>
+#include <nnc/ccv_nnc.h>
+#include <nnc/ccv_nnc_easy.h>
+#include <nnc/ccv_nnc_internal.h>
+
+#include "../_ccv_nnc_cpu_avx.h"
+#include "_ccv_nnc_conv_cpu_avx.h"
+
+FIND_FILE(cpu_avx/_ccv_nnc_conv_cpu_avx.c)
+
+enum {
+	CCV_NNC_CMD_AVX_CONV_ALGO_DC, // Direct convolution
+	CCV_NNC_CMD_AVX_CONV_ALGO_COUNT
+};
+
+static int _ccv_nnc_conv_forw(const ccv_nnc_cmd_t cmd, const ccv_nnc_hint_t hint, const int flags, ccv_nnc_tensor_t* const* const inputs, const int input_size, ccv_nnc_tensor_t* const* const outputs, const int output_size, ccv_nnc_stream_context_t* const stream_context)
+{
+	assert(input_size >= 2);
+	const ccv_nnc_tensor_view_t* a = (ccv_nnc_tensor_view_t*)inputs[0];
+	const ccv_nnc_tensor_t* w = inputs[1];
+	assert(!CCV_IS_TENSOR_VIEW(w));
+	const ccv_nnc_tensor_t* bias = input_size > 2 ? inputs[2] : 0;
+	assert(!bias || !CCV_IS_TENSOR_VIEW(bias));
+	assert(output_size == 1);
+	ccv_nnc_tensor_view_t* b = (ccv_nnc_tensor_view_t*)outputs[0];
+	const int a_nd = ccv_nnc_tensor_nd(a->info.dim);
+	assert(a_nd == CCV_NNC_MAX_DIM + 1 || a_nd == CCV_NNC_MAX_DIM + 2);
+	const int* adim = (a_nd == CCV_NNC_MAX_DIM + 1) ? a->info.dim : a->info.dim + 1;
+	const int b_nd = ccv_nnc_tensor_nd(b->info.dim);
+	assert(b_nd == CCV_NNC_MAX_DIM + 1 || b_nd == CCV_NNC_MAX_DIM + 2);
+	const int* bdim = (b_nd == CCV_NNC_MAX_DIM + 1) ? b->info.dim : b->info.dim + 1;
+	assert(w->info.dim[CCV_NNC_MAX_DIM + 1] == adim[CCV_NNC_MAX_DIM]);
+	assert(bdim[CCV_NNC_MAX_DIM] == cmd.info.convolution.count);
+	// The kernels compute 8 (AVX2) or 16 (AVX-512) output channels at a time, leave the other shapes to other backends.
+	if (cmd.info.convolution.groups != 1 || cmd.info.convolution.count % 8 != 0)
+		return CCV_NNC_EXEC_INVALID;
+	int i;
+	// Make sure the weights dimension matches the network dimension
+	for (i = 1; i < CCV_NNC_MAX_DIM_ALLOC; i++)
+	{
+		if (w->info.dim[i] == 0 || cmd.info.size.dim[i - 1] == 0)
+			break;
+		assert(w->info.dim[i] == cmd.info.size.dim[i - 1]);
+	}
+	// AVX-512 kernel is used when the output channels are multiple of 16, otherwise AVX2 kernel.
+	return _ccv_nnc_conv_forw_cpu_avx(a, w, bias, hint, b);
+}
+
+REGISTER_COMMAND_BACKEND(CCV_NNC_CONVOLUTION_FORWARD, CCV_NNC_BACKEND_CPU_AVX)(ccv_nnc_cmd_backend_registry_t* const registry)
+{
+	// Don't register the exec function if this CPU doesn't support AVX2 / FMA, thus, this backend won't be picked.
+	if (!(_ccv_nnc_cpu_avx_isa() & CCV_NNC_CPU_AVX2))
+		return;
+	registry->tensor_formats = CCV_TENSOR_FORMAT_NHWC;
+	registry->tensor_datatypes = CCV_32F;
+	registry->tensor_memory = CCV_TENSOR_CPU_MEMORY;
+	registry->algorithms = CCV_NNC_CMD_AVX_CONV_ALGO_COUNT;
+	registry->exec = _ccv_nnc_conv_forw;
+}
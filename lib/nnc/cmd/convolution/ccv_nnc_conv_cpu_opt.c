@@ -6,23 +6,96 @@
 
 #include "_ccv_nnc_conv_cpu_opt.h"
 
-FIND_FILE(cpu_opt/_ccv_nnc_conv_cpu_4x4_3x3_winograd.c, cpu_opt/_ccv_nnc_conv_cpu_fft.c, cpu_opt/_ccv_nnc_conv_cpu_gemm.c, cpu_opt/_ccv_nnc_conv_cpu_opt.c)
+FIND_FILE(cpu_opt/_ccv_nnc_conv_cpu_4x4_3x3_winograd.c, cpu_opt/_ccv_nnc_conv_cpu_6x6_3x3_winograd.c, cpu_opt/_ccv_nnc_conv_cpu_1x1.c, cpu_opt/_ccv_nnc_conv_cpu_3x3_s2.c, cpu_opt/_ccv_nnc_conv_cpu_fft.c, cpu_opt/_ccv_nnc_conv_cpu_gemm.c, cpu_opt/_ccv_nnc_conv_cpu_opt.c)
 
 enum {
 	CCV_NNC_CMD_OPT_CONV_ALGO_DC, // Direct convolution
-	CCV_NNC_CMD_OPT_CONV_ALGO_GEMM, // GEMM (for 1x1)
+	CCV_NNC_CMD_OPT_CONV_ALGO_GEMM, // GEMM (im2col for anything other than 1x1)
 	CCV_NNC_CMD_OPT_CONV_ALGO_WINOGRAD, // Winograd algorithm
 	CCV_NNC_CMD_OPT_CONV_ALGO_FFT, // Fast Fourier transform
+	CCV_NNC_CMD_OPT_CONV_ALGO_WINOGRAD_6X6, // Winograd algorithm with 6x6 output tiles (for large feature maps)
+	CCV_NNC_CMD_OPT_CONV_ALGO_1X1, // Direct convolution blocked for 1x1 (any stride)
+	CCV_NNC_CMD_OPT_CONV_ALGO_3X3_S2, // Direct convolution blocked for 3x3 with stride 2
 	CCV_NNC_CMD_OPT_CONV_ALGO_COUNT
 };
 
+// The kernels other than the GEMM ones don't take the epilogue, apply it as a separate pass.
+static int _ccv_nnc_conv_forw_epilogue(const int status, const ccv_nnc_cpu_epilogue_t* const epilogue, ccv_nnc_tensor_view_t* const b)
+{
+	if (status == CCV_NNC_EXEC_SUCCESS && epilogue)
+		return _ccv_nnc_cpu_epilogue_apply_all(epilogue, b);
+	return status;
+}
+
+static int _ccv_nnc_conv_forw_opt(const int algorithm, const ccv_nnc_tensor_view_t* const a, const ccv_nnc_tensor_t* const w, const ccv_nnc_tensor_t* const bias, const ccv_nnc_hint_t hint, ccv_nnc_tensor_view_t* const b, const int* const bdim, const ccv_nnc_cpu_epilogue_t* const epilogue, ccv_nnc_stream_context_t* const stream_context)
+{
+	switch (algorithm)
+	{
+		case CCV_NNC_CMD_OPT_CONV_ALGO_DC:
+			return _ccv_nnc_conv_forw_epilogue(_ccv_nnc_conv_forw_cpu_opt(a, w, bias, hint, b), epilogue, b);
+		case CCV_NNC_CMD_OPT_CONV_ALGO_GEMM:
+			return _ccv_nnc_conv_forw_gemm_cpu_opt(a, w, bias, hint, b, epilogue);
+		case CCV_NNC_CMD_OPT_CONV_ALGO_WINOGRAD:
+			if (w->info.dim[1] == 3 && w->info.dim[2] == 3 && hint.stride.dim[0] <= 1 && hint.stride.dim[1] <= 1)
+				return _ccv_nnc_conv_forw_epilogue(_ccv_nnc_conv_forw_4x4_3x3_winograd_cpu_opt(a, w, bias, hint, b, stream_context), epilogue, b);
+			return CCV_NNC_EXEC_INVALID;
+		case CCV_NNC_CMD_OPT_CONV_ALGO_FFT:
+			return CCV_NNC_EXEC_INVALID; // Placeholder, for fft.
+		case CCV_NNC_CMD_OPT_CONV_ALGO_WINOGRAD_6X6:
+			if (w->info.dim[1] == 3 && w->info.dim[2] == 3 && hint.stride.dim[0] <= 1 && hint.stride.dim[1] <= 1)
+				return _ccv_nnc_conv_forw_epilogue(_ccv_nnc_conv_forw_6x6_3x3_winograd_cpu_opt(a, w, bias, hint, b, stream_context), epilogue, b);
+			return CCV_NNC_EXEC_INVALID;
+		case CCV_NNC_CMD_OPT_CONV_ALGO_1X1:
+			if (w->info.dim[1] == 1 && w->info.dim[2] == 1 &&
+				hint.border.begin[0] == 0 && hint.border.begin[1] == 0 && hint.border.end[0] <= 0 && hint.border.end[1] <= 0)
+				return _ccv_nnc_conv_forw_epilogue(_ccv_nnc_conv_forw_1x1_cpu_opt(a, w, bias, hint, b), epilogue, b);
+			return CCV_NNC_EXEC_INVALID;
+		case CCV_NNC_CMD_OPT_CONV_ALGO_3X3_S2:
+			if (w->info.dim[1] == 3 && w->info.dim[2] == 3 && hint.stride.dim[0] == 2 && hint.stride.dim[1] == 2)
+				return _ccv_nnc_conv_forw_epilogue(_ccv_nnc_conv_forw_3x3_s2_cpu_opt(a, w, bias, hint, b), epilogue, b);
+			return CCV_NNC_EXEC_INVALID;
+		case -1:
+			// Pass-through
+			break;
+	}
+	// If the size is 3x3, and no stride, choose Winograd kernel, on large feature maps, the 6x6 output tiles need less
+	// multiplications, on smaller ones, the 4x4 output tiles waste less on the edges. On the smallest ones (14x14, 7x7),
+	// the edges waste too much even for the 4x4 output tiles, the packed GEMM is faster.
+	if (w->info.dim[1] == 3 && w->info.dim[2] == 3 && hint.stride.dim[0] <= 1 && hint.stride.dim[1] <= 1)
+	{
+		if (bdim[0] <= 14 && bdim[1] <= 14)
+			return _ccv_nnc_conv_forw_gemm_cpu_opt(a, w, bias, hint, b, epilogue);
+		if (bdim[0] >= 48 && bdim[1] >= 48 && w->info.dim[0] % 4 == 0)
+			return _ccv_nnc_conv_forw_epilogue(_ccv_nnc_conv_forw_6x6_3x3_winograd_cpu_opt(a, w, bias, hint, b, stream_context), epilogue, b);
+		return _ccv_nnc_conv_forw_epilogue(_ccv_nnc_conv_forw_4x4_3x3_winograd_cpu_opt(a, w, bias, hint, b, stream_context), epilogue, b);
+	}
+	// If the size is 3x3, and stride is 2, choose the blocked direct convolution kernel
+	if (w->info.dim[1] == 3 && w->info.dim[2] == 3 && hint.stride.dim[0] == 2 && hint.stride.dim[1] == 2 && w->info.dim[0] % 4 == 0)
+		return _ccv_nnc_conv_forw_epilogue(_ccv_nnc_conv_forw_3x3_s2_cpu_opt(a, w, bias, hint, b), epilogue, b);
+	// If the size is 1x1, and no stride, and not a tensor view object, no padding, choose GEMM kernel
+	if (w->info.dim[1] == 1 && w->info.dim[2] == 1 && hint.stride.dim[0] <= 1 && hint.stride.dim[1] <= 1 &&
+		hint.border.begin[0] == 0 && hint.border.begin[1] == 0 && hint.border.end[0] == 0 && hint.border.end[1] == 0 &&
+		!CCV_IS_TENSOR_VIEW(a) && !CCV_IS_TENSOR_VIEW(b) && !CCV_IS_TENSOR_VIEW(w) && (!bias || !CCV_IS_TENSOR_VIEW(bias)))
+		return _ccv_nnc_conv_forw_gemm_cpu_opt(a, w, bias, hint, b, epilogue);
+	// Otherwise, if the size is 1x1 (with stride, or a tensor view object), choose the blocked 1x1 kernel
+	if (w->info.dim[1] == 1 && w->info.dim[2] == 1 &&
+		hint.border.begin[0] == 0 && hint.border.begin[1] == 0 && hint.border.end[0] <= 0 && hint.border.end[1] <= 0 &&
+		w->info.dim[0] % 4 == 0)
+		return _ccv_nnc_conv_forw_epilogue(_ccv_nnc_conv_forw_1x1_cpu_opt(a, w, bias, hint, b), epilogue, b);
+	// Otherwise, im2col and use the packed GEMM, it is faster than the direct convolution kernel on all the shapes we tried
+	// (5x5, 7x7 with stride 2, odd number of filters).
+	return _ccv_nnc_conv_forw_gemm_cpu_opt(a, w, bias, hint, b, epilogue);
+}
+
 static int _ccv_nnc_conv_forw(const ccv_nnc_cmd_t cmd, const ccv_nnc_hint_t hint, const int flags, ccv_nnc_tensor_t* const* const inputs, const int input_size, ccv_nnc_tensor_t* const* const outputs, const int output_size, ccv_nnc_stream_context_t* const stream_context)
 {
-	assert(input_size >= 2);
+	// The fused element-wise ops take the last inputs.
+	const int epilogue_input_size = ccv_nnc_cmd_epilogue_input_size(cmd.info);
+	assert(input_size - epilogue_input_size >= 2);
 	const ccv_nnc_tensor_view_t* a = (ccv_nnc_tensor_view_t*)inputs[0];
 	const ccv_nnc_tensor_t* w = inputs[1];
 	assert(!CCV_IS_TENSOR_VIEW(w));
-	const ccv_nnc_tensor_t* bias = input_size > 2 ? inputs[2] : 0;
+	const ccv_nnc_tensor_t* bias = input_size - epilogue_input_size > 2 ? inputs[2] : 0;
 	assert(!bias || !CCV_IS_TENSOR_VIEW(bias));
 	assert(output_size == 1);
 	ccv_nnc_tensor_view_t* b = (ccv_nnc_tensor_view_t*)outputs[0];
@@ -44,36 +117,18 @@ static int _ccv_nnc_conv_forw(const ccv_nnc_cmd_t cmd, const ccv_nnc_hint_t hint
 			break;
 		assert(w->info.dim[i] == cmd.info.size.dim[i - 1]);
 	}
-	switch (cmd.algorithm)
-	{
-		case CCV_NNC_CMD_OPT_CONV_ALGO_DC:
-			return _ccv_nnc_conv_forw_cpu_opt(a, w, bias, hint, b);
-		case CCV_NNC_CMD_OPT_CONV_ALGO_GEMM:
-			if (w->info.dim[1] == 1 && w->info.dim[2] == 1 && hint.stride.dim[0] <= 1 && hint.stride.dim[1] <= 1 &&
-				hint.border.begin[0] == 0 && hint.border.begin[1] == 0 && hint.border.end[0] == 0 && hint.border.end[1] == 0 &&
-				!CCV_IS_TENSOR_VIEW(a) && !CCV_IS_TENSOR_VIEW(b) && !CCV_IS_TENSOR_VIEW(w) && (!bias || !CCV_IS_TENSOR_VIEW(bias)))
-				return _ccv_nnc_conv_forw_gemm_cpu_opt(a, w, bias, hint, b);
-			return CCV_NNC_EXEC_INVALID;
-		case CCV_NNC_CMD_OPT_CONV_ALGO_WINOGRAD:
-			if (w->info.dim[1] == 3 && w->info.dim[2] == 3 && hint.stride.dim[0] <= 1 && hint.stride.dim[1] <= 1)
-				return _ccv_nnc_conv_forw_4x4_3x3_winograd_cpu_opt(a, w, bias, hint, b, stream_context);
-			return CCV_NNC_EXEC_INVALID;
-		case CCV_NNC_CMD_OPT_CONV_ALGO_FFT:
-			return CCV_NNC_EXEC_INVALID; // Placeholder, for fft.
-		case -1:
-			// Pass-through
-			break;
-	}
-	// If the size is 3x3, and no stride, choose Winograd kernel
-	if (w->info.dim[1] == 3 && w->info.dim[2] == 3 && hint.stride.dim[0] <= 1 && hint.stride.dim[1] <= 1)
-		return _ccv_nnc_conv_forw_4x4_3x3_winograd_cpu_opt(a, w, bias, hint, b, stream_context);
-	// If the size is 1x1, and no stride, and not a tensor view object, no padding, choose GEMM kernel
-	if (w->info.dim[1] == 1 && w->info.dim[2] == 1 && hint.stride.dim[0] <= 1 && hint.stride.dim[1] <= 1 &&
-		hint.border.begin[0] == 0 && hint.border.begin[1] == 0 && hint.border.end[0] == 0 && hint.border.end[1] == 0 &&
-		!CCV_IS_TENSOR_VIEW(a) && !CCV_IS_TENSOR_VIEW(b) && !CCV_IS_TENSOR_VIEW(w) && (!bias || !CCV_IS_TENSOR_VIEW(bias)))
-		return _ccv_nnc_conv_forw_gemm_cpu_opt(a, w, bias, hint, b);
-	// Otherwise, use direct convolution kernel
-	return _ccv_nnc_conv_forw_cpu_opt(a, w, bias, hint, b);
+	if (!cmd.info.epilogue.size)
+		return _ccv_nnc_conv_forw_opt(cmd.algorithm, a, w, bias, hint, b, bdim, 0, stream_context);
+	// Not all kernels can apply the epilogue as they go, thus, the output has to be contiguous for the separate pass.
+	if (CCV_IS_TENSOR_VIEW(b))
+		return CCV_NNC_EXEC_INVALID;
+	ccv_nnc_cpu_epilogue_t epilogue;
+	int status = _ccv_nnc_cpu_epilogue_new(cmd.info, inputs + input_size - epilogue_input_size, epilogue_input_size, b, &epilogue);
+	if (status != CCV_NNC_EXEC_SUCCESS)
+		return status;
+	status = _ccv_nnc_conv_forw_opt(cmd.algorithm, a, w, bias, hint, b, bdim, &epilogue, stream_context);
+	_ccv_nnc_cpu_epilogue_free(&epilogue);
+	return status;
 }
 
 REGISTER_COMMAND_BACKEND(CCV_NNC_CONVOLUTION_FORWARD, CCV_NNC_BACKEND_CPU_OPT)(ccv_nnc_cmd_backend_registry_t* const registry)
@@ -82,5 +137,6 @@ REGISTER_COMMAND_BACKEND(CCV_NNC_CONVOLUTION_FORWARD, CCV_NNC_BACKEND_CPU_OPT)(c
 	registry->tensor_datatypes = CCV_32F;
 	registry->tensor_memory = CCV_TENSOR_CPU_MEMORY;
 	registry->algorithms = CCV_NNC_CMD_OPT_CONV_ALGO_COUNT;
+	registry->epilogue = 1;
 	registry->exec = _ccv_nnc_conv_forw;
 }
@@ -45,14 +45,14 @@ static void _ccv_nnc_conv_tensor_auto_forw(const ccv_nnc_cmd_param_t cmd, const
 }
 
 REGISTER_COMMAND(CCV_NNC_CONVOLUTION_FORWARD)(ccv_nnc_cmd_registry_t* const registry)
-	FIND_BACKEND(ccv_nnc_conv_cpu_ref.c, ccv_nnc_conv_cpu_opt.c, gpu/ccv_nnc_conv_gpu_cudnn.cu)
+	FIND_BACKEND(ccv_nnc_conv_cpu_ref.c, ccv_nnc_conv_cpu_opt.c, ccv_nnc_conv_cpu_avx.c, gpu/ccv_nnc_conv_gpu_cudnn.cu)
 {
 	registry->bitmask = _ccv_nnc_conv_forw_bitmask;
 	registry->tensor_auto = _ccv_nnc_conv_tensor_auto_forw;
 }
 
 REGISTER_COMMAND(CCV_NNC_CONVOLUTION_BACKWARD)(ccv_nnc_cmd_registry_t* const registry)
-	FIND_BACKEND(ccv_nnc_conv_cpu_ref.c, ccv_nnc_conv_cpu_opt.c, gpu/ccv_nnc_conv_gpu_cudnn.cu)
+	FIND_BACKEND(ccv_nnc_conv_cpu_ref.c, ccv_nnc_conv_cpu_opt.c, ccv_nnc_conv_cpu_avx.c, gpu/ccv_nnc_conv_gpu_cudnn.cu)
 {
 	registry->bitmask = _ccv_nnc_conv_back_bitmask;
 	registry->tensor_auto = ccv_nnc_hint_tensor_auto_backward_from_inputs;
@@ -0,0 +1,179 @@
+#include <ccv.h>
+#include <ccv_internal.h>
+#include <nnc/ccv_nnc.h>
+#include <nnc/ccv_nnc_easy.h>
+#include <nnc/ccv_nnc_internal.h>
+#ifdef USE_OPENMP
+#include <omp.h>
+#endif
+#ifdef USE_DISPATCH
+#include <dispatch/dispatch.h>
+#endif
+#include "../../_ccv_nnc_cpu_avx.h"
+#ifdef CCV_NNC_CPU_AVX_ENABLED
+#include <immintrin.h>
+#endif
+#include "../_ccv_nnc_conv_cpu_avx.h"
+
+#ifdef CCV_NNC_CPU_AVX_ENABLED
+// Interleave vw output channels together, thus, for each input channel, we can load the weights of vw output channels with one vector load.
+static void _ccv_nnc_xnw(const float* const w, const int* const dim, const int vw, float* const xnw)
+{
+	const int jump_dim = dim[0] / vw;
+	const int wstep = dim[3] * dim[2] * dim[1];
+	parallel_for(k, jump_dim) {
+		int i, x;
+		float* const xnwz = xnw + k * wstep * vw;
+		const float* const wz = w + k * vw * wstep;
+		for (i = 0; i < wstep; i++)
+			for (x = 0; x < vw; x++)
+				xnwz[i * vw + x] = wz[x * wstep + i];
+	} parallel_endfor
+}
+
+typedef void (*ccv_nnc_conv_forw_block_f)(const int k, const float* const xnw, const ccv_nnc_tensor_view_t* const a, const int* const adim, const int* const ainc, const ccv_nnc_tensor_t* const w, const ccv_nnc_tensor_t* const bias, const ccv_nnc_hint_t hint, ccv_nnc_tensor_view_t* const b, const int* const bdim, const int* const binc);
+
+// The block functions are not inlined into the parallel_for body on purpose, the target attribute won't carry over to
+// OpenMP outlined functions or dispatch blocks otherwise.
+CCV_NNC_CPU_AVX2_TARGET
+static void _ccv_nnc_conv_forw_avx2_block(const int k, const float* const xnw, const ccv_nnc_tensor_view_t* const a, const int* const adim, const int* const ainc, const ccv_nnc_tensor_t* const w, const ccv_nnc_tensor_t* const bias, const ccv_nnc_hint_t hint, ccv_nnc_tensor_view_t* const b, const int* const bdim, const int* const binc)
+{
+	int c;
+	const int channel = w->info.dim[3];
+	const float* ap = a->data.f32;
+	float* bp = b->data.f32 + k * 8;
+	// kernel weight for one dim.
+	const float* const x8wp = xnw + k * 8 * w->info.dim[1] * w->info.dim[2] * channel;
+	const __m256 biasval = bias ? _mm256_loadu_ps(bias->data.f32 + k * 8) : _mm256_setzero_ps();
+	int i[CCV_NNC_MAX_DIM];
+	int n[CCV_NNC_MAX_DIM];
+	int m[CCV_NNC_MAX_DIM];
+	int j[CCV_NNC_MAX_DIM];
+	for (i[0] = 0; i[0] < bdim[0]; i[0]++)
+	{
+		SET_BORDER_OFFSET_SIZE_FOR(0, i, hint, w->info.dim + 1, adim, n, m);
+		const float* wpu = x8wp + n[0] * w->info.dim[2] * channel * 8;
+		for (i[1] = 0; i[1] < bdim[1]; i[1]++)
+		{
+			SET_BORDER_OFFSET_SIZE_FOR(1, i, hint, w->info.dim + 1, adim, n, m);
+			__m256 v80 = biasval;
+			__m256 v81 = _mm256_setzero_ps();
+			__m256 v82 = _mm256_setzero_ps();
+			__m256 v83 = _mm256_setzero_ps();
+			const float* wpz = wpu + n[1] * channel * 8;
+			const float* apz = ap + ccv_max(i[1] * hint.stride.dim[1] - hint.border.begin[1], 0) * ainc[2];
+			for (j[0] = 0; j[0] < m[0]; j[0]++)
+			{
+				for (j[1] = 0; j[1] < m[1]; j[1]++)
+				{
+					const float* const apzu = apz + j[1] * ainc[2];
+					const float* const wpzu = wpz + j[1] * channel * 8;
+					for (c = 0; c < channel - 3; c += 4)
+					{
+						v80 = _mm256_fmadd_ps(_mm256_load_ps(wpzu + c * 8), _mm256_broadcast_ss(apzu + c), v80);
+						v81 = _mm256_fmadd_ps(_mm256_load_ps(wpzu + c * 8 + 8), _mm256_broadcast_ss(apzu + c + 1), v81);
+						v82 = _mm256_fmadd_ps(_mm256_load_ps(wpzu + c * 8 + 16), _mm256_broadcast_ss(apzu + c + 2), v82);
+						v83 = _mm256_fmadd_ps(_mm256_load_ps(wpzu + c * 8 + 24), _mm256_broadcast_ss(apzu + c + 3), v83);
+					}
+					for (; c < channel; c++)
+						v80 = _mm256_fmadd_ps(_mm256_load_ps(wpzu + c * 8), _mm256_broadcast_ss(apzu + c), v80);
+				}
+				wpz += w->info.dim[2] * channel * 8;
+				apz += ainc[1] * ainc[2];
+			}
+			_mm256_storeu_ps(bp + i[1] * binc[2], _mm256_add_ps(_mm256_add_ps(v80, v81), _mm256_add_ps(v82, v83)));
+		}
+		bp += binc[1] * binc[2];
+		ap += ainc[1] * ainc[2] * (ccv_max((i[0] + 1) * hint.stride.dim[0] - hint.border.begin[0], 0) - ccv_max(i[0] * hint.stride.dim[0] - hint.border.begin[0], 0));
+	}
+}
+
+CCV_NNC_CPU_AVX512_TARGET
+static void _ccv_nnc_conv_forw_avx512_block(const int k, const float* const xnw, const ccv_nnc_tensor_view_t* const a, const int* const adim, const int* const ainc, const ccv_nnc_tensor_t* const w, const ccv_nnc_tensor_t* const bias, const ccv_nnc_hint_t hint, ccv_nnc_tensor_view_t* const b, const int* const bdim, const int* const binc)
+{
+	int c;
+	const int channel = w->info.dim[3];
+	const float* ap = a->data.f32;
+	float* bp = b->data.f32 + k * 16;
+	// kernel weight for one dim.
+	const float* const x16wp = xnw + k * 16 * w->info.dim[1] * w->info.dim[2] * channel;
+	const __m512 biasval = bias ? _mm512_loadu_ps(bias->data.f32 + k * 16) : _mm512_setzero_ps();
+	int i[CCV_NNC_MAX_DIM];
+	int n[CCV_NNC_MAX_DIM];
+	int m[CCV_NNC_MAX_DIM];
+	int j[CCV_NNC_MAX_DIM];
+	for (i[0] = 0; i[0] < bdim[0]; i[0]++)
+	{
+		SET_BORDER_OFFSET_SIZE_FOR(0, i, hint, w->info.dim + 1, adim, n, m);
+		const float* wpu = x16wp + n[0] * w->info.dim[2] * channel * 16;
+		for (i[1] = 0; i[1] < bdim[1]; i[1]++)
+		{
+			SET_BORDER_OFFSET_SIZE_FOR(1, i, hint, w->info.dim + 1, adim, n, m);
+			__m512 v160 = biasval;
+			__m512 v161 = _mm512_setzero_ps();
+			__m512 v162 = _mm512_setzero_ps();
+			__m512 v163 = _mm512_setzero_ps();
+			const float* wpz = wpu + n[1] * channel * 16;
+			const float* apz = ap + ccv_max(i[1] * hint.stride.dim[1] - hint.border.begin[1], 0) * ainc[2];
+			for (j[0] = 0; j[0] < m[0]; j[0]++)
+			{
+				for (j[1] = 0; j[1] < m[1]; j[1]++)
+				{
+					const float* const apzu = apz + j[1] * ainc[2];
+					const float* const wpzu = wpz + j[1] * channel * 16;
+					for (c = 0; c < channel - 3; c += 4)
+					{
+						v160 = _mm512_fmadd_ps(_mm512_load_ps(wpzu + c * 16), _mm512_set1_ps(apzu[c]), v160);
+						v161 = _mm512_fmadd_ps(_mm512_load_ps(wpzu + c * 16 + 16), _mm512_set1_ps(apzu[c + 1]), v161);
+						v162 = _mm512_fmadd_ps(_mm512_load_ps(wpzu + c * 16 + 32), _mm512_set1_ps(apzu[c + 2]), v162);
+						v163 = _mm512_fmadd_ps(_mm512_load_ps(wpzu + c * 16 + 48), _mm512_set1_ps(apzu[c + 3]), v163);
+					}
+					for (; c < channel; c++)
+						v160 = _mm512_fmadd_ps(_mm512_load_ps(wpzu + c * 16), _mm512_set1_ps(apzu[c]), v160);
+				}
+				wpz += w->info.dim[2] * channel * 16;
+				apz += ainc[1] * ainc[2];
+			}
+			_mm512_storeu_ps(bp + i[1] * binc[2], _mm512_add_ps(_mm512_add_ps(v160, v161), _mm512_add_ps(v162, v163)));
+		}
+		bp += binc[1] * binc[2];
+		ap += ainc[1] * ainc[2] * (ccv_max((i[0] + 1) * hint.stride.dim[0] - hint.border.begin[0], 0) - ccv_max(i[0] * hint.stride.dim[0] - hint.border.begin[0], 0));
+	}
+}
+#endif
+
+int _ccv_nnc_conv_forw_cpu_avx(const ccv_nnc_tensor_view_t* const a, const ccv_nnc_tensor_t* const w, const ccv_nnc_tensor_t* const bias, const ccv_nnc_hint_t hint, ccv_nnc_tensor_view_t* const b)
+{
+#ifdef CCV_NNC_CPU_AVX_ENABLED
+	const int isa = _ccv_nnc_cpu_avx_isa();
+	int vw;
+	ccv_nnc_conv_forw_block_f block;
+	if ((isa & CCV_NNC_CPU_AVX512) && w->info.dim[0] % 16 == 0)
+		vw = 16, block = _ccv_nnc_conv_forw_avx512_block;
+	else if ((isa & CCV_NNC_CPU_AVX2) && w->info.dim[0] % 8 == 0)
+		vw = 8, block = _ccv_nnc_conv_forw_avx2_block;
+	else
+		return CCV_NNC_EXEC_INVALID;
+	const int a_nd = ccv_nnc_tensor_nd(a->info.dim);
+	assert(a_nd == CCV_NNC_MAX_DIM + 1 || a_nd == CCV_NNC_MAX_DIM + 2);
+	const int* adim = (a_nd == CCV_NNC_MAX_DIM + 1) ? a->info.dim : a->info.dim + 1;
+	const int b_nd = ccv_nnc_tensor_nd(b->info.dim);
+	assert(b_nd == CCV_NNC_MAX_DIM + 1 || b_nd == CCV_NNC_MAX_DIM + 2);
+	const int* bdim = (b_nd == CCV_NNC_MAX_DIM + 1) ? b->info.dim : b->info.dim + 1;
+	const int* ainc = CCV_IS_TENSOR_VIEW(a) ? ((a_nd == CCV_NNC_MAX_DIM + 1) ? a->inc : a->inc + 1) : adim;
+	const int* binc = CCV_IS_TENSOR_VIEW(b) ? ((b_nd == CCV_NNC_MAX_DIM + 1) ? b->inc : b->inc + 1) : bdim;
+	float* xnw = 0;
+	ccmemalign((void **)&xnw, 64, sizeof(float) * w->info.dim[3] * w->info.dim[2] * w->info.dim[1] * w->info.dim[0]);
+	if (!xnw)
+		return CCV_NNC_EXEC_OOM;
+	_ccv_nnc_xnw(w->data.f32, w->info.dim, vw, xnw);
+	const int jump_dim = w->info.dim[0] / vw;
+	parallel_for(k, jump_dim) {
+		block(k, xnw, a, adim, ainc, w, bias, hint, b, bdim, binc);
+	} parallel_endfor
+	ccfree(xnw);
+	return CCV_NNC_EXEC_SUCCESS;
+#else
+	return CCV_NNC_EXEC_INVALID;
+#endif
+}
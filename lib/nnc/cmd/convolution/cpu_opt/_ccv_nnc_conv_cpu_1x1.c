@@ -0,0 +1,136 @@
+#include <ccv.h>
+#include <ccv_internal.h>
+#include <nnc/ccv_nnc.h>
+#include <nnc/ccv_nnc_easy.h>
+#include <nnc/ccv_nnc_internal.h>
+#if defined(HAVE_SSE2)
+#include <xmmintrin.h>
+#endif
+#ifdef USE_OPENMP
+#include <omp.h>
+#endif
+#ifdef USE_DISPATCH
+#include <dispatch/dispatch.h>
+#endif
+#include "../_ccv_nnc_conv_cpu_opt.h"
+
+#ifdef HAVE_SSE2
+inline static void _ccv_nnc_x4w_1x1_sse2(const float* const w, const int* const dim, float* x4w)
+{
+	int jump_dim = dim[0] / 4;
+	parallel_for(k, jump_dim) {
+		int j;
+		float* x4wz = x4w + k * dim[3] * 4;
+		const float* const wz = w + k * 4 * dim[3];
+		for (j = 0; j < dim[3]; j++)
+		{
+			x4wz[j * 4] = wz[j];
+			x4wz[j * 4 + 1] = wz[dim[3] + j];
+			x4wz[j * 4 + 2] = wz[dim[3] * 2 + j];
+			x4wz[j * 4 + 3] = wz[dim[3] * 3 + j];
+		}
+	} parallel_endfor
+}
+
+// A 1x1 convolution is a GEMM of the pixels against the weights, thus, we don't need any im2col, just compute
+// 4 pixels against 8 filters at a time so that each weight load is shared by 4 pixels, and each input load is
+// shared by 8 filters. Unlike the ccv_gemm path, it works with strides and tensor views.
+static int _ccv_nnc_conv_forw_1x1_sse2(const ccv_nnc_tensor_view_t* const a, const ccv_nnc_tensor_t* const w, const ccv_nnc_tensor_t* const bias, const ccv_nnc_hint_t hint, ccv_nnc_tensor_view_t* const b)
+{
+	const int a_nd = ccv_nnc_tensor_nd(a->info.dim);
+	assert(a_nd == CCV_NNC_MAX_DIM + 1 || a_nd == CCV_NNC_MAX_DIM + 2);
+	const int* adim = (a_nd == CCV_NNC_MAX_DIM + 1) ? a->info.dim : a->info.dim + 1;
+	const int b_nd = ccv_nnc_tensor_nd(b->info.dim);
+	assert(b_nd == CCV_NNC_MAX_DIM + 1 || b_nd == CCV_NNC_MAX_DIM + 2);
+	const int* bdim = (b_nd == CCV_NNC_MAX_DIM + 1) ? b->info.dim : b->info.dim + 1;
+	const int* ainc = CCV_IS_TENSOR_VIEW(a) ? ((a_nd == CCV_NNC_MAX_DIM + 1) ? a->inc : a->inc + 1) : adim;
+	const int* binc = CCV_IS_TENSOR_VIEW(b) ? ((b_nd == CCV_NNC_MAX_DIM + 1) ? b->inc : b->inc + 1) : bdim;
+	assert(w->info.dim[0] % 4 == 0);
+	assert(w->info.dim[1] == 1 && w->info.dim[2] == 1);
+	assert(hint.border.begin[0] == 0 && hint.border.begin[1] == 0);
+	float* x4w = 0;
+	ccmemalign((void **)&x4w, 16, sizeof(float) * w->info.dim[3] * w->info.dim[0]);
+	if (!x4w)
+		return CCV_NNC_EXEC_OOM;
+	_ccv_nnc_x4w_1x1_sse2(w->data.f32, w->info.dim, x4w);
+	const int stride_s[CCV_NNC_MAX_DIM] = {
+		ccv_max(hint.stride.dim[0], 1), ccv_max(hint.stride.dim[1], 1)
+	};
+	const int* const stride = stride_s;
+	const int channel = adim[2];
+	const int count = w->info.dim[0];
+	parallel_for(i, bdim[0]) {
+		int k, x, c;
+		const float* const ap = a->data.f32 + i * stride[0] * ainc[1] * ainc[2];
+		float* const bp = b->data.f32 + i * binc[1] * binc[2];
+		for (k = 0; k < count; k += 8)
+		{
+			// If there is only 4 filters left, compute them twice and only store once.
+			const int k1 = ccv_min(k + 4, count - 4);
+			const float* const wp0 = x4w + k * channel;
+			const float* const wp1 = x4w + k1 * channel;
+			const __m128 bias40 = bias ? _mm_loadu_ps(bias->data.f32 + k) : _mm_setzero_ps();
+			const __m128 bias41 = bias ? _mm_loadu_ps(bias->data.f32 + k1) : _mm_setzero_ps();
+			for (x = 0; x < bdim[1]; x += 4)
+			{
+				// Similarly, the tail pixels are computed with the last pixel repeated.
+				const int z = ccv_min(bdim[1] - x, 4);
+				const float* const ap0 = ap + x * stride[1] * ainc[2];
+				const float* const ap1 = ap + ccv_min(x + 1, bdim[1] - 1) * stride[1] * ainc[2];
+				const float* const ap2 = ap + ccv_min(x + 2, bdim[1] - 1) * stride[1] * ainc[2];
+				const float* const ap3 = ap + ccv_min(x + 3, bdim[1] - 1) * stride[1] * ainc[2];
+				__m128 v00 = bias40, v01 = bias41;
+				__m128 v10 = bias40, v11 = bias41;
+				__m128 v20 = bias40, v21 = bias41;
+				__m128 v30 = bias40, v31 = bias41;
+				for (c = 0; c < channel; c++)
+				{
+					const __m128 w40 = _mm_load_ps(wp0 + c * 4);
+					const __m128 w41 = _mm_load_ps(wp1 + c * 4);
+					const __m128 a40 = _mm_load1_ps(ap0 + c);
+					const __m128 a41 = _mm_load1_ps(ap1 + c);
+					const __m128 a42 = _mm_load1_ps(ap2 + c);
+					const __m128 a43 = _mm_load1_ps(ap3 + c);
+					v00 = _mm_add_ps(_mm_mul_ps(w40, a40), v00);
+					v01 = _mm_add_ps(_mm_mul_ps(w41, a40), v01);
+					v10 = _mm_add_ps(_mm_mul_ps(w40, a41), v10);
+					v11 = _mm_add_ps(_mm_mul_ps(w41, a41), v11);
+					v20 = _mm_add_ps(_mm_mul_ps(w40, a42), v20);
+					v21 = _mm_add_ps(_mm_mul_ps(w41, a42), v21);
+					v30 = _mm_add_ps(_mm_mul_ps(w40, a43), v30);
+					v31 = _mm_add_ps(_mm_mul_ps(w41, a43), v31);
+				}
+				float* const bpz = bp + x * binc[2];
+				_mm_storeu_ps(bpz + k, v00);
+				_mm_storeu_ps(bpz + k1, v01);
+				if (z > 1)
+				{
+					_mm_storeu_ps(bpz + binc[2] + k, v10);
+					_mm_storeu_ps(bpz + binc[2] + k1, v11);
+				}
+				if (z > 2)
+				{
+					_mm_storeu_ps(bpz + binc[2] * 2 + k, v20);
+					_mm_storeu_ps(bpz + binc[2] * 2 + k1, v21);
+				}
+				if (z > 3)
+				{
+					_mm_storeu_ps(bpz + binc[2] * 3 + k, v30);
+					_mm_storeu_ps(bpz + binc[2] * 3 + k1, v31);
+				}
+			}
+		}
+	} parallel_endfor
+	ccfree(x4w);
+	return CCV_NNC_EXEC_SUCCESS;
+}
+#endif
+
+int _ccv_nnc_conv_forw_1x1_cpu_opt(const ccv_nnc_tensor_view_t* const a, const ccv_nnc_tensor_t* const w, const ccv_nnc_tensor_t* const bias, const ccv_nnc_hint_t hint, ccv_nnc_tensor_view_t* const b)
+{
+#if defined(HAVE_SSE2)
+	if (w->info.dim[0] % 4 == 0)
+		return _ccv_nnc_conv_forw_1x1_sse2(a, w, bias, hint, b);
+#endif
+	return CCV_NNC_EXEC_INVALID;
+}
@@ -123,6 +123,15 @@ inline static void _ccv_nnc_winograd_4x4_3x3_gwtg_ref(const float* const w, cons
 	}
 }
 
+static void _ccv_nnc_winograd_4x4_3x3_gwtg_ref_transform(void* const data, const void* const context)
+{
+	const ccv_nnc_tensor_t* const w = (const ccv_nnc_tensor_t*)context;
+	float* const gwtg = (float*)data;
+	parallel_for(k, w->info.dim[0]) {
+		_ccv_nnc_winograd_4x4_3x3_gwtg_ref(w->data.f32 + k * w->info.dim[3] * w->info.dim[2] * w->info.dim[1], w->info.dim[3], gwtg + k * 36 * w->info.dim[3]);
+	} parallel_endfor
+}
+
 static int _ccv_nnc_conv_forw_4x4_3x3_winograd_ref(const ccv_nnc_tensor_view_t* const a, const ccv_nnc_tensor_t* const w, const ccv_nnc_tensor_t* const bias, const ccv_nnc_hint_t hint, ccv_nnc_tensor_view_t* const b, ccv_nnc_stream_context_t* const stream_context)
 {
 	const int a_nd = ccv_nnc_tensor_nd(a->info.dim);
@@ -138,23 +147,24 @@ static int _ccv_nnc_conv_forw_4x4_3x3_winograd_ref(const ccv_nnc_tensor_view_t*
 	assert(w->info.dim[1] == 3);
 	assert(w->info.dim[2] == 3);
 	const int jump_dim = (bdim[0] + 3) / 4;
+	const int gwtg_size = 36 * w->info.dim[0] * w->info.dim[3];
+	const float* const kept_gwtg = _ccv_nnc_conv_cpu_opt_weights(w, "_ccv_nnc_winograd_4x4_3x3_gwtg_ref", gwtg_size, _ccv_nnc_winograd_4x4_3x3_gwtg_ref_transform);
 	float* workmem;
 	// allocating workspace memory for kernel reshaping and input reshaping.
 #if FOR_IS_PARALLEL
 	// If we do parallel for, we need to allocate input reshaping for each block.
-	workmem = ccv_nnc_stream_context_get_workspace(stream_context, sizeof(float) * (36 * adim[2] * jump_dim + 36 * w->info.dim[0] * w->info.dim[3]), CCV_TENSOR_CPU_MEMORY);
+	workmem = ccv_nnc_stream_context_get_workspace(stream_context, sizeof(float) * (36 * adim[2] * jump_dim + (kept_gwtg ? 0 : gwtg_size)), CCV_TENSOR_CPU_MEMORY);
 #else
 	// Otherwise, just one block.
-	workmem = ccv_nnc_stream_context_get_workspace(stream_context, sizeof(float) * (36 * adim[2] + 36 * w->info.dim[0] * w->info.dim[3]), CCV_TENSOR_CPU_MEMORY);
+	workmem = ccv_nnc_stream_context_get_workspace(stream_context, sizeof(float) * (36 * adim[2] + (kept_gwtg ? 0 : gwtg_size)), CCV_TENSOR_CPU_MEMORY);
 #endif
 	if (!workmem)
 		return CCV_NNC_EXEC_OOM;
 	// Convert w to a 6x6 matrix, by computing G.w.T(G) // T for transpose.
-	float* const gwtg = workmem;
-	float* const btdb = workmem + 36 * w->info.dim[0] * w->info.dim[3];
-	parallel_for(k, w->info.dim[0]) {
-		_ccv_nnc_winograd_4x4_3x3_gwtg_ref(w->data.f32 + k * w->info.dim[3] * w->info.dim[2] * w->info.dim[1], w->info.dim[3], gwtg + k * 36 * w->info.dim[3]);
-	} parallel_endfor
+	const float* const gwtg = kept_gwtg ? kept_gwtg : workmem;
+	float* const btdb = kept_gwtg ? workmem : workmem + gwtg_size;
+	if (!kept_gwtg)
+		_ccv_nnc_winograd_4x4_3x3_gwtg_ref_transform(workmem, w);
 	// kernel weight for one dim.
 	// Workaround issues of dispatch_apply (cannot reference to on-stack array)
 	const int tile_dim_s[CCV_NNC_MAX_DIM_ALLOC] = {
@@ -624,6 +634,14 @@ inline static void _ccv_nnc_winograd_4x4_3x3_gwtg_sse2(const float* const w, con
 	} parallel_endfor
 }
 
+static void _ccv_nnc_winograd_4x4_3x3_gwtg_sse2_transform(void* const data, const void* const context)
+{
+	const ccv_nnc_tensor_t* const w = (const ccv_nnc_tensor_t*)context;
+	const int dimCx4 = (w->info.dim[3] + 3) & -4;
+	memset(data, 0, sizeof(float) * 36 * dimCx4 * w->info.dim[0]);
+	_ccv_nnc_winograd_4x4_3x3_gwtg_sse2(w->data.f32, w->info.dim, (float*)data);
+}
+
 static int _ccv_nnc_conv_forw_4x4_3x3_winograd_sse2(const ccv_nnc_tensor_view_t* const a, const ccv_nnc_tensor_t* const w, const ccv_nnc_tensor_t* const bias, const ccv_nnc_hint_t hint, ccv_nnc_tensor_view_t* const b, ccv_nnc_stream_context_t* const stream_context)
 {
 	const int a_nd = ccv_nnc_tensor_nd(a->info.dim);
@@ -642,21 +660,23 @@ static int _ccv_nnc_conv_forw_4x4_3x3_winograd_sse2(const ccv_nnc_tensor_view_t*
 	const int jump_dim = (bdim[0] + 3) / 4;
 	const int dimCx4 = (adim[2] + 3) & -4;
 	// allocating workspace memory for kernel reshaping and input reshaping.
+	const int gwtg_size = 36 * dimCx4 * w->info.dim[0];
+	const float* const kept_gwtg = _ccv_nnc_conv_cpu_opt_weights(w, "_ccv_nnc_winograd_4x4_3x3_gwtg_sse2", gwtg_size, _ccv_nnc_winograd_4x4_3x3_gwtg_sse2_transform);
 	float* workmem = 0;
 #if FOR_IS_PARALLEL
 	// If we do parallel for, we need to allocate input reshaping for each block.
-	workmem = ccv_nnc_stream_context_get_workspace(stream_context, sizeof(float) * (36 * dimCx4 * jump_dim + 36 * dimCx4 * w->info.dim[0]), CCV_TENSOR_CPU_MEMORY);
+	workmem = ccv_nnc_stream_context_get_workspace(stream_context, sizeof(float) * (36 * dimCx4 * jump_dim + (kept_gwtg ? 0 : gwtg_size)), CCV_TENSOR_CPU_MEMORY);
 #else
 	// Otherwise, just one block.
-	workmem = ccv_nnc_stream_context_get_workspace(stream_context, sizeof(float) * (36 * dimCx4 + 36 * dimCx4 * w->info.dim[0]), CCV_TENSOR_CPU_MEMORY);
+	workmem = ccv_nnc_stream_context_get_workspace(stream_context, sizeof(float) * (36 * dimCx4 + (kept_gwtg ? 0 : gwtg_size)), CCV_TENSOR_CPU_MEMORY);
 #endif
 	if (!workmem)
 		return CCV_NNC_EXEC_OOM;
 	// Convert w to a 6x6 matrix, by computing G.w.T(G) // T for transpose.
-	float* const gwtg = workmem;
-	float* const btdb = workmem + 36 * dimCx4 * w->info.dim[0];
-	memset(gwtg, 0, sizeof(float) * 36 * dimCx4 * w->info.dim[0]);
-	_ccv_nnc_winograd_4x4_3x3_gwtg_sse2(w->data.f32, w->info.dim, gwtg);
+	const float* const gwtg = kept_gwtg ? kept_gwtg : workmem;
+	float* const btdb = kept_gwtg ? workmem : workmem + gwtg_size;
+	if (!kept_gwtg)
+		_ccv_nnc_winograd_4x4_3x3_gwtg_sse2_transform(workmem, w);
 	// kernel weight for one dim.
 	// Workaround issues of dispatch_apply (cannot reference to on-stack array)
 	const int tile_dim_s[CCV_NNC_MAX_DIM_ALLOC] = {
@@ -1304,6 +1324,14 @@ inline static void _ccv_nnc_winograd_4x4_3x3_gwtg_neon(const float* const w, con
 	} parallel_endfor
 }
 
+static void _ccv_nnc_winograd_4x4_3x3_gwtg_neon_transform(void* const data, const void* const context)
+{
+	const ccv_nnc_tensor_t* const w = (const ccv_nnc_tensor_t*)context;
+	const int dimCx4 = (w->info.dim[3] + 3) & -4;
+	memset(data, 0, sizeof(float) * 36 * dimCx4 * w->info.dim[0]);
+	_ccv_nnc_winograd_4x4_3x3_gwtg_neon(w->data.f32, w->info.dim, (float*)data);
+}
+
 static int _ccv_nnc_conv_forw_4x4_3x3_winograd_neon(const ccv_nnc_tensor_view_t* const a, const ccv_nnc_tensor_t* const w, const ccv_nnc_tensor_t* const bias, const ccv_nnc_hint_t hint, ccv_nnc_tensor_view_t* const b, ccv_nnc_stream_context_t* const stream_context)
 {
 	const int a_nd = ccv_nnc_tensor_nd(a->info.dim);
@@ -1322,21 +1350,23 @@ static int _ccv_nnc_conv_forw_4x4_3x3_winograd_neon(const ccv_nnc_tensor_view_t*
 	const int jump_dim = (bdim[0] + 3) / 4;
 	const int dimCx4 = (adim[2] + 3) & -4;
 	// allocating workspace memory for kernel reshaping and input reshaping.
+	const int gwtg_size = 36 * dimCx4 * w->info.dim[0];
+	const float* const kept_gwtg = _ccv_nnc_conv_cpu_opt_weights(w, "_ccv_nnc_winograd_4x4_3x3_gwtg_neon", gwtg_size, _ccv_nnc_winograd_4x4_3x3_gwtg_neon_transform);
 	float* workmem = 0;
 #if FOR_IS_PARALLEL
 	// If we do parallel for, we need to allocate input reshaping for each block.
-	workmem = (float*)ccv_nnc_stream_context_get_workspace(stream_context, sizeof(float) * (36 * dimCx4 * jump_dim + 36 * dimCx4 * w->info.dim[0]), CCV_TENSOR_CPU_MEMORY);
+	workmem = (float*)ccv_nnc_stream_context_get_workspace(stream_context, sizeof(float) * (36 * dimCx4 * jump_dim + (kept_gwtg ? 0 : gwtg_size)), CCV_TENSOR_CPU_MEMORY);
 #else
 	// Otherwise, just one block.
-	workmem = (float*)ccv_nnc_stream_context_get_workspace(stream_context, sizeof(float) * (36 * dimCx4 + 36 * dimCx4 * w->info.dim[0]), CCV_TENSOR_CPU_MEMORY);
+	workmem = (float*)ccv_nnc_stream_context_get_workspace(stream_context, sizeof(float) * (36 * dimCx4 + (kept_gwtg ? 0 : gwtg_size)), CCV_TENSOR_CPU_MEMORY);
 #endif
 	if (!workmem)
 		return CCV_NNC_EXEC_OOM;
 	// Convert w to a 6x6 matrix, by computing G.w.T(G) // T for transpose.
-	float* const gwtg = workmem;
-	float* const btdb = workmem + 36 * dimCx4 * w->info.dim[0];
-	memset(gwtg, 0, sizeof(float) * 36 * dimCx4 * w->info.dim[0]);
-	_ccv_nnc_winograd_4x4_3x3_gwtg_neon(w->data.f32, w->info.dim, gwtg);
+	const float* const gwtg = kept_gwtg ? kept_gwtg : workmem;
+	float* const btdb = kept_gwtg ? workmem : workmem + gwtg_size;
+	if (!kept_gwtg)
+		_ccv_nnc_winograd_4x4_3x3_gwtg_neon_transform(workmem, w);
 	// kernel weight for one dim.
 	// Workaround issues of dispatch_apply (cannot reference to on-stack array)
 	const int tile_dim_s[CCV_NNC_MAX_DIM_ALLOC] = {
@@ -0,0 +1,580 @@
+#include <ccv.h>
+#include <ccv_internal.h>
+#include <nnc/ccv_nnc.h>
+#include <nnc/ccv_nnc_easy.h>
+#include <nnc/ccv_nnc_internal.h>
+#if defined(HAVE_SSE2)
+#include <xmmintrin.h>
+#endif
+#ifdef USE_OPENMP
+#include <omp.h>
+#endif
+#ifdef USE_DISPATCH
+#include <dispatch/dispatch.h>
+#endif
+#include "../_ccv_nnc_conv_cpu_opt.h"
+
+#define set_n_m_dim(i, x, wd, ad) \
+	do { \
+		n[x] = ccv_max((i) * hint.stride.dim[x] - hint.border.begin[x], 0) - ((i) * hint.stride.dim[x] - hint.border.begin[x]); \
+		m[x] = wd[x + 1] - n[x] - ((i) * hint.stride.dim[x] - hint.border.begin[x] + wd[x + 1] - ccv_min(ad[x], (i) * hint.stride.dim[x] - hint.border.begin[x] + wd[x + 1])); \
+	} while (0)
+
+/*
+ * F(6x6, 3x3) computes a 6x6 output tile from an 8x8 input tile with 64 multiplications per channel, versus
+ * 36 for a 4x4 output tile with F(4x4, 3x3). It pays off on large feature maps where there are fewer tiles
+ * to transform. Interpolation points are 0, 1, -1, 2, -2, 1/2, -1/2 and infinity:
+ * BT = {{1, 0, -21/4, 0, 21/4, 0, -1, 0},
+ *       {0, 1, 1, -17/4, -17/4, 1, 1, 0},
+ *       {0, -1, 1, 17/4, -17/4, -1, 1, 0},
+ *       {0, 1/2, 1/4, -5/2, -5/4, 2, 1, 0},
+ *       {0, -1/2, 1/4, 5/2, -5/4, -2, 1, 0},
+ *       {0, 2, 4, -5/2, -5, 1/2, 1, 0},
+ *       {0, -2, 4, 5/2, -5, -1/2, 1, 0},
+ *       {0, -1, 0, 21/4, 0, -21/4, 0, 1}}
+ * G = {{1, 0, 0},
+ *      {-2/9, -2/9, -2/9},
+ *      {-2/9, 2/9, -2/9},
+ *      {1/90, 1/45, 2/45},
+ *      {1/90, -1/45, 2/45},
+ *      {32/45, 16/45, 8/45},
+ *      {32/45, -16/45, 8/45},
+ *      {0, 0, 1}}
+ * AT = {{1, 1, 1, 1, 1, 1, 1, 0},
+ *       {0, 1, -1, 2, -2, 1/2, -1/2, 0},
+ *       {0, 1, 1, 4, 4, 1/4, 1/4, 0},
+ *       {0, 1, -1, 8, -8, 1/8, -1/8, 0},
+ *       {0, 1, 1, 16, 16, 1/16, 1/16, 0},
+ *       {0, 1, -1, 32, -32, 1/32, -1/32, 1}}
+ */
+
+/* BT.d for one column (or one row) of 8. */
+#define winograd_6x6_3x3_bt(d, r) \
+	do { \
+		const float e0 = d[2] + d[6] - 4.25 * d[4]; \
+		const float o0 = d[1] + d[5] - 4.25 * d[3]; \
+		const float e1 = d[6] + 0.25 * d[2] - 1.25 * d[4]; \
+		const float o1 = 0.5 * d[1] - 2.5 * d[3] + 2 * d[5]; \
+		const float e2 = d[6] + 4 * d[2] - 5 * d[4]; \
+		const float o2 = 2 * d[1] - 2.5 * d[3] + 0.5 * d[5]; \
+		r[0] = d[0] - d[6] + 5.25 * (d[4] - d[2]); \
+		r[1] = e0 + o0; \
+		r[2] = e0 - o0; \
+		r[3] = e1 + o1; \
+		r[4] = e1 - o1; \
+		r[5] = e2 + o2; \
+		r[6] = e2 - o2; \
+		r[7] = d[7] - d[1] + 5.25 * (d[3] - d[5]); \
+	} while (0)
+
+/* G.g for one column (or one row) of 3. */
+#define winograd_6x6_3x3_g(g, r) \
+	do { \
+		const float s0 = g[0] + g[2]; \
+		r[0] = g[0]; \
+		r[1] = -2.0 / 9 * (s0 + g[1]); \
+		r[2] = -2.0 / 9 * (s0 - g[1]); \
+		const float s1 = 1.0 / 90 * g[0] + 2.0 / 45 * g[2]; \
+		r[3] = s1 + 1.0 / 45 * g[1]; \
+		r[4] = s1 - 1.0 / 45 * g[1]; \
+		const float s2 = 32.0 / 45 * g[0] + 8.0 / 45 * g[2]; \
+		r[5] = s2 + 16.0 / 45 * g[1]; \
+		r[6] = s2 - 16.0 / 45 * g[1]; \
+		r[7] = g[2]; \
+	} while (0)
+
+/* AT.m for one column (or one row) of 8. */
+#define winograd_6x6_3x3_at(m, r) \
+	do { \
+		const float s1 = m[1] + m[2]; \
+		const float d1 = m[1] - m[2]; \
+		const float s2 = m[3] + m[4]; \
+		const float d2 = m[3] - m[4]; \
+		const float s3 = m[5] + m[6]; \
+		const float d3 = m[5] - m[6]; \
+		r[0] = m[0] + s1 + s2 + s3; \
+		r[1] = d1 + 2 * d2 + 0.5 * d3; \
+		r[2] = s1 + 4 * s2 + 0.25 * s3; \
+		r[3] = d1 + 8 * d2 + 0.125 * d3; \
+		r[4] = s1 + 16 * s2 + 0.0625 * s3; \
+		r[5] = d1 + 32 * d2 + 0.03125 * d3 + m[7]; \
+	} while (0)
+
+inline static void _ccv_nnc_winograd_6x6_3x3_gwtg_ref(const float* const w, const int c, float* gwtg)
+{
+	int i, j, k;
+	for (i = 0; i < c; i++)
+	{
+		float gw[24];
+		/* G.w */
+		for (j = 0; j < 3; j++)
+		{
+			const float g[] = {
+				w[j * c + i], w[(3 + j) * c + i], w[(6 + j) * c + i]
+			};
+			float r[8];
+			winograd_6x6_3x3_g(g, r);
+			for (k = 0; k < 8; k++)
+				gw[k * 3 + j] = r[k];
+		}
+		/* G.w.T(G) */
+		for (j = 0; j < 8; j++)
+		{
+			const float* const g = gw + j * 3;
+			float r[8];
+			winograd_6x6_3x3_g(g, r);
+			for (k = 0; k < 8; k++)
+				gwtg[(j * 8 + k) * c] = r[k];
+		}
+		++gwtg;
+	}
+}
+
+static void _ccv_nnc_winograd_6x6_3x3_gwtg_ref_transform(void* const data, const void* const context)
+{
+	const ccv_nnc_tensor_t* const w = (const ccv_nnc_tensor_t*)context;
+	float* const gwtg = (float*)data;
+	parallel_for(k, w->info.dim[0]) {
+		_ccv_nnc_winograd_6x6_3x3_gwtg_ref(w->data.f32 + k * w->info.dim[3] * w->info.dim[2] * w->info.dim[1], w->info.dim[3], gwtg + k * 64 * w->info.dim[3]);
+	} parallel_endfor
+}
+
+static int _ccv_nnc_conv_forw_6x6_3x3_winograd_ref(const ccv_nnc_tensor_view_t* const a, const ccv_nnc_tensor_t* const w, const ccv_nnc_tensor_t* const bias, const ccv_nnc_hint_t hint, ccv_nnc_tensor_view_t* const b, ccv_nnc_stream_context_t* const stream_context)
+{
+	const int a_nd = ccv_nnc_tensor_nd(a->info.dim);
+	assert(a_nd == CCV_NNC_MAX_DIM + 1 || a_nd == CCV_NNC_MAX_DIM + 2);
+	const int* adim = (a_nd == CCV_NNC_MAX_DIM + 1) ? a->info.dim : a->info.dim + 1;
+	const int b_nd = ccv_nnc_tensor_nd(b->info.dim);
+	assert(b_nd == CCV_NNC_MAX_DIM + 1 || b_nd == CCV_NNC_MAX_DIM + 2);
+	const int* bdim = (b_nd == CCV_NNC_MAX_DIM + 1) ? b->info.dim : b->info.dim + 1;
+	const int* ainc = CCV_IS_TENSOR_VIEW(a) ? ((a_nd == CCV_NNC_MAX_DIM + 1) ? a->inc : a->inc + 1) : adim;
+	const int* binc = CCV_IS_TENSOR_VIEW(b) ? ((b_nd == CCV_NNC_MAX_DIM + 1) ? b->inc : b->inc + 1) : bdim;
+	assert(hint.border.begin[0] <= 1);
+	assert(hint.border.begin[1] <= 1);
+	assert(w->info.dim[1] == 3);
+	assert(w->info.dim[2] == 3);
+	const int jump_dim = (bdim[0] + 5) / 6;
+	const int gwtg_size = 64 * w->info.dim[0] * w->info.dim[3];
+	const float* const kept_gwtg = _ccv_nnc_conv_cpu_opt_weights(w, "_ccv_nnc_winograd_6x6_3x3_gwtg_ref", gwtg_size, _ccv_nnc_winograd_6x6_3x3_gwtg_ref_transform);
+	float* workmem;
+	// allocating workspace memory for kernel reshaping and input reshaping.
+#if FOR_IS_PARALLEL
+	// If we do parallel for, we need to allocate input reshaping for each block.
+	workmem = ccv_nnc_stream_context_get_workspace(stream_context, sizeof(float) * (64 * adim[2] * jump_dim + (kept_gwtg ? 0 : gwtg_size)), CCV_TENSOR_CPU_MEMORY);
+#else
+	// Otherwise, just one block.
+	workmem = ccv_nnc_stream_context_get_workspace(stream_context, sizeof(float) * (64 * adim[2] + (kept_gwtg ? 0 : gwtg_size)), CCV_TENSOR_CPU_MEMORY);
+#endif
+	if (!workmem)
+		return CCV_NNC_EXEC_OOM;
+	// Convert w to a 8x8 matrix, by computing G.w.T(G) // T for transpose.
+	const float* const gwtg = kept_gwtg ? kept_gwtg : workmem;
+	float* const btdb = kept_gwtg ? workmem : workmem + gwtg_size;
+	if (!kept_gwtg)
+		_ccv_nnc_winograd_6x6_3x3_gwtg_ref_transform(workmem, w);
+	// Workaround issues of dispatch_apply (cannot reference to on-stack array)
+	const int tile_dim_s[CCV_NNC_MAX_DIM_ALLOC] = {
+		w->info.dim[0], 8, 8, w->info.dim[3]
+	};
+	const int* const tile_dim = tile_dim_s;
+	const float* const biasval = bias ? bias->data.f32 : 0;
+	parallel_for(i, jump_dim) {
+		const int y = i * 6; // i is unsigned.
+		int j, x, k, c;
+		int n[CCV_NNC_MAX_DIM];
+		int m[CCV_NNC_MAX_DIM];
+		int z[CCV_NNC_MAX_DIM];
+		set_n_m_dim(y, 0, tile_dim, adim);
+		z[0] = ccv_min(y + 6, bdim[0]) - y;
+		const float* ap = a->data.f32 + ccv_max(y - hint.border.begin[0], 0) * ainc[1] * ainc[2];
+		float* bp = b->data.f32 + y * binc[1] * binc[2];
+		for (x = 0; x < bdim[1]; x += 6)
+		{
+			set_n_m_dim(x, 1, tile_dim, adim);
+			z[1] = ccv_min(x + 6, bdim[1]) - x;
+#if FOR_IS_PARALLEL
+			float* g = btdb + i * 64 * adim[2];
+#else
+			float* g = btdb;
+#endif
+			// zero g such that we can have zero-padding.
+			memset(g, 0, sizeof(float) * 64 * adim[2]);
+			int dx, dy;
+			const float* apz = ap + ccv_max(x - hint.border.begin[1], 0) * ainc[2];
+			float* gz = g + (n[0] * 8 + n[1]) * adim[2];
+			for (dy = 0; dy < m[0]; dy++)
+			{
+				for (dx = 0; dx < m[1]; dx++)
+				{
+					float* const gzu = gz + (dy * 8 + dx) * adim[2];
+					for (c = 0; c < adim[2]; c++)
+						gzu[c] = apz[dx * ainc[2] + c];
+				}
+				apz += ainc[1] * ainc[2];
+			}
+			for (c = 0; c < adim[2]; c++)
+			{
+				float d[64];
+				/* BT.d */
+				for (j = 0; j < 8; j++)
+				{
+					float dc[8], r[8];
+					for (k = 0; k < 8; k++)
+						dc[k] = g[(k * 8 + j) * adim[2]];
+					winograd_6x6_3x3_bt(dc, r);
+					for (k = 0; k < 8; k++)
+						d[k * 8 + j] = r[k];
+				}
+				/* BT.d.B */
+				for (j = 0; j < 8; j++)
+				{
+					float r[8];
+					const float* const dz = d + j * 8;
+					winograd_6x6_3x3_bt(dz, r);
+					for (k = 0; k < 8; k++)
+						g[(j * 8 + k) * adim[2]] = r[k];
+				}
+				// move to the next channel
+				++g;
+			}
+			const float* wpz = gwtg;
+			for (k = 0; k < w->info.dim[0]; k++)
+			{
+				float q[64];
+#if FOR_IS_PARALLEL
+				g = btdb + i * 64 * adim[2];
+#else
+				g = btdb;
+#endif
+				for (j = 0; j < 64; j++)
+				{
+					float v = 0;
+					for (c = 0; c < adim[2]; c++)
+						v += g[c] * wpz[c];
+					q[j] = v;
+					g += adim[2];
+					wpz += adim[2];
+				}
+				/* AT.q */
+				float d[48];
+				for (j = 0; j < 8; j++)
+				{
+					float qc[8], r[6];
+					for (c = 0; c < 8; c++)
+						qc[c] = q[c * 8 + j];
+					winograd_6x6_3x3_at(qc, r);
+					for (c = 0; c < 6; c++)
+						d[c * 8 + j] = r[c];
+				}
+				/* AT.q.A */
+				float* bpz = bp + x * binc[2] + k;
+				const float bk = biasval ? biasval[k] : 0;
+				for (dy = 0; dy < z[0]; dy++)
+				{
+					float r[6];
+					const float* const dz = d + dy * 8;
+					winograd_6x6_3x3_at(dz, r);
+					for (dx = 0; dx < z[1]; dx++)
+						bpz[dx * binc[2]] = r[dx] + bk;
+					bpz += binc[1] * binc[2];
+				}
+			}
+		}
+	} parallel_endfor
+	return CCV_NNC_EXEC_SUCCESS;
+}
+
+#ifdef HAVE_SSE2
+/* The same transforms with 4 channels (or 4 filters) at a time. */
+inline static void _ccv_nnc_winograd_6x6_3x3_bt_sse2(const __m128* const d, __m128* const r)
+{
+	const __m128 c4_25 = _mm_set1_ps(4.25);
+	const __m128 c5_25 = _mm_set1_ps(5.25);
+	const __m128 c0_25 = _mm_set1_ps(0.25);
+	const __m128 c1_25 = _mm_set1_ps(1.25);
+	const __m128 c0_5 = _mm_set1_ps(0.5);
+	const __m128 c2_5 = _mm_set1_ps(2.5);
+	const __m128 c2 = _mm_set1_ps(2);
+	const __m128 c4 = _mm_set1_ps(4);
+	const __m128 c5 = _mm_set1_ps(5);
+	const __m128 e0 = _mm_sub_ps(_mm_add_ps(d[2], d[6]), _mm_mul_ps(c4_25, d[4]));
+	const __m128 o0 = _mm_sub_ps(_mm_add_ps(d[1], d[5]), _mm_mul_ps(c4_25, d[3]));
+	const __m128 e1 = _mm_sub_ps(_mm_add_ps(d[6], _mm_mul_ps(c0_25, d[2])), _mm_mul_ps(c1_25, d[4]));
+	const __m128 o1 = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(c0_5, d[1]), _mm_mul_ps(c2_5, d[3])), _mm_mul_ps(c2, d[5]));
+	const __m128 e2 = _mm_sub_ps(_mm_add_ps(d[6], _mm_mul_ps(c4, d[2])), _mm_mul_ps(c5, d[4]));
+	const __m128 o2 = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(c2, d[1]), _mm_mul_ps(c2_5, d[3])), _mm_mul_ps(c0_5, d[5]));
+	r[0] = _mm_add_ps(_mm_sub_ps(d[0], d[6]), _mm_mul_ps(c5_25, _mm_sub_ps(d[4], d[2])));
+	r[1] = _mm_add_ps(e0, o0);
+	r[2] = _mm_sub_ps(e0, o0);
+	r[3] = _mm_add_ps(e1, o1);
+	r[4] = _mm_sub_ps(e1, o1);
+	r[5] = _mm_add_ps(e2, o2);
+	r[6] = _mm_sub_ps(e2, o2);
+	r[7] = _mm_add_ps(_mm_sub_ps(d[7], d[1]), _mm_mul_ps(c5_25, _mm_sub_ps(d[3], d[5])));
+}
+
+inline static void _ccv_nnc_winograd_6x6_3x3_g_sse2(const __m128* const g, __m128* const r)
+{
+	const __m128 s0 = _mm_add_ps(g[0], g[2]);
+	const __m128 cn2_9 = _mm_set1_ps(-2.0 / 9);
+	r[0] = g[0];
+	r[1] = _mm_mul_ps(cn2_9, _mm_add_ps(s0, g[1]));
+	r[2] = _mm_mul_ps(cn2_9, _mm_sub_ps(s0, g[1]));
+	const __m128 s1 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(1.0 / 90), g[0]), _mm_mul_ps(_mm_set1_ps(2.0 / 45), g[2]));
+	const __m128 g1_45 = _mm_mul_ps(_mm_set1_ps(1.0 / 45), g[1]);
+	r[3] = _mm_add_ps(s1, g1_45);
+	r[4] = _mm_sub_ps(s1, g1_45);
+	const __m128 s2 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(32.0 / 45), g[0]), _mm_mul_ps(_mm_set1_ps(8.0 / 45), g[2]));
+	const __m128 g16_45 = _mm_mul_ps(_mm_set1_ps(16.0 / 45), g[1]);
+	r[5] = _mm_add_ps(s2, g16_45);
+	r[6] = _mm_sub_ps(s2, g16_45);
+	r[7] = g[2];
+}
+
+inline static void _ccv_nnc_winograd_6x6_3x3_at_sse2(const __m128* const m, __m128* const r)
+{
+	const __m128 s1 = _mm_add_ps(m[1], m[2]);
+	const __m128 d1 = _mm_sub_ps(m[1], m[2]);
+	const __m128 s2 = _mm_add_ps(m[3], m[4]);
+	const __m128 d2 = _mm_sub_ps(m[3], m[4]);
+	const __m128 s3 = _mm_add_ps(m[5], m[6]);
+	const __m128 d3 = _mm_sub_ps(m[5], m[6]);
+	r[0] = _mm_add_ps(_mm_add_ps(m[0], s1), _mm_add_ps(s2, s3));
+	r[1] = _mm_add_ps(_mm_add_ps(d1, _mm_mul_ps(_mm_set1_ps(2), d2)), _mm_mul_ps(_mm_set1_ps(0.5), d3));
+	r[2] = _mm_add_ps(_mm_add_ps(s1, _mm_mul_ps(_mm_set1_ps(4), s2)), _mm_mul_ps(_mm_set1_ps(0.25), s3));
+	r[3] = _mm_add_ps(_mm_add_ps(d1, _mm_mul_ps(_mm_set1_ps(8), d2)), _mm_mul_ps(_mm_set1_ps(0.125), d3));
+	r[4] = _mm_add_ps(_mm_add_ps(s1, _mm_mul_ps(_mm_set1_ps(16), s2)), _mm_mul_ps(_mm_set1_ps(0.0625), s3));
+	r[5] = _mm_add_ps(_mm_add_ps(_mm_add_ps(d1, _mm_mul_ps(_mm_set1_ps(32), d2)), _mm_mul_ps(_mm_set1_ps(0.03125), d3)), m[7]);
+}
+
+inline static void _ccv_nnc_winograd_6x6_3x3_gwtg_sse2(const float* const w, const int* const dim, float* const gwtg)
+{
+	const int jump_dim = dim[0] / 4;
+	const int dimCx4 = (dim[3] + 3) & -4;
+	parallel_for(k, jump_dim) {
+		int i, j, l;
+		float* gwtgz = gwtg + k * 4 * 64 * dimCx4;
+		const float* wz[] = {
+			w + (k * 4) * 9 * dim[3],
+			w + (k * 4 + 1) * 9 * dim[3],
+			w + (k * 4 + 2) * 9 * dim[3],
+			w + (k * 4 + 3) * 9 * dim[3],
+		};
+		for (i = 0; i < dim[3]; i++)
+		{
+			__m128 x9w[9];
+			unroll_for(j, 9) {
+				x9w[j] = _mm_setr_ps(wz[0][j * dim[3] + i], wz[1][j * dim[3] + i], wz[2][j * dim[3] + i], wz[3][j * dim[3] + i]);
+			} unroll_endfor
+			/* G.w */
+			__m128 gw[24];
+			for (j = 0; j < 3; j++)
+			{
+				const __m128 g[] = {
+					x9w[j], x9w[3 + j], x9w[6 + j]
+				};
+				__m128 r[8];
+				_ccv_nnc_winograd_6x6_3x3_g_sse2(g, r);
+				for (l = 0; l < 8; l++)
+					gw[l * 3 + j] = r[l];
+			}
+			/* G.w.T(G) */
+			for (j = 0; j < 8; j++)
+			{
+				__m128 r[8];
+				_ccv_nnc_winograd_6x6_3x3_g_sse2(gw + j * 3, r);
+				for (l = 0; l < 8; l++)
+					_mm_store_ps(gwtgz + (j * 8 + l) * 4 * dimCx4, r[l]);
+			}
+			gwtgz += 4;
+		}
+	} parallel_endfor
+}
+
+static void _ccv_nnc_winograd_6x6_3x3_gwtg_sse2_transform(void* const data, const void* const context)
+{
+	const ccv_nnc_tensor_t* const w = (const ccv_nnc_tensor_t*)context;
+	const int dimCx4 = (w->info.dim[3] + 3) & -4;
+	memset(data, 0, sizeof(float) * 64 * dimCx4 * w->info.dim[0]);
+	_ccv_nnc_winograd_6x6_3x3_gwtg_sse2(w->data.f32, w->info.dim, (float*)data);
+}
+
+static int _ccv_nnc_conv_forw_6x6_3x3_winograd_sse2(const ccv_nnc_tensor_view_t* const a, const ccv_nnc_tensor_t* const w, const ccv_nnc_tensor_t* const bias, const ccv_nnc_hint_t hint, ccv_nnc_tensor_view_t* const b, ccv_nnc_stream_context_t* const stream_context)
+{
+	const int a_nd = ccv_nnc_tensor_nd(a->info.dim);
+	assert(a_nd == CCV_NNC_MAX_DIM + 1 || a_nd == CCV_NNC_MAX_DIM + 2);
+	const int* adim = (a_nd == CCV_NNC_MAX_DIM + 1) ? a->info.dim : a->info.dim + 1;
+	const int b_nd = ccv_nnc_tensor_nd(b->info.dim);
+	assert(b_nd == CCV_NNC_MAX_DIM + 1 || b_nd == CCV_NNC_MAX_DIM + 2);
+	const int* bdim = (b_nd == CCV_NNC_MAX_DIM + 1) ? b->info.dim : b->info.dim + 1;
+	const int* ainc = CCV_IS_TENSOR_VIEW(a) ? ((a_nd == CCV_NNC_MAX_DIM + 1) ? a->inc : a->inc + 1) : adim;
+	const int* binc = CCV_IS_TENSOR_VIEW(b) ? ((b_nd == CCV_NNC_MAX_DIM + 1) ? b->inc : b->inc + 1) : bdim;
+	assert(hint.border.begin[0] <= 1);
+	assert(hint.border.begin[1] <= 1);
+	assert(w->info.dim[0] % 4 == 0);
+	assert(w->info.dim[1] == 3);
+	assert(w->info.dim[2] == 3);
+	const int jump_dim = (bdim[0] + 5) / 6;
+	const int dimCx4 = (adim[2] + 3) & -4;
+	// allocating workspace memory for kernel reshaping and input reshaping.
+	const int gwtg_size = 64 * dimCx4 * w->info.dim[0];
+	const float* const kept_gwtg = _ccv_nnc_conv_cpu_opt_weights(w, "_ccv_nnc_winograd_6x6_3x3_gwtg_sse2", gwtg_size, _ccv_nnc_winograd_6x6_3x3_gwtg_sse2_transform);
+	float* workmem = 0;
+#if FOR_IS_PARALLEL
+	// If we do parallel for, we need to allocate input reshaping for each block.
+	workmem = ccv_nnc_stream_context_get_workspace(stream_context, sizeof(float) * (64 * dimCx4 * jump_dim + (kept_gwtg ? 0 : gwtg_size)), CCV_TENSOR_CPU_MEMORY);
+#else
+	// Otherwise, just one block.
+	workmem = ccv_nnc_stream_context_get_workspace(stream_context, sizeof(float) * (64 * dimCx4 + (kept_gwtg ? 0 : gwtg_size)), CCV_TENSOR_CPU_MEMORY);
+#endif
+	if (!workmem)
+		return CCV_NNC_EXEC_OOM;
+	// Convert w to a 8x8 matrix, by computing G.w.T(G) // T for transpose.
+	const float* const gwtg = kept_gwtg ? kept_gwtg : workmem;
+	float* const btdb = kept_gwtg ? workmem : workmem + gwtg_size;
+	if (!kept_gwtg)
+		_ccv_nnc_winograd_6x6_3x3_gwtg_sse2_transform(workmem, w);
+	// Workaround issues of dispatch_apply (cannot reference to on-stack array)
+	const int tile_dim_s[CCV_NNC_MAX_DIM_ALLOC] = {
+		w->info.dim[0], 8, 8, w->info.dim[3]
+	};
+	const int* const tile_dim = tile_dim_s;
+	const float* const biasval = bias ? bias->data.f32 : 0;
+	// This block will be cause in each for-loop, therefore, you can use it to generate some temporary variables.
+	parallel_for(i, jump_dim) {
+		const int y = i * 6; // i is unsigned.
+		int j, x, k, c, l;
+		int n[CCV_NNC_MAX_DIM];
+		int m[CCV_NNC_MAX_DIM];
+		int z[CCV_NNC_MAX_DIM];
+		set_n_m_dim(y, 0, tile_dim, adim);
+		z[0] = ccv_min(y + 6, bdim[0]) - y;
+		const float* ap = a->data.f32 + ccv_max(y - hint.border.begin[0], 0) * ainc[1] * ainc[2];
+		float* bp = b->data.f32 + y * binc[1] * binc[2];
+		for (x = 0; x < bdim[1]; x += 6)
+		{
+			set_n_m_dim(x, 1, tile_dim, adim);
+			z[1] = ccv_min(x + 6, bdim[1]) - x;
+#if FOR_IS_PARALLEL
+			float* g = btdb + i * 64 * dimCx4;
+#else
+			float* g = btdb;
+#endif
+			// zero g such that we can have zero-padding.
+			memset(g, 0, sizeof(float) * 64 * dimCx4);
+			int dx, dy;
+			const float* apz = ap + ccv_max(x - hint.border.begin[1], 0) * ainc[2];
+			float* gz = g + (n[0] * 8 + n[1]) * dimCx4;
+			for (dy = 0; dy < m[0]; dy++)
+			{
+				for (dx = 0; dx < m[1]; dx++)
+				{
+					float* const gzu = gz + (dy * 8 + dx) * dimCx4;
+					for (c = 0; c < adim[2]; c++)
+						gzu[c] = apz[dx * ainc[2] + c];
+				}
+				apz += ainc[1] * ainc[2];
+			}
+			for (c = 0; c < adim[2]; c += 4)
+			{
+				__m128 d[64];
+				/* BT.d */
+				for (j = 0; j < 8; j++)
+				{
+					__m128 dc[8], r[8];
+					unroll_for(l, 8) {
+						dc[l] = _mm_load_ps(g + (l * 8 + j) * dimCx4);
+					} unroll_endfor
+					_ccv_nnc_winograd_6x6_3x3_bt_sse2(dc, r);
+					unroll_for(l, 8) {
+						d[l * 8 + j] = r[l];
+					} unroll_endfor
+				}
+				/* BT.d.B */
+				for (j = 0; j < 8; j++)
+				{
+					__m128 r[8];
+					_ccv_nnc_winograd_6x6_3x3_bt_sse2(d + j * 8, r);
+					unroll_for(l, 8) {
+						_mm_store_ps(g + (j * 8 + l) * dimCx4, r[l]);
+					} unroll_endfor
+				}
+				// move to the next channel
+				g += 4;
+			}
+			const float* wpz = gwtg;
+			for (k = 0; k < w->info.dim[0]; k += 4)
+			{
+				__m128 q[64];
+#if FOR_IS_PARALLEL
+				g = btdb + i * 64 * dimCx4;
+#else
+				g = btdb;
+#endif
+				for (j = 0; j < 64; j++)
+				{
+					__m128 v40 = _mm_setzero_ps();
+					__m128 v41 = _mm_setzero_ps();
+					__m128 v42 = _mm_setzero_ps();
+					__m128 v43 = _mm_setzero_ps();
+					for (c = 0; c < adim[2]; c += 4)
+					{
+						__m128 g4 = _mm_load_ps(g);
+						__m128 w40 = _mm_load_ps(wpz);
+						__m128 w41 = _mm_load_ps(wpz + 4);
+						__m128 w42 = _mm_load_ps(wpz + 8);
+						__m128 w43 = _mm_load_ps(wpz + 12);
+						__m128 g40 = _mm_shuffle_ps(g4, g4, 0x00);
+						__m128 g41 = _mm_shuffle_ps(g4, g4, 0x55);
+						__m128 g42 = _mm_shuffle_ps(g4, g4, 0xAA);
+						__m128 g43 = _mm_shuffle_ps(g4, g4, 0xFF);
+						v40 = _mm_add_ps(_mm_mul_ps(w40, g40), v40);
+						v41 = _mm_add_ps(_mm_mul_ps(w41, g41), v41);
+						v42 = _mm_add_ps(_mm_mul_ps(w42, g42), v42);
+						v43 = _mm_add_ps(_mm_mul_ps(w43, g43), v43);
+						g += 4;
+						wpz += 16;
+					}
+					v40 = _mm_add_ps(v40, v41);
+					v42 = _mm_add_ps(v42, v43);
+					q[j] = _mm_add_ps(v40, v42);
+				}
+				/* AT.q */
+				__m128 d[48];
+				for (j = 0; j < 8; j++)
+				{
+					__m128 qc[8], r[6];
+					unroll_for(l, 8) {
+						qc[l] = q[l * 8 + j];
+					} unroll_endfor
+					_ccv_nnc_winograd_6x6_3x3_at_sse2(qc, r);
+					unroll_for(l, 6) {
+						d[l * 8 + j] = r[l];
+					} unroll_endfor
+				}
+				/* AT.q.A */
+				float* bpz = bp + x * binc[2] + k;
+				const __m128 bias4 = biasval ? _mm_loadu_ps(biasval + k) : _mm_setzero_ps();
+				for (dy = 0; dy < z[0]; dy++)
+				{
+					__m128 r[6];
+					_ccv_nnc_winograd_6x6_3x3_at_sse2(d + dy * 8, r);
+					for (dx = 0; dx < z[1]; dx++)
+						_mm_storeu_ps(bpz + dx * binc[2], _mm_add_ps(r[dx], bias4));
+					bpz += binc[1] * binc[2];
+				}
+			}
+		}
+	} parallel_endfor
+	return CCV_NNC_EXEC_SUCCESS;
+}
+#endif
+
+int _ccv_nnc_conv_forw_6x6_3x3_winograd_cpu_opt(const ccv_nnc_tensor_view_t* const a, const ccv_nnc_tensor_t* const w, const ccv_nnc_tensor_t* const bias, const ccv_nnc_hint_t hint, ccv_nnc_tensor_view_t* const b, ccv_nnc_stream_context_t* const stream_context)
+{
+#if defined(HAVE_SSE2)
+	if (w->info.dim[0] % 4 == 0)
+		return _ccv_nnc_conv_forw_6x6_3x3_winograd_sse2(a, w, bias, hint, b, stream_context);
+#endif
+	return _ccv_nnc_conv_forw_6x6_3x3_winograd_ref(a, w, bias, hint, b, stream_context);
+}
@@ -3,25 +3,18 @@
 #include <nnc/ccv_nnc.h>
 #include <nnc/ccv_nnc_easy.h>
 #include <nnc/ccv_nnc_internal.h>
+#ifdef USE_OPENMP
+#include <omp.h>
+#endif
+#ifdef USE_DISPATCH
+#include <dispatch/dispatch.h>
+#endif
 #include "../_ccv_nnc_conv_cpu_opt.h"
+#include "../../blas/_ccv_nnc_gemm_cpu_opt.h"
 
-int _ccv_nnc_conv_forw_gemm_cpu_opt(const ccv_nnc_tensor_view_t* const a, const ccv_nnc_tensor_t* const w, const ccv_nnc_tensor_t* const bias, const ccv_nnc_hint_t hint, ccv_nnc_tensor_view_t* const b)
+#if (defined HAVE_CBLAS || defined HAVE_ACCELERATE_FRAMEWORK)
+static int _ccv_nnc_conv_forw_1x1_cpu_sys(const ccv_nnc_tensor_view_t* const a, const ccv_nnc_tensor_t* const w, const ccv_nnc_tensor_t* const bias, ccv_nnc_tensor_view_t* const b, const int* const adim, const int* const bdim)
 {
-	assert(!CCV_IS_TENSOR_VIEW(a));
-	assert(!CCV_IS_TENSOR_VIEW(w));
-	assert(!bias || !CCV_IS_TENSOR_VIEW(bias));
-	assert(!CCV_IS_TENSOR_VIEW(b));
-	const int a_nd = ccv_nnc_tensor_nd(a->info.dim);
-	assert(a_nd == CCV_NNC_MAX_DIM + 1 || a_nd == CCV_NNC_MAX_DIM + 2);
-	const int* adim = (a_nd == CCV_NNC_MAX_DIM + 1) ? a->info.dim : a->info.dim + 1;
-	const int b_nd = ccv_nnc_tensor_nd(b->info.dim);
-	assert(b_nd == CCV_NNC_MAX_DIM + 1 || b_nd == CCV_NNC_MAX_DIM + 2);
-	const int* bdim = (b_nd == CCV_NNC_MAX_DIM + 1) ? b->info.dim : b->info.dim + 1;
-	assert(hint.border.begin[0] == 0 && hint.border.begin[1] == 0);
-	assert(hint.border.end[0] == 0 && hint.border.end[1] == 0);
-	assert(adim[0] == bdim[0]);
-	assert(adim[1] == bdim[1]);
-	assert(hint.stride.dim[0] <= 1 && hint.stride.dim[1] <= 1);
 	ccv_dense_matrix_t am = ccv_dense_matrix(adim[0] * adim[1], adim[2], CCV_32F | CCV_C1, a->data.u8, 0);
 	ccv_dense_matrix_t bm = ccv_dense_matrix(bdim[0] * bdim[1], bdim[2], CCV_32F | CCV_C1, b->data.u8, 0);
 	// copy bias into each row.
@@ -37,3 +30,97 @@ int _ccv_nnc_conv_forw_gemm_cpu_opt(const ccv_nnc_tensor_view_t* const a, const
 		ccv_gemm(&am, &wm, 1, 0, 0, CCV_B_TRANSPOSE, (ccv_matrix_t**)&dbm, 0); // supply b as matrix C is allowed
 	return CCV_NNC_EXEC_SUCCESS;
 }
+#endif
+
+int _ccv_nnc_conv_forw_gemm_cpu_opt(const ccv_nnc_tensor_view_t* const a, const ccv_nnc_tensor_t* const w, const ccv_nnc_tensor_t* const bias, const ccv_nnc_hint_t hint, ccv_nnc_tensor_view_t* const b, const ccv_nnc_cpu_epilogue_t* const epilogue)
+{
+	assert(!CCV_IS_TENSOR_VIEW(w));
+	assert(!bias || !CCV_IS_TENSOR_VIEW(bias));
+	const int a_nd = ccv_nnc_tensor_nd(a->info.dim);
+	assert(a_nd == CCV_NNC_MAX_DIM + 1 || a_nd == CCV_NNC_MAX_DIM + 2);
+	const int* adim = (a_nd == CCV_NNC_MAX_DIM + 1) ? a->info.dim : a->info.dim + 1;
+	const int b_nd = ccv_nnc_tensor_nd(b->info.dim);
+	assert(b_nd == CCV_NNC_MAX_DIM + 1 || b_nd == CCV_NNC_MAX_DIM + 2);
+	const int* bdim = (b_nd == CCV_NNC_MAX_DIM + 1) ? b->info.dim : b->info.dim + 1;
+	const int* ainc = CCV_IS_TENSOR_VIEW(a) ? ((a_nd == CCV_NNC_MAX_DIM + 1) ? a->inc : a->inc + 1) : adim;
+	const int* binc = CCV_IS_TENSOR_VIEW(b) ? ((b_nd == CCV_NNC_MAX_DIM + 1) ? b->inc : b->inc + 1) : bdim;
+	const int is_1x1 = w->info.dim[1] == 1 && w->info.dim[2] == 1 && hint.stride.dim[0] <= 1 && hint.stride.dim[1] <= 1 &&
+		hint.border.begin[0] == 0 && hint.border.begin[1] == 0 && hint.border.end[0] == 0 && hint.border.end[1] == 0 &&
+		!CCV_IS_TENSOR_VIEW(a) && !CCV_IS_TENSOR_VIEW(b);
+#if (defined HAVE_CBLAS || defined HAVE_ACCELERATE_FRAMEWORK)
+	if (is_1x1)
+	{
+		const int status = _ccv_nnc_conv_forw_1x1_cpu_sys(a, w, bias, b, adim, bdim);
+		if (status == CCV_NNC_EXEC_SUCCESS && epilogue)
+			return _ccv_nnc_cpu_epilogue_apply_all(epilogue, b);
+		return status;
+	}
+#endif
+	int i;
+	// The weights are [count][kernel rows][kernel cols][channels], thus, T(w) is the b matrix for GEMM if the columns
+	// of a (after im2col) are in the order of kernel rows, kernel cols and channels.
+	const int kdim = w->info.dim[1] * w->info.dim[2] * w->info.dim[3];
+	const int count = w->info.dim[0];
+	if (is_1x1) // No need to im2col.
+	{
+		const int rows = bdim[0] * bdim[1];
+		if (bias)
+			for (i = 0; i < rows; i++)
+				memcpy(b->data.f32 + i * count, bias->data.f32, sizeof(float) * count);
+		return _ccv_nnc_gemm_cpu_packed(rows, count, kdim, a->data.f32, adim[2], 1, w->data.f32, 1, kdim, w->sig, b->data.f32, count, !!bias, epilogue, 0);
+	}
+	const int stride_s[CCV_NNC_MAX_DIM] = {
+		ccv_max(hint.stride.dim[0], 1), ccv_max(hint.stride.dim[1], 1)
+	};
+	const int* const stride = stride_s;
+	const int* const kernel = w->info.dim + 1;
+	const int channel = adim[2];
+	// im2col a few rows at a time (enough to fill the packed GEMM), if b is a view, rows are not contiguous, one row at a time.
+	const int row_step = binc[1] == bdim[1] ? ccv_max(1, 512 / bdim[1]) : 1;
+	int pw_owned;
+	float* const pw = _ccv_nnc_gemm_pack_b_cpu_opt(kdim, count, w->data.f32, 1, kdim, w->sig, &pw_owned);
+	if (!pw)
+		return CCV_NNC_EXEC_OOM;
+	float* col = 0;
+	ccmemalign((void **)&col, 16, sizeof(float) * row_step * bdim[1] * kdim);
+	if (!col)
+	{
+		if (pw_owned)
+			ccfree(pw);
+		return CCV_NNC_EXEC_OOM;
+	}
+	int y0;
+	int status = CCV_NNC_EXEC_SUCCESS;
+	for (y0 = 0; y0 < bdim[0] && status == CCV_NNC_EXEC_SUCCESS; y0 += row_step)
+	{
+		const int rows = ccv_min(row_step, bdim[0] - y0) * bdim[1];
+		parallel_for(r, rows) {
+			int dy, dx;
+			const int y = y0 + r / bdim[1];
+			const int x = r % bdim[1];
+			float* colz = col + r * kdim;
+			for (dy = 0; dy < kernel[0]; dy++)
+			{
+				const int iy = y * stride[0] - hint.border.begin[0] + dy;
+				for (dx = 0; dx < kernel[1]; dx++)
+				{
+					const int ix = x * stride[1] - hint.border.begin[1] + dx;
+					if (iy >= 0 && iy < adim[0] && ix >= 0 && ix < adim[1])
+						memcpy(colz, a->data.f32 + (iy * ainc[1] + ix) * ainc[2], sizeof(float) * channel);
+					else
+						memset(colz, 0, sizeof(float) * channel);
+					colz += channel;
+				}
+			}
+		} parallel_endfor
+		float* const bp = b->data.f32 + y0 * binc[1] * binc[2];
+		if (bias)
+			for (i = 0; i < rows; i++)
+				memcpy(bp + i * binc[2], bias->data.f32, sizeof(float) * count);
+		status = _ccv_nnc_gemm_packed_cpu_opt(rows, count, kdim, col, kdim, 1, pw, bp, binc[2], !!bias, epilogue, y0 * bdim[1]);
+	}
+	ccfree(col);
+	if (pw_owned)
+		ccfree(pw);
+	return status;
+}
@@ -47,6 +47,12 @@ inline static void _ccv_nnc_x4w_sse2(const float* const w, const int* const dim,
 	} parallel_endfor
 }
 
+static void _ccv_nnc_x4w_sse2_transform(void* const data, const void* const context)
+{
+	const ccv_nnc_tensor_t* const w = (const ccv_nnc_tensor_t*)context;
+	_ccv_nnc_x4w_sse2(w->data.f32, w->info.dim, (float*)data);
+}
+
 static int _ccv_nnc_conv_forw_sse2(const ccv_nnc_tensor_view_t* const a, const ccv_nnc_tensor_t* const w, const ccv_nnc_tensor_t* const bias, const ccv_nnc_hint_t hint, ccv_nnc_tensor_view_t* const b)
 {
 	const int a_nd = ccv_nnc_tensor_nd(a->info.dim);
@@ -58,11 +64,17 @@ static int _ccv_nnc_conv_forw_sse2(const ccv_nnc_tensor_view_t* const a, const c
 	const int* ainc = CCV_IS_TENSOR_VIEW(a) ? ((a_nd == CCV_NNC_MAX_DIM + 1) ? a->inc : a->inc + 1) : adim;
 	const int* binc = CCV_IS_TENSOR_VIEW(b) ? ((b_nd == CCV_NNC_MAX_DIM + 1) ? b->inc : b->inc + 1) : bdim;
 	assert(w->info.dim[0] % 4 == 0);
-	float* x4w = 0;
-	ccmemalign((void **)&x4w, 16, sizeof(float) * w->info.dim[3] * w->info.dim[2] * w->info.dim[1] * w->info.dim[0]);
-	if (!x4w)
-		return CCV_NNC_EXEC_OOM;
-	_ccv_nnc_x4w_sse2(w->data.f32, w->info.dim, x4w);
+	const int x4w_size = w->info.dim[3] * w->info.dim[2] * w->info.dim[1] * w->info.dim[0];
+	const float* const kept_x4w = _ccv_nnc_conv_cpu_opt_weights(w, "_ccv_nnc_x4w_sse2", x4w_size, _ccv_nnc_x4w_sse2_transform);
+	float* owned_x4w = 0;
+	if (!kept_x4w)
+	{
+		ccmemalign((void **)&owned_x4w, 16, sizeof(float) * x4w_size);
+		if (!owned_x4w)
+			return CCV_NNC_EXEC_OOM;
+		_ccv_nnc_x4w_sse2(w->data.f32, w->info.dim, owned_x4w);
+	}
+	const float* const x4w = kept_x4w ? kept_x4w : owned_x4w;
 	int jump_dim = w->info.dim[0] / 4;
 	// Do naive tail partition unroll
 #define main_for(tail_block) \
@@ -169,7 +181,8 @@ static int _ccv_nnc_conv_forw_sse2(const ccv_nnc_tensor_view_t* const a, const c
 #undef tail_block
 	}
 #undef main_for
-	ccfree(x4w);
+	if (owned_x4w)
+		ccfree(owned_x4w);
 	return CCV_NNC_EXEC_SUCCESS;
 }
 #endif
@@ -205,6 +218,12 @@ inline static void _ccv_nnc_x4w_neon(const float* const w, const int* const dim,
 	} parallel_endfor
 }
 
+static void _ccv_nnc_x4w_neon_transform(void* const data, const void* const context)
+{
+	const ccv_nnc_tensor_t* const w = (const ccv_nnc_tensor_t*)context;
+	_ccv_nnc_x4w_neon(w->data.f32, w->info.dim, (float*)data);
+}
+
 static int _ccv_nnc_conv_forw_neon(const ccv_nnc_tensor_view_t* const a, const ccv_nnc_tensor_t* const w, const ccv_nnc_tensor_t* const bias, const ccv_nnc_hint_t hint, ccv_nnc_tensor_view_t* const b)
 {
 	const int a_nd = ccv_nnc_tensor_nd(a->info.dim);
@@ -216,11 +235,17 @@ static int _ccv_nnc_conv_forw_neon(const ccv_nnc_tensor_view_t* const a, const c
 	const int* ainc = CCV_IS_TENSOR_VIEW(a) ? ((a_nd == CCV_NNC_MAX_DIM + 1) ? a->inc : a->inc + 1) : adim;
 	const int* binc = CCV_IS_TENSOR_VIEW(b) ? ((b_nd == CCV_NNC_MAX_DIM + 1) ? b->inc : b->inc + 1) : bdim;
 	assert(w->info.dim[0] % 4 == 0);
-	float* x4w = 0;
-	ccmemalign((void **)&x4w, 16, sizeof(float) * w->info.dim[3] * w->info.dim[2] * w->info.dim[1] * w->info.dim[0]);
-	if (!x4w)
-		return CCV_NNC_EXEC_OOM;
-	_ccv_nnc_x4w_neon(w->data.f32, w->info.dim, x4w);
+	const int x4w_size = w->info.dim[3] * w->info.dim[2] * w->info.dim[1] * w->info.dim[0];
+	const float* const kept_x4w = _ccv_nnc_conv_cpu_opt_weights(w, "_ccv_nnc_x4w_neon", x4w_size, _ccv_nnc_x4w_neon_transform);
+	float* owned_x4w = 0;
+	if (!kept_x4w)
+	{
+		ccmemalign((void **)&owned_x4w, 16, sizeof(float) * x4w_size);
+		if (!owned_x4w)
+			return CCV_NNC_EXEC_OOM;
+		_ccv_nnc_x4w_neon(w->data.f32, w->info.dim, owned_x4w);
+	}
+	const float* const x4w = kept_x4w ? kept_x4w : owned_x4w;
 	int jump_dim = w->info.dim[0] / 4;
 #define main_for(tail_block) \
 	parallel_for(k, jump_dim) { \
@@ -329,7 +354,8 @@ static int _ccv_nnc_conv_forw_neon(const ccv_nnc_tensor_view_t* const a, const c
 #undef tail_block
 	}
 #undef main_for
-	ccfree(x4w);
+	if (owned_x4w)
+		ccfree(owned_x4w);
 	return CCV_NNC_EXEC_SUCCESS;
 }
 #endif
@@ -110,6 +110,8 @@ void _ccv_nnc_ewsum_forw_cpu_ref(ccv_nnc_tensor_view_t* const* const inputs, con
 
 static int _ccv_nnc_ewsum_forw(const ccv_nnc_cmd_t cmd, const ccv_nnc_hint_t hint, const int flags, ccv_nnc_tensor_t* const* const inputs, const int input_size, ccv_nnc_tensor_t* const* const outputs, const int output_size, ccv_nnc_stream_context_t* const stream_context)
 {
+	if (cmd.info.epilogue.size)
+		return _ccv_nnc_ew_forw_epilogue_cpu_ref(cmd, hint, flags, inputs, input_size, outputs, output_size, stream_context, _ccv_nnc_ewsum_forw);
 	_ccv_nnc_ewsum_forw_cpu_ref((ccv_nnc_tensor_view_t**)inputs, input_size, (ccv_nnc_tensor_view_t**)outputs, output_size);
 	return CCV_NNC_EXEC_SUCCESS;
 }
@@ -231,6 +233,8 @@ void _ccv_nnc_ewprod_forw_cpu_ref(ccv_nnc_tensor_view_t* const* const inputs, co
 
 static int _ccv_nnc_ewprod_forw(const ccv_nnc_cmd_t cmd, const ccv_nnc_hint_t hint, const int flags, ccv_nnc_tensor_t* const* const inputs, const int input_size, ccv_nnc_tensor_t* const* const outputs, const int output_size, ccv_nnc_stream_context_t* const stream_context)
 {
+	if (cmd.info.epilogue.size)
+		return _ccv_nnc_ew_forw_epilogue_cpu_ref(cmd, hint, flags, inputs, input_size, outputs, output_size, stream_context, _ccv_nnc_ewprod_forw);
 	_ccv_nnc_ewprod_forw_cpu_ref((ccv_nnc_tensor_view_t**)inputs, input_size, (ccv_nnc_tensor_view_t**)outputs, output_size);
 	return CCV_NNC_EXEC_SUCCESS;
 }
@@ -874,6 +878,8 @@ static int _ccv_nnc_ewdiv_back(const ccv_nnc_cmd_t cmd, const ccv_nnc_hint_t hin
 
 static int _ccv_nnc_ewexp_forw(const ccv_nnc_cmd_t cmd, const ccv_nnc_hint_t hint, const int flags, ccv_nnc_tensor_t* const* const inputs, const int input_size, ccv_nnc_tensor_t* const* const outputs, const int output_size, ccv_nnc_stream_context_t* const stream_context)
 {
+	if (cmd.info.epilogue.size)
+		return _ccv_nnc_ew_forw_epilogue_cpu_ref(cmd, hint, flags, inputs, input_size, outputs, output_size, stream_context, _ccv_nnc_ewexp_forw);
 	// Assuming this is float 32.
 	int dim[CCV_NNC_MAX_DIM + 2];
 	int ainc[CCV_NNC_MAX_DIM + 2];
@@ -1096,12 +1102,201 @@ static int _ccv_nnc_ewsqrt_back(const ccv_nnc_cmd_t cmd, const ccv_nnc_hint_t hi
 	return CCV_NNC_EXEC_SUCCESS;
 }
 
+int _ccv_nnc_cpu_epilogue_new(const ccv_nnc_cmd_param_t cmd, ccv_nnc_tensor_t* const* const inputs, const int input_size, const ccv_nnc_tensor_view_t* const b, ccv_nnc_cpu_epilogue_t* const epilogue)
+{
+	assert(input_size == ccv_nnc_cmd_epilogue_input_size(cmd));
+	const int nd = ccv_nnc_tensor_nd(b->info.dim);
+	const int count = epilogue->count = b->info.dim[nd - 1];
+	const int tensor_count = ccv_nnc_tensor_count(b->info);
+	int i, j, k;
+	int folded_size = 0;
+	for (i = 0; i < cmd.epilogue.size; i++)
+		if (cmd.epilogue.ops[i].type == CCV_NNC_EPILOGUE_BATCH_NORM)
+			folded_size += count * 2;
+	epilogue->folded = 0;
+	if (folded_size)
+	{
+		epilogue->folded = (float*)ccmalloc(sizeof(float) * folded_size);
+		if (!epilogue->folded)
+			return CCV_NNC_EXEC_OOM;
+	}
+	float* folded = epilogue->folded;
+	epilogue->size = cmd.epilogue.size;
+	for (i = 0, k = 0; i < cmd.epilogue.size; i++)
+	{
+		epilogue->ops[i].type = cmd.epilogue.ops[i].type;
+		epilogue->ops[i].a = cmd.epilogue.ops[i].a;
+		epilogue->ops[i].x = epilogue->ops[i].y = 0;
+		switch (cmd.epilogue.ops[i].type)
+		{
+			case CCV_NNC_EPILOGUE_EWSUM:
+			case CCV_NNC_EPILOGUE_EWPROD:
+				assert(!CCV_IS_TENSOR_VIEW(inputs[k]));
+				assert(ccv_nnc_tensor_count(inputs[k]->info) == tensor_count);
+				epilogue->ops[i].x = inputs[k]->data.f32;
+				++k;
+				break;
+			case CCV_NNC_EPILOGUE_BATCH_NORM: {
+				for (j = 0; j < 4; j++)
+				{
+					assert(!CCV_IS_TENSOR_VIEW(inputs[k + j]));
+					assert(ccv_nnc_tensor_count(inputs[k + j]->info) == count);
+				}
+				const float* const scale = inputs[k]->data.f32;
+				const float* const bias = inputs[k + 1]->data.f32;
+				const float* const mean = inputs[k + 2]->data.f32;
+				const float* const var = inputs[k + 3]->data.f32;
+				// Fold (b - mean) * scale / (sqrt(var) + epsilon) + bias into b * scale' + bias', the same as batch norm in test mode.
+				float* const fscale = folded;
+				float* const fbias = folded + count;
+				for (j = 0; j < count; j++)
+				{
+					fscale[j] = scale[j] / (sqrtf(var[j]) + cmd.epilogue.ops[i].a);
+					fbias[j] = bias[j] - mean[j] * fscale[j];
+				}
+				epilogue->ops[i].x = fscale;
+				epilogue->ops[i].y = fbias;
+				folded += count * 2;
+				k += 4;
+				break;
+			}
+		}
+	}
+	return CCV_NNC_EXEC_SUCCESS;
+}
+
+void _ccv_nnc_cpu_epilogue_apply(const ccv_nnc_cpu_epilogue_t* const epilogue, float* const b, const int ldb, const int row, const int rows, const int col, const int cols)
+{
+	int i, j, x;
+	for (i = 0; i < rows; i++)
+	{
+		float* const bp = b + i * ldb;
+		const int offset = (row + i) * epilogue->count + col;
+		for (j = 0; j < epilogue->size; j++)
+		{
+			const float a = epilogue->ops[j].a;
+			const float* const xp = epilogue->ops[j].x;
+			const float* const yp = epilogue->ops[j].y;
+			switch (epilogue->ops[j].type)
+			{
+				case CCV_NNC_EPILOGUE_RELU:
+					for (x = 0; x < cols; x++)
+						bp[x] = ccv_max(bp[x], 0);
+					break;
+				case CCV_NNC_EPILOGUE_SCALAR_MUL:
+					for (x = 0; x < cols; x++)
+						bp[x] *= a;
+					break;
+				case CCV_NNC_EPILOGUE_EXP:
+					for (x = 0; x < cols; x++)
+						bp[x] = expf(bp[x]);
+					break;
+				case CCV_NNC_EPILOGUE_EWSUM:
+					for (x = 0; x < cols; x++)
+						bp[x] += xp[offset + x];
+					break;
+				case CCV_NNC_EPILOGUE_EWPROD:
+					for (x = 0; x < cols; x++)
+						bp[x] *= xp[offset + x];
+					break;
+				case CCV_NNC_EPILOGUE_BATCH_NORM:
+					for (x = 0; x < cols; x++)
+						bp[x] = bp[x] * xp[col + x] + yp[col + x];
+					break;
+			}
+		}
+	}
+}
+
+void _ccv_nnc_cpu_epilogue_free(ccv_nnc_cpu_epilogue_t* const epilogue)
+{
+	if (epilogue->folded)
+		ccfree(epilogue->folded);
+}
+
+int _ccv_nnc_cpu_epilogue_apply_all(const ccv_nnc_cpu_epilogue_t* const epilogue, ccv_nnc_tensor_view_t* const b)
+{
+	if (CCV_IS_TENSOR_VIEW(b))
+		return CCV_NNC_EXEC_INVALID;
+	const int count = epilogue->count;
+	const int rows = ccv_nnc_tensor_count(b->info) / count;
+	// A few rows at a time, all the ops are applied on one row before moving to the next.
+	const int row_step = ccv_max(1, 1024 / count);
+	parallel_for(i, (rows + row_step - 1) / row_step) {
+		const int row = i * row_step;
+		_ccv_nnc_cpu_epilogue_apply(epilogue, b->data.f32 + row * count, count, row, ccv_min(row_step, rows - row), 0, count);
+	} parallel_endfor
+	return CCV_NNC_EXEC_SUCCESS;
+}
+
+int _ccv_nnc_ew_forw_epilogue_cpu_ref(const ccv_nnc_cmd_t cmd, const ccv_nnc_hint_t hint, const int flags, ccv_nnc_tensor_t* const* const inputs, const int input_size, ccv_nnc_tensor_t* const* const outputs, const int output_size, ccv_nnc_stream_context_t* const stream_context, const ccv_nnc_cmd_exec_f exec)
+{
+	assert(output_size == 1);
+	const int epilogue_input_size = ccv_nnc_cmd_epilogue_input_size(cmd.info);
+	const int native_input_size = input_size - epilogue_input_size;
+	assert(native_input_size > 0);
+	ccv_nnc_cmd_t native_cmd = cmd;
+	native_cmd.info.epilogue.size = 0;
+	ccv_nnc_tensor_t* const b = outputs[0];
+	// The epilogue is applied on the output as a contiguous block.
+	if (CCV_IS_TENSOR_VIEW(b))
+		return CCV_NNC_EXEC_INVALID;
+	ccv_nnc_cpu_epilogue_t epilogue;
+	int status = _ccv_nnc_cpu_epilogue_new(cmd.info, inputs + native_input_size, epilogue_input_size, (ccv_nnc_tensor_view_t*)b, &epilogue);
+	if (status != CCV_NNC_EXEC_SUCCESS)
+		return status;
+	const int tensor_count = ccv_nnc_tensor_count(b->info);
+	int i, blocked = 1;
+	for (i = 0; blocked && i < native_input_size; i++)
+		blocked = inputs[i] && !CCV_IS_TENSOR_VIEW(inputs[i]) && ccv_nnc_tensor_count(inputs[i]->info) == tensor_count;
+	if (!blocked)
+	{
+		status = exec(native_cmd, hint, flags, inputs, native_input_size, outputs, output_size, stream_context);
+		if (status == CCV_NNC_EXEC_SUCCESS)
+			status = _ccv_nnc_cpu_epilogue_apply_all(&epilogue, (ccv_nnc_tensor_view_t*)b);
+		_ccv_nnc_cpu_epilogue_free(&epilogue);
+		return status;
+	}
+	const int count = epilogue.count;
+	const int rows = tensor_count / count;
+	const int row_step = ccv_max(1, 1024 / count);
+	ccv_nnc_tensor_t block_inputs[native_input_size];
+	ccv_nnc_tensor_t* block_input_ptrs[native_input_size];
+	ccv_nnc_tensor_t block_output;
+	ccv_nnc_tensor_t* block_output_ptr = &block_output;
+	int row;
+	for (row = 0; row < rows && status == CCV_NNC_EXEC_SUCCESS; row += row_step)
+	{
+		const int block_rows = ccv_min(row_step, rows - row);
+		for (i = 0; i < native_input_size; i++)
+		{
+			ccv_nnc_tensor_param_t params = inputs[i]->info;
+			memset(params.dim, 0, sizeof(params.dim));
+			params.dim[0] = block_rows;
+			params.dim[1] = count;
+			block_inputs[i] = ccv_nnc_tensor(inputs[i]->data.f32 + row * count, params, 0);
+			block_input_ptrs[i] = block_inputs + i;
+		}
+		ccv_nnc_tensor_param_t params = b->info;
+		memset(params.dim, 0, sizeof(params.dim));
+		params.dim[0] = block_rows;
+		params.dim[1] = count;
+		block_output = ccv_nnc_tensor(b->data.f32 + row * count, params, 0);
+		status = exec(native_cmd, hint, flags, block_input_ptrs, native_input_size, &block_output_ptr, 1, stream_context);
+		if (status == CCV_NNC_EXEC_SUCCESS)
+			_ccv_nnc_cpu_epilogue_apply(&epilogue, block_output.data.f32, count, row, block_rows, 0, count);
+	}
+	_ccv_nnc_cpu_epilogue_free(&epilogue);
+	return status;
+}
+
 REGISTER_COMMAND_BACKEND(CCV_NNC_EWSUM_FORWARD, CCV_NNC_BACKEND_CPU_REF)(ccv_nnc_cmd_backend_registry_t* const registry)
 {
 	registry->tensor_formats = CCV_TENSOR_FORMAT_NHWC | CCV_TENSOR_FORMAT_NCHW | CCV_TENSOR_FORMAT_CHWN;
 	registry->tensor_datatypes = CCV_32F;
 	registry->tensor_memory = CCV_TENSOR_CPU_MEMORY;
 	registry->algorithms = 1;
+	registry->epilogue = 1;
 	registry->exec = _ccv_nnc_ewsum_forw;
 }
 
@@ -1120,6 +1315,7 @@ REGISTER_COMMAND_BACKEND(CCV_NNC_EWPROD_FORWARD, CCV_NNC_BACKEND_CPU_REF)(ccv_nn
 	registry->tensor_datatypes = CCV_32F;
 	registry->tensor_memory = CCV_TENSOR_CPU_MEMORY;
 	registry->algorithms = 1;
+	registry->epilogue = 1;
 	registry->exec = _ccv_nnc_ewprod_forw;
 }
 
@@ -1156,6 +1352,7 @@ REGISTER_COMMAND_BACKEND(CCV_NNC_EWEXP_FORWARD, CCV_NNC_BACKEND_CPU_REF)(ccv_nnc
 	registry->tensor_datatypes = CCV_32F;
 	registry->tensor_memory = CCV_TENSOR_CPU_MEMORY;
 	registry->algorithms = 1;
+	registry->epilogue = 1;
 	registry->exec = _ccv_nnc_ewexp_forw;
 }
 
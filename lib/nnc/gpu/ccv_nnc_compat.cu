@@ -81,10 +81,7 @@ typedef struct {
 
 typedef struct {
 	ccv_nnc_stream_context_t super;
-	struct {
-		size_t workspace_size;
-		void* workspace;
-	} cpu;
+	ccv_nnc_stream_workspace_t cpu;
 	unsigned long long seed;
 	union {
 		ccv_nnc_stream_context_device_local_t _inline_gpu;
@@ -196,16 +193,8 @@ void* ccv_nnc_stream_compat_get_workspace(const ccv_nnc_stream_context_t* const
 	if (!stream_compat)
 		stream_compat = _ccv_nnc_default_stream_compat();
 	if (mem == CCV_TENSOR_CPU_MEMORY)
-	{
-		if (stream_compat->cpu.workspace_size >= workspace_size)
-			return stream_compat->cpu.workspace;
-		stream_compat->cpu.workspace_size = workspace_size;
-		if (stream_compat->cpu.workspace)
-			ccfree(stream_compat->cpu.workspace);
-		stream_compat->cpu.workspace = 0;
-		const int success = ccmemalign(&stream_compat->cpu.workspace, 16, workspace_size);
-		return success != 0 ? 0 : stream_compat->cpu.workspace;
-	} else if (mem == CCV_TENSOR_GPU_MEMORY) {
+		return ccv_nnc_stream_workspace_get(&stream_compat->cpu, workspace_size);
+	else if (mem == CCV_TENSOR_GPU_MEMORY) {
 		ccv_nnc_stream_context_device_local_t* const device_local = _ccv_nnc_stream_compat_device_local(stream_compat);
 		if (device_local->workspace_size >= workspace_size)
 			return device_local->workspace;
@@ -224,12 +213,7 @@ void ccv_nnc_stream_compat_drain(ccv_nnc_stream_context_t* const stream_context)
 	ccv_nnc_stream_context_compat_t* stream_compat = (ccv_nnc_stream_context_compat_t*)stream_context;
 	if (!stream_compat)
 		stream_compat = _ccv_nnc_default_stream_compat();
-	if (stream_compat->cpu.workspace)
-	{
-		ccfree(stream_compat->cpu.workspace);
-		stream_compat->cpu.workspace = 0;
-		stream_compat->cpu.workspace_size = 0;
-	}
+	ccv_nnc_stream_workspace_trim(&stream_compat->cpu, 0);
 	const int device = CCV_STREAM_GET_DEVICE_ID(stream_compat->super.type);
 	if (device == CCV_STREAM_GET_DEVICE_ID(CCV_COMPUTE_DEVICE_ANY))
 	{
@@ -249,6 +233,44 @@ void ccv_nnc_stream_compat_drain(ccv_nnc_stream_context_t* const stream_context)
 	}
 }
 
+void ccv_nnc_stream_compat_trim(ccv_nnc_stream_context_t* const stream_context, const size_t max_workspace_size)
+{
+	ccv_nnc_stream_context_compat_t* stream_compat = (ccv_nnc_stream_context_compat_t*)stream_context;
+	if (!stream_compat)
+		stream_compat = _ccv_nnc_default_stream_compat();
+	ccv_nnc_stream_workspace_trim(&stream_compat->cpu, max_workspace_size);
+	if (CCV_STREAM_GET_CONTEXT(stream_compat->super.type) != CCV_STREAM_CONTEXT_GPU)
+		return;
+	const int device = CCV_STREAM_GET_DEVICE_ID(stream_compat->super.type);
+	if (device == CCV_STREAM_GET_DEVICE_ID(CCV_COMPUTE_DEVICE_ANY))
+	{
+		int i;
+		for (i = 0; i < stream_compat->_heap_gpu_size; i++)
+			if (stream_compat->_heap_gpus[i].workspace && stream_compat->_heap_gpus[i].workspace_size > max_workspace_size)
+			{
+				cudaSetDevice(i);
+				cudaFree(stream_compat->_heap_gpus[i].workspace);
+				stream_compat->_heap_gpus[i].workspace = 0;
+				stream_compat->_heap_gpus[i].workspace_size = 0;
+			}
+	} else if (stream_compat->_inline_gpu.workspace && stream_compat->_inline_gpu.workspace_size > max_workspace_size) {
+		cudaFree(stream_compat->_inline_gpu.workspace);
+		stream_compat->_inline_gpu.workspace = 0;
+		stream_compat->_inline_gpu.workspace_size = 0;
+	}
+}
+
+ccv_nnc_stream_workspace_t* ccv_nnc_stream_compat_cpu_workspace(const ccv_nnc_stream_context_t* const stream_context)
+{
+	ccv_nnc_stream_context_compat_t* stream_compat = (ccv_nnc_stream_context_compat_t*)stream_context;
+	if (!stream_compat)
+	{
+		stream_compat = _ccv_nnc_default_stream_compat();
+		ccv_nnc_stream_workspace_per_thread(&stream_compat->cpu);
+	}
+	return &stream_compat->cpu;
+}
+
 void ccv_nnc_synchronize_stream_context(const ccv_nnc_stream_context_t* const stream_context)
 {
 	ccv_nnc_stream_context_compat_t* stream_compat = (ccv_nnc_stream_context_compat_t*)stream_context;
@@ -38,6 +38,8 @@ void ccv_nnc_deinit_stream_context(ccv_nnc_stream_context_t* const stream_contex
 void ccv_nnc_deinit_tensor(ccv_nnc_tensor_t* const tensor);
 CCV_WARN_UNUSED(void*) ccv_nnc_stream_compat_get_workspace(const ccv_nnc_stream_context_t* const stream_context, const size_t workspace_size, const int mem);
 void ccv_nnc_stream_compat_drain(ccv_nnc_stream_context_t* const stream_context);
+void ccv_nnc_stream_compat_trim(ccv_nnc_stream_context_t* const stream_context, const size_t max_workspace_size);
+CCV_WARN_UNUSED(ccv_nnc_stream_workspace_t*) ccv_nnc_stream_compat_cpu_workspace(const ccv_nnc_stream_context_t* const stream_context);
 CCV_WARN_UNUSED(ccv_nnc_stream_signal_t*) ccv_nnc_init_stream_signal(ccv_nnc_stream_signal_t* const signal);
 void ccv_nnc_stream_compat_emit_signal(const ccv_nnc_stream_context_t* const stream, const ccv_nnc_stream_signal_t* const signal);
 void ccv_nnc_stream_compat_wait_signal(const ccv_nnc_stream_context_t* const stream, const ccv_nnc_stream_signal_t* const signal);
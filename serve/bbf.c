@@ -157,23 +157,16 @@ int uri_bbf_detect_objects(const void* context, const void* parsed, ebb_buf* buf
 		return -1;
 	}
 	ccv_dense_matrix_t* image = 0;
-	ccv_read(parser->source.data, &image, CCV_IO_ANY_STREAM | CCV_IO_GRAY, parser->source.written);
+	ccv_read_fit(parser->source.data, &image, CCV_IO_ANY_STREAM | CCV_IO_GRAY, parser->source.written, parser->params.max_dimension, parser->params.max_dimension);
 	free(parser->source.data);
 	if (image == 0)
 	{
 		free(parser);
 		return -1;
 	}
-	ccv_dense_matrix_t* resize = 0;
-	if (parser->params.max_dimension > 0 && (image->rows > parser->params.max_dimension || image->cols > parser->params.max_dimension))
-	{
-		ccv_resample(image, &resize, 0, ccv_min(parser->params.max_dimension, (int)(image->rows * (float)parser->params.max_dimension / image->cols + 0.5)), ccv_min(parser->params.max_dimension, (int)(image->cols * (float)parser->params.max_dimension / image->rows + 0.5)), CCV_INTER_AREA);
-		ccv_matrix_free(image);
-	} else
-		resize = image;
-	ccv_array_t* seq = ccv_bbf_detect_objects(resize, &parser->cascade, 1, parser->params.params);
-	float width = resize->cols, height = resize->rows;
-	ccv_matrix_free(resize);
+	ccv_array_t* seq = ccv_bbf_detect_objects(image, &parser->cascade, 1, parser->params.params);
+	float width = image->cols, height = image->rows;
+	ccv_matrix_free(image);
 	if (seq == 0)
 	{
 		free(parser);
@@ -3,6 +3,7 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <ctype.h>
+#include <dispatch/dispatch.h>
 
 static void uri_convnet_on_model_string(void* context, char* string);
 static void uri_convnet_on_source_blob(void* context, ebb_buf data);
@@ -27,9 +28,25 @@ static const param_dispatch_t param_map[] = {
 	},
 };
 
+// requests for the same model are coalesced into one batch, up to the max batch size, or until the max wait expires
+#define CONVNET_MAX_BATCH_SIZE (32)
+#define CONVNET_MAX_BATCH_WAIT (2000) // in microseconds
+
+typedef struct {
+	ccv_dense_matrix_t* input;
+	int top;
+	int lead; // this request is the one to run the next batch
+	ccv_array_t* rank;
+	dispatch_semaphore_t done;
+} convnet_request_t;
+
 typedef struct {
 	ccv_convnet_t* convnet;
 	ccv_array_t* words;
+	dispatch_semaphore_t semaphore;
+	dispatch_semaphore_t full;
+	ccv_array_t* pending;
+	int leading;
 } convnet_and_words_t;
 
 typedef struct {
@@ -92,6 +109,94 @@ static ccv_array_t* uri_convnet_words_read(char* filename)
 	return 0;
 }
 
+static void uri_convnet_batch_run(convnet_and_words_t* convnet_and_words)
+{
+	// the leading request waits for the batch to fill up, or for the max wait time, whichever comes first
+	dispatch_semaphore_wait(convnet_and_words->semaphore, DISPATCH_TIME_FOREVER);
+	int pending = convnet_and_words->pending->rnum;
+	dispatch_semaphore_signal(convnet_and_words->semaphore);
+	if (pending < CONVNET_MAX_BATCH_SIZE)
+		dispatch_semaphore_wait(convnet_and_words->full, dispatch_time(DISPATCH_TIME_NOW, CONVNET_MAX_BATCH_WAIT * NSEC_PER_USEC));
+	convnet_request_t* requests[CONVNET_MAX_BATCH_SIZE];
+	dispatch_semaphore_wait(convnet_and_words->semaphore, DISPATCH_TIME_FOREVER);
+	int batch = ccv_min(convnet_and_words->pending->rnum, CONVNET_MAX_BATCH_SIZE);
+	memcpy(requests, ccv_array_get(convnet_and_words->pending, 0), sizeof(convnet_request_t*) * batch);
+	memmove(ccv_array_get(convnet_and_words->pending, 0), ccv_array_get(convnet_and_words->pending, batch), sizeof(convnet_request_t*) * (convnet_and_words->pending->rnum - batch));
+	convnet_and_words->pending->rnum -= batch;
+	// the batch is taken, don't let a late signal wake up the next batch early
+	while (dispatch_semaphore_wait(convnet_and_words->full, DISPATCH_TIME_NOW) == 0);
+	dispatch_semaphore_signal(convnet_and_words->semaphore);
+	int i, top = 0;
+	ccv_dense_matrix_t* inputs[CONVNET_MAX_BATCH_SIZE];
+	ccv_array_t* ranks[CONVNET_MAX_BATCH_SIZE];
+	for (i = 0; i < batch; i++)
+	{
+		inputs[i] = requests[i]->input;
+		top = ccv_max(top, requests[i]->top);
+	}
+	ccv_convnet_classify(convnet_and_words->convnet, inputs, 1, ranks, top, batch);
+	for (i = 0; i < batch; i++)
+	{
+		// ranks are ordered by confidence, only keep as many as asked for
+		if (ranks[i]->rnum > requests[i]->top)
+			ranks[i]->rnum = requests[i]->top;
+		requests[i]->rank = ranks[i];
+		// the first one is the leading request itself
+		if (i > 0)
+			dispatch_semaphore_signal(requests[i]->done);
+	}
+	dispatch_semaphore_wait(convnet_and_words->semaphore, DISPATCH_TIME_FOREVER);
+	if (convnet_and_words->pending->rnum == 0)
+	{
+		convnet_and_words->leading = 0;
+		dispatch_semaphore_signal(convnet_and_words->semaphore);
+		return;
+	}
+	// hand over to the first request waiting, thus, this one can respond now
+	convnet_request_t* next = *(convnet_request_t**)ccv_array_get(convnet_and_words->pending, 0);
+	next->lead = 1;
+	dispatch_semaphore_signal(convnet_and_words->semaphore);
+	dispatch_semaphore_signal(next->done);
+}
+
+static ccv_array_t* uri_convnet_classify_batched(convnet_and_words_t* convnet_and_words, ccv_dense_matrix_t* input, int top)
+{
+	convnet_request_t request = {
+		.input = input,
+		.top = top,
+		.lead = 0,
+		.rank = 0,
+		.done = dispatch_semaphore_create(0),
+	};
+	convnet_request_t* request_ref = &request;
+	dispatch_semaphore_wait(convnet_and_words->semaphore, DISPATCH_TIME_FOREVER);
+	ccv_array_push(convnet_and_words->pending, &request_ref);
+	int pending = convnet_and_words->pending->rnum;
+	// if nobody is running batches, this request is the first in the queue, and it leads
+	int lead = !convnet_and_words->leading;
+	convnet_and_words->leading = 1;
+	dispatch_semaphore_signal(convnet_and_words->semaphore);
+	if (!lead)
+	{
+		if (pending == CONVNET_MAX_BATCH_SIZE)
+			dispatch_semaphore_signal(convnet_and_words->full);
+		dispatch_semaphore_wait(request.done, DISPATCH_TIME_FOREVER);
+		lead = request.lead;
+	}
+	if (lead)
+		uri_convnet_batch_run(convnet_and_words);
+	dispatch_release(request.done);
+	return request.rank;
+}
+
+static void uri_convnet_batch_init(convnet_and_words_t* convnet_and_words)
+{
+	convnet_and_words->semaphore = dispatch_semaphore_create(1);
+	convnet_and_words->full = dispatch_semaphore_create(0);
+	convnet_and_words->pending = ccv_array_new(sizeof(convnet_request_t*), CONVNET_MAX_BATCH_SIZE, 0);
+	convnet_and_words->leading = 0;
+}
+
 void* uri_convnet_classify_init(void)
 {
 	convnet_context_t* context = (convnet_context_t*)malloc(sizeof(convnet_context_t));
@@ -102,6 +207,8 @@ void* uri_convnet_classify_init(void)
 	context->image_net[1].words = uri_convnet_words_read("../samples/image-net-2012.words");
 	assert(context->image_net[1].words);
 	context->image_net[1].convnet = ccv_convnet_read(0, "../samples/image-net-2012-vgg-d.sqlite3");
+	uri_convnet_batch_init(&context->image_net[0]);
+	uri_convnet_batch_init(&context->image_net[1]);
 	assert(param_parser_map_alphabet(param_map, sizeof(param_map) / sizeof(param_dispatch_t)) == 0);
 	context->desc = param_parser_map_http_body(param_map, sizeof(param_map) / sizeof(param_dispatch_t),
 		"[{"
@@ -124,6 +231,9 @@ void uri_convnet_classify_destroy(void* context)
 			free(word);
 		}
 		ccv_array_free(convnet_context->image_net[i].words);
+		dispatch_release(convnet_context->image_net[i].semaphore);
+		dispatch_release(convnet_context->image_net[i].full);
+		ccv_array_free(convnet_context->image_net[i].pending);
 	}
 	free(convnet_context->desc.data);
 	free(convnet_context);
@@ -202,8 +312,7 @@ int uri_convnet_classify(const void* context, const void* parsed, ebb_buf* buf)
 	ccv_dense_matrix_t* input = 0;
 	ccv_convnet_input_formation(convnet->input, image, &input);
 	ccv_matrix_free(image);
-	ccv_array_t* rank = 0;
-	ccv_convnet_classify(convnet, &input, 1, &rank, parser->top, 1);
+	ccv_array_t* rank = uri_convnet_classify_batched(parser->convnet_and_words, input, parser->top);
 	// print out
 	buf->len = 192 + rank->rnum * 30 + 2;
 	char* data = (char*)malloc(buf->len);
@@ -234,25 +234,18 @@ int uri_swt_detect_words(const void* context, const void* parsed, ebb_buf* buf)
 		return -1;
 	}
 	ccv_dense_matrix_t* image = 0;
-	ccv_read(parser->source.data, &image, CCV_IO_ANY_STREAM | CCV_IO_GRAY, parser->source.written);
+	ccv_read_fit(parser->source.data, &image, CCV_IO_ANY_STREAM | CCV_IO_GRAY, parser->source.written, parser->params.max_dimension, parser->params.max_dimension);
 	free(parser->source.data);
 	if (image == 0)
 	{
 		free(parser);
 		return -1;
 	}
-	ccv_dense_matrix_t* resize = 0;
-	if (parser->params.max_dimension > 0 && (image->rows > parser->params.max_dimension || image->cols > parser->params.max_dimension))
-	{
-		ccv_resample(image, &resize, 0, ccv_min(parser->params.max_dimension, (int)(image->rows * (float)parser->params.max_dimension / image->cols + 0.5)), ccv_min(parser->params.max_dimension, (int)(image->cols * (float)parser->params.max_dimension / image->rows + 0.5)), CCV_INTER_AREA);
-		ccv_matrix_free(image);
-	} else
-		resize = image;
-	ccv_array_t* seq = ccv_swt_detect_words(resize, parser->params.params);
-	float width = resize->cols, height = resize->rows;
+	ccv_array_t* seq = ccv_swt_detect_words(image, parser->params.params);
+	float width = image->cols, height = image->rows;
 	if (seq  == 0)
 	{
-		ccv_matrix_free(resize);
+		ccv_matrix_free(image);
 		free(parser);
 		return -1;
 	}
@@ -271,7 +264,7 @@ int uri_swt_detect_words(const void* context, const void* parsed, ebb_buf* buf)
 			if (parser->context->tesseract)
 			{
 				char empty[] = "";
-				char* word = TessBaseAPIRect(parser->context->tesseract, resize->data.u8, 1, resize->step, rect->x, rect->y, rect->width, rect->height);
+				char* word = TessBaseAPIRect(parser->context->tesseract, image->data.u8, 1, image->step, rect->x, rect->y, rect->width, rect->height);
 				if (!word)
 					word = empty;
 				int wordlen = strlen(word); // trust tesseract to return correct thing
@@ -327,7 +320,7 @@ int uri_swt_detect_words(const void* context, const void* parsed, ebb_buf* buf)
 		buf->len = sizeof(ebb_http_empty_array);
 		buf->on_release = 0;
 	}
-	ccv_matrix_free(resize);
+	ccv_matrix_free(image);
 	ccv_array_free(seq);
 	free(parser);
 	return 0;
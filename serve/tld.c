@@ -3,6 +3,9 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <ctype.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
 #include <dispatch/dispatch.h>
 
 static void uri_tld_on_previous_blob(void* context, ebb_buf data);
@@ -10,6 +13,8 @@ static void uri_tld_on_source_blob(void* context, ebb_buf data);
 
 typedef struct {
 	int tld;
+	int rows;
+	int cols;
 	ccv_tld_param_t params;
 	ccv_rect_t box;
 } ccv_tld_uri_param_t;
@@ -20,6 +25,11 @@ static const param_dispatch_t param_map[] = {
 		.type = PARAM_TYPE_INT,
 		.offset = offsetof(ccv_tld_uri_param_t, params) + offsetof(ccv_tld_param_t, bad_patches),
 	},
+	{
+		.property = "cols",
+		.type = PARAM_TYPE_INT,
+		.offset = offsetof(ccv_tld_uri_param_t, cols),
+	},
 	{
 		.property = "exclude_overlap",
 		.type = PARAM_TYPE_FLOAT,
@@ -121,6 +131,16 @@ static const param_dispatch_t param_map[] = {
 		.type = PARAM_TYPE_INT,
 		.offset = offsetof(ccv_tld_uri_param_t, params) + offsetof(ccv_tld_param_t, rotation),
 	},
+	{
+		.property = "rows",
+		.type = PARAM_TYPE_INT,
+		.offset = offsetof(ccv_tld_uri_param_t, rows),
+	},
+	{
+		.property = "search_region",
+		.type = PARAM_TYPE_FLOAT,
+		.offset = offsetof(ccv_tld_uri_param_t, params) + offsetof(ccv_tld_param_t, search_region),
+	},
 	{
 		.property = "shift",
 		.type = PARAM_TYPE_FLOAT,
@@ -194,16 +214,50 @@ static const param_dispatch_t param_map[] = {
 	},
 };
 
+
+#define TLD_MAX_WORKERS (64)
+#define TLD_SESSION_IDLE_TIMEOUT (60) // in seconds, a tracking session without any request for this long will be evicted
+
 typedef struct {
-	ebb_buf desc;
-	ccv_array_t* tlds;
-	dispatch_semaphore_t semaphore;
-} tld_context_t;
+	int refcount; // one from the sessions array, and one from each request in flight, guarded by the context semaphore
+	int worker; // the worker this session is pinned to
+	time_t last_access;
+	ccv_tld_t* tld;
+	ccv_dense_matrix_t* previous; // the last frame, thus, a request only needs to push the new frame
+	void* previous_data; // the data block of previous if it is read without copy
+	uint64_t previous_content_sig; // the content signature of previous, thus, a supplied previous frame can be matched to it
+	uint64_t frame_count; // frames are signed with this counter, identical frames in a row would share a content signature otherwise
+} tld_session_t;
+
+typedef struct {
+	tld_session_t* session;
+	ccv_rect_t box; // if it is not zero, initialize the tracking session with source
+	ccv_tld_param_t params;
+	ccv_dense_matrix_t* previous; // if supplied, it will be used in place of the session's last frame
+	ccv_dense_matrix_t* source; // the worker takes the ownership of source and its data block
+	void* source_data;
+	ccv_comp_t result;
+	ccv_tld_info_t info;
+	int status;
+	dispatch_semaphore_t done;
+} tld_job_t;
+
+typedef struct {
+	pthread_t thread;
+	void* context;
+	int id;
+	int sessions; // how many sessions pinned to this worker, guarded by the context semaphore
+	ccv_array_t* jobs; // guarded by the context semaphore
+	dispatch_semaphore_t pending;
+} tld_worker_t;
 
 typedef struct {
+	ebb_buf desc;
+	ccv_array_t* sessions;
+	int worker_count;
+	tld_worker_t* workers;
 	dispatch_semaphore_t semaphore;
-	ccv_tld_t* tld;
-} ccv_thread_safe_tld_t;
+} tld_context_t;
 
 typedef struct {
 	param_parser_t param_parser;
@@ -224,12 +278,204 @@ static void uri_tld_on_source_blob(void* context, ebb_buf data)
 	parser->source = data;
 }
 
+static void uri_tld_frame_free(ccv_dense_matrix_t* frame, void* data)
+{
+	ccv_matrix_free(frame);
+	if (data)
+		free(data);
+}
+
+static void uri_tld_session_release(tld_context_t* tld_context, tld_session_t* session)
+{
+	dispatch_semaphore_wait(tld_context->semaphore, DISPATCH_TIME_FOREVER);
+	int refcount = --session->refcount;
+	dispatch_semaphore_signal(tld_context->semaphore);
+	if (refcount > 0)
+		return;
+	if (session->tld)
+		ccv_tld_free(session->tld);
+	if (session->previous)
+		uri_tld_frame_free(session->previous, session->previous_data);
+	free(session);
+}
+
+static void uri_tld_evict_idle_sessions(tld_context_t* tld_context, int worker)
+{
+	int i;
+	time_t now = time(0);
+	ccv_array_t* evicted = ccv_array_new(sizeof(tld_session_t*), 4, 0);
+	dispatch_semaphore_wait(tld_context->semaphore, DISPATCH_TIME_FOREVER);
+	for (i = 0; i < tld_context->sessions->rnum; i++)
+	{
+		tld_session_t* session = *(tld_session_t**)ccv_array_get(tld_context->sessions, i);
+		// only evict the ones that are not in use
+		if (session && session->worker == worker && session->refcount == 1 && now - session->last_access > TLD_SESSION_IDLE_TIMEOUT)
+		{
+			*(tld_session_t**)ccv_array_get(tld_context->sessions, i) = 0;
+			--tld_context->workers[worker].sessions;
+			ccv_array_push(evicted, &session);
+		}
+	}
+	dispatch_semaphore_signal(tld_context->semaphore);
+	for (i = 0; i < evicted->rnum; i++)
+		uri_tld_session_release(tld_context, *(tld_session_t**)ccv_array_get(evicted, i));
+	ccv_array_free(evicted);
+}
+
+static void uri_tld_job_run(tld_job_t* job)
+{
+	tld_session_t* session = job->session;
+	job->status = -1;
+	// frames only carry the signature of their content (raw ones included), sign them with the session's frame counter
+	// so that the tracker's frame signature check tells the last frame apart from an identical earlier one
+	uint64_t content_sig = job->source->sig;
+	++session->frame_count;
+	job->source->sig = ccv_cache_generate_signature((const char*)&session->frame_count, sizeof(session->frame_count), content_sig, (uint64_t)0);
+	if (!ccv_rect_is_zero(job->box))
+	{
+		if (session->tld == 0)
+		{
+			session->tld = ccv_tld_new(job->source, job->box, job->params);
+			job->result.rect = job->box;
+			job->result.classification.confidence = 1;
+			job->status = 0;
+		}
+	} else {
+		ccv_dense_matrix_t* previous = job->previous ? job->previous : session->previous;
+		// a supplied previous frame is the session's last frame only if it has the same content
+		if (job->previous && session->previous && job->previous->sig == session->previous_content_sig)
+			job->previous->sig = session->previous->sig;
+		if (session->tld && previous &&
+			previous->rows == job->source->rows && previous->cols == job->source->cols &&
+			session->tld->frame_signature == previous->sig)
+		{
+			job->result = ccv_tld_track_object(session->tld, previous, job->source, &job->info);
+			job->status = 0;
+		}
+	}
+	if (job->status == 0)
+	{
+		// keep the frame for the next request
+		if (session->previous)
+			uri_tld_frame_free(session->previous, session->previous_data);
+		session->previous = job->source;
+		session->previous_data = job->source_data;
+		session->previous_content_sig = content_sig;
+	} else
+		uri_tld_frame_free(job->source, job->source_data);
+}
+
+static void* uri_tld_worker_main(void* arg)
+{
+	tld_worker_t* worker = (tld_worker_t*)arg;
+	tld_context_t* tld_context = (tld_context_t*)worker->context;
+	time_t last_eviction = time(0);
+	for (;;)
+	{
+		// wake up once in a while to evict idle sessions even if there is no request
+		if (dispatch_semaphore_wait(worker->pending, dispatch_time(DISPATCH_TIME_NOW, (int64_t)TLD_SESSION_IDLE_TIMEOUT * NSEC_PER_SEC / 2)) == 0)
+		{
+			dispatch_semaphore_wait(tld_context->semaphore, DISPATCH_TIME_FOREVER);
+			tld_job_t* job = *(tld_job_t**)ccv_array_get(worker->jobs, 0);
+			memmove(ccv_array_get(worker->jobs, 0), ccv_array_get(worker->jobs, 1), sizeof(tld_job_t*) * (worker->jobs->rnum - 1));
+			--worker->jobs->rnum;
+			dispatch_semaphore_signal(tld_context->semaphore);
+			if (!job) // asked to terminate
+				break;
+			uri_tld_job_run(job);
+			dispatch_semaphore_signal(job->done);
+		}
+		if (time(0) - last_eviction >= TLD_SESSION_IDLE_TIMEOUT / 2)
+		{
+			uri_tld_evict_idle_sessions(tld_context, worker->id);
+			last_eviction = time(0);
+		}
+	}
+	return 0;
+}
+
+// run the job on the worker the session is pinned to, and wait for it to finish
+static void uri_tld_job_submit(tld_context_t* tld_context, tld_job_t* job)
+{
+	tld_worker_t* worker = tld_context->workers + job->session->worker;
+	job->done = dispatch_semaphore_create(0);
+	dispatch_semaphore_wait(tld_context->semaphore, DISPATCH_TIME_FOREVER);
+	ccv_array_push(worker->jobs, &job);
+	dispatch_semaphore_signal(tld_context->semaphore);
+	dispatch_semaphore_signal(worker->pending);
+	dispatch_semaphore_wait(job->done, DISPATCH_TIME_FOREVER);
+	dispatch_release(job->done);
+}
+
+static tld_session_t* uri_tld_session_new(tld_context_t* tld_context, int* tld_ident)
+{
+	tld_session_t* session = (tld_session_t*)malloc(sizeof(tld_session_t));
+	session->refcount = 2; // one for the sessions array, and one for the request
+	session->last_access = time(0);
+	session->tld = 0;
+	session->previous = 0;
+	session->previous_data = 0;
+	session->previous_content_sig = 0;
+	session->frame_count = 0;
+	int i;
+	dispatch_semaphore_wait(tld_context->semaphore, DISPATCH_TIME_FOREVER);
+	// pin to the least loaded worker
+	session->worker = 0;
+	for (i = 1; i < tld_context->worker_count; i++)
+		if (tld_context->workers[i].sessions < tld_context->workers[session->worker].sessions)
+			session->worker = i;
+	++tld_context->workers[session->worker].sessions;
+	*tld_ident = -1;
+	for (i = 0; i < tld_context->sessions->rnum; i++)
+		if (*(tld_session_t**)ccv_array_get(tld_context->sessions, i) == 0)
+		{
+			*tld_ident = i;
+			*(tld_session_t**)ccv_array_get(tld_context->sessions, i) = session;
+			break;
+		}
+	if (*tld_ident < 0)
+	{
+		*tld_ident = tld_context->sessions->rnum;
+		ccv_array_push(tld_context->sessions, &session);
+	}
+	dispatch_semaphore_signal(tld_context->semaphore);
+	return session;
+}
+
+static tld_session_t* uri_tld_session_find(tld_context_t* tld_context, int tld_ident)
+{
+	tld_session_t* session = 0;
+	dispatch_semaphore_wait(tld_context->semaphore, DISPATCH_TIME_FOREVER);
+	if (tld_ident >= 0 && tld_ident < tld_context->sessions->rnum)
+		session = *(tld_session_t**)ccv_array_get(tld_context->sessions, tld_ident);
+	if (session)
+	{
+		++session->refcount;
+		session->last_access = time(0);
+	}
+	dispatch_semaphore_signal(tld_context->semaphore);
+	return session;
+}
+
 void* uri_tld_track_object_init(void)
 {
 	assert(param_parser_map_alphabet(param_map, sizeof(param_map) / sizeof(param_dispatch_t)) == 0);
 	tld_context_t* context = (tld_context_t*)malloc(sizeof(tld_context_t));
-	context->tlds = ccv_array_new(sizeof(ccv_tld_t*), 64, 0);
+	context->sessions = ccv_array_new(sizeof(tld_session_t*), 64, 0);
 	context->semaphore = dispatch_semaphore_create(1);
+	context->worker_count = ccv_clamp((int)sysconf(_SC_NPROCESSORS_ONLN), 1, TLD_MAX_WORKERS);
+	context->workers = (tld_worker_t*)malloc(sizeof(tld_worker_t) * context->worker_count);
+	int i;
+	for (i = 0; i < context->worker_count; i++)
+	{
+		tld_worker_t* worker = context->workers + i;
+		worker->context = context;
+		worker->id = i;
+		worker->sessions = 0;
+		worker->jobs = ccv_array_new(sizeof(tld_job_t*), 16, 0);
+		worker->pending = dispatch_semaphore_create(0);
+		pthread_create(&worker->thread, 0, uri_tld_worker_main, worker);
+	}
 	context->desc = param_parser_map_http_body(param_map, sizeof(param_map) / sizeof(param_dispatch_t),
 		"{"
 			"\"tld\":\"integer\","
@@ -256,7 +502,27 @@ void* uri_tld_track_object_init(void)
 void uri_tld_track_object_destroy(void* context)
 {
 	tld_context_t* tld_context = (tld_context_t*)context;
-	ccv_array_free(tld_context->tlds);
+	int i;
+	for (i = 0; i < tld_context->worker_count; i++)
+	{
+		tld_worker_t* worker = tld_context->workers + i;
+		tld_job_t* terminate = 0;
+		dispatch_semaphore_wait(tld_context->semaphore, DISPATCH_TIME_FOREVER);
+		ccv_array_push(worker->jobs, &terminate);
+		dispatch_semaphore_signal(tld_context->semaphore);
+		dispatch_semaphore_signal(worker->pending);
+		pthread_join(worker->thread, 0);
+		ccv_array_free(worker->jobs);
+		dispatch_release(worker->pending);
+	}
+	free(tld_context->workers);
+	for (i = 0; i < tld_context->sessions->rnum; i++)
+	{
+		tld_session_t* session = *(tld_session_t**)ccv_array_get(tld_context->sessions, i);
+		if (session)
+			uri_tld_session_release(tld_context, session);
+	}
+	ccv_array_free(tld_context->sessions);
 	dispatch_release(tld_context->semaphore);
 	free(tld_context->desc.data);
 	free(tld_context);
@@ -268,6 +534,8 @@ static void uri_tld_param_parser_init(tld_param_parser_t* parser)
 	parser->uri_params.params = ccv_tld_default_params;
 	parser->uri_params.box = ccv_rect(0, 0, 0, 0);
 	parser->uri_params.tld = -1;
+	parser->uri_params.rows = 0;
+	parser->uri_params.cols = 0;
 	parser->previous.data = 0;
 	parser->source.data = 0;
 }
@@ -303,6 +571,29 @@ int uri_tld_track_object_intro(const void* context, const void* parsed, ebb_buf*
 	return 0;
 }
 
+// read a frame from the blob, and take the ownership of the blob's data block. With rows and cols,
+// it is raw 8-bit grayscale pixels and read without copy to skip decoding, thus, the data block
+// is returned and has to be freed after the frame
+static ccv_dense_matrix_t* uri_tld_frame_read(tld_param_parser_t* parser, ebb_buf* blob, void** data)
+{
+	ccv_dense_matrix_t* frame = 0;
+	*data = 0;
+	if (parser->uri_params.rows > 0 && parser->uri_params.cols > 0)
+	{
+		if (blob->written >= (size_t)parser->uri_params.rows * parser->uri_params.cols)
+		{
+			ccv_read(blob->data, &frame, CCV_IO_GRAY_RAW | CCV_IO_NO_COPY, parser->uri_params.rows, parser->uri_params.cols, parser->uri_params.cols);
+			*data = blob->data;
+			return frame;
+		}
+	} else if (((char*)blob->data)[0] == '@' && blob->written == 11) {
+		// TODO: find frame in cache
+	} else
+		ccv_read(blob->data, &frame, CCV_IO_ANY_STREAM | CCV_IO_GRAY, blob->written);
+	free(blob->data);
+	return frame;
+}
+
 int uri_tld_track_object(const void* context, const void* parsed, ebb_buf* buf)
 {
 	if (!parsed)
@@ -317,67 +608,66 @@ int uri_tld_track_object(const void* context, const void* parsed, ebb_buf* buf)
 		free(parser);
 		return -1;
 	}
-	ccv_dense_matrix_t* source = 0;
-	if (((char*)parser->source.data)[0] == '@' && parser->source.len == 11)
-	{
-		// TODO: find source in cache
-	} else
-		ccv_read(parser->source.data, &source, CCV_IO_ANY_STREAM | CCV_IO_GRAY, parser->source.written);
-	free(parser->source.data);
-	if (source == 0)
+	tld_job_t job = {
+		.box = ccv_rect(0, 0, 0, 0),
+		.previous = 0,
+	};
+	job.source = uri_tld_frame_read(parser, &parser->source, &job.source_data);
+	// previous is optional, the session keeps the last frame it tracked
+	int has_previous = (parser->previous.data && parser->previous.written > 0);
+	void* previous_data = 0;
+	if (has_previous)
+		job.previous = uri_tld_frame_read(parser, &parser->previous, &previous_data);
+	else if (parser->previous.data)
+		free(parser->previous.data);
+	if (job.source == 0 || (has_previous && job.previous == 0))
 	{
-		if (parser->previous.data)
-			free(parser->previous.data);
+		if (job.source)
+			uri_tld_frame_free(job.source, job.source_data);
+		if (job.previous)
+			uri_tld_frame_free(job.previous, previous_data);
 		free(parser);
 		return -1;
 	}
-	int i;
-	ccv_dense_matrix_t* previous = 0;
-	if (parser->previous.data == 0 || parser->previous.written == 0)
+	int tld_ident = parser->uri_params.tld;
+	if (tld_ident < 0)
 	{
-		if (parser->previous.data)
-			free(parser->previous.data);
 		// to initialize
 		if (ccv_rect_is_zero(parser->uri_params.box))
 		{
-			ccv_matrix_free(source);
+			uri_tld_frame_free(job.source, job.source_data);
+			if (job.previous)
+				uri_tld_frame_free(job.previous, previous_data);
 			free(parser);
 			return -1;
 		}
-		ccv_thread_safe_tld_t thread_safe_tld = {
-			.tld = 0
-		};
-		int tld_ident = -1;
-		dispatch_semaphore_wait(tld_context->semaphore, DISPATCH_TIME_FOREVER);
-		for (i = 0; i < tld_context->tlds->rnum; i++)
-		{
-			ccv_thread_safe_tld_t* tld = (ccv_thread_safe_tld_t*)ccv_array_get(tld_context->tlds, i);
-			if (tld->tld == 0)
-			{
-				tld_ident = i;
-				thread_safe_tld = *tld;
-				break;
-			}
-		}
-		if (thread_safe_tld.tld == 0)
-		{
-			thread_safe_tld.tld = (ccv_tld_t*)1;
-			thread_safe_tld.semaphore = dispatch_semaphore_create(1);
-			tld_ident = tld_context->tlds->rnum;
-			ccv_array_push(tld_context->tlds, &thread_safe_tld);
-		}
-		dispatch_semaphore_signal(tld_context->semaphore);
-		dispatch_semaphore_wait(thread_safe_tld.semaphore, DISPATCH_TIME_FOREVER);
-		thread_safe_tld.tld = ccv_tld_new(source, parser->uri_params.box, parser->uri_params.params);
-		dispatch_semaphore_signal(thread_safe_tld.semaphore);
-		ccv_matrix_free(source);
-		dispatch_semaphore_wait(tld_context->semaphore, DISPATCH_TIME_FOREVER);
-		*(ccv_thread_safe_tld_t*)ccv_array_get(tld_context->tlds, tld_ident) = thread_safe_tld; // set the real tld pointer
-		dispatch_semaphore_signal(tld_context->semaphore);
-		parser->uri_params.tld = tld_ident;
+		job.box = parser->uri_params.box;
+		job.params = parser->uri_params.params;
+		job.session = uri_tld_session_new(tld_context, &tld_ident);
+	} else
+		job.session = uri_tld_session_find(tld_context, tld_ident);
+	if (job.session == 0)
+	{
+		uri_tld_frame_free(job.source, job.source_data);
+		if (job.previous)
+			uri_tld_frame_free(job.previous, previous_data);
+		free(parser);
+		return -1;
+	}
+	uri_tld_job_submit(tld_context, &job);
+	uri_tld_session_release(tld_context, job.session);
+	if (job.previous)
+		uri_tld_frame_free(job.previous, previous_data);
+	if (job.status != 0)
+	{
+		free(parser);
+		return -1;
+	}
+	if (!ccv_rect_is_zero(job.box))
+	{
 		// print out box and tld
 		char cell[128];
-		snprintf(cell, 128, "{\"tld\":%d,\"box\":{\"x\":%d,\"y\":%d,\"width\":%d,\"height\":%d,\"confidence\":1}}\n", tld_ident, parser->uri_params.box.x, parser->uri_params.box.y, parser->uri_params.box.width, parser->uri_params.box.height);
+		snprintf(cell, 128, "{\"tld\":%d,\"box\":{\"x\":%d,\"y\":%d,\"width\":%d,\"height\":%d,\"confidence\":1}}\n", tld_ident, job.box.x, job.box.y, job.box.width, job.box.height);
 		size_t len = strlen(cell);
 		char* data = (char*)malloc(192 + len);;
 		static const char ebb_http_tld_created[] = "HTTP/1.1 201 Created\r\nCache-Control: no-cache\r\nContent-Type: application/json; charset=utf-8\r\nLocation: /tld/track.object/%d\r\nContent-Length: %zd\r\n\r\n";
@@ -388,51 +678,6 @@ int uri_tld_track_object(const void* context, const void* parsed, ebb_buf* buf)
 		buf->len = data_len + len;
 		buf->on_release = uri_ebb_buf_free;
 	} else {
-		if (parser->uri_params.tld < 0)
-		{
-			free(parser->previous.data);
-			free(parser);
-			return -1;
-		}
-		if (((char*)parser->previous.data)[0] == '@' && parser->previous.written == 11)
-		{
-			// TODO: find previous in cache
-		} else
-			ccv_read(parser->previous.data, &previous, CCV_IO_ANY_STREAM | CCV_IO_GRAY, parser->previous.written);
-		free(parser->previous.data);
-		if (previous == 0)
-		{
-			free(parser);
-			return -1;
-		}
-		ccv_thread_safe_tld_t thread_safe_tld = {
-			.tld = 0,
-		};
-		dispatch_semaphore_wait(tld_context->semaphore, DISPATCH_TIME_FOREVER);
-		if (parser->uri_params.tld < tld_context->tlds->rnum)
-			thread_safe_tld = *(ccv_thread_safe_tld_t*)ccv_array_get(tld_context->tlds, parser->uri_params.tld);
-		dispatch_semaphore_signal(tld_context->semaphore);
-		if (thread_safe_tld.tld == 0)
-		{
-			ccv_matrix_free(previous);
-			ccv_matrix_free(source);
-			free(parser);
-			return -1;
-		}
-		dispatch_semaphore_wait(thread_safe_tld.semaphore, DISPATCH_TIME_FOREVER);
-		if (thread_safe_tld.tld->frame_signature != previous->sig)
-		{
-			dispatch_semaphore_signal(thread_safe_tld.semaphore);
-			ccv_matrix_free(previous);
-			ccv_matrix_free(source);
-			free(parser);
-			return -1;
-		}
-		ccv_tld_info_t info;
-		ccv_comp_t box = ccv_tld_track_object(thread_safe_tld.tld, previous, source, &info);
-		dispatch_semaphore_signal(thread_safe_tld.semaphore);
-		ccv_matrix_free(previous);
-		ccv_matrix_free(source);
 		char cell[320];
 		snprintf(cell, 320,
 			"{\"tld\":%d,"
@@ -453,16 +698,16 @@ int uri_tld_track_object(const void* context, const void* parsed, ebb_buf* buf)
 				"\"confident_matches\":%d,"
 				"\"close_matches\":%d"
 			"}}\n",
-			parser->uri_params.tld,
-			box.rect.x, box.rect.y, box.rect.width, box.rect.height, box.classification.confidence,
-			info.perform_track ? "true" : "false",
-			info.perform_learn ? "true" : "false",
-			info.track_success ? "true" : "false",
-			info.ferns_detects,
-			info.nnc_detects,
-			info.clustered_detects,
-			info.confident_matches,
-			info.close_matches
+			tld_ident,
+			job.result.rect.x, job.result.rect.y, job.result.rect.width, job.result.rect.height, job.result.classification.confidence,
+			job.info.perform_track ? "true" : "false",
+			job.info.perform_learn ? "true" : "false",
+			job.info.track_success ? "true" : "false",
+			job.info.ferns_detects,
+			job.info.nnc_detects,
+			job.info.clustered_detects,
+			job.info.confident_matches,
+			job.info.close_matches
 		);
 		size_t len = strlen(cell);
 		char* data = (char*)malloc(192 + len);;
@@ -493,29 +738,22 @@ int uri_tld_track_object_free(const void* context, const void* parsed, ebb_buf*
 		free(parser);
 		return -1;
 	}
-	ccv_thread_safe_tld_t thread_safe_tld = {
-		.tld = 0,
-	};
+	tld_session_t* session = 0;
 	dispatch_semaphore_wait(tld_context->semaphore, DISPATCH_TIME_FOREVER);
-	if (parser->uri_params.tld < tld_context->tlds->rnum)
+	if (parser->uri_params.tld < tld_context->sessions->rnum)
 	{
-		thread_safe_tld = *(ccv_thread_safe_tld_t*)ccv_array_get(tld_context->tlds, parser->uri_params.tld);
-		ccv_thread_safe_tld_t dummy_tld = thread_safe_tld;
-		dummy_tld.tld = 0;
-		*(ccv_thread_safe_tld_t*)ccv_array_get(tld_context->tlds, parser->uri_params.tld) = dummy_tld;
+		session = *(tld_session_t**)ccv_array_get(tld_context->sessions, parser->uri_params.tld);
+		*(tld_session_t**)ccv_array_get(tld_context->sessions, parser->uri_params.tld) = 0;
+		if (session)
+			--tld_context->workers[session->worker].sessions;
 	}
 	dispatch_semaphore_signal(tld_context->semaphore);
-	if (!thread_safe_tld.tld)
-	{
-		free(parser);
+	free(parser);
+	if (!session)
 		return -1;
-	} else {
-		dispatch_semaphore_wait(thread_safe_tld.semaphore, DISPATCH_TIME_FOREVER);
-		ccv_tld_free(thread_safe_tld.tld);
-		dispatch_semaphore_signal(thread_safe_tld.semaphore);
-		buf->data = (void*)ebb_http_ok_true;
-		buf->len = sizeof(ebb_http_ok_true) - 1;
-		free(parser);
-	}
+	// the session will be freed once the requests in flight are done with it
+	uri_tld_session_release(tld_context, session);
+	buf->data = (void*)ebb_http_ok_true;
+	buf->len = sizeof(ebb_http_ok_true) - 1;
 	return 0;
 }
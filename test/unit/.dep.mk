@@ -0,0 +1,37 @@
+algebra.tests.o: algebra.tests.c ../../lib/ccv.h \
+ ../../lib/nnc/ccv_nnc_tfb.h ../case.h ../case_main.h
+util.tests.o: util.tests.c ../../lib/ccv.h ../../lib/nnc/ccv_nnc_tfb.h \
+ ../case.h ../ccv_case.h ../../lib/3rdparty/dsfmt/dSFMT.h \
+ ../../lib/3rdparty/sfmt/SFMT.h ../../lib/3rdparty/sfmt/SFMT-params.h \
+ ../../lib/3rdparty/sfmt/SFMT-params19937.h ../case_main.h
+numeric.tests.o: numeric.tests.c ../../lib/ccv.h \
+ ../../lib/nnc/ccv_nnc_tfb.h ../case.h ../ccv_case.h \
+ ../../lib/3rdparty/dsfmt/dSFMT.h ../../lib/ccv_internal.h ../case_main.h
+basic.tests.o: basic.tests.c ../../lib/ccv.h ../../lib/nnc/ccv_nnc_tfb.h \
+ ../case.h ../ccv_case.h ../case_main.h
+image_processing.tests.o: image_processing.tests.c ../../lib/ccv.h \
+ ../../lib/nnc/ccv_nnc_tfb.h ../case.h ../ccv_case.h ../case_main.h
+memory.tests.o: memory.tests.c ../../lib/ccv.h \
+ ../../lib/nnc/ccv_nnc_tfb.h ../../lib/ccv_internal.h ../case.h \
+ ../case_main.h
+io.tests.o: io.tests.c ../../lib/ccv.h ../../lib/nnc/ccv_nnc_tfb.h \
+ ../case.h ../ccv_case.h ../case_main.h
+transform.tests.o: transform.tests.c ../../lib/ccv.h \
+ ../../lib/nnc/ccv_nnc_tfb.h ../case.h ../ccv_case.h ../case_main.h
+convnet.tests.o: convnet.tests.c ../../lib/ccv.h \
+ ../../lib/nnc/ccv_nnc_tfb.h ../case.h ../ccv_case.h \
+ ../../lib/3rdparty/dsfmt/dSFMT.h ../../lib/ccv_convnet.c ../../lib/ccv.h \
+ ../../lib/ccv_internal.h ../../lib/3rdparty/sqlite3/sqlite3.h \
+ ../../lib/inc/ccv_convnet_internal.h ../case_main.h
+3rdparty.tests.o: 3rdparty.tests.c ../../lib/ccv.h \
+ ../../lib/nnc/ccv_nnc_tfb.h ../case.h ../ccv_case.h \
+ ../../lib/3rdparty/sfmt/SFMT.h ../../lib/3rdparty/sfmt/SFMT-params.h \
+ ../../lib/3rdparty/sfmt/SFMT-params19937.h ../case_main.h
+output.tests.o: output.tests.c ../../lib/ccv.h \
+ ../../lib/nnc/ccv_nnc_tfb.h ../case.h ../ccv_case.h ../case_main.h
+bbf.tests.o: bbf.tests.c ../../lib/ccv.h ../../lib/nnc/ccv_nnc_tfb.h \
+ ../case.h ../ccv_case.h ../case_main.h
+tld.tests.o: tld.tests.c ../../lib/ccv.h ../../lib/nnc/ccv_nnc_tfb.h \
+ ../case.h ../ccv_case.h ../case_main.h
+sift.tests.o: sift.tests.c ../../lib/ccv.h ../../lib/nnc/ccv_nnc_tfb.h \
+ ../case.h ../ccv_case.h ../case_main.h
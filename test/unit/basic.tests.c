@@ -74,6 +74,67 @@ TEST_CASE("sample up operation with source offset (10, 10)")
 	ccv_matrix_free(x);
 }
 
+TEST_CASE("pyramid levels are computed once and match resample / sample down")
+{
+	ccv_dense_matrix_t* image = 0;
+	ccv_read("../../samples/chessbox.png", &image, CCV_IO_ANY_FILE);
+	ccv_pyramid_t* pyramid = ccv_pyramid_new(image, 0);
+	ccv_dense_matrix_t* x = ccv_pyramid_resample(pyramid, image, image->rows / 5, image->cols / 5, CCV_INTER_AREA);
+	REQUIRE_MATRIX_FILE_EQ(x, "data/chessbox.resample.bin", "should be a image of color dot");
+	REQUIRE(x == ccv_pyramid_resample(pyramid, image, image->rows / 5, image->cols / 5, CCV_INTER_AREA), "should be the same level from the pyramid");
+	ccv_dense_matrix_t* y = ccv_pyramid_sample_down(pyramid, image, 10, 10);
+	REQUIRE_MATRIX_FILE_EQ(y, "data/chessbox.sample_down.bin", "should be down sampled (/2) image with offset from source (10, 10)");
+	REQUIRE(y == ccv_pyramid_sample_down(pyramid, image, 10, 10), "should be the same level from the pyramid");
+	REQUIRE(ccv_pyramid_sample_down(pyramid, y, 0, 0) == ccv_pyramid_sample_down(pyramid, y, 0, 0), "should be the same level derived from another level");
+	REQUIRE(y != ccv_pyramid_sample_down(pyramid, image, 0, 0), "should be a different level with different source offset");
+	REQUIRE_EQ(pyramid->entries->rnum, 4, "should only have 4 levels");
+	ccv_pyramid_free(pyramid);
+	ccv_matrix_free(image);
+}
+
+TEST_CASE("pyramid feature channels are only kept with CCV_PYRAMID_CACHE_FEATURE")
+{
+	ccv_dense_matrix_t* image = 0;
+	ccv_read("../../samples/chessbox.png", &image, CCV_IO_GRAY | CCV_IO_ANY_FILE);
+	ccv_pyramid_t* pyramid = ccv_pyramid_new(image, 0);
+	ccv_dense_matrix_t* hog = ccv_pyramid_hog(pyramid, image, 9, 8);
+	ccv_dense_matrix_t* x = 0;
+	ccv_hog(image, &x, 0, 9, 8);
+	REQUIRE_MATRIX_EQ(hog, x, "should be the same HOG feature");
+	ccv_pyramid_release(pyramid, hog);
+	REQUIRE_EQ(pyramid->entries->rnum, 0, "the HOG feature should be freed once released");
+	ccv_pyramid_free(pyramid);
+	pyramid = ccv_pyramid_new(image, CCV_PYRAMID_CACHE_FEATURE);
+	hog = ccv_pyramid_hog(pyramid, image, 9, 8);
+	REQUIRE_MATRIX_EQ(hog, x, "should be the same HOG feature");
+	ccv_pyramid_release(pyramid, hog);
+	REQUIRE(hog == ccv_pyramid_hog(pyramid, image, 9, 8), "the HOG feature should be kept");
+	ccv_pyramid_free(pyramid);
+	ccv_matrix_free(x);
+	ccv_matrix_free(image);
+}
+
+TEST_CASE("pyramid levels are freed after the last release unless CCV_PYRAMID_CACHE_LEVEL")
+{
+	ccv_dense_matrix_t* image = 0;
+	ccv_read("../../samples/chessbox.png", &image, CCV_IO_ANY_FILE);
+	ccv_pyramid_t* pyramid = ccv_pyramid_new(image, 0);
+	ccv_dense_matrix_t* x = ccv_pyramid_sample_down(pyramid, image, 0, 0);
+	REQUIRE(x == ccv_pyramid_sample_down(pyramid, image, 0, 0), "should be the same level from the pyramid");
+	ccv_pyramid_release(pyramid, x);
+	REQUIRE_EQ(pyramid->entries->rnum, 1, "the level is still in use by the second caller");
+	ccv_pyramid_release(pyramid, x);
+	REQUIRE_EQ(pyramid->entries->rnum, 0, "the level should be freed after the last release");
+	ccv_pyramid_free(pyramid);
+	pyramid = ccv_pyramid_new(image, CCV_PYRAMID_CACHE_LEVEL);
+	x = ccv_pyramid_sample_down(pyramid, image, 0, 0);
+	ccv_pyramid_release(pyramid, x);
+	REQUIRE_EQ(pyramid->entries->rnum, 1, "the level should be kept");
+	REQUIRE(x == ccv_pyramid_sample_down(pyramid, image, 0, 0), "should get the kept level back");
+	ccv_pyramid_free(pyramid);
+	ccv_matrix_free(image);
+}
+
 TEST_CASE("blur operation with sigma 10")
 {
 	ccv_dense_matrix_t* image = 0;
@@ -0,0 +1,49 @@
+#include "ccv.h"
+#include "case.h"
+#include "ccv_case.h"
+
+TEST_CASE("parallel scan of BBF detects the same objects as the serial scan")
+{
+	ccv_bbf_classifier_cascade_t* cascade = ccv_bbf_read_classifier_cascade("../../samples/face");
+	static const char* const filenames[] = {
+		"../../samples/nature.png",
+		"../../samples/street.png",
+	};
+	int i, j, k;
+	int total = 0;
+	for (k = 0; k < sizeof(filenames) / sizeof(filenames[0]); k++)
+	{
+		ccv_dense_matrix_t* image = 0;
+		ccv_read(filenames[k], &image, CCV_IO_GRAY | CCV_IO_ANY_FILE);
+		for (i = 0; i < 3; i++)
+		{
+			ccv_bbf_param_t params = ccv_bbf_default_params;
+			// Without grouping, thus, every window passed the cascade is compared, with and without spatial variations.
+			if (i < 2)
+			{
+				params.accurate = i;
+				params.min_neighbors = 0;
+			}
+			ccv_array_t* seq = ccv_bbf_detect_objects(image, &cascade, 1, params);
+			total += seq->rnum;
+			params.flags |= CCV_BBF_PARALLEL;
+			ccv_array_t* pseq = ccv_bbf_detect_objects(image, &cascade, 1, params);
+			REQUIRE_EQ(seq->rnum, pseq->rnum, "should have the same number of detections on %s", filenames[k]);
+			for (j = 0; j < seq->rnum; j++)
+			{
+				ccv_comp_t* comp = (ccv_comp_t*)ccv_array_get(seq, j);
+				ccv_comp_t* pcomp = (ccv_comp_t*)ccv_array_get(pseq, j);
+				REQUIRE(comp->rect.x == pcomp->rect.x && comp->rect.y == pcomp->rect.y && comp->rect.width == pcomp->rect.width && comp->rect.height == pcomp->rect.height, "detection %d on %s should be the same", j, filenames[k]);
+				REQUIRE_EQ(comp->neighbors, pcomp->neighbors, "detection %d on %s should have the same neighbors", j, filenames[k]);
+				REQUIRE_EQ_WITH_TOLERANCE(comp->classification.confidence, pcomp->classification.confidence, 1e-6, "detection %d on %s should have the same confidence", j, filenames[k]);
+			}
+			ccv_array_free(seq);
+			ccv_array_free(pseq);
+		}
+		ccv_matrix_free(image);
+	}
+	REQUIRE(total > 0, "should have some detections to compare");
+	ccv_bbf_classifier_cascade_free(cascade);
+}
+
+#include "case_main.h"
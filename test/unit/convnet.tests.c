@@ -887,6 +887,200 @@ TEST_CASE("local response normalization with partitioned by 2")
 // so that we can test static functions, note that CASE_TESTS is defined in case.h, which will disable all extern functions
 #include "ccv_convnet.c"
 
+// A convolutional, a max pool and a full connect layer on 16x16 images to classify them in 10 classes, the weights
+// are random from the seed, thus, networks from the same seed are the same.
+static ccv_convnet_t* _ccv_convnet_small_new(const uint32_t seed)
+{
+	ccv_convnet_layer_param_t params[] = {
+		{
+			.type = CCV_CONVNET_CONVOLUTIONAL,
+			.bias = 0,
+			.glorot = sqrtf(2),
+			.input = {
+				.matrix = {
+					.rows = 12,
+					.cols = 12,
+					.channels = 3,
+					.partition = 1,
+				},
+			},
+			.output = {
+				.convolutional = {
+					.count = 4,
+					.strides = 1,
+					.border = 1,
+					.rows = 3,
+					.cols = 3,
+					.channels = 3,
+					.partition = 1,
+				},
+			},
+		},
+		{
+			.type = CCV_CONVNET_MAX_POOL,
+			.input = {
+				.matrix = {
+					.rows = 12,
+					.cols = 12,
+					.channels = 4,
+					.partition = 1,
+				},
+			},
+			.output = {
+				.pool = {
+					.size = 2,
+					.strides = 2,
+					.border = 0,
+				},
+			},
+		},
+		{
+			.type = CCV_CONVNET_FULL_CONNECT,
+			.bias = 0,
+			.glorot = sqrtf(2),
+			.input = {
+				.matrix = {
+					.rows = 6,
+					.cols = 6,
+					.channels = 4,
+					.partition = 1,
+				},
+				.node = {
+					.count = 6 * 6 * 4,
+				},
+			},
+			.output = {
+				.full_connect = {
+					.relu = 0,
+					.count = 10,
+				},
+			},
+		},
+	};
+	ccv_convnet_t* convnet = ccv_convnet_new(0, ccv_size(16, 16), params, 3);
+	dsfmt_t dsfmt;
+	dsfmt_init_gen_rand(&dsfmt, seed);
+	int i;
+	for (i = 0; i < 3 * 3 * 3 * 4; i++)
+		convnet->layers[0].w[i] = dsfmt_genrand_open_close(&dsfmt) * 2 - 1;
+	for (i = 0; i < 6 * 6 * 4 * 10; i++)
+		convnet->layers[2].w[i] = (dsfmt_genrand_open_close(&dsfmt) * 2 - 1) * 0.1;
+	return convnet;
+}
+
+TEST_CASE("classify a batch of images is the same as classify them one by one")
+{
+	ccv_convnet_t* convnet = _ccv_convnet_small_new(0);
+	dsfmt_t dsfmt;
+	dsfmt_init_gen_rand(&dsfmt, 1);
+	int i, j;
+	ccv_dense_matrix_t* a[3];
+	for (i = 0; i < 3; i++)
+	{
+		a[i] = ccv_dense_matrix_new(16, 16, CCV_32F | CCV_C3, 0, 0);
+		for (j = 0; j < 16 * 16 * 3; j++)
+			a[i]->data.f32[j] = dsfmt_genrand_open_close(&dsfmt);
+	}
+	ccv_array_t* ranks[3];
+	ccv_convnet_classify(convnet, a, 1, ranks, 5, 3);
+	for (i = 0; i < 3; i++)
+	{
+		ccv_array_t* rank = 0;
+		ccv_convnet_classify(convnet, a + i, 1, &rank, 5, 1);
+		REQUIRE_EQ(rank->rnum, ranks[i]->rnum, "should have the same number of classes");
+		for (j = 0; j < rank->rnum; j++)
+		{
+			ccv_classification_t* expected = (ccv_classification_t*)ccv_array_get(rank, j);
+			ccv_classification_t* actual = (ccv_classification_t*)ccv_array_get(ranks[i], j);
+			REQUIRE_EQ(actual->id, expected->id, "should be the same class");
+			REQUIRE_EQ_WITH_TOLERANCE(actual->confidence, expected->confidence, 1e-5, "should be the same confidence");
+		}
+		ccv_array_free(rank);
+		ccv_array_free(ranks[i]);
+		ccv_matrix_free(a[i]);
+	}
+	ccv_convnet_free(convnet);
+}
+
+TEST_CASE("quantized convolutional network computes close to the full precision one")
+{
+	ccv_convnet_t* convnet = _ccv_convnet_small_new(1);
+	ccv_convnet_t* calibrated = _ccv_convnet_small_new(1);
+	ccv_convnet_t* dynamic = _ccv_convnet_small_new(1);
+	dsfmt_t dsfmt;
+	dsfmt_init_gen_rand(&dsfmt, 2);
+	int i, j;
+	ccv_dense_matrix_t* a[4];
+	for (i = 0; i < 4; i++)
+	{
+		a[i] = ccv_dense_matrix_new(16, 16, CCV_32F | CCV_C3, 0, 0);
+		for (j = 0; j < 16 * 16 * 3; j++)
+			a[i]->data.f32[j] = dsfmt_genrand_open_close(&dsfmt);
+	}
+	ccv_convnet_quantize(calibrated, a, 4);
+	ccv_convnet_quantize(dynamic, 0, 0);
+	REQUIRE(calibrated->layers[0].w == 0 && calibrated->layers[2].w == 0, "full precision weights should be freed");
+	for (i = 0; i < 4; i++)
+	{
+		ccv_dense_matrix_t* x = 0;
+		ccv_slice(a[i], (ccv_matrix_t**)&x, 0, 2, 2, 12, 12);
+		ccv_dense_matrix_t* y = 0;
+		ccv_convnet_encode(convnet, &x, &y, 1);
+		ccv_dense_matrix_t* cy = 0;
+		ccv_convnet_encode(calibrated, &x, &cy, 1);
+		ccv_dense_matrix_t* dy = 0;
+		ccv_convnet_encode(dynamic, &x, &dy, 1);
+		float max_abs = 0;
+		for (j = 0; j < 10; j++)
+			max_abs = ccv_max(max_abs, fabsf(y->data.f32[j]));
+		for (j = 0; j < 10; j++)
+		{
+			REQUIRE_EQ_WITH_TOLERANCE(cy->data.f32[j], y->data.f32[j], max_abs * 0.02, "calibrated 8-bit network should be close to the full precision one");
+			REQUIRE_EQ_WITH_TOLERANCE(dy->data.f32[j], y->data.f32[j], max_abs * 0.02, "dynamic 8-bit network should be close to the full precision one");
+		}
+		ccv_matrix_free(x);
+		ccv_matrix_free(y);
+		ccv_matrix_free(cy);
+		ccv_matrix_free(dy);
+	}
+	// the dynamic network quantizes each image on its own, even when a much brighter one is in the same batch
+	ccv_dense_matrix_t* b[2];
+	b[0] = a[0];
+	b[1] = 0;
+	ccv_scale(a[1], (ccv_matrix_t**)&b[1], 0, 8);
+	ccv_array_t* ranks[4];
+	ccv_convnet_classify(dynamic, b, 1, ranks, 5, 2);
+	for (i = 0; i < 2; i++)
+	{
+		ccv_array_t* rank = 0;
+		ccv_convnet_classify(dynamic, b + i, 1, &rank, 5, 1);
+		REQUIRE_EQ(rank->rnum, ranks[i]->rnum, "should have the same number of classes");
+		for (j = 0; j < rank->rnum; j++)
+		{
+			ccv_classification_t* expected = (ccv_classification_t*)ccv_array_get(rank, j);
+			ccv_classification_t* actual = (ccv_classification_t*)ccv_array_get(ranks[i], j);
+			REQUIRE_EQ(actual->id, expected->id, "should be the same class in a batch as one by one");
+			REQUIRE_EQ_WITH_TOLERANCE(actual->confidence, expected->confidence, 1e-5, "should be the same confidence in a batch as one by one");
+		}
+		ccv_array_free(rank);
+		ccv_array_free(ranks[i]);
+	}
+	ccv_matrix_free(b[1]);
+	ccv_convnet_classify(calibrated, a, 1, ranks, 1, 4);
+	for (i = 0; i < 4; i++)
+	{
+		ccv_array_t* rank = 0;
+		ccv_convnet_classify(convnet, a + i, 1, &rank, 1, 1);
+		REQUIRE_EQ(((ccv_classification_t*)ccv_array_get(ranks[i], 0))->id, ((ccv_classification_t*)ccv_array_get(rank, 0))->id, "should be the same class");
+		ccv_array_free(rank);
+		ccv_array_free(ranks[i]);
+		ccv_matrix_free(a[i]);
+	}
+	ccv_convnet_free(convnet);
+	ccv_convnet_free(calibrated);
+	ccv_convnet_free(dynamic);
+}
+
 #ifdef HAVE_GSL
 TEST_CASE("full connect network backward propagate")
 {
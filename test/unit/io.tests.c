@@ -372,4 +372,33 @@ TEST_CASE("read PNG from memory")
 	ccv_matrix_free(x);
 }
 
+TEST_CASE("read JPEG scaled down to fit within a given size")
+{
+	ccv_dense_matrix_t* x = 0;
+	ccv_read("../../samples/cmyk-jpeg-format.jpg", &x, CCV_IO_ANY_FILE);
+	ccv_dense_matrix_t* z = 0;
+	ccv_read_fit("../../samples/cmyk-jpeg-format.jpg", &z, CCV_IO_ANY_FILE, 0, 600, 600);
+	REQUIRE(z->rows <= 600 && z->cols <= 600, "should fit within 600x600");
+	REQUIRE_EQ(600, z->cols, "the longer side should be scaled to 600");
+	REQUIRE_EQ_WITH_TOLERANCE(x->rows * 600.0 / x->cols, z->rows, 1, "should keep the aspect ratio");
+	ccv_dense_matrix_t* y = 0;
+	ccv_resample(x, &y, 0, z->rows, z->cols, CCV_INTER_AREA);
+	REQUIRE_EQ(CCV_GET_CHANNEL(x->type), CCV_GET_CHANNEL(z->type), "should have the same channels as full decode");
+	int i, j;
+	double diff = 0;
+	for (i = 0; i < y->rows; i++)
+		for (j = 0; j < y->cols * CCV_GET_CHANNEL(y->type); j++)
+			diff += abs((int)y->data.u8[i * y->step + j] - (int)z->data.u8[i * z->step + j]);
+	diff /= y->rows * y->cols * CCV_GET_CHANNEL(y->type);
+	REQUIRE(diff < 6, "scaled down decode should be close to full decode and resample");
+	ccv_dense_matrix_t* w = 0;
+	ccv_read_fit("../../samples/cmyk-jpeg-format.jpg", &w, CCV_IO_ANY_FILE | CCV_IO_GRAY, 0, 0, x->cols * 2);
+	REQUIRE_EQ(x->rows, w->rows, "should not scale up when the image already fits");
+	REQUIRE_EQ(x->cols, w->cols, "should not scale up when the image already fits");
+	ccv_matrix_free(w);
+	ccv_matrix_free(z);
+	ccv_matrix_free(y);
+	ccv_matrix_free(x);
+}
+
 #include "case_main.h"
@@ -1,6 +1,7 @@
 #include "ccv.h"
 #include "ccv_internal.h"
 #include "case.h"
+#include <pthread.h>
 
 uint64_t uniqid()
 {
@@ -173,4 +174,147 @@ TEST_CASE("multi-type garbage collector 92\% hit rate")
 	ccv_disable_cache();
 }
 
+TEST_CASE("cache statistics for hit, miss and eviction")
+{
+	ccv_cache_t cache;
+	ccv_cache_init(&cache, 4, 2, ccfree, ccfree);
+	int i;
+	for (i = 0; i < 6; i++)
+		ccv_cache_put(&cache, i + 1, ccmalloc(1), 1, i % 2);
+	REQUIRE_EQ(1, cache.stat.type[0].eviction, "1 object of type 0 should be evicted");
+	REQUIRE_EQ(1, cache.stat.type[1].evicted_size, "1 byte of type 1 should be evicted");
+	REQUIRE_EQ(2, cache.stat.type[0].rnum, "2 objects of type 0 should be in the cache");
+	REQUIRE_EQ(2, cache.stat.type[1].size, "2 bytes of type 1 should be in the cache");
+	REQUIRE(ccv_cache_get(&cache, 6, 0) != 0, "the last object should be found");
+	REQUIRE(ccv_cache_get(&cache, 1, 0) == 0, "the first object should be evicted");
+	ccfree(ccv_cache_out(&cache, 5, 0));
+	ccv_cache_stat_t stat;
+	ccv_cache_get_stat(&cache, &stat);
+	REQUIRE_EQ(1, stat.miss, "should miss once");
+	REQUIRE_EQ(1, stat.type[0].hit, "should hit type 0 once");
+	REQUIRE_EQ(1, stat.type[1].hit, "should hit type 1 once");
+	REQUIRE_EQ(3, stat.type[0].put, "should put 3 objects of type 0");
+	REQUIRE_EQ(1, stat.type[0].rnum, "1 object of type 0 should be in the cache");
+	ccv_cache_close(&cache);
+}
+
+TEST_CASE("cache keeps object with cost longer")
+{
+	ccv_cache_t cache;
+	ccv_cache_init(&cache, 8, 1, ccfree);
+	// object 1 costs its size to compute again, therefore, it should outlive one turnover of the cache
+	ccv_cache_put_with_cost(&cache, 1, ccmalloc(1), 1, 0, 1);
+	int i;
+	for (i = 0; i < 8; i++)
+		ccv_cache_put(&cache, i + 2, ccmalloc(1), 1, 0);
+	REQUIRE(ccv_cache_get(&cache, 1, 0) != 0, "the object with cost should stay");
+	REQUIRE(ccv_cache_get(&cache, 2, 0) == 0, "the oldest object without cost should be evicted");
+	for (i = 0; i < 8; i++)
+		ccv_cache_put(&cache, i + 10, ccmalloc(1), 1, 0);
+	REQUIRE(ccv_cache_get(&cache, 1, 0) == 0, "the object with cost should be evicted eventually");
+	ccv_cache_close(&cache);
+}
+
+static void* global_cache_put_matrix(void* arg)
+{
+	int i = *(int*)arg;
+	ccv_dense_matrix_t* dmt = ccv_dense_matrix_new(1, 1, CCV_32S | CCV_C1, 0, 0);
+	dmt->data.i32[0] = i;
+	dmt->sig = ccv_cache_generate_signature((const char*)&i, 4, CCV_EOF_SIGN);
+	dmt->type |= CCV_REUSABLE;
+	ccv_matrix_free(dmt);
+	return 0;
+}
+
+TEST_CASE("global cache shares matrix across threads")
+{
+	ccv_enable_global_cache(ccv_compute_dense_matrix_size(1, 1, CCV_32S | CCV_C1) * 16);
+	int i = 42;
+	pthread_t thread;
+	pthread_create(&thread, 0, global_cache_put_matrix, &i);
+	pthread_join(thread, 0);
+	uint64_t sig = ccv_cache_generate_signature((const char*)&i, 4, CCV_EOF_SIGN);
+	ccv_dense_matrix_t* dmt = ccv_dense_matrix_new(1, 1, CCV_32S | CCV_C1, 0, sig);
+	REQUIRE_EQ(42, dmt->data.i32[0], "the matrix put on another thread should be reused");
+	ccv_matrix_free_immediately(dmt);
+	ccv_disable_cache();
+}
+
+TEST_CASE("global cache garbage collector 95\% hit rate")
+{
+	int i;
+	// deliberately let only cache size fits 90% of data
+	ccv_enable_global_cache(ccv_compute_dense_matrix_size(1, 1, CCV_32S | CCV_C1) * N * 9 / 10);
+	for (i = 0; i < N; i++)
+	{
+		ccv_dense_matrix_t* dmt = ccv_dense_matrix_new(1, 1, CCV_32S | CCV_C1, 0, 0);
+		dmt->data.i32[0] = i;
+		dmt->sig = ccv_cache_generate_signature((const char*)&i, 4, CCV_EOF_SIGN);
+		dmt->type |= CCV_REUSABLE;
+		ccv_matrix_free(dmt);
+	}
+	int percent = 0, total = 0;
+	for (i = N - 1; i > N * 6 / 100; i--)
+	{
+		uint64_t sig = ccv_cache_generate_signature((const char*)&i, 4, CCV_EOF_SIGN);
+		ccv_dense_matrix_t* dmt = ccv_dense_matrix_new(1, 1, CCV_32S | CCV_C1, 0, sig);
+		if (i == dmt->data.i32[0])
+			++percent;
+		++total;
+		ccv_matrix_free_immediately(dmt);
+	}
+	REQUIRE((double)percent / (double)total > 0.95, "the cache hit (%lf) should be greater than 95%%", (double)percent / (double)total);
+	ccv_cache_stat_t stat;
+	ccv_get_cache_stat(&stat);
+	REQUIRE_EQ(percent, stat.type[0].hit, "hits from all shards should add up");
+	REQUIRE_EQ(N, stat.type[0].put, "puts from all shards should add up");
+	REQUIRE(stat.type[0].eviction > 0, "some matrices should be evicted");
+	ccv_disable_cache();
+}
+
+TEST_CASE("cache rebases the age before it overflows")
+{
+	ccv_cache_t cache;
+	ccv_cache_init(&cache, 64, 2, ccfree, ccfree);
+	// the age only has 28 bits for each object
+	cache.age = 0x0FFFFF00;
+	int i;
+	for (i = 0; i < 1024; i++)
+	{
+		uint64_t sig = ccv_cache_generate_signature((const char*)&i, 4, CCV_EOF_SIGN);
+		ccv_cache_put(&cache, sig, ccmalloc(4), 1, 1);
+	}
+	REQUIRE(cache.age < 0x0FFFFFFF, "the age should be rebased");
+	REQUIRE_EQ(64, cache.rnum, "the cache should be full");
+	for (i = 1024 - 64; i < 1024; i++)
+	{
+		uint64_t sig = ccv_cache_generate_signature((const char*)&i, 4, CCV_EOF_SIGN);
+		uint8_t type = 0;
+		void* x = ccv_cache_out(&cache, sig, &type);
+		REQUIRE(x != 0, "the most recently put %d should be in the cache", i);
+		REQUIRE_EQ(1, type, "the type of %d shouldn't be overwritten by the age", i);
+		ccfree(x);
+	}
+	ccv_cache_close(&cache);
+}
+
+TEST_CASE("global cache rebases the age before it overflows")
+{
+	ccv_enable_global_cache(ccv_compute_dense_matrix_size(1, 1, CCV_32S | CCV_C1) * 16);
+	ccv_global_cache_set_age(0x0FFFFF00);
+	int i;
+	for (i = 0; i < 1024; i++)
+		global_cache_put_matrix(&i);
+	for (i = 1024 - 16; i < 1024; i++)
+	{
+		uint64_t sig = ccv_cache_generate_signature((const char*)&i, 4, CCV_EOF_SIGN);
+		ccv_dense_matrix_t* dmt = ccv_dense_matrix_new(1, 1, CCV_32S | CCV_C1, 0, sig);
+		REQUIRE(dmt->type & CCV_GARBAGE, "the most recently put %d should be reused", i);
+		REQUIRE_EQ(i, dmt->data.i32[0], "the matrix should be the one put");
+		ccv_matrix_free_immediately(dmt);
+	}
+	ccv_global_cache_set_age(0);
+	ccv_disable_cache();
+}
+
 #include "case_main.h"
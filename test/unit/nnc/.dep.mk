@@ -0,0 +1,213 @@
+tfb.tests.o: tfb.tests.c ../../../lib/ccv.h \
+ ../../../lib/nnc/ccv_nnc_tfb.h ../../case.h ../../ccv_case.h \
+ ../../../lib/nnc/ccv_nnc.h ../../../lib/nnc/cmd/ccv_nnc_cmd.h \
+ ../../../lib/nnc/cmd/ccv_nnc_backend.h ../../case_main.h
+tensor.tests.o: tensor.tests.c ../../../lib/ccv.h \
+ ../../../lib/nnc/ccv_nnc_tfb.h ../../case.h ../../ccv_case.h \
+ ../../ccv_nnc_case.h ../../../lib/nnc/ccv_nnc.h \
+ ../../../lib/nnc/cmd/ccv_nnc_cmd.h \
+ ../../../lib/nnc/cmd/ccv_nnc_backend.h ../../../lib/nnc/ccv_nnc_easy.h \
+ ../../../lib/nnc/cmd/ccv_nnc_cmd_easy.h ../../case_main.h
+forward.tests.o: forward.tests.c ../../case.h ../../ccv_case.h \
+ ../../../lib/ccv.h ../../../lib/nnc/ccv_nnc_tfb.h \
+ ../../../lib/nnc/ccv_nnc.h ../../../lib/nnc/cmd/ccv_nnc_cmd.h \
+ ../../../lib/nnc/cmd/ccv_nnc_backend.h ../../../lib/nnc/ccv_nnc_easy.h \
+ ../../../lib/nnc/cmd/ccv_nnc_cmd_easy.h \
+ ../../../lib/3rdparty/dsfmt/dSFMT.h ../../case_main.h
+backward.tests.o: backward.tests.c ../../case.h ../../ccv_case.h \
+ ../../ccv_nnc_case.h ../../../lib/ccv.h ../../../lib/nnc/ccv_nnc_tfb.h \
+ ../../../lib/nnc/ccv_nnc.h ../../../lib/nnc/cmd/ccv_nnc_cmd.h \
+ ../../../lib/nnc/cmd/ccv_nnc_backend.h ../../../lib/nnc/ccv_nnc_easy.h \
+ ../../../lib/nnc/cmd/ccv_nnc_cmd_easy.h \
+ ../../../lib/3rdparty/dsfmt/dSFMT.h ../../case_main.h
+gradient.tests.o: gradient.tests.c ../../case.h ../../ccv_case.h \
+ ../../../lib/ccv.h ../../../lib/nnc/ccv_nnc_tfb.h \
+ ../../../lib/nnc/ccv_nnc.h ../../../lib/nnc/cmd/ccv_nnc_cmd.h \
+ ../../../lib/nnc/cmd/ccv_nnc_backend.h ../../../lib/nnc/ccv_nnc_easy.h \
+ ../../../lib/nnc/cmd/ccv_nnc_cmd_easy.h \
+ ../../../lib/3rdparty/dsfmt/dSFMT.h ../../case_main.h
+graph.tests.o: graph.tests.c ../../case.h ../../ccv_case.h \
+ ../../ccv_nnc_case.h ../../../lib/ccv.h ../../../lib/nnc/ccv_nnc_tfb.h \
+ ../../../lib/nnc/ccv_nnc.h ../../../lib/nnc/cmd/ccv_nnc_cmd.h \
+ ../../../lib/nnc/cmd/ccv_nnc_backend.h ../../../lib/nnc/ccv_nnc_easy.h \
+ ../../../lib/nnc/cmd/ccv_nnc_cmd_easy.h \
+ ../../../lib/3rdparty/dsfmt/dSFMT.h ../../case_main.h
+winograd.tests.o: winograd.tests.c ../../case.h ../../ccv_case.h \
+ ../../ccv_nnc_case.h ../../../lib/ccv.h ../../../lib/nnc/ccv_nnc_tfb.h \
+ ../../../lib/nnc/ccv_nnc.h ../../../lib/nnc/cmd/ccv_nnc_cmd.h \
+ ../../../lib/nnc/cmd/ccv_nnc_backend.h ../../../lib/nnc/ccv_nnc_easy.h \
+ ../../../lib/nnc/cmd/ccv_nnc_cmd_easy.h \
+ ../../../lib/3rdparty/dsfmt/dSFMT.h ../../case_main.h
+transform.tests.o: transform.tests.c ../../case.h ../../ccv_case.h \
+ ../../ccv_nnc_case.h ../../../lib/ccv.h ../../../lib/nnc/ccv_nnc_tfb.h \
+ ../../../lib/nnc/ccv_nnc.h ../../../lib/nnc/cmd/ccv_nnc_cmd.h \
+ ../../../lib/nnc/cmd/ccv_nnc_backend.h ../../../lib/nnc/ccv_nnc_easy.h \
+ ../../../lib/nnc/cmd/ccv_nnc_cmd_easy.h \
+ ../../../lib/3rdparty/dsfmt/dSFMT.h ../../case_main.h
+symbolic.graph.tests.o: symbolic.graph.tests.c ../../case.h \
+ ../../ccv_case.h ../../ccv_nnc_case.h ../../../lib/ccv.h \
+ ../../../lib/nnc/ccv_nnc_tfb.h ../../../lib/nnc/ccv_nnc.h \
+ ../../../lib/nnc/cmd/ccv_nnc_cmd.h \
+ ../../../lib/nnc/cmd/ccv_nnc_backend.h ../../../lib/nnc/ccv_nnc_easy.h \
+ ../../../lib/nnc/cmd/ccv_nnc_cmd_easy.h \
+ ../../../lib/3rdparty/dsfmt/dSFMT.h ../../case_main.h
+autograd.tests.o: autograd.tests.c ../../case.h ../../ccv_case.h \
+ ../../ccv_nnc_case.h ../../../lib/ccv.h ../../../lib/nnc/ccv_nnc_tfb.h \
+ ../../../lib/nnc/ccv_nnc.h ../../../lib/nnc/cmd/ccv_nnc_cmd.h \
+ ../../../lib/nnc/cmd/ccv_nnc_backend.h ../../../lib/nnc/ccv_nnc_easy.h \
+ ../../../lib/nnc/cmd/ccv_nnc_cmd_easy.h ../../case_main.h
+autograd.vector.tests.o: autograd.vector.tests.c ../../case.h \
+ ../../ccv_case.h ../../ccv_nnc_case.h ../../../lib/ccv.h \
+ ../../../lib/nnc/ccv_nnc_tfb.h ../../../lib/nnc/ccv_nnc.h \
+ ../../../lib/nnc/cmd/ccv_nnc_cmd.h \
+ ../../../lib/nnc/cmd/ccv_nnc_backend.h ../../../lib/nnc/ccv_nnc_easy.h \
+ ../../../lib/nnc/cmd/ccv_nnc_cmd_easy.h ../../case_main.h
+while.tests.o: while.tests.c ../../case.h ../../ccv_case.h \
+ ../../ccv_nnc_case.h ../../../lib/ccv.h ../../../lib/nnc/ccv_nnc_tfb.h \
+ ../../../lib/nnc/ccv_nnc.h ../../../lib/nnc/cmd/ccv_nnc_cmd.h \
+ ../../../lib/nnc/cmd/ccv_nnc_backend.h ../../../lib/nnc/ccv_nnc_easy.h \
+ ../../../lib/nnc/cmd/ccv_nnc_cmd_easy.h \
+ ../../../lib/3rdparty/dsfmt/dSFMT.h ../../case_main.h
+tape.tests.o: tape.tests.c ../../case.h ../../ccv_case.h \
+ ../../ccv_nnc_case.h ../../../lib/ccv.h ../../../lib/nnc/ccv_nnc_tfb.h \
+ ../../../lib/nnc/ccv_nnc.h ../../../lib/nnc/cmd/ccv_nnc_cmd.h \
+ ../../../lib/nnc/cmd/ccv_nnc_backend.h ../../../lib/nnc/ccv_nnc_easy.h \
+ ../../../lib/nnc/cmd/ccv_nnc_cmd_easy.h \
+ ../../../lib/nnc/_ccv_nnc_graph.h ../../../lib/nnc/ccv_nnc.h \
+ ../../../lib/nnc/_ccv_nnc_stream.h ../../../lib/3rdparty/dsfmt/dSFMT.h \
+ ../../case_main.h
+while.backward.tests.o: while.backward.tests.c ../../case.h \
+ ../../ccv_case.h ../../ccv_nnc_case.h ../../../lib/ccv.h \
+ ../../../lib/nnc/ccv_nnc_tfb.h ../../../lib/nnc/ccv_nnc.h \
+ ../../../lib/nnc/cmd/ccv_nnc_cmd.h \
+ ../../../lib/nnc/cmd/ccv_nnc_backend.h ../../../lib/nnc/ccv_nnc_easy.h \
+ ../../../lib/nnc/cmd/ccv_nnc_cmd_easy.h \
+ ../../../lib/nnc/_ccv_nnc_graph.h ../../../lib/nnc/ccv_nnc.h \
+ ../../../lib/nnc/_ccv_nnc_stream.h ../../../lib/3rdparty/dsfmt/dSFMT.h \
+ ../../case_main.h
+case_of.tests.o: case_of.tests.c ../../case.h ../../ccv_case.h \
+ ../../ccv_nnc_case.h ../../../lib/ccv.h ../../../lib/nnc/ccv_nnc_tfb.h \
+ ../../../lib/nnc/ccv_nnc.h ../../../lib/nnc/cmd/ccv_nnc_cmd.h \
+ ../../../lib/nnc/cmd/ccv_nnc_backend.h ../../../lib/nnc/ccv_nnc_easy.h \
+ ../../../lib/nnc/cmd/ccv_nnc_cmd_easy.h \
+ ../../../lib/3rdparty/dsfmt/dSFMT.h ../../case_main.h
+case_of.backward.tests.o: case_of.backward.tests.c ../../case.h \
+ ../../ccv_case.h ../../ccv_nnc_case.h ../../../lib/ccv.h \
+ ../../../lib/nnc/ccv_nnc_tfb.h ../../../lib/nnc/ccv_nnc.h \
+ ../../../lib/nnc/cmd/ccv_nnc_cmd.h \
+ ../../../lib/nnc/cmd/ccv_nnc_backend.h ../../../lib/nnc/ccv_nnc_easy.h \
+ ../../../lib/nnc/cmd/ccv_nnc_cmd_easy.h \
+ ../../../lib/3rdparty/dsfmt/dSFMT.h ../../case_main.h
+numa.tests.o: numa.tests.c ../../case.h ../../ccv_case.h \
+ ../../ccv_nnc_case.h ../../../lib/ccv.h ../../../lib/nnc/ccv_nnc_tfb.h \
+ ../../../lib/nnc/ccv_nnc.h ../../../lib/nnc/cmd/ccv_nnc_cmd.h \
+ ../../../lib/nnc/cmd/ccv_nnc_backend.h ../../../lib/nnc/ccv_nnc_easy.h \
+ ../../../lib/nnc/cmd/ccv_nnc_cmd_easy.h \
+ ../../../lib/3rdparty/dsfmt/dSFMT.h ../../case_main.h
+tensor.bind.tests.o: tensor.bind.tests.c ../../case.h ../../ccv_case.h \
+ ../../ccv_nnc_case.h ../../../lib/ccv.h ../../../lib/nnc/ccv_nnc_tfb.h \
+ ../../../lib/nnc/ccv_nnc.h ../../../lib/nnc/cmd/ccv_nnc_cmd.h \
+ ../../../lib/nnc/cmd/ccv_nnc_backend.h ../../../lib/nnc/ccv_nnc_easy.h \
+ ../../../lib/nnc/cmd/ccv_nnc_cmd_easy.h \
+ ../../../lib/3rdparty/dsfmt/dSFMT.h ../../case_main.h
+broadcast.tests.o: broadcast.tests.c ../../case.h ../../ccv_case.h \
+ ../../ccv_nnc_case.h ../../../lib/ccv.h ../../../lib/nnc/ccv_nnc_tfb.h \
+ ../../../lib/nnc/ccv_nnc.h ../../../lib/nnc/cmd/ccv_nnc_cmd.h \
+ ../../../lib/nnc/cmd/ccv_nnc_backend.h ../../../lib/nnc/ccv_nnc_easy.h \
+ ../../../lib/nnc/cmd/ccv_nnc_cmd_easy.h ../../case_main.h
+reduce.tests.o: reduce.tests.c ../../case.h ../../ccv_case.h \
+ ../../ccv_nnc_case.h ../../../lib/ccv.h ../../../lib/nnc/ccv_nnc_tfb.h \
+ ../../../lib/nnc/ccv_nnc.h ../../../lib/nnc/cmd/ccv_nnc_cmd.h \
+ ../../../lib/nnc/cmd/ccv_nnc_backend.h ../../../lib/nnc/ccv_nnc_easy.h \
+ ../../../lib/nnc/cmd/ccv_nnc_cmd_easy.h \
+ ../../../lib/3rdparty/dsfmt/dSFMT.h ../../case_main.h
+batch.norm.tests.o: batch.norm.tests.c ../../case.h ../../ccv_case.h \
+ ../../ccv_nnc_case.h ../../../lib/ccv.h ../../../lib/nnc/ccv_nnc_tfb.h \
+ ../../../lib/nnc/ccv_nnc.h ../../../lib/nnc/cmd/ccv_nnc_cmd.h \
+ ../../../lib/nnc/cmd/ccv_nnc_backend.h ../../../lib/nnc/ccv_nnc_easy.h \
+ ../../../lib/nnc/cmd/ccv_nnc_cmd_easy.h \
+ ../../../lib/3rdparty/dsfmt/dSFMT.h ../../case_main.h
+dropout.tests.o: dropout.tests.c ../../case.h ../../ccv_case.h \
+ ../../ccv_nnc_case.h ../../../lib/ccv.h ../../../lib/nnc/ccv_nnc_tfb.h \
+ ../../../lib/nnc/ccv_nnc.h ../../../lib/nnc/cmd/ccv_nnc_cmd.h \
+ ../../../lib/nnc/cmd/ccv_nnc_backend.h ../../../lib/nnc/ccv_nnc_easy.h \
+ ../../../lib/nnc/cmd/ccv_nnc_cmd_easy.h ../../case_main.h
+crossentropy.tests.o: crossentropy.tests.c ../../case.h ../../ccv_case.h \
+ ../../ccv_nnc_case.h ../../../lib/ccv.h ../../../lib/nnc/ccv_nnc_tfb.h \
+ ../../../lib/nnc/ccv_nnc.h ../../../lib/nnc/cmd/ccv_nnc_cmd.h \
+ ../../../lib/nnc/cmd/ccv_nnc_backend.h ../../../lib/nnc/ccv_nnc_easy.h \
+ ../../../lib/nnc/cmd/ccv_nnc_cmd_easy.h ../../case_main.h
+dynamic.graph.tests.o: dynamic.graph.tests.c ../../case.h \
+ ../../ccv_case.h ../../ccv_nnc_case.h ../../../lib/ccv.h \
+ ../../../lib/nnc/ccv_nnc_tfb.h ../../../lib/nnc/ccv_nnc.h \
+ ../../../lib/nnc/cmd/ccv_nnc_cmd.h \
+ ../../../lib/nnc/cmd/ccv_nnc_backend.h ../../../lib/nnc/ccv_nnc_easy.h \
+ ../../../lib/nnc/cmd/ccv_nnc_cmd_easy.h \
+ ../../../lib/3rdparty/dsfmt/dSFMT.h ../../case_main.h
+simplify.tests.o: simplify.tests.c ../../case.h ../../ccv_case.h \
+ ../../ccv_nnc_case.h ../../../lib/ccv.h ../../../lib/nnc/ccv_nnc_tfb.h \
+ ../../../lib/nnc/ccv_nnc.h ../../../lib/nnc/cmd/ccv_nnc_cmd.h \
+ ../../../lib/nnc/cmd/ccv_nnc_backend.h ../../../lib/nnc/ccv_nnc_easy.h \
+ ../../../lib/nnc/cmd/ccv_nnc_cmd_easy.h \
+ ../../../lib/3rdparty/dsfmt/dSFMT.h ../../case_main.h
+symbolic.graph.compile.tests.o: symbolic.graph.compile.tests.c \
+ ../../case.h ../../ccv_case.h ../../ccv_nnc_case.h ../../../lib/ccv.h \
+ ../../../lib/nnc/ccv_nnc_tfb.h ../../../lib/nnc/ccv_nnc.h \
+ ../../../lib/nnc/cmd/ccv_nnc_cmd.h \
+ ../../../lib/nnc/cmd/ccv_nnc_backend.h ../../../lib/nnc/ccv_nnc_easy.h \
+ ../../../lib/nnc/cmd/ccv_nnc_cmd_easy.h \
+ ../../../lib/3rdparty/dsfmt/dSFMT.h ../../case_main.h
+rand.tests.o: rand.tests.c ../../case.h ../../ccv_case.h \
+ ../../ccv_nnc_case.h ../../../lib/ccv.h ../../../lib/nnc/ccv_nnc_tfb.h \
+ ../../../lib/nnc/ccv_nnc.h ../../../lib/nnc/cmd/ccv_nnc_cmd.h \
+ ../../../lib/nnc/cmd/ccv_nnc_backend.h ../../../lib/nnc/ccv_nnc_easy.h \
+ ../../../lib/nnc/cmd/ccv_nnc_cmd_easy.h \
+ ../../../lib/3rdparty/dsfmt/dSFMT.h ../../case_main.h
+graph.io.tests.o: graph.io.tests.c ../../case.h ../../ccv_case.h \
+ ../../ccv_nnc_case.h ../../../lib/ccv.h ../../../lib/nnc/ccv_nnc_tfb.h \
+ ../../../lib/nnc/ccv_nnc.h ../../../lib/nnc/cmd/ccv_nnc_cmd.h \
+ ../../../lib/nnc/cmd/ccv_nnc_backend.h ../../../lib/nnc/ccv_nnc_easy.h \
+ ../../../lib/nnc/cmd/ccv_nnc_cmd_easy.h \
+ ../../../lib/3rdparty/sqlite3/sqlite3.h ../../case_main.h
+cnnp.core.tests.o: cnnp.core.tests.c ../../case.h ../../ccv_case.h \
+ ../../ccv_nnc_case.h ../../../lib/ccv.h ../../../lib/nnc/ccv_nnc_tfb.h \
+ ../../../lib/nnc/ccv_nnc.h ../../../lib/nnc/cmd/ccv_nnc_cmd.h \
+ ../../../lib/nnc/cmd/ccv_nnc_backend.h ../../../lib/nnc/ccv_nnc_easy.h \
+ ../../../lib/nnc/cmd/ccv_nnc_cmd_easy.h \
+ ../../../lib/3rdparty/dsfmt/dSFMT.h ../../case_main.h
+minimize.tests.o: minimize.tests.c ../../case.h ../../ccv_case.h \
+ ../../ccv_nnc_case.h ../../../lib/ccv.h ../../../lib/nnc/ccv_nnc_tfb.h \
+ ../../../lib/nnc/ccv_nnc.h ../../../lib/nnc/cmd/ccv_nnc_cmd.h \
+ ../../../lib/nnc/cmd/ccv_nnc_backend.h ../../../lib/nnc/ccv_nnc_easy.h \
+ ../../../lib/nnc/cmd/ccv_nnc_cmd_easy.h \
+ ../../../lib/3rdparty/dsfmt/dSFMT.h ../../case_main.h
+custom.tests.o: custom.tests.c ../../case.h ../../ccv_case.h \
+ ../../ccv_nnc_case.h ../../../lib/ccv.h ../../../lib/nnc/ccv_nnc_tfb.h \
+ ../../../lib/nnc/ccv_nnc.h ../../../lib/nnc/cmd/ccv_nnc_cmd.h \
+ ../../../lib/nnc/cmd/ccv_nnc_backend.h ../../../lib/nnc/ccv_nnc_easy.h \
+ ../../../lib/nnc/cmd/ccv_nnc_cmd_easy.h \
+ ../../../lib/3rdparty/dsfmt/dSFMT.h ../../case_main.h
+parallel.tests.o: parallel.tests.c ../../case.h ../../ccv_case.h \
+ ../../ccv_nnc_case.h ../../../lib/ccv.h ../../../lib/nnc/ccv_nnc_tfb.h \
+ ../../../lib/nnc/ccv_nnc.h ../../../lib/nnc/cmd/ccv_nnc_cmd.h \
+ ../../../lib/nnc/cmd/ccv_nnc_backend.h ../../../lib/nnc/ccv_nnc_easy.h \
+ ../../../lib/nnc/cmd/ccv_nnc_cmd_easy.h ../../case_main.h
+dataframe.tests.o: dataframe.tests.c ../../case.h ../../ccv_case.h \
+ ../../ccv_nnc_case.h ../../../lib/ccv.h ../../../lib/nnc/ccv_nnc_tfb.h \
+ ../../../lib/nnc/ccv_nnc.h ../../../lib/nnc/cmd/ccv_nnc_cmd.h \
+ ../../../lib/nnc/cmd/ccv_nnc_backend.h ../../../lib/nnc/ccv_nnc_easy.h \
+ ../../../lib/nnc/cmd/ccv_nnc_cmd_easy.h \
+ ../../../lib/3rdparty/dsfmt/dSFMT.h ../../case_main.h
+avx.tests.o: avx.tests.c ../../case.h ../../ccv_case.h \
+ ../../ccv_nnc_case.h ../../../lib/ccv.h ../../../lib/nnc/ccv_nnc_tfb.h \
+ ../../../lib/nnc/ccv_nnc.h ../../../lib/nnc/cmd/ccv_nnc_cmd.h \
+ ../../../lib/nnc/cmd/ccv_nnc_backend.h ../../../lib/nnc/ccv_nnc_easy.h \
+ ../../../lib/nnc/cmd/ccv_nnc_cmd_easy.h \
+ ../../../lib/3rdparty/dsfmt/dSFMT.h ../../case_main.h
+rematerialize.tests.o: rematerialize.tests.c ../../case.h \
+ ../../ccv_case.h ../../ccv_nnc_case.h ../../../lib/ccv.h \
+ ../../../lib/nnc/ccv_nnc_tfb.h ../../../lib/nnc/ccv_nnc.h \
+ ../../../lib/nnc/cmd/ccv_nnc_cmd.h \
+ ../../../lib/nnc/cmd/ccv_nnc_backend.h ../../../lib/nnc/ccv_nnc_easy.h \
+ ../../../lib/nnc/cmd/ccv_nnc_cmd_easy.h \
+ ../../../lib/3rdparty/dsfmt/dSFMT.h ../../case_main.h
@@ -0,0 +1,188 @@
+#include "case.h"
+#include "ccv_case.h"
+#include "ccv_nnc_case.h"
+#include <ccv.h>
+#include <nnc/ccv_nnc.h>
+#include <nnc/ccv_nnc_easy.h>
+#include <3rdparty/dsfmt/dSFMT.h>
+
+TEST_SETUP()
+{
+	ccv_nnc_init();
+}
+
+TEST_CASE("AVX convolution of 3x3 on 31x31 with 32 output channels")
+{
+	// Skip if this machine doesn't support the instructions.
+	if (!ccv_nnc_cmd_ok(CCV_NNC_CONVOLUTION_FORWARD, CCV_NNC_BACKEND_CPU_AVX))
+		return;
+	ccv_nnc_tensor_t* a = ccv_nnc_tensor_new(0, ONE_CPU_TENSOR(31, 31, 19), 0);
+	ccv_nnc_tensor_t* b = ccv_nnc_tensor_new(0, ONE_CPU_TENSOR(31, 31, 32), 0);
+	ccv_nnc_cmd_t cmd = CMD_CONVOLUTION_FORWARD(1, 32, 3, 3, 19);
+	ccv_nnc_hint_t hint = ccv_nnc_hint_auto(cmd.info, a->info, b->info);
+	ccv_nnc_tensor_t* w = ccv_nnc_tensor_new(0, ONE_CPU_TENSOR(32, 3, 3, 19), 0);
+	ccv_nnc_tensor_t* bias = ccv_nnc_tensor_new(0, ONE_CPU_TENSOR(32), 0);
+	dsfmt_t dsfmt;
+	dsfmt_init_gen_rand(&dsfmt, 0);
+	int i;
+	for (i = 0; i < 32 * 3 * 3 * 19; i++)
+		w->data.f32[i] = dsfmt_genrand_open_close(&dsfmt) / (3 * 3 * 19);
+	for (i = 0; i < 31 * 31 * 19; i++)
+		a->data.f32[i] = dsfmt_genrand_open_close(&dsfmt);
+	for (i = 0; i < 32; i++)
+		bias->data.f32[i] = (float)i / 32;
+	cmd.backend = CCV_NNC_BACKEND_CPU_REF;
+	ccv_nnc_cmd_exec(cmd, hint, 0, TENSOR_LIST(a, w, bias), TENSOR_LIST(b), 0);
+	ccv_nnc_tensor_t* c = ccv_nnc_tensor_new(0, ONE_CPU_TENSOR(31, 31, 32), 0);
+	cmd.backend = CCV_NNC_BACKEND_CPU_AVX;
+	ccv_nnc_cmd_exec(cmd, hint, 0, TENSOR_LIST(a, w, bias), TENSOR_LIST(c), 0);
+	REQUIRE_TENSOR_EQ(b, c, "31x31 matrix should be the same from reference implementation and AVX direct convolution.");
+	ccv_nnc_tensor_free(c);
+	ccv_nnc_tensor_free(bias);
+	ccv_nnc_tensor_free(w);
+	ccv_nnc_tensor_free(b);
+	ccv_nnc_tensor_free(a);
+}
+
+TEST_CASE("AVX convolution of 5x5 with stride 2 and 24 output channels")
+{
+	// Skip if this machine doesn't support the instructions.
+	if (!ccv_nnc_cmd_ok(CCV_NNC_CONVOLUTION_FORWARD, CCV_NNC_BACKEND_CPU_AVX))
+		return;
+	ccv_nnc_tensor_t* a = ccv_nnc_tensor_new(0, ONE_CPU_TENSOR(27, 27, 6), 0);
+	ccv_nnc_tensor_t* b = ccv_nnc_tensor_new(0, ONE_CPU_TENSOR(14, 14, 24), 0);
+	ccv_nnc_cmd_t cmd = CMD_CONVOLUTION_FORWARD(1, 24, 5, 5, 6);
+	ccv_nnc_hint_t hint = ccv_nnc_hint_auto(cmd.info, a->info, b->info);
+	ccv_nnc_tensor_t* w = ccv_nnc_tensor_new(0, ONE_CPU_TENSOR(24, 5, 5, 6), 0);
+	ccv_nnc_tensor_t* bias = ccv_nnc_tensor_new(0, ONE_CPU_TENSOR(24), 0);
+	dsfmt_t dsfmt;
+	dsfmt_init_gen_rand(&dsfmt, 0);
+	int i;
+	for (i = 0; i < 24 * 5 * 5 * 6; i++)
+		w->data.f32[i] = dsfmt_genrand_open_close(&dsfmt) / (5 * 5 * 6);
+	for (i = 0; i < 27 * 27 * 6; i++)
+		a->data.f32[i] = dsfmt_genrand_open_close(&dsfmt);
+	for (i = 0; i < 24; i++)
+		bias->data.f32[i] = (float)i / 24;
+	cmd.backend = CCV_NNC_BACKEND_CPU_REF;
+	ccv_nnc_cmd_exec(cmd, hint, 0, TENSOR_LIST(a, w, bias), TENSOR_LIST(b), 0);
+	ccv_nnc_tensor_t* c = ccv_nnc_tensor_new(0, ONE_CPU_TENSOR(14, 14, 24), 0);
+	cmd.backend = CCV_NNC_BACKEND_CPU_AVX;
+	ccv_nnc_cmd_exec(cmd, hint, 0, TENSOR_LIST(a, w, bias), TENSOR_LIST(c), 0);
+	REQUIRE_TENSOR_EQ(b, c, "14x14 matrix should be the same from reference implementation and AVX direct convolution.");
+	ccv_nnc_tensor_free(c);
+	ccv_nnc_tensor_free(bias);
+	ccv_nnc_tensor_free(w);
+	ccv_nnc_tensor_free(b);
+	ccv_nnc_tensor_free(a);
+}
+
+TEST_CASE("AVX convolution refuses 20 output channels and autotune picks another backend")
+{
+	// Skip if this machine doesn't support the instructions.
+	if (!ccv_nnc_cmd_ok(CCV_NNC_CONVOLUTION_FORWARD, CCV_NNC_BACKEND_CPU_AVX))
+		return;
+	ccv_nnc_tensor_t* a = ccv_nnc_tensor_new(0, ONE_CPU_TENSOR(15, 15, 7), 0);
+	ccv_nnc_tensor_t* b = ccv_nnc_tensor_new(0, ONE_CPU_TENSOR(15, 15, 20), 0);
+	ccv_nnc_cmd_t cmd = CMD_CONVOLUTION_FORWARD(1, 20, 3, 3, 7);
+	ccv_nnc_hint_t hint = ccv_nnc_hint_auto(cmd.info, a->info, b->info);
+	ccv_nnc_tensor_t* w = ccv_nnc_tensor_new(0, ONE_CPU_TENSOR(20, 3, 3, 7), 0);
+	ccv_nnc_tensor_t* bias = ccv_nnc_tensor_new(0, ONE_CPU_TENSOR(20), 0);
+	dsfmt_t dsfmt;
+	dsfmt_init_gen_rand(&dsfmt, 0);
+	int i;
+	for (i = 0; i < 20 * 3 * 3 * 7; i++)
+		w->data.f32[i] = dsfmt_genrand_open_close(&dsfmt) / (3 * 3 * 7);
+	for (i = 0; i < 15 * 15 * 7; i++)
+		a->data.f32[i] = dsfmt_genrand_open_close(&dsfmt);
+	for (i = 0; i < 20; i++)
+		bias->data.f32[i] = (float)i / 20;
+	cmd.backend = CCV_NNC_BACKEND_CPU_REF;
+	ccv_nnc_cmd_exec(cmd, hint, 0, TENSOR_LIST(a, w, bias), TENSOR_LIST(b), 0);
+	ccv_nnc_tensor_t* c = ccv_nnc_tensor_new(0, ONE_CPU_TENSOR(15, 15, 20), 0);
+	cmd.backend = CCV_NNC_BACKEND_CPU_AVX;
+	REQUIRE_EQ(ccv_nnc_cmd_exec(cmd, hint, 0, TENSOR_LIST(a, w, bias), TENSOR_LIST(c), 0), CCV_NNC_EXEC_INVALID, "AVX convolution should refuse output channels that are not a multiple of 8");
+	ccv_nnc_cmd_t tuned_cmd = ccv_nnc_cmd_autotune(cmd, 0, hint, 0, TENSOR_LIST(a, w, bias), TENSOR_LIST(c), 0);
+	REQUIRE(tuned_cmd.backend != CCV_NNC_BACKEND_CPU_AVX, "autotune should pick a backend other than AVX");
+	REQUIRE_EQ(ccv_nnc_cmd_exec(tuned_cmd, hint, 0, TENSOR_LIST(a, w, bias), TENSOR_LIST(c), 0), CCV_NNC_EXEC_SUCCESS, "the picked backend should run the convolution");
+	REQUIRE_TENSOR_EQ(b, c, "15x15 matrix should be the same from reference implementation and the picked backend.");
+	ccv_nnc_tensor_free(c);
+	ccv_nnc_tensor_free(bias);
+	ccv_nnc_tensor_free(w);
+	ccv_nnc_tensor_free(b);
+	ccv_nnc_tensor_free(a);
+}
+
+TEST_CASE("AVX gemm forward against reference")
+{
+	if (!ccv_nnc_cmd_ok(CCV_NNC_GEMM_FORWARD, CCV_NNC_BACKEND_CPU_AVX))
+		return;
+	ccv_nnc_tensor_t* a = ccv_nnc_tensor_new(0, ONE_CPU_TENSOR(3, 77), 0);
+	ccv_nnc_tensor_t* w = ccv_nnc_tensor_new(0, ONE_CPU_TENSOR(13, 77), 0);
+	ccv_nnc_tensor_t* bias = ccv_nnc_tensor_new(0, ONE_CPU_TENSOR(13), 0);
+	dsfmt_t dsfmt;
+	dsfmt_init_gen_rand(&dsfmt, 1);
+	int i;
+	for (i = 0; i < 3 * 77; i++)
+		a->data.f32[i] = dsfmt_genrand_open_close(&dsfmt);
+	for (i = 0; i < 13 * 77; i++)
+		w->data.f32[i] = dsfmt_genrand_open_close(&dsfmt) / 77;
+	for (i = 0; i < 13; i++)
+		bias->data.f32[i] = (float)i / 13;
+	ccv_nnc_tensor_t* b = ccv_nnc_tensor_new(0, ONE_CPU_TENSOR(3, 13), 0);
+	ccv_nnc_cmd_t cmd = CMD_GEMM_FORWARD(13);
+	cmd.backend = CCV_NNC_BACKEND_CPU_REF;
+	ccv_nnc_cmd_exec(cmd, ccv_nnc_no_hint, 0, TENSOR_LIST(a, w, bias), TENSOR_LIST(b), 0);
+	ccv_nnc_tensor_t* c = ccv_nnc_tensor_new(0, ONE_CPU_TENSOR(3, 13), 0);
+	cmd.backend = CCV_NNC_BACKEND_CPU_AVX;
+	ccv_nnc_cmd_exec(cmd, ccv_nnc_no_hint, 0, TENSOR_LIST(a, w, bias), TENSOR_LIST(c), 0);
+	REQUIRE_TENSOR_EQ(b, c, "gemm output should be the same from reference implementation and AVX.");
+	ccv_nnc_tensor_free(a);
+	ccv_nnc_tensor_free(w);
+	ccv_nnc_tensor_free(bias);
+	ccv_nnc_tensor_free(b);
+	ccv_nnc_tensor_free(c);
+}
+
+TEST_CASE("AVX gemm backward against reference")
+{
+	if (!ccv_nnc_cmd_ok(CCV_NNC_GEMM_BACKWARD, CCV_NNC_BACKEND_CPU_AVX))
+		return;
+	ccv_nnc_tensor_t* g = ccv_nnc_tensor_new(0, ONE_CPU_TENSOR(3, 13), 0);
+	ccv_nnc_tensor_t* a = ccv_nnc_tensor_new(0, ONE_CPU_TENSOR(3, 301), 0);
+	ccv_nnc_tensor_t* w = ccv_nnc_tensor_new(0, ONE_CPU_TENSOR(13, 301), 0);
+	dsfmt_t dsfmt;
+	dsfmt_init_gen_rand(&dsfmt, 2);
+	int i;
+	for (i = 0; i < 3 * 13; i++)
+		g->data.f32[i] = dsfmt_genrand_open_close(&dsfmt);
+	for (i = 0; i < 3 * 301; i++)
+		a->data.f32[i] = dsfmt_genrand_open_close(&dsfmt);
+	for (i = 0; i < 13 * 301; i++)
+		w->data.f32[i] = dsfmt_genrand_open_close(&dsfmt) / 301;
+	ccv_nnc_tensor_t* h = ccv_nnc_tensor_new(0, ONE_CPU_TENSOR(3, 301), 0);
+	ccv_nnc_tensor_t* dw = ccv_nnc_tensor_new(0, ONE_CPU_TENSOR(13, 301), 0);
+	ccv_nnc_tensor_t* dbias = ccv_nnc_tensor_new(0, ONE_CPU_TENSOR(13), 0);
+	ccv_nnc_cmd_t cmd = CMD_GEMM_BACKWARD(13);
+	cmd.backend = CCV_NNC_BACKEND_CPU_REF;
+	ccv_nnc_cmd_exec(cmd, ccv_nnc_no_hint, 0, TENSOR_LIST(g, a, w), TENSOR_LIST(h, dw, dbias), 0);
+	ccv_nnc_tensor_t* th = ccv_nnc_tensor_new(0, ONE_CPU_TENSOR(3, 301), 0);
+	ccv_nnc_tensor_t* tdw = ccv_nnc_tensor_new(0, ONE_CPU_TENSOR(13, 301), 0);
+	ccv_nnc_tensor_t* tdbias = ccv_nnc_tensor_new(0, ONE_CPU_TENSOR(13), 0);
+	cmd.backend = CCV_NNC_BACKEND_CPU_AVX;
+	ccv_nnc_cmd_exec(cmd, ccv_nnc_no_hint, 0, TENSOR_LIST(g, a, w), TENSOR_LIST(th, tdw, tdbias), 0);
+	REQUIRE_TENSOR_EQ(h, th, "input gradient should be the same from reference implementation and AVX.");
+	REQUIRE_TENSOR_EQ(dw, tdw, "weight gradient should be the same from reference implementation and AVX.");
+	REQUIRE_TENSOR_EQ(dbias, tdbias, "bias gradient should be the same from reference implementation and AVX.");
+	ccv_nnc_tensor_free(g);
+	ccv_nnc_tensor_free(a);
+	ccv_nnc_tensor_free(w);
+	ccv_nnc_tensor_free(h);
+	ccv_nnc_tensor_free(dw);
+	ccv_nnc_tensor_free(dbias);
+	ccv_nnc_tensor_free(th);
+	ccv_nnc_tensor_free(tdw);
+	ccv_nnc_tensor_free(tdbias);
+}
+
+#include "case_main.h"
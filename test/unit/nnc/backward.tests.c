@@ -4,6 +4,7 @@
 #include <ccv.h>
 #include <nnc/ccv_nnc.h>
 #include <nnc/ccv_nnc_easy.h>
+#include <3rdparty/dsfmt/dSFMT.h>
 
 TEST_SETUP()
 {
@@ -222,4 +223,64 @@ TEST_CASE("full connect back propagation with batch = 2")
 	ccv_nnc_tensor_free(gbias);
 }
 
+TEST_CASE("full connect back propagation with packed gemm against reference")
+{
+	ccv_nnc_tensor_t* a = ccv_nnc_tensor_new(0, ONE_CPU_TENSOR(37, 301), 0);
+	ccv_nnc_tensor_t* w = ccv_nnc_tensor_new(0, ONE_CPU_TENSOR(13, 301), 0);
+	ccv_nnc_tensor_t* bias = ccv_nnc_tensor_new(0, ONE_CPU_TENSOR(13), 0);
+	ccv_nnc_tensor_t* g = ccv_nnc_tensor_new(0, ONE_CPU_TENSOR(37, 13), 0);
+	dsfmt_t dsfmt;
+	dsfmt_init_gen_rand(&dsfmt, 0);
+	int i;
+	for (i = 0; i < 37 * 301; i++)
+		a->data.f32[i] = dsfmt_genrand_open_close(&dsfmt);
+	for (i = 0; i < 13 * 301; i++)
+		w->data.f32[i] = dsfmt_genrand_open_close(&dsfmt) / 301;
+	for (i = 0; i < 13; i++)
+		bias->data.f32[i] = (float)i / 13;
+	for (i = 0; i < 37 * 13; i++)
+		g->data.f32[i] = dsfmt_genrand_open_close(&dsfmt);
+	ccv_nnc_tensor_t* b = ccv_nnc_tensor_new(0, ONE_CPU_TENSOR(37, 13), 0);
+	ccv_nnc_tensor_t* h = ccv_nnc_tensor_new(0, ONE_CPU_TENSOR(37, 301), 0);
+	ccv_nnc_tensor_t* dw = ccv_nnc_tensor_new(0, ONE_CPU_TENSOR(13, 301), 0);
+	ccv_nnc_tensor_t* dbias = ccv_nnc_tensor_new(0, ONE_CPU_TENSOR(13), 0);
+	ccv_nnc_cmd_t forw_cmd = CMD_GEMM_FORWARD(13);
+	forw_cmd.backend = CCV_NNC_BACKEND_CPU_REF;
+	ccv_nnc_cmd_exec(forw_cmd, ccv_nnc_no_hint, 0, TENSOR_LIST(a, w, bias), TENSOR_LIST(b), 0);
+	ccv_nnc_cmd_t back_cmd = CMD_GEMM_BACKWARD(13);
+	back_cmd.backend = CCV_NNC_BACKEND_CPU_REF;
+	ccv_nnc_cmd_exec(back_cmd, ccv_nnc_no_hint, 0, TENSOR_LIST(g, a, w), TENSOR_LIST(h, dw, dbias), 0);
+	ccv_nnc_tensor_t* tb = ccv_nnc_tensor_new(0, ONE_CPU_TENSOR(37, 13), 0);
+	ccv_nnc_tensor_t* th = ccv_nnc_tensor_new(0, ONE_CPU_TENSOR(37, 301), 0);
+	ccv_nnc_tensor_t* tdw = ccv_nnc_tensor_new(0, ONE_CPU_TENSOR(13, 301), 0);
+	ccv_nnc_tensor_t* tdbias = ccv_nnc_tensor_new(0, ONE_CPU_TENSOR(13), 0);
+	forw_cmd.backend = CCV_NNC_BACKEND_CPU_OPT;
+	forw_cmd.algorithm = 2; // CCV_NNC_CMD_OPT_GEMM_ALGO_PACKED
+	back_cmd.backend = CCV_NNC_BACKEND_CPU_OPT;
+	back_cmd.algorithm = 2;
+	// A signature alone doesn't make the weights constant (no tensor arena owns them), they are packed on every run.
+	w->sig = 0x1301;
+	for (i = 0; i < 2; i++)
+	{
+		ccv_nnc_cmd_exec(forw_cmd, ccv_nnc_no_hint, 0, TENSOR_LIST(a, w, bias), TENSOR_LIST(tb), 0);
+		REQUIRE_ARRAY_EQ_WITH_TOLERANCE(float, b->data.f32, tb->data.f32, 37 * 13, 1e-4, "output should be the same from reference implementation and packed gemm.");
+		ccv_nnc_cmd_exec(back_cmd, ccv_nnc_no_hint, 0, TENSOR_LIST(g, a, w), TENSOR_LIST(th, tdw, tdbias), 0);
+		REQUIRE_ARRAY_EQ_WITH_TOLERANCE(float, h->data.f32, th->data.f32, 37 * 301, 1e-4, "input gradient should be the same from reference implementation and packed gemm.");
+		REQUIRE_ARRAY_EQ_WITH_TOLERANCE(float, dw->data.f32, tdw->data.f32, 13 * 301, 1e-4, "weight gradient should be the same from reference implementation and packed gemm.");
+		REQUIRE_ARRAY_EQ_WITH_TOLERANCE(float, dbias->data.f32, tdbias->data.f32, 13, 1e-4, "bias gradient should be the same from reference implementation and packed gemm.");
+	}
+	ccv_nnc_tensor_free(a);
+	ccv_nnc_tensor_free(w);
+	ccv_nnc_tensor_free(bias);
+	ccv_nnc_tensor_free(g);
+	ccv_nnc_tensor_free(b);
+	ccv_nnc_tensor_free(h);
+	ccv_nnc_tensor_free(dw);
+	ccv_nnc_tensor_free(dbias);
+	ccv_nnc_tensor_free(tb);
+	ccv_nnc_tensor_free(th);
+	ccv_nnc_tensor_free(tdw);
+	ccv_nnc_tensor_free(tdbias);
+}
+
 #include "case_main.h"
@@ -103,6 +103,83 @@ TEST_CASE("compile simple cifar-10 model")
 	ccv_nnc_tensor_free(output_tensor);
 }
 
+TEST_CASE("checkpoint simple cifar-10 model to a memory-mapped file")
+{
+	ccv_cnnp_model_t* const sequential = simple_cifar_10();
+	const ccv_nnc_tensor_param_t input = CPU_TENSOR_NHWC(1, 31, 31, 3);
+	ccv_cnnp_model_compile(sequential, &input, 1, CMD_SGD_FORWARD(0.001, 0.99, 0.9, 0.9), CMD_CATEGORICAL_CROSSENTROPY_FORWARD());
+	ccv_nnc_tensor_t* const input_tensor = ccv_nnc_tensor_new(0, CPU_TENSOR_NHWC(1, 31, 31, 3), 0);
+	dsfmt_t dsfmt;
+	int i;
+	dsfmt_init_gen_rand(&dsfmt, 1);
+	for (i = 0; i < 31 * 31 * 3; i++)
+		input_tensor->data.f32[i] = dsfmt_genrand_open_close(&dsfmt) * 2 - 1;
+	ccv_nnc_tensor_t* const output_tensor = ccv_nnc_tensor_new(0, CPU_TENSOR_NHWC(1, 10), 0);
+	ccv_cnnp_model_evaluate(sequential, TENSOR_LIST(input_tensor), TENSOR_LIST(output_tensor), 0);
+	float expected[10];
+	memcpy(expected, output_tensor->data.f32, sizeof(float) * 10);
+	remove("/tmp/checkpoint_simple_cifar_10_model.mmap");
+	ccv_cnnp_model_checkpoint(sequential, "/tmp/checkpoint_simple_cifar_10_model.mmap", CCV_CNNP_MODEL_CHECKPOINT_MMAP);
+	ccv_cnnp_model_free(sequential);
+	ccv_cnnp_model_t* const sequential2 = simple_cifar_10();
+	ccv_cnnp_model_compile(sequential2, &input, 1, CMD_SGD_FORWARD(0.001, 0.99, 0.9, 0.9), CMD_CATEGORICAL_CROSSENTROPY_FORWARD());
+	// Load from the checkpoint file, the file can be removed because it is mapped already.
+	ccv_cnnp_model_checkpoint(sequential2, "/tmp/checkpoint_simple_cifar_10_model.mmap", CCV_CNNP_MODEL_CHECKPOINT_MMAP);
+	remove("/tmp/checkpoint_simple_cifar_10_model.mmap");
+	memset(output_tensor->data.f32, 0, sizeof(float) * 10);
+	ccv_cnnp_model_evaluate(sequential2, TENSOR_LIST(input_tensor), TENSOR_LIST(output_tensor), 0);
+	REQUIRE_ARRAY_EQ_WITH_TOLERANCE(float, output_tensor->data.f32, expected, 10, 1e-5, "should have the same output after loaded from the memory-mapped file");
+	// The model can still be trained, the updates only go to its own pages.
+	ccv_nnc_tensor_t* const fit_tensor = ccv_nnc_tensor_new(0, CPU_TENSOR_NHWC(1), 0);
+	fit_tensor->data.f32[0] = 0;
+	ccv_cnnp_model_fit(sequential2, TENSOR_LIST(input_tensor), TENSOR_LIST(fit_tensor), TENSOR_LIST(output_tensor), 0);
+	ccv_cnnp_model_free(sequential2);
+	ccv_nnc_tensor_free(input_tensor);
+	ccv_nnc_tensor_free(fit_tensor);
+	ccv_nnc_tensor_free(output_tensor);
+}
+
+TEST_CASE("not load a memory-mapped checkpoint missing a trainable tensor")
+{
+	ccv_cnnp_model_t* const sequential = simple_cifar_10();
+	const ccv_nnc_tensor_param_t input = CPU_TENSOR_NHWC(1, 31, 31, 3);
+	ccv_cnnp_model_compile(sequential, &input, 1, CMD_SGD_FORWARD(0.001, 0.99, 0.9, 0.9), CMD_CATEGORICAL_CROSSENTROPY_FORWARD());
+	ccv_nnc_tensor_t* const input_tensor = ccv_nnc_tensor_new(0, CPU_TENSOR_NHWC(1, 31, 31, 3), 0);
+	dsfmt_t dsfmt;
+	int i;
+	dsfmt_init_gen_rand(&dsfmt, 1);
+	for (i = 0; i < 31 * 31 * 3; i++)
+		input_tensor->data.f32[i] = dsfmt_genrand_open_close(&dsfmt) * 2 - 1;
+	ccv_nnc_tensor_t* const output_tensor = ccv_nnc_tensor_new(0, CPU_TENSOR_NHWC(1, 10), 0);
+	ccv_cnnp_model_evaluate(sequential, TENSOR_LIST(input_tensor), TENSOR_LIST(output_tensor), 0);
+	float expected[10];
+	memcpy(expected, output_tensor->data.f32, sizeof(float) * 10);
+	remove("/tmp/checkpoint_missing_simple_cifar_10_model.mmap");
+	remove("/tmp/checkpoint_intact_simple_cifar_10_model.mmap");
+	ccv_cnnp_model_checkpoint(sequential, "/tmp/checkpoint_missing_simple_cifar_10_model.mmap", CCV_CNNP_MODEL_CHECKPOINT_MMAP);
+	ccv_cnnp_model_checkpoint(sequential, "/tmp/checkpoint_intact_simple_cifar_10_model.mmap", CCV_CNNP_MODEL_CHECKPOINT_MMAP);
+	ccv_cnnp_model_free(sequential);
+	// Zero the offset and the size of the first tensor, right after the 16-byte header, it is missing from the file now.
+	FILE* const w = fopen("/tmp/checkpoint_missing_simple_cifar_10_model.mmap", "r+b");
+	const uint64_t zeros[2] = {0};
+	fseek(w, 16, SEEK_SET);
+	REQUIRE_EQ(fwrite(zeros, sizeof(zeros), 1, w), 1, "should zero the index of the first tensor");
+	fclose(w);
+	ccv_cnnp_model_t* const sequential2 = simple_cifar_10();
+	ccv_cnnp_model_compile(sequential2, &input, 1, CMD_SGD_FORWARD(0.001, 0.99, 0.9, 0.9), CMD_CATEGORICAL_CROSSENTROPY_FORWARD());
+	ccv_cnnp_model_checkpoint(sequential2, "/tmp/checkpoint_missing_simple_cifar_10_model.mmap", CCV_CNNP_MODEL_CHECKPOINT_MMAP);
+	remove("/tmp/checkpoint_missing_simple_cifar_10_model.mmap");
+	// Nothing is loaded, thus, the model is still not initialized and can load the intact file.
+	ccv_cnnp_model_checkpoint(sequential2, "/tmp/checkpoint_intact_simple_cifar_10_model.mmap", CCV_CNNP_MODEL_CHECKPOINT_MMAP);
+	remove("/tmp/checkpoint_intact_simple_cifar_10_model.mmap");
+	memset(output_tensor->data.f32, 0, sizeof(float) * 10);
+	ccv_cnnp_model_evaluate(sequential2, TENSOR_LIST(input_tensor), TENSOR_LIST(output_tensor), 0);
+	REQUIRE_ARRAY_EQ_WITH_TOLERANCE(float, output_tensor->data.f32, expected, 10, 1e-5, "should have the same output after loaded from the intact file");
+	ccv_cnnp_model_free(sequential2);
+	ccv_nnc_tensor_free(input_tensor);
+	ccv_nnc_tensor_free(output_tensor);
+}
+
 TEST_CASE("inception layer for model")
 {
 	const ccv_cnnp_model_io_t x = ccv_cnnp_input();
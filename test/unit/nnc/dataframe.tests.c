@@ -5,6 +5,7 @@
 #include <nnc/ccv_nnc.h>
 #include <nnc/ccv_nnc_easy.h>
 #include "3rdparty/dsfmt/dSFMT.h"
+#include <unistd.h>
 
 TEST_SETUP()
 {
@@ -42,4 +43,373 @@ TEST_CASE("iterate through a simple dataframe")
 	ccv_cnnp_dataframe_free(dataframe);
 }
 
+TEST_CASE("prefetch from a simple dataframe")
+{
+	int int_array[8] = {
+		2, 3, 4, 5, 6, 7, 8, 9
+	};
+	ccv_cnnp_column_data_t columns[] = {
+		{
+			.data_enum = _ccv_iter_int,
+			.context = int_array,
+		}
+	};
+	ccv_cnnp_dataframe_t* const dataframe = ccv_cnnp_dataframe_new(columns, sizeof(columns) / sizeof(columns[0]), 8);
+	ccv_cnnp_dataframe_iter_t* const iter = ccv_cnnp_dataframe_iter_new(dataframe, COLUMN_ID_LIST(0));
+	int result[8];
+	int i = 0;
+	void* data;
+	REQUIRE_EQ(ccv_cnnp_dataframe_iter_prefetch(iter, 3, 0), 0, "should prefetch 3 rows");
+	while (0 == ccv_cnnp_dataframe_iter_next(iter, &data, 1, 0))
+	{
+		result[i++] = (int)(intptr_t)data;
+		ccv_cnnp_dataframe_iter_prefetch(iter, 1, 0);
+	}
+	REQUIRE_EQ(ccv_cnnp_dataframe_iter_prefetch(iter, 1, 0), -1, "should have nothing to prefetch");
+	ccv_cnnp_dataframe_iter_free(iter);
+	REQUIRE_ARRAY_EQ(int, int_array, result, 8, "iterated result and actual result should be the same");
+	ccv_cnnp_dataframe_free(dataframe);
+}
+
+static int _ccv_int_alloc_count = 0;
+
+static void _ccv_int_plus_1(void** const column_data, const int column_size, void** const data, void* const context, ccv_nnc_stream_context_t* const stream_context)
+{
+	if (!*data)
+	{
+		*data = ccmalloc(sizeof(int));
+		__sync_fetch_and_add(&_ccv_int_alloc_count, 1);
+	}
+	*(int*)*data = (int)(intptr_t)column_data[0] + 1;
+}
+
+TEST_CASE("prefetch derived column on a CPU stream context")
+{
+	int int_array[8] = {
+		2, 3, 4, 5, 6, 7, 8, 9
+	};
+	ccv_cnnp_column_data_t columns[] = {
+		{
+			.data_enum = _ccv_iter_int,
+			.context = int_array,
+		}
+	};
+	ccv_cnnp_dataframe_t* const dataframe = ccv_cnnp_dataframe_new(columns, sizeof(columns) / sizeof(columns[0]), 8);
+	const int derived = ccv_cnnp_dataframe_map(dataframe, _ccv_int_plus_1, ccfree, COLUMN_ID_LIST(0), 0);
+	ccv_cnnp_dataframe_iter_t* const iter = ccv_cnnp_dataframe_iter_new(dataframe, COLUMN_ID_LIST(derived));
+	ccv_nnc_stream_context_t* const stream = ccv_nnc_stream_context_new(CCV_STREAM_CONTEXT_CPU);
+	int result[8];
+	int i = 0;
+	void* data;
+	ccv_cnnp_dataframe_iter_prefetch(iter, 2, stream);
+	while (0 == ccv_cnnp_dataframe_iter_next(iter, &data, 1, stream))
+	{
+		result[i++] = *(int*)data;
+		ccv_cnnp_dataframe_iter_prefetch(iter, 1, stream);
+	}
+	ccv_cnnp_dataframe_iter_free(iter);
+	int expected[8] = {
+		3, 4, 5, 6, 7, 8, 9, 10
+	};
+	REQUIRE_ARRAY_EQ(int, expected, result, 8, "iterated result and actual result should be the same");
+	REQUIRE(_ccv_int_alloc_count <= 3, "should reuse the data returned to the stream context");
+	ccv_cnnp_dataframe_free(dataframe);
+	ccv_nnc_stream_context_free(stream);
+}
+
+static void _ccv_int_slow(void** const column_data, const int column_size, void** const data, void* const context, ccv_nnc_stream_context_t* const stream_context)
+{
+	const int value = (int)(intptr_t)column_data[0];
+	// Rows after the first two take their buffers while the stream context still reads the first one.
+	if (value == 4 || value == 5)
+		usleep(30000);
+	*data = (void*)(intptr_t)value;
+}
+
+static void _ccv_int_copy_plus_1(void** const column_data, const int column_size, void** const data, void* const context, ccv_nnc_stream_context_t* const stream_context)
+{
+	if (!*data)
+		*data = ccmalloc(sizeof(int));
+	*(int*)*data = (int)(intptr_t)column_data[0] + 1;
+}
+
+static int _ccv_read_slow(const ccv_nnc_cmd_t cmd, const ccv_nnc_hint_t hint, const int flags, ccv_nnc_tensor_t* const* const inputs, const int input_size, ccv_nnc_tensor_t* const* const outputs, const int output_size, ccv_nnc_stream_context_t* const stream_context)
+{
+	usleep(50000);
+	outputs[0]->data.i32[0] = inputs[0]->data.i32[0];
+	return CCV_NNC_EXEC_SUCCESS;
+}
+
+TEST_CASE("prefetched rows don't reuse data still read on the stream context")
+{
+	int int_array[8] = {
+		2, 3, 4, 5, 6, 7, 8, 9
+	};
+	ccv_cnnp_column_data_t columns[] = {
+		{
+			.data_enum = _ccv_iter_int,
+			.context = int_array,
+		}
+	};
+	ccv_cnnp_dataframe_t* const dataframe = ccv_cnnp_dataframe_new(columns, sizeof(columns) / sizeof(columns[0]), 8);
+	const int slow = ccv_cnnp_dataframe_map(dataframe, _ccv_int_slow, 0, COLUMN_ID_LIST(0), 0);
+	const int derived = ccv_cnnp_dataframe_map(dataframe, _ccv_int_copy_plus_1, ccfree, COLUMN_ID_LIST(0), 0);
+	ccv_cnnp_dataframe_iter_t* const iter = ccv_cnnp_dataframe_iter_new(dataframe, COLUMN_ID_LIST(slow, derived));
+	ccv_nnc_stream_context_t* const stream = ccv_nnc_stream_context_new(CCV_STREAM_CONTEXT_CPU);
+	ccv_nnc_tensor_t* inputs[8];
+	ccv_nnc_tensor_t* outputs[8];
+	int i = 0;
+	void* data[2];
+	ccv_cnnp_dataframe_iter_prefetch(iter, 4, stream);
+	while (0 == ccv_cnnp_dataframe_iter_next(iter, data, 2, stream))
+	{
+		inputs[i] = ccv_nnc_tensor_new(data[1], ONE_CPU_TENSOR(1), 0);
+		outputs[i] = ccv_nnc_tensor_new(0, ONE_CPU_TENSOR(1), 0);
+		ccv_nnc_cmd_exec(CMD_CUSTOM_FORWARD(_ccv_read_slow), ccv_nnc_no_hint, 0, TENSOR_LIST(inputs[i]), TENSOR_LIST(outputs[i]), stream);
+		++i;
+		ccv_cnnp_dataframe_iter_prefetch(iter, 1, stream);
+	}
+	ccv_nnc_stream_context_wait(stream);
+	ccv_cnnp_dataframe_iter_free(iter);
+	int expected[8] = {
+		3, 4, 5, 6, 7, 8, 9, 10
+	};
+	int result[8];
+	for (i = 0; i < 8; i++)
+	{
+		result[i] = outputs[i]->data.i32[0];
+		ccv_nnc_tensor_free(inputs[i]);
+		ccv_nnc_tensor_free(outputs[i]);
+	}
+	REQUIRE_ARRAY_EQ(int, expected, result, 8, "the stream context should read the data of its own row");
+	ccv_cnnp_dataframe_free(dataframe);
+	ccv_nnc_stream_context_free(stream);
+}
+
+static void _ccv_iter_tensor(const int column_idx, const int row_idx, const int row_size, void** const data, void* const context, ccv_nnc_stream_context_t* const stream_context)
+{
+	// A 2x2x3 NHWC tensor, its values are row_idx * 100 + its position.
+	ccv_nnc_tensor_t* tensor = (ccv_nnc_tensor_t*)*data;
+	if (!tensor)
+		tensor = ccv_nnc_tensor_new(0, CPU_TENSOR_NHWC(2, 2, 3), 0);
+	int i;
+	for (i = 0; i < 2 * 2 * 3; i++)
+		tensor->data.f32[i] = row_idx * 100 + i;
+	*data = tensor;
+}
+
+static void _ccv_tensor_deinit(void* const data)
+{
+	ccv_nnc_tensor_free((ccv_nnc_tensor_t*)data);
+}
+
+TEST_CASE("batch tensors from a dataframe")
+{
+	ccv_cnnp_column_data_t columns[] = {
+		{
+			.data_enum = _ccv_iter_tensor,
+			.deinit = _ccv_tensor_deinit,
+		}
+	};
+	ccv_cnnp_dataframe_t* const dataframe = ccv_cnnp_dataframe_new(columns, sizeof(columns) / sizeof(columns[0]), 8);
+	ccv_cnnp_dataframe_t* const batching = ccv_cnnp_dataframe_batching_new(dataframe, COLUMN_ID_LIST(0), 3, 0);
+	ccv_cnnp_dataframe_iter_t* const iter = ccv_cnnp_dataframe_iter_new(batching, COLUMN_ID_LIST(0));
+	int i, j = 0;
+	void* data;
+	while (0 == ccv_cnnp_dataframe_iter_next(iter, &data, 1, 0))
+	{
+		const ccv_nnc_tensor_t* const batch = (ccv_nnc_tensor_t*)data;
+		const int batch_count = j < 2 ? 3 : 2;
+		REQUIRE_EQ(batch->info.dim[0], batch_count, "should have the rows of a batch");
+		REQUIRE_EQ(batch->info.dim[3], 3, "should keep the shape of the rows");
+		float expected[3 * 2 * 2 * 3];
+		for (i = 0; i < batch_count * 2 * 2 * 3; i++)
+			expected[i] = (j * 3 + i / 12) * 100 + i % 12;
+		REQUIRE_ARRAY_EQ(float, batch->data.f32, expected, batch_count * 2 * 2 * 3, "should be the consecutive rows");
+		++j;
+	}
+	REQUIRE_EQ(j, 3, "should have 3 batches");
+	ccv_cnnp_dataframe_iter_free(iter);
+	ccv_cnnp_dataframe_free(batching);
+	ccv_cnnp_dataframe_free(dataframe);
+}
+
+TEST_CASE("batch tensors from a dataframe and transform them to NCHW")
+{
+	ccv_cnnp_column_data_t columns[] = {
+		{
+			.data_enum = _ccv_iter_tensor,
+			.deinit = _ccv_tensor_deinit,
+		}
+	};
+	ccv_cnnp_dataframe_t* const dataframe = ccv_cnnp_dataframe_new(columns, sizeof(columns) / sizeof(columns[0]), 8);
+	ccv_cnnp_dataframe_t* const batching = ccv_cnnp_dataframe_batching_new(dataframe, COLUMN_ID_LIST(0), 4, CCV_TENSOR_FORMAT_NCHW);
+	ccv_cnnp_dataframe_iter_t* const iter = ccv_cnnp_dataframe_iter_new(batching, COLUMN_ID_LIST(0));
+	int i, j = 0;
+	void* data;
+	while (0 == ccv_cnnp_dataframe_iter_next(iter, &data, 1, 0))
+	{
+		const ccv_nnc_tensor_t* const batch = (ccv_nnc_tensor_t*)data;
+		REQUIRE_EQ(batch->info.format, CCV_TENSOR_FORMAT_NCHW, "should be in NCHW format");
+		REQUIRE_EQ(batch->info.dim[0], 4, "should have the rows of a batch");
+		REQUIRE_EQ(batch->info.dim[1], 3, "should have channels first");
+		float expected[4 * 3 * 2 * 2];
+		for (i = 0; i < 4 * 3 * 2 * 2; i++)
+		{
+			const int n = i / 12, c = (i % 12) / 4, hw = i % 4;
+			expected[i] = (j * 4 + n) * 100 + hw * 3 + c;
+		}
+		REQUIRE_ARRAY_EQ(float, batch->data.f32, expected, 4 * 3 * 2 * 2, "should be the rows in NCHW");
+		++j;
+	}
+	REQUIRE_EQ(j, 2, "should have 2 batches");
+	ccv_cnnp_dataframe_iter_free(iter);
+	ccv_cnnp_dataframe_free(batching);
+	ccv_cnnp_dataframe_free(dataframe);
+}
+
+static void _ccv_iter_row_idx(const int column_idx, const int row_idx, const int row_size, void** const data, void* const context, ccv_nnc_stream_context_t* const stream_context)
+{
+	*data = (void*)(intptr_t)(row_idx + 1);
+}
+
+TEST_CASE("batch shuffled rows from a dataframe, and shuffle them again every epoch")
+{
+	ccv_cnnp_column_data_t columns[] = {
+		{
+			.data_enum = _ccv_iter_tensor,
+			.deinit = _ccv_tensor_deinit,
+		}
+	};
+	ccv_cnnp_dataframe_t* const dataframe = ccv_cnnp_dataframe_new(columns, sizeof(columns) / sizeof(columns[0]), 16);
+	ccv_cnnp_dataframe_t* const batching = ccv_cnnp_dataframe_shuffled_batching_new(dataframe, COLUMN_ID_LIST(0), 4, 0, 7);
+	ccv_cnnp_dataframe_iter_t* const iter = ccv_cnnp_dataframe_iter_new(batching, COLUMN_ID_LIST(0));
+	int epoch_rows[3][16];
+	int epoch, i, j;
+	void* data;
+	for (epoch = 0; epoch < 3; epoch++)
+	{
+		ccv_cnnp_dataframe_iter_set_epoch(iter, epoch == 2 ? 0 : epoch);
+		int seen[16] = {0};
+		for (j = 0; 0 == ccv_cnnp_dataframe_iter_next(iter, &data, 1, 0); j++)
+		{
+			const ccv_nnc_tensor_t* const batch = (ccv_nnc_tensor_t*)data;
+			REQUIRE_EQ(batch->info.dim[0], 4, "should have the rows of a batch");
+			for (i = 0; i < 4; i++)
+			{
+				const int row_idx = (int)(batch->data.f32[i * 12] / 100 + 0.5);
+				REQUIRE_EQ_WITH_TOLERANCE(batch->data.f32[i * 12 + 11], row_idx * 100 + 11, 1e-5, "should copy the whole row");
+				epoch_rows[epoch][j * 4 + i] = row_idx;
+				++seen[row_idx];
+			}
+		}
+		REQUIRE_EQ(j, 4, "should have 4 batches");
+		int ones[16];
+		for (i = 0; i < 16; i++)
+			ones[i] = 1;
+		REQUIRE_ARRAY_EQ(int, seen, ones, 16, "each row should be batched exactly once in an epoch");
+	}
+	int sorted[16];
+	for (i = 0; i < 16; i++)
+		sorted[i] = i;
+	REQUIRE(memcmp(epoch_rows[0], sorted, sizeof(int) * 16) != 0, "rows should be shuffled before batching");
+	REQUIRE(memcmp(epoch_rows[0], epoch_rows[1], sizeof(int) * 16) != 0, "batches should have different rows in a different epoch");
+	REQUIRE_ARRAY_EQ(int, epoch_rows[0], epoch_rows[2], 16, "the same epoch should have the same batches");
+	ccv_cnnp_dataframe_iter_free(iter);
+	ccv_cnnp_dataframe_free(batching);
+	ccv_cnnp_dataframe_free(dataframe);
+}
+
+static int _ccv_shuffled_rows(ccv_cnnp_dataframe_iter_t* const iter, int* const rows)
+{
+	int i = 0;
+	void* data;
+	while (0 == ccv_cnnp_dataframe_iter_next(iter, &data, 1, 0))
+		rows[i++] = (int)(intptr_t)data - 1;
+	return i;
+}
+
+TEST_CASE("shuffle and shard rows of a dataframe by blocks")
+{
+	ccv_cnnp_column_data_t columns[] = {
+		{
+			.data_enum = _ccv_iter_row_idx,
+		}
+	};
+	ccv_cnnp_dataframe_t* const dataframe = ccv_cnnp_dataframe_new(columns, sizeof(columns) / sizeof(columns[0]), 18);
+	ccv_cnnp_dataframe_iter_t* const iter0 = ccv_cnnp_dataframe_iter_new(dataframe, COLUMN_ID_LIST(0));
+	ccv_cnnp_dataframe_iter_t* const iter1 = ccv_cnnp_dataframe_iter_new(dataframe, COLUMN_ID_LIST(0));
+	ccv_cnnp_dataframe_iter_shuffle(iter0, 17, 4, 0, 2);
+	ccv_cnnp_dataframe_iter_shuffle(iter1, 17, 4, 1, 2);
+	int rows[18];
+	int seen[18] = {0};
+	int i, j, epoch;
+	int epoch_rows[2][18];
+	for (epoch = 0; epoch < 2; epoch++)
+	{
+		ccv_cnnp_dataframe_iter_set_epoch(iter0, epoch);
+		ccv_cnnp_dataframe_iter_set_epoch(iter1, epoch);
+		memset(seen, 0, sizeof(seen));
+		int row_size = 0;
+		for (i = 0; i < 2; i++)
+		{
+			const int shard_row_size = _ccv_shuffled_rows(i == 0 ? iter0 : iter1, rows);
+			int block_change = 0;
+			for (j = 0; j < shard_row_size; j++)
+			{
+				++seen[rows[j]];
+				if (j > 0 && rows[j] / 4 != rows[j - 1] / 4)
+					++block_change;
+			}
+			REQUIRE(block_change < (shard_row_size + 3) / 4 + 1, "rows from a block should be read together");
+			memcpy(epoch_rows[epoch] + row_size, rows, sizeof(int) * shard_row_size);
+			row_size += shard_row_size;
+		}
+		REQUIRE_EQ(row_size, 18, "shards should cover all rows");
+		int ones[18];
+		for (i = 0; i < 18; i++)
+			ones[i] = 1;
+		REQUIRE_ARRAY_EQ(int, seen, ones, 18, "each row should be read exactly once in an epoch");
+	}
+	ccv_cnnp_dataframe_iter_set_epoch(iter0, 0);
+	ccv_cnnp_dataframe_iter_set_epoch(iter1, 0);
+	const int row_size = _ccv_shuffled_rows(iter0, rows);
+	_ccv_shuffled_rows(iter1, rows + row_size);
+	REQUIRE_ARRAY_EQ(int, rows, epoch_rows[0], 18, "the same epoch should have the same order");
+	REQUIRE(memcmp(epoch_rows[0], epoch_rows[1], sizeof(int) * 18) != 0, "a different epoch should have a different order");
+	ccv_cnnp_dataframe_iter_free(iter0);
+	ccv_cnnp_dataframe_iter_free(iter1);
+	ccv_cnnp_dataframe_free(dataframe);
+}
+
+TEST_CASE("prefetched rows are discarded when setting an epoch")
+{
+	ccv_cnnp_column_data_t columns[] = {
+		{
+			.data_enum = _ccv_iter_row_idx,
+		}
+	};
+	ccv_cnnp_dataframe_t* const dataframe = ccv_cnnp_dataframe_new(columns, sizeof(columns) / sizeof(columns[0]), 8);
+	ccv_cnnp_dataframe_iter_t* const iter = ccv_cnnp_dataframe_iter_new(dataframe, COLUMN_ID_LIST(0));
+	ccv_nnc_stream_context_t* const stream = ccv_nnc_stream_context_new(CCV_STREAM_CONTEXT_CPU);
+	ccv_cnnp_dataframe_iter_shuffle(iter, 1, 8, 0, 1);
+	int expected[8];
+	REQUIRE_EQ(_ccv_shuffled_rows(iter, expected), 8, "should go through all rows");
+	ccv_cnnp_dataframe_iter_set_epoch(iter, 0);
+	ccv_cnnp_dataframe_iter_prefetch(iter, 4, stream);
+	void* data;
+	ccv_cnnp_dataframe_iter_next(iter, &data, 1, stream);
+	ccv_cnnp_dataframe_iter_set_epoch(iter, 0);
+	int rows[8];
+	int i = 0;
+	ccv_cnnp_dataframe_iter_prefetch(iter, 2, stream);
+	while (0 == ccv_cnnp_dataframe_iter_next(iter, &data, 1, stream))
+		rows[i++] = (int)(intptr_t)data - 1;
+	REQUIRE_EQ(i, 8, "should go through all rows again");
+	REQUIRE_ARRAY_EQ(int, rows, expected, 8, "should be in the same order");
+	ccv_cnnp_dataframe_iter_free(iter);
+	ccv_nnc_stream_context_free(stream);
+	ccv_cnnp_dataframe_free(dataframe);
+}
+
 #include "case_main.h"
@@ -4,6 +4,7 @@
 #include <ccv.h>
 #include <nnc/ccv_nnc.h>
 #include <nnc/ccv_nnc_easy.h>
+#include <3rdparty/sqlite3/sqlite3.h>
 
 TEST_SETUP()
 {
@@ -53,4 +54,158 @@ TEST_CASE("write graph (x + y) * (x + y) and read")
 	ccv_nnc_graph_exec_arena_free(graph_exec_arena);
 }
 
+TEST_CASE("write graph x * c with a constant c and read")
+{
+	ccv_nnc_symbolic_graph_t* const symbolic_graph = ccv_nnc_symbolic_graph_new();
+	ccv_nnc_tensor_symbol_t x = ccv_nnc_tensor_symbol_new(symbolic_graph, ONE_CPU_TENSOR(2), "x");
+	const float c0[] = {3, 4};
+	ccv_nnc_tensor_symbol_t c = ccv_nnc_tensor_symbol_constant_new(symbolic_graph, ONE_CPU_TENSOR(2), c0, "c");
+	ccv_nnc_tensor_symbol_t z = ccv_nnc_tensor_symbol_new(symbolic_graph, ONE_CPU_TENSOR(2), "z");
+	ccv_nnc_graph_exec_symbol_new(symbolic_graph, CMD_EWPROD_FORWARD(), TENSOR_SYMBOL_LIST(x, c), TENSOR_SYMBOL_LIST(z), "prod");
+	ccv_nnc_graph_exec_symbol_autogen(symbolic_graph, 0, 0, CCV_NNC_AUTOGEN_ALL_EXECS | CCV_NNC_AUTOGEN_SOURCES_AND_DESTINATIONS);
+	const uint64_t sig = ccv_nnc_tensor_symbol_constant(symbolic_graph, c)->sig;
+	static char fn[] = "gen/write_graph_x___c_with_a_constant_c_and_read.graph";
+	remove(fn);
+	ccv_nnc_symbolic_graph_write(symbolic_graph, TENSOR_BIND_MAP(KV(x, 0), KV(c, 0), KV(z, 0)), fn);
+	ccv_nnc_symbolic_graph_free(symbolic_graph);
+	ccv_nnc_symbolic_graph_t* symbolic_graph_2 = 0;
+	ccv_nnc_tensor_bind_t* tensor_binds = 0;
+	int tensor_bind_size = 0;
+	ccv_nnc_symbolic_graph_read(fn, &symbolic_graph_2, &tensor_binds, &tensor_bind_size);
+	x = tensor_binds[0].symbol;
+	c = tensor_binds[1].symbol;
+	z = tensor_binds[2].symbol;
+	ccfree(tensor_binds);
+	const ccv_nnc_tensor_t* const constant = ccv_nnc_tensor_symbol_constant(symbolic_graph_2, c);
+	REQUIRE(constant != 0, "the constant should be read back");
+	REQUIRE_ARRAY_EQ(float, constant->data.f32, c0, 2, "the constant should have the same content");
+	REQUIRE_EQ(constant->sig, sig, "the constant should have the same signature");
+	ccv_nnc_graph_t* graph = 0;
+	ccv_nnc_tensor_arena_t* tensor_arena = 0;
+	ccv_nnc_graph_exec_arena_t* graph_exec_arena = 0;
+	ccv_nnc_symbolic_graph_compile(symbolic_graph_2, 0, 0, 0, 0, SYMBOLIC_GRAPH_SOURCES(symbolic_graph_2), SYMBOLIC_GRAPH_DESTINATIONS(symbolic_graph_2), &graph, &tensor_arena, &graph_exec_arena);
+	ccv_nnc_tensor_t* const x_tensor = ccv_nnc_tensor_from_symbol(tensor_arena, x);
+	x_tensor->data.f32[0] = 10;
+	x_tensor->data.f32[1] = 8;
+	ccv_nnc_graph_run(graph, 0, 0, 0, TRAVERSE_FULL);
+	ccv_nnc_tensor_t* const z_tensor = ccv_nnc_tensor_from_symbol(tensor_arena, z);
+	REQUIRE_EQ_WITH_TOLERANCE(z_tensor->data.f32[0], 10 * 3, 1e-5, "result should be equal");
+	REQUIRE_EQ_WITH_TOLERANCE(z_tensor->data.f32[1], 8 * 4, 1e-5, "result should be equal");
+	ccv_nnc_symbolic_graph_free(symbolic_graph_2);
+	ccv_nnc_graph_free(graph);
+	ccv_nnc_tensor_arena_free(tensor_arena);
+	ccv_nnc_graph_exec_arena_free(graph_exec_arena);
+}
+
+TEST_CASE("read graph x * y written without the constant column and write it again")
+{
+	ccv_nnc_symbolic_graph_t* const symbolic_graph = ccv_nnc_symbolic_graph_new();
+	ccv_nnc_tensor_symbol_t x = ccv_nnc_tensor_symbol_new(symbolic_graph, ONE_CPU_TENSOR(1), "x");
+	ccv_nnc_tensor_symbol_t y = ccv_nnc_tensor_symbol_new(symbolic_graph, ONE_CPU_TENSOR(1), "y");
+	ccv_nnc_tensor_symbol_t z = ccv_nnc_tensor_symbol_new(symbolic_graph, ONE_CPU_TENSOR(1), "z");
+	ccv_nnc_graph_exec_symbol_new(symbolic_graph, CMD_EWPROD_FORWARD(), TENSOR_SYMBOL_LIST(x, y), TENSOR_SYMBOL_LIST(z), "prod");
+	ccv_nnc_graph_exec_symbol_autogen(symbolic_graph, 0, 0, CCV_NNC_AUTOGEN_ALL_EXECS | CCV_NNC_AUTOGEN_SOURCES_AND_DESTINATIONS);
+	static char fn[] = "gen/read_graph_x___y_written_without_the_constant_column_and_write_it_again.graph";
+	remove(fn);
+	ccv_nnc_symbolic_graph_write(symbolic_graph, TENSOR_BIND_MAP(KV(x, 0), KV(y, 0), KV(z, 0)), fn);
+	ccv_nnc_symbolic_graph_free(symbolic_graph);
+	// Rewrite the tensor symbol table the way it was before the constant column.
+	sqlite3* conn = 0;
+	REQUIRE_EQ(sqlite3_open(fn, &conn), SQLITE_OK, "should open the graph file directly");
+	const char old_schema_qs[] =
+		"CREATE TABLE old_tensor_symbol "
+		"(id INTEGER, graph INTEGER, assign_ref INTEGER, r_assign_ref INTEGER, "
+		"bypass_ref INTEGER, r_bypass_ref INTEGER, p_ref INTEGER, alias_ref INTEGER, peer_ref INTEGER, "
+		"flags INTEGER, ofs BLOB, inc BLOB, s_ref BLOB, name TEXT, type INTEGER, format INTEGER, "
+		"datatype INTEGER, dim BLOB, PRIMARY KEY (id, graph));"
+		"INSERT INTO old_tensor_symbol SELECT id, graph, assign_ref, r_assign_ref, bypass_ref, r_bypass_ref, p_ref, "
+		"alias_ref, peer_ref, flags, ofs, inc, s_ref, name, type, format, datatype, dim FROM tensor_symbol;"
+		"DROP TABLE tensor_symbol;"
+		"ALTER TABLE old_tensor_symbol RENAME TO tensor_symbol;";
+	REQUIRE_EQ(sqlite3_exec(conn, old_schema_qs, 0, 0, 0), SQLITE_OK, "should drop the constant column");
+	sqlite3_close(conn);
+	ccv_nnc_symbolic_graph_t* symbolic_graph_2 = 0;
+	ccv_nnc_tensor_bind_t* tensor_binds = 0;
+	int tensor_bind_size = 0;
+	ccv_nnc_symbolic_graph_read(fn, &symbolic_graph_2, &tensor_binds, &tensor_bind_size);
+	REQUIRE(symbolic_graph_2 != 0, "should read the graph written without the constant column");
+	REQUIRE_EQ(tensor_bind_size, 3, "should read all the tensor binds");
+	x = tensor_binds[0].symbol;
+	y = tensor_binds[1].symbol;
+	z = tensor_binds[2].symbol;
+	ccfree(tensor_binds);
+	// Writing into the same file should add the constant column.
+	ccv_nnc_symbolic_graph_write(symbolic_graph_2, TENSOR_BIND_MAP(KV(x, 0), KV(y, 0), KV(z, 0)), fn);
+	ccv_nnc_symbolic_graph_free(symbolic_graph_2);
+	ccv_nnc_symbolic_graph_read(fn, &symbolic_graph_2, &tensor_binds, &tensor_bind_size);
+	x = tensor_binds[0].symbol;
+	y = tensor_binds[1].symbol;
+	z = tensor_binds[2].symbol;
+	ccfree(tensor_binds);
+	REQUIRE(ccv_nnc_tensor_symbol_constant(symbolic_graph_2, y) == 0, "no tensor symbol should be read as constant");
+	ccv_nnc_graph_t* graph = 0;
+	ccv_nnc_tensor_arena_t* tensor_arena = 0;
+	ccv_nnc_graph_exec_arena_t* graph_exec_arena = 0;
+	ccv_nnc_symbolic_graph_compile(symbolic_graph_2, 0, 0, 0, 0, SYMBOLIC_GRAPH_SOURCES(symbolic_graph_2), SYMBOLIC_GRAPH_DESTINATIONS(symbolic_graph_2), &graph, &tensor_arena, &graph_exec_arena);
+	ccv_nnc_tensor_from_symbol(tensor_arena, x)->data.f32[0] = 10;
+	ccv_nnc_tensor_from_symbol(tensor_arena, y)->data.f32[0] = 8;
+	ccv_nnc_graph_run(graph, 0, 0, 0, TRAVERSE_FULL);
+	REQUIRE_EQ_WITH_TOLERANCE(ccv_nnc_tensor_from_symbol(tensor_arena, z)->data.f32[0], 10 * 8, 1e-5, "result should be equal");
+	ccv_nnc_symbolic_graph_free(symbolic_graph_2);
+	ccv_nnc_graph_free(graph);
+	ccv_nnc_tensor_arena_free(tensor_arena);
+	ccv_nnc_graph_exec_arena_free(graph_exec_arena);
+}
+
+TEST_CASE("autotune results are remembered in the database")
+{
+	ccv_nnc_tensor_t* a = ccv_nnc_tensor_new(0, ONE_CPU_TENSOR(15, 15, 8), 0);
+	ccv_nnc_tensor_t* b = ccv_nnc_tensor_new(0, ONE_CPU_TENSOR(15, 15, 8), 0);
+	ccv_nnc_cmd_t cmd = CMD_CONVOLUTION_FORWARD(1, 8, 3, 3, 8);
+	ccv_nnc_hint_t hint = ccv_nnc_hint_auto(cmd.info, a->info, b->info);
+	ccv_nnc_tensor_t* w = ccv_nnc_tensor_new(0, ONE_CPU_TENSOR(8, 3, 3, 8), 0);
+	ccv_nnc_tensor_t* bias = ccv_nnc_tensor_new(0, ONE_CPU_TENSOR(8), 0);
+	memset(a->data.f32, 0, sizeof(float) * 15 * 15 * 8);
+	memset(w->data.f32, 0, sizeof(float) * 8 * 3 * 3 * 8);
+	memset(bias->data.f32, 0, sizeof(float) * 8);
+	static char fn[] = "gen/autotune_results_are_remembered_in_the_database.sqlite3";
+	remove(fn);
+	REQUIRE_EQ(ccv_nnc_cmd_autotune_db_open(fn), 0, "should open the autotune database");
+	ccv_nnc_cmd_t tuned_cmd = ccv_nnc_cmd_autotune(cmd, 0, hint, 0, TENSOR_LIST(a, w, bias), TENSOR_LIST(b), 0);
+	REQUIRE(tuned_cmd.backend != CCV_NNC_NO_BACKEND, "should find a backend");
+	ccv_nnc_cmd_autotune_db_close();
+	// Mark the result as the reference backend, if it is read back, autotune will pick it without running anything.
+	sqlite3* conn = 0;
+	REQUIRE_EQ(sqlite3_open(fn, &conn), SQLITE_OK, "should open the autotune database directly");
+	char update_qs[128];
+	snprintf(update_qs, sizeof(update_qs), "UPDATE autotune SET backend=%u, algorithm=0", CCV_NNC_BACKEND_CPU_REF);
+	REQUIRE_EQ(sqlite3_exec(conn, update_qs, 0, 0, 0), SQLITE_OK, "should update the autotune result");
+	REQUIRE_EQ(sqlite3_changes(conn), 1, "should have exactly one autotune result");
+	sqlite3_close(conn);
+	REQUIRE_EQ(ccv_nnc_cmd_autotune_db_open(fn), 0, "should reopen the autotune database");
+	tuned_cmd = ccv_nnc_cmd_autotune(cmd, 0, hint, 0, TENSOR_LIST(a, w, bias), TENSOR_LIST(b), 0);
+	REQUIRE_EQ(tuned_cmd.backend, CCV_NNC_BACKEND_CPU_REF, "should use the backend from the database");
+	REQUIRE_EQ(tuned_cmd.algorithm, 0, "should use the algorithm from the database");
+	// A different shape is not in the database, it will be tuned (and remembered).
+	ccv_nnc_tensor_t* c = ccv_nnc_tensor_new(0, ONE_CPU_TENSOR(8, 8, 8), 0);
+	ccv_nnc_hint_t c_hint = ccv_nnc_hint_auto(cmd.info, a->info, c->info);
+	c_hint.stride.dim[0] = c_hint.stride.dim[1] = 2;
+	tuned_cmd = ccv_nnc_cmd_autotune(cmd, 0, c_hint, 0, TENSOR_LIST(a, w, bias), TENSOR_LIST(c), 0);
+	REQUIRE(tuned_cmd.backend != CCV_NNC_NO_BACKEND, "should find a backend");
+	ccv_nnc_cmd_autotune_db_close();
+	conn = 0;
+	sqlite3_open(fn, &conn);
+	sqlite3_stmt* count_stmt = 0;
+	sqlite3_prepare_v2(conn, "SELECT COUNT(*) FROM autotune", -1, &count_stmt, 0);
+	REQUIRE_EQ(sqlite3_step(count_stmt), SQLITE_ROW, "should count the autotune results");
+	REQUIRE_EQ(sqlite3_column_int(count_stmt, 0), 2, "should remember both shapes");
+	sqlite3_finalize(count_stmt);
+	sqlite3_close(conn);
+	ccv_nnc_tensor_free(c);
+	ccv_nnc_tensor_free(bias);
+	ccv_nnc_tensor_free(w);
+	ccv_nnc_tensor_free(b);
+	ccv_nnc_tensor_free(a);
+}
+
 #include "case_main.h"
@@ -4,6 +4,7 @@
 #include <ccv.h>
 #include <nnc/ccv_nnc.h>
 #include <nnc/ccv_nnc_easy.h>
+#include <unistd.h>
 
 TEST_SETUP()
 {
@@ -59,6 +60,144 @@ TEST_CASE("schedule a simple graph for parallel execution")
 	ccv_nnc_graph_exec_arena_free(graph_exec_arena);
 }
 
+TEST_CASE("run a scheduled graph on CPU streams concurrently")
+{
+	ccv_nnc_symbolic_graph_t* const symbolic_graph = ccv_nnc_symbolic_graph_new();
+	const ccv_nnc_tensor_symbol_t x = ccv_nnc_tensor_symbol_new(symbolic_graph, ONE_CPU_TENSOR(1), "x");
+	const ccv_nnc_tensor_symbol_t y = ccv_nnc_tensor_symbol_new(symbolic_graph, ONE_CPU_TENSOR(1), "y");
+	const ccv_nnc_tensor_symbol_t z = ccv_nnc_tensor_symbol_new(symbolic_graph, ONE_CPU_TENSOR(1), "z");
+	ccv_nnc_graph_exec_symbol_new(symbolic_graph, CMD_EWPROD_FORWARD(), TENSOR_SYMBOL_LIST(x, y), TENSOR_SYMBOL_LIST(z), "mul");
+	const ccv_nnc_tensor_symbol_t a = ccv_nnc_tensor_symbol_new(symbolic_graph, ONE_CPU_TENSOR(1), "a");
+	const ccv_nnc_tensor_symbol_t b = ccv_nnc_tensor_symbol_new(symbolic_graph, ONE_CPU_TENSOR(1), "b");
+	const ccv_nnc_tensor_symbol_t c = ccv_nnc_tensor_symbol_new(symbolic_graph, ONE_CPU_TENSOR(1), "c");
+	ccv_nnc_graph_exec_symbol_new(symbolic_graph, CMD_EWSUM_FORWARD(), TENSOR_SYMBOL_LIST(a, b), TENSOR_SYMBOL_LIST(c), "sum");
+	const ccv_nnc_tensor_symbol_t d = ccv_nnc_tensor_symbol_new(symbolic_graph, ONE_CPU_TENSOR(1), "d");
+	ccv_nnc_graph_exec_symbol_new(symbolic_graph, CMD_EWDIV_FORWARD(), TENSOR_SYMBOL_LIST(z, c), TENSOR_SYMBOL_LIST(d), "div");
+	const ccv_nnc_tensor_symbol_t d0 = ccv_nnc_tensor_symbol_new(symbolic_graph, ONE_CPU_TENSOR(1), "d0");
+	ccv_nnc_graph_exec_symbol_new(symbolic_graph, CMD_EWLOG_FORWARD(), TENSOR_SYMBOL_LIST(d), TENSOR_SYMBOL_LIST(d0), "log");
+	const ccv_nnc_tensor_symbol_t d1 = ccv_nnc_tensor_symbol_new(symbolic_graph, ONE_CPU_TENSOR(1), "d1");
+	ccv_nnc_graph_exec_symbol_new(symbolic_graph, CMD_EWEXP_FORWARD(), TENSOR_SYMBOL_LIST(d), TENSOR_SYMBOL_LIST(d1), "exp");
+	const ccv_nnc_tensor_symbol_t d2 = ccv_nnc_tensor_symbol_new(symbolic_graph, ONE_CPU_TENSOR(1), "d2");
+	ccv_nnc_graph_exec_symbol_new(symbolic_graph, CMD_EWSUM_FORWARD(), TENSOR_SYMBOL_LIST(d0, d1), TENSOR_SYMBOL_LIST(d2), "sum1");
+	ccv_nnc_graph_exec_symbol_autogen(symbolic_graph, 0, 0, CCV_NNC_AUTOGEN_ALL_EXECS | CCV_NNC_AUTOGEN_SOURCES_AND_DESTINATIONS);
+	ccv_nnc_graph_t* graph;
+	ccv_nnc_tensor_arena_t* tensor_arena;
+	ccv_nnc_graph_exec_arena_t* graph_exec_arena;
+	ccv_nnc_symbolic_graph_compile(symbolic_graph,
+		0, 0,
+		TENSOR_SYMBOL_LIST(d2),
+		SYMBOLIC_GRAPH_SOURCES(symbolic_graph), SYMBOLIC_GRAPH_DESTINATIONS(symbolic_graph),
+		&graph, &tensor_arena, &graph_exec_arena);
+	ccv_nnc_graph_static_schedule(graph, CCV_STREAM_CONTEXT_CPU);
+	ccv_nnc_stream_context_t* const stream_context = ccv_nnc_graph_default_stream(graph);
+	ccv_nnc_tensor_t* const x_tensor = ccv_nnc_tensor_from_symbol(tensor_arena, x);
+	ccv_nnc_tensor_t* const y_tensor = ccv_nnc_tensor_from_symbol(tensor_arena, y);
+	ccv_nnc_tensor_t* const a_tensor = ccv_nnc_tensor_from_symbol(tensor_arena, a);
+	ccv_nnc_tensor_t* const b_tensor = ccv_nnc_tensor_from_symbol(tensor_arena, b);
+	ccv_nnc_tensor_t* const d2_tensor = ccv_nnc_tensor_from_symbol(tensor_arena, d2);
+	int i;
+	for (i = 0; i < 10; i++)
+	{
+		x_tensor->data.f32[0] = 2 + i;
+		y_tensor->data.f32[0] = 0.21;
+		a_tensor->data.f32[0] = 2.2;
+		b_tensor->data.f32[0] = 3.2;
+		ccv_nnc_graph_run(graph, 0, stream_context, 0, TRAVERSE_FULL);
+		ccv_nnc_stream_context_wait(stream_context);
+		const float dv = (2 + i) * 0.21 / (2.2 + 3.2);
+		REQUIRE_EQ_WITH_TOLERANCE(d2_tensor->data.f32[0], logf(dv) + expf(dv), 1e-5, "result should be equal");
+	}
+	ccv_nnc_symbolic_graph_free(symbolic_graph);
+	ccv_nnc_graph_free(graph);
+	ccv_nnc_tensor_arena_free(tensor_arena);
+	ccv_nnc_graph_exec_arena_free(graph_exec_arena);
+}
+
+static ccv_nnc_stream_signal_t* stream_signals[2];
+
+static int _produce_in_job(const ccv_nnc_cmd_t cmd, const ccv_nnc_hint_t hint, const int flags, ccv_nnc_tensor_t* const* const inputs, const int input_size, ccv_nnc_tensor_t* const* const outputs, const int output_size, ccv_nnc_stream_context_t* const stream_context)
+{
+	usleep(10000);
+	outputs[0]->data.f32[0] = 42;
+	// Emitted from within the job on the same stream.
+	ccv_nnc_stream_context_emit_signal(stream_context, stream_signals[0]);
+	return CCV_NNC_EXEC_SUCCESS;
+}
+
+static int _consume_in_job(const ccv_nnc_cmd_t cmd, const ccv_nnc_hint_t hint, const int flags, ccv_nnc_tensor_t* const* const inputs, const int input_size, ccv_nnc_tensor_t* const* const outputs, const int output_size, ccv_nnc_stream_context_t* const stream_context)
+{
+	// Waited from within the job on the same stream, the producer is still running on the other stream.
+	ccv_nnc_stream_context_wait_signal(stream_context, stream_signals[1]);
+	outputs[0]->data.f32[0] = inputs[0]->data.f32[0] + 1;
+	return CCV_NNC_EXEC_SUCCESS;
+}
+
+TEST_CASE("chain two CPU streams with signals from inside the jobs")
+{
+	ccv_nnc_stream_context_t* const stream_0 = ccv_nnc_stream_context_new(CCV_STREAM_CONTEXT_CPU);
+	ccv_nnc_stream_context_t* const stream_1 = ccv_nnc_stream_context_new(CCV_STREAM_CONTEXT_CPU);
+	stream_signals[0] = ccv_nnc_stream_signal_new(CCV_STREAM_CONTEXT_CPU);
+	stream_signals[1] = ccv_nnc_stream_signal_new(CCV_STREAM_CONTEXT_CPU);
+	ccv_nnc_tensor_t* const a = ccv_nnc_tensor_new(0, ONE_CPU_TENSOR(1), 0);
+	ccv_nnc_tensor_t* const b = ccv_nnc_tensor_new(0, ONE_CPU_TENSOR(1), 0);
+	ccv_nnc_tensor_t* const c = ccv_nnc_tensor_new(0, ONE_CPU_TENSOR(1), 0);
+	int i;
+	for (i = 0; i < 4; i++)
+	{
+		a->data.f32[0] = 0;
+		b->data.f32[0] = 0;
+		c->data.f32[0] = 0;
+		ccv_nnc_cmd_exec(CMD_CUSTOM_FORWARD(_produce_in_job), ccv_nnc_no_hint, 0, 0, 0, TENSOR_LIST(a), stream_0);
+		ccv_nnc_stream_context_emit_signal(stream_0, stream_signals[1]);
+		ccv_nnc_cmd_exec(CMD_CUSTOM_FORWARD(_consume_in_job), ccv_nnc_no_hint, 0, TENSOR_LIST(a), TENSOR_LIST(b), stream_1);
+		// The emit from within the producer has to be visible to the other streams as well.
+		ccv_nnc_stream_context_wait_signal(stream_1, stream_signals[0]);
+		ccv_nnc_cmd_exec(CMD_EWSUM_FORWARD(), ccv_nnc_no_hint, 0, TENSOR_LIST(a, b), TENSOR_LIST(c), stream_1);
+		ccv_nnc_stream_context_wait(stream_1);
+		REQUIRE_EQ_WITH_TOLERANCE(b->data.f32[0], 43, 1e-5, "the consumer should wait for the producer");
+		REQUIRE_EQ_WITH_TOLERANCE(c->data.f32[0], 85, 1e-5, "the sum should wait for both");
+		ccv_nnc_stream_context_wait(stream_0);
+	}
+	ccv_nnc_tensor_free(a);
+	ccv_nnc_tensor_free(b);
+	ccv_nnc_tensor_free(c);
+	ccv_nnc_stream_signal_free(stream_signals[0]);
+	ccv_nnc_stream_signal_free(stream_signals[1]);
+	ccv_nnc_stream_context_free(stream_0);
+	ccv_nnc_stream_context_free(stream_1);
+}
+
+static int _fail_in_job(const ccv_nnc_cmd_t cmd, const ccv_nnc_hint_t hint, const int flags, ccv_nnc_tensor_t* const* const inputs, const int input_size, ccv_nnc_tensor_t* const* const outputs, const int output_size, ccv_nnc_stream_context_t* const stream_context)
+{
+	return CCV_NNC_EXEC_INVALID;
+}
+
+TEST_CASE("return the failure of commands executed on a CPU stream from the wait")
+{
+	ccv_nnc_stream_context_t* const stream_context = ccv_nnc_stream_context_new(CCV_STREAM_CONTEXT_CPU);
+	ccv_nnc_tensor_t* const a = ccv_nnc_tensor_new(0, ONE_CPU_TENSOR(1), 0);
+	ccv_nnc_tensor_t* const b = ccv_nnc_tensor_new(0, ONE_CPU_TENSOR(1), 0);
+	a->data.f32[0] = 2;
+	REQUIRE_EQ(ccv_nnc_cmd_exec(CMD_CUSTOM_FORWARD(_fail_in_job), ccv_nnc_no_hint, 0, TENSOR_LIST(a), TENSOR_LIST(b), stream_context), CCV_NNC_EXEC_SUCCESS, "the command should be submitted");
+	ccv_nnc_cmd_exec(CMD_EWSUM_FORWARD(), ccv_nnc_no_hint, 0, TENSOR_LIST(a, a), TENSOR_LIST(b), stream_context);
+	REQUIRE_EQ(ccv_nnc_stream_context_wait(stream_context), CCV_NNC_EXEC_INVALID, "the wait should return the failure");
+	REQUIRE_EQ_WITH_TOLERANCE(b->data.f32[0], 4, 1e-5, "the commands after the failed one should still run");
+	REQUIRE_EQ(ccv_nnc_stream_context_wait(stream_context), CCV_NNC_EXEC_SUCCESS, "the failure should be returned once");
+	// The algorithm doesn't exist, it is refused before submitted.
+	ccv_nnc_cmd_t cmd = CMD_EWSUM_FORWARD();
+	cmd.backend = CCV_NNC_BACKEND_CPU_REF;
+	cmd.algorithm = 100;
+	REQUIRE_EQ(ccv_nnc_cmd_exec(cmd, ccv_nnc_no_hint, 0, TENSOR_LIST(a, a), TENSOR_LIST(b), stream_context), CCV_NNC_EXEC_INVALID, "the command should be refused before submitted");
+	// Stop the worker pool, the next command starts it again.
+	ccv_nnc_deinit();
+	ccv_nnc_cmd_exec(CMD_EWSUM_FORWARD(), ccv_nnc_no_hint, 0, TENSOR_LIST(a, b), TENSOR_LIST(b), stream_context);
+	REQUIRE_EQ(ccv_nnc_stream_context_wait(stream_context), CCV_NNC_EXEC_SUCCESS, "the command should run after the worker pool restarts");
+	REQUIRE_EQ_WITH_TOLERANCE(b->data.f32[0], 6, 1e-5, "the sum should be computed");
+	ccv_nnc_tensor_free(a);
+	ccv_nnc_tensor_free(b);
+	ccv_nnc_stream_context_free(stream_context);
+}
+
 TEST_CASE("schedule symbolic graph to data parallel")
 {
 	ccv_nnc_symbolic_graph_t* const symbolic_graph = ccv_nnc_symbolic_graph_new();
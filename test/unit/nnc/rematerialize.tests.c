@@ -0,0 +1,135 @@
+#include "case.h"
+#include "ccv_case.h"
+#include "ccv_nnc_case.h"
+#include <ccv.h>
+#include <nnc/ccv_nnc.h>
+#include <nnc/ccv_nnc_easy.h>
+#include "3rdparty/dsfmt/dSFMT.h"
+
+TEST_SETUP()
+{
+	ccv_nnc_init();
+}
+
+#define BATCH_SIZE (64)
+#define HIDDEN_SIZE (32)
+
+typedef struct {
+	ccv_nnc_symbolic_graph_t* symbolic_graph;
+	ccv_nnc_tensor_symbol_t x;
+	ccv_nnc_tensor_symbol_t y;
+	ccv_nnc_tensor_symbol_t w[8];
+	int layer_size;
+} mlp_t;
+
+// Fully connected layers with ReLU, if skip is set, the input to the layer after it is the sum of the last two activations.
+static mlp_t _mlp_new(const int layer_size, const int skip)
+{
+	mlp_t mlp = {
+		.layer_size = layer_size,
+	};
+	ccv_nnc_symbolic_graph_t* const symbolic_graph = mlp.symbolic_graph = ccv_nnc_symbolic_graph_new();
+	mlp.x = ccv_nnc_tensor_symbol_new(symbolic_graph, CPU_TENSOR_NHWC(BATCH_SIZE, HIDDEN_SIZE), "x");
+	ccv_nnc_tensor_symbol_t a = mlp.x, last_a = NO_TENSOR_SYMBOL;
+	int i;
+	for (i = 0; i < layer_size; i++)
+	{
+		mlp.w[i] = ccv_nnc_tensor_symbol_new(symbolic_graph, CPU_TENSOR_NHWC(HIDDEN_SIZE, HIDDEN_SIZE), "w");
+		ccv_nnc_tensor_symbol_t h = ccv_nnc_tensor_symbol_new(symbolic_graph, CPU_TENSOR_NHWC(BATCH_SIZE, HIDDEN_SIZE), "h");
+		ccv_nnc_graph_exec_symbol_new(symbolic_graph, CMD_GEMM_FORWARD(HIDDEN_SIZE), TENSOR_SYMBOL_LIST(a, mlp.w[i]), TENSOR_SYMBOL_LIST(h), "fc");
+		last_a = a;
+		a = ccv_nnc_tensor_symbol_new(symbolic_graph, CPU_TENSOR_NHWC(BATCH_SIZE, HIDDEN_SIZE), "a");
+		ccv_nnc_graph_exec_symbol_new(symbolic_graph, CMD_RELU_FORWARD(), TENSOR_SYMBOL_LIST(h), TENSOR_SYMBOL_LIST(a), "relu");
+		if (i + 1 == skip)
+		{
+			ccv_nnc_tensor_symbol_t s = ccv_nnc_tensor_symbol_new(symbolic_graph, CPU_TENSOR_NHWC(BATCH_SIZE, HIDDEN_SIZE), "s");
+			ccv_nnc_graph_exec_symbol_new(symbolic_graph, CMD_EWSUM_FORWARD(), TENSOR_SYMBOL_LIST(a, last_a), TENSOR_SYMBOL_LIST(s), "sum");
+			a = s;
+		}
+	}
+	mlp.w[layer_size] = ccv_nnc_tensor_symbol_new(symbolic_graph, CPU_TENSOR_NHWC(1, HIDDEN_SIZE), "w");
+	mlp.y = ccv_nnc_tensor_symbol_new(symbolic_graph, CPU_TENSOR_NHWC(BATCH_SIZE, 1), "y");
+	ccv_nnc_graph_exec_symbol_new(symbolic_graph, CMD_GEMM_FORWARD(1), TENSOR_SYMBOL_LIST(a, mlp.w[layer_size]), TENSOR_SYMBOL_LIST(mlp.y), "fc");
+	ccv_nnc_graph_exec_symbol_autogen(symbolic_graph, 0, 0, CCV_NNC_AUTOGEN_ALL_EXECS | CCV_NNC_AUTOGEN_SOURCES_AND_DESTINATIONS);
+	ccv_nnc_symbolic_graph_backward(symbolic_graph, TENSOR_SYMBOL_LIST(mlp.y), mlp.w, layer_size + 1, SYMBOLIC_GRAPH_SOURCES(symbolic_graph), SYMBOLIC_GRAPH_DESTINATIONS(symbolic_graph));
+	ccv_nnc_graph_exec_symbol_autogen(symbolic_graph, 0, 0, CCV_NNC_AUTOGEN_SOURCES_AND_DESTINATIONS);
+	return mlp;
+}
+
+// Run the forward and backward pass, copy out the gradients of the weights and return the size of the tensor arena.
+static uint64_t _mlp_run(const mlp_t mlp, float* const dw)
+{
+	ccv_nnc_graph_t* graph = 0;
+	ccv_nnc_tensor_arena_t* tensor_arena = 0;
+	ccv_nnc_graph_exec_arena_t* graph_exec_arena = 0;
+	ccv_nnc_tensor_symbol_t dw_symbols[8];
+	int i, j;
+	for (i = 0; i < mlp.layer_size; i++)
+		dw_symbols[i] = ccv_nnc_tensor_symbol_for_backward(mlp.symbolic_graph, mlp.w[i]);
+	ccv_nnc_symbolic_graph_compile(mlp.symbolic_graph, 0, 0, dw_symbols, mlp.layer_size, SYMBOLIC_GRAPH_SOURCES(mlp.symbolic_graph), SYMBOLIC_GRAPH_DESTINATIONS(mlp.symbolic_graph), &graph, &tensor_arena, &graph_exec_arena);
+	dsfmt_t dsfmt;
+	dsfmt_init_gen_rand(&dsfmt, 0);
+	ccv_nnc_tensor_t* const x_tensor = ccv_nnc_tensor_from_symbol(tensor_arena, mlp.x);
+	for (i = 0; i < BATCH_SIZE * HIDDEN_SIZE; i++)
+		x_tensor->data.f32[i] = dsfmt_genrand_open_close(&dsfmt) * 2 - 1;
+	for (i = 0; i <= mlp.layer_size; i++)
+	{
+		ccv_nnc_tensor_t* const w_tensor = ccv_nnc_tensor_from_symbol(tensor_arena, mlp.w[i]);
+		const int size = ccv_nnc_tensor_count(w_tensor->info);
+		for (j = 0; j < size; j++)
+			w_tensor->data.f32[j] = (dsfmt_genrand_open_close(&dsfmt) * 2 - 1) / sqrtf(HIDDEN_SIZE);
+	}
+	ccv_nnc_tensor_t* const dy_tensor = ccv_nnc_tensor_from_symbol(tensor_arena, ccv_nnc_tensor_symbol_for_backward(mlp.symbolic_graph, mlp.y));
+	for (i = 0; i < BATCH_SIZE; i++)
+		dy_tensor->data.f32[i] = 1;
+	ccv_nnc_graph_run(graph, 0, 0, 0, TRAVERSE_FULL);
+	for (i = 0; i < mlp.layer_size; i++)
+	{
+		ccv_nnc_tensor_t* const dw_tensor = ccv_nnc_tensor_from_symbol(tensor_arena, dw_symbols[i]);
+		memcpy(dw + i * HIDDEN_SIZE * HIDDEN_SIZE, dw_tensor->data.f32, sizeof(float) * HIDDEN_SIZE * HIDDEN_SIZE);
+	}
+	const uint64_t arena_size = ccv_nnc_tensor_arena_size(tensor_arena);
+	ccv_nnc_graph_free(graph);
+	ccv_nnc_tensor_arena_free(tensor_arena);
+	ccv_nnc_graph_exec_arena_free(graph_exec_arena);
+	return arena_size;
+}
+
+TEST_CASE("rematerialize the element-wise sum before the fully connected layers")
+{
+	const size_t activation_size = sizeof(float) * BATCH_SIZE * HIDDEN_SIZE;
+	mlp_t mlp = _mlp_new(3, 2);
+	float dw[3 * HIDDEN_SIZE * HIDDEN_SIZE];
+	_mlp_run(mlp, dw);
+	ccv_nnc_symbolic_graph_free(mlp.symbolic_graph);
+	mlp = _mlp_new(3, 2);
+	const int exec_count = ccv_nnc_graph_exec_symbol_count(mlp.symbolic_graph);
+	// The ReLU outputs and the sum are retained, asking to drop one of them.
+	const uint64_t retained_size = ccv_nnc_symbolic_graph_rematerialize(mlp.symbolic_graph, activation_size * 3, SYMBOLIC_GRAPH_SOURCES(mlp.symbolic_graph), SYMBOLIC_GRAPH_DESTINATIONS(mlp.symbolic_graph));
+	REQUIRE_EQ(retained_size, activation_size * 3, "one activation should be dropped");
+	REQUIRE_EQ(ccv_nnc_graph_exec_symbol_count(mlp.symbolic_graph), exec_count + 1, "only the sum should be recomputed");
+	float rdw[3 * HIDDEN_SIZE * HIDDEN_SIZE];
+	_mlp_run(mlp, rdw);
+	REQUIRE_ARRAY_EQ_WITH_TOLERANCE(float, dw, rdw, 3 * HIDDEN_SIZE * HIDDEN_SIZE, 1e-5, "gradients should be the same with rematerialization");
+	ccv_nnc_symbolic_graph_free(mlp.symbolic_graph);
+}
+
+TEST_CASE("rematerialize segments of fully connected layers to reduce memory footprint")
+{
+	mlp_t mlp = _mlp_new(7, 0);
+	float dw[7 * HIDDEN_SIZE * HIDDEN_SIZE];
+	const uint64_t arena_size = _mlp_run(mlp, dw);
+	ccv_nnc_symbolic_graph_free(mlp.symbolic_graph);
+	mlp = _mlp_new(7, 0);
+	const int exec_count = ccv_nnc_graph_exec_symbol_count(mlp.symbolic_graph);
+	const uint64_t retained_size = ccv_nnc_symbolic_graph_rematerialize(mlp.symbolic_graph, 0, SYMBOLIC_GRAPH_SOURCES(mlp.symbolic_graph), SYMBOLIC_GRAPH_DESTINATIONS(mlp.symbolic_graph));
+	REQUIRE(retained_size < sizeof(float) * BATCH_SIZE * HIDDEN_SIZE * 7, "some activations should be dropped");
+	REQUIRE(ccv_nnc_graph_exec_symbol_count(mlp.symbolic_graph) > exec_count, "should recompute the dropped activations");
+	float rdw[7 * HIDDEN_SIZE * HIDDEN_SIZE];
+	const uint64_t rematerialized_arena_size = _mlp_run(mlp, rdw);
+	REQUIRE(rematerialized_arena_size < arena_size, "should use less memory with rematerialization");
+	REQUIRE_ARRAY_EQ_WITH_TOLERANCE(float, dw, rdw, 7 * HIDDEN_SIZE * HIDDEN_SIZE, 1e-5, "gradients should be the same with rematerialization");
+	ccv_nnc_symbolic_graph_free(mlp.symbolic_graph);
+}
+
+#include "case_main.h"
@@ -4,6 +4,7 @@
 #include <ccv.h>
 #include <nnc/ccv_nnc.h>
 #include <nnc/ccv_nnc_easy.h>
+#include "3rdparty/dsfmt/dSFMT.h"
 
 TEST_SETUP()
 {
@@ -368,4 +369,269 @@ TEST_CASE("simplify graph with while, variant 3")
 	ccv_nnc_graph_exec_arena_free(graph_exec_arena);
 }
 
+// Compile the graph, fill the inputs with random values, run it and copy out the result.
+static void _epilogue_fusion_run(ccv_nnc_symbolic_graph_t* const symbolic_graph, const ccv_nnc_tensor_symbol_t* const inputs, const int input_size, const ccv_nnc_tensor_symbol_t y, float* const out)
+{
+	ccv_nnc_graph_t* graph = 0;
+	ccv_nnc_tensor_arena_t* tensor_arena = 0;
+	ccv_nnc_graph_exec_arena_t* graph_exec_arena = 0;
+	ccv_nnc_symbolic_graph_compile(symbolic_graph, 0, 0, &y, 1, SYMBOLIC_GRAPH_SOURCES(symbolic_graph), SYMBOLIC_GRAPH_DESTINATIONS(symbolic_graph), &graph, &tensor_arena, &graph_exec_arena);
+	dsfmt_t dsfmt;
+	dsfmt_init_gen_rand(&dsfmt, 0);
+	int i, j;
+	for (i = 0; i < input_size; i++)
+	{
+		ccv_nnc_tensor_t* const tensor = ccv_nnc_tensor_from_symbol(tensor_arena, inputs[i]);
+		const int count = ccv_nnc_tensor_count(tensor->info);
+		for (j = 0; j < count; j++)
+			tensor->data.f32[j] = dsfmt_genrand_open_close(&dsfmt);
+	}
+	ccv_nnc_graph_run(graph, 0, 0, 0, TRAVERSE_FULL);
+	ccv_nnc_tensor_t* const y_tensor = ccv_nnc_tensor_from_symbol(tensor_arena, y);
+	memcpy(out, y_tensor->data.f32, sizeof(float) * ccv_nnc_tensor_count(y_tensor->info));
+	ccv_nnc_graph_free(graph);
+	ccv_nnc_tensor_arena_free(tensor_arena);
+	ccv_nnc_graph_exec_arena_free(graph_exec_arena);
+}
+
+static ccv_nnc_symbolic_graph_t* _conv_bn_add_relu_new(ccv_nnc_tensor_symbol_t* const inputs, ccv_nnc_tensor_symbol_t* const y)
+{
+	ccv_nnc_symbolic_graph_t* const symbolic_graph = ccv_nnc_symbolic_graph_new();
+	const ccv_nnc_tensor_symbol_t x = inputs[0] = ccv_nnc_tensor_symbol_new(symbolic_graph, CPU_TENSOR_NHWC(1, 8, 8, 4), "x");
+	const ccv_nnc_tensor_symbol_t w = inputs[1] = ccv_nnc_tensor_symbol_new(symbolic_graph, CPU_TENSOR_NHWC(16, 3, 3, 4), "w");
+	const ccv_nnc_tensor_symbol_t bias = inputs[2] = ccv_nnc_tensor_symbol_new(symbolic_graph, CPU_TENSOR_NHWC(16), "bias");
+	const ccv_nnc_tensor_symbol_t scale = inputs[3] = ccv_nnc_tensor_symbol_new(symbolic_graph, CPU_TENSOR_NHWC(16), "scale");
+	const ccv_nnc_tensor_symbol_t shift = inputs[4] = ccv_nnc_tensor_symbol_new(symbolic_graph, CPU_TENSOR_NHWC(16), "shift");
+	const ccv_nnc_tensor_symbol_t mean = inputs[5] = ccv_nnc_tensor_symbol_new(symbolic_graph, CPU_TENSOR_NHWC(16), "mean");
+	const ccv_nnc_tensor_symbol_t var = inputs[6] = ccv_nnc_tensor_symbol_new(symbolic_graph, CPU_TENSOR_NHWC(16), "var");
+	const ccv_nnc_tensor_symbol_t r = inputs[7] = ccv_nnc_tensor_symbol_new(symbolic_graph, CPU_TENSOR_NHWC(1, 8, 8, 16), "r");
+	const ccv_nnc_tensor_symbol_t c = ccv_nnc_tensor_symbol_new(symbolic_graph, CPU_TENSOR_NHWC(1, 8, 8, 16), "c");
+	ccv_nnc_graph_exec_symbol_new(symbolic_graph, CMD_CONVOLUTION_FORWARD(1, 16, 3, 3, 4), TENSOR_SYMBOL_LIST(x, w, bias), TENSOR_SYMBOL_LIST(c), "conv");
+	const ccv_nnc_tensor_symbol_t n = ccv_nnc_tensor_symbol_new(symbolic_graph, CPU_TENSOR_NHWC(1, 8, 8, 16), "n");
+	ccv_nnc_graph_exec_symbol_new(symbolic_graph, CMD_BATCH_NORM_FORWARD(1e-4, 1, 0.9, 0, 1, 2), TENSOR_SYMBOL_LIST(c, scale, shift, mean, var), TENSOR_SYMBOL_LIST(n), "batch norm");
+	const ccv_nnc_tensor_symbol_t s = ccv_nnc_tensor_symbol_new(symbolic_graph, CPU_TENSOR_NHWC(1, 8, 8, 16), "s");
+	ccv_nnc_graph_exec_symbol_new(symbolic_graph, CMD_EWSUM_FORWARD(), TENSOR_SYMBOL_LIST(r, n), TENSOR_SYMBOL_LIST(s), "sum");
+	*y = ccv_nnc_tensor_symbol_new(symbolic_graph, CPU_TENSOR_NHWC(1, 8, 8, 16), "y");
+	ccv_nnc_graph_exec_symbol_new(symbolic_graph, CMD_RELU_FORWARD(), TENSOR_SYMBOL_LIST(s), TENSOR_SYMBOL_LIST(*y), "relu");
+	ccv_nnc_graph_exec_symbol_autogen(symbolic_graph, 0, 0, CCV_NNC_AUTOGEN_ALL_EXECS | CCV_NNC_AUTOGEN_SOURCES_AND_DESTINATIONS);
+	return symbolic_graph;
+}
+
+TEST_CASE("simplify graph with convolution + batch norm + sum + relu epilogue fusion")
+{
+	ccv_nnc_tensor_symbol_t inputs[8];
+	ccv_nnc_tensor_symbol_t y;
+	ccv_nnc_symbolic_graph_t* symbolic_graph = _conv_bn_add_relu_new(inputs, &y);
+	float y0[8 * 8 * 16];
+	_epilogue_fusion_run(symbolic_graph, inputs, 8, y, y0);
+	ccv_nnc_symbolic_graph_free(symbolic_graph);
+	symbolic_graph = _conv_bn_add_relu_new(inputs, &y);
+	ccv_nnc_symbolic_graph_simplify(symbolic_graph,
+		SYMBOLIC_GRAPH_PASSES(CCV_NNC_SIMPLIFY_EPILOGUE_FUSION),
+		TENSOR_SYMBOL_LIST(y), SYMBOLIC_GRAPH_SOURCES(symbolic_graph), SYMBOLIC_GRAPH_DESTINATIONS(symbolic_graph));
+	REQUIRE_EQ(ccv_nnc_graph_exec_symbol_count(symbolic_graph), 1, "batch norm, sum and relu should be fused into convolution");
+	float y1[8 * 8 * 16];
+	_epilogue_fusion_run(symbolic_graph, inputs, 8, y, y1);
+	REQUIRE_ARRAY_EQ_WITH_TOLERANCE(float, y0, y1, 8 * 8 * 16, 1e-4, "fused convolution should match the separate ops");
+	ccv_nnc_symbolic_graph_free(symbolic_graph);
+}
+
+static ccv_nnc_symbolic_graph_t* _gemm_relu_ew_new(ccv_nnc_tensor_symbol_t* const inputs, ccv_nnc_tensor_symbol_t* const y, ccv_nnc_graph_exec_symbol_t* const execs)
+{
+	ccv_nnc_symbolic_graph_t* const symbolic_graph = ccv_nnc_symbolic_graph_new();
+	const ccv_nnc_tensor_symbol_t x = inputs[0] = ccv_nnc_tensor_symbol_new(symbolic_graph, CPU_TENSOR_NHWC(64, 32), "x");
+	const ccv_nnc_tensor_symbol_t w = inputs[1] = ccv_nnc_tensor_symbol_new(symbolic_graph, CPU_TENSOR_NHWC(24, 32), "w");
+	const ccv_nnc_tensor_symbol_t z = inputs[2] = ccv_nnc_tensor_symbol_new(symbolic_graph, CPU_TENSOR_NHWC(64, 24), "z");
+	const ccv_nnc_tensor_symbol_t h = ccv_nnc_tensor_symbol_new(symbolic_graph, CPU_TENSOR_NHWC(64, 24), "h");
+	execs[0] = ccv_nnc_graph_exec_symbol_new(symbolic_graph, CMD_GEMM_FORWARD(24), TENSOR_SYMBOL_LIST(x, w), TENSOR_SYMBOL_LIST(h), "fc");
+	const ccv_nnc_tensor_symbol_t a = ccv_nnc_tensor_symbol_new(symbolic_graph, CPU_TENSOR_NHWC(64, 24), "a");
+	ccv_nnc_graph_exec_symbol_new(symbolic_graph, CMD_RELU_FORWARD(), TENSOR_SYMBOL_LIST(h), TENSOR_SYMBOL_LIST(a), "relu");
+	// The element-wise chain starts a new head, because its input is read twice.
+	const ccv_nnc_tensor_symbol_t p = ccv_nnc_tensor_symbol_new(symbolic_graph, CPU_TENSOR_NHWC(64, 24), "p");
+	execs[1] = ccv_nnc_graph_exec_symbol_new(symbolic_graph, CMD_EWPROD_FORWARD(), TENSOR_SYMBOL_LIST(a, z), TENSOR_SYMBOL_LIST(p), "prod");
+	const ccv_nnc_tensor_symbol_t m = ccv_nnc_tensor_symbol_new(symbolic_graph, CPU_TENSOR_NHWC(64, 24), "m");
+	ccv_nnc_graph_exec_symbol_new(symbolic_graph, CMD_SCALAR_MUL_FORWARD(-0.5), TENSOR_SYMBOL_LIST(p), TENSOR_SYMBOL_LIST(m), "mul");
+	const ccv_nnc_tensor_symbol_t e = ccv_nnc_tensor_symbol_new(symbolic_graph, CPU_TENSOR_NHWC(64, 24), "e");
+	ccv_nnc_graph_exec_symbol_new(symbolic_graph, CMD_EWEXP_FORWARD(), TENSOR_SYMBOL_LIST(m), TENSOR_SYMBOL_LIST(e), "exp");
+	*y = ccv_nnc_tensor_symbol_new(symbolic_graph, CPU_TENSOR_NHWC(64, 24), "y");
+	ccv_nnc_graph_exec_symbol_new(symbolic_graph, CMD_EWSUM_FORWARD(), TENSOR_SYMBOL_LIST(e, a), TENSOR_SYMBOL_LIST(*y), "sum");
+	ccv_nnc_graph_exec_symbol_autogen(symbolic_graph, 0, 0, CCV_NNC_AUTOGEN_ALL_EXECS | CCV_NNC_AUTOGEN_SOURCES_AND_DESTINATIONS);
+	return symbolic_graph;
+}
+
+TEST_CASE("simplify graph with fully connected + relu and element-wise epilogue fusion")
+{
+	ccv_nnc_tensor_symbol_t inputs[3];
+	ccv_nnc_tensor_symbol_t y;
+	ccv_nnc_graph_exec_symbol_t execs[2];
+	ccv_nnc_symbolic_graph_t* symbolic_graph = _gemm_relu_ew_new(inputs, &y, execs);
+	float y0[64 * 24];
+	_epilogue_fusion_run(symbolic_graph, inputs, 3, y, y0);
+	ccv_nnc_symbolic_graph_free(symbolic_graph);
+	symbolic_graph = _gemm_relu_ew_new(inputs, &y, execs);
+	ccv_nnc_symbolic_graph_simplify(symbolic_graph,
+		SYMBOLIC_GRAPH_PASSES(CCV_NNC_SIMPLIFY_EPILOGUE_FUSION),
+		TENSOR_SYMBOL_LIST(y), SYMBOLIC_GRAPH_SOURCES(symbolic_graph), SYMBOLIC_GRAPH_DESTINATIONS(symbolic_graph));
+	REQUIRE_EQ(ccv_nnc_graph_exec_symbol_cmd(symbolic_graph, execs[0]).info.epilogue.size, 1, "relu should be fused into fully connected");
+	REQUIRE_EQ(ccv_nnc_graph_exec_symbol_cmd(symbolic_graph, execs[1]).info.epilogue.size, 3, "scalar mul, exp and sum should be fused into the product");
+	float y1[64 * 24];
+	_epilogue_fusion_run(symbolic_graph, inputs, 3, y, y1);
+	REQUIRE_ARRAY_EQ_WITH_TOLERANCE(float, y0, y1, 64 * 24, 1e-5, "fused ops should match the separate ops");
+	ccv_nnc_symbolic_graph_free(symbolic_graph);
+}
+
+TEST_CASE("convolution with fused ops on a backend without native epilogue support")
+{
+	ccv_nnc_tensor_t* const a = ccv_nnc_tensor_new(0, CPU_TENSOR_NHWC(1, 8, 8, 4), 0);
+	ccv_nnc_tensor_t* const w = ccv_nnc_tensor_new(0, CPU_TENSOR_NHWC(8, 3, 3, 4), 0);
+	ccv_nnc_tensor_t* const bias = ccv_nnc_tensor_new(0, CPU_TENSOR_NHWC(8), 0);
+	ccv_nnc_tensor_t* const r = ccv_nnc_tensor_new(0, CPU_TENSOR_NHWC(1, 8, 8, 8), 0);
+	ccv_nnc_tensor_t* const b0 = ccv_nnc_tensor_new(0, CPU_TENSOR_NHWC(1, 8, 8, 8), 0);
+	ccv_nnc_tensor_t* const b1 = ccv_nnc_tensor_new(0, CPU_TENSOR_NHWC(1, 8, 8, 8), 0);
+	dsfmt_t dsfmt;
+	dsfmt_init_gen_rand(&dsfmt, 0);
+	int i;
+	for (i = 0; i < 8 * 8 * 4; i++)
+		a->data.f32[i] = dsfmt_genrand_open_close(&dsfmt) * 2 - 1;
+	for (i = 0; i < 8 * 3 * 3 * 4; i++)
+		w->data.f32[i] = dsfmt_genrand_open_close(&dsfmt) * 2 - 1;
+	for (i = 0; i < 8; i++)
+		bias->data.f32[i] = dsfmt_genrand_open_close(&dsfmt) * 2 - 1;
+	for (i = 0; i < 8 * 8 * 8; i++)
+		r->data.f32[i] = dsfmt_genrand_open_close(&dsfmt) * 2 - 1;
+	ccv_nnc_cmd_t cmd = CMD_CONVOLUTION_FORWARD(1, 8, 3, 3, 4);
+	const ccv_nnc_hint_t hint = ccv_nnc_hint_auto(cmd.info, a->info, b0->info);
+	ccv_nnc_cmd_exec(cmd, hint, 0, TENSOR_LIST(a, w, bias), TENSOR_LIST(b0), 0);
+	ccv_nnc_cmd_exec(CMD_EWSUM_FORWARD(), ccv_nnc_no_hint, 0, TENSOR_LIST(b0, r), TENSOR_LIST(b0), 0);
+	ccv_nnc_cmd_exec(CMD_RELU_FORWARD(), ccv_nnc_no_hint, 0, TENSOR_LIST(b0), TENSOR_LIST(b0), 0);
+	cmd.backend = CCV_NNC_BACKEND_CPU_REF;
+	cmd.info.epilogue.size = 2;
+	cmd.info.epilogue.ops[0].type = CCV_NNC_EPILOGUE_EWSUM;
+	cmd.info.epilogue.ops[1].type = CCV_NNC_EPILOGUE_RELU;
+	ccv_nnc_cmd_exec(cmd, hint, 0, TENSOR_LIST(a, w, bias, r), TENSOR_LIST(b1), 0);
+	REQUIRE_TENSOR_EQ(b1, b0, "convolution with fused sum and relu should match the separate ops");
+	ccv_nnc_tensor_free(a);
+	ccv_nnc_tensor_free(w);
+	ccv_nnc_tensor_free(bias);
+	ccv_nnc_tensor_free(r);
+	ccv_nnc_tensor_free(b0);
+	ccv_nnc_tensor_free(b1);
+}
+
+static ccv_nnc_symbolic_graph_t* _constant_weights_conv_new(ccv_nnc_tensor_symbol_t* const x, ccv_nnc_tensor_symbol_t* const w, ccv_nnc_tensor_symbol_t* const y, ccv_nnc_graph_exec_symbol_t* const conv)
+{
+	float w0[16 * 3 * 3 * 4];
+	float s[16 * 3 * 3 * 4];
+	float bias[16];
+	dsfmt_t dsfmt;
+	dsfmt_init_gen_rand(&dsfmt, 1);
+	int i;
+	for (i = 0; i < 16 * 3 * 3 * 4; i++)
+		w0[i] = dsfmt_genrand_open_close(&dsfmt) * 2 - 1, s[i] = dsfmt_genrand_open_close(&dsfmt);
+	for (i = 0; i < 16; i++)
+		bias[i] = dsfmt_genrand_open_close(&dsfmt) * 2 - 1;
+	ccv_nnc_symbolic_graph_t* const symbolic_graph = ccv_nnc_symbolic_graph_new();
+	*x = ccv_nnc_tensor_symbol_new(symbolic_graph, CPU_TENSOR_NHWC(1, 8, 8, 4), "x");
+	const ccv_nnc_tensor_symbol_t w0_symbol = ccv_nnc_tensor_symbol_constant_new(symbolic_graph, CPU_TENSOR_NHWC(16, 3, 3, 4), w0, "w0");
+	const ccv_nnc_tensor_symbol_t s_symbol = ccv_nnc_tensor_symbol_constant_new(symbolic_graph, CPU_TENSOR_NHWC(16, 3, 3, 4), s, "s");
+	const ccv_nnc_tensor_symbol_t bias_symbol = ccv_nnc_tensor_symbol_constant_new(symbolic_graph, CPU_TENSOR_NHWC(16), bias, "bias");
+	*w = ccv_nnc_tensor_symbol_new(symbolic_graph, CPU_TENSOR_NHWC(16, 3, 3, 4), "w");
+	*y = ccv_nnc_tensor_symbol_new(symbolic_graph, CPU_TENSOR_NHWC(1, 8, 8, 16), "y");
+	*conv = ccv_nnc_graph_exec_symbol_new(symbolic_graph, CMD_CONVOLUTION_FORWARD(1, 16, 3, 3, 4), TENSOR_SYMBOL_LIST(*x, *w, bias_symbol), TENSOR_SYMBOL_LIST(*y), "conv");
+	const ccv_nnc_tensor_symbol_t p = ccv_nnc_tensor_symbol_new(symbolic_graph, CPU_TENSOR_NHWC(16, 3, 3, 4), "p");
+	ccv_nnc_graph_exec_symbol_new(symbolic_graph, CMD_EWPROD_FORWARD(), TENSOR_SYMBOL_LIST(w0_symbol, s_symbol), TENSOR_SYMBOL_LIST(p), "prod");
+	ccv_nnc_graph_exec_symbol_new(symbolic_graph, CMD_SCALAR_MUL_FORWARD(0.5), TENSOR_SYMBOL_LIST(p), TENSOR_SYMBOL_LIST(*w), "mul");
+	ccv_nnc_graph_exec_symbol_autogen(symbolic_graph, 0, 0, CCV_NNC_AUTOGEN_ALL_EXECS | CCV_NNC_AUTOGEN_SOURCES_AND_DESTINATIONS);
+	return symbolic_graph;
+}
+
+// Compile the graph, run the convolution with the 4x4 Winograd kernel twice and copy out the result. The sizes of
+// the data the tensor arena derived from the constants after each run are kept in derived_size.
+static void _constant_folding_run(ccv_nnc_symbolic_graph_t* const symbolic_graph, const ccv_nnc_graph_exec_symbol_t conv, const ccv_nnc_tensor_symbol_t x, const ccv_nnc_tensor_symbol_t y, float* const out, uint64_t* const derived_size)
+{
+	ccv_nnc_graph_t* graph = 0;
+	ccv_nnc_tensor_arena_t* tensor_arena = 0;
+	ccv_nnc_graph_exec_arena_t* graph_exec_arena = 0;
+	ccv_nnc_symbolic_graph_compile(symbolic_graph, 0, 0, &y, 1, SYMBOLIC_GRAPH_SOURCES(symbolic_graph), SYMBOLIC_GRAPH_DESTINATIONS(symbolic_graph), &graph, &tensor_arena, &graph_exec_arena);
+	ccv_nnc_cmd_t cmd = ccv_nnc_graph_exec_symbol_cmd(symbolic_graph, conv);
+	cmd.backend = CCV_NNC_BACKEND_CPU_OPT;
+	cmd.algorithm = 2; // CCV_NNC_CMD_OPT_CONV_ALGO_WINOGRAD
+	ccv_nnc_graph_exec_set(graph, ccv_nnc_graph_exec_from_symbol(graph_exec_arena, conv), cmd);
+	dsfmt_t dsfmt;
+	dsfmt_init_gen_rand(&dsfmt, 0);
+	ccv_nnc_tensor_t* const x_tensor = ccv_nnc_tensor_from_symbol(tensor_arena, x);
+	int i;
+	for (i = 0; i < 8 * 8 * 4; i++)
+		x_tensor->data.f32[i] = dsfmt_genrand_open_close(&dsfmt) * 2 - 1;
+	for (i = 0; i < 2; i++)
+	{
+		ccv_nnc_graph_run(graph, 0, 0, 0, TRAVERSE_FULL);
+		derived_size[i] = ccv_nnc_tensor_arena_derived_size(tensor_arena);
+	}
+	ccv_nnc_tensor_t* const y_tensor = ccv_nnc_tensor_from_symbol(tensor_arena, y);
+	memcpy(out, y_tensor->data.f32, sizeof(float) * 8 * 8 * 16);
+	ccv_nnc_graph_free(graph);
+	ccv_nnc_tensor_arena_free(tensor_arena);
+	ccv_nnc_graph_exec_arena_free(graph_exec_arena);
+}
+
+TEST_CASE("simplify graph with constant folding and keep the transformed weights in the tensor arena")
+{
+	ccv_nnc_tensor_symbol_t x, w, y;
+	ccv_nnc_graph_exec_symbol_t conv;
+	ccv_nnc_symbolic_graph_t* symbolic_graph = _constant_weights_conv_new(&x, &w, &y, &conv);
+	float y0[8 * 8 * 16];
+	uint64_t derived_size[2];
+	_constant_folding_run(symbolic_graph, conv, x, y, y0, derived_size);
+	REQUIRE_EQ(derived_size[1], 0, "nothing should be derived from weights that are not constant");
+	ccv_nnc_symbolic_graph_free(symbolic_graph);
+	symbolic_graph = _constant_weights_conv_new(&x, &w, &y, &conv);
+	ccv_nnc_symbolic_graph_simplify(symbolic_graph,
+		SYMBOLIC_GRAPH_PASSES(CCV_NNC_SIMPLIFY_CONSTANT_FOLDING),
+		TENSOR_SYMBOL_LIST(y), SYMBOLIC_GRAPH_SOURCES(symbolic_graph), SYMBOLIC_GRAPH_DESTINATIONS(symbolic_graph));
+	REQUIRE_EQ(ccv_nnc_graph_exec_symbol_count(symbolic_graph), 1, "the product and the scalar multiplication should be folded");
+	REQUIRE(ccv_nnc_tensor_symbol_constant(symbolic_graph, w) != 0, "the weights should be a constant after folding");
+	float y1[8 * 8 * 16];
+	_constant_folding_run(symbolic_graph, conv, x, y, y1, derived_size);
+	REQUIRE_ARRAY_EQ_WITH_TOLERANCE(float, y0, y1, 8 * 8 * 16, 1e-5, "convolution with folded weights should match the separate ops");
+	REQUIRE(derived_size[0] >= sizeof(float) * 36 * 16 * 4, "the transformed weights should be kept by the arena");
+	REQUIRE_EQ(derived_size[1], derived_size[0], "the transformed weights should be reused");
+	ccv_nnc_symbolic_graph_free(symbolic_graph);
+}
+
+TEST_CASE("simplify graph with constant folding and not fold a tensor written again")
+{
+	ccv_nnc_symbolic_graph_t* const symbolic_graph = ccv_nnc_symbolic_graph_new();
+	const float c0[] = {3, 4};
+	const ccv_nnc_tensor_symbol_t c = ccv_nnc_tensor_symbol_constant_new(symbolic_graph, CPU_TENSOR_NHWC(2), c0, "c");
+	const ccv_nnc_tensor_symbol_t x = ccv_nnc_tensor_symbol_new(symbolic_graph, CPU_TENSOR_NHWC(2), "x");
+	const ccv_nnc_tensor_symbol_t y = ccv_nnc_tensor_symbol_new(symbolic_graph, CPU_TENSOR_NHWC(2), "y");
+	ccv_nnc_graph_exec_symbol_new(symbolic_graph, CMD_SCALAR_MUL_FORWARD(0.5), TENSOR_SYMBOL_LIST(c), TENSOR_SYMBOL_LIST(y), "mul");
+	ccv_nnc_graph_exec_symbol_new(symbolic_graph, CMD_EWSUM_FORWARD(), TENSOR_SYMBOL_LIST(y, x), TENSOR_SYMBOL_LIST(y), "sum");
+	ccv_nnc_graph_exec_symbol_autogen(symbolic_graph, 0, 0, CCV_NNC_AUTOGEN_ALL_EXECS | CCV_NNC_AUTOGEN_SOURCES_AND_DESTINATIONS);
+	ccv_nnc_symbolic_graph_simplify(symbolic_graph,
+		SYMBOLIC_GRAPH_PASSES(CCV_NNC_SIMPLIFY_CONSTANT_FOLDING),
+		TENSOR_SYMBOL_LIST(y), SYMBOLIC_GRAPH_SOURCES(symbolic_graph), SYMBOLIC_GRAPH_DESTINATIONS(symbolic_graph));
+	REQUIRE_EQ(ccv_nnc_graph_exec_symbol_count(symbolic_graph), 2, "the scalar multiplication should not be folded");
+	REQUIRE(ccv_nnc_tensor_symbol_constant(symbolic_graph, y) == 0, "the tensor written in-place later should not be a constant");
+	ccv_nnc_graph_t* graph = 0;
+	ccv_nnc_tensor_arena_t* tensor_arena = 0;
+	ccv_nnc_graph_exec_arena_t* graph_exec_arena = 0;
+	ccv_nnc_symbolic_graph_compile(symbolic_graph, 0, 0, &y, 1, SYMBOLIC_GRAPH_SOURCES(symbolic_graph), SYMBOLIC_GRAPH_DESTINATIONS(symbolic_graph), &graph, &tensor_arena, &graph_exec_arena);
+	ccv_nnc_tensor_t* const x_tensor = ccv_nnc_tensor_from_symbol(tensor_arena, x);
+	x_tensor->data.f32[0] = 1;
+	x_tensor->data.f32[1] = 2;
+	const float y0[] = {2.5, 4};
+	int i;
+	for (i = 0; i < 2; i++)
+	{
+		ccv_nnc_graph_run(graph, 0, 0, 0, TRAVERSE_FULL);
+		REQUIRE_ARRAY_EQ_WITH_TOLERANCE(float, ccv_nnc_tensor_from_symbol(tensor_arena, y)->data.f32, y0, 2, 1e-5, "the result should be the same on every run");
+	}
+	ccv_nnc_symbolic_graph_free(symbolic_graph);
+	ccv_nnc_graph_free(graph);
+	ccv_nnc_tensor_arena_free(tensor_arena);
+	ccv_nnc_graph_exec_arena_free(graph_exec_arena);
+}
+
 #include "case_main.h"
@@ -212,4 +212,65 @@ TEST_CASE("compile symbolic graph with case..of")
 	ccv_nnc_graph_exec_arena_free(graph_exec_arena);
 }
 
+TEST_CASE("compiled graph keeps the packed weights of a constant in the tensor arena")
+{
+	float w[13 * 301];
+	dsfmt_t dsfmt;
+	dsfmt_init_gen_rand(&dsfmt, 0);
+	int i;
+	for (i = 0; i < 13 * 301; i++)
+		w[i] = dsfmt_genrand_open_close(&dsfmt) / 301;
+	ccv_nnc_symbolic_graph_t* const symbolic_graph = ccv_nnc_symbolic_graph_new();
+	const ccv_nnc_tensor_symbol_t a = ccv_nnc_tensor_symbol_new(symbolic_graph, CPU_TENSOR_NHWC(37, 301), "a");
+	const ccv_nnc_tensor_symbol_t w_symbol = ccv_nnc_tensor_symbol_constant_new(symbolic_graph, CPU_TENSOR_NHWC(13, 301), w, "w");
+	const ccv_nnc_tensor_symbol_t b = ccv_nnc_tensor_symbol_new(symbolic_graph, CPU_TENSOR_NHWC(37, 13), "b");
+	const ccv_nnc_graph_exec_symbol_t gemm = ccv_nnc_graph_exec_symbol_new(symbolic_graph, CMD_GEMM_FORWARD(13), TENSOR_SYMBOL_LIST(a, w_symbol), TENSOR_SYMBOL_LIST(b), "gemm");
+	ccv_nnc_graph_exec_symbol_autogen(symbolic_graph, 0, 0, CCV_NNC_AUTOGEN_SOURCES_AND_DESTINATIONS);
+	ccv_nnc_graph_t* graph = 0;
+	ccv_nnc_tensor_arena_t* tensor_arena = 0;
+	ccv_nnc_graph_exec_arena_t* graph_exec_arena = 0;
+	ccv_nnc_symbolic_graph_compile(symbolic_graph, 0, 0, TENSOR_SYMBOL_LIST(b), SYMBOLIC_GRAPH_SOURCES(symbolic_graph), SYMBOLIC_GRAPH_DESTINATIONS(symbolic_graph), &graph, &tensor_arena, &graph_exec_arena);
+	REQUIRE_EQ(ccv_nnc_tensor_arena_derived_size(tensor_arena), 0, "nothing is derived from the constant before the first run");
+	ccv_nnc_cmd_t cmd = CMD_GEMM_FORWARD(13);
+	cmd.backend = CCV_NNC_BACKEND_CPU_OPT;
+	cmd.algorithm = 2; // CCV_NNC_CMD_OPT_GEMM_ALGO_PACKED
+	ccv_nnc_graph_exec_set(graph, ccv_nnc_graph_exec_from_symbol(graph_exec_arena, gemm), cmd);
+	ccv_nnc_tensor_t* const ta = ccv_nnc_tensor_new(0, CPU_TENSOR_NHWC(37, 301), 0);
+	ccv_nnc_tensor_t* const tw = ccv_nnc_tensor_new(w, CPU_TENSOR_NHWC(13, 301), 0);
+	ccv_nnc_tensor_t* const tb = ccv_nnc_tensor_new(0, CPU_TENSOR_NHWC(37, 13), 0);
+	ccv_nnc_tensor_t* const a_tensor = ccv_nnc_tensor_from_symbol(tensor_arena, a);
+	ccv_nnc_tensor_t* const b_tensor = ccv_nnc_tensor_from_symbol(tensor_arena, b);
+	uint64_t derived_size = 0;
+	int j;
+	for (j = 0; j < 2; j++)
+	{
+		for (i = 0; i < 37 * 301; i++)
+			ta->data.f32[i] = a_tensor->data.f32[i] = dsfmt_genrand_open_close(&dsfmt);
+		ccv_nnc_graph_run(graph, 0, 0, 0, TRAVERSE_FULL);
+		ccv_nnc_cmd_exec(CMD_GEMM_FORWARD(13), ccv_nnc_no_hint, 0, TENSOR_LIST(ta, tw), TENSOR_LIST(tb), 0);
+		REQUIRE_ARRAY_EQ_WITH_TOLERANCE(float, b_tensor->data.f32, tb->data.f32, 37 * 13, 1e-4, "packed gemm with the packed weights from the arena should match reference");
+		if (j == 0)
+		{
+			derived_size = ccv_nnc_tensor_arena_derived_size(tensor_arena);
+			REQUIRE(derived_size >= sizeof(float) * 13 * 301, "the packed weights should be kept by the arena");
+		} else
+			REQUIRE_EQ(ccv_nnc_tensor_arena_derived_size(tensor_arena), derived_size, "the packed weights should be reused");
+	}
+	// Once the constant is handed out, it can be changed, the packed weights of it are not used any more.
+	ccv_nnc_tensor_t* const w_tensor = ccv_nnc_tensor_from_symbol(tensor_arena, w_symbol);
+	REQUIRE_EQ(w_tensor->sig, 0, "the constant handed out should not be signed");
+	for (i = 0; i < 13 * 301; i++)
+		tw->data.f32[i] = w_tensor->data.f32[i] = dsfmt_genrand_open_close(&dsfmt) / 301;
+	ccv_nnc_graph_run(graph, 0, 0, 0, TRAVERSE_FULL);
+	ccv_nnc_cmd_exec(CMD_GEMM_FORWARD(13), ccv_nnc_no_hint, 0, TENSOR_LIST(ta, tw), TENSOR_LIST(tb), 0);
+	REQUIRE_ARRAY_EQ_WITH_TOLERANCE(float, b_tensor->data.f32, tb->data.f32, 37 * 13, 1e-4, "packed gemm with the changed weights should match reference");
+	ccv_nnc_tensor_free(ta);
+	ccv_nnc_tensor_free(tw);
+	ccv_nnc_tensor_free(tb);
+	ccv_nnc_symbolic_graph_free(symbolic_graph);
+	ccv_nnc_graph_free(graph);
+	ccv_nnc_tensor_arena_free(tensor_arena);
+	ccv_nnc_graph_exec_arena_free(graph_exec_arena);
+}
+
 #include "case_main.h"
@@ -135,4 +135,195 @@ TEST_CASE("convolutional network of 3x3 on 56x56 with no bias")
 	ccv_nnc_tensor_free(a);
 }
 
+TEST_CASE("convolutional network of 3x3 on 56x56 with 6x6 winograd")
+{
+	ccv_nnc_tensor_t* a = ccv_nnc_tensor_new(0, ONE_CPU_TENSOR(56, 56, 128), 0);
+	ccv_nnc_tensor_t* b = ccv_nnc_tensor_new(0, ONE_CPU_TENSOR(56, 56, 128), 0);
+	ccv_nnc_cmd_t cmd = CMD_CONVOLUTION_FORWARD(1, 128, 3, 3, 128);
+	ccv_nnc_hint_t hint = ccv_nnc_hint_auto(cmd.info, a->info, b->info);
+	ccv_nnc_tensor_t* w = ccv_nnc_tensor_new(0, ONE_CPU_TENSOR(128, 3, 3, 128), 0);
+	ccv_nnc_tensor_t* bias = ccv_nnc_tensor_new(0, ONE_CPU_TENSOR(128), 0);
+	// configure the inlets.
+	dsfmt_t dsfmt;
+	dsfmt_init_gen_rand(&dsfmt, 0);
+	int i;
+	for (i = 0; i < 128 * 3 * 3 * 128; i++)
+		w->data.f32[i] = dsfmt_genrand_open_close(&dsfmt) / (3 * 3 * 128);
+	for (i = 0; i < 56 * 56 * 128; i++)
+		a->data.f32[i] = dsfmt_genrand_open_close(&dsfmt);
+	for (i = 0; i < 128; i++)
+		bias->data.f32[i] = (float)i / 128;
+	ccv_nnc_cmd_exec(cmd, hint, 0, TENSOR_LIST(a, w, bias), TENSOR_LIST(b), 0);
+	ccv_nnc_tensor_t* c = ccv_nnc_tensor_new(0, ONE_CPU_TENSOR(56, 56, 128), 0);
+	cmd.backend = CCV_NNC_BACKEND_CPU_OPT;
+	cmd.algorithm = 4; // CCV_NNC_CMD_OPT_CONV_ALGO_WINOGRAD_6X6
+	ccv_nnc_cmd_exec(cmd, hint, 0, TENSOR_LIST(a, w, bias), TENSOR_LIST(c), 0);
+	// 6x6 output tiles amplify the rounding errors more than 4x4 output tiles do.
+	REQUIRE_ARRAY_EQ_WITH_TOLERANCE(float, b->data.f32, c->data.f32, 56 * 56 * 128, 1e-4, "56x56 matrix should be the same from reference implementation and 6x6 winograd.");
+	ccv_nnc_tensor_free(c);
+	ccv_nnc_tensor_free(bias);
+	ccv_nnc_tensor_free(w);
+	ccv_nnc_tensor_free(b);
+	ccv_nnc_tensor_free(a);
+}
+
+TEST_CASE("convolutional network of 3x3 on 55x55 with 6x6 winograd and no bias")
+{
+	ccv_nnc_tensor_t* a = ccv_nnc_tensor_new(0, ONE_CPU_TENSOR(55, 55, 126), 0);
+	ccv_nnc_tensor_t* b = ccv_nnc_tensor_new(0, ONE_CPU_TENSOR(55, 55, 126), 0);
+	ccv_nnc_cmd_t cmd = CMD_CONVOLUTION_FORWARD(1, 126, 3, 3, 126);
+	ccv_nnc_hint_t hint = ccv_nnc_hint_auto(cmd.info, a->info, b->info);
+	ccv_nnc_tensor_t* w = ccv_nnc_tensor_new(0, ONE_CPU_TENSOR(126, 3, 3, 126), 0);
+	// configure the inlets.
+	dsfmt_t dsfmt;
+	dsfmt_init_gen_rand(&dsfmt, 0);
+	int i;
+	for (i = 0; i < 126 * 3 * 3 * 126; i++)
+		w->data.f32[i] = dsfmt_genrand_open_close(&dsfmt) / (3 * 3 * 126);
+	for (i = 0; i < 55 * 55 * 126; i++)
+		a->data.f32[i] = dsfmt_genrand_open_close(&dsfmt);
+	ccv_nnc_cmd_exec(cmd, hint, 0, TENSOR_LIST(a, w), TENSOR_LIST(b), 0);
+	ccv_nnc_tensor_t* c = ccv_nnc_tensor_new(0, ONE_CPU_TENSOR(55, 55, 126), 0);
+	cmd.backend = CCV_NNC_BACKEND_CPU_OPT;
+	cmd.algorithm = 4; // CCV_NNC_CMD_OPT_CONV_ALGO_WINOGRAD_6X6
+	ccv_nnc_cmd_exec(cmd, hint, 0, TENSOR_LIST(a, w), TENSOR_LIST(c), 0);
+	// 126 filters is not a multiple of 4, thus, this goes through the reference 6x6 winograd.
+	REQUIRE_ARRAY_EQ_WITH_TOLERANCE(float, b->data.f32, c->data.f32, 55 * 55 * 126, 1e-4, "55x55 matrix should be the same from reference implementation and 6x6 winograd.");
+	ccv_nnc_tensor_free(c);
+	ccv_nnc_tensor_free(w);
+	ccv_nnc_tensor_free(b);
+	ccv_nnc_tensor_free(a);
+}
+
+TEST_CASE("convolutional network of 1x1 with stride 2 on 56x56")
+{
+	ccv_nnc_tensor_t* a = ccv_nnc_tensor_new(0, ONE_CPU_TENSOR(56, 56, 128), 0);
+	ccv_nnc_tensor_t* b = ccv_nnc_tensor_new(0, ONE_CPU_TENSOR(28, 28, 132), 0);
+	ccv_nnc_cmd_t cmd = CMD_CONVOLUTION_FORWARD(1, 132, 1, 1, 128);
+	ccv_nnc_hint_t hint = ccv_nnc_hint_auto(cmd.info, a->info, b->info);
+	ccv_nnc_tensor_t* w = ccv_nnc_tensor_new(0, ONE_CPU_TENSOR(132, 1, 1, 128), 0);
+	ccv_nnc_tensor_t* bias = ccv_nnc_tensor_new(0, ONE_CPU_TENSOR(132), 0);
+	// configure the inlets.
+	dsfmt_t dsfmt;
+	dsfmt_init_gen_rand(&dsfmt, 0);
+	int i;
+	for (i = 0; i < 132 * 128; i++)
+		w->data.f32[i] = dsfmt_genrand_open_close(&dsfmt) / 128;
+	for (i = 0; i < 56 * 56 * 128; i++)
+		a->data.f32[i] = dsfmt_genrand_open_close(&dsfmt);
+	for (i = 0; i < 132; i++)
+		bias->data.f32[i] = (float)i / 132;
+	ccv_nnc_cmd_exec(cmd, hint, 0, TENSOR_LIST(a, w, bias), TENSOR_LIST(b), 0);
+	ccv_nnc_tensor_t* c = ccv_nnc_tensor_new(0, ONE_CPU_TENSOR(28, 28, 132), 0);
+	cmd.backend = CCV_NNC_BACKEND_CPU_OPT;
+	cmd.algorithm = 5; // CCV_NNC_CMD_OPT_CONV_ALGO_1X1
+	ccv_nnc_cmd_exec(cmd, hint, 0, TENSOR_LIST(a, w, bias), TENSOR_LIST(c), 0);
+	REQUIRE_TENSOR_EQ(b, c, "28x28 matrix should be exactly the same from reference implementation and 1x1 kernel.");
+	ccv_nnc_tensor_free(c);
+	ccv_nnc_tensor_free(bias);
+	ccv_nnc_tensor_free(w);
+	ccv_nnc_tensor_free(b);
+	ccv_nnc_tensor_free(a);
+}
+
+TEST_CASE("convolutional network of 3x3 with stride 2 on 55x55")
+{
+	ccv_nnc_tensor_t* a = ccv_nnc_tensor_new(0, ONE_CPU_TENSOR(55, 55, 128), 0);
+	ccv_nnc_tensor_t* b = ccv_nnc_tensor_new(0, ONE_CPU_TENSOR(28, 28, 132), 0);
+	ccv_nnc_cmd_t cmd = CMD_CONVOLUTION_FORWARD(1, 132, 3, 3, 128);
+	ccv_nnc_hint_t hint = ccv_nnc_hint_auto(cmd.info, a->info, b->info);
+	ccv_nnc_tensor_t* w = ccv_nnc_tensor_new(0, ONE_CPU_TENSOR(132, 3, 3, 128), 0);
+	ccv_nnc_tensor_t* bias = ccv_nnc_tensor_new(0, ONE_CPU_TENSOR(132), 0);
+	// configure the inlets.
+	dsfmt_t dsfmt;
+	dsfmt_init_gen_rand(&dsfmt, 0);
+	int i;
+	for (i = 0; i < 132 * 3 * 3 * 128; i++)
+		w->data.f32[i] = dsfmt_genrand_open_close(&dsfmt) / (3 * 3 * 128);
+	for (i = 0; i < 55 * 55 * 128; i++)
+		a->data.f32[i] = dsfmt_genrand_open_close(&dsfmt);
+	for (i = 0; i < 132; i++)
+		bias->data.f32[i] = (float)i / 132;
+	ccv_nnc_cmd_exec(cmd, hint, 0, TENSOR_LIST(a, w, bias), TENSOR_LIST(b), 0);
+	ccv_nnc_tensor_t* c = ccv_nnc_tensor_new(0, ONE_CPU_TENSOR(28, 28, 132), 0);
+	cmd.backend = CCV_NNC_BACKEND_CPU_OPT;
+	cmd.algorithm = 6; // CCV_NNC_CMD_OPT_CONV_ALGO_3X3_S2
+	ccv_nnc_cmd_exec(cmd, hint, 0, TENSOR_LIST(a, w, bias), TENSOR_LIST(c), 0);
+	REQUIRE_TENSOR_EQ(b, c, "28x28 matrix should be exactly the same from reference implementation and 3x3 stride 2 kernel.");
+	ccv_nnc_tensor_free(c);
+	ccv_nnc_tensor_free(bias);
+	ccv_nnc_tensor_free(w);
+	ccv_nnc_tensor_free(b);
+	ccv_nnc_tensor_free(a);
+}
+
+TEST_CASE("convolutional network of 5x5 with stride 2 and 30 filters with gemm")
+{
+	ccv_nnc_tensor_t* a = ccv_nnc_tensor_new(0, ONE_CPU_TENSOR(27, 27, 6), 0);
+	ccv_nnc_tensor_t* b = ccv_nnc_tensor_new(0, ONE_CPU_TENSOR(14, 14, 30), 0);
+	ccv_nnc_cmd_t cmd = CMD_CONVOLUTION_FORWARD(1, 30, 5, 5, 6);
+	ccv_nnc_hint_t hint = ccv_nnc_hint_auto(cmd.info, a->info, b->info);
+	ccv_nnc_tensor_t* w = ccv_nnc_tensor_new(0, ONE_CPU_TENSOR(30, 5, 5, 6), 0);
+	ccv_nnc_tensor_t* bias = ccv_nnc_tensor_new(0, ONE_CPU_TENSOR(30), 0);
+	// configure the inlets.
+	dsfmt_t dsfmt;
+	dsfmt_init_gen_rand(&dsfmt, 0);
+	int i;
+	for (i = 0; i < 30 * 5 * 5 * 6; i++)
+		w->data.f32[i] = dsfmt_genrand_open_close(&dsfmt) / (5 * 5 * 6);
+	for (i = 0; i < 27 * 27 * 6; i++)
+		a->data.f32[i] = dsfmt_genrand_open_close(&dsfmt);
+	for (i = 0; i < 30; i++)
+		bias->data.f32[i] = (float)i / 30;
+	ccv_nnc_cmd_exec(cmd, hint, 0, TENSOR_LIST(a, w, bias), TENSOR_LIST(b), 0);
+	ccv_nnc_tensor_t* c = ccv_nnc_tensor_new(0, ONE_CPU_TENSOR(14, 14, 30), 0);
+	cmd.backend = CCV_NNC_BACKEND_CPU_OPT;
+	cmd.algorithm = 1; // CCV_NNC_CMD_OPT_CONV_ALGO_GEMM
+	ccv_nnc_cmd_exec(cmd, hint, 0, TENSOR_LIST(a, w, bias), TENSOR_LIST(c), 0);
+	REQUIRE_ARRAY_EQ_WITH_TOLERANCE(float, b->data.f32, c->data.f32, 14 * 14 * 30, 1e-5, "14x14 matrix should be the same from reference implementation and im2col with packed gemm.");
+	ccv_nnc_tensor_free(c);
+	ccv_nnc_tensor_free(bias);
+	ccv_nnc_tensor_free(w);
+	ccv_nnc_tensor_free(b);
+	ccv_nnc_tensor_free(a);
+}
+
+TEST_CASE("workspace is kept across convolutions without a stream context")
+{
+	ccv_nnc_tensor_t* a = ccv_nnc_tensor_new(0, ONE_CPU_TENSOR(56, 56, 32), 0);
+	ccv_nnc_tensor_t* b = ccv_nnc_tensor_new(0, ONE_CPU_TENSOR(56, 56, 32), 0);
+	ccv_nnc_cmd_t cmd = CMD_CONVOLUTION_FORWARD(1, 32, 3, 3, 32);
+	ccv_nnc_hint_t hint = ccv_nnc_hint_auto(cmd.info, a->info, b->info);
+	ccv_nnc_tensor_t* w = ccv_nnc_tensor_new(0, ONE_CPU_TENSOR(32, 3, 3, 32), 0);
+	ccv_nnc_tensor_t* bias = ccv_nnc_tensor_new(0, ONE_CPU_TENSOR(32), 0);
+	int i;
+	for (i = 0; i < 32 * 3 * 3 * 32; i++)
+		w->data.f32[i] = (float)(i % 7) / (3 * 3 * 32);
+	for (i = 0; i < 56 * 56 * 32; i++)
+		a->data.f32[i] = (float)(i % 5);
+	for (i = 0; i < 32; i++)
+		bias->data.f32[i] = (float)i / 32;
+	cmd.backend = CCV_NNC_BACKEND_CPU_OPT;
+	cmd.algorithm = 2; // CCV_NNC_CMD_OPT_CONV_ALGO_WINOGRAD
+	ccv_nnc_stream_context_drain(0);
+	const ccv_nnc_stream_context_workspace_stat_t before = ccv_nnc_stream_context_workspace_stat(0);
+	for (i = 0; i < 3; i++)
+		ccv_nnc_cmd_exec(cmd, hint, 0, TENSOR_LIST(a, w, bias), TENSOR_LIST(b), 0);
+	const ccv_nnc_stream_context_workspace_stat_t after = ccv_nnc_stream_context_workspace_stat(0);
+	REQUIRE(after.size > 0, "the workspace should be kept after the convolution");
+	REQUIRE_EQ(after.request_count - before.request_count, 3, "the workspace should be requested by every convolution");
+	REQUIRE_EQ(after.alloc_count - before.alloc_count, 1, "the workspace should only be allocated by the first convolution");
+	ccv_nnc_stream_context_trim(0, after.size);
+	REQUIRE_EQ(ccv_nnc_stream_context_workspace_stat(0).size, after.size, "the workspace within the size should be kept");
+	ccv_nnc_set_workspace_limit(0);
+	ccv_nnc_cmd_exec(cmd, hint, 0, TENSOR_LIST(a, w, bias), TENSOR_LIST(b), 0);
+	REQUIRE_EQ(ccv_nnc_stream_context_workspace_stat(0).size, 0, "the workspace should be freed if it is beyond the limit");
+	REQUIRE(ccv_nnc_stream_context_workspace_stat(0).high_water_mark >= after.size, "the high water mark should be kept after the workspace is freed");
+	ccv_nnc_set_workspace_limit(CCV_NNC_DEFAULT_WORKSPACE_LIMIT);
+	ccv_nnc_tensor_free(bias);
+	ccv_nnc_tensor_free(w);
+	ccv_nnc_tensor_free(b);
+	ccv_nnc_tensor_free(a);
+}
+
 #include "case_main.h"
@@ -145,6 +145,36 @@ TEST_CASE("ccv_filter centre point for odd number window size, hint: (size - 1)
 	ccv_matrix_free(x);
 }
 
+TEST_CASE("ccv_filter with CCV_C1 output sums up responses of all channels")
+{
+	ccv_dense_matrix_t* x = ccv_dense_matrix_new(37, 41, CCV_32F | 4, 0, 0);
+	ccv_dense_matrix_t* y = ccv_dense_matrix_new(7, 5, CCV_32F | 4, 0, 0);
+	int i;
+	for (i = 0; i < 37 * 41 * 4; i++)
+		x->data.f32[i] = (i * 7919 % 257) / 257.0;
+	for (i = 0; i < 7 * 5 * 4; i++)
+		y->data.f32[i] = (i * 104729 % 101) / 101.0 - 0.5;
+	ccv_make_matrix_immutable(y);
+	ccv_dense_matrix_t* d = 0;
+	ccv_filter(x, y, &d, 0, CCV_NO_PADDING);
+	ccv_dense_matrix_t* flat = 0;
+	ccv_flatten(d, (ccv_matrix_t**)&flat, 0, 0);
+	ccv_dense_matrix_t* sum = 0;
+	ccv_filter(x, y, &sum, CCV_32F | CCV_C1, CCV_NO_PADDING);
+	REQUIRE_EQ(CCV_GET_CHANNEL(sum->type), CCV_C1, "should only have one channel");
+	REQUIRE_ARRAY_EQ_WITH_TOLERANCE(float, sum->data.f32, flat->data.f32, 37 * 41, 1e-4, "summing channels in frequency domain should match flatten the response");
+	// the kernel spectrum is cached now, filter again should have the same result
+	ccv_dense_matrix_t* again = 0;
+	ccv_filter(x, y, &again, CCV_32F | CCV_C1, CCV_NO_PADDING);
+	REQUIRE_ARRAY_EQ_WITH_TOLERANCE(float, again->data.f32, sum->data.f32, 37 * 41, 1e-6, "should have the same result with cached kernel spectrum");
+	ccv_matrix_free(again);
+	ccv_matrix_free(sum);
+	ccv_matrix_free(flat);
+	ccv_matrix_free(d);
+	ccv_matrix_free(y);
+	ccv_matrix_free(x);
+}
+
 #include "ccv_internal.h"
 
 static void naive_ssd(ccv_dense_matrix_t* image, ccv_dense_matrix_t* template, ccv_dense_matrix_t* out)
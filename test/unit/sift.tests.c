@@ -0,0 +1,162 @@
+#include "ccv.h"
+#include "case.h"
+#include "ccv_case.h"
+
+static const ccv_sift_param_t sift_params = {
+	.noctaves = 3,
+	.nlevels = 6,
+	.up2x = 1,
+	.edge_threshold = 10,
+	.norm_threshold = 0,
+	.peak_threshold = 0,
+};
+
+static ccv_dense_matrix_t* _ccv_sift_desc(const char* filename)
+{
+	ccv_dense_matrix_t* image = 0;
+	ccv_read(filename, &image, CCV_IO_GRAY | CCV_IO_ANY_FILE);
+	ccv_array_t* keypoints = 0;
+	ccv_dense_matrix_t* desc = 0;
+	ccv_sift(image, &keypoints, &desc, 0, sift_params);
+	ccv_array_free(keypoints);
+	ccv_matrix_free(image);
+	return desc;
+}
+
+// The nearest descriptor of each query with the ratio test, by comparing it with every descriptor, -1 if it doesn't pass.
+static void _ccv_sift_exhaustive_match(ccv_dense_matrix_t* image_desc, ccv_dense_matrix_t* obj_desc, float ratio, int* nearest)
+{
+	int i, j, k;
+	for (i = 0; i < obj_desc->rows; i++)
+	{
+		float distance[2] = { FLT_MAX, FLT_MAX };
+		int index = -1;
+		for (j = 0; j < image_desc->rows; j++)
+		{
+			float d = 0;
+			for (k = 0; k < obj_desc->cols; k++)
+			{
+				float x = obj_desc->data.f32[i * obj_desc->cols + k] - image_desc->data.f32[j * image_desc->cols + k];
+				d += x * x;
+			}
+			if (d < distance[0])
+			{
+				distance[1] = distance[0];
+				distance[0] = d;
+				index = j;
+			} else if (d < distance[1])
+				distance[1] = d;
+		}
+		nearest[i] = distance[0] < ratio * distance[1] ? index : -1;
+	}
+}
+
+TEST_CASE("sift index matches the same descriptors as exhaustive matching")
+{
+	ccv_dense_matrix_t* obj_desc = _ccv_sift_desc("../../samples/book.png");
+	ccv_dense_matrix_t* image_desc = _ccv_sift_desc("../../samples/scene.png");
+	REQUIRE(obj_desc->rows > 0 && image_desc->rows > 0, "should have key-points on both images");
+	int* nearest = (int*)ccmalloc(sizeof(int) * obj_desc->rows);
+	_ccv_sift_exhaustive_match(image_desc, obj_desc, ccv_sift_match_default_params.ratio, nearest);
+	int i, exhaustive = 0;
+	for (i = 0; i < obj_desc->rows; i++)
+		if (nearest[i] >= 0)
+			++exhaustive;
+	REQUIRE(exhaustive > 20, "the book should be found in the scene");
+	ccv_sift_index_t* index = ccv_sift_index_new(image_desc, 4);
+	ccv_sift_match_param_t params = ccv_sift_match_default_params;
+	params.checks = 0;
+	ccv_array_t* matches = ccv_sift_index_match(index, obj_desc, params);
+	REQUIRE_EQ(matches->rnum, exhaustive, "should have the same matches without a limit on checks");
+	for (i = 0; i < matches->rnum; i++)
+	{
+		ccv_sift_match_t* match = (ccv_sift_match_t*)ccv_array_get(matches, i);
+		REQUIRE_EQ(match->index, nearest[match->query], "should be the nearest descriptor");
+	}
+	ccv_array_free(matches);
+	matches = ccv_sift_index_match(index, obj_desc, ccv_sift_match_default_params);
+	int same = 0;
+	for (i = 0; i < matches->rnum; i++)
+	{
+		ccv_sift_match_t* match = (ccv_sift_match_t*)ccv_array_get(matches, i);
+		if (match->index == nearest[match->query])
+			++same;
+	}
+	REQUIRE(same >= exhaustive * 9 / 10, "the approximate search should find most of the exhaustive matches");
+	REQUIRE(matches->rnum - same <= exhaustive / 10, "the approximate search should have few matches not from exhaustive matching");
+	ccv_array_free(matches);
+	ccv_sift_index_free(index);
+	ccfree(nearest);
+	ccv_matrix_free(obj_desc);
+	ccv_matrix_free(image_desc);
+}
+
+TEST_CASE("sift index is the same after written to and read back from a file")
+{
+	ccv_dense_matrix_t* obj_desc = _ccv_sift_desc("../../samples/book.png");
+	ccv_dense_matrix_t* image_desc = _ccv_sift_desc("../../samples/scene.png");
+	ccv_sift_index_t* index = ccv_sift_index_new(image_desc, 4);
+	ccv_sift_index_write(index, "sift.index.bin");
+	FILE* r = fopen("sift.index.bin", "rb");
+	unsigned char header[4];
+	REQUIRE_EQ(fread(header, 1, 4, r), 4, "should have the header");
+	fclose(r);
+	REQUIRE_EQ(header[0] | (header[1] << 8) | (header[2] << 16) | (header[3] << 24), index->rows, "the rows should be in little-endian");
+	ccv_sift_index_t* read_index = ccv_sift_index_read("sift.index.bin");
+	remove("sift.index.bin");
+	REQUIRE(read_index != 0, "should read the index back");
+	REQUIRE_EQ(read_index->rows, index->rows, "should have the same rows");
+	REQUIRE_EQ(read_index->cols, index->cols, "should have the same cols");
+	REQUIRE_EQ(read_index->trees, index->trees, "should have the same trees");
+	REQUIRE(memcmp(read_index->nodes, index->nodes, sizeof(ccv_sift_index_node_t) * (index->rows * 2 - 1) * index->trees) == 0, "should have the same nodes");
+	REQUIRE_ARRAY_EQ(float, read_index->data, index->data, index->rows * index->cols, "should have the same descriptors");
+	ccv_array_t* matches = ccv_sift_index_match(index, obj_desc, ccv_sift_match_default_params);
+	ccv_array_t* read_matches = ccv_sift_index_match(read_index, obj_desc, ccv_sift_match_default_params);
+	REQUIRE_EQ(read_matches->rnum, matches->rnum, "should have the same number of matches");
+	REQUIRE(memcmp(read_matches->data, matches->data, sizeof(ccv_sift_match_t) * matches->rnum) == 0, "should have the same matches");
+	ccv_array_free(matches);
+	ccv_array_free(read_matches);
+	ccv_sift_index_free(read_index);
+	ccv_sift_index_free(index);
+	ccv_matrix_free(obj_desc);
+	ccv_matrix_free(image_desc);
+}
+
+static void _ccv_sift_index_write_corrupted(ccv_sift_index_t* index, const char* filename, size_t offset, uint32_t v)
+{
+	ccv_sift_index_write(index, filename);
+	FILE* w = fopen(filename, "r+b");
+	fseek(w, (long)offset, SEEK_SET);
+	unsigned char buf[4] = { v & 0xff, (v >> 8) & 0xff, (v >> 16) & 0xff, (v >> 24) & 0xff };
+	fwrite(buf, 1, 4, w);
+	fclose(w);
+}
+
+TEST_CASE("sift index refuses to read a file with out of range nodes")
+{
+	ccv_dense_matrix_t* image_desc = _ccv_sift_desc("../../samples/scene.png");
+	ccv_sift_index_t* index = ccv_sift_index_new(image_desc, 2);
+	int leaf = 0;
+	while (index->nodes[leaf].dim >= 0)
+		++leaf;
+	const size_t tree_size = (size_t)index->rows * 2 - 1;
+	// the right child of the root of the second tree
+	_ccv_sift_index_write_corrupted(index, "sift.index.bin", 12 + (tree_size + 0) * 16 + 12, (uint32_t)tree_size);
+	REQUIRE(ccv_sift_index_read("sift.index.bin") == 0, "should refuse a child beyond the tree");
+	// a child pointing back to its parent makes a cycle
+	_ccv_sift_index_write_corrupted(index, "sift.index.bin", 12 + 8, 0);
+	REQUIRE(ccv_sift_index_read("sift.index.bin") == 0, "should refuse a child that is not after its parent");
+	_ccv_sift_index_write_corrupted(index, "sift.index.bin", 12, (uint32_t)index->cols);
+	REQUIRE(ccv_sift_index_read("sift.index.bin") == 0, "should refuse a split on a dimension the descriptor doesn't have");
+	_ccv_sift_index_write_corrupted(index, "sift.index.bin", 12 + leaf * 16 + 8, (uint32_t)index->rows);
+	REQUIRE(ccv_sift_index_read("sift.index.bin") == 0, "should refuse a leaf beyond the descriptors");
+	_ccv_sift_index_write_corrupted(index, "sift.index.bin", 12 + leaf * 16 + 8, (uint32_t)index->nodes[leaf].left);
+	ccv_sift_index_t* read_index = ccv_sift_index_read("sift.index.bin");
+	remove("sift.index.bin");
+	REQUIRE(read_index != 0, "should read the index when nothing is out of range");
+	ccv_sift_index_free(read_index);
+	ccv_sift_index_free(index);
+	ccv_matrix_free(image_desc);
+}
+
+#include "case_main.h"
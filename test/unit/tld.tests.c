@@ -0,0 +1,61 @@
+#include "ccv.h"
+#include "case.h"
+#include "ccv_case.h"
+
+// The frames are windows sliding over a fixture image, the window jumps at the given frame, thus, the object has to be
+// detected again rather than tracked.
+#define TLD_FRAME_SIZE (8)
+#define TLD_JUMP_FRAME (4)
+#define TLD_JUMP (50)
+
+static ccv_dense_matrix_t* _ccv_tld_frame(ccv_dense_matrix_t* image, const int t)
+{
+	const int jump = t >= TLD_JUMP_FRAME ? TLD_JUMP : 0;
+	ccv_dense_matrix_t* b = 0;
+	ccv_slice(image, (ccv_matrix_t**)&b, 0, 100 + t + jump, 200 + t * 2 + jump, 240, 320);
+	return b;
+}
+
+static void _ccv_tld_track_frames(ccv_dense_matrix_t* image, const ccv_tld_param_t params, ccv_rect_t* const rects)
+{
+	ccv_dense_matrix_t* x = _ccv_tld_frame(image, 0);
+	ccv_tld_t* tld = ccv_tld_new(x, ccv_rect(120, 80, 60, 60), params);
+	int t;
+	for (t = 1; t < TLD_FRAME_SIZE; t++)
+	{
+		ccv_dense_matrix_t* y = _ccv_tld_frame(image, t);
+		ccv_tld_info_t info;
+		ccv_comp_t box = ccv_tld_track_object(tld, x, y, &info);
+		rects[t] = box.rect;
+		ccv_matrix_free(x);
+		x = y;
+	}
+	ccv_matrix_free(x);
+	ccv_tld_free(tld);
+}
+
+TEST_CASE("TLD finds the object again after it jumps, with and without search region")
+{
+	ccv_dense_matrix_t* image = 0;
+	ccv_read("../../samples/nature.png", &image, CCV_IO_GRAY | CCV_IO_ANY_FILE);
+	ccv_rect_t rects[TLD_FRAME_SIZE];
+	ccv_rect_t search_rects[TLD_FRAME_SIZE];
+	ccv_tld_param_t params = ccv_tld_default_params;
+	_ccv_tld_track_frames(image, params, rects);
+	params.search_region = 1;
+	_ccv_tld_track_frames(image, params, search_rects);
+	int t;
+	for (t = 1; t < TLD_FRAME_SIZE; t++)
+	{
+		const int jump = t >= TLD_JUMP_FRAME ? TLD_JUMP : 0;
+		const int x = 120 - t * 2 - jump;
+		const int y = 80 - t - jump;
+		REQUIRE(abs(rects[t].x - x) <= 4 && abs(rects[t].y - y) <= 4, "the object should be found at frame %d (%d, %d), but at (%d, %d)", t, x, y, rects[t].x, rects[t].y);
+		REQUIRE(abs(rects[t].width - 60) <= 4 && abs(rects[t].height - 60) <= 4, "the object should be about the same size at frame %d", t);
+		REQUIRE(abs(search_rects[t].x - x) <= 4 && abs(search_rects[t].y - y) <= 4, "the object should be found at frame %d (%d, %d) within the search region, but at (%d, %d)", t, x, y, search_rects[t].x, search_rects[t].y);
+		REQUIRE(abs(search_rects[t].width - 60) <= 4 && abs(search_rects[t].height - 60) <= 4, "the object should be about the same size at frame %d within the search region", t);
+	}
+	ccv_matrix_free(image);
+}
+
+#include "case_main.h"
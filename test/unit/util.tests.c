@@ -103,6 +103,50 @@ TEST_CASE("group array with is_equal function")
 	ccv_array_free(idx);
 }
 
+static int is_equal_rect(const void* _r1, const void* _r2, void* data)
+{
+	const ccv_rect_t* r1 = (const ccv_rect_t*)_r1;
+	const ccv_rect_t* r2 = (const ccv_rect_t*)_r2;
+	int distance = (int)(ccv_min(r1->width, r1->height) * 0.25 + 0.5);
+	return r2->x <= r1->x + distance &&
+		r2->x >= r1->x - distance &&
+		r2->y <= r1->y + distance &&
+		r2->y >= r1->y - distance &&
+		r2->width <= (int)(r1->width * 1.5 + 0.5) &&
+		(int)(r2->width * 1.5 + 0.5) >= r1->width;
+}
+
+static ccv_rect_t equal_rect_bound(const void* _r, void* data)
+{
+	const ccv_rect_t* r = (const ccv_rect_t*)_r;
+	int distance = (int)(ccv_min(r->width, r->height) * 0.25 + 0.5);
+	return ccv_rect(r->x - distance, r->y - distance, distance * 2 + 1, distance * 2 + 1);
+}
+
+TEST_CASE("group array spatially is the same as group array")
+{
+	ccv_array_t* array = ccv_array_new(sizeof(ccv_rect_t), 2000, 0);
+	dsfmt_t dsfmt;
+	dsfmt_init_gen_rand(&dsfmt, 0);
+	int i;
+	for (i = 0; i < 2000; i++)
+	{
+		int size = 10 + (int)(dsfmt_genrand_open_close(&dsfmt) * 200);
+		ccv_rect_t rect = ccv_rect((int)(dsfmt_genrand_open_close(&dsfmt) * 640) - 20, (int)(dsfmt_genrand_open_close(&dsfmt) * 480) - 20, size, size);
+		ccv_array_push(array, &rect);
+	}
+	ccv_array_t* idx = 0;
+	int ncomp = ccv_array_group(array, &idx, is_equal_rect, 0);
+	ccv_array_t* spatial_idx = 0;
+	int spatial_ncomp = ccv_array_group_spatially(array, &spatial_idx, is_equal_rect, equal_rect_bound, 0);
+	REQUIRE(ncomp > 1 && ncomp < 2000, "should have some groups");
+	REQUIRE_EQ(ncomp, spatial_ncomp, "should have the same number of groups");
+	REQUIRE_ARRAY_EQ(int, ccv_array_get(idx, 0), ccv_array_get(spatial_idx, 0), 2000, "should be the same groups");
+	ccv_array_free(array);
+	ccv_array_free(idx);
+	ccv_array_free(spatial_idx);
+}
+
 TEST_CASE("specific sparse matrix insertion")
 {
 	ccv_sparse_matrix_t* mat = ccv_sparse_matrix_new(1, 70, CCV_32S | CCV_C1, CCV_SPARSE_ROW_MAJOR, 0);